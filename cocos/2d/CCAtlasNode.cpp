@@ -35,6 +35,7 @@ THE SOFTWARE.
 #include "renderer/ccShaders.h"
 #include "renderer/CCRenderer.h"
 #include "renderer/backend/ProgramState.h"
+#include "renderer/backend/ProgramStateRegistry.h"
 
 NS_CC_BEGIN
 
@@ -46,7 +47,7 @@ AtlasNode::AtlasNode()
 {
     auto& pipelineDescriptor = _quadCommand.getPipelineDescriptor();
     auto* program = backend::Program::getBuiltinProgram(backend::ProgramType::POSITION_TEXTURE_COLOR);
-    attachProgramState(new (std::nothrow) backend::ProgramState(program));
+    attachProgramState(backend::ProgramStateRegistry::getInstance()->getProgramState(program));
     pipelineDescriptor.programState = _programState;
     _mvpMatrixLocation = pipelineDescriptor.programState->getUniformLocation("u_MVPMatrix");
     _textureLocation = pipelineDescriptor.programState->getUniformLocation("u_texture");
@@ -35,6 +35,7 @@
 #include "base/ccUtils.h"
 #include "renderer/ccShaders.h"
 #include "renderer/backend/ProgramState.h"
+#include "renderer/backend/Buffer.h"
 
 NS_CC_BEGIN
 
@@ -99,9 +100,6 @@ void DrawNode::ensureCapacity(int count)
     {
         _bufferCapacity += MAX(_bufferCapacity, count);
         _buffer = (V2F_C4B_T2F*)realloc(_buffer, _bufferCapacity*sizeof(V2F_C4B_T2F));
-        
-        _customCommand.createVertexBuffer(sizeof(V2F_C4B_T2F), _bufferCapacity, CustomCommand::BufferUsage::STATIC);
-        _customCommand.updateVertexBuffer(_buffer, _bufferCapacity*sizeof(V2F_C4B_T2F));
     }
 }
 
@@ -113,9 +111,6 @@ void DrawNode::ensureCapacityGLPoint(int count)
     {
         _bufferCapacityGLPoint += MAX(_bufferCapacityGLPoint, count);
         _bufferGLPoint = (V2F_C4B_T2F*)realloc(_bufferGLPoint, _bufferCapacityGLPoint*sizeof(V2F_C4B_T2F));
-        
-        _customCommandGLPoint.createVertexBuffer(sizeof(V2F_C4B_T2F), _bufferCapacityGLPoint, CustomCommand::BufferUsage::STATIC);
-        _customCommandGLPoint.updateVertexBuffer(_bufferGLPoint, _bufferCapacityGLPoint*sizeof(V2F_C4B_T2F));
     }
 }
 
@@ -127,9 +122,6 @@ void DrawNode::ensureCapacityGLLine(int count)
     {
         _bufferCapacityGLLine += MAX(_bufferCapacityGLLine, count);
         _bufferGLLine = (V2F_C4B_T2F*)realloc(_bufferGLLine, _bufferCapacityGLLine*sizeof(V2F_C4B_T2F));
-        
-        _customCommandGLLine.createVertexBuffer(sizeof(V2F_C4B_T2F), _bufferCapacityGLLine, CustomCommand::BufferUsage::STATIC);
-        _customCommandGLLine.updateVertexBuffer(_bufferGLLine, _bufferCapacityGLLine*sizeof(V2F_C4B_T2F));
     }
 }
 
@@ -149,8 +141,9 @@ bool DrawNode::init()
 
 void DrawNode::updateShader()
 {
+    // not shared, the MVP matrix includes the node transform and is set every frame
     auto* program = backend::Program::getBuiltinProgram(backend::ProgramType::POSITION_COLOR_LENGTH_TEXTURE);
-    setProgramState(new (std::nothrow) backend::ProgramState(program));
+    attachProgramState(new (std::nothrow) backend::ProgramState(program));
     _customCommand.getPipelineDescriptor().programState = _programState;
     setVertexLayout(_customCommand);
     _customCommand.setDrawType(CustomCommand::DrawType::ARRAY);
@@ -233,10 +226,23 @@ void DrawNode::updateUniforms(const Mat4 &transform, CustomCommand& cmd)
     pipelineDescriptor.programState->setUniform(alphaUniformLocation, &alpha, sizeof(alpha));
 }
 
+void DrawNode::updateVertexBuffer(CustomCommand& cmd, V2F_C4B_T2F* vertices, int count, int capacity, bool& dirty)
+{
+    // Always streamed, the upload doesn't wait for the GPU to draw the previous shapes. The region of the ring is
+    // reused a few frames later, so unchanged shapes are streamed again rather than switching to a static buffer.
+    auto buffer = cmd.getVertexBuffer();
+    if (!buffer || cmd.getVertexCapacity() < capacity)
+        cmd.createVertexBuffer(sizeof(V2F_C4B_T2F), capacity, CustomCommand::BufferUsage::STREAM);
+    cmd.streamVertexBuffer(vertices, count * sizeof(V2F_C4B_T2F));
+    dirty = false;
+    cmd.setVertexDrawInfo(0, count);
+}
+
 void DrawNode::draw(Renderer *renderer, const Mat4 &transform, uint32_t flags)
 {
     if(_bufferCount)
     {
+        updateVertexBuffer(_customCommand, _buffer, _bufferCount, _bufferCapacity, _dirty);
         updateBlendState(_customCommand);
         updateUniforms(transform, _customCommand);
         _customCommand.init(_globalZOrder);
@@ -245,6 +251,7 @@ void DrawNode::draw(Renderer *renderer, const Mat4 &transform, uint32_t flags)
     
     if(_bufferCountGLPoint)
     {
+        updateVertexBuffer(_customCommandGLPoint, _bufferGLPoint, _bufferCountGLPoint, _bufferCapacityGLPoint, _dirtyGLPoint);
         updateBlendState(_customCommandGLPoint);
         updateUniforms(transform, _customCommandGLPoint);
         _customCommandGLPoint.init(_globalZOrder);
@@ -253,6 +260,7 @@ void DrawNode::draw(Renderer *renderer, const Mat4 &transform, uint32_t flags)
     
     if(_bufferCountGLLine)
     {
+        updateVertexBuffer(_customCommandGLLine, _bufferGLLine, _bufferCountGLLine, _bufferCapacityGLLine, _dirtyGLLine);
         updateBlendState(_customCommandGLLine);
         updateUniforms(transform, _customCommandGLLine);
         _customCommandGLLine.setLineWidth(_lineWidth);
@@ -268,10 +276,8 @@ void DrawNode::drawPoint(const Vec2& position, const float pointSize, const Colo
     V2F_C4B_T2F *point = _bufferGLPoint + _bufferCountGLPoint;
     *point = {position, Color4B(color), Tex2F(pointSize,0)};
     
-    _customCommandGLPoint.updateVertexBuffer(point, _bufferCountGLPoint*sizeof(V2F_C4B_T2F), sizeof(V2F_C4B_T2F));
     _bufferCountGLPoint += 1;
     _dirtyGLPoint = true;
-    _customCommandGLPoint.setVertexDrawInfo(0, _bufferCountGLPoint);
 }
 
 void DrawNode::drawPoints(const Vec2 *position, unsigned int numberOfPoints, const Color4F &color)
@@ -289,10 +295,8 @@ void DrawNode::drawPoints(const Vec2 *position, unsigned int numberOfPoints, con
         *(point + i) = {position[i], Color4B(color), Tex2F(pointSize,0)};
     }
     
-    _customCommandGLPoint.updateVertexBuffer(point, _bufferCountGLPoint*sizeof(V2F_C4B_T2F), numberOfPoints*sizeof(V2F_C4B_T2F));
     _bufferCountGLPoint += numberOfPoints;
     _dirtyGLPoint = true;
-    _customCommandGLPoint.setVertexDrawInfo(0, _bufferCountGLPoint);
 }
 
 void DrawNode::drawLine(const Vec2 &origin, const Vec2 &destination, const Color4F &color)
@@ -304,10 +308,8 @@ void DrawNode::drawLine(const Vec2 &origin, const Vec2 &destination, const Color
     *point = {origin, Color4B(color), Tex2F(0.0, 0.0)};
     *(point+1) = {destination, Color4B(color), Tex2F(0.0, 0.0)};
     
-    _customCommandGLLine.updateVertexBuffer(point, _bufferCountGLLine*sizeof(V2F_C4B_T2F), 2*sizeof(V2F_C4B_T2F));
     _bufferCountGLLine += 2;
     _dirtyGLLine = true;
-    _customCommandGLLine.setVertexDrawInfo(0, _bufferCountGLLine);
 }
 
 void DrawNode::drawRect(const Vec2 &origin, const Vec2 &destination, const Color4F &color)
@@ -333,7 +335,6 @@ void DrawNode::drawPoly(const Vec2 *poli, unsigned int numberOfPoints, bool clos
     }
     
     V2F_C4B_T2F *point = _bufferGLLine + _bufferCountGLLine;
-    V2F_C4B_T2F *cursor = point;
     
     unsigned int i = 0;
     for(; i < numberOfPoints - 1; i++)
@@ -348,9 +349,8 @@ void DrawNode::drawPoly(const Vec2 *poli, unsigned int numberOfPoints, bool clos
         *(point + 1) = {poli[0], Color4B(color), Tex2F(0.0, 0.0)};
     }
     
-    _customCommandGLLine.updateVertexBuffer(cursor, _bufferCountGLLine*sizeof(V2F_C4B_T2F), vertex_count*sizeof(V2F_C4B_T2F));
     _bufferCountGLLine += vertex_count;
-    _customCommandGLLine.setVertexDrawInfo(0, _bufferCountGLLine);
+    _dirtyGLLine = true;
 }
 
 void DrawNode::drawCircle(const Vec2& center, float radius, float angle, unsigned int segments, bool drawLineToCenter, float scaleX, float scaleY, const Color4F &color)
@@ -488,10 +488,8 @@ void DrawNode::drawDot(const Vec2 &pos, float radius, const Color4F &color)
     triangles[0] = triangle0;
     triangles[1] = triangle1;
     
-    _customCommand.updateVertexBuffer(triangles, _bufferCount*sizeof(V2F_C4B_T2F), vertex_count*sizeof(V2F_C4B_T2F));
     _bufferCount += vertex_count;
     _dirty = true;
-    _customCommand.setVertexDrawInfo(0, _bufferCount);
 }
 
 void DrawNode::drawRect(const Vec2 &p1, const Vec2 &p2, const Vec2 &p3, const Vec2& p4, const Color4F &color)
@@ -570,10 +568,8 @@ void DrawNode::drawSegment(const Vec2 &from, const Vec2 &to, float radius, const
     };
     triangles[5] = triangles5;
     
-    _customCommand.updateVertexBuffer(triangles, _bufferCount*sizeof(V2F_C4B_T2F), vertex_count*sizeof(V2F_C4B_T2F));
     _bufferCount += vertex_count;
     _dirty = true;
-    _customCommand.setVertexDrawInfo(0, _bufferCount);
 }
 
 void DrawNode::drawPolygon(const Vec2 *verts, int count, const Color4F &fillColor, float borderWidth, const Color4F &borderColor)
@@ -652,9 +648,7 @@ void DrawNode::drawPolygon(const Vec2 *verts, int count, const Color4F &fillColo
         free(extrude);
     }
     
-    _customCommand.updateVertexBuffer(triangles, _bufferCount*sizeof(V2F_C4B_T2F), vertex_count*sizeof(V2F_C4B_T2F));
     _bufferCount += vertex_count;
-    _customCommand.setVertexDrawInfo(0, _bufferCount);
     _dirty = true;
 }
 
@@ -717,10 +711,8 @@ void DrawNode::drawTriangle(const Vec2 &p1, const Vec2 &p2, const Vec2 &p3, cons
     V2F_C4B_T2F_Triangle triangle = {a, b, c};
     triangles[0] = triangle;
 
-    _customCommand.updateVertexBuffer(triangles, _bufferCount*sizeof(V2F_C4B_T2F), vertex_count*sizeof(V2F_C4B_T2F));
     _bufferCount += vertex_count;
     _dirty = true;
-    _customCommand.setVertexDrawInfo(0, _bufferCount);
 }
 
 void DrawNode::clear()
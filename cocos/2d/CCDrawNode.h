@@ -319,6 +319,7 @@ protected:
     void setVertexLayout(CustomCommand& cmd);
     void updateBlendState(CustomCommand& cmd);
     void updateUniforms(const Mat4 &transform, CustomCommand& cmd);
+    void updateVertexBuffer(CustomCommand& cmd, V2F_C4B_T2F* vertices, int count, int capacity, bool& dirty);
 
     int         _bufferCapacity = 0;
     int         _bufferCount = 0;
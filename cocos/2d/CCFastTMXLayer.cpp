@@ -401,6 +401,7 @@ void FastTMXLayer::updatePrimitives()
             if (_useAutomaticVertexZ)
             {
                 CC_SAFE_RELEASE(pipelineDescriptor.programState);
+                // not shared, the MVP matrix includes the layer transform and is set every frame
                 auto* program = backend::Program::getBuiltinProgram(backend::ProgramType::POSITION_TEXTURE_COLOR_ALPHA_TEST);
                 auto programState = new (std::nothrow) backend::ProgramState(program);
                 pipelineDescriptor.programState = programState;
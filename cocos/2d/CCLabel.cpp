@@ -726,7 +726,7 @@ void Label::updateShaderProgram()
     }
 
     auto* program = backend::Program::getBuiltinProgram(programType);
-    attachProgramState(new backend::ProgramState(program));
+    attachProgramState(backend::ProgramStateRegistry::getInstance()->getProgramState(program));
 
     updateUniformLocations();
 
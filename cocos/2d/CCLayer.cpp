@@ -44,6 +44,7 @@ THE SOFTWARE.
 #include "renderer/backend/Buffer.h"
 #include "renderer/ccShaders.h"
 #include "renderer/backend/ProgramState.h"
+#include "renderer/backend/ProgramStateRegistry.h"
 
 #if (CC_TARGET_PLATFORM == CC_PLATFORM_MAC)
 #include "platform/desktop/CCGLViewImpl-desktop.h"
@@ -246,7 +247,7 @@ LayerColor::LayerColor()
     
     auto& pipelineDescriptor = _customCommand.getPipelineDescriptor();
     auto* program = backend::Program::getBuiltinProgram(backend::ProgramType::POSITION_COLOR); // TODO: noMVP?
-    attachProgramState(new (std::nothrow) backend::ProgramState(program));
+    attachProgramState(backend::ProgramStateRegistry::getInstance()->getProgramState(program));
     pipelineDescriptor.programState = _programState;
     
     auto vertexLayout = _programState->getVertexLayout();
@@ -37,6 +37,7 @@ THE SOFTWARE.
 #include "base/CCScheduler.h"
 #include "base/CCEventDispatcher.h"
 #include "base/ccUTF8.h"
+#include "base/CCParallelTaskPool.h"
 #include "2d/CCCamera.h"
 #include "2d/CCActionManager.h"
 #include "2d/CCScene.h"
@@ -57,6 +58,10 @@ NS_CC_BEGIN
 
 // FIXME:: Yes, nodes might have a sort problem once every 30 days if the game runs at 60 FPS and each frame sprites are reordered.
 std::uint32_t Node::s_globalOrderOfArrival = 0;
+std::uint32_t Node::s_transformPass = 0;
+
+// Subtrees handed to each thread by updateTransforms(), a few more than one so that deep subtrees even out.
+static const size_t TRANSFORM_SUBTREES_PER_THREAD = 16;
 int Node::__attachedNodeCount = 0;
 
 // MARK: Constructor, Destructor, Init
@@ -82,6 +87,10 @@ Node::Node()
 , _additionalTransform(nullptr)
 , _additionalTransformDirty(false)
 , _transformUpdated(true)
+, _preparedPass(0)
+, _preparedParentFlags(0)
+, _preparedFlags(0)
+, _preparedParentTransform(nullptr)
 // children (lazy allocs)
 // lazy alloc
 , _localZOrder$Arrival(0LL)
@@ -1158,6 +1167,18 @@ void Node::visit()
 
 uint32_t Node::processParentFlags(const Mat4& parentTransform, uint32_t parentFlags)
 {
+    if (_preparedPass == s_transformPass)
+    {
+        _preparedPass = 0;
+        if (isPreparedTransformValid(parentTransform, parentFlags))
+        {
+            _preparedPass = s_transformPass;
+            _transformUpdated = false;
+            _contentSizeDirty = false;
+            return _preparedFlags;
+        }
+    }
+
     if(_usingNormalizedPosition)
     {
         CCASSERT(_parent, "setPositionNormalized() doesn't work with orphan nodes");
@@ -1190,6 +1211,106 @@ uint32_t Node::processParentFlags(const Mat4& parentTransform, uint32_t parentFl
     return flags;
 }
 
+uint32_t Node::prepareTransform(const Mat4& parentTransform, uint32_t parentFlags)
+{
+    // the same as processParentFlags(), except that the dirty flags are left for the visit
+    if(_usingNormalizedPosition)
+    {
+        CCASSERT(_parent, "setPositionNormalized() doesn't work with orphan nodes");
+        if ((parentFlags & FLAGS_CONTENT_SIZE_DIRTY) || _normalizedPositionDirty)
+        {
+            auto& s = _parent->getContentSize();
+            _position.x = _normalizedPosition.x * s.width;
+            _position.y = _normalizedPosition.y * s.height;
+            _transformUpdated = _transformDirty = _inverseDirty = true;
+            _normalizedPositionDirty = false;
+        }
+    }
+
+    if (!isVisitableByVisitingCamera())
+        return parentFlags;
+
+    uint32_t flags = parentFlags;
+    flags |= (_transformUpdated ? FLAGS_TRANSFORM_DIRTY : 0);
+    flags |= (_contentSizeDirty ? FLAGS_CONTENT_SIZE_DIRTY : 0);
+
+    if(flags & FLAGS_DIRTY_MASK)
+        _modelViewTransform = this->transform(parentTransform);
+
+    _preparedPass = s_transformPass;
+    _preparedParentTransform = &parentTransform;
+    _preparedParentFlags = parentFlags;
+    _preparedFlags = flags;
+    return flags;
+}
+
+void Node::prepareTransforms(const Mat4& parentTransform, uint32_t parentFlags)
+{
+    if (!_visible)
+        return;
+
+    uint32_t flags = prepareTransform(parentTransform, parentFlags);
+    for (const auto& child : _children)
+        child->prepareTransforms(_modelViewTransform, flags);
+}
+
+bool Node::isPreparedTransformValid(const Mat4& parentTransform, uint32_t parentFlags) const
+{
+    // Visited with what the pass used, and nothing was moved or resized since.
+    if (&parentTransform != _preparedParentTransform || parentFlags != _preparedParentFlags || _transformDirty || _normalizedPositionDirty)
+        return false;
+
+    // The parent's transform was updated again by the visit.
+    if (_parent && &parentTransform == &_parent->_modelViewTransform && _parent->_preparedPass != s_transformPass)
+        return false;
+
+    uint32_t flags = parentFlags;
+    flags |= (_transformUpdated ? FLAGS_TRANSFORM_DIRTY : 0);
+    flags |= (_contentSizeDirty ? FLAGS_CONTENT_SIZE_DIRTY : 0);
+    return flags == _preparedFlags && isVisitableByVisitingCamera();
+}
+
+void Node::updateTransforms(const Mat4& parentTransform, uint32_t parentFlags, int threads)
+{
+    struct Subtree
+    {
+        Node* node;
+        const Mat4* parentTransform;
+        uint32_t parentFlags;
+    };
+    // only used on the main thread
+    static std::vector<Subtree> subtrees;
+    static std::vector<Subtree> nextSubtrees;
+
+    if (++s_transformPass == 0)
+        ++s_transformPass;
+
+    // The top levels are updated here breadth first, until there are enough subtrees to keep the threads busy.
+    const size_t wantedSubtrees = static_cast<size_t>(threads) * TRANSFORM_SUBTREES_PER_THREAD;
+    subtrees.clear();
+    subtrees.push_back({this, &parentTransform, parentFlags});
+    while (!subtrees.empty() && subtrees.size() < wantedSubtrees)
+    {
+        nextSubtrees.clear();
+        for (const auto& subtree : subtrees)
+        {
+            auto node = subtree.node;
+            if (!node->_visible)
+                continue;
+
+            uint32_t flags = node->prepareTransform(*subtree.parentTransform, subtree.parentFlags);
+            for (const auto& child : node->_children)
+                nextSubtrees.push_back({child, &node->_modelViewTransform, flags});
+        }
+        subtrees.swap(nextSubtrees);
+    }
+
+    ParallelTaskPool::getInstance()->parallelFor(subtrees.size(), 1, [](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i)
+            subtrees[i].node->prepareTransforms(*subtrees[i].parentTransform, subtrees[i].parentFlags);
+    }, threads);
+}
+
 bool Node::isVisitableByVisitingCamera() const
 {
     auto camera = Camera::getVisitingCamera();
@@ -2131,7 +2252,9 @@ int Node::getAttachedNodeCount()
 void Node::setProgramStateWithRegistry(backend::ProgramType programType, Texture2D* texture)
 {
     auto formatEXT = texture ? texture->getTextureFormatEXT() : 0;
-    setProgramState(backend::ProgramStateRegistry::getInstance()->getProgramState(programType, formatEXT));
+    auto programState = backend::ProgramStateRegistry::getInstance()->getProgramState(programType, formatEXT);
+    setProgramState(programState);
+    CC_SAFE_RELEASE(programState);
 }
 
 void Node::updateProgramStateTexture(Texture2D* texture)
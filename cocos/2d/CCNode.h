@@ -1121,6 +1121,19 @@ public:
      * @param parentFlags Renderer flag.
      */
     virtual void visit(Renderer *renderer, const Mat4& parentTransform, uint32_t parentFlags);
+
+    /**
+     * Updates the model view transforms of this node and its visible children ahead of
+     * visit(renderer, parentTransform, parentFlags), splitting the subtrees across the ParallelTaskPool.
+     * The visit then only checks that nothing changed in between and uses them, so the transforms and the
+     * render commands are the same as without this pass. Nodes changed in between are updated by the visit.
+     *
+     * @param parentTransform The transform matrix the visit will be called with.
+     * @param parentFlags The flags the visit will be called with.
+     * @param threads The number of threads including the calling one.
+     * @see Director::setTransformThreads()
+     */
+    void updateTransforms(const Mat4& parentTransform, uint32_t parentFlags, int threads);
     virtual void visit() final;
 
 
@@ -1799,6 +1812,11 @@ protected:
     Mat4 transform(const Mat4 &parentTransform);
     uint32_t processParentFlags(const Mat4& parentTransform, uint32_t parentFlags);
 
+    /// processParentFlags() of the transform pass, the visit takes the result if it is still valid
+    uint32_t prepareTransform(const Mat4& parentTransform, uint32_t parentFlags);
+    void prepareTransforms(const Mat4& parentTransform, uint32_t parentFlags);
+    bool isPreparedTransformValid(const Mat4& parentTransform, uint32_t parentFlags) const;
+
     virtual void updateCascadeOpacity();
     virtual void disableCascadeOpacity();
     virtual void updateCascadeColor();
@@ -1860,6 +1878,13 @@ protected:
     mutable bool _additionalTransformDirty; ///< transform dirty ?
     bool _transformUpdated;         ///< Whether or not the Transform object was updated since the last frame
 
+    // Result of the last transform pass, see updateTransforms()
+    std::uint32_t _preparedPass;
+    std::uint32_t _preparedParentFlags;
+    std::uint32_t _preparedFlags;
+    const Mat4* _preparedParentTransform;
+    static std::uint32_t s_transformPass;
+
 #if CC_LITTLE_ENDIAN
     union {
         struct {
@@ -31,6 +31,7 @@ THE SOFTWARE.
 #include "base/CCEventType.h"
 #include "base/CCConfiguration.h"
 #include "base/CCDirector.h"
+#include "base/CCAsyncTaskPool.h"
 #include "base/CCEventListenerCustom.h"
 #include "base/CCEventDispatcher.h"
 #include "renderer/CCRenderer.h"
@@ -442,19 +443,34 @@ bool RenderTexture::saveToFile(const std::string& fileName, Image::Format format
 void RenderTexture::onSaveToFile(const std::string& filename, bool isRGBA, bool forceNonPMA)
 {
     auto callbackFunc = [&, filename, isRGBA, forceNonPMA](Image* image){
-        if (image)
+        // another save may replace the callback before this one is written
+        auto saveFileCallback = _saveFileCallback;
+        if (!image)
         {
+            if (saveFileCallback)
+            {
+                saveFileCallback(this, filename);
+            }
+            return;
+        }
+
+        // only the readback happens in the frame, the pixels are converted and encoded on a compute thread
+        retain();
+        auto options = _saveOptions;
+        AsyncTaskPool::getInstance()->enqueue(AsyncTaskPool::TaskType::TASK_COMPUTE, [this, image, filename, saveFileCallback](void*) {
+            if (saveFileCallback)
+            {
+                saveFileCallback(this, filename);
+            }
+            delete image;
+            release();
+        }, nullptr, [image, filename, isRGBA, forceNonPMA, options]() {
             if (forceNonPMA && image->hasPremultipliedAlpha())
             {
                 image->reversePremultipliedAlpha();
             }
-            image->saveToFile(filename, !isRGBA);
-        }
-        if(_saveFileCallback)
-        {
-            _saveFileCallback(this, filename);
-        }
-        CC_SAFE_DELETE(image);
+            image->saveToFile(filename, !isRGBA, options);
+        });
     };
     newImage(callbackFunc);
 }
@@ -207,6 +207,17 @@ public:
      * @return Returns true if the operation is successful.
      */
     bool saveToFile(const std::string& filename, Image::Format format, bool isRGBA = true, std::function<void (RenderTexture*, const std::string&)> callback = nullptr);
+
+    /** Sets how the saved files are encoded. The pixels are read back during the render, then converted and
+     * encoded on a compute thread of AsyncTaskPool, and the save callback is called on the main thread once
+     * the file is written.
+     *
+     * @param options The PNG compression and JPG quality, Image::EncodeOptions::fastLossless() suits debug captures.
+     */
+    void setSaveOptions(const Image::EncodeOptions& options) { _saveOptions = options; }
+
+    /** Gets how the saved files are encoded. */
+    const Image::EncodeOptions& getSaveOptions() const { return _saveOptions; }
     
     /** Listen "come to background" message, and save render texture.
      * It only has effect on Android.
@@ -391,6 +402,7 @@ protected:
     */
     CallbackCommand _saveToFileCommand;
     std::function<void (RenderTexture*, const std::string&)> _saveFileCallback = nullptr;
+    Image::EncodeOptions _saveOptions;
     
     Mat4 _oldTransMatrix, _oldProjMatrix;
     Mat4 _transformMatrix, _projectionMatrix;
@@ -207,6 +207,8 @@ void Scene::render(Renderer* renderer, const Mat4& eyeTransform, const Mat4* eye
         //clear background with max depth
         camera->clearBackground();
         //visit the scene
+        if (director->getTransformThreads() > 1)
+            updateTransforms(transform, 0, director->getTransformThreads());
         visit(renderer, transform, 0);
 #if CC_USE_NAVMESH
         if (_navMesh && _navMeshDebugCamera == camera)
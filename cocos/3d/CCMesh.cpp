@@ -347,6 +347,9 @@ void Mesh::setMaterial(Material* material)
                     auto& attributes = program->getActiveAttributes();
                     auto meshVertexData = _meshIndexData->getMeshVertexData();
                     auto attributeCount = meshVertexData->getMeshVertexAttribCount();
+                    // the instance attribute is supplied by the renderer
+                    if (program->getAttributeLocation(backend::Attribute::INSTANCE) >= 0)
+                        ++attributeCount;
                     CCASSERT(attributes.size() <= attributeCount, "missing attribute data");
                 }
 #endif
@@ -167,7 +167,7 @@ void MotionStreak3D::initCustomCommand()
     _locMVP = _programState->getUniformLocation("u_MVPMatrix");
     _locTexture = _programState->getUniformLocation("u_texture");
 
-    _customCommand.createVertexBuffer(sizeof(VertexData), _vertexData.size(), CustomCommand::BufferUsage::DYNAMIC);
+    _customCommand.createVertexBuffer(sizeof(VertexData), _vertexData.size(), CustomCommand::BufferUsage::STREAM);
 }
 
 void MotionStreak3D::setPosition(const Vec2& position)
@@ -423,7 +423,7 @@ void MotionStreak3D::draw(Renderer *renderer, const Mat4 &transform, uint32_t fl
     _beforeCommand.func = CC_CALLBACK_0(MotionStreak3D::onBeforeDraw, this);
     _afterCommand.func = CC_CALLBACK_0(MotionStreak3D::onAfterDraw, this);
     
-    _customCommand.updateVertexBuffer(_vertexData.data(), sizeof(_vertexData[0]) * _nuPoints * 2);
+    _customCommand.streamVertexBuffer(_vertexData.data(), sizeof(_vertexData[0]) * _nuPoints * 2);
 
     _customCommand.setVertexDrawInfo(0, _nuPoints * 2);
 
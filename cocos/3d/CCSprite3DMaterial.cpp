@@ -45,6 +45,8 @@ Sprite3DMaterial* Sprite3DMaterial::_vertexLitMaterial = nullptr;
 Sprite3DMaterial* Sprite3DMaterial::_diffuseMaterial = nullptr;
 Sprite3DMaterial* Sprite3DMaterial::_diffuseNoTexMaterial = nullptr;
 Sprite3DMaterial* Sprite3DMaterial::_bumpedDiffuseMaterial = nullptr;
+Sprite3DMaterial* Sprite3DMaterial::_unLitInstanceMaterial = nullptr;
+Sprite3DMaterial* Sprite3DMaterial::_unLitNoTexInstanceMaterial = nullptr;
 
 Sprite3DMaterial* Sprite3DMaterial::_unLitMaterialSkin = nullptr;
 Sprite3DMaterial* Sprite3DMaterial::_vertexLitMaterialSkin = nullptr;
@@ -57,6 +59,8 @@ backend::ProgramState* Sprite3DMaterial::_vertexLitMaterialProgState = nullptr;
 backend::ProgramState* Sprite3DMaterial::_diffuseMaterialProgState = nullptr;
 backend::ProgramState* Sprite3DMaterial::_diffuseNoTexMaterialProgState = nullptr;
 backend::ProgramState* Sprite3DMaterial::_bumpedDiffuseMaterialProgState = nullptr;
+backend::ProgramState* Sprite3DMaterial::_unLitInstanceMaterialProgState = nullptr;
+backend::ProgramState* Sprite3DMaterial::_unLitNoTexInstanceMaterialProgState = nullptr;
 
 backend::ProgramState* Sprite3DMaterial::_unLitMaterialSkinProgState = nullptr;
 backend::ProgramState* Sprite3DMaterial::_vertexLitMaterialSkinProgState = nullptr;
@@ -130,6 +134,29 @@ void Sprite3DMaterial::createBuiltInMaterial()
     {
         _bumpedDiffuseMaterialSkin->_type = Sprite3DMaterial::MaterialType::BUMPED_DIFFUSE;
     }
+
+    // only built when the device supports instanced drawing
+    program = backend::Program::getBuiltinProgram(backend::ProgramType::POSITION_TEXTURE_3D_INSTANCE);
+    if (program)
+    {
+        _unLitInstanceMaterialProgState = new (std::nothrow) backend::ProgramState(program);
+        _unLitInstanceMaterial = new (std::nothrow) Sprite3DMaterial();
+        if (_unLitInstanceMaterial && _unLitInstanceMaterial->initWithProgramState(_unLitInstanceMaterialProgState))
+        {
+            _unLitInstanceMaterial->_type = Sprite3DMaterial::MaterialType::UNLIT_INSTANCE;
+        }
+    }
+
+    program = backend::Program::getBuiltinProgram(backend::ProgramType::POSITION_3D_INSTANCE);
+    if (program)
+    {
+        _unLitNoTexInstanceMaterialProgState = new (std::nothrow) backend::ProgramState(program);
+        _unLitNoTexInstanceMaterial = new (std::nothrow) Sprite3DMaterial();
+        if (_unLitNoTexInstanceMaterial && _unLitNoTexInstanceMaterial->initWithProgramState(_unLitNoTexInstanceMaterialProgState))
+        {
+            _unLitNoTexInstanceMaterial->_type = Sprite3DMaterial::MaterialType::UNLIT_NOTEX_INSTANCE;
+        }
+    }
 }
 
 void Sprite3DMaterial::releaseBuiltInMaterial()
@@ -142,6 +169,8 @@ void Sprite3DMaterial::releaseBuiltInMaterial()
     CC_SAFE_RELEASE_NULL(_diffuseMaterial);
     CC_SAFE_RELEASE_NULL(_diffuseNoTexMaterial);
     CC_SAFE_RELEASE_NULL(_bumpedDiffuseMaterial);
+    CC_SAFE_RELEASE_NULL(_unLitInstanceMaterial);
+    CC_SAFE_RELEASE_NULL(_unLitNoTexInstanceMaterial);
     
     CC_SAFE_RELEASE_NULL(_vertexLitMaterialSkin);
     CC_SAFE_RELEASE_NULL(_diffuseMaterialSkin);
@@ -153,6 +182,8 @@ void Sprite3DMaterial::releaseBuiltInMaterial()
     CC_SAFE_RELEASE_NULL(_diffuseMaterialProgState);
     CC_SAFE_RELEASE_NULL(_diffuseNoTexMaterialProgState);
     CC_SAFE_RELEASE_NULL(_bumpedDiffuseMaterialProgState);
+    CC_SAFE_RELEASE_NULL(_unLitInstanceMaterialProgState);
+    CC_SAFE_RELEASE_NULL(_unLitNoTexInstanceMaterialProgState);
 
     CC_SAFE_RELEASE_NULL(_unLitMaterialSkinProgState);
     CC_SAFE_RELEASE_NULL(_vertexLitMaterialSkinProgState);
@@ -227,6 +258,18 @@ Sprite3DMaterial* Sprite3DMaterial::createBuiltInMaterial(MaterialType type, boo
         case Sprite3DMaterial::MaterialType::BUMPED_DIFFUSE:
             material = skinned ? _bumpedDiffuseMaterialSkin : _bumpedDiffuseMaterial;
             break;
+
+        case Sprite3DMaterial::MaterialType::UNLIT_INSTANCE:
+            // the skin matrix palette is per instance, skinned meshes can't be instanced
+            if (skinned)
+                material = _unLitMaterialSkin;
+            else
+                material = _unLitInstanceMaterial ? _unLitInstanceMaterial : _unLitMaterial;
+            break;
+
+        case Sprite3DMaterial::MaterialType::UNLIT_NOTEX_INSTANCE:
+            material = _unLitNoTexInstanceMaterial ? _unLitNoTexInstanceMaterial : _unLitNoTexMaterial;
+            break;
             
         default:
             break;
@@ -63,6 +63,8 @@ public:
         DIFFUSE, // diffuse (pixel lighting)
         DIFFUSE_NOTEX, //diffuse (without texture)
         BUMPED_DIFFUSE, //bumped diffuse
+        UNLIT_INSTANCE, //unlit material drawn with hardware instancing, falls back to UNLIT without it
+        UNLIT_NOTEX_INSTANCE, //unlit material without texture drawn with hardware instancing, falls back to UNLIT_NOTEX without it
         
         //Custom material
         CUSTOM, //Create from material file
@@ -129,6 +131,8 @@ protected:
     static Sprite3DMaterial* _diffuseMaterial;
     static Sprite3DMaterial* _diffuseNoTexMaterial;
     static Sprite3DMaterial* _bumpedDiffuseMaterial;
+    static Sprite3DMaterial* _unLitInstanceMaterial;
+    static Sprite3DMaterial* _unLitNoTexInstanceMaterial;
     
     static Sprite3DMaterial* _unLitMaterialSkin;
     static Sprite3DMaterial* _vertexLitMaterialSkin;
@@ -141,6 +145,8 @@ protected:
     static backend::ProgramState* _diffuseMaterialProgState;
     static backend::ProgramState* _diffuseNoTexMaterialProgState;
     static backend::ProgramState* _bumpedDiffuseMaterialProgState;
+    static backend::ProgramState* _unLitInstanceMaterialProgState;
+    static backend::ProgramState* _unLitNoTexInstanceMaterialProgState;
 
     static backend::ProgramState* _unLitMaterialSkinProgState;
     static backend::ProgramState* _vertexLitMaterialSkinProgState;
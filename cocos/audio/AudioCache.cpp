@@ -33,6 +33,7 @@
 #include <thread>
 #include "base/CCDirector.h"
 #include "base/CCScheduler.h"
+#include "platform/CCFileUtils.h"
 
 #include "audio/include/AudioDecoderManager.h"
 #include "audio/include/AudioDecoder.h"
@@ -127,7 +128,13 @@ void AudioCache::readDataTask(unsigned int selfId)
     AudioDecoder* decoder = AudioDecoderManager::createDecoder(_fileFullPath);
     do
     {
-        if (decoder == nullptr || !decoder->open(_fileFullPath))
+        if (decoder == nullptr)
+            break;
+        if (_compressedData != nullptr)
+        {
+            BREAK_IF_ERR_LOG(!decoder->openData(_fileFullPath, _compressedData), "decoding %s from memory failed", _fileFullPath.c_str());
+        }
+        else if (!decoder->open(_fileFullPath))
             break;
 
         const uint32_t originalTotalFrames = decoder->getTotalFrames();
@@ -220,6 +227,14 @@ void AudioCache::readDataTask(unsigned int selfId)
             }
             ALOGV("pcm buffer was loaded successfully, total frames: %u, total read frames: %u, remainingFrames: %u", totalFrames, _framesRead, remainingFrames);
 
+            // small compressed files are kept, to decode them from memory instead of the file system after an eviction
+            if (_keepCompressedData && _compressedData == nullptr)
+            {
+                auto data = FileUtils::getInstance()->getDataFromFile(_fileFullPath);
+                if (!data.isNull())
+                    _compressedData = std::make_shared<Data>(std::move(data));
+            }
+
             if(sourceFormat == AUDIO_SOURCE_FORMAT::ADPCM || sourceFormat == AUDIO_SOURCE_FORMAT::IMA_ADPCM)
                 alBufferi(_alBufferId, AL_UNPACK_BLOCK_ALIGNMENT_SOFT, decoder->getSamplesPerBlock());
             alBufferData(_alBufferId, _format, pcmData, (ALsizei)dataSize, (ALsizei)sampleRate);
@@ -231,6 +246,7 @@ void AudioCache::readDataTask(unsigned int selfId)
                 break;
             }
 
+            _pcmDataSize = dataSize;
             _state = State::READY;
         }
         else
@@ -48,6 +48,11 @@ AudioDecoder::AudioDecoder()
     }
 
 
+    bool AudioDecoder::openData(const std::string& /*path*/, const std::shared_ptr<Data>& /*data*/)
+    {
+        return false;
+    }
+
     bool AudioDecoder::isOpened() const
     {
         return _isOpened;
@@ -79,6 +79,16 @@ AudioDecoder* AudioDecoderManager::createDecoder(const std::string& path)
     return nullptr;
 }
 
+bool AudioDecoderManager::canDecodeData(const std::string& path)
+{
+    cxx17::string_view svPath(path);
+#if CC_TARGET_PLATFORM != CC_PLATFORM_IOS
+    return cxx20::ic::ends_with(svPath, ".ogg") || cxx20::ic::ends_with(svPath, ".mp3");
+#else
+    return cxx20::ic::ends_with(svPath, ".ogg");
+#endif
+}
+
 void AudioDecoderManager::destroyDecoder(AudioDecoder* decoder)
 {
     if (decoder) decoder->close();
@@ -26,6 +26,7 @@
 #define LOG_TAG "AudioDecoderMp3"
 #include "audio/include/AudioDecoderMp3.h"
 #include "audio/include/AudioMacros.h"
+#include "audio/include/AudioSampleConverter.h"
 #include "platform/CCFileUtils.h"
 
 #include "base/CCConsole.h"
@@ -96,6 +97,27 @@ namespace cocos2d {
     }
 
     bool AudioDecoderMp3::open(const std::string& fullPath)
+    {
+        if (!_fileStream.open(fullPath))
+        {
+            ALOGE("Trouble with mpg123(1): %s\n", strerror(errno));
+            return false;
+        }
+        return openStream();
+    }
+
+    bool AudioDecoderMp3::openData(const std::string& path, const std::shared_ptr<Data>& data)
+    {
+        if (data == nullptr || !_fileStream.openMemory(data->getBytes(), static_cast<long>(data->getSize())))
+        {
+            ALOGE("Trouble with mpg123(1): no data for %s\n", path.c_str());
+            return false;
+        }
+        _data = data;
+        return openStream();
+    }
+
+    bool AudioDecoderMp3::openStream()
     {
         long rate = 0;
         int error = MPG123_OK;
@@ -109,12 +131,6 @@ namespace cocos2d {
                 ALOGE("Basic setup goes wrong: %s", mpg123_plain_strerror(error));
                 break;
             }
-            
-            if (!_fileStream.open(fullPath))
-            {
-                ALOGE("Trouble with mpg123(1): %s\n", strerror(errno));
-                break;
-            }
 
             mpg123_replace_reader_handle(_mpg123handle, mpg123_read_r, mpg123_lseek_r, mpg123_close_r);
 
@@ -135,8 +151,10 @@ namespace cocos2d {
             }
             else if (mp3Encoding == MPG123_ENC_FLOAT_32)
             {
-                _bytesPerBlock = 4 * _channelCount;
-                _sourceFormat = AUDIO_SOURCE_FORMAT::PCM_FLT32;
+                // Converted by read(), 16 bits samples take half the memory in the cache and OpenAL.
+                _bytesPerBlock = 2 * _channelCount;
+                _sourceFormat = AUDIO_SOURCE_FORMAT::PCM_16;
+                _floatOutput = true;
             }
             else
             {
@@ -181,8 +199,26 @@ namespace cocos2d {
 
     uint32_t AudioDecoderMp3::read(uint32_t framesToRead, char* pcmBuf)
     {
-        int bytesToRead = framesToBytes(framesToRead);
         size_t bytesRead = 0;
+        if (_floatOutput)
+        {
+            size_t samplesToRead = static_cast<size_t>(framesToRead) * _channelCount;
+            if (_readBuffer.size() < samplesToRead)
+                _readBuffer.resize(samplesToRead);
+
+            int err = mpg123_read(_mpg123handle, (unsigned char*)_readBuffer.data(), samplesToRead * sizeof(float), &bytesRead);
+            if (err == MPG123_ERR)
+            {
+                ALOGE("Trouble with mpg123: %s\n", mpg123_strerror(_mpg123handle) );
+                return 0;
+            }
+
+            uint32_t frames = static_cast<uint32_t>(bytesRead / (sizeof(float) * _channelCount));
+            AudioSampleConverter::f32ToS16(_readBuffer.data(), reinterpret_cast<int16_t*>(pcmBuf), static_cast<size_t>(frames) * _channelCount);
+            return frames;
+        }
+
+        int bytesToRead = framesToBytes(framesToRead);
         int err = mpg123_read(_mpg123handle, (unsigned char*)pcmBuf, bytesToRead, &bytesRead);
         if (err == MPG123_ERR)
         {
@@ -27,7 +27,9 @@
 
 #include "audio/include/AudioDecoderOgg.h"
 #include "audio/include/AudioMacros.h"
+#include "audio/include/AudioSampleConverter.h"
 #include "platform/CCFileUtils.h"
+#include "base/CCData.h"
 
 #if CC_TARGET_PLATFORM == CC_PLATFORM_ANDROID
 #include <unistd.h>
@@ -74,7 +76,22 @@ namespace cocos2d {
             ALOGE("Trouble with ogg(1): %s\n", strerror(errno));
             return false;
         }
+        return openStream();
+    }
+
+    bool AudioDecoderOgg::openData(const std::string& path, const std::shared_ptr<Data>& data)
+    {
+        if (data == nullptr || !_fileStream.openMemory(data->getBytes(), static_cast<long>(data->getSize())))
+        {
+            ALOGE("Trouble with ogg(1): no data for %s\n", path.c_str());
+            return false;
+        }
+        _data = data;
+        return openStream();
+    }
 
+    bool AudioDecoderOgg::openStream()
+    {
         static ov_callbacks OV_CALLBACKS_POSIX = {
                ov_fread_r,
                ov_fseek_r,
@@ -87,8 +104,15 @@ namespace cocos2d {
             // header
             vorbis_info* vi = ov_info(&_vf, -1);
             _sampleRate = static_cast<uint32_t>(vi->rate);
-            _channelCount = vi->channels;
-            _bytesPerBlock = vi->channels * sizeof(short);
+            _fileChannels = vi->channels;
+            if (_fileChannels > 2 && !AudioSampleConverter::canDownmix(_fileChannels))
+            {
+                ALOGE("Trouble with ogg(2): %u channels aren't supported\n", _fileChannels);
+                ov_clear(&_vf);
+                return false;
+            }
+            _channelCount = (std::min)(_fileChannels, 2u);
+            _bytesPerBlock = _channelCount * sizeof(short);
             _totalFrames = static_cast<uint32_t>(ov_pcm_total(&_vf, -1));
             _isOpened = true;
             return true;
@@ -108,9 +132,22 @@ namespace cocos2d {
     uint32_t AudioDecoderOgg::read(uint32_t framesToRead, char* pcmBuf)
     {
         int currentSection = 0;
-        int bytesToRead = framesToBytes(framesToRead);
-        long bytesRead = ov_read(&_vf, pcmBuf, bytesToRead, 0, 2, 1, &currentSection);
-        return bytesToFrames(bytesRead);
+        if (_fileChannels <= 2)
+        {
+            int bytesToRead = framesToBytes(framesToRead);
+            long bytesRead = ov_read(&_vf, pcmBuf, bytesToRead, 0, 2, 1, &currentSection);
+            return bytesToFrames(bytesRead);
+        }
+
+        size_t samplesToRead = static_cast<size_t>(framesToRead) * _fileChannels;
+        if (_readBuffer.size() < samplesToRead)
+            _readBuffer.resize(samplesToRead);
+
+        long bytesRead = ov_read(&_vf, reinterpret_cast<char*>(_readBuffer.data()), static_cast<int>(samplesToRead * sizeof(short)), 0, 2, 1, &currentSection);
+        uint32_t frames = bytesRead > 0 ? static_cast<uint32_t>(bytesRead / (_fileChannels * sizeof(short))) : 0;
+        AudioSampleConverter::downmixToStereo(_readBuffer.data(), reinterpret_cast<int16_t*>(pcmBuf), frames, _fileChannels,
+            AudioSampleConverter::ChannelOrder::VORBIS);
+        return frames;
     }
 
     bool AudioDecoderOgg::seek(uint32_t frameOffset)
@@ -28,6 +28,7 @@
 #include <assert.h>
 #include "audio/include/AudioDecoderWav.h"
 #include "audio/include/AudioMacros.h"
+#include "audio/include/AudioSampleConverter.h"
 #include "platform/CCFileUtils.h"
 
 namespace cocos2d {
@@ -94,15 +95,24 @@ namespace cocos2d {
         auto h = &wavf->FileHeader;
 
         // Parsing FMT chunk
-        if (!wav_scan_chunk(wavf, WAV_FMT_ID, &wavf->FileHeader.Fmt, &wavf->FileHeader.Fmt.AudioFormat, sizeof(wavf->FileHeader.Fmt) - sizeof(WAV_RIFF_CHUNK)))
+        if (!wav_scan_chunk(wavf, WAV_FMT_ID, &wavf->FileHeader.Fmt, &wavf->FileHeader.Fmt.AudioFormat, sizeof(wavf->FileHeader.Fmt) - sizeof(WAV_CHUNK_HEADER)))
             return false;
 
         auto& fmtInfo = h->Fmt;
 
         int bitDepth = (fmtInfo.BitsPerSample);
 
+        auto audioFormat = fmtInfo.AudioFormat;
+        if (audioFormat == WAV_FORMAT::EXT)
+        { // Check sub-format, the samples are then read like the plain formats.
+            if (IsEqualGUID(fmtInfo.ExtParams.SubFormat, WAV_SUBTYPE_PCM))
+                audioFormat = WAV_FORMAT::PCM;
+            else if (IsEqualGUID(fmtInfo.ExtParams.SubFormat, WAV_SUBTYPE_IEEE_FLOAT))
+                audioFormat = WAV_FORMAT::IEEE;
+        }
+
         // Read PCM data or extensible data if exists.
-        switch (fmtInfo.AudioFormat)
+        switch (audioFormat)
         { // Check supported format
         case WAV_FORMAT::PCM:
         case WAV_FORMAT::IEEE:
@@ -111,15 +121,15 @@ namespace cocos2d {
             case 8: wavf->SourceFormat = AUDIO_SOURCE_FORMAT::PCM_U8; break;
             case 16: wavf->SourceFormat = AUDIO_SOURCE_FORMAT::PCM_16; break;
             case 24: wavf->SourceFormat = AUDIO_SOURCE_FORMAT::PCM_24; break;
-            case 32: wavf->SourceFormat = (fmtInfo.AudioFormat == WAV_FORMAT::IEEE) ? AUDIO_SOURCE_FORMAT::PCM_FLT32 : AUDIO_SOURCE_FORMAT::PCM_32; break;
-            case 64: wavf->SourceFormat = (fmtInfo.AudioFormat == WAV_FORMAT::IEEE) ? AUDIO_SOURCE_FORMAT::PCM_FLT64 : AUDIO_SOURCE_FORMAT::PCM_64; break;
+            case 32: wavf->SourceFormat = (audioFormat == WAV_FORMAT::IEEE) ? AUDIO_SOURCE_FORMAT::PCM_FLT32 : AUDIO_SOURCE_FORMAT::PCM_32; break;
+            case 64: wavf->SourceFormat = (audioFormat == WAV_FORMAT::IEEE) ? AUDIO_SOURCE_FORMAT::PCM_FLT64 : AUDIO_SOURCE_FORMAT::PCM_64; break;
             }
             break;
         case WAV_FORMAT::MULAW:
             wavf->SourceFormat = AUDIO_SOURCE_FORMAT::MULAW;
             break;
         case WAV_FORMAT::ALAW:
-            wavf->SourceFormat = AUDIO_SOURCE_FORMAT::MULAW;
+            wavf->SourceFormat = AUDIO_SOURCE_FORMAT::ALAW;
             break;
         case WAV_FORMAT::ADPCM:
             wavf->SourceFormat = AUDIO_SOURCE_FORMAT::ADPCM;
@@ -128,14 +138,9 @@ namespace cocos2d {
             wavf->SourceFormat = AUDIO_SOURCE_FORMAT::IMA_ADPCM;
             break;
         case WAV_FORMAT::EXT:
-            // Check sub-format.
-            if (!IsEqualGUID(fmtInfo.ExtParams.SubFormat, WAV_SUBTYPE_PCM)
-                && !IsEqualGUID(fmtInfo.ExtParams.SubFormat, WAV_SUBTYPE_IEEE_FLOAT))
-            {
-                fileStream.close();
-                return false;
-            }
-            break;
+            // Unknown sub-format.
+            fileStream.close();
+            return false;
         default:
             ALOGW("The wav format %d doesn't supported currently!", (int)fmtInfo.AudioFormat);
             fileStream.close();
@@ -162,6 +167,35 @@ namespace cocos2d {
         return  wavf->Stream.close();
     }
 
+    static bool needsConversion(AUDIO_SOURCE_FORMAT format, uint32_t channels)
+    {
+        switch (format)
+        {
+        case AUDIO_SOURCE_FORMAT::PCM_24:
+        case AUDIO_SOURCE_FORMAT::PCM_32:
+        case AUDIO_SOURCE_FORMAT::PCM_FLT32:
+        case AUDIO_SOURCE_FORMAT::PCM_FLT64:
+            return true;
+        default:
+            return channels > 2;
+        }
+    }
+
+    static bool canConvert(AUDIO_SOURCE_FORMAT format, uint32_t channels)
+    {
+        switch (format)
+        {
+        case AUDIO_SOURCE_FORMAT::PCM_16:
+        case AUDIO_SOURCE_FORMAT::PCM_24:
+        case AUDIO_SOURCE_FORMAT::PCM_32:
+        case AUDIO_SOURCE_FORMAT::PCM_FLT32:
+        case AUDIO_SOURCE_FORMAT::PCM_FLT64:
+            return channels > 0 && (channels <= 2 || AudioSampleConverter::canDownmix(channels));
+        default:
+            return false;
+        }
+    }
+
     AudioDecoderWav::AudioDecoderWav()
     {
         memset(&_wavf, 0, offsetof(WAV_FILE, Stream));
@@ -193,7 +227,28 @@ namespace cocos2d {
             default:;
             }
 
-            _totalFrames = bytesToFrames(_wavf.FileHeader.PcmData.ChunkSize);
+            _sourceBytesPerFrame = 0;
+            if (needsConversion(_sourceFormat, _channelCount))
+            {
+                if (!canConvert(_sourceFormat, _channelCount))
+                {
+                    ALOGE("The wav format %d with %u channels isn't supported!", (int)_sourceFormat, _channelCount);
+                    wav_close(&_wavf);
+                    return false;
+                }
+
+                _fileFormat = _sourceFormat;
+                _fileChannels = _channelCount;
+                _sourceBytesPerFrame = _bytesPerBlock;
+                _sourceFormat = AUDIO_SOURCE_FORMAT::PCM_16;
+                _channelCount = (std::min)(_channelCount, 2u);
+                _bytesPerBlock = _channelCount * sizeof(int16_t);
+                _totalFrames = _wavf.FileHeader.PcmData.ChunkSize / _sourceBytesPerFrame;
+            }
+            else
+            {
+                _totalFrames = bytesToFrames(_wavf.FileHeader.PcmData.ChunkSize);
+            }
 
             _isOpened = true;
             return true;
@@ -226,14 +281,53 @@ namespace cocos2d {
 
     uint32_t AudioDecoderWav::read(uint32_t framesToRead, char* pcmBuf)
     {
-        auto bytesToRead = framesToBytes(framesToRead);
-        long bytesRead = wav_read(&_wavf, pcmBuf, bytesToRead);
-        return bytesToFrames(bytesRead);
+        if (_sourceBytesPerFrame == 0)
+        {
+            auto bytesToRead = framesToBytes(framesToRead);
+            long bytesRead = wav_read(&_wavf, pcmBuf, bytesToRead);
+            return bytesToFrames(bytesRead);
+        }
+
+        auto bytesToRead = framesToRead * _sourceBytesPerFrame;
+        if (_readBuffer.size() < bytesToRead)
+            _readBuffer.resize(bytesToRead);
+
+        long bytesRead = wav_read(&_wavf, _readBuffer.data(), bytesToRead);
+        uint32_t frames = bytesRead > 0 ? static_cast<uint32_t>(bytesRead) / _sourceBytesPerFrame : 0;
+        size_t samples = static_cast<size_t>(frames) * _fileChannels;
+
+        // The 16 bits samples of all the channels go to pcmBuf, or are converted in place when they are mixed down afterwards.
+        auto raw = _readBuffer.data();
+        auto samples16 = reinterpret_cast<int16_t*>(_fileChannels > 2 ? raw : pcmBuf);
+        switch (_fileFormat)
+        {
+        case AUDIO_SOURCE_FORMAT::PCM_24:
+            AudioSampleConverter::s24ToS16(reinterpret_cast<const uint8_t*>(raw), samples16, samples);
+            break;
+        case AUDIO_SOURCE_FORMAT::PCM_32:
+            AudioSampleConverter::s32ToS16(reinterpret_cast<const int32_t*>(raw), samples16, samples);
+            break;
+        case AUDIO_SOURCE_FORMAT::PCM_FLT32:
+            AudioSampleConverter::f32ToS16(reinterpret_cast<const float*>(raw), samples16, samples);
+            break;
+        case AUDIO_SOURCE_FORMAT::PCM_FLT64:
+            AudioSampleConverter::f64ToS16(reinterpret_cast<const double*>(raw), samples16, samples);
+            break;
+        default: // PCM_16, only mixed down
+            break;
+        }
+
+        if (_fileChannels > 2)
+        {
+            AudioSampleConverter::downmixToStereo(samples16, reinterpret_cast<int16_t*>(pcmBuf), frames, _fileChannels,
+                AudioSampleConverter::ChannelOrder::WAVE);
+        }
+        return frames;
     }
 
     bool AudioDecoderWav::seek(uint32_t frameOffset)
     {
-        auto offset = framesToBytes(frameOffset);
+        auto offset = _sourceBytesPerFrame != 0 ? frameOffset * _sourceBytesPerFrame : framesToBytes(frameOffset);
         return wav_seek(&_wavf, offset) == offset;
     }
 } // namespace cocos2d {
@@ -28,9 +28,11 @@
 
 #include "audio/include/AudioEngine.h"
 #include <condition_variable>
+#include <memory>
 #include <queue>
 #include "platform/CCFileUtils.h"
 #include "base/ccUtils.h"
+#include "base/CCFrameProfiler.h"
 
 #include "audio/include/AudioEngineImpl.h"
 
@@ -49,7 +51,10 @@ const float AudioEngine::TIME_UNKNOWN = -1.0f;
 std::unordered_map<std::string,std::list<AUDIO_ID>> AudioEngine::_audioPathIDMap;
 //profileName,ProfileHelper
 std::unordered_map<std::string, AudioEngine::ProfileHelper> AudioEngine::_audioPathProfileHelperMap;
-unsigned int AudioEngine::_maxInstances = MAX_AUDIOINSTANCES;
+unsigned int AudioEngine::_maxInstances = MAX_AUDIOVOICES;
+size_t AudioEngine::_cacheBudget = 0;
+size_t AudioEngine::_compressedCacheBudget = 0;
+int AudioEngine::_offlineSampleRate = 0;
 AudioEngine::ProfileHelper* AudioEngine::_defaultProfileHelper = nullptr;
 std::unordered_map<AUDIO_ID, AudioEngine::AudioInfo> AudioEngine::_audioIDInfoMap;
 AudioEngineImpl* AudioEngine::_audioEngineImpl = nullptr;
@@ -105,6 +110,7 @@ public:
 private:
     void threadFunc()
     {
+        CC_PROFILE_THREAD("AudioEngine");
         while (true) {
             std::function<void()> task = nullptr;
             {
@@ -125,6 +131,7 @@ private:
                 }
             }
 
+            CC_PROFILE_ZONE("AudioEngine::task");
             task();
         }
     }
@@ -227,7 +234,12 @@ AUDIO_ID AudioEngine::play2d(const std::string& filePath, bool loop, float volum
             volume = 1.0f;
         }
         
-        ret = _audioEngineImpl->play2d(filePath, loop, volume);
+        float profileVolume = profileHelper ? profileHelper->profile.volume : 1.0f;
+#if CC_USE_ALSOFT
+        ret = _audioEngineImpl->play2d(filePath, loop, volume * profileVolume, profileHelper ? profileHelper->profile.priority : 0);
+#else
+        ret = _audioEngineImpl->play2d(filePath, loop, volume * profileVolume);
+#endif
         if (ret != INVALID_AUDIO_ID)
         {
             _audioPathIDMap[filePath].push_back(ret);
@@ -270,7 +282,8 @@ void AudioEngine::setVolume(AUDIO_ID audioID, float volume)
         }
 
         if (it->second.volume != volume){
-            _audioEngineImpl->setVolume(audioID, volume);
+            auto profileHelper = it->second.profileHelper;
+            _audioEngineImpl->setVolume(audioID, volume * (profileHelper ? profileHelper->profile.volume : 1.0f));
             it->second.volume = volume;
         }
     }
@@ -448,7 +461,7 @@ void AudioEngine::setFinishCallback(AUDIO_ID audioID, const std::function<void (
 
 bool AudioEngine::setMaxAudioInstance(int maxInstances)
 {
-    if (maxInstances > 0 && maxInstances <= MAX_AUDIOINSTANCES) {
+    if (maxInstances > 0 && maxInstances <= MAX_AUDIOVOICES) {
         _maxInstances = maxInstances;
         return true;
     }
@@ -546,6 +559,132 @@ void AudioEngine::preload(const std::string& filePath, std::function<void(bool i
     }
 }
 
+void AudioEngine::preloadBatch(const std::vector<std::string>& filePaths, std::function<void(int loaded, int total)> progressCallback,
+                               std::function<void(bool allSucceeded)> callback)
+{
+    int total = static_cast<int>(filePaths.size());
+    if (total == 0)
+    {
+        if (callback)
+        {
+            callback(true);
+        }
+        return;
+    }
+
+    // The preload callbacks are all invoked on the cocos thread, no need to lock the state of the batch.
+    struct BatchState
+    {
+        int loaded = 0;
+        bool allSucceeded = true;
+    };
+    auto state = std::make_shared<BatchState>();
+
+    for (auto&& filePath : filePaths)
+    {
+        preload(filePath, [state, total, progressCallback, callback](bool isSuccess){
+            state->allSucceeded = state->allSucceeded && isSuccess;
+            ++state->loaded;
+            if (progressCallback)
+            {
+                progressCallback(state->loaded, total);
+            }
+            if (state->loaded == total && callback)
+            {
+                callback(state->allSucceeded);
+            }
+        });
+    }
+}
+
+void AudioEngine::setCacheBudget(size_t bytes)
+{
+    _cacheBudget = bytes;
+#if CC_USE_ALSOFT
+    if (_audioEngineImpl)
+    {
+        _audioEngineImpl->enforceCacheBudget();
+    }
+#endif
+}
+
+void AudioEngine::setCompressedCacheBudget(size_t bytes)
+{
+    _compressedCacheBudget = bytes;
+#if CC_USE_ALSOFT
+    if (_audioEngineImpl)
+    {
+        _audioEngineImpl->enforceCacheBudget();
+    }
+#endif
+}
+
+AudioEngine::CacheStats AudioEngine::getCacheStats()
+{
+#if CC_USE_ALSOFT
+    if (_audioEngineImpl)
+    {
+        return _audioEngineImpl->getCacheStats();
+    }
+#endif
+    return CacheStats();
+}
+
+void AudioEngine::resetCacheStats()
+{
+#if CC_USE_ALSOFT
+    if (_audioEngineImpl)
+    {
+        _audioEngineImpl->resetCacheStats();
+    }
+#endif
+}
+
+bool AudioEngine::isVirtual(AUDIO_ID audioID)
+{
+#if CC_USE_ALSOFT
+    if (_audioEngineImpl && _audioIDInfoMap.find(audioID) != _audioIDInfoMap.end())
+    {
+        return _audioEngineImpl->isVirtual(audioID);
+    }
+#endif
+    return false;
+}
+
+AudioEngine::VoiceStats AudioEngine::getVoiceStats()
+{
+#if CC_USE_ALSOFT
+    if (_audioEngineImpl)
+    {
+        return _audioEngineImpl->getVoiceStats();
+    }
+#endif
+    return VoiceStats();
+}
+
+bool AudioEngine::enableOfflineRendering(int sampleRate)
+{
+#if CC_USE_ALSOFT
+    if (_audioEngineImpl == nullptr && sampleRate > 0)
+    {
+        _offlineSampleRate = sampleRate;
+        return true;
+    }
+#endif
+    return false;
+}
+
+bool AudioEngine::renderOffline(short* buffer, int frames)
+{
+#if CC_USE_ALSOFT
+    if (_offlineSampleRate > 0 && lazyInit())
+    {
+        return _audioEngineImpl->renderOffline(buffer, frames);
+    }
+#endif
+    return false;
+}
+
 void AudioEngine::addTask(const std::function<void()>& task)
 {
     lazyInit();
@@ -42,11 +42,53 @@
 #include "platform/CCFileUtils.h"
 #include "audio/include/AudioDecoderManager.h"
 #include "audio/include/AudioPlayer.h"
+#include "audio/include/AudioStreamer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <unordered_set>
 
 using namespace cocos2d;
 
 static ALCdevice *s_ALDevice = nullptr;
 static ALCcontext *s_ALContext = nullptr;
+static LPALCRENDERSAMPLESSOFT s_alcRenderSamplesSOFT = nullptr;
+
+// Opens a loopback device of ALC_SOFT_loopback, which mixes into memory when asked to
+static ALCdevice* openLoopbackDevice(int sampleRate, ALCint* attributes)
+{
+    if (!alcIsExtensionPresent(nullptr, "ALC_SOFT_loopback"))
+    {
+        ALOGE("ALC_SOFT_loopback isn't supported!");
+        return nullptr;
+    }
+
+    auto alcLoopbackOpenDeviceSOFT = (LPALCLOOPBACKOPENDEVICESOFT)alcGetProcAddress(nullptr, "alcLoopbackOpenDeviceSOFT");
+    auto alcIsRenderFormatSupportedSOFT = (LPALCISRENDERFORMATSUPPORTEDSOFT)alcGetProcAddress(nullptr, "alcIsRenderFormatSupportedSOFT");
+    s_alcRenderSamplesSOFT = (LPALCRENDERSAMPLESSOFT)alcGetProcAddress(nullptr, "alcRenderSamplesSOFT");
+    if (!alcLoopbackOpenDeviceSOFT || !alcIsRenderFormatSupportedSOFT || !s_alcRenderSamplesSOFT)
+        return nullptr;
+
+    auto device = alcLoopbackOpenDeviceSOFT(nullptr);
+    if (device == nullptr)
+        return nullptr;
+
+    if (!alcIsRenderFormatSupportedSOFT(device, sampleRate, ALC_STEREO_SOFT, ALC_SHORT_SOFT))
+    {
+        ALOGE("Rendering 16-bit stereo at %d Hz isn't supported!", sampleRate);
+        alcCloseDevice(device);
+        return nullptr;
+    }
+
+    ALCint loopbackAttributes[] = {
+        ALC_FORMAT_CHANNELS_SOFT, ALC_STEREO_SOFT,
+        ALC_FORMAT_TYPE_SOFT, ALC_SHORT_SOFT,
+        ALC_FREQUENCY, sampleRate,
+        0
+    };
+    memcpy(attributes, loopbackAttributes, sizeof(loopbackAttributes));
+    return device;
+}
 
 AudioEngineImpl::AudioEngineImpl()
 : _lazyInitLoop(true)
@@ -64,6 +106,14 @@ AudioEngineImpl::~AudioEngineImpl()
     }
 
     if (s_ALContext) {
+        // the players still streaming must be removed from the streaming threads before they exit
+        for (auto&& player : _audioPlayers)
+        {
+            delete player.second;
+        }
+        _audioPlayers.clear();
+        AudioStreamer::destroyInstance();
+
         alDeleteSources(MAX_AUDIOINSTANCES, _alSources);
 
         _audioCaches.clear();
@@ -85,11 +135,18 @@ bool AudioEngineImpl::init()
 {
     bool ret = false;
     do{
-        s_ALDevice = alcOpenDevice(nullptr);
+        ALCint attributes[7] = { 0 };
+        bool offline = AudioEngine::isOfflineRendering();
+        if (offline) {
+            s_ALDevice = openLoopbackDevice(AudioEngine::_offlineSampleRate, attributes);
+        }
+        else {
+            s_ALDevice = alcOpenDevice(nullptr);
+        }
 
         if (s_ALDevice) {
             alGetError();
-            s_ALContext = alcCreateContext(s_ALDevice, nullptr);
+            s_ALContext = alcCreateContext(s_ALDevice, offline ? attributes : nullptr);
             alcMakeContextCurrent(s_ALContext);
 
             alGenSources(MAX_AUDIOINSTANCES, _alSources);
@@ -104,6 +161,9 @@ bool AudioEngineImpl::init()
                 _unusedSourcesPool.push(_alSources[i]);
             }
 
+            // the streams of an offline rendering are refilled by renderOffline()
+            AudioStreamer::createInstance(offline ? 0 : AUDIO_STREAMING_THREADS);
+
             _scheduler = Director::getInstance()->getScheduler();
             ret = AudioDecoderManager::init();
             ALOGI("OpenAL was initialized successfully!");
@@ -119,8 +179,24 @@ AudioCache* AudioEngineImpl::preload(const std::string& filePath, std::function<
 
     auto it = _audioCaches.find(filePath);
     if (it == _audioCaches.end()) {
+        ++_cacheStats.misses;
+        // make room before loading, the cache which is added can't be evicted until it is loaded
+        enforceCacheBudget();
+
         audioCache = &_audioCaches[filePath];
         audioCache->_fileFullPath = FileUtils::getInstance()->fullPathForFilename(filePath);
+        if (AudioEngine::_compressedCacheBudget > 0 && AudioDecoderManager::canDecodeData(filePath))
+        {
+            audioCache->_keepCompressedData = true;
+            auto compressed = _compressedCaches.find(filePath);
+            if (compressed != _compressedCaches.end())
+            {
+                ++_cacheStats.compressedHits;
+                _compressedCacheSize -= compressed->second.first->getSize();
+                audioCache->_compressedData = std::move(compressed->second.first);
+                _compressedCaches.erase(compressed);
+            }
+        }
         unsigned int cacheId = audioCache->_id;
         auto isCacheDestroyed = audioCache->_isDestroyed;
         AudioEngine::addTask([audioCache, cacheId, isCacheDestroyed](){
@@ -134,8 +210,10 @@ AudioCache* AudioEngineImpl::preload(const std::string& filePath, std::function<
         });
     }
     else {
+        ++_cacheStats.hits;
         audioCache = &it->second;
     }
+    audioCache->_lastUsed = ++_cacheUseCounter;
 
     if (audioCache && callback)
     {
@@ -144,26 +222,21 @@ AudioCache* AudioEngineImpl::preload(const std::string& filePath, std::function<
     return audioCache;
 }
 
-AUDIO_ID AudioEngineImpl::play2d(const std::string &filePath ,bool loop ,float volume)
+AUDIO_ID AudioEngineImpl::play2d(const std::string &filePath ,bool loop ,float volume, int priority)
 {
     if (s_ALDevice == nullptr) {
         return AudioEngine::INVALID_AUDIO_ID;
     }
 
-    ALuint alSource = findValidSource();
-    if (alSource == AL_INVALID)
-    {
-        return AudioEngine::INVALID_AUDIO_ID;
-    }
-
     auto player = new (std::nothrow) AudioPlayer;
     if (player == nullptr) {
         return AudioEngine::INVALID_AUDIO_ID;
     }
 
-    player->_alSource = alSource;
+    player->_alSource = AL_INVALID;
     player->_loop = loop;
     player->_volume = volume;
+    player->_priority = priority;
 
     auto audioCache = preload(filePath, nullptr);
     if (audioCache == nullptr) {
@@ -173,6 +246,8 @@ AUDIO_ID AudioEngineImpl::play2d(const std::string &filePath ,bool loop ,float v
 
     player->setCache(audioCache);
     _threadMutex.lock();
+    // without a source the player starts as a virtual voice
+    player->_alSource = findValidSource(player);
     _audioPlayers.emplace(++_currentAudioID, player);
     _threadMutex.unlock();
 
@@ -197,7 +272,16 @@ void AudioEngineImpl::_play2d(AudioCache *cache, AUDIO_ID audioID)
     //Note: It maybe in sub thread or main thread :(
     if (!*cache->_isDestroyed && cache->_state == AudioCache::State::READY)
     {
-        if (player->play2d()) {
+        bool started = true;
+        if (player->_alSource != AL_INVALID) {
+            started = player->play2d();
+        }
+        else {
+            // a virtual voice, its time advances from now on
+            player->_ready = true;
+        }
+
+        if (started) {
             _scheduler->performFunctionInCocosThread([audioID](){
 
                 if (AudioEngine::_audioIDInfoMap.find(audioID) != AudioEngine::_audioIDInfoMap.end()) {
@@ -213,7 +297,20 @@ void AudioEngineImpl::_play2d(AudioCache *cache, AUDIO_ID audioID)
     }
 }
 
-ALuint AudioEngineImpl::findValidSource()
+// The order in which the players get the sources: playing ones before paused ones, then by priority and
+// volume, the newest first so that a new sound takes the source of an old one like it.
+bool AudioEngineImpl::isMoreImportant(const AudioPlayer* a, const AudioPlayer* b)
+{
+    if (a->_paused != b->_paused)
+        return !a->_paused;
+    if (a->_priority != b->_priority)
+        return a->_priority > b->_priority;
+    if (a->_volume != b->_volume)
+        return a->_volume > b->_volume;
+    return a->_id > b->_id;
+}
+
+ALuint AudioEngineImpl::findValidSource(AudioPlayer* player)
 {
     ALuint sourceId = AL_INVALID;
     if (!_unusedSourcesPool.empty())
@@ -221,10 +318,121 @@ ALuint AudioEngineImpl::findValidSource()
         sourceId = _unusedSourcesPool.front();
         _unusedSourcesPool.pop();
     }
+    else
+    {
+        // take the source of the least important player if the new one is more important
+        AudioPlayer* leastImportant = nullptr;
+        for (auto&& other : _audioPlayers)
+        {
+            auto otherPlayer = other.second;
+            if (otherPlayer->_alSource != AL_INVALID && !otherPlayer->_removeByAudioEngine
+                && (leastImportant == nullptr || isMoreImportant(leastImportant, otherPlayer)))
+            {
+                leastImportant = otherPlayer;
+            }
+        }
+
+        if (leastImportant != nullptr && isMoreImportant(player, leastImportant))
+        {
+            sourceId = leastImportant->releaseSource();
+            ++_voiceStats.steals;
+        }
+    }
 
     return sourceId;
 }
 
+void AudioEngineImpl::updateVoices()
+{
+    _voices.clear();
+    size_t sourceCount = _unusedSourcesPool.size();
+    size_t waitingVoices = 0;
+    for (auto&& player : _audioPlayers)
+    {
+        auto voice = player.second;
+        if (voice->_removeByAudioEngine)
+            continue;
+
+        _voices.push_back(voice);
+        if (voice->_alSource != AL_INVALID)
+            ++sourceCount;
+        else if (!voice->_paused)
+            ++waitingVoices;
+    }
+
+    // every player which could use a source has one
+    if (waitingVoices == 0)
+        return;
+
+    if (_voices.size() > sourceCount)
+    {
+        std::nth_element(_voices.begin(), _voices.begin() + sourceCount, _voices.end(), isMoreImportant);
+
+        // the less important players give their sources to the more important virtual ones
+        for (size_t index = sourceCount; index < _voices.size(); ++index)
+        {
+            auto voice = _voices[index];
+            if (voice->_alSource != AL_INVALID)
+            {
+                _unusedSourcesPool.push(voice->releaseSource());
+                ++_voiceStats.steals;
+            }
+        }
+        _voices.resize(sourceCount);
+    }
+
+    for (auto&& voice : _voices)
+    {
+        if (voice->_alSource != AL_INVALID || voice->_paused || _unusedSourcesPool.empty())
+            continue;
+
+        voice->_alSource = _unusedSourcesPool.front();
+        _unusedSourcesPool.pop();
+        ++_voiceStats.revivals;
+
+        // the ones still loading start playing once their cache is ready
+        if (voice->_ready)
+        {
+            voice->play2d();
+        }
+    }
+}
+
+bool AudioEngineImpl::isVirtual(AUDIO_ID audioID)
+{
+    std::lock_guard<std::recursive_mutex> lck(_threadMutex);
+    auto iter = _audioPlayers.find(audioID);
+    return iter != _audioPlayers.end() && iter->second->_alSource == AL_INVALID;
+}
+
+bool AudioEngineImpl::renderOffline(short* buffer, int frames)
+{
+    if (s_alcRenderSamplesSOFT == nullptr || s_ALContext == nullptr)
+        return false;
+
+    AudioStreamer::getInstance()->pump();
+    s_alcRenderSamplesSOFT(s_ALDevice, buffer, frames);
+    return true;
+}
+
+AudioEngine::VoiceStats AudioEngineImpl::getVoiceStats()
+{
+    std::lock_guard<std::recursive_mutex> lck(_threadMutex);
+    auto stats = _voiceStats;
+    for (auto&& player : _audioPlayers)
+    {
+        if (player.second->_removeByAudioEngine)
+            continue;
+
+        ++stats.voices;
+        if (player.second->_alSource != AL_INVALID)
+            ++stats.realVoices;
+        else
+            ++stats.virtualVoices;
+    }
+    return stats;
+}
+
 void AudioEngineImpl::setVolume(AUDIO_ID audioID,float volume)
 {
     std::unique_lock<std::recursive_mutex> lck(_threadMutex);
@@ -237,7 +445,7 @@ void AudioEngineImpl::setVolume(AUDIO_ID audioID,float volume)
     
     player->_volume = volume;
 
-    if (player->_ready) {
+    if (player->_ready && player->_alSource != AL_INVALID) {
         alSourcef(player->_alSource, AL_GAIN, volume);
 
         auto error = alGetError();
@@ -258,10 +466,12 @@ void AudioEngineImpl::setLoop(AUDIO_ID audioID, bool loop)
 
     lck.unlock();
     
-    if (player->_ready) {
+    if (player->_ready && player->_alSource != AL_INVALID) {
         if (player->_streamingSource) {
             player->setLoop(loop);
         } else {
+            // kept for when the player becomes a virtual voice
+            player->_loop = loop;
             if (loop) {
                 alSourcei(player->_alSource, AL_LOOPING, AL_TRUE);
             } else {
@@ -291,6 +501,10 @@ bool AudioEngineImpl::pause(AUDIO_ID audioID)
     lck.unlock();
     
     bool ret = true;
+    player->_paused = true;
+    if (player->_alSource == AL_INVALID)
+        return ret;
+
     alSourcePause(player->_alSource);
 
     auto error = alGetError();
@@ -313,6 +527,11 @@ bool AudioEngineImpl::resume(AUDIO_ID audioID)
     auto player = iter->second;
     lck.unlock();
     
+    // a virtual voice gets a source with the next update if it is important enough
+    player->_paused = false;
+    if (player->_alSource == AL_INVALID)
+        return ret;
+
     alSourcePlay(player->_alSource);
 
     auto error = alGetError();
@@ -380,7 +599,7 @@ float AudioEngineImpl::getCurrentTime(AUDIO_ID audioID)
     float ret = 0.0f;
     auto player = it->second;
     if (player->_ready) {
-        if (player->_streamingSource) {
+        if (player->_streamingSource || player->_alSource == AL_INVALID) {
             ret = player->getTime();
         }
         else {
@@ -411,7 +630,7 @@ bool AudioEngineImpl::setCurrentTime(AUDIO_ID audioID, float time)
             break;
         }
 
-        if (player->_streamingSource) {
+        if (player->_streamingSource || player->_alSource == AL_INVALID) {
             ret = player->setTime(time);
             break;
         }
@@ -459,6 +678,7 @@ void AudioEngineImpl::_updateLocked(float dt)
     AUDIO_ID audioID;
     AudioPlayer* player;
     ALuint alSource;
+    bool playerRemoved = false;
 
 //    ALOGV("AudioPlayer count: %d", (int)_audioPlayers.size());
     for (auto it = _audioPlayers.begin(); it != _audioPlayers.end(); ) {
@@ -466,13 +686,23 @@ void AudioEngineImpl::_updateLocked(float dt)
         player = it->second;
         alSource = player->_alSource;
 
+        // virtual voices play silently
+        if (alSource == AL_INVALID && player->_ready && !player->_paused && player->_audioCache != nullptr) {
+            player->_currTime += dt;
+            if (player->_loop && player->_audioCache->_duration > 0) {
+                player->_currTime = std::fmod(player->_currTime, player->_audioCache->_duration);
+            }
+        }
+
         if (player->_removeByAudioEngine)
         {
             AudioEngine::remove(audioID);
             
             it = _audioPlayers.erase(it);
             delete player;
-            _unusedSourcesPool.push(alSource);
+            if (alSource != AL_INVALID)
+                _unusedSourcesPool.push(alSource);
+            playerRemoved = true;
         }
         else if (player->_ready && player->isFinished()) {
 
@@ -496,13 +726,23 @@ void AudioEngineImpl::_updateLocked(float dt)
             // clear cache when audio player finsihed properly
             player->setCache(nullptr);
             delete player;
-            _unusedSourcesPool.push(alSource);
+            if (alSource != AL_INVALID)
+                _unusedSourcesPool.push(alSource);
+            playerRemoved = true;
         }
         else{
             ++it;
         }
     }
 
+    // the sources of the removed players and of the less important ones go to the virtual voices
+    updateVoices();
+
+    // the caches of the removed players may be evicted now
+    if (playerRemoved) {
+        enforceCacheBudget();
+    }
+
     if(_audioPlayers.empty()) {
         _lazyInitLoop = true;
         _scheduler->unschedule(CC_SCHEDULE_SELECTOR(AudioEngineImpl::update), this);
@@ -517,6 +757,12 @@ void AudioEngineImpl::_updateLocked(float dt)
 void AudioEngineImpl::uncache(const std::string &filePath)
 {
     _audioCaches.erase(filePath);
+
+    auto compressed = _compressedCaches.find(filePath);
+    if (compressed != _compressedCaches.end()) {
+        _compressedCacheSize -= compressed->second.first->getSize();
+        _compressedCaches.erase(compressed);
+    }
 }
 
 void AudioEngineImpl::uncacheAll()
@@ -526,5 +772,92 @@ void AudioEngineImpl::uncacheAll()
         player.second->setCache(nullptr);
 
     _audioCaches.clear();
+    _compressedCaches.clear();
+    _compressedCacheSize = 0;
+}
+
+void AudioEngineImpl::enforceCacheBudget()
+{
+    const size_t budget = AudioEngine::_cacheBudget;
+    const size_t compressedBudget = AudioEngine::_compressedCacheBudget;
+
+    if (budget > 0)
+    {
+        size_t pcmBytes = 0;
+        for (auto& cache : _audioCaches)
+            pcmBytes += cache.second._pcmDataSize;
+
+        if (pcmBytes > budget)
+        {
+            std::unordered_set<AudioCache*> usedCaches;
+            {
+                std::lock_guard<std::recursive_mutex> lck(_threadMutex);
+                for (auto& player : _audioPlayers)
+                    usedCaches.insert(player.second->_audioCache);
+            }
+
+            // the loaded, fully decoded files nobody plays, and whose preload callbacks were invoked
+            std::vector<std::unordered_map<std::string, AudioCache>::iterator> candidates;
+            for (auto it = _audioCaches.begin(); it != _audioCaches.end(); ++it)
+            {
+                auto& cache = it->second;
+                if (cache._pcmDataSize > 0 && cache._isLoadingFinished && cache._loadCallbacks.empty()
+                    && usedCaches.find(&cache) == usedCaches.end())
+                {
+                    candidates.push_back(it);
+                }
+            }
+            std::sort(candidates.begin(), candidates.end(), [](const std::unordered_map<std::string, AudioCache>::iterator& a,
+                                                               const std::unordered_map<std::string, AudioCache>::iterator& b) {
+                return a->second._lastUsed < b->second._lastUsed;
+            });
+
+            for (auto& it : candidates)
+            {
+                if (pcmBytes <= budget)
+                    break;
+
+                auto& cache = it->second;
+                pcmBytes -= cache._pcmDataSize;
+                if (compressedBudget > 0 && cache._compressedData != nullptr)
+                {
+                    _compressedCacheSize += cache._compressedData->getSize();
+                    _compressedCaches[it->first] = std::make_pair(std::move(cache._compressedData), cache._lastUsed);
+                }
+                ALOGV("Evicting %s, %u bytes", it->first.c_str(), cache._pcmDataSize);
+                _audioCaches.erase(it);
+                ++_cacheStats.evictions;
+            }
+        }
+    }
+
+    if (compressedBudget == 0)
+    {
+        _compressedCaches.clear();
+        _compressedCacheSize = 0;
+    }
+    while (_compressedCacheSize > compressedBudget)
+    {
+        auto oldest = std::min_element(_compressedCaches.begin(), _compressedCaches.end(),
+                                       [](const decltype(_compressedCaches)::value_type& a, const decltype(_compressedCaches)::value_type& b) {
+            return a.second.second < b.second.second;
+        });
+        _compressedCacheSize -= oldest->second.first->getSize();
+        _compressedCaches.erase(oldest);
+    }
+}
+
+AudioEngine::CacheStats AudioEngineImpl::getCacheStats() const
+{
+    auto stats = _cacheStats;
+    for (auto& cache : _audioCaches)
+        stats.pcmBytes += cache.second._pcmDataSize;
+    stats.compressedBytes = _compressedCacheSize;
+    return stats;
+}
+
+void AudioEngineImpl::resetCacheStats()
+{
+    _cacheStats = AudioEngine::CacheStats();
 }
 
@@ -33,6 +33,7 @@
 #include "platform/CCFileUtils.h"
 #include "audio/include/AudioDecoderManager.h"
 #include "audio/include/AudioDecoder.h"
+#include "audio/include/AudioStreamer.h"
 
 #define VERY_VERY_VERBOSE_LOGGING
 #ifdef VERY_VERY_VERBOSE_LOGGING
@@ -55,9 +56,9 @@ AudioPlayer::AudioPlayer()
 , _ready(false)
 , _currTime(0.0f)
 , _streamingSource(false)
-, _rotateBufferThread(nullptr)
-, _timeDirty(false)
-, _isRotateThreadExited(false)
+, _streamFinished(false)
+, _priority(0)
+, _paused(false)
 , _id(++__idIndex)
 {
     memset(_bufferIds, 0, sizeof(_bufferIds));
@@ -102,29 +103,18 @@ void AudioPlayer::destroy()
 
         if (_streamingSource)
         {
-            if (_rotateBufferThread != nullptr)
-            {
-                while (!_isRotateThreadExited)
-                {
-                    _sleepCondition.notify_one();
-                    std::this_thread::sleep_for(std::chrono::milliseconds(5));
-                }
-
-                if (_rotateBufferThread->joinable()) {
-                    _rotateBufferThread->join();
-                }
-
-                delete _rotateBufferThread;
-                _rotateBufferThread = nullptr;
-                ALOGVV("rotateBufferThread exited!");
-            }
+            AudioStreamer::getInstance()->removeStream(this);
+            ALOGVV("stream removed!");
         }
     } while(false);
 
-    ALOGVV("Before alSourceStop");
-    alSourceStop(_alSource); CHECK_AL_ERROR_DEBUG();
-    ALOGVV("Before alSourcei");
-    alSourcei(_alSource, AL_BUFFER, 0); CHECK_AL_ERROR_DEBUG();
+    if (_alSource != AL_INVALID)
+    {
+        ALOGVV("Before alSourceStop");
+        alSourceStop(_alSource); CHECK_AL_ERROR_DEBUG();
+        ALOGVV("Before alSourcei");
+        alSourcei(_alSource, AL_BUFFER, 0); CHECK_AL_ERROR_DEBUG();
+    }
 
     _removeByAudioEngine = true;
 
@@ -157,6 +147,10 @@ bool AudioPlayer::play2d()
             break;
         }
 
+        // a virtual voice taking back a source goes on where it is
+        _streamFinished = false;
+        bool resumeStream = false;
+
         alSourcei(_alSource, AL_BUFFER, 0);CHECK_AL_ERROR_DEBUG();
         alSourcef(_alSource, AL_PITCH, 1.0f);CHECK_AL_ERROR_DEBUG();
         alSourcef(_alSource, AL_GAIN, _volume);CHECK_AL_ERROR_DEBUG();
@@ -190,41 +184,50 @@ bool AudioPlayer::play2d()
             _streamingSource = true;
         }
 
+        if (_streamingSource)
         {
-            std::unique_lock<std::mutex> lk(_sleepMutex);
-            if (_isDestroyed)
-                break;
-
-            if (_streamingSource)
-            {
-                // To continuously stream audio from a source without interruption, buffer queuing is required.
-                alSourceQueueBuffers(_alSource, QUEUEBUFFER_NUM, _bufferIds);
-                CHECK_AL_ERROR_DEBUG();
-                _rotateBufferThread = new std::thread(&AudioPlayer::rotateBufferThread, this, _audioCache->_queBufferFrames * QUEUEBUFFER_NUM + 1);
-            }
-            else
+            // To continuously stream audio from a source without interruption, buffer queuing is required.
+            alSourceQueueBuffers(_alSource, QUEUEBUFFER_NUM, _bufferIds);
+            CHECK_AL_ERROR_DEBUG();
+        }
+        else
+        {
+            alSourcei(_alSource, AL_BUFFER, _audioCache->_alBufferId);
+            CHECK_AL_ERROR_DEBUG();
+            if (_currTime > 0)
             {
-                alSourcei(_alSource, AL_BUFFER, _audioCache->_alBufferId);
+                alSourcef(_alSource, AL_SEC_OFFSET, _currTime);
                 CHECK_AL_ERROR_DEBUG();
             }
-
-            alSourcePlay(_alSource);
         }
 
-        auto alError = alGetError();
-        if (alError != AL_NO_ERROR)
+        // the streaming thread starts the source once it queued the buffers at _currTime
+        resumeStream = _streamingSource && _currTime > 0;
+        if (!resumeStream)
         {
-            ALOGE("%s:alSourcePlay error code:%x", __FUNCTION__,alError);
-            break;
+            alSourcePlay(_alSource);
+
+            auto alError = alGetError();
+            if (alError != AL_NO_ERROR)
+            {
+                ALOGE("%s:alSourcePlay error code:%x", __FUNCTION__,alError);
+                break;
+            }
+
+            ALint state;
+            alGetSourcei(_alSource, AL_SOURCE_STATE, &state);
+            if (state != AL_PLAYING)
+            {
+                ALOGE("state isn't playing, %d, %s, cache id=%u, player id=%u", state, _audioCache->_fileFullPath.c_str(), _audioCache->_id, _id);
+            }
+            assert(state == AL_PLAYING);
         }
 
-        ALint state;
-        alGetSourcei(_alSource, AL_SOURCE_STATE, &state);
-        if (state != AL_PLAYING)
+        if (_streamingSource)
         {
-            ALOGE("state isn't playing, %d, %s, cache id=%u, player id=%u", state, _audioCache->_fileFullPath.c_str(), _audioCache->_id, _id);
+            // the shared streaming threads refill the queued buffers from now on
+            AudioStreamer::getInstance()->addStream(this, resumeStream ? _currTime : 0);
         }
-        assert(state == AL_PLAYING);
         _ready = true;
         ret = true;
     } while (false);
@@ -237,117 +240,53 @@ bool AudioPlayer::play2d()
     return ret;
 }
 
-void AudioPlayer::rotateBufferThread(int offsetFrame)
+ALuint AudioPlayer::releaseSource()
 {
-    char* tmpBuffer = nullptr;
-    auto& fullPath = _audioCache->_fileFullPath;
-    AudioDecoder* decoder = AudioDecoderManager::createDecoder(fullPath);
-    long long rotateSleepTime = static_cast<long long>(QUEUEBUFFER_TIME_STEP * 1000) / 2;
-    do
-    {
-        BREAK_IF(decoder == nullptr || !decoder->open(fullPath));
-
-        uint32_t framesRead = 0;
-        const uint32_t framesToRead = _audioCache->_queBufferFrames;
-        const uint32_t bufferSize = decoder->framesToBytes(framesToRead);
-        const auto sourceFormat = decoder->getSourceFormat();
-        tmpBuffer = (char*)malloc(bufferSize);
-        memset(tmpBuffer, 0, bufferSize);
+    std::unique_lock<std::mutex> lck(_play2dMutex);
+    ALuint source = _alSource;
+    if (source == AL_INVALID)
+        return source;
 
-        if (offsetFrame != 0) {
-            decoder->seek(offsetFrame);
+    if (_ready)
+    {
+        // a source which played to the end makes a finished virtual voice, not one starting over
+        bool finished = isFinished();
+        if (_streamingSource)
+        {
+            // _currTime stays where the streaming thread last saw the source
+            AudioStreamer::getInstance()->removeStream(this);
         }
-
-        ALint sourceState;
-        ALint bufferProcessed = 0;
-        bool needToExitThread = false;
-
-        while (!_isDestroyed) {
-            alGetSourcei(_alSource, AL_SOURCE_STATE, &sourceState);
-            if (sourceState == AL_PLAYING) {
-                alGetSourcei(_alSource, AL_BUFFERS_PROCESSED, &bufferProcessed);
-                while (bufferProcessed > 0) {
-                    bufferProcessed--;
-                    if (_timeDirty) {
-                        _timeDirty = false;
-                        offsetFrame = _currTime * decoder->getSampleRate();
-                        decoder->seek(offsetFrame);
-                    }
-                    else {
-                        _currTime += QUEUEBUFFER_TIME_STEP;
-                        if (_currTime > _audioCache->_duration) {
-                            if (_loop) {
-                                _currTime = 0.0f;
-                            } else {
-                                _currTime = _audioCache->_duration;
-                            }
-                        }
-                    }
-
-                    framesRead = decoder->readFixedFrames(framesToRead, tmpBuffer);
-
-                    if (framesRead == 0) {
-                        if (_loop) {
-                            decoder->seek(0);
-                            framesRead = decoder->readFixedFrames(framesToRead, tmpBuffer);
-                        } else {
-                            needToExitThread = true;
-                            break;
-                        }
-                    }
-
-                    ALuint bid;
-                    alSourceUnqueueBuffers(_alSource, 1, &bid);
-                    if (sourceFormat == AUDIO_SOURCE_FORMAT::ADPCM || sourceFormat == AUDIO_SOURCE_FORMAT::IMA_ADPCM)
-                        alBufferi(bid, AL_UNPACK_BLOCK_ALIGNMENT_SOFT, decoder->getSamplesPerBlock());
-                    alBufferData(bid, _audioCache->_format, tmpBuffer, decoder->framesToBytes(framesRead), decoder->getSampleRate());
-                    alSourceQueueBuffers(_alSource, 1, &bid);
-                }
-            }
-            /* Make sure the source hasn't underrun */
-            else if (sourceState != AL_PAUSED)
-            {
-                ALint queued;
-
-                /* If no buffers are queued, playback is finished */
-                alGetSourcei(_alSource, AL_BUFFERS_QUEUED, &queued);
-                if (queued == 0) {
-                    needToExitThread = true;
-                }
-                else {
-                    alSourcePlay(_alSource);
-                    if (alGetError() != AL_NO_ERROR)
-                    {
-                        ALOGE("Error restarting playback!");
-                        needToExitThread = true;
-                    }
-                }
-            }
-
-            std::unique_lock<std::mutex> lk(_sleepMutex);
-            if (_isDestroyed || needToExitThread) {
-                break;
-            }
-
-            _sleepCondition.wait_for(lk,std::chrono::milliseconds(rotateSleepTime));
+        else
+        {
+            alGetSourcef(source, AL_SEC_OFFSET, &_currTime); CHECK_AL_ERROR_DEBUG();
         }
+        if (finished && _audioCache != nullptr)
+        {
+            _currTime = _audioCache->_duration;
+        }
+        alSourceStop(source); CHECK_AL_ERROR_DEBUG();
+        alSourcei(source, AL_BUFFER, 0); CHECK_AL_ERROR_DEBUG();
 
-    } while(false);
-
-    ALOGV("Exit rotate buffer thread ...");
-    if (decoder != nullptr)
-    {
-        decoder->close();
+        if (_streamingSource)
+        {
+            alDeleteBuffers(QUEUEBUFFER_NUM, _bufferIds);
+            memset(_bufferIds, 0, sizeof(_bufferIds));
+            _streamingSource = false;
+        }
     }
-    AudioDecoderManager::destroyDecoder(decoder);
-    free(tmpBuffer);
-    _isRotateThreadExited = true;
-    ALOGV("%s exited.\n", __FUNCTION__);
+
+    _alSource = AL_INVALID;
+    return source;
 }
 
 bool AudioPlayer::isFinished() const
 {
-    if(_streamingSource) return _isRotateThreadExited;
+    if (_alSource == AL_INVALID)
+    {
+        // a virtual voice, its time is advanced by AudioEngineImpl
+        return _audioCache == nullptr || (!_loop && _currTime >= _audioCache->_duration);
+    }
+    if(_streamingSource) return _streamFinished;
     else {
         ALint sourceState;
         alGetSourcei(_alSource, AL_SOURCE_STATE, &sourceState);
@@ -370,7 +309,10 @@ bool AudioPlayer::setTime(float time)
     if (!_isDestroyed && time >= 0.0f && time < _audioCache->_duration) {
 
         _currTime = time;
-        _timeDirty = true;
+        if (_streamingSource)
+        {
+            AudioStreamer::getInstance()->seekStream(this, time);
+        }
 
         return true;
     }
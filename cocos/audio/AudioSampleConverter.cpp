@@ -0,0 +1,326 @@
+/****************************************************************************
+Copyright (c) 2020 c4games.com.
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#include "audio/include/AudioSampleConverter.h"
+#include <math.h>
+#include <string.h>
+#include <atomic>
+
+// The kernels are picked at compile time like the pixel format converters.
+#if defined (__SSE2__) || defined (_M_X64) || (defined (_M_IX86_FP) && _M_IX86_FP >= 2)
+#define USE_AUDIO_SSE2
+#include <emmintrin.h>
+#elif defined (__ARM_NEON) || defined (__ARM_NEON__)
+#define USE_AUDIO_NEON
+#include <arm_neon.h>
+#endif
+
+#if defined (USE_AUDIO_SSE2) || defined (USE_AUDIO_NEON)
+#define USE_AUDIO_SIMD
+#endif
+
+namespace cocos2d {
+
+namespace AudioSampleConverter {
+
+    enum ChannelRole { L, R, C, LFE, SL, SR, SC };
+
+    // Indexed by channel count - 3.
+    static const ChannelRole WAVE_LAYOUTS[][8] = {
+        { L, R, C },
+        { L, R, SL, SR },
+        { L, R, C, SL, SR },
+        { L, R, C, LFE, SL, SR },
+        { L, R, C, LFE, SC, SL, SR },
+        { L, R, C, LFE, SL, SR, SL, SR },
+    };
+
+    static const ChannelRole VORBIS_LAYOUTS[][8] = {
+        { L, C, R },
+        { L, R, SL, SR },
+        { L, C, R, SL, SR },
+        { L, C, R, SL, SR, LFE },
+        { L, C, R, SL, SR, SC, LFE },
+        { L, C, R, SL, SR, SL, SR, LFE },
+    };
+
+    static const float ROLE_WEIGHTS[][2] = {
+        { 1.0f, 0.0f },         // L
+        { 0.0f, 1.0f },         // R
+        { 0.7071f, 0.7071f },   // C
+        { 0.0f, 0.0f },         // LFE
+        { 0.7071f, 0.0f },      // SL
+        { 0.0f, 0.7071f },      // SR
+        { 0.5f, 0.5f },         // SC
+    };
+
+    static const uint32_t MIN_DOWNMIX_CHANNELS = 3;
+    static const uint32_t MAX_DOWNMIX_CHANNELS = 8;
+
+    static std::atomic<bool> s_simdEnabled(true);
+
+    void setSIMDEnabled(bool enabled)
+    {
+        s_simdEnabled = enabled;
+    }
+
+    bool isSIMDEnabled()
+    {
+#ifdef USE_AUDIO_SIMD
+        return s_simdEnabled;
+#else
+        return false;
+#endif
+    }
+
+    const char* getSIMDName()
+    {
+#if defined (USE_AUDIO_SSE2)
+        return "SSE2";
+#elif defined (USE_AUDIO_NEON)
+        return "NEON";
+#else
+        return "none";
+#endif
+    }
+
+    static inline int16_t floatToS16(float value)
+    {
+        value *= 32768.0f;
+        // Written so that NaN ends up at the minimum like with the SIMD max instructions.
+        value = value > -32768.0f ? value : -32768.0f;
+        value = value < 32767.0f ? value : 32767.0f;
+        return static_cast<int16_t>(lrintf(value));
+    }
+
+    void s24ToS16(const uint8_t* src, int16_t* dst, size_t samples)
+    {
+        size_t i = 0;
+#if defined (USE_AUDIO_SSE2)
+        if (s_simdEnabled)
+        {
+            // 8 samples per step from two 16 bytes loads of 12 bytes each, the second one reads 4 bytes past the 24 used.
+            for (; i + 10 <= samples; i += 8)
+            {
+                const uint8_t* p = src + i * 3;
+                __m128i a = _mm_loadu_si128((const __m128i*)p);
+                __m128i b = _mm_loadu_si128((const __m128i*)(p + 12));
+                // One sample in each 32 bits lane, then its upper 16 bits sign extended.
+                __m128i la = _mm_unpacklo_epi64(_mm_unpacklo_epi32(a, _mm_srli_si128(a, 3)),
+                                                _mm_unpacklo_epi32(_mm_srli_si128(a, 6), _mm_srli_si128(a, 9)));
+                __m128i lb = _mm_unpacklo_epi64(_mm_unpacklo_epi32(b, _mm_srli_si128(b, 3)),
+                                                _mm_unpacklo_epi32(_mm_srli_si128(b, 6), _mm_srli_si128(b, 9)));
+                la = _mm_srai_epi32(_mm_slli_epi32(la, 8), 16);
+                lb = _mm_srai_epi32(_mm_slli_epi32(lb, 8), 16);
+                _mm_storeu_si128((__m128i*)(dst + i), _mm_packs_epi32(la, lb));
+            }
+        }
+#elif defined (USE_AUDIO_NEON)
+        if (s_simdEnabled)
+        {
+            for (; i + 16 <= samples; i += 16)
+            {
+                uint8x16x3_t bytes = vld3q_u8(src + i * 3);
+                // The low byte is dropped, the middle and high ones make the 16 bits sample.
+                uint8x16x2_t words = vzipq_u8(bytes.val[1], bytes.val[2]);
+                vst1q_s16(dst + i, vreinterpretq_s16_u8(words.val[0]));
+                vst1q_s16(dst + i + 8, vreinterpretq_s16_u8(words.val[1]));
+            }
+        }
+#endif
+        for (; i < samples; ++i)
+        {
+            const uint8_t* p = src + i * 3;
+            dst[i] = static_cast<int16_t>(p[1] | (p[2] << 8));
+        }
+    }
+
+    void s32ToS16(const int32_t* src, int16_t* dst, size_t samples)
+    {
+        size_t i = 0;
+#if defined (USE_AUDIO_SSE2)
+        if (s_simdEnabled)
+        {
+            for (; i + 8 <= samples; i += 8)
+            {
+                __m128i a = _mm_srai_epi32(_mm_loadu_si128((const __m128i*)(src + i)), 16);
+                __m128i b = _mm_srai_epi32(_mm_loadu_si128((const __m128i*)(src + i + 4)), 16);
+                _mm_storeu_si128((__m128i*)(dst + i), _mm_packs_epi32(a, b));
+            }
+        }
+#elif defined (USE_AUDIO_NEON)
+        if (s_simdEnabled)
+        {
+            for (; i + 8 <= samples; i += 8)
+            {
+                int16x4_t a = vshrn_n_s32(vld1q_s32(src + i), 16);
+                int16x4_t b = vshrn_n_s32(vld1q_s32(src + i + 4), 16);
+                vst1q_s16(dst + i, vcombine_s16(a, b));
+            }
+        }
+#endif
+        for (; i < samples; ++i)
+        {
+            dst[i] = static_cast<int16_t>(src[i] >> 16);
+        }
+    }
+
+    void f32ToS16(const float* src, int16_t* dst, size_t samples)
+    {
+        size_t i = 0;
+#if defined (USE_AUDIO_SSE2)
+        if (s_simdEnabled)
+        {
+            const __m128 scale = _mm_set1_ps(32768.0f);
+            const __m128 minValue = _mm_set1_ps(-32768.0f);
+            const __m128 maxValue = _mm_set1_ps(32767.0f);
+            for (; i + 8 <= samples; i += 8)
+            {
+                // _mm_max_ps returns its second operand for NaN, cvtps rounds to nearest even like lrintf.
+                __m128 a = _mm_mul_ps(_mm_loadu_ps(src + i), scale);
+                __m128 b = _mm_mul_ps(_mm_loadu_ps(src + i + 4), scale);
+                a = _mm_min_ps(_mm_max_ps(a, minValue), maxValue);
+                b = _mm_min_ps(_mm_max_ps(b, minValue), maxValue);
+                _mm_storeu_si128((__m128i*)(dst + i), _mm_packs_epi32(_mm_cvtps_epi32(a), _mm_cvtps_epi32(b)));
+            }
+        }
+#elif defined (USE_AUDIO_NEON) && defined (__aarch64__)
+        if (s_simdEnabled)
+        {
+            const float32x4_t minValue = vdupq_n_f32(-32768.0f);
+            const float32x4_t maxValue = vdupq_n_f32(32767.0f);
+            for (; i + 8 <= samples; i += 8)
+            {
+                // vmaxnm returns the number for NaN, vcvtn rounds to nearest even, ARMv7 has neither and uses the scalar code.
+                float32x4_t a = vmulq_n_f32(vld1q_f32(src + i), 32768.0f);
+                float32x4_t b = vmulq_n_f32(vld1q_f32(src + i + 4), 32768.0f);
+                a = vminq_f32(vmaxnmq_f32(a, minValue), maxValue);
+                b = vminq_f32(vmaxnmq_f32(b, minValue), maxValue);
+                vst1q_s16(dst + i, vcombine_s16(vmovn_s32(vcvtnq_s32_f32(a)), vmovn_s32(vcvtnq_s32_f32(b))));
+            }
+        }
+#endif
+        for (; i < samples; ++i)
+        {
+            dst[i] = floatToS16(src[i]);
+        }
+    }
+
+    void f64ToS16(const double* src, int16_t* dst, size_t samples)
+    {
+        for (size_t i = 0; i < samples; ++i)
+        {
+            dst[i] = floatToS16(static_cast<float>(src[i]));
+        }
+    }
+
+    bool canDownmix(uint32_t channels)
+    {
+        return channels >= MIN_DOWNMIX_CHANNELS && channels <= MAX_DOWNMIX_CHANNELS;
+    }
+
+    // Q15 weights of each channel for the left and the right output, zero for the lanes past the channel count.
+    static void getDownmixWeights(uint32_t channels, ChannelOrder order, int16_t left[8], int16_t right[8])
+    {
+        auto layout = (order == ChannelOrder::VORBIS ? VORBIS_LAYOUTS : WAVE_LAYOUTS)[channels - MIN_DOWNMIX_CHANNELS];
+
+        float sum = 0;
+        for (uint32_t c = 0; c < channels; ++c)
+            sum += ROLE_WEIGHTS[layout[c]][0];
+
+        for (uint32_t c = 0; c < MAX_DOWNMIX_CHANNELS; ++c)
+        {
+            left[c] = c < channels ? static_cast<int16_t>(ROLE_WEIGHTS[layout[c]][0] / sum * 32767.0f + 0.5f) : 0;
+            right[c] = c < channels ? static_cast<int16_t>(ROLE_WEIGHTS[layout[c]][1] / sum * 32767.0f + 0.5f) : 0;
+        }
+    }
+
+    static inline int16_t mixToS16(int32_t sum)
+    {
+        sum = (sum + (1 << 14)) >> 15;
+        return static_cast<int16_t>(sum < -32768 ? -32768 : (sum > 32767 ? 32767 : sum));
+    }
+
+    void downmixToStereo(const int16_t* src, int16_t* dst, size_t frames, uint32_t channels, ChannelOrder order)
+    {
+        if (!canDownmix(channels))
+            return;
+
+        int16_t left[8], right[8];
+        getDownmixWeights(channels, order, left, right);
+
+        size_t f = 0;
+#if defined (USE_AUDIO_SSE2)
+        if (s_simdEnabled)
+        {
+            // One frame per step, its channels loaded in a single vector, stops while 8 samples can still be read.
+            const __m128i wl = _mm_loadu_si128((const __m128i*)left);
+            const __m128i wr = _mm_loadu_si128((const __m128i*)right);
+            const __m128i rounding = _mm_set1_epi32(1 << 14);
+            for (; (frames - f) * channels >= 8; ++f)
+            {
+                __m128i v = _mm_loadu_si128((const __m128i*)(src + f * channels));
+                __m128i ml = _mm_madd_epi16(v, wl);
+                __m128i mr = _mm_madd_epi16(v, wr);
+                // L0 R0 L1 R1 + L2 R2 L3 R3, then the two halves.
+                __m128i s = _mm_add_epi32(_mm_unpacklo_epi32(ml, mr), _mm_unpackhi_epi32(ml, mr));
+                s = _mm_add_epi32(s, _mm_srli_si128(s, 8));
+                s = _mm_srai_epi32(_mm_add_epi32(s, rounding), 15);
+                int32_t lr = _mm_cvtsi128_si32(_mm_packs_epi32(s, s));
+                memcpy(dst + f * 2, &lr, sizeof(lr));
+            }
+        }
+#elif defined (USE_AUDIO_NEON)
+        if (s_simdEnabled)
+        {
+            const int16x8_t wl = vld1q_s16(left);
+            const int16x8_t wr = vld1q_s16(right);
+            for (; (frames - f) * channels >= 8; ++f)
+            {
+                int16x8_t v = vld1q_s16(src + f * channels);
+                int32x4_t ml = vmlal_s16(vmull_s16(vget_low_s16(v), vget_low_s16(wl)), vget_high_s16(v), vget_high_s16(wl));
+                int32x4_t mr = vmlal_s16(vmull_s16(vget_low_s16(v), vget_low_s16(wr)), vget_high_s16(v), vget_high_s16(wr));
+                int32x2_t s = vpadd_s32(vpadd_s32(vget_low_s32(ml), vget_high_s32(ml)), vpadd_s32(vget_low_s32(mr), vget_high_s32(mr)));
+                // Rounding, saturating narrow: the same as mixToS16.
+                int16x4_t lr = vqrshrn_n_s32(vcombine_s32(s, s), 15);
+                vst1_lane_s32((int32_t*)(dst + f * 2), vreinterpret_s32_s16(lr), 0);
+            }
+        }
+#endif
+        for (; f < frames; ++f)
+        {
+            const int16_t* frame = src + f * channels;
+            int32_t l = 0, r = 0;
+            for (uint32_t c = 0; c < channels; ++c)
+            {
+                l += frame[c] * left[c];
+                r += frame[c] * right[c];
+            }
+            dst[f * 2] = mixToS16(l);
+            dst[f * 2 + 1] = mixToS16(r);
+        }
+    }
+}
+
+} // namespace cocos2d
@@ -0,0 +1,549 @@
+/****************************************************************************
+Copyright (c) 2020 c4games.com.
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#define LOG_TAG "AudioStreamer"
+
+#include "audio/include/AudioStreamer.h"
+#include "audio/include/AudioPlayer.h"
+#include "audio/include/AudioCache.h"
+#include "audio/include/AudioDecoder.h"
+#include "audio/include/AudioDecoderManager.h"
+#include "base/CCFrameProfiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <future>
+#include <string>
+
+// the longest a thread sleeps, paused sources are checked this often
+#define STREAMING_MAX_SLEEP QUEUEBUFFER_TIME_STEP
+// how long after a buffer is played a thread wakes up to refill it
+#define STREAMING_MIN_SLEEP 0.002f
+
+NS_CC_BEGIN
+
+struct AudioStreamer::Stream
+{
+    AudioPlayer* player = nullptr;
+    ALuint source = 0;
+    AudioDecoder* decoder = nullptr;
+
+    // copied from the AudioCache, which may be uncached while the stream plays
+    std::string path;
+    ALenum format = 0;
+    uint32_t sampleRate = 0;
+    uint32_t framesPerBuffer = 0;
+    uint32_t totalFrames = 0;
+    float duration = 0;
+
+    std::vector<char> buffer;
+    uint32_t nextFrame = 0; // the first frame of the next buffer to decode
+    float startTime = 0;    // where the thread starts the source, 0 when AudioPlayer::play2d() did
+    bool ended = false;     // decoded to the end without looping, the queued buffers play out
+    // first frame and frame count of every queued buffer, the one being played first
+    std::deque<std::pair<uint32_t, uint32_t>> queued;
+};
+
+struct AudioStreamer::Command
+{
+    enum class Type
+    {
+        ADD,
+        SEEK,
+        REMOVE,
+    };
+
+    Type type = Type::ADD;
+    AudioPlayer* player = nullptr;
+    std::unique_ptr<Stream> stream;              // ADD
+    float time = 0;                              // SEEK
+    std::shared_ptr<std::promise<void>> removed; // REMOVE
+};
+
+struct AudioStreamer::Worker
+{
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::deque<Command> commands;
+    bool stop = false;
+
+    // the streams added to this thread and not removed yet, for balancing the threads, guarded by _streamWorkersMutex
+    int streamCount = 0;
+    // only used by the thread
+    std::vector<std::unique_ptr<Stream>> streams;
+};
+
+AudioStreamer* AudioStreamer::s_audioStreamer = nullptr;
+
+AudioStreamer* AudioStreamer::getInstance()
+{
+    if (s_audioStreamer == nullptr)
+    {
+        s_audioStreamer = new (std::nothrow) AudioStreamer();
+    }
+    return s_audioStreamer;
+}
+
+AudioStreamer* AudioStreamer::createInstance(int threads)
+{
+    if (s_audioStreamer == nullptr)
+    {
+        s_audioStreamer = new (std::nothrow) AudioStreamer(threads);
+    }
+    return s_audioStreamer;
+}
+
+void AudioStreamer::destroyInstance()
+{
+    delete s_audioStreamer;
+    s_audioStreamer = nullptr;
+}
+
+AudioStreamer::AudioStreamer(int threads)
+: _manual(threads <= 0)
+, _wakeups(0)
+, _buffersQueued(0)
+, _framesDecoded(0)
+, _underruns(0)
+, _busyMicroseconds(0)
+{
+    for (int index = 0; index < std::max(threads, 1); ++index)
+    {
+        _workers.emplace_back(new Worker());
+        auto worker = _workers.back().get();
+        if (!_manual)
+            worker->thread = std::thread(&AudioStreamer::threadFunc, this, worker);
+    }
+}
+
+AudioStreamer::~AudioStreamer()
+{
+    for (auto& worker : _workers)
+    {
+        {
+            std::lock_guard<std::mutex> lk(worker->mutex);
+            worker->stop = true;
+        }
+        worker->condition.notify_one();
+        if (worker->thread.joinable())
+            worker->thread.join();
+
+        for (auto& stream : worker->streams)
+        {
+            closeStream(stream.get());
+        }
+    }
+}
+
+void AudioStreamer::addStream(AudioPlayer* player, float time)
+{
+    auto cache = player->_audioCache;
+    std::unique_ptr<Stream> stream(new Stream());
+    stream->player = player;
+    stream->source = player->_alSource;
+    stream->path = cache->_fileFullPath;
+    stream->format = cache->_format;
+    stream->sampleRate = cache->_sampleRate;
+    stream->framesPerBuffer = cache->_queBufferFrames;
+    stream->totalFrames = cache->_totalFrames;
+    stream->duration = cache->_duration;
+    stream->startTime = time;
+
+    // AudioPlayer::play2d() queued the first buffers, which AudioCache decoded while loading
+    for (int index = 0; index < QUEUEBUFFER_NUM; ++index)
+    {
+        stream->queued.emplace_back(index * stream->framesPerBuffer, stream->framesPerBuffer);
+    }
+    stream->nextFrame = QUEUEBUFFER_NUM * stream->framesPerBuffer;
+
+    Worker* worker = nullptr;
+    {
+        std::lock_guard<std::mutex> lk(_streamWorkersMutex);
+        for (auto& candidate : _workers)
+        {
+            if (worker == nullptr || candidate->streamCount < worker->streamCount)
+                worker = candidate.get();
+        }
+        ++worker->streamCount;
+        _streamWorkers[player] = worker;
+    }
+
+    Command command;
+    command.type = Command::Type::ADD;
+    command.player = player;
+    command.stream = std::move(stream);
+    {
+        std::lock_guard<std::mutex> lk(worker->mutex);
+        worker->commands.push_back(std::move(command));
+    }
+    worker->condition.notify_one();
+}
+
+void AudioStreamer::seekStream(AudioPlayer* player, float time)
+{
+    Command command;
+    command.type = Command::Type::SEEK;
+    command.player = player;
+    command.time = time;
+    postCommand(player, std::move(command));
+}
+
+void AudioStreamer::removeStream(AudioPlayer* player)
+{
+    Worker* worker = nullptr;
+    {
+        std::lock_guard<std::mutex> lk(_streamWorkersMutex);
+        auto it = _streamWorkers.find(player);
+        if (it == _streamWorkers.end())
+            return;
+        worker = it->second;
+        --worker->streamCount;
+        _streamWorkers.erase(it);
+    }
+
+    Command command;
+    command.type = Command::Type::REMOVE;
+    command.player = player;
+    command.removed = std::make_shared<std::promise<void>>();
+    auto removed = command.removed->get_future();
+    {
+        std::lock_guard<std::mutex> lk(worker->mutex);
+        worker->commands.push_back(std::move(command));
+    }
+    worker->condition.notify_one();
+
+    if (_manual)
+    {
+        std::lock_guard<std::mutex> pumpLock(_pumpMutex);
+        std::deque<Command> commands;
+        {
+            std::lock_guard<std::mutex> lk(worker->mutex);
+            commands.swap(worker->commands);
+        }
+        float nextRefill = 0;
+        process(worker, commands, nextRefill, true);
+    }
+
+    // the player is destroyed after this, its thread mustn't touch it anymore
+    removed.wait();
+}
+
+void AudioStreamer::postCommand(AudioPlayer* player, Command&& command)
+{
+    Worker* worker = nullptr;
+    {
+        std::lock_guard<std::mutex> lk(_streamWorkersMutex);
+        auto it = _streamWorkers.find(player);
+        if (it == _streamWorkers.end())
+            return;
+        worker = it->second;
+    }
+
+    {
+        std::lock_guard<std::mutex> lk(worker->mutex);
+        worker->commands.push_back(std::move(command));
+    }
+    worker->condition.notify_one();
+}
+
+AudioStreamer::Stats AudioStreamer::getStats() const
+{
+    Stats stats;
+    {
+        std::lock_guard<std::mutex> lk(_streamWorkersMutex);
+        stats.streams = static_cast<int>(_streamWorkers.size());
+    }
+    stats.wakeups = _wakeups;
+    stats.buffersQueued = _buffersQueued;
+    stats.framesDecoded = _framesDecoded;
+    stats.underruns = _underruns;
+    stats.busyTime = _busyMicroseconds / 1000000.0;
+    return stats;
+}
+
+void AudioStreamer::resetStats()
+{
+    _wakeups = 0;
+    _buffersQueued = 0;
+    _framesDecoded = 0;
+    _underruns = 0;
+    _busyMicroseconds = 0;
+}
+
+void AudioStreamer::threadFunc(Worker* worker)
+{
+    CC_PROFILE_THREAD("AudioStreamer");
+    std::deque<Command> commands;
+    float nextRefill = STREAMING_MAX_SLEEP;
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lk(worker->mutex);
+            worker->condition.wait_for(lk, std::chrono::microseconds(static_cast<int64_t>(nextRefill * 1000000)),
+                                       [worker]{ return worker->stop || !worker->commands.empty(); });
+            if (worker->stop)
+                break;
+            commands.swap(worker->commands);
+        }
+
+        process(worker, commands, nextRefill, false);
+    }
+}
+
+void AudioStreamer::pump()
+{
+    if (!_manual)
+        return;
+
+    std::lock_guard<std::mutex> pumpLock(_pumpMutex);
+    auto worker = _workers.front().get();
+    std::deque<Command> commands;
+    {
+        std::lock_guard<std::mutex> lk(worker->mutex);
+        commands.swap(worker->commands);
+    }
+    float nextRefill = 0;
+    process(worker, commands, nextRefill, false);
+}
+
+void AudioStreamer::process(Worker* worker, std::deque<Command>& commands, float& nextRefill, bool commandsOnly)
+{
+    auto begin = std::chrono::steady_clock::now();
+    ++_wakeups;
+
+    for (auto& command : commands)
+    {
+        runCommand(worker, command);
+    }
+    commands.clear();
+
+    if (!commandsOnly)
+    {
+        nextRefill = STREAMING_MAX_SLEEP;
+        auto& streams = worker->streams;
+        for (auto it = streams.begin(); it != streams.end(); )
+        {
+            if (refill(it->get(), nextRefill))
+            {
+                ++it;
+            }
+            else
+            {
+                closeStream(it->get());
+                it = streams.erase(it);
+            }
+        }
+        nextRefill = std::max(nextRefill, STREAMING_MIN_SLEEP);
+    }
+
+    _busyMicroseconds += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - begin).count();
+}
+
+void AudioStreamer::runCommand(Worker* worker, Command& command)
+{
+    CC_PROFILE_ZONE("AudioStreamer::runCommand");
+    auto& streams = worker->streams;
+    auto it = std::find_if(streams.begin(), streams.end(), [&command](const std::unique_ptr<Stream>& stream) {
+        return stream->player == command.player;
+    });
+
+    switch (command.type)
+    {
+    case Command::Type::ADD:
+    {
+        auto stream = command.stream.get();
+        stream->decoder = AudioDecoderManager::createDecoder(stream->path);
+        if (stream->decoder == nullptr || !stream->decoder->open(stream->path) || !stream->decoder->seek(stream->nextFrame))
+        {
+            ALOGE("Streaming %s failed!", stream->path.c_str());
+            closeStream(stream);
+            break;
+        }
+        stream->buffer.resize(stream->decoder->framesToBytes(stream->framesPerBuffer));
+        if (stream->startTime > 0)
+        {
+            requeue(stream, static_cast<uint32_t>(stream->startTime * stream->sampleRate));
+            alSourcePlay(stream->source);
+        }
+        streams.push_back(std::move(command.stream));
+        break;
+    }
+    case Command::Type::SEEK:
+    {
+        if (it == streams.end())
+            break;
+
+        auto stream = it->get();
+        ALint state = AL_STOPPED;
+        alGetSourcei(stream->source, AL_SOURCE_STATE, &state);
+
+        requeue(stream, static_cast<uint32_t>(command.time * stream->sampleRate));
+
+        if (state == AL_PLAYING || state == AL_PAUSED)
+        {
+            alSourcePlay(stream->source);
+            if (state == AL_PAUSED)
+                alSourcePause(stream->source);
+        }
+        break;
+    }
+    case Command::Type::REMOVE:
+        if (it != streams.end())
+        {
+            closeStream(it->get());
+            streams.erase(it);
+        }
+        command.removed->set_value();
+        break;
+    }
+}
+
+bool AudioStreamer::refill(Stream* stream, float& nextRefill)
+{
+    ALint state = AL_STOPPED;
+    alGetSourcei(stream->source, AL_SOURCE_STATE, &state);
+    if (state == AL_PAUSED)
+        return true;
+
+    ALint processed = 0;
+    alGetSourcei(stream->source, AL_BUFFERS_PROCESSED, &processed);
+    for (; processed > 0; --processed)
+    {
+        CC_PROFILE_ZONE("AudioStreamer::refill");
+        ALuint bufferId;
+        alSourceUnqueueBuffers(stream->source, 1, &bufferId);
+        stream->queued.pop_front();
+        if (!stream->ended)
+            queueBuffer(stream, bufferId);
+    }
+
+    if (state != AL_PLAYING)
+    {
+        // all buffers were played, the last ones of the file or some that weren't refilled in time
+        if (stream->queued.empty())
+            return false;
+
+        ++_underruns;
+        alSourcePlay(stream->source);
+        if (alGetError() != AL_NO_ERROR)
+        {
+            ALOGE("Error restarting playback!");
+            return false;
+        }
+    }
+
+    updateTime(stream, nextRefill);
+    return true;
+}
+
+uint32_t AudioStreamer::decode(Stream* stream)
+{
+    auto decoder = stream->decoder;
+    uint32_t frames = decoder->readFixedFrames(stream->framesPerBuffer, stream->buffer.data());
+    if (frames == 0 && stream->player->_loop)
+    {
+        decoder->seek(0);
+        stream->nextFrame = 0;
+        frames = decoder->readFixedFrames(stream->framesPerBuffer, stream->buffer.data());
+    }
+    return frames;
+}
+
+void AudioStreamer::queueBuffer(Stream* stream, ALuint bufferId)
+{
+    uint32_t frames = decode(stream);
+    if (frames == 0)
+    {
+        stream->ended = true;
+        return;
+    }
+
+    auto decoder = stream->decoder;
+    auto sourceFormat = decoder->getSourceFormat();
+    if (sourceFormat == AUDIO_SOURCE_FORMAT::ADPCM || sourceFormat == AUDIO_SOURCE_FORMAT::IMA_ADPCM)
+        alBufferi(bufferId, AL_UNPACK_BLOCK_ALIGNMENT_SOFT, decoder->getSamplesPerBlock());
+    alBufferData(bufferId, stream->format, stream->buffer.data(), decoder->framesToBytes(frames), decoder->getSampleRate());
+    alSourceQueueBuffers(stream->source, 1, &bufferId);
+
+    stream->queued.emplace_back(stream->nextFrame, frames);
+    stream->nextFrame += frames;
+    ++_buffersQueued;
+    _framesDecoded += frames;
+}
+
+void AudioStreamer::requeue(Stream* stream, uint32_t frame)
+{
+    // stopping marks all buffers processed, so all of them can be unqueued and refilled at once
+    alSourceStop(stream->source);
+    ALint queued = 0;
+    alGetSourcei(stream->source, AL_BUFFERS_QUEUED, &queued);
+    ALuint bufferIds[QUEUEBUFFER_NUM];
+    alSourceUnqueueBuffers(stream->source, std::min<ALint>(queued, QUEUEBUFFER_NUM), bufferIds);
+    stream->queued.clear();
+
+    frame = std::min(frame, stream->totalFrames);
+    stream->decoder->seek(frame);
+    stream->nextFrame = frame;
+    stream->ended = false;
+    for (int index = 0; index < QUEUEBUFFER_NUM && !stream->ended; ++index)
+    {
+        queueBuffer(stream, stream->player->_bufferIds[index]);
+    }
+}
+
+void AudioStreamer::updateTime(Stream* stream, float& nextRefill)
+{
+    if (stream->queued.empty())
+        return;
+
+    // the sample offset counts from the beginning of the first queued buffer
+    ALint offset = 0;
+    alGetSourcei(stream->source, AL_SAMPLE_OFFSET, &offset);
+    uint32_t frame = static_cast<uint32_t>(std::max(offset, 0));
+    auto buffer = stream->queued.begin();
+    while (frame >= buffer->second && buffer + 1 != stream->queued.end())
+    {
+        frame -= buffer->second;
+        ++buffer;
+    }
+    stream->player->_currTime = std::min(static_cast<float>(buffer->first + frame) / stream->sampleRate, stream->duration);
+
+    // wake up once the buffer being played is done, or right away if others were played meanwhile
+    float remaining = buffer != stream->queued.begin() ? 0.0f
+        : static_cast<float>(buffer->second - std::min(frame, buffer->second)) / stream->sampleRate;
+    nextRefill = std::min(nextRefill, remaining + STREAMING_MIN_SLEEP);
+}
+
+void AudioStreamer::closeStream(Stream* stream)
+{
+    if (stream->decoder != nullptr)
+    {
+        AudioDecoderManager::destroyDecoder(stream->decoder);
+        stream->decoder = nullptr;
+    }
+    stream->player->_streamFinished = true;
+}
+
+NS_CC_END
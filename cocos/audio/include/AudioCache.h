@@ -34,6 +34,7 @@
 #include <memory>
 
 #include "platform/CCPlatformMacros.h"
+#include "base/CCData.h"
 #include "audio/include/AudioMacros.h"
 #include "audio/include/alconfig.h"
 
@@ -88,6 +89,16 @@ protected:
     ALsizei _queBufferSize[QUEUEBUFFER_NUM];
     uint32_t _queBufferFrames;
 
+    /*Cache budget related stuff
+     * The bytes of the pcm data in _alBufferId, 0 when streaming. When _keepCompressedData is set,
+     * a fully decoded file keeps its contents in _compressedData, to decode it again from memory once evicted.
+     * A cache created for an evicted file gets them back in _compressedData before loading.
+     */
+    uint32_t _pcmDataSize = 0;
+    unsigned int _lastUsed = 0;
+    bool _keepCompressedData = false;
+    std::shared_ptr<Data> _compressedData;
+
     std::mutex _playCallbackMutex;
     std::vector< std::function<void()> > _playCallbacks;
 
@@ -106,6 +117,7 @@ protected:
 
     friend class AudioEngineImpl;
     friend class AudioPlayer;
+    friend class AudioStreamer;
 };
 
 NS_CC_END
@@ -27,8 +27,11 @@
 
 #include <stdint.h>
 #include <string>
+#include <memory>
 
 namespace cocos2d {
+class Data;
+
 enum class AUDIO_SOURCE_FORMAT : uint16_t
 {
     PCM_UNK, // Unknown
@@ -59,6 +62,14 @@ public:
      */
     virtual bool open(const std::string& path) = 0;
 
+    /**
+     * @brief Opens the contents of an audio file already in memory, only compressed formats support it.
+     * @param path The path of the file, to log errors.
+     * @param data The contents of the file, the decoder holds them until it is destroyed.
+     * @return true if succeed, otherwise false.
+     */
+    virtual bool openData(const std::string& path, const std::shared_ptr<Data>& data);
+
     /**
      * @brief Checks whether decoder has opened file successfully.
      * @return true if succeed, otherwise false.
@@ -36,6 +36,8 @@ public:
     static bool init();
     static void destroy();
     static AudioDecoder* createDecoder(const std::string& path);
+    // whether the decoder of a file can open its contents from memory with AudioDecoder::openData()
+    static bool canDecodeData(const std::string& path);
     static void destroyDecoder(AudioDecoder* decoder);
 };
 
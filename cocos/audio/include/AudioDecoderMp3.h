@@ -27,6 +27,7 @@
 
 #include "audio/include/AudioDecoder.h"
 #include "platform/PXFileStream.h"
+#include <vector>
 
 struct mpg123_handle_struct;
 
@@ -44,6 +45,12 @@ public:
      */
     bool open(const std::string& path) override;
 
+    /**
+     * @brief Opens the contents of an mp3 file in memory.
+     * @return true if succeed, otherwise false.
+     */
+    bool openData(const std::string& path, const std::shared_ptr<Data>& data) override;
+
     /**
      * @brief Closes opened audio file.
      * @note The method will also be automatically invoked in the destructor.
@@ -73,9 +80,16 @@ protected:
     static bool lazyInit();
     static void destroy();
 
+    bool openStream();
+
     PXFileStream _fileStream;
+    std::shared_ptr<Data> _data;
     struct mpg123_handle_struct* _mpg123handle;
 
+    // mpg123 built for float output is read here and converted to 16 bits.
+    bool _floatOutput = false;
+    std::vector<float> _readBuffer;
+
     friend class AudioDecoderManager;
 };
 
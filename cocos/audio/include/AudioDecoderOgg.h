@@ -30,6 +30,7 @@
 #include "vorbis/vorbisfile.h"
 
 #include "platform/PXFileStream.h"
+#include <vector>
 
 namespace cocos2d {
 
@@ -45,6 +46,12 @@ public:
      */
     bool open(const std::string& path) override;
 
+    /**
+     * @brief Opens the contents of an ogg file in memory.
+     * @return true if succeed, otherwise false.
+     */
+    bool openData(const std::string& path, const std::shared_ptr<Data>& data) override;
+
     /**
      * @brief Closes opened audio file.
      * @note The method will also be automatically invoked in the destructor.
@@ -70,9 +77,16 @@ protected:
     AudioDecoderOgg();
     ~AudioDecoderOgg();
 
+    bool openStream();
+
     PXFileStream _fileStream;
+    std::shared_ptr<Data> _data;
     OggVorbis_File _vf;
 
+    // Files with more than 2 channels are read here and mixed down to stereo.
+    uint32_t _fileChannels = 0;
+    std::vector<int16_t> _readBuffer;
+
     friend class AudioDecoderManager;
 };
 
@@ -29,6 +29,7 @@
 
 #include "audio/include/AudioDecoder.h"
 #include "platform/PXFileStream.h"
+#include <vector>
 
 #if !defined(MAKE_FOURCC)
 #define MAKE_FOURCC(a,b,c,d) ((uint32_t)((a) | ((b) << 8) | ((c) << 16) | (((uint32_t)(d)) << 24)))
@@ -36,7 +37,7 @@
 
 #if !defined(_WIN32)
 typedef struct _GUID {
-    unsigned long  Data1;
+    uint32_t       Data1; // unsigned long is 8 bytes on LP64, the struct must match the 16 bytes of the file
     unsigned short Data2;
     unsigned short Data3;
     unsigned char  Data4[8];
@@ -161,6 +162,13 @@ protected:
     ~AudioDecoderWav();
 
     mutable WAV_FILE _wavf;
+
+    // Formats OpenAL doesn't play or that waste memory are converted to 16 bits by read(), more than 2 channels
+    // are mixed down to stereo. _sourceBytesPerFrame is 0 when the samples are read as they are.
+    AUDIO_SOURCE_FORMAT _fileFormat = AUDIO_SOURCE_FORMAT::PCM_UNK;
+    uint32_t _fileChannels = 0;
+    uint32_t _sourceBytesPerFrame = 0;
+    std::vector<char> _readBuffer;
 };
 
 } // namespace cocos2d {
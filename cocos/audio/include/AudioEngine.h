@@ -33,6 +33,7 @@
 #include <list>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #ifdef ERROR
 #undef ERROR
@@ -61,6 +62,13 @@ public:
     
     /* Minimum delay in between sounds */
     double minDelay;
+
+    /* When more instances play than there are OpenAL sources, the ones of a higher priority keep the sources,
+       then the louder ones. The others are virtual voices, their playback position advances silently. */
+    int priority;
+
+    /* Scales the volume of the instances of the profile. */
+    float volume;
     
     /**
      * Default constructor
@@ -70,6 +78,8 @@ public:
     AudioProfile()
     : maxInstances(0)
     , minDelay(0.0)
+    , priority(0)
+    , volume(1.0f)
     {
         
     }
@@ -98,6 +108,27 @@ public:
         PAUSED
     };
     
+    /** Statistics of the cache of decoded audio files, see setCacheBudget(). */
+    struct CacheStats
+    {
+        unsigned int hits = 0;           ///< plays and preloads of files which were cached
+        unsigned int misses = 0;         ///< plays and preloads which had to load their file
+        unsigned int compressedHits = 0; ///< misses decoded from the compressed contents kept in memory
+        unsigned int evictions = 0;      ///< decoded files evicted to stay within the budget
+        size_t pcmBytes = 0;             ///< bytes of the decoded files
+        size_t compressedBytes = 0;      ///< bytes of the compressed contents kept for evicted files
+    };
+
+    /** Statistics of the audio instances and the OpenAL sources they share, see AudioProfile::priority. */
+    struct VoiceStats
+    {
+        unsigned int voices = 0;        ///< instances being played
+        unsigned int realVoices = 0;    ///< instances which have a source
+        unsigned int virtualVoices = 0; ///< instances without a source, which only advance their position
+        unsigned int steals = 0;        ///< sources taken from less important instances
+        unsigned int revivals = 0;      ///< virtual instances which got a source back
+    };
+
     static const int INVALID_AUDIO_ID;
 
     static const float TIME_UNKNOWN;
@@ -242,10 +273,45 @@ public:
     
     /**
      * Sets the maximum number of simultaneous audio instance for AudioEngine.
+     * With openal-soft there is no limit by default, the instances beyond the MAX_AUDIOINSTANCES sources are virtual.
      *
      * @param maxInstances The maximum number of simultaneous audio instance.
      */
     static bool setMaxAudioInstance(int maxInstances);
+
+    /**
+     * Whether an audio instance is a virtual voice: it has no OpenAL source because more important instances
+     * use all of them, it is silent and its playback position advances until it gets a source back.
+     *
+     * @param audioID An audioID returned by the play2d function.
+     */
+    static bool isVirtual(AUDIO_ID audioID);
+
+    /** Gets how many instances have a source, and how often sources moved between instances. */
+    static VoiceStats getVoiceStats();
+
+    /**
+     * Mixes the output into memory instead of playing it on a device, with the ALC_SOFT_loopback extension of
+     * openal-soft. The streams are refilled by renderOffline() instead of the streaming threads, so the output
+     * only depends on the calls made. It must be enabled before the audio engine is initialized.
+     *
+     * @param sampleRate The sample rate of the output, which is 16-bit stereo.
+     * @return False if the audio engine is initialized already, or doesn't use openal-soft.
+     */
+    static bool enableOfflineRendering(int sampleRate);
+
+    /** Whether the output is mixed into memory, see enableOfflineRendering(). */
+    static bool isOfflineRendering() { return _offlineSampleRate > 0; }
+
+    /**
+     * Refills the streams and mixes the next frames of all the playing instances.
+     * Call it with at most the frames of a streaming buffer (QUEUEBUFFER_TIME_STEP), the streams underrun otherwise.
+     *
+     * @param buffer Receives frames * 2 interleaved samples.
+     * @param frames The number of frames to mix.
+     * @return False if offline rendering isn't enabled or the audio engine couldn't be initialized.
+     */
+    static bool renderOffline(short* buffer, int frames);
     
     /** 
      * Uncache the audio data from internal buffer.
@@ -292,10 +358,48 @@ public:
      */
     static void preload(const std::string& filePath, std::function<void(bool isSuccess)> callback);
 
+    /**
+     * Preloads a list of audio files, they are decoded at the same time by the threads of the audio engine.
+     * @param filePaths The file paths of the audios.
+     * @param progressCallback Called on the cocos thread each time a file is loaded or failed to load, may be nullptr.
+     * @param callback Called once all the files are processed, with false if any of them failed to load.
+     */
+    static void preloadBatch(const std::vector<std::string>& filePaths, std::function<void(int loaded, int total)> progressCallback,
+                             std::function<void(bool allSucceeded)> callback);
+
     /**
      * Gets playing audio count.
      */
     static int getPlayingAudioCount();
+
+    /**
+     * Sets how many bytes of decoded audio data may be cached.
+     * Over budget, the fully decoded files no audio plays are evicted, least recently played first. Streamed files
+     * don't count. The budget is checked on every play or preload of a file that isn't cached, and when audios finish.
+     * @note It only works with OpenAL Soft, the native Apple audio engine ignores it.
+     * @param bytes The budget in bytes, 0 (the default) disables it.
+     */
+    static void setCacheBudget(size_t bytes);
+
+    /** Gets the budget of decoded audio data in bytes, 0 if disabled. */
+    static size_t getCacheBudget() { return _cacheBudget; }
+
+    /**
+     * Sets how many bytes of compressed files (ogg and mp3) may be kept in memory once their decoded data is evicted.
+     * The next play decodes them again from memory on an audio thread, instead of reading the file system.
+     * The least recently played ones are dropped first.
+     * @param bytes The budget in bytes, 0 (the default) doesn't keep any.
+     */
+    static void setCompressedCacheBudget(size_t bytes);
+
+    /** Gets the budget of the compressed files kept in memory in bytes, 0 if disabled. */
+    static size_t getCompressedCacheBudget() { return _compressedCacheBudget; }
+
+    /** Gets the hits, misses and evictions of the audio cache, and the memory it uses. */
+    static CacheStats getCacheStats();
+
+    /** Resets the counters of the audio cache statistics. */
+    static void resetCacheStats();
     
     /**
      * Whether to enable playing audios
@@ -355,6 +459,12 @@ protected:
     static std::unordered_map<std::string, ProfileHelper> _audioPathProfileHelperMap;
     
     static unsigned int _maxInstances;
+
+    static size_t _cacheBudget;
+    static size_t _compressedCacheBudget;
+
+    // the sample rate of the loopback device, 0 when playing on a device
+    static int _offlineSampleRate;
     
     static ProfileHelper* _defaultProfileHelper;
     
@@ -33,6 +33,7 @@
 
 #include "base/CCRef.h"
 #include "audio/include/AudioMacros.h"
+#include "audio/include/AudioEngine.h"
 #include "audio/include/AudioCache.h"
 #include "audio/include/AudioPlayer.h"
 
@@ -47,7 +48,11 @@ public:
     ~AudioEngineImpl();
 
     bool init();
+#if CC_USE_ALSOFT
+    AUDIO_ID play2d(const std::string &fileFullPath ,bool loop ,float volume, int priority);
+#else
     AUDIO_ID play2d(const std::string &fileFullPath ,bool loop ,float volume);
+#endif
     void setVolume(AUDIO_ID audioID,float volume);
     void setLoop(AUDIO_ID audioID, bool loop);
     bool pause(AUDIO_ID audioID);
@@ -63,11 +68,25 @@ public:
     void uncacheAll();
     AudioCache* preload(const std::string& filePath, std::function<void(bool)> callback);
     void update(float dt);
+#if CC_USE_ALSOFT
+    void enforceCacheBudget();
+    AudioEngine::CacheStats getCacheStats() const;
+    void resetCacheStats();
+    bool isVirtual(AUDIO_ID audioID);
+    AudioEngine::VoiceStats getVoiceStats();
+    bool renderOffline(short* buffer, int frames);
+#endif
 
 private:
     void _updateLocked(float dt);
     void _play2d(AudioCache *cache, AUDIO_ID audioID);
+#if CC_USE_ALSOFT
+    ALuint findValidSource(AudioPlayer* player);
+    void updateVoices();
+    static bool isMoreImportant(const AudioPlayer* a, const AudioPlayer* b);
+#else
     ALuint findValidSource();
+#endif
 #if !CC_USE_ALSOFT
     static ALvoid myAlSourceNotificationCallback(ALuint sid, ALuint notificationID, ALvoid* userData);
 #endif
@@ -78,6 +97,17 @@ private:
 
     //filePath,bufferInfo
     std::unordered_map<std::string, AudioCache> _audioCaches;
+#if CC_USE_ALSOFT
+    //filePath,compressed contents of evicted files and when they were last used
+    std::unordered_map<std::string, std::pair<std::shared_ptr<Data>, unsigned int>> _compressedCaches;
+    size_t _compressedCacheSize = 0;
+    unsigned int _cacheUseCounter = 0;
+    AudioEngine::CacheStats _cacheStats;
+
+    // the players sorted by importance when virtual voices compete for the sources
+    std::vector<AudioPlayer*> _voices;
+    AudioEngine::VoiceStats _voiceStats;
+#endif
 
     //audioID,AudioInfo
     std::unordered_map<AUDIO_ID, AudioPlayer*>  _audioPlayers;
@@ -32,6 +32,8 @@
 
 #define QUEUEBUFFER_NUM (3)
 #define QUEUEBUFFER_TIME_STEP (0.05f)
+// the threads of AudioStreamer, which refill the buffers of all streaming sources
+#define AUDIO_STREAMING_THREADS (2)
 
 #define QUOTEME_(x) #x
 #define QUOTEME(x) QUOTEME_(x)
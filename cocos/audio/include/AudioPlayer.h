@@ -28,6 +28,7 @@
 #include "platform/CCPlatformConfig.h"
 
 #include <string>
+#include <atomic>
 #include <condition_variable>
 #include <mutex>
 #include <thread>
@@ -40,10 +41,16 @@ NS_CC_BEGIN
 
 class AudioCache;
 class AudioEngineImpl;
+#if CC_USE_ALSOFT
+class AudioStreamer;
+#endif
 
 class CC_DLL AudioPlayer
 {
     friend class AudioEngineImpl;
+#if CC_USE_ALSOFT
+    friend class AudioStreamer;
+#endif
 public:
     AudioPlayer();
     ~AudioPlayer();
@@ -59,9 +66,15 @@ public:
 
 protected:
     void setCache(AudioCache* cache);
-    void rotateBufferThread(int offsetFrame);
     bool play2d();
-#if !CC_USE_ALSOFT
+#if CC_USE_ALSOFT
+    /**
+     * Stops the source and keeps the playback position in _currTime, the player goes on as a virtual voice.
+     * @return The source, which the player doesn't use anymore.
+     */
+    ALuint releaseSource();
+#else
+    void rotateBufferThread(int offsetFrame);
     void wakeupRotateThread();
 #endif
 
@@ -80,12 +93,19 @@ protected:
     float _currTime;
     bool _streamingSource;
     ALuint _bufferIds[QUEUEBUFFER_NUM];
+#if CC_USE_ALSOFT
+    // set by AudioStreamer once all buffers were played
+    std::atomic_bool _streamFinished;
+
+    // virtual voices have no source (AL_INVALID), their _currTime is advanced by AudioEngineImpl
+    int _priority;
+    bool _paused;
+#else
     std::thread* _rotateBufferThread;
     std::condition_variable _sleepCondition;
     std::mutex _sleepMutex;
     bool _timeDirty;
     bool _isRotateThreadExited;
-#if !CC_USE_ALSOFT
     std::atomic_bool _needWakeupRotateThread;
 #endif
 
@@ -0,0 +1,79 @@
+/****************************************************************************
+Copyright (c) 2020 c4games.com.
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace cocos2d {
+
+/**
+ * Sample conversions shared by the decoders, they turn what the files contain into the 16 bits
+ * mono or stereo PCM the engine plays.
+ * The SSE2 and NEON kernels give the same results as the scalar code, dst may be src for the in place
+ * conversions to a smaller sample size.
+ */
+namespace AudioSampleConverter {
+
+    /** The order of the channels in the interleaved samples of a file with more than 2 channels. */
+    enum class ChannelOrder
+    {
+        WAVE,   // FL FR FC LFE BL BR SL SR (WAVEFORMATEXTENSIBLE, also used by mp3)
+        VORBIS, // FL FC FR ... LFE, see the Vorbis I specification 4.3.9
+    };
+
+    /** Little endian signed 24 bits samples, 3 bytes each, to 16 bits. */
+    void s24ToS16(const uint8_t* src, int16_t* dst, size_t samples);
+
+    /** Signed 32 bits samples to 16 bits. */
+    void s32ToS16(const int32_t* src, int16_t* dst, size_t samples);
+
+    /** Float samples in [-1, 1] to 16 bits, values out of the range are clamped. */
+    void f32ToS16(const float* src, int16_t* dst, size_t samples);
+
+    /** Double samples in [-1, 1] to 16 bits, values out of the range are clamped. */
+    void f64ToS16(const double* src, int16_t* dst, size_t samples);
+
+    /**
+     * Mixes interleaved frames of 3 to 8 channels down to stereo, the center and surround channels are
+     * attenuated by 3dB and the LFE is dropped. The weights are scaled so the mix can't clip.
+     * @param dst The stereo frames, frames * 2 samples, it may not overlap src.
+     */
+    void downmixToStereo(const int16_t* src, int16_t* dst, size_t frames, uint32_t channels, ChannelOrder order);
+
+    /** Whether downmixToStereo knows the layout of this channel count. */
+    bool canDownmix(uint32_t channels);
+
+    /**
+     * The converters use SSE2 or NEON kernels when the engine is built for them.
+     * Turning them off is meant for tests and benchmarks.
+     */
+    void setSIMDEnabled(bool enabled);
+    bool isSIMDEnabled();
+    /** The instruction set of the kernels: "SSE2", "NEON" or "none". */
+    const char* getSIMDName();
+}
+
+} // namespace cocos2d
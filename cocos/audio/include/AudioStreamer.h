@@ -0,0 +1,135 @@
+/****************************************************************************
+Copyright (c) 2020 c4games.com.
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#pragma once
+
+#include "platform/CCPlatformConfig.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "platform/CCPlatformMacros.h"
+#include "audio/include/AudioMacros.h"
+#include "audio/include/alconfig.h"
+
+NS_CC_BEGIN
+
+class AudioPlayer;
+
+/**
+ * Refills the OpenAL buffer queues of all streaming AudioPlayers from a few shared threads, instead of a thread
+ * per player. Streams are added, seeked and removed through the command queue of their thread, and a thread
+ * sleeps until the earliest of its sources has played a buffer.
+ */
+class CC_DLL AudioStreamer
+{
+public:
+    struct Stats
+    {
+        int streams = 0;            ///< the streams being played
+        uint64_t wakeups = 0;       ///< passes of the threads over their streams
+        uint64_t buffersQueued = 0; ///< buffers decoded and queued
+        uint64_t framesDecoded = 0; ///< frames decoded into the queued buffers
+        uint64_t underruns = 0;     ///< sources which played all their buffers before they were refilled
+        double busyTime = 0;        ///< seconds the threads spent on commands and refills, without sleeping
+    };
+
+    static AudioStreamer* getInstance();
+    static void destroyInstance();
+
+    /**
+     * Creates the shared instance with a number of threads unless it exists already. Without threads the streams
+     * are only refilled by pump(), which makes offline rendering deterministic.
+     */
+    static AudioStreamer* createInstance(int threads);
+
+    /**
+     * Starts refilling the source of a player, its first QUEUEBUFFER_NUM buffers are queued and playing.
+     * @param time When it isn't 0 the source isn't playing yet, the thread queues the buffers at time, in seconds,
+     *             and starts it. For virtual voices taking back a source.
+     */
+    void addStream(AudioPlayer* player, float time = 0);
+
+    /** Replaces the queued buffers of a stream with the ones at time, in seconds. */
+    void seekStream(AudioPlayer* player, float time);
+
+    /** Stops refilling the source of a player, returns once its thread doesn't use the player anymore. */
+    void removeStream(AudioPlayer* player);
+
+    /** Runs the commands and refills the streams on the calling thread, when there are no streaming threads. */
+    void pump();
+
+    Stats getStats() const;
+    void resetStats();
+
+    int getThreadCount() const { return _manual ? 0 : static_cast<int>(_workers.size()); }
+
+CC_CONSTRUCTOR_ACCESS:
+    explicit AudioStreamer(int threads = AUDIO_STREAMING_THREADS);
+    ~AudioStreamer();
+
+protected:
+    struct Stream;
+    struct Worker;
+    struct Command;
+
+    void threadFunc(Worker* worker);
+    /** Runs the commands of a thread, then refills its streams unless commandsOnly. */
+    void process(Worker* worker, std::deque<Command>& commands, float& nextRefill, bool commandsOnly);
+    void runCommand(Worker* worker, Command& command);
+    /** Refills the processed buffers of a stream, returns false once it is finished. */
+    bool refill(Stream* stream, float& nextRefill);
+    uint32_t decode(Stream* stream);
+    void queueBuffer(Stream* stream, ALuint bufferId);
+    /** Replaces all the buffers of a stopped or stopping source with the ones at frame. */
+    void requeue(Stream* stream, uint32_t frame);
+    void updateTime(Stream* stream, float& nextRefill);
+    void closeStream(Stream* stream);
+    void postCommand(AudioPlayer* player, Command&& command);
+
+    std::vector<std::unique_ptr<Worker>> _workers;
+    // no threads, the one worker is run by pump()
+    bool _manual;
+    std::mutex _pumpMutex;
+
+    // the thread of every stream which wasn't removed yet
+    std::unordered_map<AudioPlayer*, Worker*> _streamWorkers;
+    mutable std::mutex _streamWorkersMutex;
+
+    std::atomic<uint64_t> _wakeups;
+    std::atomic<uint64_t> _buffersQueued;
+    std::atomic<uint64_t> _framesDecoded;
+    std::atomic<uint64_t> _underruns;
+    std::atomic<int64_t> _busyMicroseconds;
+
+    static AudioStreamer* s_audioStreamer;
+};
+
+NS_CC_END
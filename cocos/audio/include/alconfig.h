@@ -32,6 +32,7 @@
 #if (CC_TARGET_PLATFORM == CC_PLATFORM_IOS || CC_TARGET_PLATFORM == CC_PLATFORM_MAC) && !CC_USE_ALSOFT_ON_APPLE
 #import <OpenAL/al.h>
 #define MAX_AUDIOINSTANCES 24
+#define MAX_AUDIOVOICES MAX_AUDIOINSTANCES
 #define CC_USE_ALSOFT 0
 #else
 #ifdef OPENAL_PLAIN_INCLUDES
@@ -42,5 +43,7 @@
 #include <AL/alext.h>
 #endif
 #define MAX_AUDIOINSTANCES 32
+// audio instances beyond the sources play as virtual voices, see AudioProfile::priority
+#define MAX_AUDIOVOICES 0x7fffffff
 #define CC_USE_ALSOFT 1
 #endif
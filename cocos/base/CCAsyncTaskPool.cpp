@@ -25,6 +25,7 @@ THE SOFTWARE.
 ****************************************************************************/
 
 #include "base/CCAsyncTaskPool.h"
+#include <algorithm>
 
 NS_CC_BEGIN
 
@@ -47,6 +48,12 @@ void AsyncTaskPool::destroyInstance()
 
 AsyncTaskPool::AsyncTaskPool()
 {
+    // hardware_concurrency() may return 0 when it can't be detected, the main thread keeps a core
+    int computeThreads = std::min(std::max(static_cast<int>(std::thread::hardware_concurrency()) - 1, 1), 4);
+    for (int type = 0; type < static_cast<int>(TaskType::TASK_MAX_TYPE); ++type)
+    {
+        _threadTasks[type].start(type == static_cast<int>(TaskType::TASK_COMPUTE) ? computeThreads : 1);
+    }
 }
 
 AsyncTaskPool::~AsyncTaskPool()
@@ -61,6 +61,7 @@ public:
         TASK_IO,
         TASK_NETWORK,
         TASK_OTHER,
+        TASK_COMPUTE, ///< cpu bound work such as encoding images, run on several threads
         TASK_MAX_TYPE,
     };
 
@@ -84,7 +85,8 @@ public:
     /**
      * Enqueue a asynchronous task.
      *
-     * @param type task type is io task, network task or others, each type of task has a thread to deal with it.
+     * @param type task type is io task, network task or others, each type of task has a thread to deal with it,
+     *        compute tasks have several and may finish in any order.
      * @param callback callback when the task is finished. The callback is called in the main thread instead of task thread.
      * @param callbackParam parameter used by the callback.
      * @param task: task can be lambda function to be performed off thread.
@@ -118,7 +120,12 @@ protected:
         ThreadTasks()
         : _stop(false)
         {
-            _thread = std::thread(
+        }
+        void start(int threads)
+        {
+            for (int index = 0; index < threads; ++index)
+            {
+                _threads.emplace_back(
                                   [this]
                                   {
                                       for(;;)
@@ -142,6 +149,7 @@ protected:
                                       }
                                   }
                                   );
+            }
         }
         ~ThreadTasks()
         {
@@ -155,7 +163,8 @@ protected:
                     _taskCallBacks.pop();
             }
             _condition.notify_all();
-            _thread.join();
+            for (auto& thread : _threads)
+                thread.join();
         }
         void clear()
         {
@@ -189,8 +198,8 @@ protected:
         }
     private:
         
-        // need to keep track of thread so we can join them
-        std::thread _thread;
+        // need to keep track of threads so we can join them
+        std::vector<std::thread> _threads;
         // the task queue
         std::queue< std::function<void()> > _tasks;
         std::queue<AsyncTaskCallBack> _taskCallBacks;
@@ -0,0 +1,480 @@
+/****************************************************************************
+Copyright (c) 2020 c4games.com.
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#include "base/CCBinaryValue.h"
+#include "base/CCData.h"
+#include <string.h>
+#include <stdlib.h>
+
+NS_CC_BEGIN
+
+static const char VALUE_MAGIC[4] = { 'C', 'C', 'V', 'B' };
+
+// Containers nest one C++ call deep per level, damaged files mustn't blow the stack.
+static const int MAX_DEPTH = 512;
+
+static uint64_t alignTo8(uint64_t offset)
+{
+    return (offset + 7) & ~static_cast<uint64_t>(7);
+}
+
+namespace
+{
+    struct Layout
+    {
+        uint64_t stringOffsets;
+        uint64_t nodes;
+        uint64_t slots;
+        uint64_t stringData;
+        uint64_t size;
+    };
+
+    Layout computeLayout(const BinaryValue::Header& header)
+    {
+        Layout layout;
+        layout.stringOffsets = sizeof(BinaryValue::Header);
+        layout.nodes = alignTo8(layout.stringOffsets + (static_cast<uint64_t>(header.stringCount) + 1) * sizeof(uint32_t));
+        layout.slots = layout.nodes + static_cast<uint64_t>(header.nodeCount) * sizeof(BinaryValue::Node);
+        layout.stringData = layout.slots + static_cast<uint64_t>(header.slotCount) * sizeof(uint32_t);
+        layout.size = layout.stringData + header.stringDataSize;
+        return layout;
+    }
+
+    class Encoder
+    {
+    public:
+        uint32_t addValue(const Value& value)
+        {
+            switch (value.getType())
+            {
+            case Value::Type::VECTOR:
+                return addVector(value.asValueVector());
+            case Value::Type::MAP:
+                return addMap(value.asValueMap());
+            case Value::Type::INT_KEY_MAP:
+                return addIntKeyMap(value.asIntKeyMap());
+            default:
+                break;
+            }
+
+            BinaryValue::Node node;
+            uint32_t index = newNode(value.getType(), &node);
+            switch (value.getType())
+            {
+            case Value::Type::BYTE:
+                node.payload = value.asByte();
+                break;
+            case Value::Type::INTEGER:
+                node.payload = static_cast<uint64_t>(static_cast<int64_t>(value.asInt()));
+                break;
+            case Value::Type::UNSIGNED:
+                node.payload = value.asUnsignedInt();
+                break;
+            case Value::Type::FLOAT:
+            {
+                float floatValue = value.asFloat();
+                uint32_t bits;
+                memcpy(&bits, &floatValue, sizeof(bits));
+                node.payload = bits;
+                break;
+            }
+            case Value::Type::DOUBLE:
+            {
+                double doubleValue = value.asDouble();
+                memcpy(&node.payload, &doubleValue, sizeof(node.payload));
+                break;
+            }
+            case Value::Type::BOOLEAN:
+                node.payload = value.asBool() ? 1 : 0;
+                break;
+            case Value::Type::STRING:
+                node.payload = addString(value.asString());
+                break;
+            default:
+                break;
+            }
+            _nodes[index] = node;
+            return index;
+        }
+
+        uint32_t addVector(const ValueVector& vector)
+        {
+            BinaryValue::Node node;
+            uint32_t index = newNode(Value::Type::VECTOR, &node);
+            uint32_t first = newSlots(vector.size(), &node);
+            _nodes[index] = node;
+
+            // the children are added after the slots were reserved, so the slots of a container stay contiguous
+            for (size_t i = 0; i < vector.size(); ++i)
+            {
+                uint32_t child = addValue(vector[i]);
+                _slots[first + i] = child;
+            }
+            return index;
+        }
+
+        uint32_t addMap(const ValueMap& map)
+        {
+            BinaryValue::Node node;
+            uint32_t index = newNode(Value::Type::MAP, &node);
+            uint32_t slot = newSlots(map.size(), &node);
+            _nodes[index] = node;
+
+            for (const auto& element : map)
+            {
+                _slots[slot] = addString(element.first);
+                uint32_t child = addValue(element.second);
+                _slots[slot + 1] = child;
+                slot += 2;
+            }
+            return index;
+        }
+
+        uint32_t addIntKeyMap(const ValueMapIntKey& map)
+        {
+            BinaryValue::Node node;
+            uint32_t index = newNode(Value::Type::INT_KEY_MAP, &node);
+            uint32_t slot = newSlots(map.size(), &node);
+            _nodes[index] = node;
+
+            for (const auto& element : map)
+            {
+                _slots[slot] = static_cast<uint32_t>(element.first);
+                uint32_t child = addValue(element.second);
+                _slots[slot + 1] = child;
+                slot += 2;
+            }
+            return index;
+        }
+
+        Data finish(uint32_t root)
+        {
+            BinaryValue::Header header;
+            memcpy(header.magic, VALUE_MAGIC, sizeof(VALUE_MAGIC));
+            header.version = BinaryValue::VERSION;
+            header.stringCount = static_cast<uint32_t>(_stringOffsets.size());
+            header.nodeCount = static_cast<uint32_t>(_nodes.size());
+            header.slotCount = static_cast<uint32_t>(_slots.size());
+            header.stringDataSize = static_cast<uint32_t>(_stringData.size());
+            header.root = root;
+            header.reserved = 0;
+            _stringOffsets.push_back(header.stringDataSize);
+
+            Layout layout = computeLayout(header);
+            auto bytes = static_cast<unsigned char*>(calloc(1, static_cast<size_t>(layout.size)));
+            Data data;
+            if (bytes == nullptr)
+                return data;
+
+            memcpy(bytes, &header, sizeof(header));
+            memcpy(bytes + layout.stringOffsets, _stringOffsets.data(), _stringOffsets.size() * sizeof(uint32_t));
+            if (!_nodes.empty())
+                memcpy(bytes + layout.nodes, _nodes.data(), _nodes.size() * sizeof(BinaryValue::Node));
+            if (!_slots.empty())
+                memcpy(bytes + layout.slots, _slots.data(), _slots.size() * sizeof(uint32_t));
+            if (!_stringData.empty())
+                memcpy(bytes + layout.stringData, _stringData.data(), _stringData.size());
+            data.fastSet(bytes, static_cast<ssize_t>(layout.size));
+            return data;
+        }
+
+    private:
+        uint32_t newNode(Value::Type type, BinaryValue::Node* node)
+        {
+            memset(node, 0, sizeof(*node));
+            node->type = static_cast<uint8_t>(type);
+            _nodes.push_back(*node);
+            return static_cast<uint32_t>(_nodes.size() - 1);
+        }
+
+        uint32_t newSlots(size_t count, BinaryValue::Node* node)
+        {
+            uint32_t first = static_cast<uint32_t>(_slots.size());
+            size_t slotsPerElement = node->type == static_cast<uint8_t>(Value::Type::VECTOR) ? 1 : 2;
+            _slots.resize(_slots.size() + count * slotsPerElement);
+            node->count = static_cast<uint32_t>(count);
+            node->payload = first;
+            return first;
+        }
+
+        uint32_t addString(const std::string& str)
+        {
+            auto iter = _stringIndices.find(str);
+            if (iter != _stringIndices.end())
+                return iter->second;
+
+            uint32_t index = static_cast<uint32_t>(_stringOffsets.size());
+            _stringIndices.emplace(str, index);
+            _stringOffsets.push_back(static_cast<uint32_t>(_stringData.size()));
+            _stringData += str;
+            return index;
+        }
+
+        std::vector<BinaryValue::Node> _nodes;
+        std::vector<uint32_t> _slots;
+        std::vector<uint32_t> _stringOffsets;
+        std::string _stringData;
+        std::unordered_map<std::string, uint32_t> _stringIndices;
+    };
+
+    class Decoder
+    {
+    public:
+        bool init(const void* data, size_t size)
+        {
+            if (!BinaryValue::isBinaryValue(data, size))
+                return false;
+
+            memcpy(&_header, data, sizeof(_header));
+            if (_header.version != BinaryValue::VERSION)
+                return false;
+
+            Layout layout = computeLayout(_header);
+            if (layout.size > size)
+                return false;
+
+            auto bytes = static_cast<const unsigned char*>(data);
+            _stringOffsets = bytes + layout.stringOffsets;
+            _nodes = bytes + layout.nodes;
+            _slots = bytes + layout.slots;
+            _stringData = reinterpret_cast<const char*>(bytes + layout.stringData);
+            return true;
+        }
+
+        uint32_t getRoot() const { return _header.root; }
+
+        bool readNode(uint32_t index, BinaryValue::Node* node) const
+        {
+            if (index >= _header.nodeCount)
+                return false;
+            // memcpy, the data given to decode() doesn't have to be aligned
+            memcpy(node, _nodes + static_cast<size_t>(index) * sizeof(BinaryValue::Node), sizeof(*node));
+            return true;
+        }
+
+        bool readValue(uint32_t index, int depth, Value* value) const
+        {
+            BinaryValue::Node node;
+            if (!readNode(index, &node))
+                return false;
+
+            switch (static_cast<Value::Type>(node.type))
+            {
+            case Value::Type::NONE:
+                *value = Value();
+                return true;
+            case Value::Type::BYTE:
+                *value = static_cast<unsigned char>(node.payload);
+                return true;
+            case Value::Type::INTEGER:
+                *value = static_cast<int>(static_cast<int64_t>(node.payload));
+                return true;
+            case Value::Type::UNSIGNED:
+                *value = static_cast<unsigned int>(node.payload);
+                return true;
+            case Value::Type::FLOAT:
+            {
+                uint32_t bits = static_cast<uint32_t>(node.payload);
+                float floatValue;
+                memcpy(&floatValue, &bits, sizeof(floatValue));
+                *value = floatValue;
+                return true;
+            }
+            case Value::Type::DOUBLE:
+            {
+                double doubleValue;
+                memcpy(&doubleValue, &node.payload, sizeof(doubleValue));
+                *value = doubleValue;
+                return true;
+            }
+            case Value::Type::BOOLEAN:
+                *value = node.payload != 0;
+                return true;
+            case Value::Type::STRING:
+            {
+                std::string str;
+                if (!readString(node.payload, &str))
+                    return false;
+                *value = std::move(str);
+                return true;
+            }
+            case Value::Type::VECTOR:
+            {
+                ValueVector vector;
+                if (!readVector(index, node, depth, &vector))
+                    return false;
+                *value = std::move(vector);
+                return true;
+            }
+            case Value::Type::MAP:
+            {
+                ValueMap map;
+                if (!readMap(index, node, depth, &map))
+                    return false;
+                *value = std::move(map);
+                return true;
+            }
+            case Value::Type::INT_KEY_MAP:
+            {
+                ValueMapIntKey map;
+                if (!readIntKeyMap(index, node, depth, &map))
+                    return false;
+                *value = std::move(map);
+                return true;
+            }
+            default:
+                return false;
+            }
+        }
+
+        bool readVector(uint32_t index, const BinaryValue::Node& node, int depth, ValueVector* vector) const
+        {
+            if (node.type != static_cast<uint8_t>(Value::Type::VECTOR) || !checkSlots(node, 1) || depth >= MAX_DEPTH)
+                return false;
+
+            vector->resize(node.count);
+            for (uint32_t i = 0; i < node.count; ++i)
+            {
+                uint32_t child = readSlot(node.payload + i);
+                // children always come after their container, so damaged files can't make cycles
+                if (child <= index || !readValue(child, depth + 1, &(*vector)[i]))
+                    return false;
+            }
+            return true;
+        }
+
+        bool readMap(uint32_t index, const BinaryValue::Node& node, int depth, ValueMap* map) const
+        {
+            if (node.type != static_cast<uint8_t>(Value::Type::MAP) || !checkSlots(node, 2) || depth >= MAX_DEPTH)
+                return false;
+
+            map->reserve(node.count);
+            std::string key;
+            for (uint32_t i = 0; i < node.count; ++i)
+            {
+                uint64_t slot = node.payload + i * 2ULL;
+                uint32_t child = readSlot(slot + 1);
+                if (child <= index || !readString(readSlot(slot), &key))
+                    return false;
+                if (!readValue(child, depth + 1, &(*map)[std::move(key)]))
+                    return false;
+            }
+            return true;
+        }
+
+        bool readIntKeyMap(uint32_t index, const BinaryValue::Node& node, int depth, ValueMapIntKey* map) const
+        {
+            if (node.type != static_cast<uint8_t>(Value::Type::INT_KEY_MAP) || !checkSlots(node, 2) || depth >= MAX_DEPTH)
+                return false;
+
+            map->reserve(node.count);
+            for (uint32_t i = 0; i < node.count; ++i)
+            {
+                uint64_t slot = node.payload + i * 2ULL;
+                uint32_t child = readSlot(slot + 1);
+                if (child <= index || !readValue(child, depth + 1, &(*map)[static_cast<int>(readSlot(slot))]))
+                    return false;
+            }
+            return true;
+        }
+
+    private:
+        bool checkSlots(const BinaryValue::Node& node, uint64_t slotsPerElement) const
+        {
+            return node.payload <= _header.slotCount && node.count * slotsPerElement <= _header.slotCount - node.payload;
+        }
+
+        uint32_t readSlot(uint64_t slot) const
+        {
+            uint32_t value;
+            memcpy(&value, _slots + slot * sizeof(uint32_t), sizeof(value));
+            return value;
+        }
+
+        bool readString(uint64_t index, std::string* str) const
+        {
+            if (index >= _header.stringCount)
+                return false;
+
+            uint32_t offsets[2];
+            memcpy(offsets, _stringOffsets + index * sizeof(uint32_t), sizeof(offsets));
+            if (offsets[0] > offsets[1] || offsets[1] > _header.stringDataSize)
+                return false;
+
+            str->assign(_stringData + offsets[0], offsets[1] - offsets[0]);
+            return true;
+        }
+
+        BinaryValue::Header _header;
+        const unsigned char* _stringOffsets = nullptr;
+        const unsigned char* _nodes = nullptr;
+        const unsigned char* _slots = nullptr;
+        const char* _stringData = nullptr;
+    };
+}
+
+bool BinaryValue::isBinaryValue(const void* data, size_t size)
+{
+    return data != nullptr && size >= sizeof(Header) && memcmp(data, VALUE_MAGIC, sizeof(VALUE_MAGIC)) == 0;
+}
+
+Data BinaryValue::encode(const ValueMap& map)
+{
+    Encoder encoder;
+    uint32_t root = encoder.addMap(map);
+    return encoder.finish(root);
+}
+
+Data BinaryValue::encode(const ValueVector& vector)
+{
+    Encoder encoder;
+    uint32_t root = encoder.addVector(vector);
+    return encoder.finish(root);
+}
+
+bool BinaryValue::decode(const void* data, size_t size, ValueMap* map)
+{
+    Decoder decoder;
+    BinaryValue::Node node;
+    map->clear();
+    if (decoder.init(data, size) && decoder.readNode(decoder.getRoot(), &node) && decoder.readMap(decoder.getRoot(), node, 0, map))
+        return true;
+
+    map->clear();
+    return false;
+}
+
+bool BinaryValue::decode(const void* data, size_t size, ValueVector* vector)
+{
+    Decoder decoder;
+    BinaryValue::Node node;
+    vector->clear();
+    if (decoder.init(data, size) && decoder.readNode(decoder.getRoot(), &node) && decoder.readVector(decoder.getRoot(), node, 0, vector))
+        return true;
+
+    vector->clear();
+    return false;
+}
+
+NS_CC_END
@@ -0,0 +1,98 @@
+/****************************************************************************
+Copyright (c) 2020 c4games.com.
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+#pragma once
+
+#include "base/CCValue.h"
+#include <stdint.h>
+
+/**
+ * @addtogroup base
+ * @{
+ */
+NS_CC_BEGIN
+
+class Data;
+
+/**
+ * @class BinaryValue
+ * @brief A compact binary form of ValueMap and ValueVector trees, which loads much faster than an XML plist.
+ *
+ * The layout, all integers little endian:
+ * - Header: the magic "CCVB", the version, the counts of strings, nodes and child slots, the size of
+ *   the string data and the index of the root node.
+ * - The string table: stringCount + 1 offsets into the string data, every distinct string is stored once.
+ * - The nodes, 16 bytes each: the Value::Type, a count and a 64 bit payload. Scalars keep their value in the
+ *   payload, strings the index of their string, containers the index of their first child slot.
+ * - The child slots: a node index per element of a vector, a key (string index or integer) and a node index
+ *   per element of a map. The slots of a container are contiguous and its nodes come after it.
+ * - The string data, the strings aren't null terminated.
+ *
+ * Everything is addressed by offsets, so a file can be decoded right from a memory mapping.
+ * @js NA
+ * @lua NA
+ */
+class CC_DLL BinaryValue
+{
+public:
+    static const uint32_t VERSION = 1;
+
+    struct Header
+    {
+        char magic[4];
+        uint32_t version;
+        uint32_t stringCount;
+        uint32_t nodeCount;
+        uint32_t slotCount;
+        uint32_t stringDataSize;
+        uint32_t root;
+        uint32_t reserved;
+    };
+
+    struct Node
+    {
+        uint8_t type;
+        uint8_t reserved[3];
+        uint32_t count;
+        uint64_t payload;
+    };
+
+    /** Whether the data starts like an encoded value, decoding may still fail if it's damaged. */
+    static bool isBinaryValue(const void* data, size_t size);
+
+    /** Encodes a tree, the result can be decoded by decode() or written to a file. */
+    static Data encode(const ValueMap& map);
+    static Data encode(const ValueVector& vector);
+
+    /**
+     * Decodes a tree whose root is a map, respectively a vector.
+     *
+     * @return false if the data isn't valid or the root has another type, the output is left empty then.
+     */
+    static bool decode(const void* data, size_t size, ValueMap* map);
+    static bool decode(const void* data, size_t size, ValueVector* vector);
+};
+
+NS_CC_END
+// end group
+/// @}
@@ -65,6 +65,7 @@
 #include "base/base64.h"
 #include "base/ccUtils.h"
 #include "base/ccUTF8.h"
+#include "base/CCFrameProfiler.h"
 
 NS_CC_BEGIN
 
@@ -456,6 +457,7 @@ Console::Console()
     createCommandFileUtils();
     createCommandFps();
     createCommandHelp();
+    createCommandProfiler();
     createCommandProjection();
     createCommandResolution();
     createCommandSceneGraph();
@@ -1040,6 +1042,16 @@ void Console::createCommandHelp()
     addCommand({"help", "Print this message. Args: [ ]", CC_CALLBACK_2(Console::commandHelp, this)});
 }
 
+void Console::createCommandProfiler()
+{
+    addCommand({"profiler", "Capture a Chrome trace of the frame profiler. Args: [-h | help | start [frames] [path] | stop | ]",
+        CC_CALLBACK_2(Console::commandProfiler, this)});
+    addSubCommand("profiler", {"start", "profiler start [frames] [path]: capture the next frames (60 by default, 0 until stopped) and write the trace to path.",
+        CC_CALLBACK_2(Console::commandProfilerSubCommandStart, this)});
+    addSubCommand("profiler", {"stop", "stop the capture and write the trace.",
+        CC_CALLBACK_2(Console::commandProfilerSubCommandStop, this)});
+}
+
 void Console::createCommandProjection()
 {
     addCommand({"projection", "Change or print the current projection. Args: [-h | help | 2d | 3d | ]",
@@ -1064,10 +1076,12 @@ void Console::createCommandSceneGraph()
 
 void Console::createCommandTexture()
 {
-    addCommand({"texture", "Flush or print the TextureCache info. Args: [-h | help | flush | ] ",
+    addCommand({"texture", "Flush or print the TextureCache info. Args: [-h | help | flush | budget [MB] | ] ",
         CC_CALLBACK_2(Console::commandTextures, this)});
     addSubCommand("texture", {"flush", "Purges the dictionary of loaded textures.",
         CC_CALLBACK_2(Console::commandTexturesSubCommandFlush, this)});
+    addSubCommand("texture", {"budget", "texture budget [MB]: print or set the memory budget of the cached textures, 0 disables it.",
+        CC_CALLBACK_2(Console::commandTexturesSubCommandBudget, this)});
 }
 
 void Console::createCommandTouch()
@@ -1198,6 +1212,65 @@ void Console::commandHelp(int fd, const std::string& /*args*/)
     sendHelp(fd, _commands, "\nAvailable commands:\n");
 }
 
+void Console::commandProfiler(int fd, const std::string& /*args*/)
+{
+#if CC_ENABLE_FRAME_PROFILER
+    Scheduler *sched = Director::getInstance()->getScheduler();
+    sched->performFunctionInCocosThread( [=](){
+        Console::Utility::mydprintf(fd, "%s", FrameProfiler::getInstance()->getStatus().c_str());
+        Console::Utility::sendPrompt(fd);
+    });
+#else
+    Console::Utility::mydprintf(fd, "frame profiler not available. CC_ENABLE_FRAME_PROFILER must be set to 1 in ccConfig.h\n");
+#endif
+}
+
+void Console::commandProfilerSubCommandStart(int fd, const std::string& args)
+{
+#if CC_ENABLE_FRAME_PROFILER
+    auto argv = Console::Utility::split(args, ' ');
+    unsigned int frames = 60;
+    std::string path;
+    if (argv.size() > 1)
+    {
+        if (!Console::Utility::isFloat(argv[1]))
+        {
+            const char msg[] = "profiler: invalid arguments.\n";
+            Console::Utility::sendToConsole(fd, msg, strlen(msg));
+            return;
+        }
+        frames = static_cast<unsigned int>(std::max(utils::atof(argv[1].c_str()), 0.0));
+    }
+    if (argv.size() > 2)
+        path = argv[2];
+
+    Scheduler *sched = Director::getInstance()->getScheduler();
+    sched->performFunctionInCocosThread( [=](){
+        FrameProfiler::getInstance()->startCapture(frames, path, [=](const std::string& tracePath){
+            if (tracePath.empty())
+                Console::Utility::mydprintf(fd, "profiler: failed to write the trace\n");
+            else
+                Console::Utility::mydprintf(fd, "profiler: trace written to %s\n", tracePath.c_str());
+            Console::Utility::sendPrompt(fd);
+        });
+    });
+#else
+    commandProfiler(fd, args);
+#endif
+}
+
+void Console::commandProfilerSubCommandStop(int fd, const std::string& args)
+{
+#if CC_ENABLE_FRAME_PROFILER
+    Scheduler *sched = Director::getInstance()->getScheduler();
+    sched->performFunctionInCocosThread( [](){
+        FrameProfiler::getInstance()->stopCapture();
+    });
+#else
+    commandProfiler(fd, args);
+#endif
+}
+
 void Console::commandProjection(int fd, const std::string& /*args*/)
 {
     auto director = Director::getInstance();
@@ -1302,6 +1375,30 @@ void Console::commandTexturesSubCommandFlush(int /*fd*/, const std::string& /*ar
     });
 }
 
+void Console::commandTexturesSubCommandBudget(int fd, const std::string& args)
+{
+    auto argv = Console::Utility::split(args, ' ');
+    if (argv.size() > 1 && !Console::Utility::isFloat(argv[1]))
+    {
+        const char msg[] = "texture budget: invalid arguments.\n";
+        Console::Utility::sendToConsole(fd, msg, strlen(msg));
+        return;
+    }
+
+    bool set = argv.size() > 1;
+    double megabytes = set ? std::max(utils::atof(argv[1].c_str()), 0.0) : 0;
+    Scheduler *sched = Director::getInstance()->getScheduler();
+    sched->performFunctionInCocosThread( [=](){
+        auto cache = Director::getInstance()->getTextureCache();
+        if (set)
+            cache->setMemoryBudget(static_cast<size_t>(megabytes * 1024 * 1024));
+        Console::Utility::mydprintf(fd, "budget: %.2f MB, used: %.2f MB, %u evictions, %u reloads\n",
+            cache->getMemoryBudget() / (1024.0f*1024.0f), cache->getMemoryUsage() / (1024.0f*1024.0f),
+            cache->getEvictionCount(), cache->getReloadCount());
+        Console::Utility::sendPrompt(fd);
+    });
+}
+
 void Console::commandTouchSubCommandTap(int fd, const std::string& args)
 {
     auto argv = Console::Utility::split(args,' ');
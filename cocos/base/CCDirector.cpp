@@ -57,6 +57,8 @@ THE SOFTWARE.
 #include "base/CCAutoreleasePool.h"
 #include "base/CCConfiguration.h"
 #include "base/CCAsyncTaskPool.h"
+#include "base/CCParallelTaskPool.h"
+#include "base/CCFrameProfiler.h"
 #include "base/ObjectFactory.h"
 #include "platform/CCApplication.h"
 #include "renderer/backend/ProgramCache.h"
@@ -117,6 +119,8 @@ bool Director::init()
 
     _scenesStack.reserve(15);
 
+    CC_PROFILE_THREAD("Main");
+
     // FPS
     _lastUpdate = std::chrono::steady_clock::now();
     
@@ -247,6 +251,9 @@ void Director::setGLDefaultValues()
 // Draw the Scene
 void Director::drawScene()
 {
+    CC_PROFILE_FRAME();
+    CC_PROFILE_ZONE("Director::drawScene");
+
     _renderer->beginFrame();
 
     // calculate "global" dt
@@ -1020,6 +1027,7 @@ void Director::reset()
     SpriteFrameCache::destroyInstance();
     FileUtils::destroyInstance();
     AsyncTaskPool::destroyInstance();
+    ParallelTaskPool::destroyInstance();
     backend::ProgramCache::destroyInstance();
     
     
@@ -28,6 +28,7 @@ THE SOFTWARE.
 #pragma once
 
 #include <stack>
+#include <algorithm>
 #include <thread>
 #include <chrono>
 
@@ -161,6 +162,17 @@ public:
     bool isDisplayStats() { return _displayStats; }
     /** Display the FPS on the bottom-left corner of the screen. */
     void setDisplayStats(bool displayStats) { _displayStats = displayStats; }
+
+    /**
+     * Set the number of threads used to update the transforms of the running scene before it is visited.
+     * 1 (the default) updates them while visiting, larger values update the dirty transforms of the subtrees
+     * on the ParallelTaskPool first, see Node::updateTransforms(). The transforms and the commands are the same
+     * in both cases, but getNodeToParentTransform() of the nodes is called from worker threads.
+     * @param threads The number of threads including the main thread.
+     */
+    void setTransformThreads(int threads) { _transformThreads = std::max(threads, 1); }
+    /** Get the number of threads used to update the transforms of the running scene. */
+    int getTransformThreads() const { return _transformThreads; }
     
     /** Get seconds per frame. */
     float getSecondsPerFrame() { return _secondsPerFrame; }
@@ -582,6 +594,7 @@ protected:
     float _oldAnimationInterval = 0.0f;
     
     bool _displayStats = false;
+    int _transformThreads = 1;
     float _accumDt = 0.0f;
     float _frameRate = 0.0f;
     
@@ -0,0 +1,323 @@
+/****************************************************************************
+Copyright (c) 2020 c4games.com.
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#include "base/CCFrameProfiler.h"
+
+#if CC_ENABLE_FRAME_PROFILER
+
+#include "platform/CCFileUtils.h"
+#include "base/ccMacros.h"
+#include <time.h>
+
+NS_CC_BEGIN
+
+std::atomic<bool> FrameProfiler::s_capturing(false);
+std::atomic<FrameProfiler*> FrameProfiler::s_frameProfiler(nullptr);
+
+// The buffer of the calling thread. Buffers are owned by the profiler and live until it is destroyed,
+// the buffer of an exited thread is reused by the next new one, so restarted workers don't add buffers.
+struct FrameProfilerThreadBufferHolder
+{
+    FrameProfiler* owner = nullptr;
+    FrameProfiler::ThreadBuffer* buffer = nullptr;
+
+    ~FrameProfilerThreadBufferHolder()
+    {
+        if (owner && owner == FrameProfiler::s_frameProfiler.load(std::memory_order_acquire))
+            owner->releaseThreadBuffer(buffer);
+    }
+};
+
+static thread_local FrameProfilerThreadBufferHolder t_threadBuffer;
+
+FrameProfiler* FrameProfiler::getInstance()
+{
+    // zones and thread names may arrive from any thread
+    auto profiler = s_frameProfiler.load(std::memory_order_acquire);
+    if (profiler == nullptr)
+    {
+        static std::mutex instanceMutex;
+        std::lock_guard<std::mutex> lock(instanceMutex);
+        profiler = s_frameProfiler.load(std::memory_order_relaxed);
+        if (profiler == nullptr)
+        {
+            profiler = new (std::nothrow) FrameProfiler();
+            s_frameProfiler.store(profiler, std::memory_order_release);
+        }
+    }
+    return profiler;
+}
+
+void FrameProfiler::destroyInstance()
+{
+    s_capturing = false;
+    delete s_frameProfiler.exchange(nullptr);
+}
+
+void FrameProfiler::startCapture(unsigned int frames, const std::string& path, const CaptureCallback& callback)
+{
+    if (isCapturing())
+        endCapture();
+
+    _captureFrames = frames;
+    _path = path;
+    _callback = callback;
+    _startRequested = true;
+    _stopRequested = false;
+}
+
+void FrameProfiler::stopCapture()
+{
+    if (_startRequested)
+    {
+        _startRequested = false;
+        return;
+    }
+    _stopRequested = isCapturing();
+}
+
+void FrameProfiler::beginFrame()
+{
+    if (isCapturing())
+    {
+        ++_capturedFrames;
+        if (_stopRequested || (_captureFrames > 0 && _capturedFrames >= _captureFrames))
+            endCapture();
+    }
+
+    if (_startRequested)
+    {
+        _startRequested = false;
+        _stopRequested = false;
+        _capturedFrames = 0;
+        _captureBegin.store(Clock::now().time_since_epoch().count(), std::memory_order_relaxed);
+        // the threads reset their buffers when they see a new capture
+        ++_capture;
+        s_capturing.store(true, std::memory_order_release);
+    }
+}
+
+void FrameProfiler::setThreadName(const char* name)
+{
+    auto buffer = getThreadBuffer();
+    std::lock_guard<std::mutex> lock(_threadBuffersMutex);
+    buffer->name = name;
+}
+
+void FrameProfiler::addZone(const char* name, const Clock::time_point& begin, const Clock::time_point& end)
+{
+    // s_capturing is set after the capture is set up
+    if (!s_capturing.load(std::memory_order_acquire))
+        return;
+    unsigned int capture = _capture.load(std::memory_order_relaxed);
+    // started before the capture
+    if (begin.time_since_epoch().count() < _captureBegin.load(std::memory_order_relaxed))
+        return;
+
+    auto buffer = getThreadBuffer();
+    if (buffer->capture.load(std::memory_order_relaxed) != capture)
+    {
+        if (!buffer->zones)
+            buffer->zones.reset(new (std::nothrow) Zone[ZONES_PER_THREAD]);
+        buffer->count.store(0, std::memory_order_relaxed);
+        buffer->dropped.store(0, std::memory_order_relaxed);
+        buffer->capture.store(capture, std::memory_order_release);
+    }
+
+    size_t count = buffer->count.load(std::memory_order_relaxed);
+    if (!buffer->zones || count >= ZONES_PER_THREAD)
+    {
+        buffer->dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    buffer->zones[count] = {name, begin, end};
+    // publishes the zone to the thread writing the trace
+    buffer->count.store(count + 1, std::memory_order_release);
+}
+
+FrameProfiler::ThreadBuffer* FrameProfiler::getThreadBuffer()
+{
+    if (t_threadBuffer.owner != this)
+    {
+        std::lock_guard<std::mutex> lock(_threadBuffersMutex);
+        ThreadBuffer* buffer = nullptr;
+        for (auto& exited : _threadBuffers)
+        {
+            if (exited->thread == std::thread::id())
+            {
+                buffer = exited.get();
+                break;
+            }
+        }
+        if (buffer == nullptr)
+        {
+            _threadBuffers.emplace_back(new ThreadBuffer());
+            buffer = _threadBuffers.back().get();
+            buffer->id = static_cast<unsigned int>(_threadBuffers.size());
+        }
+        buffer->thread = std::this_thread::get_id();
+        t_threadBuffer.buffer = buffer;
+        t_threadBuffer.owner = this;
+    }
+    return t_threadBuffer.buffer;
+}
+
+void FrameProfiler::releaseThreadBuffer(ThreadBuffer* buffer)
+{
+    // the zones and the name stay until the next capture or the next thread
+    std::lock_guard<std::mutex> lock(_threadBuffersMutex);
+    buffer->thread = std::thread::id();
+}
+
+void FrameProfiler::endCapture()
+{
+    s_capturing = false;
+
+    std::string path = _path;
+    if (path.empty())
+    {
+        char name[64];
+        time_t now = time(nullptr);
+        strftime(name, sizeof(name), "trace-%Y%m%d-%H%M%S.json", localtime(&now));
+        path = FileUtils::getInstance()->getWritablePath() + name;
+    }
+
+    if (writeTrace(path))
+    {
+        CCLOG("FrameProfiler: wrote %u frames to %s", _capturedFrames, path.c_str());
+        _lastPath = path;
+    }
+    else
+    {
+        CCLOG("FrameProfiler: failed to write %s", path.c_str());
+        path.clear();
+    }
+
+    auto callback = std::move(_callback);
+    _callback = nullptr;
+    if (callback)
+        callback(path);
+}
+
+static void appendJsonString(std::string& out, const char* str)
+{
+    out += '"';
+    for (; *str; ++str)
+    {
+        if (*str == '"' || *str == '\\')
+            out += '\\';
+        if (static_cast<unsigned char>(*str) >= 0x20)
+            out += *str;
+    }
+    out += '"';
+}
+
+bool FrameProfiler::writeTrace(const std::string& path) const
+{
+    unsigned int capture = _capture.load(std::memory_order_relaxed);
+    Clock::time_point captureBegin(Clock::duration(_captureBegin.load(std::memory_order_relaxed)));
+    std::string trace = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    char buf[128];
+    bool first = true;
+
+    std::lock_guard<std::mutex> lock(_threadBuffersMutex);
+    for (const auto& buffer : _threadBuffers)
+    {
+        if (!buffer->name.empty())
+        {
+            snprintf(buf, sizeof(buf), "%s{\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"name\":\"thread_name\",\"args\":{\"name\":",
+                first ? "" : ",\n", buffer->id);
+            trace += buf;
+            appendJsonString(trace, buffer->name.c_str());
+            trace += "}}";
+            first = false;
+        }
+
+        if (buffer->capture.load(std::memory_order_acquire) != capture)
+            continue;
+
+        // zones added from now on are not part of the trace
+        size_t count = buffer->count.load(std::memory_order_acquire);
+        for (size_t i = 0; i < count; ++i)
+        {
+            const auto& zone = buffer->zones[i];
+            auto begin = std::chrono::duration<double, std::micro>(zone.begin - captureBegin).count();
+            auto duration = std::chrono::duration<double, std::micro>(zone.end - zone.begin).count();
+            snprintf(buf, sizeof(buf), "%s{\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f,\"name\":",
+                first ? "" : ",\n", buffer->id, begin, duration);
+            trace += buf;
+            appendJsonString(trace, zone.name);
+            trace += '}';
+            first = false;
+        }
+
+        size_t dropped = buffer->dropped.load(std::memory_order_relaxed);
+        if (dropped > 0)
+            CCLOG("FrameProfiler: thread %u dropped %u zones, the buffer holds %u", buffer->id,
+                static_cast<unsigned int>(dropped), static_cast<unsigned int>(ZONES_PER_THREAD));
+    }
+    trace += "\n]}\n";
+
+    return FileUtils::getInstance()->writeStringToFile(trace, path);
+}
+
+std::string FrameProfiler::getStatus() const
+{
+    char buf[256];
+    if (isCapturing())
+    {
+        size_t zones = 0;
+        unsigned int capture = _capture.load(std::memory_order_relaxed);
+        {
+            std::lock_guard<std::mutex> lock(_threadBuffersMutex);
+            for (const auto& buffer : _threadBuffers)
+            {
+                if (buffer->capture.load(std::memory_order_relaxed) == capture)
+                    zones += buffer->count.load(std::memory_order_relaxed);
+            }
+        }
+        if (_captureFrames > 0)
+            snprintf(buf, sizeof(buf), "capturing: frame %u of %u, %u zones\n", _capturedFrames, _captureFrames, static_cast<unsigned int>(zones));
+        else
+            snprintf(buf, sizeof(buf), "capturing: frame %u, %u zones\n", _capturedFrames, static_cast<unsigned int>(zones));
+    }
+    else if (_startRequested)
+    {
+        snprintf(buf, sizeof(buf), "capture starts at the next frame\n");
+    }
+    else if (!_lastPath.empty())
+    {
+        snprintf(buf, sizeof(buf), "idle, last trace: %s\n", _lastPath.c_str());
+    }
+    else
+    {
+        snprintf(buf, sizeof(buf), "idle\n");
+    }
+    return buf;
+}
+
+NS_CC_END
+
+#endif // CC_ENABLE_FRAME_PROFILER
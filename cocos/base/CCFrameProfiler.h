@@ -0,0 +1,199 @@
+/****************************************************************************
+Copyright (c) 2020 c4games.com.
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+#pragma once
+
+#include "platform/CCPlatformMacros.h"
+#include "base/ccConfig.h"
+
+#if CC_ENABLE_FRAME_PROFILER
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <functional>
+
+/**
+* @addtogroup base
+* @{
+*/
+NS_CC_BEGIN
+
+/**
+ * @class FrameProfiler
+ * @brief Records the scoped zones of all threads over a range of frames and writes them as a Chrome trace.
+ *
+ * Zones are placed with CC_PROFILE_ZONE(name) and only cost a flag check while no capture is running.
+ * Each thread appends to its own buffer, so recording a zone takes no lock. Nested zones show up as a
+ * hierarchy when the trace is opened in chrome://tracing or https://ui.perfetto.dev.
+ * The class and the macros only exist when CC_ENABLE_FRAME_PROFILER is set in ccConfig.h.
+ * @js NA
+ * @lua NA
+ */
+class CC_DLL FrameProfiler
+{
+public:
+    typedef std::chrono::steady_clock Clock;
+    /** Receives the path of the written trace, or an empty string if it couldn't be written. */
+    typedef std::function<void(const std::string& path)> CaptureCallback;
+
+    /** Maximum number of zones recorded per thread and capture, later zones are dropped. */
+    static const size_t ZONES_PER_THREAD = 65536;
+
+    /**
+     * Returns the shared instance of the frame profiler.
+     */
+    static FrameProfiler* getInstance();
+
+    /**
+     * Destroys the frame profiler, no zone may be recorded anymore.
+     */
+    static void destroyInstance();
+
+    /** Whether a capture is running, zones are only recorded then. */
+    static bool isCapturing() { return s_capturing.load(std::memory_order_relaxed); }
+
+    /**
+     * Starts a capture at the next frame. A running capture is ended first.
+     *
+     * @param frames The number of frames to capture, 0 captures until stopCapture() is called.
+     * @param path The file the trace is written to, empty for "trace-<time>.json" in the writable path.
+     * @param callback Called on the cocos thread once the trace is written.
+     */
+    void startCapture(unsigned int frames, const std::string& path = "", const CaptureCallback& callback = nullptr);
+
+    /** Ends the capture at the start of the next frame and writes the trace. */
+    void stopCapture();
+
+    /** Marks the start of a frame, starts and ends the captures. Called by Director::drawScene(). */
+    void beginFrame();
+
+    /** Names the calling thread in the trace. */
+    void setThreadName(const char* name);
+
+    /**
+     * Records a zone of the calling thread.
+     * @param name The zone name, it must stay valid until the trace is written, usually a string literal.
+     */
+    void addZone(const char* name, const Clock::time_point& begin, const Clock::time_point& end);
+
+    /** Describes the running or the last capture. */
+    std::string getStatus() const;
+
+protected:
+    struct Zone
+    {
+        const char* name;
+        Clock::time_point begin;
+        Clock::time_point end;
+    };
+
+    // Written by its thread only, read by the cocos thread when the capture ends.
+    struct ThreadBuffer
+    {
+        unsigned int id = 0;
+        // none once the thread exited, the next new thread then takes over the buffer
+        std::thread::id thread;
+        std::string name;
+        std::unique_ptr<Zone[]> zones;
+        std::atomic<size_t> count{0};
+        std::atomic<size_t> dropped{0};
+        std::atomic<unsigned int> capture{0};
+    };
+
+    FrameProfiler() = default;
+    ~FrameProfiler() = default;
+
+    friend struct FrameProfilerThreadBufferHolder;
+
+    ThreadBuffer* getThreadBuffer();
+    void releaseThreadBuffer(ThreadBuffer* buffer);
+    void endCapture();
+    bool writeTrace(const std::string& path) const;
+
+    // guards _threadBuffers, taken once per thread
+    mutable std::mutex _threadBuffersMutex;
+    std::vector<std::unique_ptr<ThreadBuffer>> _threadBuffers;
+
+    std::atomic<unsigned int> _capture{0};
+    // the time since the clock's epoch, read by all threads recording zones
+    std::atomic<Clock::rep> _captureBegin{0};
+    unsigned int _captureFrames = 0;
+    unsigned int _capturedFrames = 0;
+    bool _startRequested = false;
+    bool _stopRequested = false;
+    std::string _path;
+    std::string _lastPath;
+    CaptureCallback _callback;
+
+    static std::atomic<bool> s_capturing;
+    static std::atomic<FrameProfiler*> s_frameProfiler;
+};
+
+/** Records the enclosing scope as a zone while the FrameProfiler captures, see CC_PROFILE_ZONE(). */
+class FrameProfilerZone
+{
+public:
+    explicit FrameProfilerZone(const char* name)
+    : _name(FrameProfiler::isCapturing() ? name : nullptr)
+    {
+        if (_name)
+            _begin = FrameProfiler::Clock::now();
+    }
+
+    ~FrameProfilerZone()
+    {
+        if (_name)
+            FrameProfiler::getInstance()->addZone(_name, _begin, FrameProfiler::Clock::now());
+    }
+
+private:
+    const char* _name;
+    FrameProfiler::Clock::time_point _begin;
+};
+
+NS_CC_END
+// end group
+/// @}
+
+#define CC_PROFILE_CONCAT_(__a__, __b__) __a__##__b__
+#define CC_PROFILE_CONCAT(__a__, __b__) CC_PROFILE_CONCAT_(__a__, __b__)
+
+/** Records the rest of the enclosing scope as a zone named __name__, a string literal. */
+#define CC_PROFILE_ZONE(__name__) NS_CC::FrameProfilerZone CC_PROFILE_CONCAT(__ccProfileZone, __LINE__)(__name__)
+/** Names the calling thread in the trace. */
+#define CC_PROFILE_THREAD(__name__) NS_CC::FrameProfiler::getInstance()->setThreadName(__name__)
+/** Marks the start of a frame. */
+#define CC_PROFILE_FRAME() NS_CC::FrameProfiler::getInstance()->beginFrame()
+
+#else
+
+#define CC_PROFILE_ZONE(__name__) do {} while (0)
+#define CC_PROFILE_THREAD(__name__) do {} while (0)
+#define CC_PROFILE_FRAME() do {} while (0)
+
+#endif // CC_ENABLE_FRAME_PROFILER
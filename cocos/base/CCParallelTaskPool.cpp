@@ -0,0 +1,206 @@
+/****************************************************************************
+Copyright (c) 2020 c4games.com.
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#include "base/CCParallelTaskPool.h"
+#include "base/CCFrameProfiler.h"
+#include <algorithm>
+
+NS_CC_BEGIN
+
+// Each thread gets a few ranges so that a slow thread doesn't hold the whole job back.
+static const size_t RANGES_PER_THREAD = 4;
+
+std::atomic<ParallelTaskPool*> ParallelTaskPool::s_parallelTaskPool(nullptr);
+static std::once_flag s_parallelTaskPoolOnce;
+
+ParallelTaskPool* ParallelTaskPool::getInstance()
+{
+    // The renderer and the texture loader threads may ask for it at the same time.
+    std::call_once(s_parallelTaskPoolOnce, [] {
+        s_parallelTaskPool = new ParallelTaskPool();
+    });
+    return s_parallelTaskPool;
+}
+
+void ParallelTaskPool::destroyInstance()
+{
+    // The instance is never deleted: a loader thread may have got it and not have started its job yet.
+    auto pool = s_parallelTaskPool.load();
+    if (pool != nullptr)
+    {
+        std::lock_guard<std::mutex> jobLock(pool->_jobMutex);
+        pool->stopWorkers();
+    }
+}
+
+ParallelTaskPool::ParallelTaskPool(int workers)
+: _nextRange(0)
+, _doneRanges(0)
+{
+    if (workers < 0)
+    {
+        // hardware_concurrency() may return 0 when it can't be detected
+        workers = std::max(static_cast<int>(std::thread::hardware_concurrency()) - 1, 1);
+    }
+    _workerCount = workers;
+
+    startWorkers();
+}
+
+ParallelTaskPool::~ParallelTaskPool()
+{
+    std::lock_guard<std::mutex> jobLock(_jobMutex);
+    stopWorkers();
+}
+
+void ParallelTaskPool::startWorkers()
+{
+    {
+        std::unique_lock<std::mutex> lk(_queueMutex);
+        _stop = false;
+    }
+
+    for (int index = 0; index < _workerCount; ++index)
+    {
+        _workers.emplace_back(std::thread(std::bind(&ParallelTaskPool::threadFunc, this)));
+    }
+}
+
+void ParallelTaskPool::stopWorkers()
+{
+    {
+        std::unique_lock<std::mutex> lk(_queueMutex);
+        _stop = true;
+    }
+    _taskCondition.notify_all();
+
+    for (auto&& worker : _workers)
+    {
+        worker.join();
+    }
+    _workers.clear();
+}
+
+void ParallelTaskPool::parallelFor(size_t count, size_t grain, const RangeTask& task, int maxThreads)
+{
+    if (count == 0)
+        return;
+
+    grain = std::max<size_t>(grain, 1);
+    int threads = getThreadCount();
+    if (maxThreads > 0)
+        threads = std::min(threads, maxThreads);
+
+    // Not worth waking anyone up, or the pool is busy with a job of another thread (or of this one).
+    if (threads <= 1 || count <= grain || !_jobMutex.try_lock())
+    {
+        task(0, count);
+        return;
+    }
+    std::lock_guard<std::mutex> jobLock(_jobMutex, std::adopt_lock);
+
+    // the workers were stopped by destroyInstance()
+    if (_workers.empty())
+        startWorkers();
+
+    size_t rangeSize = std::max(grain, (count + threads * RANGES_PER_THREAD - 1) / (threads * RANGES_PER_THREAD));
+    size_t rangeCount = (count + rangeSize - 1) / rangeSize;
+
+    {
+        std::unique_lock<std::mutex> lk(_queueMutex);
+        _task = &task;
+        _count = count;
+        _rangeSize = rangeSize;
+        _rangeCount = rangeCount;
+        _maxHelpers = static_cast<int>(std::min<size_t>(threads - 1, rangeCount - 1));
+        _nextRange = 0;
+        _doneRanges = 0;
+        ++_generation;
+    }
+    _taskCondition.notify_all();
+
+    runRanges(&task, count, rangeSize, rangeCount);
+
+    // The job description lives on this stack frame, so wait for every helper to leave as well.
+    std::unique_lock<std::mutex> lk(_queueMutex);
+    _doneCondition.wait(lk, [this]{ return _doneRanges == _rangeCount && _helpers == 0; });
+    _task = nullptr;
+    _maxHelpers = 0;
+}
+
+void ParallelTaskPool::runRanges(const RangeTask* task, size_t count, size_t rangeSize, size_t rangeCount)
+{
+    for (;;)
+    {
+        size_t range = _nextRange++;
+        if (range >= rangeCount)
+            break;
+
+        size_t begin = range * rangeSize;
+        (*task)(begin, std::min(begin + rangeSize, count));
+        ++_doneRanges;
+    }
+}
+
+void ParallelTaskPool::threadFunc()
+{
+    CC_PROFILE_THREAD("ParallelTaskPool");
+    unsigned int generation = 0;
+    while (true)
+    {
+        const RangeTask* task = nullptr;
+        size_t count, rangeSize, rangeCount;
+        {
+            std::unique_lock<std::mutex> lk(_queueMutex);
+            _taskCondition.wait(lk, [&]{ return _stop || generation != _generation; });
+            if (_stop)
+            {
+                break;
+            }
+
+            generation = _generation;
+            if (_task == nullptr || _helpers >= _maxHelpers)
+                continue;
+
+            ++_helpers;
+            task = _task;
+            count = _count;
+            rangeSize = _rangeSize;
+            rangeCount = _rangeCount;
+        }
+
+        {
+            CC_PROFILE_ZONE("ParallelTaskPool::job");
+            runRanges(task, count, rangeSize, rangeCount);
+        }
+
+        {
+            std::unique_lock<std::mutex> lk(_queueMutex);
+            --_helpers;
+        }
+        _doneCondition.notify_one();
+    }
+}
+
+NS_CC_END
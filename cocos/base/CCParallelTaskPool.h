@@ -0,0 +1,124 @@
+/****************************************************************************
+Copyright (c) 2020 c4games.com.
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+#pragma once
+
+#include "platform/CCPlatformMacros.h"
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+
+/**
+* @addtogroup base
+* @{
+*/
+NS_CC_BEGIN
+
+/**
+ * @class ParallelTaskPool
+ * @brief Runs data parallel work, like filling vertex buffers or converting pixels, on a fixed set of worker threads.
+ *
+ * Unlike AsyncTaskPool the caller is blocked until the work is done, and it takes part in the work itself.
+ * @js NA
+ */
+class CC_DLL ParallelTaskPool
+{
+public:
+    /** Processes the items in [begin, end). */
+    typedef std::function<void(size_t begin, size_t end)> RangeTask;
+
+    /**
+     * Returns the shared instance of the parallel task pool, it may be called from any thread.
+     */
+    static ParallelTaskPool* getInstance();
+
+    /**
+     * Joins the worker threads of the shared instance once the job being run is done.
+     * The instance itself is kept, since loader threads may be about to use it, and the next job starts the threads again.
+     */
+    static void destroyInstance();
+
+    /**
+     * Get the number of threads which can take part in a job, including the calling thread.
+     */
+    int getThreadCount() const { return _workerCount + 1; }
+
+    /**
+     * Splits [0, count) into ranges of at least grain items and runs them on the calling thread
+     * and the worker threads, returns when all of them are done.
+     * Nested calls, and calls made while another thread owns the pool, run on the calling thread.
+     *
+     * @param count The number of items.
+     * @param grain The minimum number of items processed by one task invocation.
+     * @param task The task to run for every range.
+     * @param maxThreads Upper limit of threads to use including the calling one, 0 means all of them.
+     * @lua NA
+     */
+    void parallelFor(size_t count, size_t grain, const RangeTask& task, int maxThreads = 0);
+
+CC_CONSTRUCTOR_ACCESS:
+    /**
+     * @param workers Number of worker threads, a negative value picks one less than the hardware concurrency.
+     */
+    explicit ParallelTaskPool(int workers = -1);
+    ~ParallelTaskPool();
+
+protected:
+    void threadFunc();
+    // both are called with _jobMutex locked
+    void startWorkers();
+    void stopWorkers();
+    void runRanges(const RangeTask* task, size_t count, size_t rangeSize, size_t rangeCount);
+
+    std::vector<std::thread> _workers;
+    int _workerCount;
+
+    // serializes jobs, only one job uses the workers at a time
+    std::mutex _jobMutex;
+
+    // guards the job description below
+    std::mutex _queueMutex;
+    std::condition_variable _taskCondition;
+    std::condition_variable _doneCondition;
+
+    const RangeTask* _task = nullptr;
+    size_t _count = 0;
+    size_t _rangeSize = 0;
+    size_t _rangeCount = 0;
+    int _maxHelpers = 0;
+    int _helpers = 0;
+    unsigned int _generation = 0;
+    bool _stop = false;
+
+    std::atomic<size_t> _nextRange;
+    std::atomic<size_t> _doneRanges;
+
+    static std::atomic<ParallelTaskPool*> s_parallelTaskPool;
+};
+
+NS_CC_END
+// end group
+/// @}
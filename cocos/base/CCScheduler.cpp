@@ -32,6 +32,7 @@ THE SOFTWARE.
 #include "base/utlist.h"
 #include "base/ccCArray.h"
 #include "base/CCScriptSupport.h"
+#include "base/CCFrameProfiler.h"
 
 NS_CC_BEGIN
 
@@ -822,6 +823,7 @@ void Scheduler::removeAllFunctionsToBePerformedInCocosThread()
 // main loop
 void Scheduler::update(float dt)
 {
+    CC_PROFILE_ZONE("Scheduler::update");
     _updateHashLocked = true;
 
     if (_timeScale != 1.0f)
@@ -33,6 +33,9 @@ THE SOFTWARE.
 #endif
 #include <fcntl.h>
 #include <sys/stat.h>
+#include <thread>
+#include <atomic>
+#include <vector>
 
 #include "openssl/aes.h"
 #include "openssl/modes.h"
@@ -43,6 +46,8 @@ THE SOFTWARE.
 #include "pugixml/pugixml_imp.hpp"
 #include "base/base64.h"
 #include "base/ccUtils.h"
+#include "base/CCDirector.h"
+#include "base/CCScheduler.h"
 
 #include "yasio/ibstream.hpp"
 #include "yasio/obstream.hpp"
@@ -59,6 +64,8 @@ THE SOFTWARE.
 #define posix_write ::_write
 #define posix_fd2fh(fd) reinterpret_cast<HANDLE>(_get_osfhandle(fd))
 #define posix_fsetsize(fd, size) ::_chsize(fd, size)
+#define posix_fsync ::_commit
+#define posix_replace(from, to) (MoveFileExA(from, to, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != FALSE)
 #else
 #define O_READ_FLAGS O_RDONLY, S_IRUSR
 #define O_WRITE_FLAGS O_CREAT | O_RDWR, S_IRWXU
@@ -70,6 +77,8 @@ THE SOFTWARE.
 #define posix_write ::write
 #define posix_fd2fh(fd) (fd)
 #define posix_fsetsize(fd, size) ::ftruncate(fd, size), ::lseek(fd, 0, SEEK_SET)
+#define posix_fsync ::fsync
+#define posix_replace(from, to) (::rename(from, to) == 0)
 #endif
 
 #define USER_DEFAULT_PLAIN_MODE 0
@@ -82,6 +91,9 @@ THE SOFTWARE.
 
 typedef int32_t udflen_t;
 
+// Compacting starts when the file is this big and stale entries take more than half of it.
+#define USER_DEFAULT_COMPACTION_MIN_SIZE (64 * 1024)
+
 NS_CC_BEGIN
 
 /**
@@ -113,6 +125,57 @@ static void ud_write_v_s(yasio::obstream& obs, const cxx17::string_view value)
         UserDefault::encrypt(obs.wptr(valpos + sizeof(int32_t)), obs.length() - valpos - sizeof(int32_t), AES_ENCRYPT);
 }
 
+static void ud_write_entry(yasio::obstream& obs, const cxx17::string_view key, const cxx17::string_view value, bool encrypted)
+{
+    if (encrypted)
+    {
+        ud_write_v_s(obs, key);
+        ud_write_v_s(obs, value);
+    }
+    else {
+        obs.write_v(key);
+        obs.write_v(value);
+    }
+}
+
+// the size of an entry in the file, encrypting doesn't change it
+static int ud_entry_size(const std::string& key, const std::string& value)
+{
+    return static_cast<int>(2 * sizeof(int32_t) + key.size() + value.size());
+}
+
+static bool ud_write_all(int fd, const char* data, size_t size)
+{
+    while (size > 0) {
+        auto written = posix_write(fd, data, static_cast<unsigned int>(size));
+        if (written <= 0)
+            return false;
+        data += written;
+        size -= written;
+    }
+    return true;
+}
+
+struct UserDefault::Compaction
+{
+    std::thread thread;
+    std::atomic<bool> done{ false };
+
+    // input, the values when it started, the main thread copies them before changing any
+    std::shared_ptr<const ValueMap> values;
+    bool encrypted = false;
+    std::string path;
+
+    // output, the compacted file at path
+    bool succeeded = false;
+    int realSize = 0;
+    int mapSize = 0;
+
+    // the entries appended to the old file meanwhile, they're carried over before the swap
+    std::string tail;
+    int tailCount = 0;
+};
+
 void UserDefault::setEncryptEnabled(bool enabled, const cxx17::string_view& key, const cxx17::string_view& iv)
 {
     _encryptEnabled = enabled;
@@ -144,6 +207,10 @@ void UserDefault::encrypt(char* inout, size_t size, int enc)
 
 UserDefault::~UserDefault()
 {
+    // nothing may be scheduled anymore, so the last commit and compaction are done in place
+    _writeBatching = false;
+    commitPendingWrites();
+    finishCompaction(true);
     closeFileMapping();
 }
 
@@ -167,8 +234,8 @@ bool UserDefault::getBoolForKey(const char* pKey)
 
 bool UserDefault::getBoolForKey(const char* pKey, bool defaultValue)
 {
-    auto it = this->_values.find(pKey);
-    if (it != this->_values.end())
+    auto it = _values->find(pKey);
+    if (it != _values->end())
         return it->second == "1";
 
     return defaultValue;
@@ -181,8 +248,8 @@ int UserDefault::getIntegerForKey(const char* pKey)
 
 int UserDefault::getIntegerForKey(const char* pKey, int defaultValue)
 {
-    auto it = this->_values.find(pKey);
-    if (it != this->_values.end())
+    auto it = _values->find(pKey);
+    if (it != _values->end())
         return atoi(it->second.c_str());
 
     return defaultValue;
@@ -207,8 +274,8 @@ double  UserDefault::getDoubleForKey(const char* pKey)
 
 double UserDefault::getDoubleForKey(const char* pKey, double defaultValue)
 {
-    auto it = this->_values.find(pKey);
-    if (it != this->_values.end())
+    auto it = _values->find(pKey);
+    if (it != _values->end())
         return utils::atof(it->second.c_str());
 
     return defaultValue;
@@ -221,8 +288,8 @@ std::string UserDefault::getStringForKey(const char* pKey)
 
 std::string UserDefault::getStringForKey(const char* pKey, const std::string & defaultValue)
 {
-    auto it = this->_values.find(pKey);
-    if (it != this->_values.end())
+    auto it = _values->find(pKey);
+    if (it != _values->end())
         return it->second;
 
     return defaultValue;
@@ -281,44 +348,247 @@ void UserDefault::setStringForKey(const char* pKey, const std::string & value)
 
     setValueForKey(pKey, value);
 
+    if (_writeBatching) {
+        // only the latest value of a key is written at the end of the frame
+        _pendingKeys.emplace(pKey);
+        scheduleCommit();
+        return;
+    }
+
 #if !USER_DEFAULT_PLAIN_MODE
     if (_rwmmap) {
         yasio::obstream obs;
-        if (_encryptEnabled)
-        {
-            ud_write_v_s(obs, pKey);
-            ud_write_v_s(obs, value);
-        }
-        else {
-            obs.write_v(pKey);
-            obs.write_v(value);
-        }
-
-        if ((_realSize + obs.length() + sizeof(udflen_t)) < _curMapSize)
-        {
-            // increase entities count
-            yasio::obstream::swrite_i(_rwmmap->data(), 1 + yasio::ibstream::sread_i<udflen_t>(_rwmmap->data()));
-
-            // append entity
-            ::memcpy(_rwmmap->data() + sizeof(udflen_t) + _realSize, obs.data(), obs.length());
-            _realSize += obs.length();
-        }
-        else {
-            flush();
-        }
+        ud_write_entry(obs, pKey, value, _encryptEnabled);
+        appendEntries(obs.data(), static_cast<int>(obs.length()), 1);
     }
 #else
     flush();
 #endif
 }
 
+UserDefault::ValueMap& UserDefault::editValues()
+{
+    // the running compaction reads the values of when it started, they are copied on the first change instead
+    if (_values.use_count() > 1)
+        _values = std::make_shared<ValueMap>(*_values);
+    return *_values;
+}
+
 void UserDefault::setValueForKey(const std::string& key, const std::string& value)
 {
-    auto it = _values.find(key);
-    if (it != _values.end())
+    auto& values = editValues();
+    auto it = values.find(key);
+    if (it != values.end()) {
+        _liveSize += static_cast<int>(value.size()) - static_cast<int>(it->second.size());
         it->second = value;
-    else
-        _values.emplace(key, value);
+    }
+    else {
+        _liveSize += ud_entry_size(key, value);
+        values.emplace(key, value);
+    }
+}
+
+void UserDefault::setWriteBatchingEnabled(bool enabled)
+{
+    if (!enabled)
+        commitPendingWrites();
+    _writeBatching = enabled;
+}
+
+void UserDefault::scheduleCommit()
+{
+    if (_commitScheduled)
+        return;
+
+    _commitScheduled = true;
+    Director::getInstance()->getScheduler()->performFunctionInCocosThread([]() {
+        if (_userDefault)
+            _userDefault->commitPendingWrites();
+    });
+}
+
+void UserDefault::commitPendingWrites()
+{
+    _commitScheduled = false;
+#if !USER_DEFAULT_PLAIN_MODE
+    if (!_pendingKeys.empty() && _rwmmap) {
+        yasio::obstream obs;
+        int count = 0;
+        for (auto& key : _pendingKeys) {
+            auto it = _values->find(key);
+            if (it != _values->end()) {
+                ud_write_entry(obs, it->first, it->second, _encryptEnabled);
+                ++count;
+            }
+        }
+        if (count > 0)
+            appendEntries(obs.data(), static_cast<int>(obs.length()), count);
+    }
+    _pendingKeys.clear();
+
+    updateCompaction();
+    // keep polling the compaction from the frames, so the new file is swapped in soon after it is written
+    if (_compaction && _writeBatching)
+        scheduleCommit();
+#else
+    if (!_pendingKeys.empty()) {
+        _pendingKeys.clear();
+        flush();
+    }
+#endif
+}
+
+void UserDefault::appendEntries(const char* entries, int size, int count)
+{
+    int requiredSize = static_cast<int>(sizeof(udflen_t)) + _realSize + size;
+    if (requiredSize > _curMapSize && !growFileMapping(requiredSize))
+        return;
+
+    ::memcpy(_rwmmap->data() + sizeof(udflen_t) + _realSize, entries, size);
+    // the count is updated last, a crash in between leaves the new entries out instead of half written
+    yasio::obstream::swrite_i(_rwmmap->data(), count + yasio::ibstream::sread_i<udflen_t>(_rwmmap->data()));
+    _realSize += size;
+
+    if (_compaction) {
+        _compaction->tail.append(entries, size);
+        _compaction->tailCount += count;
+    }
+    updateCompaction();
+}
+
+bool UserDefault::growFileMapping(int requiredSize)
+{
+    // double the size, so that appending stays cheap however big the file gets
+    int mapSize = _curMapSize;
+    while (mapSize < requiredSize)
+        mapSize <<= 1;
+
+    std::error_code error;
+    _rwmmap->unmap();
+    posix_fsetsize(_fd, mapSize);
+    _rwmmap->map(posix_fd2fh(_fd), 0, mapSize, error);
+    if (error || !_rwmmap->is_mapped()) {
+        // the entries written so far are still valid, but nothing is persisted from now on
+        log("[Warnning] UserDefault: growing the file mapping of '%s' failed!", _filePath.c_str());
+        closeFileMapping();
+        return false;
+    }
+
+    _curMapSize = mapSize;
+    return true;
+}
+
+void UserDefault::updateCompaction()
+{
+    finishCompaction(false);
+    if (_compaction || !_rwmmap)
+        return;
+
+    if (_compactionNeeded || (_realSize > USER_DEFAULT_COMPACTION_MIN_SIZE && _realSize > 2 * _liveSize && _realSize > _compactionSize))
+        startCompaction();
+}
+
+void UserDefault::startCompaction()
+{
+    if (_compaction) {
+        // the running one has a copy of the values from before
+        _compactionNeeded = true;
+        return;
+    }
+
+    _compactionNeeded = false;
+    _compaction.reset(new Compaction());
+    _compaction->values = _values;
+    _compaction->encrypted = _encryptEnabled;
+    _compaction->path = _filePath + ".tmp";
+    _compaction->thread = std::thread(&UserDefault::runCompaction, _compaction.get());
+}
+
+void UserDefault::runCompaction(Compaction* compaction)
+{
+    yasio::obstream obs;
+    obs.write_i<int>(static_cast<int>(compaction->values->size()));
+    for (auto& item : *compaction->values)
+        ud_write_entry(obs, item.first, item.second, compaction->encrypted);
+
+    int mapSize = 4096;
+    while (mapSize < 2 * static_cast<int>(obs.length()))
+        mapSize <<= 1;
+
+    int fd = posix_open(compaction->path.c_str(), O_TRUNC | O_WRITE_FLAGS);
+    if (fd != -1) {
+        compaction->succeeded = ud_write_all(fd, obs.data(), obs.length());
+        posix_fsetsize(fd, mapSize);
+        compaction->succeeded = compaction->succeeded && posix_fsync(fd) == 0;
+        posix_close(fd);
+    }
+
+    compaction->realSize = static_cast<int>(obs.length() - sizeof(udflen_t));
+    compaction->mapSize = mapSize;
+    compaction->done = true;
+}
+
+void UserDefault::finishCompaction(bool wait)
+{
+    if (!_compaction || (!wait && !_compaction->done))
+        return;
+
+    _compaction->thread.join();
+    std::unique_ptr<Compaction> compaction = std::move(_compaction);
+    const char* path = compaction->path.c_str();
+
+    bool succeeded = compaction->succeeded;
+    int realSize = compaction->realSize;
+    int mapSize = compaction->mapSize;
+    if (succeeded && !compaction->tail.empty()) {
+        int fd = posix_open(path, O_WRITE_FLAGS);
+        succeeded = fd != -1;
+        if (succeeded) {
+            while (mapSize < static_cast<int>(sizeof(udflen_t)) + realSize + static_cast<int>(compaction->tail.size()))
+                mapSize <<= 1;
+            posix_fsetsize(fd, mapSize);
+
+            char count[sizeof(udflen_t)];
+            yasio::obstream::swrite_i(count, static_cast<int>(compaction->values->size()) + compaction->tailCount);
+            succeeded = posix_lseek(fd, sizeof(udflen_t) + realSize, SEEK_SET) != -1
+                && ud_write_all(fd, compaction->tail.data(), compaction->tail.size())
+                && posix_lseek(fd, 0, SEEK_SET) != -1
+                && ud_write_all(fd, count, sizeof(count))
+                && posix_fsync(fd) == 0;
+            posix_close(fd);
+            realSize += static_cast<int>(compaction->tail.size());
+        }
+    }
+
+    // the old file has to be closed before it can be replaced on windows
+    if (succeeded) {
+        closeFileMapping();
+        succeeded = posix_replace(path, _filePath.c_str());
+    }
+    if (!succeeded) {
+        log("[Warnning] UserDefault: compacting '%s' failed!", _filePath.c_str());
+        ::remove(path);
+        // retry once the file has grown a good deal more
+        _compactionSize = _realSize * 2;
+        if (_rwmmap)
+            return;
+        realSize = _realSize;
+        mapSize = _curMapSize;
+    }
+
+    std::error_code error;
+    _fd = posix_open(_filePath.c_str(), O_WRITE_FLAGS);
+    if (_fd != -1) {
+        _rwmmap = std::make_shared<mio::mmap_sink>();
+        _rwmmap->map(posix_fd2fh(_fd), 0, mapSize, error);
+    }
+    if (_fd == -1 || error || !_rwmmap->is_mapped()) {
+        log("[Warnning] UserDefault: mapping '%s' failed, we can't save data persisit this time!", _filePath.c_str());
+        closeFileMapping();
+        return;
+    }
+    _realSize = realSize;
+    _curMapSize = mapSize;
 }
 
 UserDefault* UserDefault::getInstance()
@@ -352,6 +622,9 @@ void UserDefault::init()
         _filePath = FileUtils::getInstance()->getWritablePath() + USER_DEFAULT_FILENAME;
 
 #if !USER_DEFAULT_PLAIN_MODE
+        // left over by a compaction which didn't finish, the file itself is complete
+        ::remove((_filePath + ".tmp").c_str());
+
         // construct file mapping
         _fd = posix_open(_filePath.c_str(), O_WRITE_FLAGS);
         if (_fd == -1) {
@@ -374,17 +647,27 @@ void UserDefault::init()
                 if (ibs.length() > 0) {
                     // read count of keyvals.
                     int count = ibs.read_i<int>();
-                    for (auto i = 0; i < count; ++i) {
-                        std::string key(ibs.read_v());
-                        std::string value(ibs.read_v());
-                        if (_encryptEnabled)
-                        {
-                            UserDefault::encrypt(key, AES_DECRYPT);
-                            UserDefault::encrypt(value, AES_DECRYPT);
+                    int loaded = 0;
+                    _realSize = 0;
+                    try {
+                        for (; loaded < count; ++loaded) {
+                            std::string key(ibs.read_v());
+                            std::string value(ibs.read_v());
+                            if (_encryptEnabled)
+                            {
+                                UserDefault::encrypt(key, AES_DECRYPT);
+                                UserDefault::encrypt(value, AES_DECRYPT);
+                            }
+                            setValueForKey(key, value);
+                            _realSize = ibs.seek(0, SEEK_CUR) - sizeof(udflen_t);
                         }
-                        setValueForKey(key, value);
                     }
-                    _realSize = ibs.seek(0, SEEK_CUR) - sizeof(udflen_t);
+                    catch (const std::exception&) {
+                        // a damaged count, keep the entries which are complete and append after them
+                        log("[Warnning] UserDefault::init '%s' has %d entries instead of %d!", _filePath.c_str(), loaded, count);
+                        yasio::obstream::swrite_i(_rwmmap->data(), loaded);
+                    }
+                    _curMapSize = static_cast<int>(_rwmmap->length());
                 }
             }
             else {
@@ -412,46 +695,21 @@ void UserDefault::init()
 void UserDefault::flush()
 {
 #if !USER_DEFAULT_PLAIN_MODE
-    if (_rwmmap) {
-        yasio::obstream obs;
-        obs.write_i<int>(static_cast<int>(this->_values.size()));
-        for (auto& item : this->_values) {
-            if (_encryptEnabled)
-            {
-                ud_write_v_s(obs, item.first);
-                ud_write_v_s(obs, item.second);
-            }
-            else {
-                obs.write_v(item.first);
-                obs.write_v(item.second);
-            }
-        }
-
-        std::error_code error;
-        if (obs.length() > _curMapSize) {
-            _rwmmap->unmap();
-            _curMapSize <<= 1; // X2
-            posix_fsetsize(_fd, _curMapSize);
-            _rwmmap->map(posix_fd2fh(_fd), 0, _curMapSize, error);
-        }
-
-        if (!error && _rwmmap->is_mapped())
-        { // mapping status is good
-            ::memcpy(_rwmmap->data(), obs.data(), obs.length());
-            _realSize = obs.length() - sizeof(udflen_t);
-        }
-        else {
-            // close file mapping and do a simple workaround fix to don't do persist later at this time
-            closeFileMapping();
-            ::remove(_filePath.c_str());
-        }
+    // every write is in the file mapping already, unless it was batched
+    commitPendingWrites();
+    finishCompaction(true);
+    if (_compactionNeeded) {
+        startCompaction();
+        finishCompaction(true);
     }
 #else
+    _pendingKeys.clear();
+
     pugi::xml_document doc;
     doc.load_string(R"(<?xml version="1.0" ?>
 <r />)");
     auto r = doc.document_element();
-    for(auto& kv : _values)
+    for(auto& kv : *_values)
         r.append_child(kv.first.c_str())
         .append_child(pugi::xml_node_type::node_pcdata)
         .set_value(kv.second.c_str());
@@ -461,8 +719,24 @@ void UserDefault::flush()
 
 void UserDefault::deleteValueForKey(const char* key)
 {
-    if(this->_values.erase(key) > 0)
-        flush();
+    auto it = _values->find(key);
+    if (it == _values->end())
+        return;
+
+    _liveSize -= ud_entry_size(it->first, it->second);
+    _pendingKeys.erase(it->first);
+    editValues().erase(key);
+
+#if !USER_DEFAULT_PLAIN_MODE
+    // entries can't be removed from the file, it is compacted without them in the background instead
+    _compactionNeeded = true;
+    if (_writeBatching)
+        scheduleCommit();
+    else
+        updateCompaction();
+#else
+    flush();
+#endif
 }
 
 NS_CC_END
@@ -31,6 +31,8 @@ THE SOFTWARE.
 #include <string>
 
 #include <unordered_map>
+#include <unordered_set>
+#include <memory>
 #include "mio/mio.hpp"
 #include "yasio/cxx17/string_view.hpp"
 
@@ -183,16 +185,28 @@ public:
 
     /**
      * You should invoke this function to save values set by setXXXForKey().
+     * It writes the batched changes and waits for a running compaction of the file.
      * @js NA
      */
     virtual void flush();
 
     /**
     * delete any value by key,
+    * The file is compacted without it in the background, the new file replaces the old one
+    * at the next write, flush() or exit.
     * @param key The key to delete value.
     * @js NA
     */
     virtual void deleteValueForKey(const char* key);
+
+    /**
+     * Batches the writes of a frame: setXXXForKey() only changes the value in memory, and the latest values
+     * of the keys changed during the frame are appended to the file once, at the beginning of the next frame.
+     * flush() writes them right away. It needs a running Director.
+     * @js NA
+     */
+    void setWriteBatchingEnabled(bool enabled);
+    bool isWriteBatchingEnabled() const { return _writeBatching; }
     
     /** Returns the singleton.
      * @js NA
@@ -234,10 +248,33 @@ protected:
 
     void closeFileMapping();
 
+    using ValueMap = std::unordered_map<std::string, std::string>;
+    /** Returns the values to change them, a running compaction keeps reading the ones of when it started. */
+    ValueMap& editValues();
     void setValueForKey(const std::string& key, const std::string& value);
+
+    /** Appends the entries of the keys changed since the last commit, see setWriteBatchingEnabled(). */
+    void commitPendingWrites();
+    void scheduleCommit();
+
+    /**
+     * The file is a log: every write appends an entry, the count at its beginning is updated last.
+     * Once stale entries take most of it, or values were deleted, a background thread writes the current
+     * values to a new file which then replaces the old one, so a crash leaves either of them intact.
+     */
+    void appendEntries(const char* entries, int size, int count);
+    bool growFileMapping(int requiredSize);
+    void updateCompaction();
+    void startCompaction();
+    /** Swaps the compacted file in once it is written, or right away after waiting for it. */
+    void finishCompaction(bool wait);
+
+    struct Compaction;
+    static void runCompaction(Compaction* compaction);
 private:
 
-    std::unordered_map<std::string, std::string> _values;
+    // shared with a running compaction, see editValues()
+    std::shared_ptr<ValueMap> _values = std::make_shared<ValueMap>();
     
     static UserDefault* _userDefault;
     std::string _filePath;
@@ -245,8 +282,17 @@ private:
     std::shared_ptr<mio::mmap_sink> _rwmmap;
     int _curMapSize = 4096; // init mapsize is 4K
     int _realSize = 0; // real data size without key/value entities count field
+    int _liveSize = 0; // the size the entries of _values take in the file
     bool _initialized = false;
 
+    bool _writeBatching = false;
+    bool _commitScheduled = false;
+    std::unordered_set<std::string> _pendingKeys;
+
+    std::unique_ptr<Compaction> _compaction;
+    bool _compactionNeeded = false; // values were deleted
+    int _compactionSize = 0; // don't compact again before the file grows past this after a failure
+
     // cfb128 encrpyt args
     static bool _encryptEnabled;
     static std::string _key;
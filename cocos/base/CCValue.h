@@ -85,6 +85,8 @@ public:
     
     /** Create a Value by a string. */
     explicit Value(const std::string& v);
+    /** Create a Value by moving a string. */
+    explicit Value(std::string&& v);
     
     /** Create a Value by a ValueVector object. */
     explicit Value(const ValueVector& v);
@@ -130,6 +132,8 @@ public:
     Value& operator= (const char* v);
     /** Assignment operator, assign from string to Value. */
     Value& operator= (const std::string& v);
+    /** Assignment operator, assign from string to Value. It will use std::move internally. */
+    Value& operator= (std::string&& v);
 
     /** Assignment operator, assign from ValueVector to Value. */
     Value& operator= (const ValueVector& v);
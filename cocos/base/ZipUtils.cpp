@@ -26,13 +26,11 @@
 
 #include "base/ZipUtils.h"
 
-#ifdef MINIZIP_FROM_SYSTEM
-#include <minizip/unzip.h>
-#else // from our embedded sources
-#include "unzip.h"
-#endif
-#include "ioapi_mem.h"
+#include "mio/mio.hpp"
 #include <memory>
+#include <algorithm>
+#include <limits.h>
+#include <unordered_map>
 
 #include <zlib.h>
 #include <assert.h>
@@ -45,10 +43,6 @@
 #include <map>
 #include <mutex>
 
-// minizip 1.2.0 is same with other platforms
-#define unzGoToFirstFile64(A,B,C,D) unzGoToFirstFile2(A,B,C,D, NULL, 0, NULL, 0)
-#define unzGoToNextFile64(A,B,C,D) unzGoToNextFile2(A,B,C,D, NULL, 0, NULL, 0)
-
 NS_CC_BEGIN
 
 unsigned int ZipUtils::s_uEncryptedPvrKeyParts[4] = {0,0,0,0};
@@ -497,30 +491,268 @@ void ZipUtils::setPvrEncryptionKey(unsigned int keyPart1, unsigned int keyPart2,
 }
 
 // --------------------- ZipFile ---------------------
-// from unzip.cpp
-#define UNZ_MAXFILENAMEINZIP 256
+// The archive is mapped (or given as a buffer) and the central directory is parsed into a hash index once,
+// reading an entry afterwards only touches its local header and data, so readers don't share any state.
 
 static const std::string emptyFilename("");
 
+static const uint32_t ZIP_LOCAL_HEADER_SIGNATURE = 0x04034b50;
+static const uint32_t ZIP_CENTRAL_HEADER_SIGNATURE = 0x02014b50;
+static const uint32_t ZIP_END_SIGNATURE = 0x06054b50;
+static const uint32_t ZIP64_END_SIGNATURE = 0x06064b50;
+static const uint32_t ZIP64_END_LOCATOR_SIGNATURE = 0x07064b50;
+static const uint16_t ZIP64_EXTRA_FIELD_ID = 0x0001;
+
+static const size_t ZIP_LOCAL_HEADER_SIZE = 30;
+static const size_t ZIP_CENTRAL_HEADER_SIZE = 46;
+static const size_t ZIP_END_SIZE = 22;
+static const size_t ZIP64_END_SIZE = 56;
+static const size_t ZIP64_END_LOCATOR_SIZE = 20;
+
+static const uint16_t ZIP_METHOD_STORED = 0;
+static const uint16_t ZIP_METHOD_DEFLATED = 8;
+static const uint16_t ZIP_FLAG_ENCRYPTED = 0x1;
+
+// zip headers aren't aligned
+static inline uint16_t readLE16(const unsigned char* p)
+{
+    return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+static inline uint32_t readLE32(const unsigned char* p)
+{
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) | (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+static inline uint64_t readLE64(const unsigned char* p)
+{
+    return static_cast<uint64_t>(readLE32(p)) | (static_cast<uint64_t>(readLE32(p + 4)) << 32);
+}
+
 struct ZipEntryInfo
 {
-    unz_file_pos pos;
-    uLong uncompressed_size;
+    uint64_t localHeaderOffset;
+    uint64_t compressedSize;
+    uint64_t uncompressedSize;
+    uint16_t method;
+    uint16_t flags;
 };
 
 class ZipFilePrivate
 {
 public:
-    unzFile zipFile;
-    std::mutex zipFileMtx;
-    std::unique_ptr<ourmemory_s> memfs;
-    
+    bool open();
+    bool readCentralEntry(uint64_t offset, std::string* name, ZipEntryInfo* info, uint64_t* nextOffset) const;
+    const unsigned char* getEntryData(const ZipEntryInfo& info) const;
+    bool readEntry(const ZipEntryInfo& info, unsigned char* out) const;
+    int inflateEntryRange(const ZipEntryInfo& info, uint64_t offset, unsigned char* out, unsigned int size) const;
+
+    mio::mmap_source mapping;
+    const unsigned char* data = nullptr;
+    uint64_t size = 0;
+
+    uint64_t centralDirOffset = 0;
+    uint64_t centralDirSize = 0;
+    uint64_t entryCount = 0;
+
+    // cursor of getFirstFilename()/getNextFilename()
+    uint64_t cursorOffset = 0;
+    uint64_t cursorIndex = 0;
+
     // std::unordered_map is faster if available on the platform
     typedef std::unordered_map<std::string, struct ZipEntryInfo> FileListContainer;
     FileListContainer fileList;
 };
 
-ZipFile *ZipFile::createWithBuffer(const void* buffer, uLong size)
+bool ZipFilePrivate::open()
+{
+    if (size < ZIP_END_SIZE)
+        return false;
+
+    // the end of central directory record is followed by a comment of up to 64KB
+    uint64_t searchBegin = size > ZIP_END_SIZE + 0xffff ? size - ZIP_END_SIZE - 0xffff : 0;
+    uint64_t endOffset = size - ZIP_END_SIZE;
+    while (readLE32(data + endOffset) != ZIP_END_SIGNATURE)
+    {
+        if (endOffset == searchBegin)
+            return false;
+        --endOffset;
+    }
+
+    const unsigned char* end = data + endOffset;
+    entryCount = readLE16(end + 10);
+    centralDirSize = readLE32(end + 12);
+    centralDirOffset = readLE32(end + 16);
+
+    if (entryCount == 0xffff || centralDirSize == 0xffffffff || centralDirOffset == 0xffffffff)
+    {
+        if (endOffset < ZIP64_END_LOCATOR_SIZE)
+            return false;
+        const unsigned char* locator = end - ZIP64_END_LOCATOR_SIZE;
+        if (readLE32(locator) != ZIP64_END_LOCATOR_SIGNATURE)
+            return false;
+
+        uint64_t zip64EndOffset = readLE64(locator + 8);
+        if (zip64EndOffset > size - ZIP64_END_SIZE || readLE32(data + zip64EndOffset) != ZIP64_END_SIGNATURE)
+            return false;
+
+        const unsigned char* zip64End = data + zip64EndOffset;
+        entryCount = readLE64(zip64End + 32);
+        centralDirSize = readLE64(zip64End + 40);
+        centralDirOffset = readLE64(zip64End + 48);
+    }
+
+    return centralDirOffset <= size && centralDirSize <= size - centralDirOffset;
+}
+
+bool ZipFilePrivate::readCentralEntry(uint64_t offset, std::string* name, ZipEntryInfo* info, uint64_t* nextOffset) const
+{
+    uint64_t centralDirEnd = centralDirOffset + centralDirSize;
+    if (offset > centralDirEnd || centralDirEnd - offset < ZIP_CENTRAL_HEADER_SIZE)
+        return false;
+
+    const unsigned char* header = data + offset;
+    if (readLE32(header) != ZIP_CENTRAL_HEADER_SIGNATURE)
+        return false;
+
+    uint16_t nameLength = readLE16(header + 28);
+    uint16_t extraLength = readLE16(header + 30);
+    uint16_t commentLength = readLE16(header + 32);
+    uint64_t recordSize = ZIP_CENTRAL_HEADER_SIZE + nameLength + extraLength + commentLength;
+    if (centralDirEnd - offset < recordSize)
+        return false;
+
+    info->flags = readLE16(header + 8);
+    info->method = readLE16(header + 10);
+    info->compressedSize = readLE32(header + 20);
+    info->uncompressedSize = readLE32(header + 24);
+    info->localHeaderOffset = readLE32(header + 42);
+
+    // the 64 bit values are in the extra field, only the ones which don't fit into their 32 bit fields
+    const unsigned char* extra = header + ZIP_CENTRAL_HEADER_SIZE + nameLength;
+    const unsigned char* extraEnd = extra + extraLength;
+    while (extraEnd - extra >= 4)
+    {
+        uint16_t id = readLE16(extra);
+        uint16_t fieldSize = readLE16(extra + 2);
+        const unsigned char* field = extra + 4;
+        const unsigned char* fieldEnd = field + std::min<ptrdiff_t>(fieldSize, extraEnd - field);
+        if (id == ZIP64_EXTRA_FIELD_ID)
+        {
+            uint64_t* values[] = { &info->uncompressedSize, &info->compressedSize, &info->localHeaderOffset };
+            for (auto value : values)
+            {
+                if (*value != 0xffffffff)
+                    continue;
+                if (fieldEnd - field < 8)
+                    return false;
+                *value = readLE64(field);
+                field += 8;
+            }
+        }
+        extra += 4 + fieldSize;
+    }
+
+    name->assign(reinterpret_cast<const char*>(header) + ZIP_CENTRAL_HEADER_SIZE, nameLength);
+    *nextOffset = offset + recordSize;
+    return true;
+}
+
+const unsigned char* ZipFilePrivate::getEntryData(const ZipEntryInfo& info) const
+{
+    if (info.localHeaderOffset > size || size - info.localHeaderOffset < ZIP_LOCAL_HEADER_SIZE)
+        return nullptr;
+
+    const unsigned char* header = data + info.localHeaderOffset;
+    if (readLE32(header) != ZIP_LOCAL_HEADER_SIGNATURE)
+        return nullptr;
+
+    // the extra field of the local header may differ from the central one
+    uint64_t dataOffset = info.localHeaderOffset + ZIP_LOCAL_HEADER_SIZE + readLE16(header + 26) + readLE16(header + 28);
+    if (dataOffset > size || size - dataOffset < info.compressedSize)
+        return nullptr;
+
+    return data + dataOffset;
+}
+
+bool ZipFilePrivate::readEntry(const ZipEntryInfo& info, unsigned char* out) const
+{
+    if ((info.flags & ZIP_FLAG_ENCRYPTED) || info.uncompressedSize > INT_MAX)
+        return false;
+
+    const unsigned char* entryData = getEntryData(info);
+    if (!entryData)
+        return false;
+
+    if (info.method == ZIP_METHOD_STORED)
+    {
+        if (info.compressedSize != info.uncompressedSize)
+            return false;
+        memcpy(out, entryData, static_cast<size_t>(info.uncompressedSize));
+        return true;
+    }
+
+    return info.method == ZIP_METHOD_DEFLATED
+        && inflateEntryRange(info, 0, out, static_cast<unsigned int>(info.uncompressedSize)) == static_cast<int>(info.uncompressedSize);
+}
+
+int ZipFilePrivate::inflateEntryRange(const ZipEntryInfo& info, uint64_t offset, unsigned char* out, unsigned int outSize) const
+{
+    const unsigned char* entryData = getEntryData(info);
+    if (!entryData || (info.flags & ZIP_FLAG_ENCRYPTED) || info.method != ZIP_METHOD_DEFLATED)
+        return -1;
+
+    z_stream stream = { 0 };
+    // raw deflate data, without zlib header
+    if (inflateInit2(&stream, -MAX_WBITS) != Z_OK)
+        return -1;
+
+    const uint64_t inSize = info.compressedSize;
+    uint64_t consumed = 0;
+    uint64_t produced = 0;
+    unsigned int written = 0;
+    unsigned char skipped[16 * 1024];
+    int err = Z_OK;
+    while (err == Z_OK && written < outSize)
+    {
+        if (stream.avail_in == 0)
+        {
+            stream.next_in = const_cast<Bytef*>(entryData + consumed);
+            stream.avail_in = static_cast<uInt>(std::min<uint64_t>(inSize - consumed, UINT_MAX));
+            consumed += stream.avail_in;
+        }
+
+        // data before the requested range is inflated into scratch space and dropped
+        bool skipping = produced < offset;
+        if (skipping)
+        {
+            stream.next_out = skipped;
+            stream.avail_out = static_cast<uInt>(std::min<uint64_t>(offset - produced, sizeof(skipped)));
+        }
+        else
+        {
+            stream.next_out = out + written;
+            stream.avail_out = outSize - written;
+        }
+
+        uInt available = stream.avail_out;
+        err = inflate(&stream, Z_NO_FLUSH);
+        uInt count = available - stream.avail_out;
+        produced += count;
+        if (!skipping)
+            written += count;
+
+        if (err == Z_BUF_ERROR && stream.avail_in == 0 && consumed < inSize)
+            err = Z_OK;
+    }
+    inflateEnd(&stream);
+
+    if (err != Z_OK && err != Z_STREAM_END)
+        return -1;
+    return static_cast<int>(written);
+}
+
+ZipFile *ZipFile::createWithBuffer(const void* buffer, unsigned long size)
 {
     ZipFile *zip = new (std::nothrow) ZipFile();
     if (zip && zip->initWithBuffer(buffer, size)) {
@@ -534,23 +766,28 @@ ZipFile *ZipFile::createWithBuffer(const void* buffer, uLong size)
 ZipFile::ZipFile()
 : _data(new ZipFilePrivate)
 {
-    _data->zipFile = nullptr;
 }
 
 ZipFile::ZipFile(const std::string &zipFile, const std::string &filter)
 : _data(new ZipFilePrivate)
 {
-    _data->zipFile = unzOpen(zipFile.c_str());
+    std::error_code error;
+    _data->mapping.map(zipFile, error);
+    if (!error)
+    {
+        _data->data = reinterpret_cast<const unsigned char*>(_data->mapping.data());
+        _data->size = _data->mapping.size();
+        if (!_data->open())
+        {
+            CCLOG("ZipFile: %s isn't a zip file", zipFile.c_str());
+            _data->data = nullptr;
+        }
+    }
     setFilter(filter);
 }
 
 ZipFile::~ZipFile()
 {
-    if (_data && _data->zipFile)
-    {
-        unzClose(_data->zipFile);
-    }
-
     CC_SAFE_DELETE(_data);
 }
 
@@ -560,38 +797,26 @@ bool ZipFile::setFilter(const std::string &filter)
     do
     {
         CC_BREAK_IF(!_data);
-        CC_BREAK_IF(!_data->zipFile);
+        CC_BREAK_IF(!_data->data);
         
         // clear existing file list
         _data->fileList.clear();
-        
-        // UNZ_MAXFILENAMEINZIP + 1 - it is done so in unzLocateFile
-        char szCurrentFileName[UNZ_MAXFILENAMEINZIP + 1];
-        unz_file_info64 fileInfo;
-        
+        _data->fileList.reserve(static_cast<size_t>(std::min<uint64_t>(_data->entryCount, _data->centralDirSize / ZIP_CENTRAL_HEADER_SIZE)));
+
         // go through all files and store position information about the required files
-        int err = unzGoToFirstFile64(_data->zipFile, &fileInfo,
-                                     szCurrentFileName, sizeof(szCurrentFileName) - 1);
-        while (err == UNZ_OK)
+        std::string currentFileName;
+        ZipEntryInfo entry;
+        uint64_t offset = _data->centralDirOffset;
+        for (uint64_t index = 0; index < _data->entryCount; ++index)
         {
-            unz_file_pos posInfo;
-            int posErr = unzGetFilePos(_data->zipFile, &posInfo);
-            if (posErr == UNZ_OK)
+            CC_BREAK_IF(!_data->readCentralEntry(offset, &currentFileName, &entry, &offset));
+
+            // cache info about filtered files only (like 'assets/')
+            if (filter.empty()
+                || currentFileName.compare(0, filter.length(), filter) == 0)
             {
-                std::string currentFileName = szCurrentFileName;
-                // cache info about filtered files only (like 'assets/')
-                if (filter.empty()
-                    || currentFileName.substr(0, filter.length()) == filter)
-                {
-                    ZipEntryInfo entry;
-                    entry.pos = posInfo;
-                    entry.uncompressed_size = (uLong)fileInfo.uncompressed_size;
-                    _data->fileList[currentFileName] = entry;
-                }
+                _data->fileList[currentFileName] = entry;
             }
-            // next file - also get the information about it
-            err = unzGoToNextFile64(_data->zipFile, &fileInfo,
-                                    szCurrentFileName, sizeof(szCurrentFileName) - 1);
         }
         ret = true;
         
@@ -654,31 +879,28 @@ unsigned char *ZipFile::getFileData(const std::string &fileName, ssize_t *size)
 
     do
     {
-        CC_BREAK_IF(!_data->zipFile);
+        CC_BREAK_IF(!_data->data);
         CC_BREAK_IF(fileName.empty());
         
-        ZipFilePrivate::FileListContainer::iterator it = _data->fileList.find(fileName);
+        ZipFilePrivate::FileListContainer::const_iterator it = _data->fileList.find(fileName);
         CC_BREAK_IF(it ==  _data->fileList.end());
         
-        ZipEntryInfo& fileInfo = it->second;
+        const ZipEntryInfo& fileInfo = it->second;
 
-        std::unique_lock<std::mutex> lck(_data->zipFileMtx);
-        
-        int nRet = unzGoToFilePos(_data->zipFile, &fileInfo.pos);
-        CC_BREAK_IF(UNZ_OK != nRet);
-        
-        nRet = unzOpenCurrentFile(_data->zipFile);
-        CC_BREAK_IF(UNZ_OK != nRet);
-        
-        buffer = (unsigned char*)malloc(fileInfo.uncompressed_size);
-        int CC_UNUSED nSize = unzReadCurrentFile(_data->zipFile, buffer, static_cast<unsigned int>(fileInfo.uncompressed_size));
-        CCASSERT(nSize == 0 || nSize == (int)fileInfo.uncompressed_size, "the file size is wrong");
+        buffer = (unsigned char*)malloc(static_cast<size_t>(std::max<uint64_t>(fileInfo.uncompressedSize, 1)));
+        CC_BREAK_IF(!buffer);
+        if (!_data->readEntry(fileInfo, buffer))
+        {
+            CCLOG("ZipFile: can't read %s", fileName.c_str());
+            free(buffer);
+            buffer = nullptr;
+            break;
+        }
         
         if (size)
         {
-            *size = fileInfo.uncompressed_size;
+            *size = static_cast<ssize_t>(fileInfo.uncompressedSize);
         }
-        unzCloseCurrentFile(_data->zipFile);
     } while (0);
     
     return buffer;
@@ -689,75 +911,75 @@ bool ZipFile::getFileData(const std::string &fileName, ResizableBuffer* buffer)
     bool res = false;
     do
     {
-        CC_BREAK_IF(!_data->zipFile);
+        CC_BREAK_IF(!_data->data);
         CC_BREAK_IF(fileName.empty());
         
-        ZipFilePrivate::FileListContainer::iterator it = _data->fileList.find(fileName);
+        ZipFilePrivate::FileListContainer::const_iterator it = _data->fileList.find(fileName);
         CC_BREAK_IF(it ==  _data->fileList.end());
         
-        ZipEntryInfo& fileInfo = it->second;
-        
-        std::unique_lock<std::mutex> lck(_data->zipFileMtx);
+        const ZipEntryInfo& fileInfo = it->second;
 
-        int nRet = unzGoToFilePos(_data->zipFile, &fileInfo.pos);
-        CC_BREAK_IF(UNZ_OK != nRet);
-        
-        nRet = unzOpenCurrentFile(_data->zipFile);
-        CC_BREAK_IF(UNZ_OK != nRet);
-        
-        buffer->resize(fileInfo.uncompressed_size);
-        int CC_UNUSED nSize = unzReadCurrentFile(_data->zipFile, buffer->buffer(), static_cast<unsigned int>(fileInfo.uncompressed_size));
-        CCASSERT(nSize == 0 || nSize == (int)fileInfo.uncompressed_size, "the file size is wrong");
-        unzCloseCurrentFile(_data->zipFile);
-        res = true;
+        buffer->resize(static_cast<size_t>(fileInfo.uncompressedSize));
+        res = _data->readEntry(fileInfo, static_cast<unsigned char*>(buffer->buffer()));
+        if (!res)
+            CCLOG("ZipFile: can't read %s", fileName.c_str());
     } while (0);
     
     return res;
 }
 
-std::string ZipFile::getFirstFilename()
+const unsigned char* ZipFile::getFileView(const std::string &fileName, ssize_t *size) const
 {
-    if (unzGoToFirstFile(_data->zipFile) != UNZ_OK) return emptyFilename;
-    std::string path;
-    unz_file_info info;
-    getCurrentFileInfo(&path, &info);
-    return path;
+    if (size)
+        *size = 0;
+
+    auto it = _data->fileList.find(fileName);
+    if (it == _data->fileList.end())
+        return nullptr;
+
+    const ZipEntryInfo& fileInfo = it->second;
+    if (fileInfo.method != ZIP_METHOD_STORED || (fileInfo.flags & ZIP_FLAG_ENCRYPTED) || fileInfo.compressedSize != fileInfo.uncompressedSize)
+        return nullptr;
+
+    const unsigned char* view = _data->getEntryData(fileInfo);
+    if (view && size)
+        *size = static_cast<ssize_t>(fileInfo.uncompressedSize);
+    return view;
 }
 
-std::string ZipFile::getNextFilename()
+std::string ZipFile::getFirstFilename()
 {
-    if (unzGoToNextFile(_data->zipFile) != UNZ_OK) return emptyFilename;
-    std::string path;
-    unz_file_info info;
-    getCurrentFileInfo(&path, &info);
-    return path;
+    _data->cursorOffset = _data->centralDirOffset;
+    _data->cursorIndex = 0;
+    return getNextFilename();
 }
 
-int ZipFile::getCurrentFileInfo(std::string *filename, unz_file_info *info)
+std::string ZipFile::getNextFilename()
 {
-    char path[FILENAME_MAX + 1];
-    int ret = unzGetCurrentFileInfo(_data->zipFile, info, path, sizeof(path), nullptr, 0, nullptr, 0);
-    if (ret != UNZ_OK) {
-        *filename = emptyFilename;
-    } else {
-        filename->assign(path);
+    if (!_data->data || _data->cursorIndex >= _data->entryCount) return emptyFilename;
+
+    std::string path;
+    ZipEntryInfo info;
+    if (!_data->readCentralEntry(_data->cursorOffset, &path, &info, &_data->cursorOffset))
+    {
+        _data->cursorIndex = _data->entryCount;
+        return emptyFilename;
     }
-    return ret;
+    ++_data->cursorIndex;
+    return path;
 }
 
-bool ZipFile::initWithBuffer(const void *buffer, uLong size)
+bool ZipFile::initWithBuffer(const void *buffer, unsigned long size)
 {
     if (!buffer || size == 0) return false;
 
-    zlib_filefunc_def memory_file = { 0 };
-    
-    std::unique_ptr<ourmemory_t> memfs(new(std::nothrow) ourmemory_t{ (char*)const_cast<void*>(buffer), static_cast<uint32_t>(size), 0, 0, 0 });
-    if (!memfs) return false;
-    fill_memory_filefunc(&memory_file, memfs.get());
-    
-    _data->zipFile = unzOpen2(nullptr, &memory_file);
-    if (!_data->zipFile) return false;
-    _data->memfs = std::move(memfs);
+    _data->data = static_cast<const unsigned char*>(buffer);
+    _data->size = size;
+    if (!_data->open())
+    {
+        _data->data = nullptr;
+        return false;
+    }
 
     setFilter(emptyFilename);
     return true;
@@ -781,21 +1003,26 @@ int ZipFile::zfread(ZipFileStream* zfs, void* buf, unsigned int size)
 {
     int n = 0;
     do {
-        CC_BREAK_IF(zfs == nullptr || zfs->offset >= zfs->entry->uncompressed_size);
-
-        std::unique_lock<std::mutex> lck(_data->zipFileMtx);
+        CC_BREAK_IF(zfs == nullptr || zfs->entry == nullptr || zfs->offset < 0 || (uint64_t)zfs->offset >= zfs->entry->uncompressedSize);
 
-        int nRet = unzGoToFilePos(_data->zipFile, &zfs->entry->pos);
-        CC_BREAK_IF(UNZ_OK != nRet);
+        const ZipEntryInfo& fileInfo = *zfs->entry;
+        unsigned int count = static_cast<unsigned int>(std::min<uint64_t>(size, fileInfo.uncompressedSize - zfs->offset));
+        if (fileInfo.method == ZIP_METHOD_STORED && !(fileInfo.flags & ZIP_FLAG_ENCRYPTED))
+        {
+            const unsigned char* entryData = _data->getEntryData(fileInfo);
+            CC_BREAK_IF(!entryData);
+            memcpy(buf, entryData + zfs->offset, count);
+            n = static_cast<int>(count);
+        }
+        else
+        {
+            // works, but inflates everything before the offset on every read
+            n = _data->inflateEntryRange(fileInfo, zfs->offset, static_cast<unsigned char*>(buf), count);
+        }
 
-        nRet = unzOpenCurrentFile(_data->zipFile);
-        unzSeek64(_data->zipFile, zfs->offset, SEEK_SET);
-        n = unzReadCurrentFile(_data->zipFile, buf, size);
         if (n > 0)
             zfs->offset += n;
 
-        unzCloseCurrentFile(_data->zipFile);
-
     } while (false);
 
     return n;
@@ -813,7 +1040,7 @@ long ZipFile::zfseek(ZipFileStream* zfs, long offset, int origin)
             result = zfs->offset + offset;
             break;
         case SEEK_END:
-            result = (long)zfs->entry->uncompressed_size + offset;
+            result = (long)zfs->entry->uncompressedSize + offset;
             break;
         default:;
         }
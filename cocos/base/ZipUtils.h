@@ -221,8 +221,11 @@ namespace cocos2d
     /**
     * Zip file - reader helper class.
     *
-    * It will cache the file list of a particular zip file with positions inside an archive,
-    * so it would be much faster to read some particular files or to check their existence.
+    * It maps the zip file and indexes the central directory once, so it would be much faster to read some
+    * particular files or to check their existence. Once the filter is set, files can be read from several
+    * threads at the same time.
+    *
+    * Only stored and deflated files without encryption can be read.
     *
     * @since v2.0.5
     */
@@ -247,6 +250,7 @@ namespace cocos2d
         * @param filter New filter string (first part of files names)
         * @return true whenever zip file is open successfully and it is possible to locate
         *              at least the first file, false otherwise
+        * @warning Don't call it while other threads read files.
         *
         * @since v2.0.5
         */
@@ -291,14 +295,24 @@ namespace cocos2d
         */
         bool getFileData(const std::string &fileName, ResizableBuffer* buffer);
 
+        /**
+        * Get the data of a file stored without compression in the zip file, without copying it.
+        * @param fileName File name
+        * @param[out] size If the file is stored uncompressed, it will be the data size, otherwise 0.
+        * @return A pointer into the zip file, valid as long as the ZipFile exists, or nullptr if the file
+        *         doesn't exist or is compressed.
+        */
+        const unsigned char* getFileView(const std::string &fileName, ssize_t *size) const;
+
+        /** Iterate over all files of the zip file, the filter doesn't apply. Not thread safe. */
         std::string getFirstFilename();
         std::string getNextFilename();
 
         static ZipFile *createWithBuffer(const void* buffer, unsigned long size);
 
         /**
-        * zipFile Streaming support, !!!important, the file in zip must no compress level, otherwise
-        *  stream seek doesn't work.
+        * zipFile Streaming support, !!!important, the file in zip should be stored without compression,
+        *  reading a compressed file inflates it from its beginning on every read.
         */
         bool zfopen(const std::string& fileName, ZipFileStream* zfs);
         int zfread(ZipFileStream* zfs, void* buf, unsigned int size);
@@ -310,7 +324,6 @@ namespace cocos2d
         ZipFile();
         
         bool initWithBuffer(const void *buffer, unsigned long size);
-        int getCurrentFileInfo(std::string *filename, unz_file_info *info);
         
         /** Internal data like zip file pointer / file list array and so on */
         ZipFilePrivate *_data;
@@ -6,6 +6,8 @@
 
 #include "base/astc.h"
 #include "astc/astc_codec_internals.h"
+#include "base/CCParallelTaskPool.h"
+#include <mutex>
 
  // Functions that are used in compilation units we depend on, but don't actually
  // use.
@@ -20,7 +22,27 @@ int store_dds_uncompressed_image(const astc_codec_image* img, const char* filena
 int store_tga_image(const astc_codec_image* img, const char* tga_filename, int bitness) { return 0; }
 
 
-extern int ASTC_INIT = 0;
+// Minimum number of pixels one task decodes, smaller images are decoded on the calling thread.
+static const size_t MIN_DECODE_PIXELS_PER_TASK = 16 * 1024;
+
+// The codec builds its tables lazily, build the ones used for this block size
+// before several threads can ask for them at once.
+static void prepare_astc_tables(uint32_t xdim, uint32_t ydim)
+{
+    static std::mutex tablesMutex;
+    static bool quantizationTableBuilt = false;
+
+    std::lock_guard<std::mutex> lock(tablesMutex);
+    //init astc mode table only once
+    if (!quantizationTableBuilt)
+    {
+        quantizationTableBuilt = true;
+        build_quantization_mode_table();
+    }
+    get_block_size_descriptor(xdim, ydim, 1);
+    for (int partitionCount = 1; partitionCount <= 4; ++partitionCount)
+        get_partition_table(xdim, ydim, 1, partitionCount);
+}
 
 uint8_t float2byte(float f) {
 
@@ -30,44 +52,44 @@ uint8_t float2byte(float f) {
     return (uint8_t)(f * 255.0f + 0.5f);
 }
 
-uint8_t decompress_astc(const uint8_t* in, uint8_t* out, uint32_t width, uint32_t height, uint32_t xdim, uint32_t ydim, uint32_t datalen)
+uint8_t decompress_astc(const uint8_t* in, uint8_t* out, uint32_t width, uint32_t height, uint32_t xdim, uint32_t ydim, uint32_t datalen, int maxThreads)
 {
-    //init astc mode table only once
-    if (ASTC_INIT <= 0)
-    {
-        ASTC_INIT = 1;
-        build_quantization_mode_table();
-    }
+    prepare_astc_tables(xdim, ydim);
 
     uint32_t  xblocks = (width + xdim - 1) / xdim;
     uint32_t  yblocks = (height + ydim - 1) / ydim;
+    size_t grain = MIN_DECODE_PIXELS_PER_TASK / (size_t(xblocks) * xdim * ydim + 1) + 1;
 
-    imageblock pb;
-    for (uint32_t by = 0; by < yblocks; by++) {
-        for (uint32_t bx = 0; bx < xblocks; bx++) {
-
-            physical_compressed_block pcb = *(physical_compressed_block*)in;
-            symbolic_compressed_block scb;
-            physical_to_symbolic(xdim, ydim, 1, pcb, &scb);
-            decompress_symbolic_block(DECODE_LDR_SRGB, xdim, ydim, 1, bx * xdim, by * ydim, 0, &scb, &pb);
-            in += 16;
-
-            const float* data = pb.orig_data;
-            for (uint32_t dy = 0; dy < ydim; dy++) {
-                uint32_t y = by * ydim + dy;
-                for (uint32_t dx = 0; dx < xdim; dx++) {
-                    uint32_t x = bx * xdim + dx;
-                    if (x < width && y < height) {
-                        uint8_t* pxl = &out[(width * y + x) * 4];
-                        pxl[0] = float2byte(data[0]);
-                        pxl[1] = float2byte(data[1]);
-                        pxl[2] = float2byte(data[2]);
-                        pxl[3] = float2byte(data[3]);
+    // block rows are decoded independently, each task with its own imageblock
+    cocos2d::ParallelTaskPool::getInstance()->parallelFor(yblocks, grain, [=](size_t beginRow, size_t endRow) {
+        const uint8_t* blockData = in + beginRow * xblocks * 16;
+        imageblock pb;
+        for (uint32_t by = (uint32_t)beginRow; by < endRow; by++) {
+            for (uint32_t bx = 0; bx < xblocks; bx++) {
+
+                physical_compressed_block pcb = *(physical_compressed_block*)blockData;
+                symbolic_compressed_block scb;
+                physical_to_symbolic(xdim, ydim, 1, pcb, &scb);
+                decompress_symbolic_block(DECODE_LDR_SRGB, xdim, ydim, 1, bx * xdim, by * ydim, 0, &scb, &pb);
+                blockData += 16;
+
+                const float* data = pb.orig_data;
+                for (uint32_t dy = 0; dy < ydim; dy++) {
+                    uint32_t y = by * ydim + dy;
+                    for (uint32_t dx = 0; dx < xdim; dx++) {
+                        uint32_t x = bx * xdim + dx;
+                        if (x < width && y < height) {
+                            uint8_t* pxl = &out[(width * y + x) * 4];
+                            pxl[0] = float2byte(data[0]);
+                            pxl[1] = float2byte(data[1]);
+                            pxl[2] = float2byte(data[2]);
+                            pxl[3] = float2byte(data[3]);
+                        }
+                        data += 4;
                     }
-                    data += 4;
                 }
             }
         }
-    }
+    }, maxThreads);
     return 0;
-}
\ No newline at end of file
+}
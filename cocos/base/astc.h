@@ -15,10 +15,17 @@
 #ifdef __cplusplus
 extern "C" {
 #endif
-    uint8_t decompress_astc(const uint8_t* in, uint8_t* out, uint32_t width, uint32_t height, uint32_t xdim, uint32_t ydim, uint32_t datalen);
+    // Block rows are split across at most maxThreads threads of the ParallelTaskPool, including the calling one, 0 means all of them.
+    uint8_t decompress_astc(const uint8_t* in, uint8_t* out, uint32_t width, uint32_t height, uint32_t xdim, uint32_t ydim, uint32_t datalen, int maxThreads);
 
 #ifdef __cplusplus
 }  // extern "C"
+
+// Decodes on all threads of the ParallelTaskPool, the C declaration above can't take a default argument.
+inline uint8_t decompress_astc(const uint8_t* in, uint8_t* out, uint32_t width, uint32_t height, uint32_t xdim, uint32_t ydim, uint32_t datalen)
+{
+    return decompress_astc(in, out, width, height, xdim, ydim, datalen, 0);
+}
 #endif
 
 #endif //__ASTC_H__
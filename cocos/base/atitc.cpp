@@ -24,6 +24,11 @@
  ****************************************************************************/
 
 #include "base/atitc.h"
+#include "base/CCParallelTaskPool.h"
+#include <algorithm>
+
+// Minimum number of pixels one task decodes, smaller images are decoded on the calling thread.
+static const size_t MIN_DECODE_PIXELS_PER_TASK = 16 * 1024;
 
 //Decode ATITC encode block to 4x4 RGB32 pixels
 static void atitc_decode_block(uint8_t **blockData,
@@ -155,42 +160,50 @@ void atitc_decode(uint8_t *encodeData,             //in_data
                  uint8_t *decodeData,              //out_data
                  const int pixelsWidth,
                  const int pixelsHeight,
-                 ATITCDecodeFlag decodeFlag)
+                 ATITCDecodeFlag decodeFlag,
+                 int maxThreads)
 {
-    uint32_t *decodeBlockData = (uint32_t *)decodeData;
-    
-    for (int block_y = 0; block_y < pixelsHeight / 4; ++block_y, decodeBlockData += 3 * pixelsWidth)   //stride = 3*width
-    {
-        for (int block_x = 0; block_x < pixelsWidth / 4; ++block_x, decodeBlockData += 4)            //skip 4 pixels
+    const int blocksX = pixelsWidth / 4;
+    const size_t blockSize = (ATITCDecodeFlag::ATC_RGB == decodeFlag) ? 8 : 16;
+    // every block row is independent: its encoded data starts at a fixed offset and it writes 4 rows of pixels
+    const size_t grain = std::max<size_t>(1, MIN_DECODE_PIXELS_PER_TASK / std::max(pixelsWidth * 4, 1));
+
+    cocos2d::ParallelTaskPool::getInstance()->parallelFor(pixelsHeight / 4, grain, [=](size_t beginRow, size_t endRow) {
+        uint8_t *blockData = encodeData + beginRow * blocksX * blockSize;
+        uint32_t *decodeBlockData = (uint32_t *)decodeData + beginRow * 4 * pixelsWidth;
+        for (size_t block_y = beginRow; block_y < endRow; ++block_y, decodeBlockData += 3 * pixelsWidth)   //stride = 3*width
         {
-            uint64_t blockAlpha = 0;
-            
-            switch (decodeFlag)
+            for (int block_x = 0; block_x < blocksX; ++block_x, decodeBlockData += 4)            //skip 4 pixels
             {
-                case ATITCDecodeFlag::ATC_RGB:
-                {
-                    atitc_decode_block(&encodeData, decodeBlockData, pixelsWidth, 0, 0LL, ATITCDecodeFlag::ATC_RGB);
-                }
-                    break;
-                case ATITCDecodeFlag::ATC_EXPLICIT_ALPHA:
-                {
-                    memcpy((void *)&blockAlpha, encodeData, 8);
-                    encodeData += 8;
-                    atitc_decode_block(&encodeData, decodeBlockData, pixelsWidth, 1, blockAlpha, ATITCDecodeFlag::ATC_EXPLICIT_ALPHA);
-                }
-                    break;
-                case ATITCDecodeFlag::ATC_INTERPOLATED_ALPHA:
+                uint64_t blockAlpha = 0;
+                
+                switch (decodeFlag)
                 {
-                    memcpy((void *)&blockAlpha, encodeData, 8);
-                    encodeData += 8;
-                    atitc_decode_block(&encodeData, decodeBlockData, pixelsWidth, 1, blockAlpha, ATITCDecodeFlag::ATC_INTERPOLATED_ALPHA);
-                }
-                    break;
-                default:
-                    break;
-            }//switch
-        }//for block_x
-    }//for block_y
+                    case ATITCDecodeFlag::ATC_RGB:
+                    {
+                        atitc_decode_block(&blockData, decodeBlockData, pixelsWidth, 0, 0LL, ATITCDecodeFlag::ATC_RGB);
+                    }
+                        break;
+                    case ATITCDecodeFlag::ATC_EXPLICIT_ALPHA:
+                    {
+                        memcpy((void *)&blockAlpha, blockData, 8);
+                        blockData += 8;
+                        atitc_decode_block(&blockData, decodeBlockData, pixelsWidth, 1, blockAlpha, ATITCDecodeFlag::ATC_EXPLICIT_ALPHA);
+                    }
+                        break;
+                    case ATITCDecodeFlag::ATC_INTERPOLATED_ALPHA:
+                    {
+                        memcpy((void *)&blockAlpha, blockData, 8);
+                        blockData += 8;
+                        atitc_decode_block(&blockData, decodeBlockData, pixelsWidth, 1, blockAlpha, ATITCDecodeFlag::ATC_INTERPOLATED_ALPHA);
+                    }
+                        break;
+                    default:
+                        break;
+                }//switch
+            }//for block_x
+        }//for block_y
+    }, maxThreads);
 }
 
 
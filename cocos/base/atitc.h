@@ -36,12 +36,13 @@ enum class ATITCDecodeFlag
     ATC_INTERPOLATED_ALPHA = 5,
 };
 
-//Decode ATITC encode data to RGB32
+//Decode ATITC encode data to RGB32, block rows are split across at most maxThreads threads of the ParallelTaskPool (0 means all of them)
 void atitc_decode(uint8_t *encode_data,
                   uint8_t *decode_data,
                   const int pixelsWidth,
                   const int pixelsHeight,
-                  ATITCDecodeFlag decodeFlag
+                  ATITCDecodeFlag decodeFlag,
+                  int maxThreads = 0
                   );
 
 /// @endcond
@@ -245,6 +245,16 @@ THE SOFTWARE.
 #define CC_ENABLE_PROFILERS 0
 #endif
 
+/** @def CC_ENABLE_FRAME_PROFILER
+ * If enabled, the FrameProfiler records the zones placed with CC_PROFILE_ZONE() in the engine and the game
+ * on all threads, and writes captured frames as a Chrome trace. Captures are started from code or with the
+ * "profiler" command of the Console. When disabled the zones compile to nothing.
+ * To enable set it to a value different than 0. Disabled by default.
+ */
+#ifndef CC_ENABLE_FRAME_PROFILER
+#define CC_ENABLE_FRAME_PROFILER 0
+#endif
+
 /** Enable Lua engine debug log. */
 #ifndef CC_LUA_ENGINE_DEBUG
 #define CC_LUA_ENGINE_DEBUG 0
@@ -361,3 +371,22 @@ THE SOFTWARE.
 #ifndef CC_META_TEXTURES
 #define CC_META_TEXTURES 2
 #endif
+
+/** @def CC_ENABLE_PROGRAM_BINARY_CACHE
+ * Whether to keep the binaries of the linked programs in the writable path, so that the next start and
+ * a context loss load them instead of compiling the shaders again.
+ * Only used by OpenGL drivers which support program binaries, see backend::FeatureType::PROGRAM_BINARY.
+ */
+#ifndef CC_ENABLE_PROGRAM_BINARY_CACHE
+#define CC_ENABLE_PROGRAM_BINARY_CACHE 1
+#endif
+
+/** @def CC_ENABLE_SHARED_PROGRAM_STATE
+ * Whether the program states handed out by backend::ProgramStateRegistry share their uniforms and textures
+ * with identical ones, so that sprites and labels with the same program, texture and uniforms don't keep a copy each.
+ * Off by default, since a shared program state is hashed again on every uniform change.
+ * Can be changed at runtime with backend::ProgramStateRegistry::setSharingEnabled().
+ */
+#ifndef CC_ENABLE_SHARED_PROGRAM_STATE
+#define CC_ENABLE_SHARED_PROGRAM_STATE 0
+#endif
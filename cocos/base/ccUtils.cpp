@@ -108,21 +108,15 @@ void onCaptureScreen(const std::function<void(bool, const std::string&)>& afterC
                 outputFile = FileUtils::getInstance()->getWritablePath() + filename;
             }
 
-            // Save image in AsyncTaskPool::TaskType::TASK_IO thread, and call afterCaptured in mainThread
-            static bool succeedSaveToFile = false;
-            std::function<void(void*)> mainThread = [afterCaptured, outputFile](void* /*param*/)
+            // Save image in a AsyncTaskPool::TaskType::TASK_COMPUTE thread, and call afterCaptured in mainThread
+            image->saveToFileAsync(outputFile, true, Image::EncodeOptions(), [image, afterCaptured, outputFile](bool succeedSaveToFile)
             {
                 if (afterCaptured)
                 {
                     afterCaptured(succeedSaveToFile, outputFile);
                 }
                 startedCapture = false;
-            };
-
-            AsyncTaskPool::getInstance()->enqueue(AsyncTaskPool::TaskType::TASK_IO, std::move(mainThread), nullptr, [image, outputFile]()
-            {
-                succeedSaveToFile = image->saveToFile(outputFile);
-                delete image;
+                image->release();
             });
         }
         else
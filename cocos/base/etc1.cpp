@@ -16,6 +16,11 @@
 
 #include <string.h>
 
+#include "base/CCParallelTaskPool.h"
+
+// Minimum number of pixels one task decodes, smaller images are decoded on the calling thread.
+static const size_t MIN_DECODE_PIXELS_PER_TASK = 16 * 1024;
+
 /* From http://www.khronos.org/registry/gles/extensions/OES/OES_compressed_ETC1_RGB8_texture.txt
 
  The number of bits that represent a 4x4 texel block is 64 bits if
@@ -567,45 +572,51 @@ int etc1_encode_image(const etc1_byte* pIn, etc1_uint32 width, etc1_uint32 heigh
 
 int etc1_decode_image(const etc1_byte* pIn, etc1_byte* pOut,
         etc1_uint32 width, etc1_uint32 height,
-        etc1_uint32 pixelSize, etc1_uint32 stride) {
+        etc1_uint32 pixelSize, etc1_uint32 stride, int maxThreads) {
     if (pixelSize < 2 || pixelSize > 3) {
         return -1;
     }
-    etc1_byte block[ETC1_DECODED_BLOCK_SIZE];
 
     etc1_uint32 encodedWidth = (width + 3) & ~3;
     etc1_uint32 encodedHeight = (height + 3) & ~3;
-
-    for (etc1_uint32 y = 0; y < encodedHeight; y += 4) {
-        etc1_uint32 yEnd = height - y;
-        if (yEnd > 4) {
-            yEnd = 4;
-        }
-        for (etc1_uint32 x = 0; x < encodedWidth; x += 4) {
-            etc1_uint32 xEnd = width - x;
-            if (xEnd > 4) {
-                xEnd = 4;
+    etc1_uint32 blockRowSize = (encodedWidth >> 2) * ETC1_ENCODED_BLOCK_SIZE;
+    size_t grain = MIN_DECODE_PIXELS_PER_TASK / (encodedWidth * 4 + 1) + 1;
+
+    // Block rows don't share anything, each task decodes a few of them into its own rows of pOut.
+    cocos2d::ParallelTaskPool::getInstance()->parallelFor(encodedHeight >> 2, grain, [=](size_t beginRow, size_t endRow) {
+        etc1_byte block[ETC1_DECODED_BLOCK_SIZE];
+        const etc1_byte* pBlock = pIn + beginRow * blockRowSize;
+        for (etc1_uint32 y = (etc1_uint32) beginRow * 4; y < endRow * 4; y += 4) {
+            etc1_uint32 yEnd = height - y;
+            if (yEnd > 4) {
+                yEnd = 4;
             }
-            etc1_decode_block(pIn, block);
-            pIn += ETC1_ENCODED_BLOCK_SIZE;
-            for (etc1_uint32 cy = 0; cy < yEnd; cy++) {
-                const etc1_byte* q = block + (cy * 4) * 3;
-                etc1_byte* p = pOut + pixelSize * x + stride * (y + cy);
-                if (pixelSize == 3) {
-                    memcpy(p, q, xEnd * 3);
-                } else {
-                    for (etc1_uint32 cx = 0; cx < xEnd; cx++) {
-                        etc1_byte r = *q++;
-                        etc1_byte g = *q++;
-                        etc1_byte b = *q++;
-                        etc1_uint32 pixel = ((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3);
-                        *p++ = (etc1_byte) pixel;
-                        *p++ = (etc1_byte) (pixel >> 8);
+            for (etc1_uint32 x = 0; x < encodedWidth; x += 4) {
+                etc1_uint32 xEnd = width - x;
+                if (xEnd > 4) {
+                    xEnd = 4;
+                }
+                etc1_decode_block(pBlock, block);
+                pBlock += ETC1_ENCODED_BLOCK_SIZE;
+                for (etc1_uint32 cy = 0; cy < yEnd; cy++) {
+                    const etc1_byte* q = block + (cy * 4) * 3;
+                    etc1_byte* p = pOut + pixelSize * x + stride * (y + cy);
+                    if (pixelSize == 3) {
+                        memcpy(p, q, xEnd * 3);
+                    } else {
+                        for (etc1_uint32 cx = 0; cx < xEnd; cx++) {
+                            etc1_byte r = *q++;
+                            etc1_byte g = *q++;
+                            etc1_byte b = *q++;
+                            etc1_uint32 pixel = ((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3);
+                            *p++ = (etc1_byte) pixel;
+                            *p++ = (etc1_byte) (pixel >> 8);
+                        }
                     }
                 }
             }
         }
-    }
+    }, maxThreads);
     return 0;
 }
 
@@ -74,11 +74,13 @@ int etc1_encode_image(const etc1_byte* pIn, etc1_uint32 width, etc1_uint32 heigh
 //        pixel (x,y) is at pIn + pixelSize * x + stride * y. Must be
 //        large enough to store entire image.
 // pixelSize can be 2 or 3. 2 is an GL_UNSIGNED_SHORT_5_6_5 image, 3 is a GL_BYTE RGB image.
+// maxThreads - block rows are split across at most this many threads of the
+//        ParallelTaskPool, including the calling one. 0 means all of them.
 // returns non-zero if there is an error.
 
 int etc1_decode_image(const etc1_byte* pIn, etc1_byte* pOut,
         etc1_uint32 width, etc1_uint32 height,
-        etc1_uint32 pixelSize, etc1_uint32 stride);
+        etc1_uint32 pixelSize, etc1_uint32 stride, int maxThreads);
 
 // Size of a PKM header, in bytes.
 
@@ -102,6 +104,15 @@ etc1_uint32 etc1_pkm_get_height(const etc1_byte* pHeader);
 
 #ifdef __cplusplus
 }
+
+// Decode an entire image on all threads of the ParallelTaskPool. C has no default
+// arguments, so this is an overload instead of a default maxThreads.
+
+inline int etc1_decode_image(const etc1_byte* pIn, etc1_byte* pOut,
+        etc1_uint32 width, etc1_uint32 height,
+        etc1_uint32 pixelSize, etc1_uint32 stride) {
+    return etc1_decode_image(pIn, pOut, width, height, pixelSize, stride, 0);
+}
 #endif
 
 /// @endcond
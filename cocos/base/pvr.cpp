@@ -19,6 +19,7 @@
 #include <assert.h>
 #include <cstdint>
 #include "base/pvr.h"
+#include "base/CCParallelTaskPool.h"
 
 #define PVRT_MIN(a,b)            (((a) < (b)) ? (a) : (b))
 #define PVRT_MAX(a,b)            (((a) > (b)) ? (a) : (b))
@@ -27,6 +28,9 @@
 /*****************************************************************************
  * defines and consts
  *****************************************************************************/
+// Minimum number of pixels one task decodes, smaller images are decoded on the calling thread.
+#define MIN_DECODE_PIXELS_PER_TASK (16 * 1024)
+
 #define PT_INDEX (2)	// The Punch-through index
 
 #define BLK_Y_SIZE 	(4) // always 4 for all 2D block types
@@ -74,7 +78,8 @@ static void PVRDecompress(AMTC_BLOCK_STRUCT *pCompressedData,
 					   const int XDim,
 					   const int YDim,
 					   const int AssumeImageTiles,
-					   unsigned char* pResultImage);
+					   unsigned char* pResultImage,
+					   const int MaxThreads);
 
 /*!***********************************************************************
  @Function		PVRTDecompressPVRTC
@@ -82,12 +87,13 @@ static void PVRDecompress(AMTC_BLOCK_STRUCT *pCompressedData,
  @Input			Do2bitMode Signifies whether the data is PVRTC2 or PVRTC4
  @Input			XDim X dimension of the texture
  @Input			YDim Y dimension of the texture
+ @Input			MaxThreads Maximum number of threads decoding rows, 0 means all
  @Modified		pResultImage The decompressed texture data
  @Description	Decompresses PVRTC to RGBA 8888
  *************************************************************************/
-int PVRTDecompressPVRTC(const void * const pCompressedData,const int XDim,const int YDim, void *pDestData,const bool Do2bitMode)
+int PVRTDecompressPVRTC(const void * const pCompressedData,const int XDim,const int YDim, void *pDestData,const bool Do2bitMode,const int MaxThreads)
 {
-	PVRDecompress((AMTC_BLOCK_STRUCT*)pCompressedData,Do2bitMode,XDim,YDim,1,(unsigned char*)pDestData);
+	PVRDecompress((AMTC_BLOCK_STRUCT*)pCompressedData,Do2bitMode,XDim,YDim,1,(unsigned char*)pDestData,MaxThreads);
     
     return XDim*YDim/2;
 }
@@ -551,21 +557,25 @@ static U32 TwiddleUV(U32 YSize, U32 XSize, U32 YPos, U32 XPos)
 }
 
 /*!***********************************************************************
- @Function		Decompress
+ @Function		PVRDecompressRows
  @Input			pCompressedData The PVRTC texture data to decompress
  @Input			Do2BitMode Signifies whether the data is PVRTC2 or PVRTC4
  @Input			XDim X dimension of the texture
  @Input			YDim Y dimension of the texture
  @Input			AssumeImageTiles Assume the texture data tiles
+ @Input			YBegin First row to decompress
+ @Input			YEnd Row after the last one to decompress
  @Modified		pResultImage The decompressed texture data
- @Description	Decompresses PVRTC to RGBA 8888
+ @Description	Decompresses rows [YBegin, YEnd) of PVRTC to RGBA 8888
  *************************************************************************/
-static void PVRDecompress(AMTC_BLOCK_STRUCT *pCompressedData,
+static void PVRDecompressRows(AMTC_BLOCK_STRUCT *pCompressedData,
                        const bool Do2bitMode,
                        const int XDim,
                        const int YDim,
                        const int AssumeImageTiles,
-                       unsigned char* pResultImage)
+                       unsigned char* pResultImage,
+                       const int YBegin,
+                       const int YEnd)
 {
 	int x, y;
 	int i, j;
@@ -614,7 +624,7 @@ static void PVRDecompress(AMTC_BLOCK_STRUCT *pCompressedData,
      
      Note that this is a hideously inefficient way to do this!
      */
-	for(y = 0; y < YDim; y++)
+	for(y = YBegin; y < YEnd; y++)
 	{
 		for(x = 0; x < XDim; x++)
 		{
@@ -708,6 +718,37 @@ static void PVRDecompress(AMTC_BLOCK_STRUCT *pCompressedData,
 	}
 }
 
+/*!***********************************************************************
+ @Function		PVRDecompress
+ @Input			pCompressedData The PVRTC texture data to decompress
+ @Input			Do2BitMode Signifies whether the data is PVRTC2 or PVRTC4
+ @Input			XDim X dimension of the texture
+ @Input			YDim Y dimension of the texture
+ @Input			AssumeImageTiles Assume the texture data tiles
+ @Input			MaxThreads Maximum number of threads decoding rows, 0 means all
+ @Modified		pResultImage The decompressed texture data
+ @Description	Decompresses PVRTC to RGBA 8888. Every pixel only depends on
+ the compressed data, so the rows are split across the ParallelTaskPool.
+ *************************************************************************/
+static void PVRDecompress(AMTC_BLOCK_STRUCT *pCompressedData,
+                       const bool Do2bitMode,
+                       const int XDim,
+                       const int YDim,
+                       const int AssumeImageTiles,
+                       unsigned char* pResultImage,
+                       const int MaxThreads)
+{
+	// Tasks take whole block rows of pixels, each one unpacks the neighbourhoods of blocks it needs itself
+	size_t RowsPerTask = MIN_DECODE_PIXELS_PER_TASK / (XDim * BLK_Y_SIZE + 1) * BLK_Y_SIZE + BLK_Y_SIZE;
+
+	cocos2d::ParallelTaskPool::getInstance()->parallelFor((YDim + RowsPerTask - 1) / RowsPerTask, 1,
+		[=](size_t Begin, size_t End)
+		{
+			PVRDecompressRows(pCompressedData, Do2bitMode, XDim, YDim, AssumeImageTiles, pResultImage,
+							  (int)(Begin * RowsPerTask), (int)PVRT_MIN(End * RowsPerTask, (size_t)YDim));
+		}, MaxThreads);
+}
+
 /*****************************************************************************
  End of file (pvr.cpp)
  *****************************************************************************/
\ No newline at end of file
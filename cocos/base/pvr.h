@@ -16,7 +16,8 @@
 #define __PVR_H__
 
 
-int PVRTDecompressPVRTC(const void * const pCompressedData,const int XDim,const int YDim,void *pDestData,const bool Do2bitMode);
+// Rows are split across at most MaxThreads threads of the ParallelTaskPool, including the calling one, 0 means all of them.
+int PVRTDecompressPVRTC(const void * const pCompressedData,const int XDim,const int YDim,void *pDestData,const bool Do2bitMode,const int MaxThreads = 0);
 
 
 #endif //__PVR_H__
@@ -24,6 +24,11 @@
  ****************************************************************************/
 
 #include "base/s3tc.h"
+#include "base/CCParallelTaskPool.h"
+#include <algorithm>
+
+// Minimum number of pixels one task decodes, smaller images are decoded on the calling thread.
+static const size_t MIN_DECODE_PIXELS_PER_TASK = 16 * 1024;
 
 //Decode S3TC encode block to 4x4 RGB32 pixels
 static void s3tc_decode_block(uint8_t **blockData,
@@ -143,41 +148,49 @@ void s3tc_decode(uint8_t *encodeData,             //in_data
                  uint8_t *decodeData,             //out_data
                  const int pixelsWidth,
                  const int pixelsHeight,
-                 S3TCDecodeFlag decodeFlag)
+                 S3TCDecodeFlag decodeFlag,
+                 int maxThreads)
 {
-    uint32_t *decodeBlockData = (uint32_t *)decodeData;
-    for (int block_y = 0; block_y < pixelsHeight / 4; ++block_y, decodeBlockData += 3 * pixelsWidth)   //stride = 3*width
-    {
-        for(int block_x = 0; block_x < pixelsWidth / 4; ++block_x, decodeBlockData += 4)            //skip 4 pixels
+    const int blocksX = pixelsWidth / 4;
+    const size_t blockSize = (S3TCDecodeFlag::DXT1 == decodeFlag) ? 8 : 16;
+    // every block row is independent: its encoded data starts at a fixed offset and it writes 4 rows of pixels
+    const size_t grain = std::max<size_t>(1, MIN_DECODE_PIXELS_PER_TASK / std::max(pixelsWidth * 4, 1));
+
+    cocos2d::ParallelTaskPool::getInstance()->parallelFor(pixelsHeight / 4, grain, [=](size_t beginRow, size_t endRow) {
+        uint8_t *blockData = encodeData + beginRow * blocksX * blockSize;
+        uint32_t *decodeBlockData = (uint32_t *)decodeData + beginRow * 4 * pixelsWidth;
+        for (size_t block_y = beginRow; block_y < endRow; ++block_y, decodeBlockData += 3 * pixelsWidth)   //stride = 3*width
         {
-            uint64_t blockAlpha = 0;
-            
-            switch (decodeFlag)
+            for(int block_x = 0; block_x < blocksX; ++block_x, decodeBlockData += 4)            //skip 4 pixels
             {
-                case S3TCDecodeFlag::DXT1:
+                uint64_t blockAlpha = 0;
+                
+                switch (decodeFlag)
                 {
-                    s3tc_decode_block(&encodeData, decodeBlockData, pixelsWidth, 0, 0LL, S3TCDecodeFlag::DXT1);
-                }
-                    break;
-                case S3TCDecodeFlag::DXT3:
-                {
-                    memcpy((void *)&blockAlpha, encodeData, 8);
-                    encodeData += 8;
-                    s3tc_decode_block(&encodeData, decodeBlockData, pixelsWidth, 1, blockAlpha, S3TCDecodeFlag::DXT3);
-                }
-                    break;
-                case S3TCDecodeFlag::DXT5:
-                {
-                    memcpy((void *)&blockAlpha, encodeData, 8);
-                    encodeData += 8;
-                    s3tc_decode_block(&encodeData, decodeBlockData, pixelsWidth, 1, blockAlpha, S3TCDecodeFlag::DXT5);
-                }
-                    break;
-                default:
-                    break;
-            }//switch
-        }//for block_x
-    }//for block_y
+                    case S3TCDecodeFlag::DXT1:
+                    {
+                        s3tc_decode_block(&blockData, decodeBlockData, pixelsWidth, 0, 0LL, S3TCDecodeFlag::DXT1);
+                    }
+                        break;
+                    case S3TCDecodeFlag::DXT3:
+                    {
+                        memcpy((void *)&blockAlpha, blockData, 8);
+                        blockData += 8;
+                        s3tc_decode_block(&blockData, decodeBlockData, pixelsWidth, 1, blockAlpha, S3TCDecodeFlag::DXT3);
+                    }
+                        break;
+                    case S3TCDecodeFlag::DXT5:
+                    {
+                        memcpy((void *)&blockAlpha, blockData, 8);
+                        blockData += 8;
+                        s3tc_decode_block(&blockData, decodeBlockData, pixelsWidth, 1, blockAlpha, S3TCDecodeFlag::DXT5);
+                    }
+                        break;
+                    default:
+                        break;
+                }//switch
+            }//for block_x
+        }//for block_y
+    }, maxThreads);
 }
 
-
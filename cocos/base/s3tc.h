@@ -36,12 +36,13 @@ enum class S3TCDecodeFlag
     DXT5 = 5,
 };
 
-//Decode S3TC encode data to RGB32
+//Decode S3TC encode data to RGB32, block rows are split across at most maxThreads threads of the ParallelTaskPool (0 means all of them)
  void s3tc_decode(uint8_t *encode_data,
                  uint8_t *decode_data,
                  const int pixelsWidth,
                  const int pixelsHeight,
-                 S3TCDecodeFlag decodeFlag
+                 S3TCDecodeFlag decodeFlag,
+                 int maxThreads = 0
                  );
 
  /// @endcond
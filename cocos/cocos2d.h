@@ -42,7 +42,9 @@ THE SOFTWARE.
 
 // base
 #include "base/CCAsyncTaskPool.h"
+#include "base/CCParallelTaskPool.h"
 #include "base/CCAutoreleasePool.h"
+#include "base/CCBinaryValue.h"
 #include "base/CCConfiguration.h"
 #include "base/CCConsole.h"
 #include "base/CCData.h"
@@ -52,6 +54,7 @@ THE SOFTWARE.
 #include "base/CCMap.h"
 #include "base/CCNS.h"
 #include "base/CCProfiling.h"
+#include "base/CCFrameProfiler.h"
 #include "base/CCProperties.h"
 #include "base/CCRef.h"
 #include "base/CCRefPtr.h"
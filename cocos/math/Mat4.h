@@ -773,6 +773,19 @@ public:
      */
     inline void transformPoint(const Vec3& point, Vec3* dst) const { GP_ASSERT(dst); transformVector(point.x, point.y, point.z, 1.0f, dst); }
 
+    /**
+     * Transforms an array of points by this matrix, treating the fourth (w)
+     * coordinate as 1, the same way transformPoint does.
+     *
+     * The result of the transformation is stored directly into the points.
+     *
+     * @param points The first point to transform.
+     * @param count The number of points to transform.
+     * @param stride The distance in bytes between two consecutive points, which allows
+     *        transforming the position of interleaved vertices such as V3F_C4B_T2F.
+     */
+    void transformPoints(Vec3* points, size_t count, size_t stride = sizeof(Vec3)) const;
+
     /**
      * Transforms the specified vector by this matrix by
      * treating the fourth (w) coordinate as zero.
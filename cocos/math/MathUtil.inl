@@ -40,6 +40,8 @@ public:
     inline static void transformVec4(const float* m, float x, float y, float z, float w, float* dst);
     
     inline static void transformVec4(const float* m, const float* v, float* dst);
+
+    inline static void transformVertices(const float* m, float* v, size_t count, size_t stride);
     
     inline static void crossVec3(const float* v1, const float* v2, float* dst);
 };
@@ -204,6 +206,14 @@ inline void MathUtilC::transformVec4(const float* m, const float* v, float* dst)
     dst[3] = w;
 }
 
+inline void MathUtilC::transformVertices(const float* m, float* v, size_t count, size_t stride)
+{
+    for (size_t i = 0; i < count; ++i, v = (float*)((char*)v + stride))
+    {
+        transformVec4(m, v[0], v[1], v[2], 1.0f, v);
+    }
+}
+
 inline void MathUtilC::crossVec3(const float* v1, const float* v2, float* dst)
 {
     float x = (v1[1] * v2[2]) - (v1[2] * v2[1]);
@@ -18,6 +18,8 @@
  This file was modified to fit the cocos2d-x project
  */
 
+#include <arm_neon.h>
+
 NS_CC_MATH_BEGIN
 
 class MathUtilNeon64
@@ -41,6 +43,8 @@ public:
     
     inline static void transformVec4(const float* m, const float* v, float* dst);
     
+    inline static void transformVertices(const float* m, float* v, size_t count, size_t stride);
+
     inline static void crossVec3(const float* v1, const float* v2, float* dst);
 };
 
@@ -223,6 +227,25 @@ inline void MathUtilNeon64::transformVec4(const float* m, const float* v, float*
     );
 }
 
+inline void MathUtilNeon64::transformVertices(const float* m, float* v, size_t count, size_t stride)
+{
+    float32x4_t col0 = vld1q_f32(m);
+    float32x4_t col1 = vld1q_f32(m + 4);
+    float32x4_t col2 = vld1q_f32(m + 8);
+    float32x4_t col3 = vld1q_f32(m + 12);
+    for (size_t i = 0; i < count; ++i, v = (float*)((char*)v + stride))
+    {
+        // fmul/fmla like transformVec4, w is 1 so the last column is added as is
+        float32x4_t dst = vmulq_n_f32(col0, v[0]);
+        dst = vfmaq_n_f32(dst, col1, v[1]);
+        dst = vfmaq_n_f32(dst, col2, v[2]);
+        dst = vaddq_f32(dst, col3);
+
+        vst1_f32(v, vget_low_f32(dst));
+        vst1q_lane_f32(v + 2, dst, 2);
+    }
+}
+
 inline void MathUtilNeon64::crossVec3(const float* v1, const float* v2, float* dst)
 {
         asm volatile(
@@ -151,6 +151,23 @@ void MathUtil::transformVec4(const __m128 m[4], const __m128& v, __m128& dst)
                      );
 }
 
+void MathUtil::transformVertices(const __m128 m[4], float* v, size_t count, size_t stride)
+{
+    for (size_t i = 0; i < count; ++i, v = (float*)((char*)v + stride))
+    {
+        // Same operation order as MathUtilC::transformVec4, so the results are bit-identical.
+        __m128 dst = _mm_mul_ps(m[0], _mm_set1_ps(v[0]));
+        dst = _mm_add_ps(dst, _mm_mul_ps(m[1], _mm_set1_ps(v[1])));
+        dst = _mm_add_ps(dst, _mm_mul_ps(m[2], _mm_set1_ps(v[2])));
+        // w is 1
+        dst = _mm_add_ps(dst, m[3]);
+
+        // only x, y, z are written, the vertex may be followed by other attributes
+        _mm_storel_pi((__m64*)v, dst);
+        _mm_store_ss(v + 2, _mm_movehl_ps(dst, dst));
+    }
+}
+
 #endif
 
 
@@ -0,0 +1,312 @@
+/****************************************************************************
+Copyright (c) 2020 c4games.com.
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#include "platform/CCAssetPack.h"
+#include "platform/CCFileUtils.h"
+#include "base/ccMacros.h"
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <zlib.h>
+#include "mio/mio.hpp"
+
+NS_CC_BEGIN
+
+static const char PACK_MAGIC[4] = { 'C', 'C', 'A', 'P' };
+
+struct AssetPack::Mapping
+{
+    mio::mmap_source source;
+};
+
+static bool entryLess(const AssetPack::Entry& entry, uint64_t hash)
+{
+    return entry.hash < hash;
+}
+
+uint64_t AssetPack::hashName(const char* name, size_t length)
+{
+    // FNV-1a
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < length; ++i)
+    {
+        hash ^= static_cast<unsigned char>(name[i]);
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+AssetPack::AssetPack()
+: _mapping(new Mapping())
+{
+}
+
+AssetPack::~AssetPack()
+{
+}
+
+std::shared_ptr<AssetPack> AssetPack::open(const std::string& path)
+{
+    std::shared_ptr<AssetPack> pack(new (std::nothrow) AssetPack());
+    if (pack && pack->init(path))
+        return pack;
+    return nullptr;
+}
+
+bool AssetPack::init(const std::string& path)
+{
+    std::error_code error;
+    _mapping->source.map(path, error);
+    if (error)
+    {
+        CCLOG("AssetPack: can't map %s: %s", path.c_str(), error.message().c_str());
+        return false;
+    }
+
+    const size_t size = _mapping->source.size();
+    const char* data = _mapping->source.data();
+    if (size < sizeof(Header))
+    {
+        CCLOG("AssetPack: %s is too small", path.c_str());
+        return false;
+    }
+
+    _header = reinterpret_cast<const Header*>(data);
+    if (memcmp(_header->magic, PACK_MAGIC, sizeof(PACK_MAGIC)) != 0 || _header->version != VERSION)
+    {
+        CCLOG("AssetPack: %s isn't a pack of version %u", path.c_str(), VERSION);
+        return false;
+    }
+
+    const uint64_t namesBegin = sizeof(Header) + uint64_t(_header->entryCount) * sizeof(Entry);
+    if (namesBegin + _header->namesSize > size)
+    {
+        CCLOG("AssetPack: the index of %s is truncated", path.c_str());
+        return false;
+    }
+    _entries = reinterpret_cast<const Entry*>(data + sizeof(Header));
+    _names = data + namesBegin;
+
+    // checked once here, so reads don't need to
+    for (uint32_t i = 0; i < _header->entryCount; ++i)
+    {
+        const Entry& entry = _entries[i];
+        if (entry.offset > size || entry.storedSize > size - entry.offset
+            || uint64_t(entry.nameOffset) + entry.nameLength > _header->namesSize
+            || (entry.compression != Compression::NONE && entry.compression != Compression::ZLIB)
+            || (entry.compression == Compression::NONE && entry.storedSize != entry.size)
+            || (i > 0 && _entries[i - 1].hash > entry.hash))
+        {
+            CCLOG("AssetPack: entry %u of %s is damaged", i, path.c_str());
+            return false;
+        }
+    }
+
+    _path = path;
+    return true;
+}
+
+const AssetPack::Entry* AssetPack::findEntry(const std::string& name) const
+{
+    const uint64_t hash = hashName(name.data(), name.size());
+    const Entry* end = _entries + _header->entryCount;
+    for (auto entry = std::lower_bound(_entries, end, hash, entryLess); entry != end && entry->hash == hash; ++entry)
+    {
+        if (entry->nameLength == name.size() && memcmp(_names + entry->nameOffset, name.data(), name.size()) == 0)
+            return entry;
+    }
+    return nullptr;
+}
+
+std::string AssetPack::getName(const Entry* entry) const
+{
+    return std::string(_names + entry->nameOffset, entry->nameLength);
+}
+
+bool AssetPack::getContents(const std::string& name, ResizableBuffer* buffer) const
+{
+    const Entry* entry = findEntry(name);
+    if (entry == nullptr)
+        return false;
+
+    const unsigned char* stored = reinterpret_cast<const unsigned char*>(_mapping->source.data()) + entry->offset;
+    buffer->resize(entry->size);
+    if (entry->size == 0)
+        return true;
+
+    if (entry->compression == Compression::NONE)
+    {
+        memcpy(buffer->buffer(), stored, entry->size);
+        return true;
+    }
+
+    uLongf size = entry->size;
+    if (uncompress(static_cast<Bytef*>(buffer->buffer()), &size, stored, entry->storedSize) != Z_OK || size != entry->size)
+    {
+        CCLOG("AssetPack: can't inflate %s from %s", name.c_str(), _path.c_str());
+        buffer->resize(0);
+        return false;
+    }
+    return true;
+}
+
+AssetView AssetPack::getView(const std::string& name) const
+{
+    const Entry* entry = findEntry(name);
+    if (entry == nullptr || entry->compression != Compression::NONE)
+        return AssetView();
+
+    return AssetView(shared_from_this(), reinterpret_cast<const unsigned char*>(_mapping->source.data()) + entry->offset, entry->size);
+}
+
+std::vector<std::string> AssetPack::listFiles() const
+{
+    std::vector<std::string> files;
+    files.reserve(_header->entryCount);
+    for (uint32_t i = 0; i < _header->entryCount; ++i)
+    {
+        files.push_back(getName(&_entries[i]));
+    }
+    return files;
+}
+
+bool AssetPack::write(const std::string& path, const std::vector<Source>& sources, bool compress)
+{
+    struct Pending
+    {
+        Entry entry;
+        const Source* source;
+    };
+    std::vector<Pending> pending;
+    pending.reserve(sources.size());
+
+    std::string names;
+    for (const auto& source : sources)
+    {
+        if (source.name.size() > UINT16_MAX)
+        {
+            CCLOG("AssetPack: the name %s is too long", source.name.c_str());
+            return false;
+        }
+
+        Pending item;
+        memset(&item.entry, 0, sizeof(item.entry));
+        item.entry.hash = hashName(source.name.data(), source.name.size());
+        item.entry.nameOffset = static_cast<uint32_t>(names.size());
+        item.entry.nameLength = static_cast<uint16_t>(source.name.size());
+        item.source = &source;
+        pending.push_back(item);
+        names += source.name;
+    }
+
+    std::sort(pending.begin(), pending.end(), [](const Pending& a, const Pending& b) {
+        return a.entry.hash != b.entry.hash ? a.entry.hash < b.entry.hash : a.source->name < b.source->name;
+    });
+    for (size_t i = 1; i < pending.size(); ++i)
+    {
+        if (pending[i].source->name == pending[i - 1].source->name)
+        {
+            CCLOG("AssetPack: %s is added twice", pending[i].source->name.c_str());
+            return false;
+        }
+    }
+
+    FILE* fp = fopen(path.c_str(), "wb");
+    if (!fp)
+    {
+        CCLOG("AssetPack: can't create %s", path.c_str());
+        return false;
+    }
+
+    Header header;
+    memcpy(header.magic, PACK_MAGIC, sizeof(PACK_MAGIC));
+    header.version = VERSION;
+    header.entryCount = static_cast<uint32_t>(pending.size());
+    header.namesSize = static_cast<uint32_t>(names.size());
+
+    // the index is written last, once the offsets are known
+    const uint64_t indexSize = sizeof(Header) + pending.size() * sizeof(Entry) + names.size();
+    uint64_t offset = indexSize;
+    bool ok = fseek(fp, static_cast<long>(indexSize), SEEK_SET) == 0;
+
+    std::vector<unsigned char> data, deflated;
+    const unsigned char padding[DATA_ALIGNMENT] = {};
+    for (auto& item : pending)
+    {
+        if (!ok)
+            break;
+        if (FileUtils::getInstance()->getContents(item.source->path, &data) != FileUtils::Status::OK || data.size() > UINT32_MAX)
+        {
+            CCLOG("AssetPack: can't read %s", item.source->path.c_str());
+            ok = false;
+            break;
+        }
+
+        const unsigned char* stored = data.data();
+        size_t storedSize = data.size();
+        item.entry.compression = Compression::NONE;
+        if (compress && !data.empty())
+        {
+            uLongf deflatedSize = compressBound(static_cast<uLong>(data.size()));
+            deflated.resize(deflatedSize);
+            if (compress2(deflated.data(), &deflatedSize, data.data(), static_cast<uLong>(data.size()), Z_BEST_COMPRESSION) == Z_OK
+                && deflatedSize < data.size())
+            {
+                stored = deflated.data();
+                storedSize = deflatedSize;
+                item.entry.compression = Compression::ZLIB;
+            }
+        }
+
+        size_t paddingSize = static_cast<size_t>((DATA_ALIGNMENT - offset % DATA_ALIGNMENT) % DATA_ALIGNMENT);
+        ok = fwrite(padding, 1, paddingSize, fp) == paddingSize
+            && (storedSize == 0 || fwrite(stored, 1, storedSize, fp) == storedSize);
+        offset += paddingSize;
+
+        item.entry.offset = offset;
+        item.entry.size = static_cast<uint32_t>(data.size());
+        item.entry.storedSize = static_cast<uint32_t>(storedSize);
+        offset += storedSize;
+    }
+
+    if (ok)
+    {
+        ok = fseek(fp, 0, SEEK_SET) == 0 && fwrite(&header, sizeof(header), 1, fp) == 1;
+        for (const auto& item : pending)
+        {
+            ok = ok && fwrite(&item.entry, sizeof(Entry), 1, fp) == 1;
+        }
+        ok = ok && (names.empty() || fwrite(names.data(), 1, names.size(), fp) == names.size());
+    }
+    ok = (fclose(fp) == 0) && ok;
+
+    if (!ok)
+    {
+        CCLOG("AssetPack: writing %s failed", path.c_str());
+        remove(path.c_str());
+    }
+    return ok;
+}
+
+NS_CC_END
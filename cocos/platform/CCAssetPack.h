@@ -0,0 +1,180 @@
+/****************************************************************************
+Copyright (c) 2020 c4games.com.
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+#pragma once
+
+#include "platform/CCPlatformMacros.h"
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <memory>
+
+/**
+ * @addtogroup platform
+ * @{
+ */
+NS_CC_BEGIN
+
+class ResizableBuffer;
+class AssetPack;
+
+/**
+ * The bytes of a file stored uncompressed in an asset pack, read straight from the mapping of the pack.
+ * They stay valid as long as the view exists, even if the pack is unmounted meanwhile.
+ */
+class CC_DLL AssetView
+{
+public:
+    AssetView() = default;
+    AssetView(std::shared_ptr<const AssetPack> pack, const unsigned char* data, size_t size)
+    : _pack(std::move(pack)), _data(data), _size(size) {}
+
+    const unsigned char* data() const { return _data; }
+    size_t size() const { return _size; }
+    explicit operator bool() const { return _pack != nullptr; }
+
+private:
+    std::shared_ptr<const AssetPack> _pack;
+    const unsigned char* _data = nullptr;
+    size_t _size = 0;
+};
+
+/**
+ * @class AssetPack
+ * @brief A read-only archive of files, memory mapped as a whole, which FileUtils can mount as a search path.
+ *
+ * The layout, all integers little endian:
+ * - Header: the magic "CCAP", the version, the number of entries and the size of the names block.
+ * - The entries sorted by the 64 bit FNV-1a hash of their name, then by name.
+ * - The names block, the names aren't null terminated.
+ * - The file data, every file starts on a DATA_ALIGNMENT boundary.
+ *
+ * Names are relative paths using '/' like "fonts/arial.ttf". Files are stored as they are or deflated with zlib,
+ * the stored ones are read without any copy through getView().
+ * @js NA
+ * @lua NA
+ */
+class CC_DLL AssetPack : public std::enable_shared_from_this<AssetPack>
+{
+public:
+    enum class Compression : uint8_t
+    {
+        NONE = 0,
+        ZLIB = 1,
+    };
+
+    static const uint32_t VERSION = 1;
+    static const uint32_t DATA_ALIGNMENT = 16;
+
+    struct Header
+    {
+        char magic[4];
+        uint32_t version;
+        uint32_t entryCount;
+        uint32_t namesSize;
+    };
+
+    struct Entry
+    {
+        uint64_t hash;
+        uint64_t offset;
+        uint32_t size;
+        uint32_t storedSize;
+        uint32_t nameOffset;
+        uint16_t nameLength;
+        Compression compression;
+        uint8_t reserved;
+    };
+
+    /** A file to put in a pack by write(). */
+    struct Source
+    {
+        std::string name;
+        std::string path;
+    };
+
+    /**
+     * Maps a pack file and checks its index.
+     *
+     * @param path The full path of the pack on the file system, it can't be inside an APK.
+     * @return The pack, or nullptr if it can't be mapped or isn't valid.
+     */
+    static std::shared_ptr<AssetPack> open(const std::string& path);
+
+    /**
+     * Writes a pack of the given files.
+     *
+     * @param path Where to write the pack.
+     * @param sources The name in the pack and the path of every file, paths are resolved by FileUtils.
+     * @param compress Whether to deflate files, the ones which don't get smaller are stored anyway.
+     * @return false if a source can't be read, a name appears twice or the pack can't be written.
+     */
+    static bool write(const std::string& path, const std::vector<Source>& sources, bool compress);
+
+    /** Hashes a name the way the index does. */
+    static uint64_t hashName(const char* name, size_t length);
+
+    const std::string& getPath() const { return _path; }
+    uint32_t getEntryCount() const { return _header->entryCount; }
+
+    /** Finds the entry of a name, nullptr if the pack doesn't have it. */
+    const Entry* findEntry(const std::string& name) const;
+    bool hasFile(const std::string& name) const { return findEntry(name) != nullptr; }
+    std::string getName(const Entry* entry) const;
+
+    /**
+     * Copies, or inflates, the contents of a file into the buffer.
+     * @return false if the pack doesn't have the file or it is damaged.
+     */
+    bool getContents(const std::string& name, ResizableBuffer* buffer) const;
+
+    /**
+     * Gets the contents of a file stored uncompressed without copying them.
+     * @return An empty view if the pack doesn't have the file or it is compressed.
+     */
+    AssetView getView(const std::string& name) const;
+
+    /** Lists the names of all files in the pack. */
+    std::vector<std::string> listFiles() const;
+
+    ~AssetPack();
+
+CC_CONSTRUCTOR_ACCESS:
+    AssetPack();
+
+protected:
+    bool init(const std::string& path);
+
+    // wraps the mio mapping, so that including FileUtils doesn't pull in the system headers of mio
+    struct Mapping;
+
+    std::string _path;
+    std::unique_ptr<Mapping> _mapping;
+    const Header* _header = nullptr;
+    const Entry* _entries = nullptr;
+    const char* _names = nullptr;
+};
+
+NS_CC_END
+// end group
+/// @}
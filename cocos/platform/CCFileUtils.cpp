@@ -27,8 +27,11 @@ THE SOFTWARE.
 #include "platform/CCFileUtils.h"
 
 #include <stack>
+#include <thread>
+#include <algorithm>
 
 #include "base/CCData.h"
+#include "base/CCBinaryValue.h"
 #include "base/ccMacros.h"
 #include "base/CCDirector.h"
 #include "platform/CCSAXParser.h"
@@ -42,6 +45,7 @@ THE SOFTWARE.
 #include <sys/stat.h>
 
 #include "pugixml/pugixml_imp.hpp"
+#include "mio/mio.hpp"
 #define DECLARE_GUARD (void)0
 
 NS_CC_BEGIN
@@ -326,15 +330,61 @@ public:
     }
 };
 
+// Decodes a compiled plist without copying it when it's in an asset pack or on the file system.
+template <typename T>
+static bool readCompiledPlist(const FileUtils* fileUtils, const std::string& path, T* value)
+{
+    auto view = fileUtils->getContentsView(path);
+    if (view)
+        return BinaryValue::decode(view.data(), view.size(), value);
+
+    std::error_code error;
+    mio::mmap_source mapping;
+    mapping.map(path, error);
+    if (!error)
+        return BinaryValue::decode(mapping.data(), mapping.size(), value);
+
+    Data data = fileUtils->getDataFromFile(path);
+    return !data.isNull() && BinaryValue::decode(data.getBytes(), static_cast<size_t>(data.getSize()), value);
+}
+
+template <typename T>
+static bool loadCompiledPlist(const FileUtils* fileUtils, const std::string& compiledPath, T* value)
+{
+    if (compiledPath.empty())
+        return false;
+    if (readCompiledPlist(fileUtils, compiledPath, value))
+        return true;
+
+    CCLOG("FileUtils: %s isn't a valid compiled plist, parsing the plist instead", compiledPath.c_str());
+    return false;
+}
+
 ValueMap FileUtils::getValueMapFromFile(const std::string& filename) const
 {
     const std::string fullPath = fullPathForFilename(filename);
+    ValueMap dict;
+    if (fullPath.empty() || loadCompiledPlist(this, findCompiledPlist(fullPath), &dict))
+        return dict;
+
     DictMaker tMaker;
-    return tMaker.dictionaryWithContentsOfFile(fullPath);
+    dict = tMaker.dictionaryWithContentsOfFile(fullPath);
+
+    std::string cachePath = getPlistCachePath(fullPath);
+    if (!cachePath.empty() && !dict.empty())
+        writePlistCache(cachePath, BinaryValue::encode(dict));
+    return dict;
 }
 
 ValueMap FileUtils::getValueMapFromData(const char* filedata, int filesize) const
 {
+    if (filesize > 0 && BinaryValue::isBinaryValue(filedata, static_cast<size_t>(filesize)))
+    {
+        ValueMap dict;
+        BinaryValue::decode(filedata, static_cast<size_t>(filesize), &dict);
+        return dict;
+    }
+
     DictMaker tMaker;
     return tMaker.dictionaryWithDataOfFile(filedata, filesize);
 }
@@ -342,8 +392,92 @@ ValueMap FileUtils::getValueMapFromData(const char* filedata, int filesize) cons
 ValueVector FileUtils::getValueVectorFromFile(const std::string& filename) const
 {
     const std::string fullPath = fullPathForFilename(filename);
+    ValueVector array;
+    if (fullPath.empty() || loadCompiledPlist(this, findCompiledPlist(fullPath), &array))
+        return array;
+
     DictMaker tMaker;
-    return tMaker.arrayWithContentsOfFile(fullPath);
+    array = tMaker.arrayWithContentsOfFile(fullPath);
+
+    std::string cachePath = getPlistCachePath(fullPath);
+    if (!cachePath.empty() && !array.empty())
+        writePlistCache(cachePath, BinaryValue::encode(array));
+    return array;
+}
+
+void FileUtils::setPlistCacheDirectory(const std::string& dirPath)
+{
+    std::string path = dirPath;
+    if (!path.empty() && path.back() != '/')
+        path += '/';
+    if (!path.empty() && !createDirectory(path))
+    {
+        CCLOG("FileUtils: can't create the plist cache directory %s", path.c_str());
+        path.clear();
+    }
+
+    std::lock_guard<std::mutex> lock(_plistCacheMutex);
+    _plistCacheDirectory = path;
+}
+
+std::string FileUtils::getPlistCacheDirectory() const
+{
+    std::lock_guard<std::mutex> lock(_plistCacheMutex);
+    return _plistCacheDirectory;
+}
+
+int64_t FileUtils::getFileModificationTime(const std::string& fullPath) const
+{
+    struct stat info;
+    if (findAssetPack(fullPath, nullptr) || ::stat(fullPath.c_str(), &info) != 0)
+        return -1;
+    return static_cast<int64_t>(info.st_mtime);
+}
+
+std::string FileUtils::findCompiledPlist(const std::string& plistPath) const
+{
+    // shipped with the plist, in an APK or an asset pack there's no time to compare and they are trusted
+    std::string compiledPath = getCompiledPlistPath(plistPath);
+    if (isFileExist(compiledPath))
+    {
+        int64_t plistTime = getFileModificationTime(plistPath);
+        int64_t compiledTime = getFileModificationTime(compiledPath);
+        if (plistTime < 0 || compiledTime < 0 || compiledTime >= plistTime)
+            return compiledPath;
+    }
+
+    compiledPath = getPlistCachePath(plistPath);
+    if (!compiledPath.empty() && getFileModificationTime(compiledPath) >= getFileModificationTime(plistPath))
+        return compiledPath;
+    return "";
+}
+
+std::string FileUtils::getPlistCachePath(const std::string& plistPath) const
+{
+    std::string cacheDirectory = getPlistCacheDirectory();
+    // without a time the copy could never be told apart from a stale one
+    if (cacheDirectory.empty() || getFileModificationTime(plistPath) < 0)
+        return "";
+
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.bin", static_cast<unsigned long long>(AssetPack::hashName(plistPath.data(), plistPath.size())));
+    return cacheDirectory + name;
+}
+
+void FileUtils::writePlistCache(const std::string& cachePath, const Data& data) const
+{
+    if (data.isNull())
+        return;
+
+    // plists may be loaded by several threads at once, each writes its own file
+    char suffix[32];
+    snprintf(suffix, sizeof(suffix), ".%llx.tmp", static_cast<unsigned long long>(std::hash<std::thread::id>()(std::this_thread::get_id())));
+    std::string tempPath = cachePath + suffix;
+    if (!writeDataToFile(data, tempPath) || !renameFile(tempPath, cachePath))
+    {
+        CCLOG("FileUtils: can't write the compiled plist %s", cachePath.c_str());
+        removeFile(tempPath);
+    }
 }
 
 /*
@@ -516,6 +650,7 @@ bool FileUtils::writeBinaryToFile(const void* data, size_t dataSize, const std::
 bool FileUtils::init()
 {
     DECLARE_GUARD;
+    std::lock_guard<std::mutex> lock(_searchPathsMutex);
     _searchPathArray.push_back(_defaultResRootPath);
     _searchResolutionsOrderArray.emplace_back("");
     return true;
@@ -524,8 +659,7 @@ bool FileUtils::init()
 void FileUtils::purgeCachedEntries()
 {
     DECLARE_GUARD;
-    _fullPathCache.clear();
-    _fullPathCacheDir.clear();
+    clearFullPathCaches();
 }
 
 std::string FileUtils::getStringFromFile(const std::string& filename) const
@@ -571,6 +705,10 @@ FileUtils::Status FileUtils::getContents(const std::string& filename, ResizableB
     if (fullPath.empty())
         return Status::NotExists;
 
+    Status status;
+    if (getContentsFromAssetPack(fullPath, buffer, &status))
+        return status;
+
     struct stat statBuf;
     if (stat(fullPath.c_str(), &statBuf) == -1) {
         return Status::ReadFailed;
@@ -640,6 +778,99 @@ unsigned char* FileUtils::getFileDataFromZip(const std::string& zipFilePath, con
     return buffer;
 }
 
+bool FileUtils::mountAssetPack(const std::string& packPath, bool front)
+{
+    std::string fullPath = getAssetPackPath(packPath);
+    if (fullPath.empty())
+        return false;
+
+    auto pack = AssetPack::open(fullPath);
+    if (!pack)
+        return false;
+
+    unmountAssetPack(fullPath);
+    {
+        std::lock_guard<std::mutex> lock(_assetPacksMutex);
+        _assetPacks.emplace_back(fullPath, std::move(pack));
+    }
+
+    DECLARE_GUARD;
+    // paths found in the search paths behind it could be in the pack now
+    clearFullPathCaches();
+    addSearchPath(fullPath, front);
+    return true;
+}
+
+void FileUtils::unmountAssetPack(const std::string& packPath)
+{
+    std::string fullPath = getAssetPackPath(packPath);
+    std::string searchPath = fullPath + '/';
+    {
+        std::lock_guard<std::mutex> lock(_assetPacksMutex);
+        auto iter = std::find_if(_assetPacks.begin(), _assetPacks.end(), [&](const std::pair<std::string, std::shared_ptr<AssetPack>>& mounted) {
+            return mounted.first == fullPath;
+        });
+        if (iter == _assetPacks.end())
+            return;
+        _assetPacks.erase(iter);
+    }
+
+    DECLARE_GUARD;
+    clearFullPathCaches();
+    std::lock_guard<std::mutex> lock(_searchPathsMutex);
+    _searchPathArray.erase(std::remove(_searchPathArray.begin(), _searchPathArray.end(), searchPath), _searchPathArray.end());
+    _originalSearchPaths.erase(std::remove(_originalSearchPaths.begin(), _originalSearchPaths.end(), fullPath), _originalSearchPaths.end());
+}
+
+AssetView FileUtils::getContentsView(const std::string& filename) const
+{
+    if (filename.empty())
+        return AssetView();
+
+    std::string name;
+    auto pack = findAssetPack(fullPathForFilename(filename), &name);
+    return pack ? pack->getView(name) : AssetView();
+}
+
+std::string FileUtils::getAssetPackPath(const std::string& packPath) const
+{
+    std::string fullPath = isAbsolutePath(packPath) ? packPath : fullPathForFilename(packPath);
+    while (fullPath.size() > 1 && fullPath.back() == '/')
+        fullPath.pop_back();
+    return fullPath;
+}
+
+std::shared_ptr<AssetPack> FileUtils::findAssetPack(const std::string& fullPath, std::string* name) const
+{
+    std::lock_guard<std::mutex> lock(_assetPacksMutex);
+    for (const auto& mounted : _assetPacks)
+    {
+        // whole path segments only, "/data/res.pack2/a.png" isn't in "/data/res.pack"
+        size_t length = mounted.first.size();
+        if (fullPath.size() > length && fullPath[length] == '/' && fullPath.compare(0, length, mounted.first) == 0)
+        {
+            if (name)
+                name->assign(fullPath, length + 1, std::string::npos);
+            return mounted.second;
+        }
+    }
+    return nullptr;
+}
+
+bool FileUtils::getContentsFromAssetPack(const std::string& fullPath, ResizableBuffer* buffer, Status* status) const
+{
+    std::string name;
+    auto pack = findAssetPack(fullPath, &name);
+    if (!pack)
+        return false;
+
+    if (!pack->hasFile(name))
+        *status = Status::NotExists;
+    else
+        *status = pack->getContents(name, buffer) ? Status::OK : Status::ReadFailed;
+    return true;
+}
+
 void FileUtils::writeValueMapToFile(ValueMap dict, const std::string& fullPath, std::function<void(bool)> callback) const
 {
     
@@ -701,6 +932,194 @@ std::string FileUtils::getPathForDirectory(const std::string &dir, const std::st
     return searchPath + resolutionDiretory + dir;
 }
 
+// Composes the path of a file relative to a search path like getPathForFilename() does.
+static std::string getRelativePathForFilename(const std::string& filename, const std::string& resolutionDirectory)
+{
+    std::string name;
+    size_t pos = filename.find_last_of('/');
+    if (pos != std::string::npos)
+    {
+        name = filename.substr(0, pos+1);
+    }
+    name += resolutionDirectory;
+    if (!name.empty() && name[name.size()-1] != '/')
+    {
+        name += '/';
+    }
+    name.append(filename, pos == std::string::npos ? 0 : pos+1, std::string::npos);
+    return name;
+}
+
+// Looks the file up in the index of the pack instead of the file system.
+// packDirectory is where the search path points into the pack, empty for its root
+static std::string getPathInAssetPack(const AssetPack* pack, const std::string& packDirectory, const std::string& filename, const std::string& resolutionDirectory, const std::string& searchPath)
+{
+    std::string name = getRelativePathForFilename(filename, resolutionDirectory);
+    return pack->hasFile(packDirectory + name) ? searchPath + name : std::string();
+}
+
+// The index only has normalized paths, names like "../a.png" or "a\\b.png" are looked up on the file system.
+static bool canLookUpInFileIndex(const std::string& filename)
+{
+    return filename.find("./") == std::string::npos && filename.find("//") == std::string::npos
+        && filename.find('\\') == std::string::npos;
+}
+
+// Collapses repeated separators and uses '/' only, like the paths composed from search paths.
+static std::string normalizeIndexPath(const std::string& path)
+{
+    std::string normalized;
+    normalized.reserve(path.size());
+    for (char c : path)
+    {
+        if (c == '\\')
+            c = '/';
+        if (c == '/' && !normalized.empty() && normalized.back() == '/')
+            continue;
+        normalized.push_back(c);
+    }
+    return normalized;
+}
+
+bool FileUtils::FileIndex::covers(const std::string& searchPath) const
+{
+    for (const auto& root : roots)
+    {
+        if (searchPath.compare(0, root.size(), root) == 0)
+            return true;
+    }
+    return false;
+}
+
+bool FileUtils::findInFullPathCache(std::unordered_map<std::string, std::string>& cache, const std::string& key, std::string* fullPath, unsigned int* generation) const
+{
+    std::lock_guard<std::mutex> lock(_fullPathCacheMutex);
+    *generation = _fullPathCacheGeneration;
+    auto iter = cache.find(key);
+    if (iter == cache.end())
+        return false;
+    *fullPath = iter->second;
+    return true;
+}
+
+void FileUtils::addToFullPathCache(std::unordered_map<std::string, std::string>& cache, const std::string& key, const std::string& fullPath, unsigned int generation) const
+{
+    std::lock_guard<std::mutex> lock(_fullPathCacheMutex);
+    // the search paths changed while looking the path up
+    if (generation == _fullPathCacheGeneration)
+        cache.emplace(key, fullPath);
+}
+
+void FileUtils::clearFullPathCaches() const
+{
+    std::lock_guard<std::mutex> lock(_fullPathCacheMutex);
+    ++_fullPathCacheGeneration;
+    _fullPathCache.clear();
+    _fullPathCacheDir.clear();
+}
+
+const std::unordered_map<std::string, std::string> FileUtils::getFullPathCache() const
+{
+    std::lock_guard<std::mutex> lock(_fullPathCacheMutex);
+    return _fullPathCache;
+}
+
+void FileUtils::buildFileIndex()
+{
+    DECLARE_GUARD;
+    auto index = std::make_shared<FileIndex>();
+    for (const auto& searchPath : getSearchPaths())
+    {
+        // packs have their own index
+        if (findAssetPack(searchPath, nullptr) || index->covers(searchPath))
+            continue;
+
+        std::vector<std::string> files;
+        listFilesRecursively(searchPath, &files);
+
+        std::string root = normalizeIndexPath(searchPath);
+        bool hasFiles = false;
+        for (const auto& file : files)
+        {
+            std::string path = normalizeIndexPath(file);
+            if (path.back() != '/' && path.compare(0, root.size(), root) == 0)
+            {
+                index->files.insert(std::move(path));
+                hasFiles = true;
+            }
+        }
+
+        // nothing could be listed, like in an APK, or the directory is empty
+        if (hasFiles)
+            index->roots.push_back(root);
+    }
+
+    std::atomic_store(&_fileIndex, std::shared_ptr<const FileIndex>(std::move(index)));
+    clearFullPathCaches();
+}
+
+bool FileUtils::loadFileIndexManifest(const std::string& filename)
+{
+    std::string manifest;
+    if (getContents(filename, &manifest) != Status::OK)
+        return false;
+
+    DECLARE_GUARD;
+    auto current = std::atomic_load(&_fileIndex);
+    auto index = current ? std::make_shared<FileIndex>(*current) : std::make_shared<FileIndex>();
+    std::string root = normalizeIndexPath(_defaultResRootPath);
+
+    size_t begin = 0;
+    while (begin < manifest.size())
+    {
+        size_t end = manifest.find('\n', begin);
+        if (end == std::string::npos)
+            end = manifest.size();
+
+        std::string line = manifest.substr(begin, end - begin);
+        if (!line.empty() && line.back() == '\r')
+            line.pop_back();
+        if (!line.empty())
+            index->files.insert(normalizeIndexPath(root + line));
+        begin = end + 1;
+    }
+
+    if (!index->covers(root))
+        index->roots.push_back(root);
+
+    std::atomic_store(&_fileIndex, std::shared_ptr<const FileIndex>(std::move(index)));
+    clearFullPathCaches();
+    return true;
+}
+
+bool FileUtils::writeFileIndexManifest(const std::string& dirPath, const std::string& manifestPath) const
+{
+    std::string root = normalizeIndexPath(fullPathForDirectory(dirPath));
+    if (root.empty())
+        return false;
+
+    std::vector<std::string> files;
+    listFilesRecursively(root, &files);
+
+    std::string manifest;
+    for (const auto& file : files)
+    {
+        std::string path = normalizeIndexPath(file);
+        if (path.back() != '/' && path.compare(0, root.size(), root) == 0)
+        {
+            manifest.append(path, root.size(), std::string::npos);
+            manifest += '\n';
+        }
+    }
+    return writeStringToFile(manifest, manifestPath);
+}
+
+void FileUtils::clearFileIndex()
+{
+    std::atomic_store(&_fileIndex, std::shared_ptr<const FileIndex>());
+    clearFullPathCaches();
+}
+
 std::string FileUtils::fullPathForFilename(const std::string &filename) const
 {
     
@@ -716,28 +1135,69 @@ std::string FileUtils::fullPathForFilename(const std::string &filename) const
         return filename;
     }
 
+    std::string fullpath;
+
     // Already Cached ?
-    auto cacheIter = _fullPathCache.find(filename);
-    if(cacheIter != _fullPathCache.end())
+    unsigned int cacheGeneration;
+    if (findInFullPathCache(_fullPathCache, filename, &fullpath, &cacheGeneration))
     {
-        return cacheIter->second;
+        return fullpath;
     }
 
     // Get the new file name.
     const std::string newFilename( getNewFilename(filename) );
 
-    std::string fullpath;
+    auto fileIndex = std::atomic_load(&_fileIndex);
+    if (fileIndex && !canLookUpInFileIndex(newFilename))
+    {
+        fileIndex = nullptr;
+    }
+
+    // copies, the search paths may be changed by another thread meanwhile
+    std::vector<std::string> searchPaths;
+    std::vector<std::string> resolutionsOrder;
+    {
+        std::lock_guard<std::mutex> lock(_searchPathsMutex);
+        searchPaths = _searchPathArray;
+        resolutionsOrder = _searchResolutionsOrderArray;
+    }
+
+    bool hasAssetPacks;
+    {
+        std::lock_guard<std::mutex> lock(_assetPacksMutex);
+        hasAssetPacks = !_assetPacks.empty();
+    }
 
-    for (const auto& searchIt : _searchPathArray)
+    for (const auto& searchIt : searchPaths)
     {
-        for (const auto& resolutionIt : _searchResolutionsOrderArray)
+        // the search path of a mounted pack, look the file up in its index instead of the file system
+        std::string packDirectory;
+        auto pack = hasAssetPacks ? findAssetPack(searchIt, &packDirectory) : nullptr;
+        bool indexed = !pack && fileIndex && fileIndex->covers(searchIt);
+
+        for (const auto& resolutionIt : resolutionsOrder)
         {
-            fullpath = this->getPathForFilename(newFilename, resolutionIt, searchIt);
+            if (pack)
+            {
+                fullpath = getPathInAssetPack(pack.get(), packDirectory, newFilename, resolutionIt, searchIt);
+            }
+            else if (indexed)
+            {
+                fullpath = searchIt + getRelativePathForFilename(newFilename, resolutionIt);
+                if (fileIndex->files.find(fullpath) == fileIndex->files.end())
+                {
+                    fullpath.clear();
+                }
+            }
+            else
+            {
+                fullpath = this->getPathForFilename(newFilename, resolutionIt, searchIt);
+            }
 
             if (!fullpath.empty())
             {
                 // Using the filename passed in as key.
-                _fullPathCache.emplace(filename, fullpath);
+                addToFullPathCache(_fullPathCache, filename, fullpath, cacheGeneration);
                 return fullpath;
             }
 
@@ -768,13 +1228,13 @@ std::string FileUtils::fullPathForDirectory(const std::string &dir) const
     }
 
     // Already Cached ?
-    auto cacheIter = _fullPathCacheDir.find(dir);
-    if(cacheIter != _fullPathCacheDir.end())
+    std::string fullpath;
+    unsigned int cacheGeneration;
+    if (findInFullPathCache(_fullPathCacheDir, dir, &fullpath, &cacheGeneration))
     {
-        return cacheIter->second;
+        return fullpath;
     }
     std::string longdir = dir;
-    std::string fullpath;
 
     if(longdir[longdir.length() - 1] != '/')
     {
@@ -782,16 +1242,24 @@ std::string FileUtils::fullPathForDirectory(const std::string &dir) const
     }
 
     const std::string newdirname( getNewFilename(longdir) );
-    
-    for (const auto& searchIt : _searchPathArray)
+
+    std::vector<std::string> searchPaths;
+    std::vector<std::string> resolutionsOrder;
     {
-        for (const auto& resolutionIt : _searchResolutionsOrderArray)
+        std::lock_guard<std::mutex> lock(_searchPathsMutex);
+        searchPaths = _searchPathArray;
+        resolutionsOrder = _searchResolutionsOrderArray;
+    }
+
+    for (const auto& searchIt : searchPaths)
+    {
+        for (const auto& resolutionIt : resolutionsOrder)
         {
             fullpath = this->getPathForDirectory(newdirname, resolutionIt, searchIt);
             if (!fullpath.empty() && isDirectoryExistInternal(fullpath))
             {
                 // Using the filename passed in as key.
-                _fullPathCacheDir.emplace(dir, fullpath);
+                addToFullPathCache(_fullPathCacheDir, dir, fullpath, cacheGeneration);
                 return fullpath;
             }
 
@@ -814,6 +1282,7 @@ std::string FileUtils::fullPathFromRelativeFile(const std::string &filename, con
 void FileUtils::setSearchResolutionsOrder(const std::vector<std::string>& searchResolutionsOrder)
 {
     DECLARE_GUARD;
+    std::lock_guard<std::mutex> lock(_searchPathsMutex);
 
     if (_searchResolutionsOrderArray == searchResolutionsOrder)
     {
@@ -822,8 +1291,7 @@ void FileUtils::setSearchResolutionsOrder(const std::vector<std::string>& search
 
     bool existDefault = false;
 
-    _fullPathCache.clear();
-    _fullPathCacheDir.clear();
+    clearFullPathCaches();
     _searchResolutionsOrderArray.clear();
     for(const auto& iter : searchResolutionsOrder)
     {
@@ -856,6 +1324,7 @@ void FileUtils::addSearchResolutionsOrder(const std::string &order,const bool fr
     if (!resOrder.empty() && resOrder[resOrder.length()-1] != '/')
         resOrder.push_back('/');
 
+    std::lock_guard<std::mutex> lock(_searchPathsMutex);
     if (front) {
         _searchResolutionsOrderArray.insert(_searchResolutionsOrderArray.begin(), resOrder);
     } else {
@@ -866,12 +1335,14 @@ void FileUtils::addSearchResolutionsOrder(const std::string &order,const bool fr
 const std::vector<std::string> FileUtils::getSearchResolutionsOrder() const
 {
     DECLARE_GUARD;
+    std::lock_guard<std::mutex> lock(_searchPathsMutex);
     return _searchResolutionsOrderArray;
 }
 
 const std::vector<std::string> FileUtils::getSearchPaths() const
 {
     DECLARE_GUARD;
+    std::lock_guard<std::mutex> lock(_searchPathsMutex);
     return _searchPathArray;
 }
 
@@ -898,8 +1369,7 @@ void FileUtils::setDefaultResourceRootPath(const std::string& path)
     DECLARE_GUARD;
     if (_defaultResRootPath != path)
     {
-        _fullPathCache.clear();
-        _fullPathCacheDir.clear();
+        clearFullPathCaches();
         _defaultResRootPath = path;
         if (!_defaultResRootPath.empty() && _defaultResRootPath[_defaultResRootPath.length()-1] != '/')
         {
@@ -917,8 +1387,8 @@ void FileUtils::setSearchPaths(const std::vector<std::string>& searchPaths)
     bool existDefaultRootPath = false;
     _originalSearchPaths = searchPaths;
 
-    _fullPathCache.clear();
-    _fullPathCacheDir.clear();
+    clearFullPathCaches();
+    std::lock_guard<std::mutex> lock(_searchPathsMutex);
     _searchPathArray.clear();
 
     for (const auto& path : _originalSearchPaths)
@@ -962,6 +1432,7 @@ void FileUtils::addSearchPath(const std::string &searchpath,const bool front)
         path += "/";
     }
 
+    std::lock_guard<std::mutex> lock(_searchPathsMutex);
     if (front) {
         _originalSearchPaths.insert(_originalSearchPaths.begin(), searchpath);
         _searchPathArray.insert(_searchPathArray.begin(), path);
@@ -974,8 +1445,7 @@ void FileUtils::addSearchPath(const std::string &searchpath,const bool front)
 void FileUtils::setFilenameLookupDictionary(const ValueMap& filenameLookupDict)
 {
     DECLARE_GUARD;
-    _fullPathCache.clear();
-    _fullPathCacheDir.clear();
+    clearFullPathCaches();
     _filenameLookupDict = filenameLookupDict;
 }
 
@@ -1018,6 +1488,11 @@ bool FileUtils::isFileExist(const std::string& filename) const
 {
     if (isAbsolutePath(filename))
     {
+        std::string name;
+        auto pack = findAssetPack(filename, &name);
+        if (pack)
+            return pack->hasFile(name);
+
         return isFileExistInternal(filename);
     }
     else
@@ -1354,6 +1829,14 @@ int64_t FileUtils::getFileSize(const std::string &filepath) const
             return 0;
     }
 
+    std::string name;
+    auto pack = findAssetPack(fullpath, &name);
+    if (pack)
+    {
+        auto entry = pack->findEntry(name);
+        return entry ? entry->size : -1;
+    }
+
     struct stat info;
     // Get data associated with "crt_stat.c":
     int result = ::stat(fullpath.c_str(), &info);
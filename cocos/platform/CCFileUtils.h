@@ -29,6 +29,7 @@ THE SOFTWARE.
 #include <string>
 #include <vector>
 #include <unordered_map>
+#include <unordered_set>
 #include <type_traits>
 #include <mutex>
 
@@ -39,6 +40,7 @@ THE SOFTWARE.
 #include "base/CCAsyncTaskPool.h"
 #include "base/CCScheduler.h"
 #include "base/CCDirector.h"
+#include "platform/CCAssetPack.h"
 
 NS_CC_BEGIN
 
@@ -488,6 +490,8 @@ public:
 
     /**
      *  Converts the contents of a file to a ValueMap.
+     *  A compiled copy of the plist, see getCompiledPlistPath() and setPlistCacheDirectory(), is read instead
+     *  of parsing the XML when it isn't older than the plist.
      *  @param filename The filename of the file to gets content.
      *  @return ValueMap of the file contents.
      *  @note This method is used internally.
@@ -495,7 +499,7 @@ public:
     virtual ValueMap getValueMapFromFile(const std::string& filename) const;
 
 
-    /** Converts the contents of a file to a ValueMap.
+    /** Converts the contents of a file to a ValueMap, the contents can be a compiled plist as well.
      *  This method is used internally.
      */
     virtual ValueMap getValueMapFromData(const char* filedata, int filesize) const;
@@ -615,10 +619,29 @@ public:
     */
     virtual void writeValueVectorToFile(ValueVector vecData, const std::string& fullPath, std::function<void(bool)> callback) const;
 
-    // Converts the contents of a file to a ValueVector.
+    // Converts the contents of a file to a ValueVector, compiled copies are used like by getValueMapFromFile().
     // This method is used internally.
     virtual ValueVector getValueVectorFromFile(const std::string& filename) const;
 
+    /**
+     *  Gets where a plist compiled ahead of time is looked for: beside the plist, with ".bin" appended to its name.
+     *  Compiled plists are written by BinaryValue::encode() or the asset-packer tool with --compile-plists.
+     *  When both files have a modification time, the compiled one is only used if it isn't older.
+     */
+    static std::string getCompiledPlistPath(const std::string& plistPath) { return plistPath + ".bin"; }
+
+    /**
+     *  Sets a directory where getValueMapFromFile() and getValueVectorFromFile() keep compiled copies of the
+     *  XML plists they parse, the next load of a plist reads its copy instead. Only plists on the file system
+     *  are cached, the copies are checked against their modification time.
+     *
+     *  @param dirPath A writable directory, it's created if needed. An empty path, the default, turns the cache off.
+     */
+    void setPlistCacheDirectory(const std::string& dirPath);
+
+    /** Gets the directory set by setPlistCacheDirectory(). */
+    std::string getPlistCacheDirectory() const;
+
     /**
      *  Checks whether a file exists.
      *
@@ -830,8 +853,62 @@ public:
     */
     virtual void listFilesRecursivelyAsync(const std::string& dirPath, std::function<void(std::vector<std::string>)> callback) const;
 
-    /** Returns the full path cache. */
-    const std::unordered_map<std::string, std::string> getFullPathCache() const { return _fullPathCache; }
+    /** Returns a copy of the full path cache. */
+    const std::unordered_map<std::string, std::string> getFullPathCache() const;
+
+    /**
+     *  Lists the files of all search paths once, fullPathForFilename() then looks files up in this index
+     *  instead of asking the file system. Call it again after adding or removing files in a search path.
+     *  Search paths added later, search paths without files and files in an APK aren't indexed,
+     *  they are looked up on the file system as before.
+     *  The index is case sensitive on every platform: on Windows and macOS a file name which differs from
+     *  the file in case is found without the index, but not with it.
+     */
+    void buildFileIndex();
+
+    /**
+     *  Adds the files listed by a manifest to the file index, for instance one shipped with the game
+     *  and written by writeFileIndexManifest(). This also indexes resources in an APK.
+     *
+     *  @param filename The manifest, it lists one path per line relative to the default resource root path.
+     *          All search paths under the default resource root path are answered by the index afterwards.
+     *  @return false if the manifest can't be read.
+     */
+    bool loadFileIndexManifest(const std::string& filename);
+
+    /**
+     *  Writes a manifest for loadFileIndexManifest(), the paths of all files in a directory relative to it.
+     */
+    bool writeFileIndexManifest(const std::string& dirPath, const std::string& manifestPath) const;
+
+    /** Drops the file index, every lookup asks the file system again. */
+    void clearFileIndex();
+
+    /**
+     *  Mounts an asset pack as a search path. The files in it are found like the ones of a directory named
+     *  like the pack, their full paths are the full path of the pack followed by their names in the pack,
+     *  for instance "/data/res.pack/fonts/arial.ttf".
+     *
+     *  @param packPath The pack written by AssetPack::write() or the asset-packer tool, it has to be a file
+     *          on the file system, a pack inside an APK can't be mapped.
+     *  @param front Whether the pack is searched before the other search paths.
+     *  @return false if the pack can't be opened.
+     */
+    bool mountAssetPack(const std::string& packPath, bool front = false);
+
+    /**
+     *  Unmounts an asset pack and removes it from the search paths.
+     *  Views returned by getContentsView() stay valid until they are destroyed.
+     */
+    void unmountAssetPack(const std::string& packPath);
+
+    /**
+     *  Gets the contents of a file stored uncompressed in a mounted asset pack without copying them.
+     *
+     *  @param filename The resource file name which contains the path.
+     *  @return An empty view if the file isn't stored like that, use getContents() then.
+     */
+    AssetView getContentsView(const std::string& filename) const;
 
     /**
      *  Gets the new filename from the filename lookup dictionary.
@@ -904,6 +981,45 @@ protected:
      */
     virtual std::string fullPathForDirectory(const std::string &dirname) const;
 
+    /**
+     *  Finds the mounted asset pack a full path points into.
+     *
+     *  @param fullPath The full path of a file.
+     *  @param name Set to the name of the file in the pack, can be nullptr.
+     *  @return The pack, nullptr if the path isn't inside a mounted one.
+     */
+    std::shared_ptr<AssetPack> findAssetPack(const std::string& fullPath, std::string* name) const;
+
+    /** The full path of an asset pack without a trailing '/', as the packs are mounted. */
+    std::string getAssetPackPath(const std::string& packPath) const;
+
+    /**
+     *  Reads a file of a mounted asset pack, platforms overriding getContents() call it first.
+     *
+     *  @return false if the full path isn't inside a mounted pack, otherwise status is set.
+     */
+    bool getContentsFromAssetPack(const std::string& fullPath, ResizableBuffer* buffer, Status* status) const;
+
+    /**
+     *  Gets the modification time of a file on the file system, in seconds.
+     *
+     *  @return -1 if it isn't known, for instance for files in an APK or an asset pack.
+     */
+    virtual int64_t getFileModificationTime(const std::string& fullPath) const;
+
+    /**
+     *  Finds a compiled copy of a plist, beside it or in the plist cache directory, which isn't older than it.
+     *
+     *  @return The full path of the copy, an empty string if there is none.
+     */
+    std::string findCompiledPlist(const std::string& plistPath) const;
+
+    /** Gets the path of the copy of a plist in the plist cache directory, empty if the plist can't be cached. */
+    std::string getPlistCachePath(const std::string& plistPath) const;
+
+    /** Writes a compiled plist to the plist cache directory, readers never see a partly written file. */
+    void writePlistCache(const std::string& cachePath, const Data& data) const;
+
     /**
     * mutex used to protect fields. 
     */
@@ -931,6 +1047,9 @@ protected:
      */
     std::vector<std::string> _searchPathArray;
 
+    /** Guards _searchPathArray and _searchResolutionsOrderArray, the loading threads look files up too. */
+    mutable std::mutex _searchPathsMutex;
+
     /**
      * The search paths which was set by 'setSearchPaths' / 'addSearchPath'.
      */
@@ -957,6 +1076,42 @@ protected:
      */
     mutable std::unordered_map<std::string, std::string> _fullPathCacheDir;
 
+    /**
+     *  Guards both full path caches, texture and audio loading threads look paths up too.
+     *  The generation changes whenever the caches are cleared, so that a lookup which started before
+     *  doesn't cache a path of the old search paths.
+     */
+    mutable std::mutex _fullPathCacheMutex;
+    mutable unsigned int _fullPathCacheGeneration = 0;
+
+    bool findInFullPathCache(std::unordered_map<std::string, std::string>& cache, const std::string& key, std::string* fullPath, unsigned int* generation) const;
+    void addToFullPathCache(std::unordered_map<std::string, std::string>& cache, const std::string& key, const std::string& fullPath, unsigned int generation) const;
+    void clearFullPathCaches() const;
+
+    /**
+     *  The full paths of the files in the directories listed by roots, all of them ending with '/'.
+     *  It is replaced as a whole and never changed afterwards, so lookups just take a reference.
+     */
+    struct FileIndex
+    {
+        std::unordered_set<std::string> files;
+        std::vector<std::string> roots;
+
+        bool covers(const std::string& searchPath) const;
+    };
+    std::shared_ptr<const FileIndex> _fileIndex;
+
+    /**
+     *  The mounted asset packs, keyed by the full path of the pack without a trailing '/'.
+     *  They are read by loading threads too, so they have their own mutex.
+     */
+    std::vector<std::pair<std::string, std::shared_ptr<AssetPack>>> _assetPacks;
+    mutable std::mutex _assetPacksMutex;
+
+    /** Where parsed plists are compiled to, see setPlistCacheDirectory(). */
+    std::string _plistCacheDirectory;
+    mutable std::mutex _plistCacheMutex;
+
     /**
      * Writable path.
      */
@@ -28,6 +28,7 @@ THE SOFTWARE.
 #include "platform/CCImage.h"
 
 #include <string>
+#include <algorithm>
 #include <ctype.h>
 
 #include "base/ccConfig.h" // CC_USE_JPEG, CC_USE_WEBP
@@ -93,6 +94,7 @@ extern "C"
 
 #if CC_USE_PNG
 #include "png.h"
+#include "zlib.h" // Z_RLE
 #endif //CC_USE_PNG
 
 #include "base/etc1.h"
@@ -118,8 +120,10 @@ extern "C"
 #include "platform/CCStdC.h"
 #include "platform/CCFileUtils.h"
 #include "base/CCConfiguration.h"
+#include "base/CCAsyncTaskPool.h"
 #include "base/ccUtils.h"
 #include "base/ZipUtils.h"
+#include "renderer/CCTextureUtils.h"
 #if (CC_TARGET_PLATFORM == CC_PLATFORM_ANDROID)
 #include "platform/android/CCFileUtils-android.h"
 #include "platform/CCGL.h"
@@ -512,6 +516,7 @@ backend::PixelFormat getDevicePixelFormat(backend::PixelFormat format)
 // Implement Image
 //////////////////////////////////////////////////////////////////////////
 bool Image::PNG_PREMULTIPLIED_ALPHA_ENABLED = true;
+int Image::SOFTWARE_DECODE_THREADS = 0;
 
 Image::Image()
 : _data(nullptr)
@@ -524,6 +529,8 @@ Image::Image()
 , _pixelFormat(backend::PixelFormat::NONE)
 , _numberOfMipmaps(0)
 , _hasPremultipliedAlpha(false)
+, _premultiplyDeferred(false)
+, _premultiplyPending(false)
 {
 
 }
@@ -544,6 +551,11 @@ bool Image::initWithImageFile(const std::string& path)
     bool ret = false;
     _filePath = FileUtils::getInstance()->fullPathForFilename(path);
 
+    // files of a mounted asset pack are decoded straight from the mapping
+    auto view = FileUtils::getInstance()->getContentsView(_filePath);
+    if (view)
+        return initWithImageData(view.data(), view.size(), false);
+
     Data data = FileUtils::getInstance()->getDataFromFile(_filePath);
 
     if (!data.isNull())
@@ -561,6 +573,10 @@ bool Image::initWithImageFileThreadSafe(const std::string& fullpath)
     bool ret = false;
     _filePath = fullpath;
 
+    auto view = FileUtils::getInstance()->getContentsView(fullpath);
+    if (view)
+        return initWithImageData(view.data(), view.size(), false);
+
     Data data = FileUtils::getInstance()->getDataFromFile(fullpath);
 
     if (!data.isNull())
@@ -1095,7 +1111,15 @@ bool Image::initWithPngData(const unsigned char * data, ssize_t dataLen)
         {
             if (PNG_PREMULTIPLIED_ALPHA_ENABLED)
             {
-                premultiplyAlpha();
+                if (_premultiplyDeferred && CC_ENABLE_PREMULTIPLIED_ALPHA != 0)
+                {
+                    // a texture of another pixel format premultiplies in the same pass as the conversion
+                    _premultiplyPending = true;
+                }
+                else
+                {
+                    premultiplyAlpha();
+                }
             }
             else
             {
@@ -1260,7 +1284,7 @@ bool Image::initWithPVRv2Data(const unsigned char * data, ssize_t dataLen)
                     _unpack = true;
                     _mipmaps[_numberOfMipmaps].len = width*height*4;
                     _mipmaps[_numberOfMipmaps].address = new (std::nothrow) unsigned char[width*height*4];
-                    PVRTDecompressPVRTC(_data+dataOffset,width,height,_mipmaps[_numberOfMipmaps].address, true);
+                    PVRTDecompressPVRTC(_data+dataOffset,width,height,_mipmaps[_numberOfMipmaps].address, true, SOFTWARE_DECODE_THREADS);
                     bpp = 2;
                 }
                 blockSize = 8 * 4; // Pixel by pixel block size for 2bpp
@@ -1274,7 +1298,7 @@ bool Image::initWithPVRv2Data(const unsigned char * data, ssize_t dataLen)
                     _unpack = true;
                     _mipmaps[_numberOfMipmaps].len = width*height*4;
                     _mipmaps[_numberOfMipmaps].address = new (std::nothrow) unsigned char[width*height*4];
-                    PVRTDecompressPVRTC(_data+dataOffset,width,height,_mipmaps[_numberOfMipmaps].address, false);
+                    PVRTDecompressPVRTC(_data+dataOffset,width,height,_mipmaps[_numberOfMipmaps].address, false, SOFTWARE_DECODE_THREADS);
                     bpp = 4;
                 }
                 blockSize = 4 * 4; // Pixel by pixel block size for 4bpp
@@ -1414,7 +1438,7 @@ bool Image::initWithPVRv3Data(const unsigned char * data, ssize_t dataLen)
                     _unpack = true;
                     _mipmaps[i].len = width*height*4;
                     _mipmaps[i].address = new (std::nothrow) unsigned char[width*height*4];
-                    PVRTDecompressPVRTC(_data+dataOffset,width,height,_mipmaps[i].address, true);
+                    PVRTDecompressPVRTC(_data+dataOffset,width,height,_mipmaps[i].address, true, SOFTWARE_DECODE_THREADS);
                     bpp = 2;
                 }
                 blockSize = 8 * 4; // Pixel by pixel block size for 2bpp
@@ -1429,7 +1453,7 @@ bool Image::initWithPVRv3Data(const unsigned char * data, ssize_t dataLen)
                     _unpack = true;
                     _mipmaps[i].len = width*height*4;
                     _mipmaps[i].address = new (std::nothrow) unsigned char[width*height*4];
-                    PVRTDecompressPVRTC(_data+dataOffset,width,height,_mipmaps[i].address, false);
+                    PVRTDecompressPVRTC(_data+dataOffset,width,height,_mipmaps[i].address, false, SOFTWARE_DECODE_THREADS);
                     bpp = 4;
                 }
                 blockSize = 4 * 4; // Pixel by pixel block size for 4bpp
@@ -1445,7 +1469,7 @@ bool Image::initWithPVRv3Data(const unsigned char * data, ssize_t dataLen)
                     _unpack = true;
                     _mipmaps[i].len = width*height*bytePerPixel;
                     _mipmaps[i].address = new (std::nothrow) unsigned char[width*height*bytePerPixel];
-                    if (etc1_decode_image(static_cast<const unsigned char*>(_data+dataOffset), static_cast<etc1_byte*>(_mipmaps[i].address), width, height, bytePerPixel, stride) != 0)
+                    if (etc1_decode_image(static_cast<const unsigned char*>(_data+dataOffset), static_cast<etc1_byte*>(_mipmaps[i].address), width, height, bytePerPixel, stride, SOFTWARE_DECODE_THREADS) != 0)
                     {
                         return false;
                     }
@@ -1550,7 +1574,7 @@ bool Image::initWithETCData(const unsigned char* data, ssize_t dataLen, bool own
         _dataLen =  _width * _height * bytePerPixel;
         _data = static_cast<unsigned char*>(malloc(_dataLen * sizeof(unsigned char)));
         
-        if (etc1_decode_image(static_cast<const unsigned char*>(data) + ETC_PKM_HEADER_SIZE, static_cast<etc1_byte*>(_data), _width, _height, bytePerPixel, stride) != 0)
+        if (etc1_decode_image(static_cast<const unsigned char*>(data) + ETC_PKM_HEADER_SIZE, static_cast<etc1_byte*>(_data), _width, _height, bytePerPixel, stride, SOFTWARE_DECODE_THREADS) != 0)
         {
             _dataLen = 0;
             if (_data != nullptr)
@@ -1599,7 +1623,11 @@ bool Image::initWithASTCData(const unsigned char* data, ssize_t dataLen, bool ow
             _pixelFormat = backend::PixelFormat::ASTC8;
         }
         _dataLen = dataLen;
-        _data = (unsigned char*)data;
+        if (ownData) _data = (unsigned char*)data;
+        else {
+            _data = (unsigned char*)malloc(dataLen);
+            if (_data) memcpy(_data, data, dataLen);
+        }
         _offset = ASTC_HEAD_SIZE; 
         return true;
     }
@@ -1613,7 +1641,7 @@ bool Image::initWithASTCData(const unsigned char* data, ssize_t dataLen, bool ow
         _dataLen = _width * _height * 32;
         _data = static_cast<unsigned char*>(malloc(_dataLen * sizeof(unsigned char)));
 
-        uint8_t result = decompress_astc(static_cast<const unsigned char*>(data) + ASTC_HEAD_SIZE, _data, _width, _height, xdim, ydim, _dataLen);
+        uint8_t result = decompress_astc(static_cast<const unsigned char*>(data) + ASTC_HEAD_SIZE, _data, _width, _height, xdim, ydim, _dataLen, SOFTWARE_DECODE_THREADS);
         if (result != 0)
         {
             _dataLen = 0;
@@ -1810,15 +1838,15 @@ bool Image::initWithS3TCData(const unsigned char * data, ssize_t dataLen)
             std::vector<unsigned char> decodeImageData(stride * height);
             if (FOURCC_DXT1 == header->ddsd.DUMMYUNIONNAMEN4.ddpfPixelFormat.fourCC)
             {
-                s3tc_decode(pixelData + encodeOffset, &decodeImageData[0], width, height, S3TCDecodeFlag::DXT1);
+                s3tc_decode(pixelData + encodeOffset, &decodeImageData[0], width, height, S3TCDecodeFlag::DXT1, SOFTWARE_DECODE_THREADS);
             }
             else if (FOURCC_DXT3 == header->ddsd.DUMMYUNIONNAMEN4.ddpfPixelFormat.fourCC)
             {
-                s3tc_decode(pixelData + encodeOffset, &decodeImageData[0], width, height, S3TCDecodeFlag::DXT3);
+                s3tc_decode(pixelData + encodeOffset, &decodeImageData[0], width, height, S3TCDecodeFlag::DXT3, SOFTWARE_DECODE_THREADS);
             }
             else if (FOURCC_DXT5 == header->ddsd.DUMMYUNIONNAMEN4.ddpfPixelFormat.fourCC)
             {
-                s3tc_decode(pixelData + encodeOffset, &decodeImageData[0], width, height, S3TCDecodeFlag::DXT5);
+                s3tc_decode(pixelData + encodeOffset, &decodeImageData[0], width, height, S3TCDecodeFlag::DXT5, SOFTWARE_DECODE_THREADS);
             }
             
             _mipmaps[i].address = (unsigned char *)_data + decodeOffset;
@@ -1945,13 +1973,13 @@ bool Image::initWithATITCData(const unsigned char *data, ssize_t dataLen)
             switch (header->glInternalFormat)
             {
                 case CC_GL_ATC_RGB_AMD:
-                    atitc_decode(pixelData + encodeOffset, &decodeImageData[0], width, height, ATITCDecodeFlag::ATC_RGB);
+                    atitc_decode(pixelData + encodeOffset, &decodeImageData[0], width, height, ATITCDecodeFlag::ATC_RGB, SOFTWARE_DECODE_THREADS);
                     break;
                 case CC_GL_ATC_RGBA_EXPLICIT_ALPHA_AMD:
-                    atitc_decode(pixelData + encodeOffset, &decodeImageData[0], width, height, ATITCDecodeFlag::ATC_EXPLICIT_ALPHA);
+                    atitc_decode(pixelData + encodeOffset, &decodeImageData[0], width, height, ATITCDecodeFlag::ATC_EXPLICIT_ALPHA, SOFTWARE_DECODE_THREADS);
                     break;
                 case CC_GL_ATC_RGBA_INTERPOLATED_ALPHA_AMD:
-                    atitc_decode(pixelData + encodeOffset, &decodeImageData[0], width, height, ATITCDecodeFlag::ATC_INTERPOLATED_ALPHA);
+                    atitc_decode(pixelData + encodeOffset, &decodeImageData[0], width, height, ATITCDecodeFlag::ATC_INTERPOLATED_ALPHA, SOFTWARE_DECODE_THREADS);
                     break;
                 default:
                     break;
@@ -2048,8 +2076,46 @@ bool Image::initWithRawData(const unsigned char * data, ssize_t /*dataLen*/, int
 }
 
 
+Image::EncodeOptions Image::EncodeOptions::fastLossless()
+{
+    EncodeOptions options;
+    options.pngCompressionLevel = 1;
+    options.pngFilter = PNGFilter::SUB;
+    options.pngRunLengthOnly = true;
+    return options;
+}
+
+Image::EncodeOptions Image::EncodeOptions::smallest()
+{
+    EncodeOptions options;
+    options.pngCompressionLevel = 9;
+    options.pngFilter = PNGFilter::ALL;
+    return options;
+}
+
+void Image::saveToFileAsync(const std::string& filename, bool isToRGB, const EncodeOptions& options, const std::function<void(bool)>& callback)
+{
+    // written by the compute thread, read by the callback on the main thread once the task is done
+    auto succeeded = std::make_shared<bool>(false);
+    retain();
+    AsyncTaskPool::getInstance()->enqueue(AsyncTaskPool::TaskType::TASK_COMPUTE, [this, callback, succeeded](void*) {
+        if (callback)
+        {
+            callback(*succeeded);
+        }
+        release();
+    }, nullptr, [this, filename, isToRGB, options, succeeded]() {
+        *succeeded = saveToFile(filename, isToRGB, options);
+    });
+}
+
 #if (CC_TARGET_PLATFORM != CC_PLATFORM_IOS)
 bool Image::saveToFile(const std::string& filename, bool isToRGB)
+{
+    return saveToFile(filename, isToRGB, EncodeOptions());
+}
+
+bool Image::saveToFile(const std::string& filename, bool isToRGB, const EncodeOptions& options)
 {
     //only support for backend::PixelFormat::RGB888 or backend::PixelFormat::RGBA8888 uncompressed data
     if (isCompressed() || (_pixelFormat != backend::PixelFormat::RGB888 && _pixelFormat != backend::PixelFormat::RGBA8888))
@@ -2062,11 +2128,11 @@ bool Image::saveToFile(const std::string& filename, bool isToRGB)
 
     if (fileExtension == ".png")
     {
-        return saveImageToPNG(filename, isToRGB);
+        return saveImageToPNG(filename, isToRGB, options);
     }
     else if (fileExtension == ".jpg")
     {
-        return saveImageToJPG(filename);
+        return saveImageToJPG(filename, options);
     }
     else
     {
@@ -2074,9 +2140,15 @@ bool Image::saveToFile(const std::string& filename, bool isToRGB)
         return false;
     }
 }
+#else
+bool Image::saveToFile(const std::string& filename, bool isToRGB, const EncodeOptions& /*options*/)
+{
+    // UIKit encodes with its own settings
+    return saveToFile(filename, isToRGB);
+}
 #endif
 
-bool Image::saveImageToPNG(const std::string& filePath, bool isToRGB)
+bool Image::saveImageToPNG(const std::string& filePath, bool isToRGB, const EncodeOptions& options)
 {
 #if CC_USE_PNG
     bool ret = false;
@@ -2113,6 +2185,20 @@ bool Image::saveImageToPNG(const std::string& filePath, bool isToRGB)
         }
         png_init_io(png_ptr, fp);
 
+        if (options.pngCompressionLevel >= 0)
+        {
+            png_set_compression_level(png_ptr, std::min(options.pngCompressionLevel, 9));
+        }
+        if (options.pngRunLengthOnly)
+        {
+            png_set_compression_strategy(png_ptr, Z_RLE);
+        }
+        if (options.pngFilter != PNGFilter::DEFAULT)
+        {
+            static const int filters[] = { 0, PNG_FILTER_NONE, PNG_FILTER_SUB, PNG_FILTER_UP, PNG_FILTER_PAETH, PNG_ALL_FILTERS };
+            png_set_filter(png_ptr, PNG_FILTER_TYPE_BASE, filters[static_cast<int>(options.pngFilter)]);
+        }
+
         if (!isToRGB && hasAlpha())
         {
             png_set_IHDR(png_ptr, info_ptr, _width, _height, 8, PNG_COLOR_TYPE_RGB_ALPHA,
@@ -2217,7 +2303,7 @@ bool Image::saveImageToPNG(const std::string& filePath, bool isToRGB)
 #endif // CC_USE_PNG
 }
 
-bool Image::saveImageToJPG(const std::string& filePath)
+bool Image::saveImageToJPG(const std::string& filePath, const EncodeOptions& options)
 {
 #if CC_USE_JPEG
     bool ret = false;
@@ -2243,7 +2329,7 @@ bool Image::saveImageToJPG(const std::string& filePath)
         cinfo.in_color_space = JCS_RGB;       /* colorspace of input image */
 
         jpeg_set_defaults(&cinfo);
-        jpeg_set_quality(&cinfo, 90, TRUE);
+        jpeg_set_quality(&cinfo, std::max(1, std::min(options.jpgQuality, 100)), TRUE);
         
         jpeg_start_compress(&cinfo, TRUE);
 
@@ -2311,12 +2397,8 @@ void Image::premultiplyAlpha()
 #else
     CCASSERT(_pixelFormat == backend::PixelFormat::RGBA8888, "The pixel format should be RGBA8888!");
     
-    unsigned int* fourBytes = (unsigned int*)_data;
-    for(int i = 0; i < _width * _height; i++)
-    {
-        unsigned char* p = _data + i * 4;
-        fourBytes[i] = CC_RGB_PREMULTIPLY_ALPHA(p[0], p[1], p[2], p[3]);
-    }
+    _premultiplyPending = false;
+    backend::PixelFormatUtils::premultiplyAlpha(_data, static_cast<size_t>(_width) * _height * 4, _data);
     
     _hasPremultipliedAlpha = true;
 #endif
@@ -2330,6 +2412,13 @@ void Image::reversePremultipliedAlpha()
 {
     CCASSERT(_pixelFormat == backend::PixelFormat::RGBA8888, "The pixel format should be RGBA8888!");
 
+    // the colors weren't multiplied yet
+    if (_premultiplyPending)
+    {
+        _premultiplyPending = false;
+        return;
+    }
+
     unsigned int* fourBytes = (unsigned int*)_data;
     for (int i = 0; i < _width * _height; i++)
     {
@@ -31,6 +31,7 @@ THE SOFTWARE.
 #include "base/CCRef.h"
 #include "renderer/CCTexture2D.h"
 #include "base/CCData.h"
+#include <functional>
 
 // premultiply alpha, or the effect will be wrong when using other pixel formats in Texture2D,
 // such as RGB888, RGB5A1
@@ -100,6 +101,34 @@ public:
         UNKNOWN
     };
 
+    /** Row filters of PNG files, see png_set_filter(). */
+    enum class PNGFilter
+    {
+        DEFAULT,    ///< chosen by libpng, adaptive for true color images
+        NONE,       ///< the fastest and the biggest
+        SUB,        ///< cheap, good for gradients and photos
+        UP,
+        PAETH,
+        ALL,        ///< tries every filter on every row, the slowest
+    };
+
+    /** Speed and size trade-offs of saveToFile(). */
+    struct EncodeOptions
+    {
+        /** zlib level of PNG files, from 0 (stored) to 9 (smallest), -1 is the libpng default of 6. */
+        int pngCompressionLevel = -1;
+        PNGFilter pngFilter = PNGFilter::DEFAULT;
+        /** Only compresses runs of repeated bytes (Z_RLE), much faster for somewhat bigger files. */
+        bool pngRunLengthOnly = false;
+        /** Quality of JPG files, from 1 to 100. */
+        int jpgQuality = 90;
+
+        /** Fast lossless PNG files, e.g. for debug captures: level 1, SUB filter, runs only. */
+        static EncodeOptions fastLossless();
+        /** The smallest PNG files at the cost of time: level 9, all filters. */
+        static EncodeOptions smallest();
+    };
+
     /**
      * Enables or disables premultiplied alpha for PNG files.
      *
@@ -115,6 +144,15 @@ public:
      */
     static void setPVRImagesHavePremultipliedAlpha(bool haveAlphaPremultiplied);
 
+    /**
+     * Sets how many threads decode a compressed texture (ETC1, S3TC, ATITC, ASTC or PVRTC) when the GPU can't
+     * and it is decoded in software, including the loading thread. Every mipmap level is split by block rows.
+     *
+     *  @param threads Maximum number of threads of the ParallelTaskPool, 0 means all of them (default: 0)
+     */
+    static void setSoftwareDecodeThreads(int threads) { SOFTWARE_DECODE_THREADS = threads; }
+    static int getSoftwareDecodeThreads() { return SOFTWARE_DECODE_THREADS; }
+
     /**
     @brief Load the image from the specified path.
     @param path   the absolute file path.
@@ -158,9 +196,27 @@ public:
      @param    isToRGB        whether the image is saved as RGB format.
      */
     bool saveToFile(const std::string &filename, bool isToRGB = true);
+
+    /**
+     @brief    Save Image data to the specified file, encoded with the given settings.
+     @param    options        the PNG compression and JPG quality, ignored on iOS.
+     */
+    bool saveToFile(const std::string &filename, bool isToRGB, const EncodeOptions& options);
+
+    /**
+     @brief    Encodes and saves the image on a compute thread of AsyncTaskPool, several saves run at once.
+     The image is retained until the callback and must not be changed meanwhile.
+     @param    callback        called on the main thread with whether the file was saved, may be nullptr.
+     */
+    void saveToFileAsync(const std::string &filename, bool isToRGB, const EncodeOptions& options, const std::function<void(bool)>& callback);
     void premultiplyAlpha();
     void reversePremultipliedAlpha();   
 
+    /** Leaves the colors of a png loaded afterwards straight, for a texture that multiplies them by alpha while converting the pixel format. */
+    void setPremultiplyAlphaDeferred(bool deferred) { _premultiplyDeferred = deferred; }
+    /** Whether the colors of a png loaded with setPremultiplyAlphaDeferred(true) still have to be multiplied by alpha, see premultiplyAlpha(). */
+    bool isPremultiplyAlphaPending() const { return _premultiplyPending; }
+
 protected:
     bool initWithJpgData(const unsigned char *  data, ssize_t dataLen);
     bool initWithPngData(const unsigned char * data, ssize_t dataLen);
@@ -176,8 +232,8 @@ protected:
     typedef struct sImageTGA tImageTGA;
     bool initWithTGAData(tImageTGA* tgaData);
 
-    bool saveImageToPNG(const std::string& filePath, bool isToRGB = true);
-    bool saveImageToJPG(const std::string& filePath);
+    bool saveImageToPNG(const std::string& filePath, bool isToRGB, const EncodeOptions& options);
+    bool saveImageToJPG(const std::string& filePath, const EncodeOptions& options);
     
 
     
@@ -191,6 +247,10 @@ protected:
      @brief Determine whether we premultiply alpha for png files.
      */
     static bool PNG_PREMULTIPLIED_ALPHA_ENABLED;
+    /**
+     @brief Maximum number of threads decoding compressed textures in software.
+     */
+    static int SOFTWARE_DECODE_THREADS;
     unsigned char *_data;
     ssize_t _dataLen;
     ssize_t _offset;
@@ -203,6 +263,8 @@ protected:
     int _numberOfMipmaps;
     // false if we can't auto detect the image is premultiplied or not.
     bool _hasPremultipliedAlpha;
+    bool _premultiplyDeferred;
+    bool _premultiplyPending;
     std::string _filePath;
 
 
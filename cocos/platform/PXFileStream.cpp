@@ -7,6 +7,8 @@
 
 #include <sys/stat.h>
 #include <assert.h>
+#include <string.h>
+#include <algorithm>
 
 #if defined(_WIN32)
 #define O_READ_FLAGS O_BINARY | O_RDONLY, S_IREAD
@@ -71,6 +73,35 @@ static PXIoF pfs_posix_iof = {
         pfs_posix_close
 };
 
+// memory wrappers
+static int pfs_mem_read(PXFileHandle& handle, void* buf, unsigned int size) {
+    auto& mem = handle._mem;
+    long n = (std::min)(static_cast<long>(size), mem._size - mem._offset);
+    if (n <= 0)
+        return 0;
+    memcpy(buf, mem._data + mem._offset, n);
+    mem._offset += n;
+    return static_cast<int>(n);
+}
+static long pfs_mem_seek(PXFileHandle& handle, long offst, int origin) {
+    auto& mem = handle._mem;
+    long offset = offst + (origin == SEEK_CUR ? mem._offset : (origin == SEEK_END ? mem._size : 0));
+    if (offset < 0 || offset > mem._size)
+        return -1;
+    mem._offset = offset;
+    return offset;
+}
+static int pfs_mem_close(PXFileHandle& handle) {
+    handle._mem._data = nullptr;
+    handle._mem._size = handle._mem._offset = 0;
+    return 0;
+}
+static PXIoF pfs_mem_iof = {
+        pfs_mem_read,
+        pfs_mem_seek,
+        pfs_mem_close
+};
+
 #if CC_TARGET_PLATFORM == CC_PLATFORM_ANDROID
 // android AssetManager wrappers
 static int pfs_asset_read(PXFileHandle& handle, void* buf, unsigned int size) { return AAsset_read(handle._asset, buf, size); }
@@ -113,6 +144,7 @@ PXFileStream::~PXFileStream()
 
 bool PXFileStream::open(const std::string& path, int mode)
 {
+    this->_iof = &pfs_posix_iof;
 #if CC_TARGET_PLATFORM != CC_PLATFORM_ANDROID
     return pfs_posix_open(path, mode, _handle) != -1;
 #else // Android
@@ -152,8 +184,22 @@ bool PXFileStream::open(const std::string& path, int mode)
 #endif
 }
 
+bool PXFileStream::openMemory(const void* data, long size)
+{
+    if (data == nullptr || size < 0)
+        return false;
+
+    _handle._mem._data = static_cast<const char*>(data);
+    _handle._mem._size = size;
+    _handle._mem._offset = 0;
+    this->_iof = &pfs_mem_iof;
+    return true;
+}
+
 PXFileStream::operator bool() const
 {
+    if (_iof == &pfs_mem_iof)
+        return _handle._mem._data != nullptr;
 #if CC_TARGET_PLATFORM != CC_PLATFORM_ANDROID
     return _handle._fd != -1;
 #else
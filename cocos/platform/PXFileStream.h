@@ -26,8 +26,14 @@
 NS_CC_BEGIN
 
 struct UnzFileStream;
+struct PXMemoryFile {
+    const char* _data;
+    long _size;
+    long _offset;
+};
 union PXFileHandle {
     int _fd = -1;
+    PXMemoryFile _mem;
 #if CC_TARGET_PLATFORM == CC_PLATFORM_ANDROID
     AAsset* _asset;
     ZipFileStream _zfs;
@@ -48,6 +54,8 @@ public:
     };
 
     bool open(const std::string& path, int mode = kModeReadOnly);
+    // reads from memory owned by the caller, which must outlive the stream
+    bool openMemory(const void* data, long size);
     int close();
 
     int seek(long offset, int origin);
@@ -165,6 +165,10 @@ FileUtils::Status FileUtilsWin32::getContents(const std::string& filename, Resiz
     // read the file from hardware
     std::string fullPath = FileUtils::getInstance()->fullPathForFilename(filename);
 
+    Status status;
+    if (getContentsFromAssetPack(fullPath, buffer, &status))
+        return status;
+
     HANDLE fileHandle = ::CreateFileW(ntcvt::from_chars(fullPath).c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, NULL, nullptr);
     if (fileHandle == INVALID_HANDLE_VALUE)
         return FileUtils::Status::OpenFailed;
@@ -263,6 +267,15 @@ int64_t FileUtilsWin32::getFileSize(const std::string &filepath) const
 {
     if (filepath.empty())
         return -1;
+
+    std::string name;
+    auto pack = findAssetPack(filepath, &name);
+    if (pack)
+    {
+        auto entry = pack->findEntry(name);
+        return entry ? entry->size : -1;
+    }
+
     WIN32_FILE_ATTRIBUTE_DATA attrs = { 0 };
     if (GetFileAttributesExA(filepath.c_str(), GetFileExInfoStandard, &attrs) &&
         !(attrs.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
@@ -271,6 +284,20 @@ int64_t FileUtilsWin32::getFileSize(const std::string &filepath) const
     return -1;
 }
 
+int64_t FileUtilsWin32::getFileModificationTime(const std::string& fullPath) const
+{
+    if (fullPath.empty() || findAssetPack(fullPath, nullptr))
+        return -1;
+
+    WIN32_FILE_ATTRIBUTE_DATA attrs = { 0 };
+    if (!GetFileAttributesExW(ntcvt::from_chars(fullPath).c_str(), GetFileExInfoStandard, &attrs))
+        return -1;
+
+    // FILETIME counts 100 nanoseconds, only the order of the times matters
+    uint64_t ticks = static_cast<uint64_t>(attrs.ftLastWriteTime.dwHighDateTime) << 32 | attrs.ftLastWriteTime.dwLowDateTime;
+    return static_cast<int64_t>(ticks / 10000000);
+}
+
 std::vector<std::string> FileUtilsWin32::listFiles(const std::string& dirPath) const
 {
     std::string fullpath = fullPathForDirectory(dirPath);
@@ -109,6 +109,8 @@ protected:
 
     virtual int64_t getFileSize(const std::string &filepath) const override;
 
+    virtual int64_t getFileModificationTime(const std::string& fullPath) const override;
+
     /**
      *  Gets full path for filename, resolution directory and search path.
      *
@@ -67,6 +67,7 @@ void CustomCommand::createVertexBuffer(std::size_t vertexSize, std::size_t capac
     
     _vertexCapacity = capacity;
     _vertexDrawCount = capacity;
+    _vertexBufferOffset = 0;
     
     auto device = backend::Device::getInstance();
     _vertexBuffer = device->newBuffer(vertexSize * capacity, backend::BufferType::VERTEX, usage);
@@ -80,6 +81,7 @@ void CustomCommand::createIndexBuffer(IndexFormat format, std::size_t capacity,
     _indexSize = computeIndexSize();
     _indexCapacity = capacity;
     _indexDrawCount = capacity;
+    _indexBufferOffset = 0;
     
     auto device = backend::Device::getInstance();
     _indexBuffer = device->newBuffer(_indexSize * capacity, backend::BufferType::INDEX, usage);
@@ -97,6 +99,18 @@ void CustomCommand::updateIndexBuffer(void* data, std::size_t offset, std::size_
     _indexBuffer->updateSubData(data, offset, length);
 }
 
+void CustomCommand::streamVertexBuffer(void* data, std::size_t length)
+{
+    assert(_vertexBuffer);
+    _vertexBufferOffset = _vertexBuffer->streamData(data, length);
+}
+
+void CustomCommand::streamIndexBuffer(void* data, std::size_t length)
+{
+    assert(_indexBuffer);
+    _indexBufferOffset = _indexBuffer->streamData(data, length);
+}
+
 void CustomCommand::setVertexBuffer(backend::Buffer *vertexBuffer)
 {
     if (_vertexBuffer == vertexBuffer)
@@ -105,6 +119,7 @@ void CustomCommand::setVertexBuffer(backend::Buffer *vertexBuffer)
     CC_SAFE_RELEASE(_vertexBuffer);
     _vertexBuffer = vertexBuffer;
     CC_SAFE_RETAIN(_vertexBuffer);
+    _vertexBufferOffset = 0;
 }
 
 void CustomCommand::setIndexBuffer(backend::Buffer *indexBuffer, IndexFormat format)
@@ -115,6 +130,7 @@ void CustomCommand::setIndexBuffer(backend::Buffer *indexBuffer, IndexFormat for
     CC_SAFE_RELEASE(_indexBuffer);
     _indexBuffer = indexBuffer;
     CC_SAFE_RETAIN(_indexBuffer);
+    _indexBufferOffset = 0;
 
     _indexFormat = format;
     _indexSize = computeIndexSize();
@@ -54,7 +54,8 @@ public:
     using PrimitiveType = backend::PrimitiveType;
     /**
     Buffer usage of vertex/index buffer. If the contents is not updated every frame,
-    then use STATIC, other use DYNAMIC.
+    then use STATIC, other use DYNAMIC. Contents which are sent again every frame
+    can use STREAM with streamVertexBuffer() and streamIndexBuffer().
     */
     using BufferUsage = backend::BufferUsage;
     /**
@@ -142,6 +143,26 @@ public:
     */
     void updateIndexBuffer(void* data, std::size_t offset, std::size_t length);
 
+    /**
+    Send the vertices of the current frame to a vertex buffer created with BufferUsage::STREAM.
+    The vertices are written where the GPU doesn't read anymore, so it never waits for the previous frames.
+    They are drawn from getVertexBufferOffset(), the draw info stays relative to the streamed data.
+    @param data Specifies a pointer to the vertices.
+    @param length Specifies the size in bytes of the vertices, at most the size of the buffer.
+    */
+    void streamVertexBuffer(void* data, std::size_t length);
+    /**
+    Send the indices of the current frame to an index buffer created with BufferUsage::STREAM.
+    @param data Specifies a pointer to the indices.
+    @param length Specifies the size in bytes of the indices, at most the size of the buffer.
+    */
+    void streamIndexBuffer(void* data, std::size_t length);
+
+    /** Get the byte offset of the vertices in the vertex buffer, not 0 once streamed. */
+    inline std::size_t getVertexBufferOffset() const { return _vertexBufferOffset; }
+    /** Get the byte offset of the indices in the index buffer, not 0 once streamed. */
+    inline std::size_t getIndexBufferOffset() const { return _indexBufferOffset; }
+
     /**
     Get vertex buffer capacity.
     */
@@ -215,6 +236,8 @@ protected:
 
     backend::Buffer* _vertexBuffer = nullptr;
     backend::Buffer* _indexBuffer = nullptr;
+    std::size_t _vertexBufferOffset = 0;
+    std::size_t _indexBufferOffset = 0;
     
     std::size_t _vertexDrawStart = 0;
     std::size_t _vertexDrawCount = 0;
@@ -73,6 +73,35 @@ void MeshCommand::init(float globalZOrder, const Mat4 &transform)
     _mv = transform;
 }
 
+void MeshCommand::captureUniforms()
+{
+    auto programState = _pipelineDescriptor.programState;
+    char* vertexBuffer = nullptr;
+    char* fragmentBuffer = nullptr;
+    std::size_t vertexSize = 0;
+    std::size_t fragmentSize = 0;
+    programState->getVertexUniformBuffer(&vertexBuffer, vertexSize);
+    programState->getFragmentUniformBuffer(&fragmentBuffer, fragmentSize);
+
+    _capturedUniforms.resize(vertexSize + fragmentSize);
+    if (vertexSize)
+        memcpy(_capturedUniforms.data(), vertexBuffer, vertexSize);
+    if (fragmentSize)
+        memcpy(_capturedUniforms.data() + vertexSize, fragmentBuffer, fragmentSize);
+}
+
+void MeshCommand::restoreUniforms() const
+{
+    auto programState = _pipelineDescriptor.programState;
+    char* vertexBuffer = nullptr;
+    std::size_t vertexSize = 0;
+    programState->getVertexUniformBuffer(&vertexBuffer, vertexSize);
+    CCASSERT(vertexSize <= _capturedUniforms.size(), "the uniforms were not captured");
+
+    programState->setUniformBuffers(_capturedUniforms.data(), vertexSize,
+                                    _capturedUniforms.data() + vertexSize, _capturedUniforms.size() - vertexSize);
+}
+
 MeshCommand::~MeshCommand()
 {
 #if CC_ENABLE_CACHE_TEXTURE_DATA
@@ -26,6 +26,7 @@
 #pragma once
 
 #include <unordered_map>
+#include <vector>
 #include "renderer/CCRenderCommand.h"
 #include "renderer/CCRenderState.h"
 #include "renderer/backend/ProgramState.h"
@@ -68,11 +69,22 @@ public:
 
     void init(float globalZOrder, const Mat4 &transform);
 
+    /**
+     * Copy the uniforms of the ProgramState. The renderer calls it when the command is added, so the
+     * uniforms written by the meshes sharing the ProgramState later in the frame are not lost.
+     */
+    void captureUniforms();
+    /** Get the uniforms copied by captureUniforms(), the vertex uniforms followed by the fragment ones. */
+    const std::vector<char>& getCapturedUniforms() const { return _capturedUniforms; }
+    /** Write the uniforms copied by captureUniforms() back to the ProgramState. */
+    void restoreUniforms() const;
+
 #if CC_ENABLE_CACHE_TEXTURE_DATA
     void listenRendererRecreated(EventCustom* event);
 #endif
 
 protected:
+    std::vector<char> _capturedUniforms;
 #if CC_ENABLE_CACHE_TEXTURE_DATA
     EventListenerCustom* _rendererRecreatedListener;
 #endif
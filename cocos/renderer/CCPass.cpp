@@ -150,6 +150,8 @@ void Pass::initUniformLocations()
 {
     auto *ps = _programState;
 
+    _instanced = ps->getAttributeLocation(backend::Attribute::INSTANCE) >= 0;
+
     _locMVPMatrix = ps->getUniformLocation("u_MVPMatrix");
     _locMVMatrix = ps->getUniformLocation("u_MVMatrix");
     _locPMatrix = ps->getUniformLocation("u_PMatrix");
@@ -201,6 +203,13 @@ void Pass::draw(MeshCommand *meshCommand, float globalZOrder, backend::Buffer* v
 void Pass::updateMVPUniform(const Mat4& modelView)
 {
     auto &matrixP = Director::getInstance()->getMatrix(MATRIX_STACK_TYPE::MATRIX_STACK_PROJECTION);
+    if (_instanced)
+    {
+        // the renderer supplies the model matrices of the instances
+        _programState->setUniform(_locMVPMatrix, matrixP.m, sizeof(matrixP.m));
+        return;
+    }
+
     auto mvp = matrixP * modelView;
     _programState->setUniform(_locMVPMatrix, mvp.m, sizeof(mvp.m));
     if (_locMVMatrix)
@@ -145,6 +145,9 @@ private:
     void onBeforeVisitCmd(MeshCommand *);
     void onAfterVisitCmd(MeshCommand *);
 
+    // the program reads the model matrix from the a_instance attribute, u_MVPMatrix holds the projection only
+    bool _instanced = false;
+
     backend::UniformLocation _locMVPMatrix;
     backend::UniformLocation _locMVMatrix;
     backend::UniformLocation _locPMatrix;
@@ -93,12 +93,19 @@ public:
     void set3D(bool value) { _is3D = value; }
     /**Get the depth by current model view matrix.*/
     float getDepth() const { return _depth; }
+    /**
+     Get the packed key the render queue sorts the command by: queue group, global order or depth,
+     and submission order. It is set when the command is added to a render queue.
+     */
+    uint64_t getSortKey() const { return _sortKey; }
     /// Can use the result to change the descriptor content.
     inline PipelineDescriptor& getPipelineDescriptor() { return _pipelineDescriptor; }
 
     const Mat4 & getMV() const { return _mv; }
 
 protected:
+    friend class RenderQueue;
+
     /**Constructor.*/
     RenderCommand();
     /**Destructor.*/
@@ -127,6 +134,9 @@ protected:
     /** Depth from the model view matrix.*/
     float _depth = 0.f;
 
+    /** Key the render queue sorts by.*/
+    uint64_t _sortKey = 0;
+
     Mat4 _mv;
 
     PipelineDescriptor _pipelineDescriptor;
@@ -42,6 +42,8 @@
 #include "base/CCEventDispatcher.h"
 #include "base/CCEventListenerCustom.h"
 #include "base/CCEventType.h"
+#include "base/CCParallelTaskPool.h"
+#include "base/CCFrameProfiler.h"
 #include "2d/CCCamera.h"
 #include "2d/CCScene.h"
 #include "xxhash.h"
@@ -61,6 +63,65 @@ static bool compare3DCommand(RenderCommand* a, RenderCommand* b)
     return  a->getDepth() > b->getDepth();
 }
 
+// Sort key: queue group (3 bits) | global order or depth (32 bits) | submission order (29 bits).
+// The submission order makes every key unique, so any sort of the keys is stable and tells where the command was.
+static const int SORT_KEY_GROUP_SHIFT = 61;
+static const int SORT_KEY_ORDER_SHIFT = 29;
+static const uint64_t SORT_KEY_SUBMISSION_MASK = (1ull << SORT_KEY_ORDER_SHIFT) - 1;
+// Below this many commands std::sort of the keys beats the radix passes.
+static const size_t RADIX_SORT_MIN_COMMANDS = 256;
+
+// Maps a float to bits which compare as unsigned integers like the floats do.
+static uint32_t getOrderedBits(float value)
+{
+    // -0.0 has the sign bit set, but it is equal to 0.0
+    if (value == 0)
+        value = 0.0f;
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return (bits & 0x80000000u) ? ~bits : bits | 0x80000000u;
+}
+
+// Stable LSD radix sort, 8 bits per pass. The passes over bytes which are the same in all keys are skipped,
+// so usually only the bytes of the submission order and of a few distinct global orders are sorted.
+static void radixSort(std::vector<uint64_t>& keys, std::vector<uint64_t>& buffer)
+{
+    const size_t count = keys.size();
+    if (count < RADIX_SORT_MIN_COMMANDS)
+    {
+        std::sort(keys.begin(), keys.end());
+        return;
+    }
+
+    uint32_t histograms[8][256] = {};
+    for (auto key : keys)
+    {
+        for (int pass = 0; pass < 8; ++pass)
+            ++histograms[pass][(key >> (pass * 8)) & 0xff];
+    }
+
+    buffer.resize(count);
+    for (int pass = 0; pass < 8; ++pass)
+    {
+        const int shift = pass * 8;
+        auto& histogram = histograms[pass];
+        if (histogram[(keys[0] >> shift) & 0xff] == count)
+            continue;
+
+        uint32_t offset = 0;
+        for (auto& bucket : histogram)
+        {
+            uint32_t bucketSize = bucket;
+            bucket = offset;
+            offset += bucketSize;
+        }
+
+        for (auto key : keys)
+            buffer[histogram[(key >> shift) & 0xff]++] = key;
+        keys.swap(buffer);
+    }
+}
+
 // queue
 RenderQueue::RenderQueue()
 {
@@ -68,14 +129,18 @@ RenderQueue::RenderQueue()
 
 void RenderQueue::push_back(RenderCommand* command)
 {
+    QUEUE_GROUP group;
+    uint32_t order = 0;
     float z = command->getGlobalOrder();
     if(z < 0)
     {
-        _commands[QUEUE_GROUP::GLOBALZ_NEG].push_back(command);
+        group = QUEUE_GROUP::GLOBALZ_NEG;
+        order = getOrderedBits(z);
     }
     else if(z > 0)
     {
-        _commands[QUEUE_GROUP::GLOBALZ_POS].push_back(command);
+        group = QUEUE_GROUP::GLOBALZ_POS;
+        order = getOrderedBits(z);
     }
     else
     {
@@ -83,18 +148,30 @@ void RenderQueue::push_back(RenderCommand* command)
         {
             if(command->isTransparent())
             {
-                _commands[QUEUE_GROUP::TRANSPARENT_3D].push_back(command);
+                // back to front
+                group = QUEUE_GROUP::TRANSPARENT_3D;
+                order = ~getOrderedBits(command->getDepth());
             }
             else
             {
-                _commands[QUEUE_GROUP::OPAQUE_3D].push_back(command);
+                // submission order, the commands may rely on the state set by the ones before
+                group = QUEUE_GROUP::OPAQUE_3D;
             }
         }
         else
         {
-            _commands[QUEUE_GROUP::GLOBALZ_ZERO].push_back(command);
+            group = QUEUE_GROUP::GLOBALZ_ZERO;
         }
     }
+
+    auto& commands = _commands[group];
+    CCASSERT(commands.size() <= SORT_KEY_SUBMISSION_MASK, "Too many render commands in a render queue");
+    command->_sortKey = (static_cast<uint64_t>(group) << SORT_KEY_GROUP_SHIFT)
+                      | (static_cast<uint64_t>(order) << SORT_KEY_ORDER_SHIFT)
+                      | commands.size();
+    if (group != QUEUE_GROUP::GLOBALZ_ZERO && group != QUEUE_GROUP::OPAQUE_3D)
+        _sortKeys[group].push_back(command->_sortKey);
+    commands.push_back(command);
 }
 
 ssize_t RenderQueue::size() const
@@ -110,10 +187,40 @@ ssize_t RenderQueue::size() const
 
 void RenderQueue::sort()
 {
-    // Don't sort _queue0, it already comes sorted
-    std::stable_sort(std::begin(_commands[QUEUE_GROUP::TRANSPARENT_3D]), std::end(_commands[QUEUE_GROUP::TRANSPARENT_3D]), compare3DCommand);
-    std::stable_sort(std::begin(_commands[QUEUE_GROUP::GLOBALZ_NEG]), std::end(_commands[QUEUE_GROUP::GLOBALZ_NEG]), compareRenderCommand);
-    std::stable_sort(std::begin(_commands[QUEUE_GROUP::GLOBALZ_POS]), std::end(_commands[QUEUE_GROUP::GLOBALZ_POS]), compareRenderCommand);
+    // Don't sort _queue0 and the opaque 3D queue, they already come sorted
+    sort(QUEUE_GROUP::TRANSPARENT_3D);
+    sort(QUEUE_GROUP::GLOBALZ_NEG);
+    sort(QUEUE_GROUP::GLOBALZ_POS);
+}
+
+void RenderQueue::sort(QUEUE_GROUP group)
+{
+    auto& commands = _commands[group];
+    auto& keys = _sortKeys[group];
+    if (commands.size() < 2)
+        return;
+
+    // Commands were added to the sub queue directly, so they have no keys.
+    if (keys.size() != commands.size())
+    {
+        if (group == QUEUE_GROUP::TRANSPARENT_3D)
+            std::stable_sort(std::begin(commands), std::end(commands), compare3DCommand);
+        else
+            std::stable_sort(std::begin(commands), std::end(commands), compareRenderCommand);
+        return;
+    }
+
+    radixSort(keys, _sortBuffer);
+
+    const size_t count = commands.size();
+    _sortedCommands.resize(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        _sortedCommands[i] = commands[keys[i] & SORT_KEY_SUBMISSION_MASK];
+        // the submission order of the sorted queue, in case it is sorted again
+        keys[i] = (keys[i] & ~SORT_KEY_SUBMISSION_MASK) | i;
+    }
+    commands.swap(_sortedCommands);
 }
 
 RenderCommand* RenderQueue::operator[](ssize_t index) const
@@ -137,6 +244,7 @@ void RenderQueue::clear()
     for(int i = 0; i < QUEUE_GROUP::QUEUE_COUNT; ++i)
     {
         _commands[i].clear();
+        _sortKeys[i].clear();
     }
 }
 
@@ -146,6 +254,7 @@ void RenderQueue::realloc(size_t reserveSize)
     {
         _commands[i] = std::vector<RenderCommand*>();
         _commands[i].reserve(reserveSize);
+        _sortKeys[i] = std::vector<uint64_t>();
     }
 }
 
@@ -153,6 +262,10 @@ void RenderQueue::realloc(size_t reserveSize)
 //
 //
 static const int DEFAULT_RENDER_QUEUE = 0;
+// Below this many queued vertices waking the worker threads costs more than it saves.
+static const unsigned int PARALLEL_FILL_MIN_VERTICES = 4096;
+// Minimum number of TrianglesCommands filled by one worker task.
+static const size_t PARALLEL_FILL_GRAIN = 64;
 
 //
 // constructors, destructor, init
@@ -166,6 +279,7 @@ Renderer::Renderer()
     RenderQueue defaultRenderQueue;
     _renderGroups.push_back(defaultRenderQueue);
     _queuedTriangleCommands.reserve(BATCH_TRIAGCOMMAND_RESERVED_SIZE);
+    _queuedFillOffsets.reserve(BATCH_TRIAGCOMMAND_RESERVED_SIZE);
 
     // for the batched TriangleCommand
     _triBatchesToDraw = (TriBatchToDraw*) malloc(sizeof(_triBatchesToDraw[0]) * _triBatchesToDrawCapacity);
@@ -180,19 +294,74 @@ Renderer::~Renderer()
     
     CC_SAFE_RELEASE(_commandBuffer);
     CC_SAFE_RELEASE(_renderPipeline);
+    CC_SAFE_RELEASE(_instanceBuffer);
 }
 
-void Renderer::init()
+void Renderer::setTrianglesBatchFormat(backend::IndexFormat format, unsigned int vertexCapacity)
 {
-    // Should invoke _triangleCommandBufferManager.init() first.
-    _triangleCommandBufferManager.init();
+    CCASSERT(!_isRendering, "Cannot change the triangles batch format while rendering");
+    _triIndexFormat = format;
+    _triVertexCapacity = (format == backend::IndexFormat::U_INT) ? vertexCapacity : VBO_SIZE;
+    _triIndexCapacity = _triVertexCapacity * 6 / 4;
+
+    // already initialized, recreate the buffers now
+    if (_commandBuffer)
+        initTrianglesBatch();
+}
+
+void Renderer::setTrianglesStreaming(bool enabled)
+{
+    CCASSERT(!_isRendering, "Cannot change the triangles buffers while rendering");
+    if (_triStreaming == enabled)
+        return;
+
+    _triStreaming = enabled;
+    if (_commandBuffer)
+        initTrianglesBatch();
+}
+
+void Renderer::initTrianglesBatch()
+{
+    if (_triIndexFormat == backend::IndexFormat::U_INT &&
+        !backend::Device::getInstance()->getDeviceInfo()->checkForFeatureSupported(backend::FeatureType::ELEMENT_INDEX_UINT))
+    {
+        CCLOG("warning: 32 bit indices are not supported, batching triangles with 16 bit indices");
+        _triIndexFormat = backend::IndexFormat::U_SHORT;
+        _triVertexCapacity = VBO_SIZE;
+        _triIndexCapacity = INDEX_VBO_SIZE;
+    }
+
+    _verts.resize(_triVertexCapacity);
+    _verts.shrink_to_fit();
+    if (_triIndexFormat == backend::IndexFormat::U_INT)
+    {
+        _indices = std::vector<unsigned short>();
+        _indices32.resize(_triIndexCapacity);
+    }
+    else
+    {
+        _indices32 = std::vector<unsigned int>();
+        _indices.resize(_triIndexCapacity);
+    }
+
+    _triangleCommandBufferManager.init(_triVertexCapacity, _triIndexCapacity, getTrianglesIndexSize(),
+                                       _triStreaming ? backend::BufferUsage::STREAM : backend::BufferUsage::DYNAMIC);
     _vertexBuffer = _triangleCommandBufferManager.getVertexBuffer();
     _indexBuffer = _triangleCommandBufferManager.getIndexBuffer();
+    _queuedTotalIndexCount = _queuedTotalVertexCount = 0;
+    _queuedIndexCount = _queuedVertexCount = 0;
+}
+
+void Renderer::init()
+{
+    // Should invoke _triangleCommandBufferManager.init() first.
+    initTrianglesBatch();
 
     auto device = backend::Device::getInstance();
     _commandBuffer = device->newCommandBuffer();
     _renderPipeline = device->newRenderPipeline();
     _commandBuffer->setRenderPipeline(_renderPipeline);
+    _instancingSupported = device->getDeviceInfo()->checkForFeatureSupported(backend::FeatureType::INSTANCED_DRAW);
 }
 
 void Renderer::addCommand(RenderCommand* command)
@@ -207,6 +376,10 @@ void Renderer::addCommand(RenderCommand* command, int renderQueueID)
     CCASSERT(renderQueueID >=0, "Invalid render queue");
     CCASSERT(command->getType() != RenderCommand::Type::UNKNOWN_COMMAND, "Invalid Command Type");
 
+    // the meshes sharing a ProgramState overwrite its uniforms while they are visited, keep the ones of this command
+    if (command->getType() == RenderCommand::Type::MESH_COMMAND && isInstancedMeshCommand(static_cast<MeshCommand*>(command)))
+        static_cast<MeshCommand*>(command)->captureUniforms();
+
     _renderGroups[renderQueueID].push_back(command);
 }
 
@@ -257,10 +430,10 @@ void Renderer::processRenderCommand(RenderCommand* command)
             auto cmd = static_cast<TrianglesCommand*>(command);
             
             // flush own queue when buffer is full
-            if(_queuedTotalVertexCount + cmd->getVertexCount() > VBO_SIZE || _queuedTotalIndexCount + cmd->getIndexCount() > INDEX_VBO_SIZE)
+            if(_queuedTotalVertexCount + cmd->getVertexCount() > _triVertexCapacity || _queuedTotalIndexCount + cmd->getIndexCount() > _triIndexCapacity)
             {
-                CCASSERT(cmd->getVertexCount()>= 0 && cmd->getVertexCount() < VBO_SIZE, "VBO for vertex is not big enough, please break the data down or use customized render command");
-                CCASSERT(cmd->getIndexCount()>= 0 && cmd->getIndexCount() < INDEX_VBO_SIZE, "VBO for index is not big enough, please break the data down or use customized render command");
+                CCASSERT(cmd->getVertexCount()>= 0 && cmd->getVertexCount() < _triVertexCapacity, "VBO for vertex is not big enough, please break the data down or use customized render command");
+                CCASSERT(cmd->getIndexCount()>= 0 && cmd->getIndexCount() < _triIndexCapacity, "VBO for index is not big enough, please break the data down or use customized render command");
                 drawBatchedTriangles();
 
                 _queuedTotalIndexCount = _queuedTotalVertexCount = 0;
@@ -284,8 +457,27 @@ void Renderer::processRenderCommand(RenderCommand* command)
         }
             break;
         case RenderCommand::Type::MESH_COMMAND:
+        {
             flush2D();
-            drawMeshCommand(command);
+
+            auto cmd = static_cast<MeshCommand*>(command);
+            if (!isInstancedMeshCommand(cmd))
+            {
+                flush3D();
+                drawMeshCommand(command);
+            }
+            else if (cmd->isSkipBatching())
+            {
+                // transparent, keep the order
+                flush3D();
+                _queuedMeshCommands.push_back(cmd);
+                flush3D();
+            }
+            else
+            {
+                _queuedMeshCommands.push_back(cmd);
+            }
+        }
             break;
         case RenderCommand::Type::GROUP_COMMAND:
             processGroupCommand(static_cast<GroupCommand*>(command));
@@ -297,6 +489,7 @@ void Renderer::processRenderCommand(RenderCommand* command)
         case RenderCommand::Type::CALLBACK_COMMAND:
             flush();
            static_cast<CallbackCommand*>(command)->execute();
+            invalidateState();
             break;
         case RenderCommand::Type::CAPTURE_SCREEN_COMMAND:
             flush();
@@ -359,6 +552,7 @@ void Renderer::doVisitRenderQueue(const std::vector<RenderCommand*>& renderComma
 
 void Renderer::render()
 {
+    CC_PROFILE_ZONE("Renderer::render");
     //TODO: setup camera or MVP
     _isRendering = true;
 //    if (_glViewAssigned)
@@ -408,6 +602,7 @@ void Renderer::clean()
 
     // Clear batch commands
     _queuedTriangleCommands.clear();
+    _queuedMeshCommands.clear();
 }
 
 void Renderer::setDepthTest(bool value)
@@ -518,6 +713,21 @@ unsigned int Renderer::getStencilReferenceValue() const
     return _stencilRef;
 }
 
+const backend::StreamStats& Renderer::getStreamStats() const
+{
+    return backend::Buffer::getStreamStats();
+}
+
+void Renderer::invalidateState()
+{
+    _commandBuffer->invalidateState();
+}
+
+const backend::StateStats& Renderer::getStateStats() const
+{
+    return _commandBuffer->getStateStats();
+}
+
 void Renderer::setViewPort(int x, int y, unsigned int w, unsigned int h)
 {
     _viewport.x = x;
@@ -526,28 +736,64 @@ void Renderer::setViewPort(int x, int y, unsigned int w, unsigned int h)
     _viewport.h = h;
 }
 
-void Renderer::fillVerticesAndIndices(const TrianglesCommand* cmd, unsigned int vertexBufferOffset)
+void Renderer::fillVerticesAndIndices(const TrianglesCommand* cmd, unsigned int vertexBufferOffset, const TriFillOffset& fillOffset)
 {
     size_t vertexCount = cmd->getVertexCount();
-    memcpy(&_verts[_filledVertex], cmd->getVertices(), sizeof(V3F_C4B_T2F) * vertexCount);
+    V3F_C4B_T2F* verts = &_verts[fillOffset.vertex];
+    memcpy(verts, cmd->getVertices(), sizeof(V3F_C4B_T2F) * vertexCount);
     
     // fill vertex, and convert them to world coordinates
-    const Mat4& modelView = cmd->getModelView();
-    for (size_t i=0; i < vertexCount; ++i)
-    {
-        modelView.transformPoint(&(_verts[i + _filledVertex].vertices));
-    }
+    cmd->getModelView().transformPoints(&verts->vertices, vertexCount, sizeof(V3F_C4B_T2F));
     
     // fill index
     const unsigned short* indices = cmd->getIndices();
     size_t indexCount = cmd->getIndexCount();
-    for (size_t i = 0; i < indexCount; ++i)
+    const unsigned int indexBase = vertexBufferOffset + fillOffset.vertex;
+    if (_triIndexFormat == backend::IndexFormat::U_INT)
     {
-        _indices[_filledIndex + i] = vertexBufferOffset + _filledVertex + indices[i];
+        unsigned int* dstIndices = &_indices32[fillOffset.index];
+        for (size_t i = 0; i < indexCount; ++i)
+        {
+            dstIndices[i] = indexBase + indices[i];
+        }
+    }
+    else
+    {
+        unsigned short* dstIndices = &_indices[fillOffset.index];
+        for (size_t i = 0; i < indexCount; ++i)
+        {
+            dstIndices[i] = indexBase + indices[i];
+        }
     }
-    
-    _filledVertex += vertexCount;
-    _filledIndex += indexCount;
+}
+
+unsigned int Renderer::getTrianglesIndexSize() const
+{
+    return _triIndexFormat == backend::IndexFormat::U_INT ? sizeof(unsigned int) : sizeof(unsigned short);
+}
+
+void* Renderer::getTrianglesIndexData()
+{
+    if (_triIndexFormat == backend::IndexFormat::U_INT)
+        return _indices32.data();
+    return _indices.data();
+}
+
+void Renderer::fillQueuedTriangles(unsigned int vertexBufferOffset)
+{
+    // Every command writes to its own range of _verts and _indices, so they can be filled in any order.
+    auto fillRange = [this, vertexBufferOffset](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i)
+        {
+            fillVerticesAndIndices(_queuedTriangleCommands[i], vertexBufferOffset, _queuedFillOffsets[i]);
+        }
+    };
+
+    const size_t commandCount = _queuedTriangleCommands.size();
+    if (_vertexFillThreads > 1 && _filledVertex >= PARALLEL_FILL_MIN_VERTICES)
+        ParallelTaskPool::getInstance()->parallelFor(commandCount, PARALLEL_FILL_GRAIN, fillRange, _vertexFillThreads);
+    else
+        fillRange(0, commandCount);
 }
 
 void Renderer::drawBatchedTriangles()
@@ -575,12 +821,20 @@ void Renderer::drawBatchedTriangles()
     _filledVertex = 0;
     _filledIndex = 0;
 
+    // Only reserve the output range of each command here, the vertices are filled afterwards.
+    _queuedFillOffsets.resize(_queuedTriangleCommands.size());
+    size_t cmdIndex = 0;
+
     for(const auto& cmd : _queuedTriangleCommands)
     {
         auto currentMaterialID = cmd->getMaterialID();
         const bool batchable = !cmd->isSkipBatching();
         
-        fillVerticesAndIndices(cmd, vertexBufferFillOffset);
+        auto& fillOffset = _queuedFillOffsets[cmdIndex++];
+        fillOffset.vertex = _filledVertex;
+        fillOffset.index = _filledIndex;
+        _filledVertex += cmd->getVertexCount();
+        _filledIndex += cmd->getIndexCount();
         
         // in the same batch ?
         if (batchable && (prevMaterialID == currentMaterialID || firstCommand))
@@ -617,26 +871,41 @@ void Renderer::drawBatchedTriangles()
         firstCommand = false;
     }
     batchesTotal++;
+
+    fillQueuedTriangles(vertexBufferFillOffset);
+
+    const unsigned int indexSize = getTrianglesIndexSize();
+    std::size_t vertexStreamOffset = 0;
+    std::size_t indexStreamOffset = 0;
 #ifdef CC_USE_METAL
-    _vertexBuffer->updateSubData(_verts, vertexBufferFillOffset * sizeof(_verts[0]), _filledVertex * sizeof(_verts[0]));
-    _indexBuffer->updateSubData(_indices, indexBufferFillOffset * sizeof(_indices[0]), _filledIndex * sizeof(_indices[0]));
+    _vertexBuffer->updateSubData(_verts.data(), vertexBufferFillOffset * sizeof(_verts[0]), _filledVertex * sizeof(_verts[0]));
+    _indexBuffer->updateSubData(getTrianglesIndexData(), indexBufferFillOffset * indexSize, _filledIndex * indexSize);
 #else
-    _vertexBuffer->updateData(_verts, _filledVertex * sizeof(_verts[0]));
-    _indexBuffer->updateData(_indices,  _filledIndex * sizeof(_indices[0]));
+    if (_triStreaming)
+    {
+        // the indices start at 0, the vertices are drawn from their offset in the stream
+        vertexStreamOffset = _vertexBuffer->streamData(_verts.data(), _filledVertex * sizeof(_verts[0]));
+        indexStreamOffset = _indexBuffer->streamData(getTrianglesIndexData(), _filledIndex * indexSize);
+    }
+    else
+    {
+        _vertexBuffer->updateData(_verts.data(), _filledVertex * sizeof(_verts[0]));
+        _indexBuffer->updateData(getTrianglesIndexData(), _filledIndex * indexSize);
+    }
 #endif
 
     /************** 2: Draw *************/
     for (int i = 0; i < batchesTotal; ++i)
     {
         beginRenderPass(_triBatchesToDraw[i].cmd);
-        _commandBuffer->setVertexBuffer(_vertexBuffer);
+        _commandBuffer->setVertexBuffer(_vertexBuffer, vertexStreamOffset);
         _commandBuffer->setIndexBuffer(_indexBuffer);
         auto& pipelineDescriptor = _triBatchesToDraw[i].cmd->getPipelineDescriptor();
         _commandBuffer->setProgramState(pipelineDescriptor.programState);
         _commandBuffer->drawElements(backend::PrimitiveType::TRIANGLE,
-                                     backend::IndexFormat::U_SHORT,
+                                     _triIndexFormat,
                                      _triBatchesToDraw[i].indicesToDraw,
-                                     _triBatchesToDraw[i].offset * sizeof(_indices[0]));
+                                     indexStreamOffset + _triBatchesToDraw[i].offset * indexSize);
         _commandBuffer->endRenderPass();
 
         _drawnBatches++;
@@ -655,11 +924,18 @@ void Renderer::drawBatchedTriangles()
 void Renderer::drawCustomCommand(RenderCommand *command)
 {
     auto cmd = static_cast<CustomCommand*>(command);
+    // the callbacks of a MeshCommand belong to its Pass, which changes the state through the renderer only
+    const bool ownCallbacks = command->getType() == RenderCommand::Type::CUSTOM_COMMAND;
 
-    if (cmd->getBeforeCallback()) cmd->getBeforeCallback()();
+    if (cmd->getBeforeCallback())
+    {
+        cmd->getBeforeCallback()();
+        if (ownCallbacks)
+            invalidateState();
+    }
 
     beginRenderPass(command);
-    _commandBuffer->setVertexBuffer(cmd->getVertexBuffer());
+    _commandBuffer->setVertexBuffer(cmd->getVertexBuffer(), cmd->getVertexBufferOffset());
     _commandBuffer->setProgramState(cmd->getPipelineDescriptor().programState);
     
     auto drawType = cmd->getDrawType();
@@ -670,7 +946,7 @@ void Renderer::drawCustomCommand(RenderCommand *command)
         _commandBuffer->drawElements(cmd->getPrimitiveType(),
                                      cmd->getIndexFormat(),
                                      cmd->getIndexDrawCount(),
-                                     cmd->getIndexDrawOffset());
+                                     cmd->getIndexBufferOffset() + cmd->getIndexDrawOffset());
         _drawnVertices += cmd->getIndexDrawCount();
     }
     else
@@ -683,7 +959,12 @@ void Renderer::drawCustomCommand(RenderCommand *command)
     _drawnBatches++;
     _commandBuffer->endRenderPass();
 
-    if (cmd->getAfterCallback()) cmd->getAfterCallback()();
+    if (cmd->getAfterCallback())
+    {
+        cmd->getAfterCallback()();
+        if (ownCallbacks)
+            invalidateState();
+    }
 }
 
 void Renderer::drawMeshCommand(RenderCommand *command)
@@ -692,6 +973,33 @@ void Renderer::drawMeshCommand(RenderCommand *command)
     drawCustomCommand(command);
 }
 
+void Renderer::drawMeshInstances(MeshCommand* cmd, unsigned int firstInstance, unsigned int instanceCount)
+{
+    // the state of the first command is used for all the instances, they all have the same uniforms.
+    // The before callback sets the matrices, so they are restored first.
+    cmd->restoreUniforms();
+    if (cmd->getBeforeCallback()) cmd->getBeforeCallback()();
+
+    beginRenderPass(cmd);
+    _commandBuffer->setVertexBuffer(cmd->getVertexBuffer());
+    _commandBuffer->setProgramState(cmd->getPipelineDescriptor().programState);
+    _commandBuffer->setLineWidth(cmd->getLineWidth());
+    _commandBuffer->setIndexBuffer(cmd->getIndexBuffer());
+    _commandBuffer->setInstanceBuffer(_instanceBuffer, firstInstance * sizeof(Mat4));
+    _commandBuffer->drawElementsInstanced(cmd->getPrimitiveType(),
+                                          cmd->getIndexFormat(),
+                                          cmd->getIndexDrawCount(),
+                                          cmd->getIndexDrawOffset(),
+                                          instanceCount);
+    _drawnVertices += cmd->getIndexDrawCount() * instanceCount;
+    _drawnBatches++;
+    _drawnInstancedBatches++;
+    _drawnInstances += instanceCount;
+    _commandBuffer->endRenderPass();
+
+    if (cmd->getAfterCallback()) cmd->getAfterCallback()();
+}
+
 
 void Renderer::flush()
 {
@@ -706,7 +1014,81 @@ void Renderer::flush2D()
 
 void Renderer::flush3D()
 {
-    //TODO 3d batch rendering
+    if (_queuedMeshCommands.empty())
+        return;
+
+    // Group the commands drawing the same mesh with the same ProgramState (so the same material and state)
+    // and the same uniforms, the groups are drawn in the order of their first command.
+    _meshInstanceGroups.clear();
+    _queuedMeshGroups.resize(_queuedMeshCommands.size());
+    for (size_t i = 0, size = _queuedMeshCommands.size(); i < size; ++i)
+    {
+        const auto cmd = _queuedMeshCommands[i];
+        size_t group = 0;
+        const size_t groupCount = _meshInstanceGroups.size();
+        for (; group < groupCount; ++group)
+        {
+            const auto other = _meshInstanceGroups[group].cmd;
+            if (other->getPipelineDescriptor().programState == cmd->getPipelineDescriptor().programState &&
+                other->getVertexBuffer() == cmd->getVertexBuffer() &&
+                other->getIndexBuffer() == cmd->getIndexBuffer() &&
+                other->getIndexFormat() == cmd->getIndexFormat() &&
+                other->getPrimitiveType() == cmd->getPrimitiveType() &&
+                other->getIndexDrawOffset() == cmd->getIndexDrawOffset() &&
+                other->getIndexDrawCount() == cmd->getIndexDrawCount() &&
+                other->getCapturedUniforms() == cmd->getCapturedUniforms())
+                break;
+        }
+        if (group == groupCount)
+        {
+            MeshInstanceGroup newGroup;
+            newGroup.cmd = cmd;
+            _meshInstanceGroups.push_back(newGroup);
+        }
+        _meshInstanceGroups[group].instanceCount++;
+        _queuedMeshGroups[i] = static_cast<unsigned int>(group);
+    }
+
+    unsigned int firstInstance = 0;
+    for (auto& group : _meshInstanceGroups)
+    {
+        group.firstInstance = firstInstance;
+        firstInstance += group.instanceCount;
+        group.instanceCount = 0;
+    }
+
+    // the model matrices of a group are contiguous, upload them all at once
+    const auto instanceCount = static_cast<unsigned int>(_queuedMeshCommands.size());
+    _instanceTransforms.resize(instanceCount);
+    for (unsigned int i = 0; i < instanceCount; ++i)
+    {
+        auto& group = _meshInstanceGroups[_queuedMeshGroups[i]];
+        _instanceTransforms[group.firstInstance + group.instanceCount++] = _queuedMeshCommands[i]->getMV();
+    }
+
+    if (instanceCount > _instanceBufferCapacity)
+    {
+        CC_SAFE_RELEASE_NULL(_instanceBuffer);
+        _instanceBufferCapacity = std::max(instanceCount, _instanceBufferCapacity * 2);
+        _instanceBuffer = backend::Device::getInstance()->newBuffer(_instanceBufferCapacity * sizeof(Mat4), backend::BufferType::VERTEX, backend::BufferUsage::DYNAMIC);
+    }
+    _instanceBuffer->updateData(_instanceTransforms.data(), instanceCount * sizeof(Mat4));
+
+    for (const auto& group : _meshInstanceGroups)
+    {
+        drawMeshInstances(group.cmd, group.firstInstance, group.instanceCount);
+    }
+
+    _queuedMeshCommands.clear();
+}
+
+bool Renderer::isInstancedMeshCommand(MeshCommand* command) const
+{
+    if (!_instancingSupported || command->getDrawType() != CustomCommand::DrawType::ELEMENT)
+        return false;
+
+    auto programState = command->getPipelineDescriptor().programState;
+    return programState && programState->getAttributeLocation(backend::Attribute::INSTANCE) >= 0;
 }
 
 void Renderer::flushTriangles()
@@ -942,8 +1324,21 @@ Renderer::TriangleCommandBufferManager::~TriangleCommandBufferManager()
         indexBuffer->release();
 }
 
-void Renderer::TriangleCommandBufferManager::init()
+void Renderer::TriangleCommandBufferManager::init(unsigned int vertexCount, unsigned int indexCount, unsigned int indexSize, backend::BufferUsage usage)
 {
+    // drop the buffers of a previous configuration
+    for (auto& vertexBuffer : _vertexBufferPool)
+        vertexBuffer->release();
+    for (auto& indexBuffer : _indexBufferPool)
+        indexBuffer->release();
+    _vertexBufferPool.clear();
+    _indexBufferPool.clear();
+    _currentBufferIndex = 0;
+
+    _vertexCount = vertexCount;
+    _indexCount = indexCount;
+    _indexSize = indexSize;
+    _usage = usage;
     createBuffer();
 }
 
@@ -980,37 +1375,56 @@ void Renderer::TriangleCommandBufferManager::createBuffer()
 
 #ifdef CC_USE_METAL
     // Metal doesn't need to update buffer to make sure it has the correct size.
-    auto vertexBuffer = device->newBuffer(Renderer::VBO_SIZE * sizeof(_verts[0]), backend::BufferType::VERTEX, backend::BufferUsage::DYNAMIC);
+    auto vertexBuffer = device->newBuffer(_vertexCount * sizeof(V3F_C4B_T2F), backend::BufferType::VERTEX, backend::BufferUsage::DYNAMIC);
     if (!vertexBuffer)
         return;
 
-    auto indexBuffer = device->newBuffer(Renderer::INDEX_VBO_SIZE * sizeof(_indices[0]), backend::BufferType::INDEX, backend::BufferUsage::DYNAMIC);
+    auto indexBuffer = device->newBuffer(_indexCount * _indexSize, backend::BufferType::INDEX, backend::BufferUsage::DYNAMIC);
     if (!indexBuffer)
     {
         vertexBuffer->release();
         return;
     }
 #else
-    auto tmpData = malloc(Renderer::VBO_SIZE * sizeof(V3F_C4B_T2F));
+    if (backend::BufferUsage::STREAM == _usage)
+    {
+        // stream buffers allocate their storage on the first write
+        auto vertexBuffer = device->newBuffer(_vertexCount * sizeof(V3F_C4B_T2F), backend::BufferType::VERTEX, backend::BufferUsage::STREAM);
+        if (!vertexBuffer)
+            return;
+
+        auto indexBuffer = device->newBuffer(_indexCount * _indexSize, backend::BufferType::INDEX, backend::BufferUsage::STREAM);
+        if (!indexBuffer)
+        {
+            vertexBuffer->release();
+            return;
+        }
+
+        _vertexBufferPool.push_back(vertexBuffer);
+        _indexBufferPool.push_back(indexBuffer);
+        return;
+    }
+
+    auto tmpData = malloc(std::max(_vertexCount * sizeof(V3F_C4B_T2F), (size_t)_indexCount * _indexSize));
     if (!tmpData)
         return;
 
-    auto vertexBuffer = device->newBuffer(Renderer::VBO_SIZE * sizeof(V3F_C4B_T2F), backend::BufferType::VERTEX, backend::BufferUsage::DYNAMIC);
+    auto vertexBuffer = device->newBuffer(_vertexCount * sizeof(V3F_C4B_T2F), backend::BufferType::VERTEX, backend::BufferUsage::DYNAMIC);
     if (!vertexBuffer)
     {
         free(tmpData);
         return;
     }
-    vertexBuffer->updateData(tmpData, Renderer::VBO_SIZE * sizeof(V3F_C4B_T2F));
+    vertexBuffer->updateData(tmpData, _vertexCount * sizeof(V3F_C4B_T2F));
 
-    auto indexBuffer = device->newBuffer(Renderer::INDEX_VBO_SIZE * sizeof(unsigned short), backend::BufferType::INDEX, backend::BufferUsage::DYNAMIC);
+    auto indexBuffer = device->newBuffer(_indexCount * _indexSize, backend::BufferType::INDEX, backend::BufferUsage::DYNAMIC);
     if (! indexBuffer)
     {
         free(tmpData);
         vertexBuffer->release();
         return;
     }
-    indexBuffer->updateData(tmpData, Renderer::INDEX_VBO_SIZE * sizeof(unsigned short));
+    indexBuffer->updateData(tmpData, _indexCount * _indexSize);
 
     free(tmpData);
 #endif
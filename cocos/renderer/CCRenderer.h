@@ -28,6 +28,7 @@
 #include <stack>
 #include <array>
 #include <deque>
+#include <algorithm>
 
 #include "platform/CCPlatformMacros.h"
 #include "renderer/CCRenderCommand.h"
@@ -50,6 +51,8 @@ namespace backend
     class RenderPipeline;
     class RenderPass;
     struct RenderPipelineDescriptor;
+    struct StreamStats;
+    struct StateStats;
 }
 
 class EventListenerCustom;
@@ -63,7 +66,8 @@ class Texture2D;
 /** Class that knows how to sort `RenderCommand` objects.
  Since the commands that have `z == 0` are "pushed back" in
  the correct order, the only `RenderCommand` objects that need to be sorted,
- are the ones that have `z < 0` and `z > 0`.
+ are the ones that have `z < 0` and `z > 0`, and the transparent 3D ones by depth.
+ The sort keys are packed into 64 bits when the commands are added and sorted with a stable radix sort.
 */
 class RenderQueue
 {
@@ -107,8 +111,16 @@ public:
     ssize_t getSubQueueSize(QUEUE_GROUP group) const { return _commands[group].size(); }
     
 protected:
+    /**Sort the render commands of a group.*/
+    void sort(QUEUE_GROUP group);
+
     /**The commands in the render queue.*/
     std::vector<RenderCommand*> _commands[QUEUE_COUNT];
+    /**The sort keys of the commands, in the same order. The GLOBALZ_ZERO group has none.*/
+    std::vector<uint64_t> _sortKeys[QUEUE_COUNT];
+    /**Scratch buffers of the sort.*/
+    std::vector<uint64_t> _sortBuffer;
+    std::vector<RenderCommand*> _sortedCommands;
     
     /**Cull state.*/
     bool _isCullEnabled;
@@ -133,6 +145,8 @@ public:
     static const int VBO_SIZE = 65536;
     /**The max number of indices in a index buffer.*/
     static const int INDEX_VBO_SIZE = VBO_SIZE * 6 / 4;
+    /**The default max number of vertices in a vertex buffer object when batching with 32 bit indices.*/
+    static const int LARGE_VBO_SIZE = VBO_SIZE * 4;
     /**The rendercommands which can be batched will be saved into a list, this is the reserved size of this list.*/
     static const int BATCH_TRIAGCOMMAND_RESERVED_SIZE = 64;
     /**Reserved for material id, which means that the command could not be batched.*/
@@ -145,6 +159,35 @@ public:
     //TODO: manage GLView inside Render itself
     void init();
 
+    /**
+     * Set the index format and the max number of vertices of one batch of TrianglesCommands.
+     * IndexFormat::U_SHORT (the default) limits a batch to VBO_SIZE vertices. IndexFormat::U_INT allows bigger
+     * batches, so big tilemaps, particle fields and labels are drawn with less draw calls, at the cost of memory.
+     * Falls back to U_SHORT if the device doesn't support 32 bit indices. Can be called before init(), or between
+     * frames, in which case the batch buffers are recreated.
+     * @param format The index format of batched triangles.
+     * @param vertexCapacity The max number of vertices of one batch, only used with IndexFormat::U_INT.
+     */
+    void setTrianglesBatchFormat(backend::IndexFormat format, unsigned int vertexCapacity = LARGE_VBO_SIZE);
+
+    /** Get the index format of batched triangles. */
+    backend::IndexFormat getTrianglesIndexFormat() const { return _triIndexFormat; }
+
+    /** Get the max number of vertices of one batch of TrianglesCommands. */
+    unsigned int getTrianglesVertexCapacity() const { return _triVertexCapacity; }
+
+    /**
+     * Whether the vertices and indices of batched TrianglesCommands go to BufferUsage::STREAM buffers (the default).
+     * Every batch is then appended to the region of the frame, instead of reallocating the whole buffer with
+     * glBufferData for each batch, and the driver never waits for the GPU to finish the previous frames.
+     * Only used by the OpenGL backend, Metal always writes to per frame buffers.
+     * @param enabled Stream the batches if true, otherwise upload them to dynamic buffers.
+     */
+    void setTrianglesStreaming(bool enabled);
+
+    /** Whether the batched TrianglesCommands are streamed. */
+    bool isTrianglesStreaming() const { return _triStreaming; }
+
     /** Adds a `RenderComamnd` into the renderer */
     void addCommand(RenderCommand* command);
 
@@ -174,8 +217,41 @@ public:
     ssize_t getDrawnVertices() const { return _drawnVertices; }
     /* RenderCommands (except) TrianglesCommand should update this value */
     void addDrawnVertices(ssize_t number) { _drawnVertices += number; };
+    /* returns the number of instanced draw calls in the last frame, they are included in getDrawnBatches() */
+    ssize_t getDrawnInstancedBatches() const { return _drawnInstancedBatches; }
+    /* returns the number of MeshCommands drawn by the instanced draw calls in the last frame */
+    ssize_t getDrawnInstances() const { return _drawnInstances; }
     /* clear draw stats */
-    void clearDrawStats() { _drawnBatches = _drawnVertices = 0; }
+    void clearDrawStats() { _drawnBatches = _drawnVertices = _drawnInstancedBatches = _drawnInstances = 0; }
+    /** Get the bytes uploaded to the BufferUsage::STREAM buffers, and the stalls they avoided, in the last frame. */
+    const backend::StreamStats& getStreamStats() const;
+    /**
+     * Forget the render state the backend assumes is set. Call it after using the graphics API directly,
+     * otherwise the backend may skip state changes it takes for redundant. CallbackCommands and the callbacks
+     * of CustomCommands are followed by it already.
+     */
+    void invalidateState();
+    /** Get the numbers of state changes sent to the driver and filtered out as redundant in the last frame. */
+    const backend::StateStats& getStateStats() const;
+
+    /**
+     * Set the number of threads used to fill the vertices and indices of batched TrianglesCommands.
+     * 1 (the default) fills them on the render thread, larger values split the commands across the
+     * ParallelTaskPool. The batches drawn are the same in both cases.
+     * @param threads The number of threads including the render thread.
+     */
+    void setVertexFillThreads(int threads) { _vertexFillThreads = std::max(threads, 1); }
+    /** Get the number of threads used to fill the vertices and indices of batched TrianglesCommands. */
+    int getVertexFillThreads() const { return _vertexFillThreads; }
+
+    /**
+     * Whether MeshCommands using an instanced program (one with an `a_instance` attribute, like
+     * ProgramType::POSITION_TEXTURE_3D_INSTANCE) are drawn with hardware instancing.
+     * MeshCommands sharing mesh, ProgramState, uniforms and draw range are then merged into one draw call.
+     * Without backend::FeatureType::INSTANCED_DRAW the instanced programs are not available and
+     * every MeshCommand is drawn on its own.
+     */
+    bool isMeshInstancingSupported() const { return _instancingSupported; }
 
     /**
      Set render targets. If not set, will use default render targets. It will effect all commands.
@@ -419,10 +495,14 @@ protected:
         ~TriangleCommandBufferManager();
 
         /**
-         * Create a new vertex buffer and a index buffer and push it to cache.
+         * Create a new vertex buffer and a index buffer and push it to cache, releasing the buffers created before.
          * @note Should invoke firstly.
+         * @param vertexCount The number of vertices of a vertex buffer.
+         * @param indexCount The number of indices of an index buffer.
+         * @param indexSize The size of one index in bytes.
+         * @param usage BufferUsage::STREAM or BufferUsage::DYNAMIC, Metal always uses BufferUsage::DYNAMIC.
          */
-        void init();
+        void init(unsigned int vertexCount, unsigned int indexCount, unsigned int indexSize, backend::BufferUsage usage);
 
         /**
          * Reset avalable buffer index to zero.
@@ -442,6 +522,10 @@ protected:
         void createBuffer();
 
         int _currentBufferIndex = 0;
+        unsigned int _vertexCount = 0;
+        unsigned int _indexCount = 0;
+        unsigned int _indexSize = 0;
+        backend::BufferUsage _usage = backend::BufferUsage::DYNAMIC;
         std::vector<backend::Buffer*> _vertexBufferPool;
         std::vector<backend::Buffer*> _indexBufferPool;
     };
@@ -450,6 +534,8 @@ protected:
     void drawBatchedTriangles();
     void drawCustomCommand(RenderCommand* command);
     void drawMeshCommand(RenderCommand* command);
+    void drawMeshInstances(MeshCommand* command, unsigned int firstInstance, unsigned int instanceCount);
+    bool isInstancedMeshCommand(MeshCommand* command) const;
     void captureScreen(RenderCommand* command);
 
     void beginFrame(); /// Indicate the begining of a frame
@@ -469,7 +555,18 @@ protected:
     void visitRenderQueue(RenderQueue& queue);
     void doVisitRenderQueue(const std::vector<RenderCommand*>&);
 
-    void fillVerticesAndIndices(const TrianglesCommand* cmd, unsigned int vertexBufferOffset);
+    // Where the vertices and indices of a queued TrianglesCommand go in _verts and _indices.
+    struct TriFillOffset
+    {
+        unsigned int vertex = 0;
+        unsigned int index = 0;
+    };
+
+    void fillVerticesAndIndices(const TrianglesCommand* cmd, unsigned int vertexBufferOffset, const TriFillOffset& fillOffset);
+    void fillQueuedTriangles(unsigned int vertexBufferOffset);
+    void initTrianglesBatch();
+    unsigned int getTrianglesIndexSize() const;
+    void* getTrianglesIndexData();
     void beginRenderPass(RenderCommand*); /// Begin a render pass.
     
     /**
@@ -495,10 +592,35 @@ protected:
     std::vector<RenderQueue> _renderGroups;
 
     std::vector<TrianglesCommand*> _queuedTriangleCommands;
+    std::vector<TriFillOffset> _queuedFillOffsets;
+
+    // MeshCommands drawn with the same instanced draw call, their model matrices are at
+    // [firstInstance, firstInstance + instanceCount) of _instanceTransforms.
+    struct MeshInstanceGroup
+    {
+        MeshCommand* cmd = nullptr;
+        unsigned int firstInstance = 0;
+        unsigned int instanceCount = 0;
+    };
+
+    //for instanced MeshCommands
+    std::vector<MeshCommand*> _queuedMeshCommands;
+    std::vector<unsigned int> _queuedMeshGroups;
+    std::vector<MeshInstanceGroup> _meshInstanceGroups;
+    std::vector<Mat4> _instanceTransforms;
+    backend::Buffer* _instanceBuffer = nullptr;
+    unsigned int _instanceBufferCapacity = 0;
+    bool _instancingSupported = false;
 
     //for TrianglesCommand
-    V3F_C4B_T2F _verts[VBO_SIZE];
-    unsigned short _indices[INDEX_VBO_SIZE];
+    std::vector<V3F_C4B_T2F> _verts;
+    std::vector<unsigned short> _indices;
+    // used instead of _indices with IndexFormat::U_INT
+    std::vector<unsigned int> _indices32;
+    backend::IndexFormat _triIndexFormat = backend::IndexFormat::U_SHORT;
+    unsigned int _triVertexCapacity = VBO_SIZE;
+    unsigned int _triIndexCapacity = INDEX_VBO_SIZE;
+    bool _triStreaming = true;
     backend::Buffer* _vertexBuffer = nullptr;
     backend::Buffer* _indexBuffer = nullptr;
     TriangleCommandBufferManager _triangleCommandBufferManager;
@@ -525,10 +647,13 @@ protected:
     unsigned int _queuedIndexCount = 0;
     unsigned int _filledIndex = 0;
     unsigned int _filledVertex = 0;
+    int _vertexFillThreads = 1;
 
     // stats
     unsigned int _drawnBatches = 0;
     unsigned int _drawnVertices = 0;
+    unsigned int _drawnInstancedBatches = 0;
+    unsigned int _drawnInstances = 0;
     //the flag for checking whether renderer is rendering
     bool _isRendering = false;
     bool _isDepthTestFor2D = false;
@@ -262,7 +262,6 @@ bool Texture2D::updateWithImage(Image* image, backend::PixelFormat format, int i
         return false;
     }
 
-    unsigned char* tempData = image->getData();
     Size             imageSize = Size((float)imageWidth, (float)imageHeight);
     backend::PixelFormat      renderFormat = ((PixelFormat::NONE == format) || (PixelFormat::AUTO == format)) ? image->getPixelFormat() : format;
     backend::PixelFormat      imagePixelFormat = image->getPixelFormat();
@@ -341,12 +340,34 @@ bool Texture2D::updateWithImage(Image* image, backend::PixelFormat format, int i
             CCLOG("cocos2d: WARNING: This image is compressed and we can't convert it for now");
         }
 
-        updateWithData(tempData, tempDataLen, image->getPixelFormat(), image->getPixelFormat(), imageWidth, imageHeight, imageSize, image->hasPremultipliedAlpha(), index);
+        updateWithData(image->getData(), tempDataLen, image->getPixelFormat(), image->getPixelFormat(), imageWidth, imageHeight, imageSize, image->hasPremultipliedAlpha(), index);
+    }
+    else if (image->isPremultiplyAlphaPending() && renderFormat != imagePixelFormat)
+    {
+        // the colors are multiplied by alpha in the same pass as the conversion, instead of a pass of their own
+        unsigned char* outData = nullptr;
+        size_t outDataLen = 0;
+        auto convertedFormat = backend::PixelFormatUtils::convertDataToFormat(image->getData(), tempDataLen, imagePixelFormat, renderFormat, &outData, &outDataLen, true);
+        if (outData != image->getData())
+        {
+            updateWithData(outData, outDataLen, convertedFormat, convertedFormat, imageWidth, imageHeight, imageSize, true, index);
+            free(outData);
+        }
+        else
+        {
+            // not converted, so not premultiplied either
+            image->premultiplyAlpha();
+            updateWithData(image->getData(), tempDataLen, imagePixelFormat, renderFormat, imageWidth, imageHeight, imageSize, image->hasPremultipliedAlpha(), index);
+        }
     }
     else
     {
+        if (image->isPremultiplyAlphaPending())
+        {
+            image->premultiplyAlpha();
+        }
         //after conversion, renderFormat == pixelFormat of data
-        updateWithData(tempData, tempDataLen, imagePixelFormat, renderFormat, imageWidth, imageHeight, imageSize, image->hasPremultipliedAlpha(), index);
+        updateWithData(image->getData(), tempDataLen, imagePixelFormat, renderFormat, imageWidth, imageHeight, imageSize, image->hasPremultipliedAlpha(), index);
     }
 
     _flagsAndFormatEXT |= formatEXT;
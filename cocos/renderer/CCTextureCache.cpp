@@ -32,6 +32,9 @@ THE SOFTWARE.
 #include <stack>
 #include <cctype>
 #include <list>
+#include <algorithm>
+#include <chrono>
+#include <unordered_set>
 
 #include "renderer/CCTexture2D.h"
 #include "base/ccMacros.h"
@@ -41,6 +44,7 @@ THE SOFTWARE.
 #include "platform/CCFileUtils.h"
 #include "base/ccUtils.h"
 #include "base/CCNinePatchImageParser.h"
+#include "base/CCFrameProfiler.h"
 #include "renderer/backend/Device.h"
 //#include "renderer/backend/StringUtils.h"
 
@@ -51,6 +55,15 @@ NS_CC_BEGIN
 
 std::string TextureCache::s_etc1AlphaFileSuffix = "@alpha";
 
+// how many evicted paths are kept to count their reloads
+static const size_t MAX_EVICTED_TEXTURES = 256;
+
+// whether a texture of the format converts an RGBA8888 png, which then premultiplies its colors in the same pass
+static bool convertsRGBA8888(backend::PixelFormat format)
+{
+    return format != backend::PixelFormat::NONE && format != backend::PixelFormat::AUTO && format != backend::PixelFormat::RGBA8888;
+}
+
 // implementation TextureCache
 
 void TextureCache::setETC1AlphaFileSuffix(const std::string& suffix)
@@ -64,9 +77,13 @@ std::string TextureCache::getETC1AlphaFileSuffix()
 }
 
 TextureCache::TextureCache()
-: _loadingThread(nullptr)
+: _loadingThreadCount(std::max(std::min(static_cast<int>(std::thread::hardware_concurrency()) - 1, 4), 1))
 , _needQuit(false)
 , _asyncRefCount(0)
+, _uploadTimeBudget(0)
+, _memoryBudget(0)
+, _evictionCount(0)
+, _reloadCount(0)
 {
 }
 
@@ -77,7 +94,7 @@ TextureCache::~TextureCache()
     for (auto& texture : _textures)
         texture.second->release();
 
-    CC_SAFE_DELETE(_loadingThread);
+    stopLoadingThreads();
 }
 
 std::string TextureCache::getDescription() const
@@ -103,6 +120,10 @@ public:
     Image imageAlpha;
     backend::PixelFormat pixelFormat;
     bool loadSuccess;
+    LoadPriority priority = LoadPriority::NORMAL;
+    // the request decoding the same file, nullptr if this one decodes it
+    AsyncStruct* decoder = nullptr;
+    bool cancelled = false;
 };
 
 /**
@@ -125,15 +146,15 @@ public:
  How to deal add image many times?
  - At first, this situation is abnormal, we only ensure the logic is correct.
  - If the image has been loaded, the after load image call will return immediately.
- - If the image request is in queue already, there will be more than one request in queue,
- - In addImageAsyncCallback, will deduplicate the request to ensure only create one texture.
+ - If the image request is in queue already, the new request waits in _asyncStructQueue for its image,
+ - In addImageAsyncCallback, the callbacks of all requests for the image are called with the same texture.
 
  Does process all response in addImageAsyncCallback consume more time?
- - Convert image to texture faster than load image from disk, so this isn't a
- problem.
+ - Convert image to texture faster than load image from disk, but large levels can
+ limit the time spent per frame with setUploadTimeBudget().
 
  Call unbindImageAsync(path) to prevent the call to the callback when the
- texture is loaded.
+ texture is loaded, or cancelImageAsync(path) to drop the request as well.
  */
 void TextureCache::addImageAsync(const std::string &path, const std::function<void(Texture2D*)>& callback)
 {
@@ -156,16 +177,17 @@ void TextureCache::addImageAsync(const std::string &path, const std::function<vo
  
  Note:
  - all AsyncStruct referenced in _asyncStructQueue, for unbind function use.
+ - the requests are decoded by several load threads, both queues are sorted by priority.
  
  How to deal add image many times?
  - At first, this situation is abnormal, we only ensure the logic is correct.
  - If the image has been loaded, the after load image call will return immediately.
- - If the image request is in queue already, there will be more than one request in queue,
- - In addImageAsyncCallback, will deduplicate the request to ensure only create one texture.
+ - If the image request is in queue already, the new request waits for it and raises its priority if needed,
+ - In addImageAsyncCallback, the callbacks of all requests for the image are called with the same texture.
  
  Does process all response in addImageAsyncCallback consume more time?
- - Convert image to texture faster than load image from disk, so this isn't a
- problem.
+ - Convert image to texture faster than load image from disk, but large levels can
+ limit the time spent per frame with setUploadTimeBudget().
 
  The callbackKey allows to unbind the callback in cases where the loading of
  path is requested by several sources simultaneously. Each source can then
@@ -173,6 +195,11 @@ void TextureCache::addImageAsync(const std::string &path, const std::function<vo
  unbindImageAsync(path) would be ambiguous.
  */
 void TextureCache::addImageAsync(const std::string &path, const std::function<void(Texture2D*)>& callback, const std::string& callbackKey)
+{
+    addImageAsync(path, callback, callbackKey, LoadPriority::NORMAL);
+}
+
+void TextureCache::addImageAsync(const std::string &path, const std::function<void(Texture2D*)>& callback, const std::string& callbackKey, LoadPriority priority)
 {
     Texture2D *texture = nullptr;
 
@@ -184,6 +211,7 @@ void TextureCache::addImageAsync(const std::string &path, const std::function<vo
 
     if (texture != nullptr)
     {
+        markTextureUsed(fullpath);
         if (callback) callback(texture);
         return;
     }
@@ -195,11 +223,10 @@ void TextureCache::addImageAsync(const std::string &path, const std::function<vo
     }
 
     // lazy init
-    if (_loadingThread == nullptr)
+    if (_loadingThreads.empty())
     {
-        // create a new thread to load images
-        _needQuit = false;
-        _loadingThread = new (std::nothrow) std::thread(&TextureCache::loadImage, this);
+        // create the threads to load images
+        startLoadingThreads();
     }
 
     if (0 == _asyncRefCount)
@@ -212,14 +239,55 @@ void TextureCache::addImageAsync(const std::string &path, const std::function<vo
     // generate async struct
     AsyncStruct *data =
       new (std::nothrow) AsyncStruct(fullpath, callback, callbackKey);
+    data->priority = priority;
     
     // add async struct into queue
     _asyncStructQueue.push_back(data);
+
+    auto decoding = _decodingAsyncStructs.find(fullpath);
+    if (decoding != _decodingAsyncStructs.end())
+    {
+        // wait for the queued request of the same file, and make it hurry if this one is more urgent
+        auto decoder = decoding->second;
+        data->decoder = decoder;
+        if (priority > decoder->priority)
+        {
+            std::unique_lock<std::mutex> ul(_requestMutex);
+            if (unqueueRequest(decoder))
+            {
+                decoder->priority = priority;
+                queueRequest(decoder);
+            }
+        }
+        return;
+    }
+
+    _decodingAsyncStructs.emplace(fullpath, data);
     std::unique_lock<std::mutex> ul(_requestMutex);
-    _requestQueue.push_back(data);
+    queueRequest(data);
     _sleepCondition.notify_one();
 }
 
+void TextureCache::queueRequest(AsyncStruct* asyncStruct)
+{
+    // behind the requests of the same priority
+    auto it = std::find_if(_requestQueue.begin(), _requestQueue.end(), [asyncStruct](AsyncStruct* queued) {
+        return queued->priority < asyncStruct->priority;
+    });
+    _requestQueue.insert(it, asyncStruct);
+}
+
+bool TextureCache::unqueueRequest(AsyncStruct* asyncStruct)
+{
+    // not found if a load thread took it already
+    auto it = std::find(_requestQueue.begin(), _requestQueue.end(), asyncStruct);
+    if (it == _requestQueue.end())
+        return false;
+
+    _requestQueue.erase(it);
+    return true;
+}
+
 void TextureCache::unbindImageAsync(const std::string& callbackKey)
 {
     if (_asyncStructQueue.empty())
@@ -249,33 +317,132 @@ void TextureCache::unbindAllImageAsync()
     }
 }
 
-void TextureCache::loadImage()
+void TextureCache::cancelImageAsync(const std::string& callbackKey)
 {
-    AsyncStruct *asyncStruct = nullptr;
-    while (!_needQuit)
+    for (auto& asyncStruct : _asyncStructQueue)
     {
-        std::unique_lock<std::mutex> ul(_requestMutex);
-        // pop an AsyncStruct from request queue
-        if (_requestQueue.empty())
+        if (asyncStruct->callbackKey == callbackKey)
         {
-            asyncStruct = nullptr;
+            asyncStruct->callback = nullptr;
+            asyncStruct->cancelled = true;
         }
-        else
+    }
+    removeCancelledAsyncStructs();
+}
+
+void TextureCache::cancelAllImageAsync()
+{
+    for (auto& asyncStruct : _asyncStructQueue)
+    {
+        asyncStruct->callback = nullptr;
+        asyncStruct->cancelled = true;
+    }
+    removeCancelledAsyncStructs();
+}
+
+void TextureCache::removeCancelledAsyncStructs()
+{
+    // the requests waiting for an image are only referenced by _asyncStructQueue
+    std::unordered_set<AsyncStruct*> neededDecoders;
+    for (auto it = _asyncStructQueue.begin(); it != _asyncStructQueue.end();)
+    {
+        auto asyncStruct = *it;
+        if (asyncStruct->decoder && asyncStruct->cancelled)
         {
-            asyncStruct = _requestQueue.front();
-            _requestQueue.pop_front();
+            delete asyncStruct;
+            --_asyncRefCount;
+            it = _asyncStructQueue.erase(it);
+            continue;
         }
+        if (asyncStruct->decoder)
+            neededDecoders.insert(asyncStruct->decoder);
+        ++it;
+    }
 
-        if (nullptr == asyncStruct) {
-            if (_needQuit) {
-                break;
-            }
-            _sleepCondition.wait(ul);
+    // the decoding requests nobody needs anymore are dropped unless a load thread took them already
+    std::unique_lock<std::mutex> ul(_requestMutex);
+    for (auto it = _asyncStructQueue.begin(); it != _asyncStructQueue.end();)
+    {
+        auto asyncStruct = *it;
+        if (!asyncStruct->decoder && asyncStruct->cancelled
+            && neededDecoders.find(asyncStruct) == neededDecoders.end() && unqueueRequest(asyncStruct))
+        {
+            _decodingAsyncStructs.erase(asyncStruct->filename);
+            delete asyncStruct;
+            --_asyncRefCount;
+            it = _asyncStructQueue.erase(it);
             continue;
         }
+        ++it;
+    }
+    ul.unlock();
+
+    if (0 == _asyncRefCount)
+    {
+        Director::getInstance()->getScheduler()->unschedule(CC_SCHEDULE_SELECTOR(TextureCache::addImageAsyncCallBack), this);
+    }
+}
+
+void TextureCache::setLoadingThreads(int threads)
+{
+    threads = std::max(threads, 1);
+    if (threads == _loadingThreadCount)
+        return;
+
+    _loadingThreadCount = threads;
+    if (!_loadingThreads.empty())
+    {
+        // the queued requests stay in _requestQueue for the new threads
+        stopLoadingThreads();
+        startLoadingThreads();
+    }
+}
+
+void TextureCache::startLoadingThreads()
+{
+    _needQuit = false;
+    for (int i = static_cast<int>(_loadingThreads.size()); i < _loadingThreadCount; ++i)
+    {
+        _loadingThreads.emplace_back(&TextureCache::loadImage, this);
+    }
+}
+
+void TextureCache::stopLoadingThreads()
+{
+    // notify sub threads to quit
+    std::unique_lock<std::mutex> ul(_requestMutex);
+    _needQuit = true;
+    _sleepCondition.notify_all();
+    ul.unlock();
+
+    for (auto& thread : _loadingThreads)
+    {
+        thread.join();
+    }
+    _loadingThreads.clear();
+}
+
+void TextureCache::loadImage()
+{
+    CC_PROFILE_THREAD("TextureCache");
+    AsyncStruct *asyncStruct = nullptr;
+    while (true)
+    {
+        std::unique_lock<std::mutex> ul(_requestMutex);
+        _sleepCondition.wait(ul, [this]{ return _needQuit || !_requestQueue.empty(); });
+        if (_needQuit)
+        {
+            break;
+        }
+
+        // pop the most urgent AsyncStruct from request queue
+        asyncStruct = _requestQueue.front();
+        _requestQueue.pop_front();
         ul.unlock();
 
+        CC_PROFILE_ZONE("TextureCache::loadImage");
         // load image
+        asyncStruct->image.setPremultiplyAlphaDeferred(convertsRGBA8888(asyncStruct->pixelFormat));
         asyncStruct->loadSuccess = asyncStruct->image.initWithImageFileThreadSafe(asyncStruct->filename);
 
         // ETC1 ALPHA supports.
@@ -285,17 +452,23 @@ void TextureCache::loadImage()
             if (FileUtils::getInstance()->isFileExist(alphaFile))
                 asyncStruct->imageAlpha.initWithImageFileThreadSafe(alphaFile);
         }
-        // push the asyncStruct to response queue
+        // push the asyncStruct to response queue, behind the responses of the same priority
         _responseMutex.lock();
-        _responseQueue.push_back(asyncStruct);
+        auto it = std::find_if(_responseQueue.begin(), _responseQueue.end(), [asyncStruct](AsyncStruct* response) {
+            return response->priority < asyncStruct->priority;
+        });
+        _responseQueue.insert(it, asyncStruct);
         _responseMutex.unlock();
     }
 }
 
 void TextureCache::addImageAsyncCallBack(float /*dt*/)
 {
+    CC_PROFILE_ZONE("TextureCache::addImageAsyncCallBack");
+    auto begin = std::chrono::steady_clock::now();
     Texture2D *texture = nullptr;
     AsyncStruct *asyncStruct = nullptr;
+    std::vector<AsyncStruct*> asyncStructs;
     while (true)
     {
         // pop an AsyncStruct from response queue
@@ -308,10 +481,6 @@ void TextureCache::addImageAsyncCallBack(float /*dt*/)
         {
             asyncStruct = _responseQueue.front();
             _responseQueue.pop_front();
-
-            // the asyncStruct's sequence order in _asyncStructQueue must equal to the order in _responseQueue
-            CC_ASSERT(asyncStruct == _asyncStructQueue.front());
-            _asyncStructQueue.pop_front();
         }
         _responseMutex.unlock();
 
@@ -319,11 +488,35 @@ void TextureCache::addImageAsyncCallBack(float /*dt*/)
             break;
         }
 
+        // collect the requests of the image in the order they were made
+        bool needed = false;
+        asyncStructs.clear();
+        for (auto it = _asyncStructQueue.begin(); it != _asyncStructQueue.end();)
+        {
+            if (*it == asyncStruct || (*it)->decoder == asyncStruct)
+            {
+                needed = needed || !(*it)->cancelled;
+                asyncStructs.push_back(*it);
+                it = _asyncStructQueue.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+        _decodingAsyncStructs.erase(asyncStruct->filename);
+
         // check the image has been convert to texture or not
         auto it = _textures.find(asyncStruct->filename);
         if (it != _textures.end())
         {
             texture = it->second;
+            markTextureUsed(asyncStruct->filename);
+        }
+        else if (!needed)
+        {
+            // all requests were cancelled while decoding
+            texture = nullptr;
         }
         else
         {
@@ -342,8 +535,8 @@ void TextureCache::addImageAsyncCallBack(float /*dt*/)
                 VolatileTextureMgr::addImageTexture(texture, asyncStruct->filename);
 #endif
                 // cache the texture. retain it, since it is added in the map
-                _textures.emplace(asyncStruct->filename, texture);
                 texture->retain();
+                addCachedTexture(asyncStruct->filename, texture);
 
                 texture->autorelease();
                 // ETC1 ALPHA supports.
@@ -357,15 +550,24 @@ void TextureCache::addImageAsyncCallBack(float /*dt*/)
             }
         }
 
-        // call callback function
-        if (asyncStruct->callback)
+        for (auto request : asyncStructs)
         {
-            (asyncStruct->callback)(texture);
+            // call callback function
+            if (request->callback)
+            {
+                (request->callback)(texture);
+            }
+
+            // release the asyncStruct
+            delete request;
+            --_asyncRefCount;
         }
 
-        // release the asyncStruct
-        delete asyncStruct;
-        --_asyncRefCount;
+        // the other images are uploaded in the next frames
+        if (_uploadTimeBudget > 0 && std::chrono::duration<float>(std::chrono::steady_clock::now() - begin).count() >= _uploadTimeBudget)
+        {
+            break;
+        }
     }
 
     if (0 == _asyncRefCount)
@@ -376,6 +578,7 @@ void TextureCache::addImageAsyncCallBack(float /*dt*/)
 
 Texture2D * TextureCache::addImage(const std::string &path)
 {
+    CC_PROFILE_ZONE("TextureCache::addImage");
     Texture2D * texture = nullptr;
     Image* image = nullptr;
     // Split up directory and filename
@@ -389,7 +592,10 @@ Texture2D * TextureCache::addImage(const std::string &path)
     }
     auto it = _textures.find(fullpath);
     if (it != _textures.end())
+    {
         texture = it->second;
+        markTextureUsed(fullpath);
+    }
 
     if (!texture)
     {
@@ -399,6 +605,7 @@ Texture2D * TextureCache::addImage(const std::string &path)
             image = new (std::nothrow) Image();
             CC_BREAK_IF(nullptr == image);
 
+            image->setPremultiplyAlphaDeferred(convertsRGBA8888(Texture2D::getDefaultAlphaPixelFormat()));
             bool bRet = image->initWithImageFile(fullpath);
             CC_BREAK_IF(!bRet);
 
@@ -411,7 +618,7 @@ Texture2D * TextureCache::addImage(const std::string &path)
                 VolatileTextureMgr::addImageTexture(texture, fullpath);
 #endif
                 // texture already retained, no need to re-retain it
-                _textures.emplace(fullpath, texture);
+                addCachedTexture(fullpath, texture);
 
                 //-- ANDROID ETC1 ALPHA SUPPORTS.
                 std::string alphaFullPath = path + s_etc1AlphaFileSuffix;
@@ -464,6 +671,7 @@ Texture2D* TextureCache::addImage(Image *image, const std::string &key)
         auto it = _textures.find(key);
         if (it != _textures.end()) {
             texture = it->second;
+            markTextureUsed(key);
             break;
         }
 
@@ -473,7 +681,7 @@ Texture2D* TextureCache::addImage(Image *image, const std::string &key)
         {
             if (texture->initWithImage(image))
             {
-                _textures.emplace(key, texture);
+                addCachedTexture(key, texture);
             }
             else
             {
@@ -543,6 +751,8 @@ void TextureCache::removeAllTextures()
         texture.second->release();
     }
     _textures.clear();
+    _lastUsedFrames.clear();
+    _evictedTextures.clear();
 }
 
 void TextureCache::removeUnusedTextures()
@@ -607,7 +817,10 @@ Texture2D* TextureCache::getTextureForKey(const std::string &textureKeyName) con
     }
 
     if (it != _textures.end())
+    {
+        markTextureUsed(key);
         return it->second;
+    }
     return nullptr;
 }
 
@@ -626,12 +839,7 @@ std::string TextureCache::getTextureFilePath(cocos2d::Texture2D* texture) const
 
 void TextureCache::waitForQuit()
 {
-    // notify sub thread to quick
-    std::unique_lock<std::mutex> ul(_requestMutex);
-    _needQuit = true;
-    _sleepCondition.notify_one();
-    ul.unlock();
-    if (_loadingThread) _loadingThread->join();
+    stopLoadingThreads();
 }
 
 std::string TextureCache::getCachedTextureInfo() const
@@ -640,7 +848,8 @@ std::string TextureCache::getCachedTextureInfo() const
     char buftmp[4096];
 
     unsigned int count = 0;
-    unsigned int totalBytes = 0;
+    size_t totalBytes = 0;
+    unsigned int frame = Director::getInstance()->getTotalFrames();
 
     for (auto& texture : _textures) {
 
@@ -649,18 +858,22 @@ std::string TextureCache::getCachedTextureInfo() const
 
         Texture2D* tex = texture.second;
         unsigned int bpp = tex->getBitsPerPixelForFormat();
-        // Each texture takes up width * height * bytesPerPixel bytes.
-        auto bytes = tex->getPixelsWide() * tex->getPixelsHigh() * bpp / 8;
+        auto bytes = getTextureBytes(tex);
         totalBytes += bytes;
         count++;
-        snprintf(buftmp, sizeof(buftmp) - 1, "\"%s\" rc=%lu id=%p %lu x %lu @ %ld bpp => %lu KB\n",
+
+        auto lastUsed = _lastUsedFrames.find(texture.first);
+        // referenced textures are in use right now
+        unsigned int framesUnused = (tex->getReferenceCount() > 1 || lastUsed == _lastUsedFrames.end()) ? 0 : frame - lastUsed->second;
+        snprintf(buftmp, sizeof(buftmp) - 1, "\"%s\" rc=%lu id=%p %lu x %lu @ %ld bpp => %lu KB, unused for %u frames\n",
             texture.first.c_str(),
             (long)tex->getReferenceCount(),
             tex->getBackendTexture(),
             (long)tex->getPixelsWide(),
             (long)tex->getPixelsHigh(),
             (long)bpp,
-            (long)bytes / 1024);
+            (long)bytes / 1024,
+            framesUnused);
 
         buffer += buftmp;
     }
@@ -668,9 +881,142 @@ std::string TextureCache::getCachedTextureInfo() const
     snprintf(buftmp, sizeof(buftmp) - 1, "TextureCache dumpDebugInfo: %ld textures, for %lu KB (%.2f MB)\n", (long)count, (long)totalBytes / 1024, totalBytes / (1024.0f*1024.0f));
     buffer += buftmp;
 
+    if (_memoryBudget > 0)
+    {
+        snprintf(buftmp, sizeof(buftmp) - 1, "TextureCache budget: %.2f MB, %u evictions, %u reloads\n", _memoryBudget / (1024.0f*1024.0f), _evictionCount, _reloadCount);
+        buffer += buftmp;
+    }
+
     return buffer;
 }
 
+size_t TextureCache::getTextureBytes(Texture2D* texture)
+{
+    // Each texture takes up width * height * bytesPerPixel bytes, the mipmaps a third more.
+    size_t bytes = static_cast<size_t>(texture->getPixelsWide()) * texture->getPixelsHigh() * texture->getBitsPerPixelForFormat() / 8;
+    if (texture->hasMipmaps())
+        bytes += bytes / 3;
+    return bytes;
+}
+
+void TextureCache::addCachedTexture(const std::string& key, Texture2D* texture)
+{
+    _textures.emplace(key, texture);
+    markTextureUsed(key);
+
+    auto evicted = std::find(_evictedTextures.begin(), _evictedTextures.end(), key);
+    if (evicted != _evictedTextures.end())
+    {
+        _evictedTextures.erase(evicted);
+        ++_reloadCount;
+    }
+
+    if (_memoryBudget > 0)
+        enforceMemoryBudget();
+}
+
+void TextureCache::markTextureUsed(const std::string& key) const
+{
+    if (_memoryBudget > 0)
+        _lastUsedFrames[key] = Director::getInstance()->getTotalFrames();
+}
+
+void TextureCache::setMemoryBudget(size_t bytes)
+{
+    if (bytes > 0 && _memoryBudget == 0)
+        Director::getInstance()->getScheduler()->schedule(CC_SCHEDULE_SELECTOR(TextureCache::checkMemoryBudget), this, 0, false);
+    else if (bytes == 0 && _memoryBudget > 0)
+        Director::getInstance()->getScheduler()->unschedule(CC_SCHEDULE_SELECTOR(TextureCache::checkMemoryBudget), this);
+
+    _memoryBudget = bytes;
+    if (_memoryBudget > 0)
+    {
+        enforceMemoryBudget();
+    }
+    else
+    {
+        _lastUsedFrames.clear();
+        _evictedTextures.clear();
+    }
+}
+
+size_t TextureCache::getMemoryUsage() const
+{
+    size_t bytes = 0;
+    for (auto& texture : _textures)
+        bytes += getTextureBytes(texture.second);
+    return bytes;
+}
+
+void TextureCache::checkMemoryBudget(float /*dt*/)
+{
+    enforceMemoryBudget();
+}
+
+void TextureCache::enforceMemoryBudget()
+{
+    struct Candidate
+    {
+        unsigned int lastUsedFrame;
+        size_t bytes;
+        const std::string* key;
+    };
+    static std::vector<Candidate> candidates;
+
+    unsigned int frame = Director::getInstance()->getTotalFrames();
+    size_t totalBytes = 0;
+    candidates.clear();
+    for (auto& texture : _textures)
+    {
+        auto bytes = getTextureBytes(texture.second);
+        totalBytes += bytes;
+
+        auto& lastUsedFrame = _lastUsedFrames.emplace(texture.first, frame).first->second;
+        // referenced by nodes, or by the code which just requested it
+        if (texture.second->getReferenceCount() > 1)
+            lastUsedFrame = frame;
+        else if (lastUsedFrame != frame)
+            candidates.push_back({lastUsedFrame, bytes, &texture.first});
+    }
+
+    // forget the textures removed from the cache
+    if (_lastUsedFrames.size() > _textures.size())
+    {
+        for (auto it = _lastUsedFrames.begin(); it != _lastUsedFrames.end();)
+        {
+            if (_textures.find(it->first) == _textures.end())
+                it = _lastUsedFrames.erase(it);
+            else
+                ++it;
+        }
+    }
+
+    if (totalBytes <= _memoryBudget)
+        return;
+
+    std::sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) {
+        return a.lastUsedFrame < b.lastUsedFrame;
+    });
+
+    for (const auto& candidate : candidates)
+    {
+        if (totalBytes <= _memoryBudget)
+            break;
+
+        std::string key = *candidate.key;
+        auto it = _textures.find(key);
+        CCLOGINFO("TextureCache: evicting %s, unused for %u frames", key.c_str(), frame - candidate.lastUsedFrame);
+        it->second->release();
+        _textures.erase(it);
+        _lastUsedFrames.erase(key);
+        if (_evictedTextures.size() == MAX_EVICTED_TEXTURES)
+            _evictedTextures.pop_front();
+        _evictedTextures.push_back(key);
+        totalBytes -= candidate.bytes;
+        ++_evictionCount;
+    }
+}
+
 void TextureCache::renameTextureWithKey(const std::string& srcName, const std::string& dstName)
 {
     std::string key = srcName;
@@ -33,8 +33,10 @@ THE SOFTWARE.
 #include <thread>
 #include <condition_variable>
 #include <queue>
+#include <vector>
 #include <string>
 #include <unordered_map>
+#include <deque>
 #include <functional>
 
 #include "base/CCRef.h"
@@ -67,6 +69,14 @@ public:
     static void setETC1AlphaFileSuffix(const std::string& suffix);
     static std::string getETC1AlphaFileSuffix();
 
+    /** Order in which the asynchronous loads are decoded and uploaded, higher priorities first. */
+    enum class LoadPriority
+    {
+        PREFETCH,   ///< needed later, e.g. by the next level
+        NORMAL,     ///< the default of addImageAsync()
+        VISIBLE,    ///< needed for what is on screen now
+    };
+
 public:
     /**
      * @js ctor
@@ -107,6 +117,15 @@ public:
     
     void addImageAsync(const std::string &path, const std::function<void(Texture2D*)>& callback, const std::string& callbackKey );
 
+    /** Loads a texture asynchronously like addImageAsync(), queued by priority.
+    * Loading a path which is already queued doesn't decode it twice, the queued request takes the higher priority.
+     @param path The file path.
+     @param callback A callback function would be invoked after the image is loaded.
+     @param callbackKey The key to unbind or cancel the callback with.
+     @param priority Requests of higher priority are decoded and uploaded first.
+    */
+    void addImageAsync(const std::string &path, const std::function<void(Texture2D*)>& callback, const std::string& callbackKey, LoadPriority priority);
+
     /** Unbind a specified bound image asynchronous callback.
      * In the case an object who was bound to an image asynchronous callback was destroyed before the callback is invoked,
      * the object always need to unbind this callback manually.
@@ -120,6 +139,34 @@ public:
      */
     virtual void unbindAllImageAsync();
 
+    /** Cancels the asynchronous loads bound to callbackKey, their callbacks won't be called.
+    * Requests which no worker has picked up yet are dropped, for instance when leaving a scene.
+    * Images being decoded are not turned into textures unless another request still needs them.
+    * @param callbackKey The callbackKey given to addImageAsync(), the path by default.
+    */
+    void cancelImageAsync(const std::string& callbackKey);
+
+    /** Cancels all asynchronous loads, see cancelImageAsync(). */
+    void cancelAllImageAsync();
+
+    /** Sets the number of threads decoding the asynchronous loads.
+    * Running threads finish their current image and are replaced, queued requests are kept.
+    * @param threads The number of threads, at least 1.
+    */
+    void setLoadingThreads(int threads);
+
+    /** Gets the number of threads decoding the asynchronous loads. */
+    int getLoadingThreads() const { return _loadingThreadCount; }
+
+    /** Sets the time the main thread may spend on turning decoded images into textures per frame.
+    * At least one texture is uploaded per frame, the rest waits for the next frames.
+    * @param seconds The time per frame, 0 (the default) uploads all decoded images right away.
+    */
+    void setUploadTimeBudget(float seconds) { _uploadTimeBudget = seconds; }
+
+    /** Gets the time the main thread may spend on uploads per frame, 0 means unlimited. */
+    float getUploadTimeBudget() const { return _uploadTimeBudget; }
+
     /** Returns a Texture2D object given an Image.
     * If the image was not previously loaded, it will create a new Texture2D object and it will return it.
     * Otherwise it will return a reference of a previously loaded image.
@@ -174,6 +221,30 @@ public:
     */
     std::string getCachedTextureInfo() const;
 
+    /** Sets how much memory the cached textures should use.
+    * While the cache is over budget, the textures only referenced by the cache are evicted, least recently used
+    * first. Textures referenced by nodes are never evicted, so the budget may be exceeded. An evicted texture is
+    * released at once, nothing reloads it until the next addImage() or addImageAsync() of its path.
+    * The budget is checked every frame and when a texture is added.
+    * @param bytes The budget in bytes, 0 (the default) disables it.
+    */
+    void setMemoryBudget(size_t bytes);
+
+    /** Gets the memory budget of the cached textures in bytes, 0 if disabled. */
+    size_t getMemoryBudget() const { return _memoryBudget; }
+
+    /** Gets the memory used by the cached textures in bytes. */
+    size_t getMemoryUsage() const;
+
+    /** Gets the number of textures evicted to stay within the memory budget. */
+    unsigned int getEvictionCount() const { return _evictionCount; }
+
+    /** Gets the number of evicted textures which were loaded again, among the last 256 evicted paths. */
+    unsigned int getReloadCount() const { return _reloadCount; }
+
+    /** Evicts the least recently used textures nobody else references until the cache fits in the memory budget. */
+    void enforceMemoryBudget();
+
     //Wait for texture cache to quit before destroy instance.
     /**Called by director, please do not called outside.*/
     void waitForQuit();
@@ -201,16 +272,29 @@ public:
 private:
     void addImageAsyncCallBack(float dt);
     void loadImage();
+    void startLoadingThreads();
+    void stopLoadingThreads();
+    void checkMemoryBudget(float dt);
+    void addCachedTexture(const std::string& key, Texture2D* texture);
+    void markTextureUsed(const std::string& key) const;
+    static size_t getTextureBytes(Texture2D* texture);
     void parseNinePatchImage(Image* image, Texture2D* texture, const std::string& path);
 public:
 protected:
     struct AsyncStruct;
+
+    void queueRequest(AsyncStruct* asyncStruct);
+    bool unqueueRequest(AsyncStruct* asyncStruct);
+    void removeCancelledAsyncStructs();
     
-    std::thread* _loadingThread;
+    std::vector<std::thread> _loadingThreads;
+    int _loadingThreadCount;
 
     std::deque<AsyncStruct*> _asyncStructQueue;
+    // sorted by priority, every path is decoded by one request, the others wait for it in _asyncStructQueue
     std::deque<AsyncStruct*> _requestQueue;
     std::deque<AsyncStruct*> _responseQueue;
+    std::unordered_map<std::string, AsyncStruct*> _decodingAsyncStructs;
 
     std::mutex _requestMutex;
     std::mutex _responseMutex;
@@ -220,9 +304,18 @@ protected:
     bool _needQuit;
 
     int _asyncRefCount;
+    float _uploadTimeBudget;
 
     std::unordered_map<std::string, Texture2D*> _textures;
 
+    // memory budget, the frame each texture was last referenced or requested
+    size_t _memoryBudget;
+    unsigned int _evictionCount;
+    unsigned int _reloadCount;
+    mutable std::unordered_map<std::string, unsigned int> _lastUsedFrames;
+    // the last evicted paths, oldest first, to count their reloads
+    std::deque<std::string> _evictedTextures;
+
     static std::string s_etc1AlphaFileSuffix;
 };
 
@@ -23,17 +23,417 @@
  ****************************************************************************/
  
 #include "CCTextureUtils.h"
+#include "base/CCParallelTaskPool.h"
+#include <string.h>
+#include <algorithm>
+#include <atomic>
 
+//#define USE_PIXEL_AVX2    : AVX2 kernels, 8 pixels per step
+//#define USE_PIXEL_SSE2    : SSE2 kernels, 4 pixels per step
+//#define USE_PIXEL_NEON    : NEON kernels, 4 pixels per step
+//#define USE_PIXEL_SIMD    : one of them is used
+// Like the MathUtil ones they are picked at compile time, AVX2 is used when the engine is built with -mavx2 (/arch:AVX2).
+
+#if defined (__AVX2__)
+#define USE_PIXEL_AVX2
+#elif defined (__SSE2__) || defined (_M_X64) || (defined (_M_IX86_FP) && _M_IX86_FP >= 2)
+#define USE_PIXEL_SSE2
+#elif defined (__ARM_NEON) || defined (__ARM_NEON__)
+#define USE_PIXEL_NEON
+#endif
+
+#if defined (USE_PIXEL_AVX2) || defined (USE_PIXEL_SSE2)
+#define USE_PIXEL_SIMD
+#include "renderer/CCTextureUtilsSSE.inl"
+#elif defined (USE_PIXEL_NEON)
+#define USE_PIXEL_SIMD
+#include "renderer/CCTextureUtilsNeon.inl"
+#endif
 
 NS_CC_BEGIN
 
 namespace backend { namespace PixelFormatUtils {
     
+    // Images with fewer pixels are converted on the calling thread, waking up the workers would cost more.
+    static const size_t PARALLEL_CONVERSION_MIN_PIXELS = 256 * 256;
+    // Smallest stripe of pixels one thread converts.
+    static const size_t PARALLEL_CONVERSION_GRAIN = 16 * 1024;
+    // Pixels premultiplied at a time for the scalar converters.
+    static const size_t PREMULTIPLY_CHUNK_PIXELS = 64;
+    
+    static std::atomic<bool> s_simdEnabled(true);
+    static std::atomic<int> s_conversionThreads(0);
+    
+    void setSIMDEnabled(bool enabled)
+    {
+        s_simdEnabled = enabled;
+    }
+    
+    bool isSIMDEnabled()
+    {
+#ifdef USE_PIXEL_SIMD
+        return s_simdEnabled;
+#else
+        return false;
+#endif
+    }
+    
+    const char* getSIMDName()
+    {
+#if defined (USE_PIXEL_AVX2)
+        return "AVX2";
+#elif defined (USE_PIXEL_SSE2)
+        return "SSE2";
+#elif defined (USE_PIXEL_NEON)
+        return "NEON";
+#else
+        return "none";
+#endif
+    }
+    
+    void setConversionThreads(int threads)
+    {
+        s_conversionThreads = std::max(threads, 0);
+    }
+    
+    int getConversionThreads()
+    {
+        return s_conversionThreads;
+    }
+    
+    //////////////////////////////////////////////////////////////////////////
+    // Pixel formats: the SIMD kernels read every source format into 32 bit RGBA lanes
+    // (R in the low byte) and write them out in the destination format. Each pair of load()
+    // and store() computes exactly what the scalar converter of that pair does.
+    
+    struct I8Pixels
+    {
+        enum { BYTES = 1, PADDING = 0 };
+#ifdef USE_PIXEL_SIMD
+        typedef PixelSimd S;
+        static inline S::Vec load(const unsigned char* p)
+        {
+            S::Vec i = S::load8(p);
+            return S::bitOr(S::bitOr(i, S::shiftLeft32<8>(i)), S::bitOr(S::shiftLeft32<16>(i), S::set1(0xFF000000)));
+        }
+        static inline void store(unsigned char* p, S::Vec v)
+        {
+            S::store8(p, S::luminance(v));
+        }
+#endif
+    };
+    
+    struct AI88Pixels
+    {
+        enum { BYTES = 2, PADDING = 0 };
+#ifdef USE_PIXEL_SIMD
+        typedef PixelSimd S;
+        static inline S::Vec load(const unsigned char* p)
+        {
+            S::Vec ia = S::load16(p);
+            S::Vec i = S::bitAnd(ia, S::set1(0xFF));
+            S::Vec rgb = S::bitOr(S::bitOr(i, S::shiftLeft32<8>(i)), S::shiftLeft32<16>(i));
+            return S::bitOr(rgb, S::shiftLeft32<16>(S::bitAnd(ia, S::set1(0xFF00))));
+        }
+        static inline void store(unsigned char* p, S::Vec v)
+        {
+            S::store16(p, S::bitOr(S::luminance(v), S::bitAnd(S::shiftRight32<16>(v), S::set1(0xFF00))));
+        }
+#endif
+    };
+    
+    struct A8Pixels
+    {
+        enum { BYTES = 1, PADDING = 0 };
+#ifdef USE_PIXEL_SIMD
+        typedef PixelSimd S;
+        static inline S::Vec load(const unsigned char* p)
+        {
+            return S::shiftLeft32<24>(S::load8(p));
+        }
+        static inline void store(unsigned char* p, S::Vec v)
+        {
+            S::store8(p, S::shiftRight32<24>(v));
+        }
+#endif
+    };
+    
+    struct RGB888Pixels
+    {
+#ifdef USE_PIXEL_SIMD
+        enum { BYTES = 3, PADDING = PixelSimd::LOAD24_PADDING };
+        typedef PixelSimd S;
+        static inline S::Vec load(const unsigned char* p)
+        {
+            return S::bitOr(S::load24(p), S::set1(0xFF000000));
+        }
+        static inline void store(unsigned char* p, S::Vec v)
+        {
+            S::store24(p, v);
+        }
+#else
+        enum { BYTES = 3, PADDING = 0 };
+#endif
+    };
+    
+    struct RGBA8888Pixels
+    {
+        enum { BYTES = 4, PADDING = 0 };
+#ifdef USE_PIXEL_SIMD
+        typedef PixelSimd S;
+        static inline S::Vec load(const unsigned char* p)
+        {
+            return S::load32(p);
+        }
+        static inline void store(unsigned char* p, S::Vec v)
+        {
+            S::store32(p, v);
+        }
+#endif
+    };
+    
+    struct BGRA8888Pixels
+    {
+        enum { BYTES = 4, PADDING = 0 };
+#ifdef USE_PIXEL_SIMD
+        typedef PixelSimd S;
+        static inline S::Vec load(const unsigned char* p)
+        {
+            S::Vec v = S::load32(p);
+            S::Vec rb = S::bitOr(S::bitAnd(S::shiftRight32<16>(v), S::set1(0xFF)), S::bitAnd(S::shiftLeft32<16>(v), S::set1(0xFF0000)));
+            return S::bitOr(S::bitAnd(v, S::set1(0xFF00FF00)), rb);
+        }
+#endif
+    };
+    
+    // RRRRRGGGGGGBBBBB, MTL_B5G6R5 has the same layout
+    struct RGB565Pixels
+    {
+        enum { BYTES = 2, PADDING = 0 };
+#ifdef USE_PIXEL_SIMD
+        typedef PixelSimd S;
+        static inline S::Vec load(const unsigned char* p)
+        {
+            S::Vec x = S::load16(p);
+            S::Vec r = S::shiftRight32<8>(S::bitAnd(x, S::set1(0xF800)));
+            S::Vec g = S::shiftLeft32<5>(S::bitAnd(x, S::set1(0x07E0)));
+            S::Vec b = S::shiftLeft32<19>(S::bitAnd(x, S::set1(0x001F)));
+            return S::bitOr(S::bitOr(r, g), S::bitOr(b, S::set1(0xFF000000)));
+        }
+        static inline void store(unsigned char* p, S::Vec v)
+        {
+            S::Vec r = S::shiftLeft32<8>(S::bitAnd(v, S::set1(0xF8)));
+            S::Vec g = S::bitAnd(S::shiftRight32<5>(v), S::set1(0x07E0));
+            S::Vec b = S::bitAnd(S::shiftRight32<19>(v), S::set1(0x001F));
+            S::store16(p, S::bitOr(S::bitOr(r, g), b));
+        }
+#endif
+    };
+    
+    // RRRRGGGGBBBBAAAA, MTL_ABGR4 has the same layout
+    struct RGBA4444Pixels
+    {
+        enum { BYTES = 2, PADDING = 0 };
+#ifdef USE_PIXEL_SIMD
+        typedef PixelSimd S;
+        static inline S::Vec load(const unsigned char* p)
+        {
+            // spreads the nibbles to one byte each, then * 17 copies them to the high halves
+            S::Vec x = S::load16(p);
+            S::Vec r = S::shiftRight32<12>(x);
+            S::Vec g = S::bitAnd(x, S::set1(0x0F00));
+            S::Vec b = S::bitAnd(S::shiftLeft32<12>(x), S::set1(0x000F0000));
+            S::Vec a = S::bitAnd(S::shiftLeft32<24>(x), S::set1(0x0F000000));
+            S::Vec nibbles = S::bitOr(S::bitOr(r, g), S::bitOr(b, a));
+            return S::bitOr(nibbles, S::shiftLeft32<4>(nibbles));
+        }
+        static inline void store(unsigned char* p, S::Vec v)
+        {
+            S::Vec r = S::shiftLeft32<8>(S::bitAnd(v, S::set1(0xF0)));
+            S::Vec g = S::bitAnd(S::shiftRight32<4>(v), S::set1(0x0F00));
+            S::Vec b = S::bitAnd(S::shiftRight32<16>(v), S::set1(0x00F0));
+            S::Vec a = S::shiftRight32<28>(v);
+            S::store16(p, S::bitOr(S::bitOr(r, g), S::bitOr(b, a)));
+        }
+#endif
+    };
+    
+    // RRRRRGGGGGBBBBBA
+    struct RGB5A1Pixels
+    {
+        enum { BYTES = 2, PADDING = 0 };
+#ifdef USE_PIXEL_SIMD
+        typedef PixelSimd S;
+        static inline S::Vec load(const unsigned char* p)
+        {
+            S::Vec x = S::load16(p);
+            S::Vec r = S::shiftRight32<8>(S::bitAnd(x, S::set1(0xF800)));
+            S::Vec g = S::shiftLeft32<5>(S::bitAnd(x, S::set1(0x07C0)));
+            S::Vec b = S::shiftLeft32<18>(S::bitAnd(x, S::set1(0x003E)));
+            S::Vec bit = S::bitAnd(x, S::set1(0x0001));
+            S::Vec a = S::shiftLeft32<24>(S::sub32(S::shiftLeft32<8>(bit), bit));
+            return S::bitOr(S::bitOr(r, g), S::bitOr(b, a));
+        }
+        static inline void store(unsigned char* p, S::Vec v)
+        {
+            S::Vec r = S::shiftLeft32<8>(S::bitAnd(v, S::set1(0xF8)));
+            S::Vec g = S::bitAnd(S::shiftRight32<5>(v), S::set1(0x07C0));
+            S::Vec b = S::bitAnd(S::shiftRight32<18>(v), S::set1(0x003E));
+            S::Vec a = S::shiftRight32<31>(v);
+            S::store16(p, S::bitOr(S::bitOr(r, g), S::bitOr(b, a)));
+        }
+#endif
+    };
+    
+    // BBBBBGGG GGRRRRRA (MTL_BGR5A1)
+    struct BGR5A1Pixels
+    {
+        enum { BYTES = 2, PADDING = 0 };
+#ifdef USE_PIXEL_SIMD
+        typedef PixelSimd S;
+        static inline void store(unsigned char* p, S::Vec v)
+        {
+            S::Vec r = S::shiftLeft32<7>(S::bitAnd(v, S::set1(0xF8)));
+            S::Vec g = S::bitAnd(S::shiftRight32<6>(v), S::set1(0x03E0));
+            S::Vec b = S::bitAnd(S::shiftRight32<19>(v), S::set1(0x001F));
+            S::Vec a = S::shiftLeft32<15>(S::shiftRight32<31>(v));
+            S::store16(p, S::bitOr(S::bitOr(r, g), S::bitOr(b, a)));
+        }
+#endif
+    };
+    
+    // RRRRRRRRGGGGGGGGBBBBBBBBAAAAAAAA -> RRRRRRRRGGGGGGGGBBBBBBBBAAAAAAAA, every color * (A + 1) >> 8 like CC_RGB_PREMULTIPLY_ALPHA
+    static void premultiplyAlphaScalar(const unsigned char* data, size_t dataLen, unsigned char* outData)
+    {
+        for (size_t i = 0; i + 3 < dataLen; i += 4)
+        {
+            unsigned int alpha = data[i + 3] + 1;
+            outData[i] = (unsigned char)((data[i] * alpha) >> 8);
+            outData[i + 1] = (unsigned char)((data[i + 1] * alpha) >> 8);
+            outData[i + 2] = (unsigned char)((data[i + 2] * alpha) >> 8);
+            outData[i + 3] = data[i + 3];
+        }
+    }
+    
+    static void copyPixelsScalar(const unsigned char* data, size_t dataLen, unsigned char* outData)
+    {
+        memcpy(outData, data, dataLen);
+    }
+    
+#ifdef USE_PIXEL_SIMD
+    static inline PixelSimd::Vec premultiplyPixels(PixelSimd::Vec v)
+    {
+        typedef PixelSimd S;
+        // color * (A + 1) fits in 16 bits, so R and B are multiplied together in the two halves of a lane
+        S::Vec alpha = S::add32(S::shiftRight32<24>(v), S::set1(1));
+        S::Vec rb = S::mul16(S::bitAnd(v, S::set1(0x00FF00FF)), S::bitOr(alpha, S::shiftLeft32<16>(alpha)));
+        S::Vec g = S::mul16(S::bitAnd(S::shiftRight32<8>(v), S::set1(0xFF)), alpha);
+        S::Vec rgb = S::bitOr(S::shiftRight16<8>(rb), S::shiftLeft32<8>(S::shiftRight16<8>(g)));
+        return S::bitOr(rgb, S::bitAnd(v, S::set1(0xFF000000)));
+    }
+    
+    // Converts as many pixels as the kernels can, returns how many that were.
+    template<typename Src, typename Dst, bool Premultiply>
+    static size_t convertBlocks(const unsigned char* data, unsigned char* outData, size_t pixels)
+    {
+        size_t done = 0;
+        const size_t step = PixelSimd::LANES;
+        const size_t padding = Src::PADDING;
+        for (; done + step + padding <= pixels; done += step)
+        {
+            PixelSimd::Vec v = Src::load(data + done * Src::BYTES);
+            if (Premultiply)
+            {
+                v = premultiplyPixels(v);
+            }
+            Dst::store(outData + done * Dst::BYTES, v);
+        }
+        return done;
+    }
+#endif
+    
+    typedef void (*ScalarConverter)(const unsigned char* data, size_t dataLen, unsigned char* outData);
+    
+    // Large images are split in stripes converted by the ParallelTaskPool threads.
+    template<typename ConvertRange>
+    static void convertStripes(size_t pixels, const ConvertRange& convertRange)
+    {
+        int threads = s_conversionThreads;
+        if (threads != 1 && pixels >= PARALLEL_CONVERSION_MIN_PIXELS)
+        {
+            ParallelTaskPool::getInstance()->parallelFor(pixels, PARALLEL_CONVERSION_GRAIN, convertRange, threads);
+        }
+        else
+        {
+            convertRange(0, pixels);
+        }
+    }
+    
+    template<typename Src, typename Dst>
+    static void convertPixels(const unsigned char* data, size_t dataLen, unsigned char* outData, ScalarConverter scalar)
+    {
+        const size_t pixels = dataLen / Src::BYTES;
+        convertStripes(pixels, [=](size_t begin, size_t end) {
+#ifdef USE_PIXEL_SIMD
+            if (s_simdEnabled)
+            {
+                begin += convertBlocks<Src, Dst, false>(data + begin * Src::BYTES, outData + begin * Dst::BYTES, end - begin);
+            }
+#endif
+            // the scalar converter does the rest, the last stripe includes a partial pixel at the end like it always did
+            size_t inEnd = end == pixels ? dataLen : end * Src::BYTES;
+            scalar(data + begin * Src::BYTES, inEnd - begin * Src::BYTES, outData + begin * Dst::BYTES);
+        });
+    }
+    
+    template<typename Src, typename Dst>
+    static void convertPremultipliedPixels(const unsigned char* data, size_t dataLen, unsigned char* outData, ScalarConverter scalar)
+    {
+        static_assert(Src::BYTES == 4, "Only pixels with alpha in the fourth byte can be premultiplied");
+        
+        const size_t pixels = dataLen / Src::BYTES;
+        convertStripes(pixels, [=](size_t begin, size_t end) {
+#ifdef USE_PIXEL_SIMD
+            if (s_simdEnabled)
+            {
+                begin += convertBlocks<Src, Dst, true>(data + begin * Src::BYTES, outData + begin * Dst::BYTES, end - begin);
+            }
+#endif
+            // without kernels the pixels are premultiplied into a small buffer the scalar converter reads from
+            unsigned char buffer[PREMULTIPLY_CHUNK_PIXELS * Src::BYTES];
+            while (begin < end)
+            {
+                size_t count = std::min(end - begin, PREMULTIPLY_CHUNK_PIXELS);
+                premultiplyAlphaScalar(data + begin * Src::BYTES, count * Src::BYTES, buffer);
+                scalar(buffer, count * Src::BYTES, outData + begin * Dst::BYTES);
+                begin += count;
+            }
+        });
+    }
+    
+    template<typename Src, typename Dst>
+    static void convertAlphaPixels(const unsigned char* data, size_t dataLen, unsigned char* outData, ScalarConverter scalar, bool premultiply)
+    {
+        if (premultiply)
+        {
+            convertPremultipliedPixels<Src, Dst>(data, dataLen, outData, scalar);
+        }
+        else
+        {
+            convertPixels<Src, Dst>(data, dataLen, outData, scalar);
+        }
+    }
+    
+    void premultiplyAlpha(const unsigned char* data, size_t dataLen, unsigned char* outData)
+    {
+        convertPremultipliedPixels<RGBA8888Pixels, RGBA8888Pixels>(data, dataLen, outData, copyPixelsScalar);
+    }
+    
     //////////////////////////////////////////////////////////////////////////
     //convertor function
     
     // IIIIIIII -> RRRRRRRRGGGGGGGGGBBBBBBBB
-    void convertI8ToRGB888(const unsigned char* data, size_t dataLen, unsigned char* outData)
+    static void convertI8ToRGB888Scalar(const unsigned char* data, size_t dataLen, unsigned char* outData)
     {
         for (size_t i = 0; i < dataLen; ++i)
         {
@@ -42,9 +442,14 @@ namespace backend { namespace PixelFormatUtils {
             *outData++ = data[i];     //B
         }
     }
+
+    void convertI8ToRGB888(const unsigned char* data, size_t dataLen, unsigned char* outData)
+    {
+        convertPixels<I8Pixels, RGB888Pixels>(data, dataLen, outData, convertI8ToRGB888Scalar);
+    }
     
     // IIIIIIIIAAAAAAAA -> RRRRRRRRGGGGGGGGBBBBBBBB
-    void convertAI88ToRGB888(const unsigned char* data, size_t dataLen, unsigned char* outData)
+    static void convertAI88ToRGB888Scalar(const unsigned char* data, size_t dataLen, unsigned char* outData)
     {
         for (ssize_t i = 0, l = dataLen - 1; i < l; i += 2)
         {
@@ -53,9 +458,14 @@ namespace backend { namespace PixelFormatUtils {
             *outData++ = data[i];     //B
         }
     }
+
+    void convertAI88ToRGB888(const unsigned char* data, size_t dataLen, unsigned char* outData)
+    {
+        convertPixels<AI88Pixels, RGB888Pixels>(data, dataLen, outData, convertAI88ToRGB888Scalar);
+    }
     
     // IIIIIIII -> RRRRRRRRGGGGGGGGGBBBBBBBBAAAAAAAA
-    void convertI8ToRGBA8888(const unsigned char* data, size_t dataLen, unsigned char* outData)
+    static void convertI8ToRGBA8888Scalar(const unsigned char* data, size_t dataLen, unsigned char* outData)
     {
         for (size_t i = 0; i < dataLen; ++i)
         {
@@ -65,9 +475,14 @@ namespace backend { namespace PixelFormatUtils {
             *outData++ = 0xFF;        //A
         }
     }
+
+    void convertI8ToRGBA8888(const unsigned char* data, size_t dataLen, unsigned char* outData)
+    {
+        convertPixels<I8Pixels, RGBA8888Pixels>(data, dataLen, outData, convertI8ToRGBA8888Scalar);
+    }
     
     // IIIIIIIIAAAAAAAA -> RRRRRRRRGGGGGGGGBBBBBBBBAAAAAAAA
-    void convertAI88ToRGBA8888(const unsigned char* data, size_t dataLen, unsigned char* outData)
+    static void convertAI88ToRGBA8888Scalar(const unsigned char* data, size_t dataLen, unsigned char* outData)
     {
         for (ssize_t i = 0, l = dataLen - 1; i < l; i += 2)
         {
@@ -77,9 +492,14 @@ namespace backend { namespace PixelFormatUtils {
             *outData++ = data[i + 1]; //A
         }
     }
+
+    void convertAI88ToRGBA8888(const unsigned char* data, size_t dataLen, unsigned char* outData)
+    {
+        convertPixels<AI88Pixels, RGBA8888Pixels>(data, dataLen, outData, convertAI88ToRGBA8888Scalar);
+    }
     
     // IIIIIIII -> RRRRRGGGGGGBBBBB
-    void convertI8ToRGB565(const unsigned char* data, size_t dataLen, unsigned char* outData)
+    static void convertI8ToRGB565Scalar(const unsigned char* data, size_t dataLen, unsigned char* outData)
     {
         unsigned short* out16 = (unsigned short*)outData;
         for (size_t i = 0; i < dataLen; ++i)
@@ -89,9 +509,14 @@ namespace backend { namespace PixelFormatUtils {
             | (data[i] & 0x00F8) >> 3;        //B
         }
     }
+
+    void convertI8ToRGB565(const unsigned char* data, size_t dataLen, unsigned char* outData)
+    {
+        convertPixels<I8Pixels, RGB565Pixels>(data, dataLen, outData, convertI8ToRGB565Scalar);
+    }
     
     // IIIIIIIIAAAAAAAA -> RRRRRGGGGGGBBBBB
-    void convertAI88ToRGB565(const unsigned char* data, size_t dataLen, unsigned char* outData)
+    static void convertAI88ToRGB565Scalar(const unsigned char* data, size_t dataLen, unsigned char* outData)
     {
         unsigned short* out16 = (unsigned short*)outData;
         for (ssize_t i = 0, l = dataLen - 1; i < l; i += 2)
@@ -101,9 +526,14 @@ namespace backend { namespace PixelFormatUtils {
             | (data[i] & 0x00F8) >> 3;        //B
         }
     }
+
+    void convertAI88ToRGB565(const unsigned char* data, size_t dataLen, unsigned char* outData)
+    {
+        convertPixels<AI88Pixels, RGB565Pixels>(data, dataLen, outData, convertAI88ToRGB565Scalar);
+    }
     
     // IIIIIIII -> RRRRGGGGBBBBAAAA
-    void convertI8ToRGBA4444(const unsigned char* data, size_t dataLen, unsigned char* outData)
+    static void convertI8ToRGBA4444Scalar(const unsigned char* data, size_t dataLen, unsigned char* outData)
     {
         unsigned short* out16 = (unsigned short*)outData;
         for (size_t i = 0; i < dataLen; ++i)
@@ -114,9 +544,14 @@ namespace backend { namespace PixelFormatUtils {
             | 0x000F;                             //A
         }
     }
+
+    void convertI8ToRGBA4444(const unsigned char* data, size_t dataLen, unsigned char* outData)
+    {
+        convertPixels<I8Pixels, RGBA4444Pixels>(data, dataLen, outData, convertI8ToRGBA4444Scalar);
+    }
     
     // IIIIIIIIAAAAAAAA -> RRRRGGGGBBBBAAAA
-    void convertAI88ToRGBA4444(const unsigned char* data, size_t dataLen, unsigned char* outData)
+    static void convertAI88ToRGBA4444Scalar(const unsigned char* data, size_t dataLen, unsigned char* outData)
     {
         unsigned short* out16 = (unsigned short*)outData;
         for (ssize_t i = 0, l = dataLen - 1; i < l; i += 2)
@@ -127,9 +562,14 @@ namespace backend { namespace PixelFormatUtils {
             | (data[i + 1] & 0x00F0) >> 4;          //A
         }
     }
+
+    void convertAI88ToRGBA4444(const unsigned char* data, size_t dataLen, unsigned char* outData)
+    {
+        convertPixels<AI88Pixels, RGBA4444Pixels>(data, dataLen, outData, convertAI88ToRGBA4444Scalar);
+    }
     
     // IIIIIIIIAAAAAAAA -> BBBBBGGG GGGRRRR
-    void convertAI88ToBGR565(const unsigned char* data, size_t dataLen, unsigned char* outData)
+    static void convertAI88ToBGR565Scalar(const unsigned char* data, size_t dataLen, unsigned char* outData)
     {
         uint16_t* out16 = (uint16_t*)outData;
         for (ssize_t i = 0, l = dataLen - 1; i < l; i += 2)
@@ -139,9 +579,14 @@ namespace backend { namespace PixelFormatUtils {
             | (data[i] & 0x00F8) >> 3;            //B
         }
     }
+
+    void convertAI88ToBGR565(const unsigned char* data, size_t dataLen, unsigned char* outData)
+    {
+        convertPixels<AI88Pixels, RGB565Pixels>(data, dataLen, outData, convertAI88ToBGR565Scalar);
+    }
     
     // IIIIIIIIAAAAAAAA -> BBBBBGGG GGRRRRRA
-    void convertAI88ToBGR5A1(const unsigned char* data, size_t dataLen, unsigned char* outData)
+    static void convertAI88ToBGR5A1Scalar(const unsigned char* data, size_t dataLen, unsigned char* outData)
     {
         uint16_t* out16 = (uint16_t*)outData;
         for (ssize_t i = 0, l = dataLen - 1; i < l; i += 2)
@@ -152,9 +597,14 @@ namespace backend { namespace PixelFormatUtils {
             | (data[i + 1] & 0x0080) << 8;          //A
         }
     }
+
+    void convertAI88ToBGR5A1(const unsigned char* data, size_t dataLen, unsigned char* outData)
+    {
+        convertPixels<AI88Pixels, BGR5A1Pixels>(data, dataLen, outData, convertAI88ToBGR5A1Scalar);
+    }
     
     // IIIIIIIIAAAAAAAA -> AAAABBBB GGGGRRRR
-    void convertAI88ToABGR4(const unsigned char* data, size_t dataLen, unsigned char* outData)
+    static void convertAI88ToABGR4Scalar(const unsigned char* data, size_t dataLen, unsigned char* outData)
     {
         uint16_t* out16 = (uint16_t*)outData;
         for (ssize_t i = 0, l = dataLen - 1; i < l; i += 2)
@@ -165,10 +615,15 @@ namespace backend { namespace PixelFormatUtils {
             | (data[i + 1] & 0x00F0) >> 4;        //A
         }
     }
+
+    void convertAI88ToABGR4(const unsigned char* data, size_t dataLen, unsigned char* outData)
+    {
+        convertPixels<AI88Pixels, RGBA4444Pixels>(data, dataLen, outData, convertAI88ToABGR4Scalar);
+    }
     
     
     // IIIIIIII -> RRRRRGGGGGBBBBBA
-    void convertI8ToRGB5A1(const unsigned char* data, size_t dataLen, unsigned char* outData)
+    static void convertI8ToRGB5A1Scalar(const unsigned char* data, size_t dataLen, unsigned char* outData)
     {
         unsigned short* out16 = (unsigned short*)outData;
         for (size_t i = 0; i < dataLen; ++i)
@@ -179,9 +634,14 @@ namespace backend { namespace PixelFormatUtils {
             | 0x0001;                         //A
         }
     }
+
+    void convertI8ToRGB5A1(const unsigned char* data, size_t dataLen, unsigned char* outData)
+    {
+        convertPixels<I8Pixels, RGB5A1Pixels>(data, dataLen, outData, convertI8ToRGB5A1Scalar);
+    }
     
     /// IIIIIIII -> BBBBBGGG GGRRRRRA
-    void convertI8ToBGR5A1(const unsigned char* data, size_t dataLen, unsigned char* outData)
+    static void convertI8ToBGR5A1Scalar(const unsigned char* data, size_t dataLen, unsigned char* outData)
     {
         uint16_t *out16 = (uint16_t*)outData;
         for (size_t i = 0; i < dataLen; ++i)
@@ -192,9 +652,14 @@ namespace backend { namespace PixelFormatUtils {
             | 0x8000;                           //A
         }
     }
+
+    void convertI8ToBGR5A1(const unsigned char* data, size_t dataLen, unsigned char* outData)
+    {
+        convertPixels<I8Pixels, BGR5A1Pixels>(data, dataLen, outData, convertI8ToBGR5A1Scalar);
+    }
     
     // IIIIIIIII -> BBBBBGGG GGGRRRRR
-    void convertI8ToBGR565(const unsigned char* data, size_t dataLen, unsigned char* outData)
+    static void convertI8ToBGR565Scalar(const unsigned char* data, size_t dataLen, unsigned char* outData)
     {
         uint16_t *out16 = (uint16_t*)outData;
         for (size_t i = 0; i < dataLen; ++i)
@@ -205,9 +670,14 @@ namespace backend { namespace PixelFormatUtils {
             ;
         }
     }
+
+    void convertI8ToBGR565(const unsigned char* data, size_t dataLen, unsigned char* outData)
+    {
+        convertPixels<I8Pixels, RGB565Pixels>(data, dataLen, outData, convertI8ToBGR565Scalar);
+    }
     
     // IIIIIIIII -> AAAABBBBB GGGGRRRR
-    void convertI8ToABGR4(const unsigned char* data, size_t dataLen, unsigned char* outData)
+    static void convertI8ToABGR4Scalar(const unsigned char* data, size_t dataLen, unsigned char* outData)
     {
         uint16_t *out16 = (uint16_t*)outData;
         for (size_t i = 0; i < dataLen; ++i)
@@ -218,9 +688,14 @@ namespace backend { namespace PixelFormatUtils {
             | 0x000F;
         }
     }
+
+    void convertI8ToABGR4(const unsigned char* data, size_t dataLen, unsigned char* outData)
+    {
+        convertPixels<I8Pixels, RGBA4444Pixels>(data, dataLen, outData, convertI8ToABGR4Scalar);
+    }
     
     // IIIIIIIIAAAAAAAA -> RRRRRGGGGGBBBBBA
-    void convertAI88ToRGB5A1(const unsigned char* data, size_t dataLen, unsigned char* outData)
+    static void convertAI88ToRGB5A1Scalar(const unsigned char* data, size_t dataLen, unsigned char* outData)
     {
         unsigned short* out16 = (unsigned short*)outData;
         for (ssize_t i = 0, l = dataLen - 1; i < l; i += 2)
@@ -231,9 +706,14 @@ namespace backend { namespace PixelFormatUtils {
             | (data[i + 1] & 0x0080) >> 7;    //A
         }
     }
+
+    void convertAI88ToRGB5A1(const unsigned char* data, size_t dataLen, unsigned char* outData)
+    {
+        convertPixels<AI88Pixels, RGB5A1Pixels>(data, dataLen, outData, convertAI88ToRGB5A1Scalar);
+    }
     
     // IIIIIIII -> IIIIIIIIAAAAAAAA
-    void convertI8ToAI88(const unsigned char* data, size_t dataLen, unsigned char* outData)
+    static void convertI8ToAI88Scalar(const unsigned char* data, size_t dataLen, unsigned char* outData)
     {
         unsigned short* out16 = (unsigned short*)outData;
         for (size_t i = 0; i < dataLen; ++i)
@@ -242,27 +722,42 @@ namespace backend { namespace PixelFormatUtils {
             | data[i];            //I
         }
     }
+
+    void convertI8ToAI88(const unsigned char* data, size_t dataLen, unsigned char* outData)
+    {
+        convertPixels<I8Pixels, AI88Pixels>(data, dataLen, outData, convertI8ToAI88Scalar);
+    }
     
     // IIIIIIIIAAAAAAAA -> AAAAAAAA
-    void convertAI88ToA8(const unsigned char* data, size_t dataLen, unsigned char* outData)
+    static void convertAI88ToA8Scalar(const unsigned char* data, size_t dataLen, unsigned char* outData)
     {
         for (size_t i = 1; i < dataLen; i += 2)
         {
             *outData++ = data[i]; //A
         }
     }
+
+    void convertAI88ToA8(const unsigned char* data, size_t dataLen, unsigned char* outData)
+    {
+        convertPixels<AI88Pixels, A8Pixels>(data, dataLen, outData, convertAI88ToA8Scalar);
+    }
     
     // IIIIIIIIAAAAAAAA -> IIIIIIII
-    void convertAI88ToI8(const unsigned char* data, size_t dataLen, unsigned char* outData)
+    static void convertAI88ToI8Scalar(const unsigned char* data, size_t dataLen, unsigned char* outData)
     {
         for (ssize_t i = 0, l = dataLen - 1; i < l; i += 2)
         {
             *outData++ = data[i]; //R
         }
     }
+
+    void convertAI88ToI8(const unsigned char* data, size_t dataLen, unsigned char* outData)
+    {
+        convertPixels<AI88Pixels, I8Pixels>(data, dataLen, outData, convertAI88ToI8Scalar);
+    }
     
     // RRRRRRRRGGGGGGGGBBBBBBBB -> RRRRRRRRGGGGGGGGBBBBBBBBAAAAAAAA
-    void convertRGB888ToRGBA8888(const unsigned char* data, size_t dataLen, unsigned char* outData)
+    static void convertRGB888ToRGBA8888Scalar(const unsigned char* data, size_t dataLen, unsigned char* outData)
     {
         for (ssize_t i = 0, l = dataLen - 2; i < l; i += 3)
         {
@@ -272,9 +767,14 @@ namespace backend { namespace PixelFormatUtils {
             *outData++ = 0xFF;            //A
         }
     }
+
+    void convertRGB888ToRGBA8888(const unsigned char* data, size_t dataLen, unsigned char* outData)
+    {
+        convertPixels<RGB888Pixels, RGBA8888Pixels>(data, dataLen, outData, convertRGB888ToRGBA8888Scalar);
+    }
     
     // RRRRRRRRGGGGGGGGBBBBBBBBAAAAAAAA -> RRRRRRRRGGGGGGGGBBBBBBBB
-    void convertRGBA8888ToRGB888(const unsigned char* data, size_t dataLen, unsigned char* outData)
+    static void convertRGBA8888ToRGB888Scalar(const unsigned char* data, size_t dataLen, unsigned char* outData)
     {
         for (ssize_t i = 0, l = dataLen - 3; i < l; i += 4)
         {
@@ -283,9 +783,14 @@ namespace backend { namespace PixelFormatUtils {
             *outData++ = data[i + 2];     //B
         }
     }
+
+    void convertRGBA8888ToRGB888(const unsigned char* data, size_t dataLen, unsigned char* outData, bool premultiply)
+    {
+        convertAlphaPixels<RGBA8888Pixels, RGB888Pixels>(data, dataLen, outData, convertRGBA8888ToRGB888Scalar, premultiply);
+    }
     
     // RRRRRRRRGGGGGGGGBBBBBBBB -> RRRRRGGGGGGBBBBB
-    void convertRGB888ToRGB565(const unsigned char* data, size_t dataLen, unsigned char* outData)
+    static void convertRGB888ToRGB565Scalar(const unsigned char* data, size_t dataLen, unsigned char* outData)
     {
         unsigned short* out16 = (unsigned short*)outData;
         for (ssize_t i = 0, l = dataLen - 2; i < l; i += 3)
@@ -295,9 +800,14 @@ namespace backend { namespace PixelFormatUtils {
             | (data[i + 2] & 0x00F8) >> 3;    //B
         }
     }
+
+    void convertRGB888ToRGB565(const unsigned char* data, size_t dataLen, unsigned char* outData)
+    {
+        convertPixels<RGB888Pixels, RGB565Pixels>(data, dataLen, outData, convertRGB888ToRGB565Scalar);
+    }
     
     // RRRRRRRRGGGGGGGGBBBBBBBBAAAAAAAA -> RRRRRGGGGGGBBBBB
-    void convertRGBA8888ToRGB565(const unsigned char* data, size_t dataLen, unsigned char* outData)
+    static void convertRGBA8888ToRGB565Scalar(const unsigned char* data, size_t dataLen, unsigned char* outData)
     {
         unsigned short* out16 = (unsigned short*)outData;
         for (ssize_t i = 0, l = dataLen - 3; i < l; i += 4)
@@ -307,45 +817,71 @@ namespace backend { namespace PixelFormatUtils {
             | (data[i + 2] & 0x00F8) >> 3;    //B
         }
     }
+
+    void convertRGBA8888ToRGB565(const unsigned char* data, size_t dataLen, unsigned char* outData, bool premultiply)
+    {
+        convertAlphaPixels<RGBA8888Pixels, RGB565Pixels>(data, dataLen, outData, convertRGBA8888ToRGB565Scalar, premultiply);
+    }
     
     // RRRRRRRRGGGGGGGGBBBBBBBB -> AAAAAAAA
-    void convertRGB888ToA8(const unsigned char* data, size_t dataLen, unsigned char* outData)
+    static void convertRGB888ToA8Scalar(const unsigned char* data, size_t dataLen, unsigned char* outData)
     {
         for (ssize_t i = 0, l = dataLen - 2; i < l; i += 3)
         {
             *outData++ = (data[i] * 299 + data[i + 1] * 587 + data[i + 2] * 114 + 500) / 1000;  //A =  (R*299 + G*587 + B*114 + 500) / 1000
         }
     }
+
+    // the scalar code writes the luminance as alpha, so do the kernels
+    void convertRGB888ToA8(const unsigned char* data, size_t dataLen, unsigned char* outData)
+    {
+        convertPixels<RGB888Pixels, I8Pixels>(data, dataLen, outData, convertRGB888ToA8Scalar);
+    }
     
     // RRRRRRRRGGGGGGGGBBBBBBBB -> IIIIIIII
-    void convertRGB888ToI8(const unsigned char* data, size_t dataLen, unsigned char* outData)
+    static void convertRGB888ToI8Scalar(const unsigned char* data, size_t dataLen, unsigned char* outData)
     {
         for (ssize_t i = 0, l = dataLen - 2; i < l; i += 3)
         {
             *outData++ = (data[i] * 299 + data[i + 1] * 587 + data[i + 2] * 114 + 500) / 1000;  //I =  (R*299 + G*587 + B*114 + 500) / 1000
         }
     }
+
+    void convertRGB888ToI8(const unsigned char* data, size_t dataLen, unsigned char* outData)
+    {
+        convertPixels<RGB888Pixels, I8Pixels>(data, dataLen, outData, convertRGB888ToI8Scalar);
+    }
     
     // RRRRRRRRGGGGGGGGBBBBBBBBAAAAAAAA -> IIIIIIII
-    void convertRGBA8888ToI8(const unsigned char* data, size_t dataLen, unsigned char* outData)
+    static void convertRGBA8888ToI8Scalar(const unsigned char* data, size_t dataLen, unsigned char* outData)
     {
         for (ssize_t i = 0, l = dataLen - 3; i < l; i += 4)
         {
             *outData++ = (data[i] * 299 + data[i + 1] * 587 + data[i + 2] * 114 + 500) / 1000;  //I =  (R*299 + G*587 + B*114 + 500) / 1000
         }
     }
+
+    void convertRGBA8888ToI8(const unsigned char* data, size_t dataLen, unsigned char* outData, bool premultiply)
+    {
+        convertAlphaPixels<RGBA8888Pixels, I8Pixels>(data, dataLen, outData, convertRGBA8888ToI8Scalar, premultiply);
+    }
     
     // RRRRRRRRGGGGGGGGBBBBBBBBAAAAAAAA -> AAAAAAAA
-    void convertRGBA8888ToA8(const unsigned char* data, size_t dataLen, unsigned char* outData)
+    static void convertRGBA8888ToA8Scalar(const unsigned char* data, size_t dataLen, unsigned char* outData)
     {
         for (ssize_t i = 0, l = dataLen - 3; i < l; i += 4)
         {
             *outData++ = data[i + 3]; //A
         }
     }
+
+    void convertRGBA8888ToA8(const unsigned char* data, size_t dataLen, unsigned char* outData, bool premultiply)
+    {
+        convertAlphaPixels<RGBA8888Pixels, A8Pixels>(data, dataLen, outData, convertRGBA8888ToA8Scalar, premultiply);
+    }
     
     // RRRRRRRRGGGGGGGGBBBBBBBB -> IIIIIIIIAAAAAAAA
-    void convertRGB888ToAI88(const unsigned char* data, size_t dataLen, unsigned char* outData)
+    static void convertRGB888ToAI88Scalar(const unsigned char* data, size_t dataLen, unsigned char* outData)
     {
         for (ssize_t i = 0, l = dataLen - 2; i < l; i += 3)
         {
@@ -353,10 +889,15 @@ namespace backend { namespace PixelFormatUtils {
             *outData++ = 0xFF;
         }
     }
+
+    void convertRGB888ToAI88(const unsigned char* data, size_t dataLen, unsigned char* outData)
+    {
+        convertPixels<RGB888Pixels, AI88Pixels>(data, dataLen, outData, convertRGB888ToAI88Scalar);
+    }
     
     
     // RRRRRRRRGGGGGGGGBBBBBBBBAAAAAAAA -> IIIIIIIIAAAAAAAA
-    void convertRGBA8888ToAI88(const unsigned char* data, size_t dataLen, unsigned char* outData)
+    static void convertRGBA8888ToAI88Scalar(const unsigned char* data, size_t dataLen, unsigned char* outData)
     {
         for (ssize_t i = 0, l = dataLen - 3; i < l; i += 4)
         {
@@ -364,9 +905,14 @@ namespace backend { namespace PixelFormatUtils {
             *outData++ = data[i + 3];
         }
     }
+
+    void convertRGBA8888ToAI88(const unsigned char* data, size_t dataLen, unsigned char* outData, bool premultiply)
+    {
+        convertAlphaPixels<RGBA8888Pixels, AI88Pixels>(data, dataLen, outData, convertRGBA8888ToAI88Scalar, premultiply);
+    }
     
     // RRRRRRRRGGGGGGGGBBBBBBBB -> RRRRGGGGBBBBAAAA
-    void convertRGB888ToRGBA4444(const unsigned char* data, size_t dataLen, unsigned char* outData)
+    static void convertRGB888ToRGBA4444Scalar(const unsigned char* data, size_t dataLen, unsigned char* outData)
     {
         unsigned short* out16 = (unsigned short*)outData;
         for (ssize_t i = 0, l = dataLen - 2; i < l; i += 3)
@@ -377,9 +923,14 @@ namespace backend { namespace PixelFormatUtils {
                         | 0x0F);                         //A
         }
     }
+
+    void convertRGB888ToRGBA4444(const unsigned char* data, size_t dataLen, unsigned char* outData)
+    {
+        convertPixels<RGB888Pixels, RGBA4444Pixels>(data, dataLen, outData, convertRGB888ToRGBA4444Scalar);
+    }
     
     // RRRRRRRRGGGGGGGGBBBBBBBBAAAAAAAA -> RRRRGGGGBBBBAAAA
-    void convertRGBA8888ToRGBA4444(const unsigned char* data, size_t dataLen, unsigned char* outData)
+    static void convertRGBA8888ToRGBA4444Scalar(const unsigned char* data, size_t dataLen, unsigned char* outData)
     {
         unsigned short* out16 = (unsigned short*)outData;
         for (ssize_t i = 0, l = dataLen - 3; i < l; i += 4)
@@ -390,9 +941,14 @@ namespace backend { namespace PixelFormatUtils {
             | (data[i + 3] & 0xF0) >> 4;         //A
         }
     }
+
+    void convertRGBA8888ToRGBA4444(const unsigned char* data, size_t dataLen, unsigned char* outData, bool premultiply)
+    {
+        convertAlphaPixels<RGBA8888Pixels, RGBA4444Pixels>(data, dataLen, outData, convertRGBA8888ToRGBA4444Scalar, premultiply);
+    }
     
     // RRRRRRRRGGGGGGGGBBBBBBBB -> RRRRRGGGGGBBBBBA
-    void convertRGB888ToRGB5A1(const unsigned char* data, size_t dataLen, unsigned char* outData)
+    static void convertRGB888ToRGB5A1Scalar(const unsigned char* data, size_t dataLen, unsigned char* outData)
     {
         unsigned short* out16 = (unsigned short*)outData;
         for (ssize_t i = 0, l = dataLen - 2; i < l; i += 3)
@@ -403,9 +959,14 @@ namespace backend { namespace PixelFormatUtils {
             | 0x01;                          //A
         }
     }
+
+    void convertRGB888ToRGB5A1(const unsigned char* data, size_t dataLen, unsigned char* outData)
+    {
+        convertPixels<RGB888Pixels, RGB5A1Pixels>(data, dataLen, outData, convertRGB888ToRGB5A1Scalar);
+    }
     
     // RRRRRRRRGGGGGGGGBBBBBBBB -> BBBBBGGG GGGRRRRR
-    void convertRGB888ToB5G6R5(const unsigned char *data, size_t dataLen, unsigned char *out)
+    static void convertRGB888ToB5G6R5Scalar(const unsigned char *data, size_t dataLen, unsigned char *out)
     {
         uint16_t *outData = (uint16_t*) out;
         for(size_t i = 0;i < dataLen ; i += 3)
@@ -415,9 +976,14 @@ namespace backend { namespace PixelFormatUtils {
             ((data[i + 2] & 0xF8)>> 3);
         }
     }
+
+    void convertRGB888ToB5G6R5(const unsigned char* data, size_t dataLen, unsigned char* outData)
+    {
+        convertPixels<RGB888Pixels, RGB565Pixels>(data, dataLen, outData, convertRGB888ToB5G6R5Scalar);
+    }
     
     // RRRRRRRRGGGGGGGGBBBBBBBB -> BBBBBGGG GGRRRRRA
-    void convertRGB888ToBGR5A1(const unsigned char *data, size_t dataLen, unsigned char *out)
+    static void convertRGB888ToBGR5A1Scalar(const unsigned char *data, size_t dataLen, unsigned char *out)
     {
         uint16_t *outData = (uint16_t*) out;
         for(size_t i = 0;i < dataLen ; i += 3)
@@ -427,9 +993,14 @@ namespace backend { namespace PixelFormatUtils {
             ((data[i + 2] &0xF8) >> 3) | 0x8000;
         }
     }
+
+    void convertRGB888ToBGR5A1(const unsigned char* data, size_t dataLen, unsigned char* outData)
+    {
+        convertPixels<RGB888Pixels, BGR5A1Pixels>(data, dataLen, outData, convertRGB888ToBGR5A1Scalar);
+    }
     
     // RRRRRRRRGGGGGGGGBBBBBBBB -> AAAABBBB GGGGRRRR
-    void convertRGB888ToABGR4(const unsigned char *data, size_t dataLen, unsigned char *out)
+    static void convertRGB888ToABGR4Scalar(const unsigned char *data, size_t dataLen, unsigned char *out)
     {
         uint16_t *outData = (uint16_t*) out;
         for(size_t i = 0;i < dataLen ; i += 3)
@@ -440,9 +1011,14 @@ namespace backend { namespace PixelFormatUtils {
             0x000F;                                //a
         }
     }
+
+    void convertRGB888ToABGR4(const unsigned char* data, size_t dataLen, unsigned char* outData)
+    {
+        convertPixels<RGB888Pixels, RGBA4444Pixels>(data, dataLen, outData, convertRGB888ToABGR4Scalar);
+    }
     
     // RRRRRRRRGGGGGGGGBBBBBBBBAAAAAAAA -> RRRRRGGG GGBBBBBA
-    void convertRGBA8888ToRGB5A1(const unsigned char* data, size_t dataLen, unsigned char* outData)
+    static void convertRGBA8888ToRGB5A1Scalar(const unsigned char* data, size_t dataLen, unsigned char* outData)
     {
         unsigned short* out16 = (unsigned short*)outData;
         for (ssize_t i = 0, l = dataLen - 2; i < l; i += 4)
@@ -453,9 +1029,14 @@ namespace backend { namespace PixelFormatUtils {
             | (data[i + 3] & 0x0080) >> 7;   //A
         }
     }
+
+    void convertRGBA8888ToRGB5A1(const unsigned char* data, size_t dataLen, unsigned char* outData, bool premultiply)
+    {
+        convertAlphaPixels<RGBA8888Pixels, RGB5A1Pixels>(data, dataLen, outData, convertRGBA8888ToRGB5A1Scalar, premultiply);
+    }
     
     // RRRRRRRRGGGGGGGGBBBBBBBBAAAAAAAA -> BBBBBGGG GGGRRRR
-    void convertRGBA8888ToBGR565(const unsigned char *data, size_t dataLen, unsigned char *out)
+    static void convertRGBA8888ToBGR565Scalar(const unsigned char *data, size_t dataLen, unsigned char *out)
     {
         uint16_t *outData = (uint16_t*)out;
         const size_t pixelCnt = dataLen / 4;
@@ -466,9 +1047,14 @@ namespace backend { namespace PixelFormatUtils {
             (((data[i * 4 + 0] & 0xF8) << 8));             //r
         }
     }
+
+    void convertRGBA8888ToBGR565(const unsigned char* data, size_t dataLen, unsigned char* outData, bool premultiply = false)
+    {
+        convertAlphaPixels<RGBA8888Pixels, RGB565Pixels>(data, dataLen, outData, convertRGBA8888ToBGR565Scalar, premultiply);
+    }
     
     // RRRRRRRRGGGGGGGGBBBBBBBBAAAAAAAA -> AAAABBBB GGGGRRRR
-    void convertRGBA8888ToABGR4(const unsigned char *data, size_t dataLen, unsigned char *out)
+    static void convertRGBA8888ToABGR4Scalar(const unsigned char *data, size_t dataLen, unsigned char *out)
     {
         uint16_t *outData = (uint16_t*)out;
         for(size_t i=0;i < dataLen; i+=4 )
@@ -479,9 +1065,14 @@ namespace backend { namespace PixelFormatUtils {
             ((data[i + 3] & 0xF0) >> 4);               //a
         }
     }
+
+    void convertRGBA8888ToABGR4(const unsigned char* data, size_t dataLen, unsigned char* outData, bool premultiply = false)
+    {
+        convertAlphaPixels<RGBA8888Pixels, RGBA4444Pixels>(data, dataLen, outData, convertRGBA8888ToABGR4Scalar, premultiply);
+    }
     
     // RRRRRRRRGGGGGGGGBBBBBBBBAAAAAAAA -> BBBBBGGG GGRRRRRA
-    void convertRGBA8888ToBGR5A1(const unsigned char *data, size_t dataLen, unsigned char *out)
+    static void convertRGBA8888ToBGR5A1Scalar(const unsigned char *data, size_t dataLen, unsigned char *out)
     {
         uint16_t *outData = (uint16_t*)out;
         for(size_t i = 0; i < dataLen; i += 4)
@@ -492,9 +1083,14 @@ namespace backend { namespace PixelFormatUtils {
             ((data[i + 3] & 0x80) << 8);                  //a
         }
     }
+
+    void convertRGBA8888ToBGR5A1(const unsigned char* data, size_t dataLen, unsigned char* outData, bool premultiply = false)
+    {
+        convertAlphaPixels<RGBA8888Pixels, BGR5A1Pixels>(data, dataLen, outData, convertRGBA8888ToBGR5A1Scalar, premultiply);
+    }
     
     
-    void convertRGB5A1ToRGBA8888(const unsigned char* data, size_t dataLen, unsigned char* outData)
+    static void convertRGB5A1ToRGBA8888Scalar(const unsigned char* data, size_t dataLen, unsigned char* outData)
     {
         uint16_t *inData = (uint16_t*)data;
         const size_t pixelLen = dataLen / 2;
@@ -508,9 +1104,14 @@ namespace backend { namespace PixelFormatUtils {
             *outData++ = (pixel & 0x0001) * 255;
         }
     }
+
+    void convertRGB5A1ToRGBA8888(const unsigned char* data, size_t dataLen, unsigned char* outData)
+    {
+        convertPixels<RGB5A1Pixels, RGBA8888Pixels>(data, dataLen, outData, convertRGB5A1ToRGBA8888Scalar);
+    }
     
     // ABBBBBGG GGGRRRRR  -> BBBBBGGG GGRRRRRA
-    void convertRGB5A1ToBGR5A1(const unsigned char *data, size_t dataLen, unsigned char *out)
+    static void convertRGB5A1ToBGR5A1Scalar(const unsigned char *data, size_t dataLen, unsigned char *out)
     {
         const size_t pixelLen = dataLen / 2;
         const uint16_t *inData = (uint16_t*) data;
@@ -522,9 +1123,14 @@ namespace backend { namespace PixelFormatUtils {
             outData[i] = (pixel >> 1) | ((pixel & 0x0001) << 15);
         }
     }
+
+    void convertRGB5A1ToBGR5A1(const unsigned char* data, size_t dataLen, unsigned char* outData)
+    {
+        convertPixels<RGB5A1Pixels, BGR5A1Pixels>(data, dataLen, outData, convertRGB5A1ToBGR5A1Scalar);
+    }
     
     
-    void convertRGB565ToRGBA8888(const unsigned char* data, size_t dataLen, unsigned char* outData)
+    static void convertRGB565ToRGBA8888Scalar(const unsigned char* data, size_t dataLen, unsigned char* outData)
     {
         uint16_t *inData = (uint16_t*)data;
         const size_t pixelLen = dataLen / 2;
@@ -538,12 +1144,17 @@ namespace backend { namespace PixelFormatUtils {
             *outData++ = 0xFF;
         }
     }
+
+    void convertRGB565ToRGBA8888(const unsigned char* data, size_t dataLen, unsigned char* outData)
+    {
+        convertPixels<RGB565Pixels, RGBA8888Pixels>(data, dataLen, outData, convertRGB565ToRGBA8888Scalar);
+    }
     
     // BBBBBGGG GGGRRRRR -> BBBGGG GGGRRRRR
     // void convertRGB565ToB5G6R5(const unsigned char *data, ssize_t dataLen, unsigned char *out)
     
     
-    void convertRGBA4444ToRGBA8888(const unsigned char* data, size_t dataLen, unsigned char* outData)
+    static void convertRGBA4444ToRGBA8888Scalar(const unsigned char* data, size_t dataLen, unsigned char* outData)
     {
         uint16_t *inData = (uint16_t*)data;
         const size_t pixelLen = dataLen / 2;
@@ -558,11 +1169,16 @@ namespace backend { namespace PixelFormatUtils {
         }
         
     }
+
+    void convertRGBA4444ToRGBA8888(const unsigned char* data, size_t dataLen, unsigned char* outData)
+    {
+        convertPixels<RGBA4444Pixels, RGBA8888Pixels>(data, dataLen, outData, convertRGBA4444ToRGBA8888Scalar);
+    }
     
     // AAAABBBBGGGGRRRR -> AAAABBBB GGGGRRRR
     //void convertRGBA4444ToABGR4444(const unsigned char *data, ssize_t dataLen, unsigned char *out)
     
-    void convertA8ToRGBA8888(const unsigned char* data, size_t dataLen, unsigned char* outData)
+    static void convertA8ToRGBA8888Scalar(const unsigned char* data, size_t dataLen, unsigned char* outData)
     {
         for (size_t i = 0; i < dataLen; i++)
         {
@@ -572,8 +1188,13 @@ namespace backend { namespace PixelFormatUtils {
             *outData++ = data[i];
         }
     }
+
+    void convertA8ToRGBA8888(const unsigned char* data, size_t dataLen, unsigned char* outData)
+    {
+        convertPixels<A8Pixels, RGBA8888Pixels>(data, dataLen, outData, convertA8ToRGBA8888Scalar);
+    }
     
-    void convertBGRA8888ToRGBA8888(const unsigned char* data, size_t dataLen, unsigned char* outData)
+    static void convertBGRA8888ToRGBA8888Scalar(const unsigned char* data, size_t dataLen, unsigned char* outData)
     {
         const size_t pixelCounts = dataLen / 4;
         for (size_t i = 0; i < pixelCounts; i++)
@@ -584,6 +1205,11 @@ namespace backend { namespace PixelFormatUtils {
             *outData++ = data[i*4 + 3];
         }
     }
+
+    void convertBGRA8888ToRGBA8888(const unsigned char* data, size_t dataLen, unsigned char* outData, bool premultiply)
+    {
+        convertAlphaPixels<BGRA8888Pixels, RGBA8888Pixels>(data, dataLen, outData, convertBGRA8888ToRGBA8888Scalar, premultiply);
+    }
     
     // converter function end
     //////////////////////////////////////////////////////////////////////////
@@ -796,7 +1422,7 @@ namespace backend { namespace PixelFormatUtils {
         return format;
     }
     
-    cocos2d::backend::PixelFormat convertRGBA8888ToFormat(const unsigned char* data, size_t dataLen, PixelFormat format, unsigned char** outData, size_t* outDataLen)
+    cocos2d::backend::PixelFormat convertRGBA8888ToFormat(const unsigned char* data, size_t dataLen, PixelFormat format, unsigned char** outData, size_t* outDataLen, bool premultiply)
     {
         
         switch (format)
@@ -804,52 +1430,52 @@ namespace backend { namespace PixelFormatUtils {
             case PixelFormat::RGB888:
                 *outDataLen = dataLen/4*3;
                 *outData = (unsigned char*)malloc(sizeof(unsigned char) * (*outDataLen));
-                convertRGBA8888ToRGB888(data, dataLen, *outData);
+                convertRGBA8888ToRGB888(data, dataLen, *outData, premultiply);
                 break;
             case PixelFormat::RGB565:
                 *outDataLen = dataLen/2;
                 *outData = (unsigned char*)malloc(sizeof(unsigned char) * (*outDataLen));
-                convertRGBA8888ToRGB565(data, dataLen, *outData);
+                convertRGBA8888ToRGB565(data, dataLen, *outData, premultiply);
                 break;
             case PixelFormat::A8:
                 *outDataLen = dataLen/4;
                 *outData = (unsigned char*)malloc(sizeof(unsigned char) * (*outDataLen));
-                convertRGBA8888ToA8(data, dataLen, *outData);
+                convertRGBA8888ToA8(data, dataLen, *outData, premultiply);
                 break;
             case PixelFormat::I8:
                 *outDataLen = dataLen/4;
                 *outData = (unsigned char*)malloc(sizeof(unsigned char) * (*outDataLen));
-                convertRGBA8888ToI8(data, dataLen, *outData);
+                convertRGBA8888ToI8(data, dataLen, *outData, premultiply);
                 break;
             case PixelFormat::AI88:
                 *outDataLen = dataLen/2;
                 *outData = (unsigned char*)malloc(sizeof(unsigned char) * (*outDataLen));
-                convertRGBA8888ToAI88(data, dataLen, *outData);
+                convertRGBA8888ToAI88(data, dataLen, *outData, premultiply);
                 break;
             case PixelFormat::RGBA4444:
                 *outDataLen = dataLen/2;
                 *outData = (unsigned char*)malloc(sizeof(unsigned char) * (*outDataLen));
-                convertRGBA8888ToRGBA4444(data, dataLen, *outData);
+                convertRGBA8888ToRGBA4444(data, dataLen, *outData, premultiply);
                 break;
             case PixelFormat::RGB5A1:
                 *outDataLen = dataLen/2;
                 *outData = (unsigned char*)malloc(sizeof(unsigned char) * (*outDataLen));
-                convertRGBA8888ToRGB5A1(data, dataLen, *outData);
+                convertRGBA8888ToRGB5A1(data, dataLen, *outData, premultiply);
                 break;
             case PixelFormat::MTL_B5G6R5:
                 *outDataLen = dataLen/2;
                 *outData = (unsigned char*)malloc(sizeof(unsigned char) * (*outDataLen));
-                convertRGBA8888ToBGR565(data, dataLen, *outData);
+                convertRGBA8888ToBGR565(data, dataLen, *outData, premultiply);
                 break;
             case PixelFormat::MTL_ABGR4:
                 *outDataLen = dataLen/2;
                 *outData = (unsigned char*)malloc(sizeof(unsigned char) * (*outDataLen));
-                convertRGBA8888ToABGR4(data, dataLen, *outData);
+                convertRGBA8888ToABGR4(data, dataLen, *outData, premultiply);
                 break;
             case PixelFormat::MTL_BGR5A1:
                 *outDataLen = dataLen/2;
                 *outData = (unsigned char*)malloc(sizeof(unsigned char) * (*outDataLen));
-                convertRGBA8888ToBGR5A1(data, dataLen, *outData);
+                convertRGBA8888ToBGR5A1(data, dataLen, *outData, premultiply);
                 break;
             default:
                 // unsupported conversion or don't need to convert
@@ -858,6 +1484,14 @@ namespace backend { namespace PixelFormatUtils {
                     CCLOG("Can not convert image format PixelFormat::RGBA8888 to format ID:%d, we will use it's origin format PixelFormat::RGBA8888", static_cast<int>(format));
                 }
                 
+                if (premultiply)
+                {
+                    *outDataLen = dataLen;
+                    *outData = (unsigned char*)malloc(sizeof(unsigned char) * (*outDataLen));
+                    premultiplyAlpha(data, dataLen, *outData);
+                    return PixelFormat::RGBA8888;
+                }
+                
                 *outData = (unsigned char*)data;
                 *outDataLen = dataLen;
                 return PixelFormat::RGBA8888;
@@ -974,13 +1608,13 @@ namespace backend { namespace PixelFormatUtils {
         return format;
     }
     
-    PixelFormat convertBGRA8888ToFormat(const unsigned char* data, size_t dataLen, PixelFormat format, unsigned char** outData, size_t* outDataLen)
+    PixelFormat convertBGRA8888ToFormat(const unsigned char* data, size_t dataLen, PixelFormat format, unsigned char** outData, size_t* outDataLen, bool premultiply)
     {
         switch (format) {
             case PixelFormat::RGBA8888:
                 *outDataLen = dataLen;
                 *outData = (unsigned char*)malloc(sizeof(unsigned char) * (*outDataLen));
-                convertBGRA8888ToRGBA8888(data, dataLen, *outData);
+                convertBGRA8888ToRGBA8888(data, dataLen, *outData, premultiply);
                 break;
                 
             default:
@@ -1006,11 +1640,25 @@ namespace backend { namespace PixelFormatUtils {
      rgba(1) -> 12345678
      
      */
-    cocos2d::backend::PixelFormat convertDataToFormat(const unsigned char* data, size_t dataLen, PixelFormat originFormat, PixelFormat format, unsigned char** outData, size_t* outDataLen)
+    cocos2d::backend::PixelFormat convertDataToFormat(const unsigned char* data, size_t dataLen, PixelFormat originFormat, PixelFormat format, unsigned char** outData, size_t* outDataLen, bool premultiply)
     {
+        if (premultiply && originFormat != PixelFormat::RGBA8888 && originFormat != PixelFormat::BGRA8888)
+        {
+            CCLOG("Can not premultiply the alpha of format ID:%d, only RGBA8888 and BGRA8888 are supported", static_cast<int>(originFormat));
+            premultiply = false;
+        }
+        
         // don't need to convert
         if (format == originFormat || format == PixelFormat::AUTO)
         {
+            if (premultiply)
+            {
+                *outDataLen = dataLen;
+                *outData = (unsigned char*)malloc(sizeof(unsigned char) * (*outDataLen));
+                premultiplyAlpha(data, dataLen, *outData);
+                return originFormat;
+            }
+            
             *outData = (unsigned char*)data;
             *outDataLen = dataLen;
             return originFormat;
@@ -1025,7 +1673,7 @@ namespace backend { namespace PixelFormatUtils {
             case PixelFormat::RGB888:
                 return convertRGB888ToFormat(data, dataLen, format, outData, outDataLen);
             case PixelFormat::RGBA8888:
-                return convertRGBA8888ToFormat(data, dataLen, format, outData, outDataLen);
+                return convertRGBA8888ToFormat(data, dataLen, format, outData, outDataLen, premultiply);
             case PixelFormat::RGB5A1:
                 return convertRGB5A1ToFormat(data, dataLen, format, outData, outDataLen);
             case PixelFormat::RGB565:
@@ -1038,7 +1686,7 @@ namespace backend { namespace PixelFormatUtils {
                 
 #endif
             case PixelFormat::BGRA8888:
-                return convertBGRA8888ToFormat(data, dataLen, format, outData, outDataLen);
+                return convertBGRA8888ToFormat(data, dataLen, format, outData, outDataLen, premultiply);
             default:
                 CCLOG("unsupported conversion from format %d to format %d", static_cast<int>(originFormat), static_cast<int>(format));
                 *outData = (unsigned char*)data;
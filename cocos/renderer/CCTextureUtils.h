@@ -38,18 +38,39 @@ namespace backend {
         /**
         Convert the format to the format param you specified, if the format is PixelFormat::Automatic, it will detect it automatically and convert to the closest format for you.
         It will return the converted format to you. if the outData != data, you must delete it manually.
+        When premultiply is true the color channels of RGBA8888 and BGRA8888 data are multiplied by alpha in the same pass,
+        outData is a new buffer then, even if the format stays the same.
         */
-        PixelFormat convertDataToFormat(const unsigned char* data, size_t dataLen, PixelFormat originFormat, PixelFormat format, unsigned char** outData, size_t* outDataLen);
+        PixelFormat convertDataToFormat(const unsigned char* data, size_t dataLen, PixelFormat originFormat, PixelFormat format, unsigned char** outData, size_t* outDataLen, bool premultiply = false);
+
+        /** Multiplies the colors of RGBA8888 data by its alpha like CC_RGB_PREMULTIPLY_ALPHA does, outData may be data. */
+        void premultiplyAlpha(const unsigned char* data, size_t dataLen, unsigned char* outData);
+
+        /**
+        The converters use SSE2, AVX2 or NEON kernels when the engine is built for them, with the same results as the scalar code.
+        Turning them off is meant for tests and benchmarks.
+        */
+        void setSIMDEnabled(bool enabled);
+        bool isSIMDEnabled();
+        /** The instruction set of the kernels: "AVX2", "SSE2", "NEON" or "none". */
+        const char* getSIMDName();
+
+        /**
+        Images of 256x256 pixels and more are converted in stripes by the threads of the ParallelTaskPool.
+        @param threads The maximum number of threads converting one image, 0 (default) uses all of them, 1 converts on the calling thread.
+        */
+        void setConversionThreads(int threads);
+        int getConversionThreads();
 
         PixelFormat convertI8ToFormat(const unsigned char* data, size_t dataLen, PixelFormat format, unsigned char** outData, size_t* outDataLen);
         PixelFormat convertAI88ToFormat(const unsigned char* data, size_t dataLen, PixelFormat format, unsigned char** outData, size_t* outDataLen);
         PixelFormat convertRGB888ToFormat(const unsigned char* data, size_t dataLen, PixelFormat format, unsigned char** outData, size_t* outDataLen);
-        PixelFormat convertRGBA8888ToFormat(const unsigned char* data, size_t dataLen, PixelFormat format, unsigned char** outData, size_t* outDataLen);
+        PixelFormat convertRGBA8888ToFormat(const unsigned char* data, size_t dataLen, PixelFormat format, unsigned char** outData, size_t* outDataLen, bool premultiply = false);
         PixelFormat convertRGB5A1ToFormat(const unsigned char* data, size_t dataLen, PixelFormat format, unsigned char** outData, size_t* outDataLen);
         PixelFormat convertRGB565ToFormat(const unsigned char* data, size_t dataLen, PixelFormat format, unsigned char** outData, size_t* outDataLen);
         PixelFormat convertA8ToFormat(const unsigned char* data, size_t dataLen, PixelFormat format, unsigned char** outData, size_t* outDataLen);
         PixelFormat convertRGBA4444ToFormat(const unsigned char* data, size_t dataLen, PixelFormat format, unsigned char** outData, size_t* outDataLen);
-        PixelFormat convertBGRA8888ToFormat(const unsigned char* data, size_t dataLen, PixelFormat format, unsigned char** outData, size_t* outDataLen);
+        PixelFormat convertBGRA8888ToFormat(const unsigned char* data, size_t dataLen, PixelFormat format, unsigned char** outData, size_t* outDataLen, bool premultiply = false);
 
         //I8 to XXX
         void convertI8ToRGB888(const unsigned char* data, size_t dataLen, unsigned char* outData);
@@ -77,14 +98,14 @@ namespace backend {
         void convertRGB888ToRGBA4444(const unsigned char* data, size_t dataLen, unsigned char* outData);
         void convertRGB888ToRGB5A1(const unsigned char* data, size_t dataLen, unsigned char* outData);
 
-        //RGBA8888 to XXX
-        void convertRGBA8888ToRGB888(const unsigned char* data, size_t dataLen, unsigned char* outData);
-        void convertRGBA8888ToRGB565(const unsigned char* data, size_t dataLen, unsigned char* outData);
-        void convertRGBA8888ToI8(const unsigned char* data, size_t dataLen, unsigned char* outData);
-        void convertRGBA8888ToA8(const unsigned char* data, size_t dataLen, unsigned char* outData);
-        void convertRGBA8888ToAI88(const unsigned char* data, size_t dataLen, unsigned char* outData);
-        void convertRGBA8888ToRGBA4444(const unsigned char* data, size_t dataLen, unsigned char* outData);
-        void convertRGBA8888ToRGB5A1(const unsigned char* data, size_t dataLen, unsigned char* outData);
+        //RGBA8888 to XXX, premultiply multiplies the colors by alpha on the way
+        void convertRGBA8888ToRGB888(const unsigned char* data, size_t dataLen, unsigned char* outData, bool premultiply = false);
+        void convertRGBA8888ToRGB565(const unsigned char* data, size_t dataLen, unsigned char* outData, bool premultiply = false);
+        void convertRGBA8888ToI8(const unsigned char* data, size_t dataLen, unsigned char* outData, bool premultiply = false);
+        void convertRGBA8888ToA8(const unsigned char* data, size_t dataLen, unsigned char* outData, bool premultiply = false);
+        void convertRGBA8888ToAI88(const unsigned char* data, size_t dataLen, unsigned char* outData, bool premultiply = false);
+        void convertRGBA8888ToRGBA4444(const unsigned char* data, size_t dataLen, unsigned char* outData, bool premultiply = false);
+        void convertRGBA8888ToRGB5A1(const unsigned char* data, size_t dataLen, unsigned char* outData, bool premultiply = false);
 
 
         void convertRGB5A1ToRGBA8888(const unsigned char* data, size_t dataLen, unsigned char* outData);
@@ -93,7 +114,7 @@ namespace backend {
         void convertRGBA4444ToRGBA8888(const unsigned char* data, size_t dataLen, unsigned char* outData);
         
         //BGRA8888 to XXX
-        void convertBGRA8888ToRGBA8888(const unsigned char* data, size_t dataLen, unsigned char* outData);
+        void convertBGRA8888ToRGBA8888(const unsigned char* data, size_t dataLen, unsigned char* outData, bool premultiply = false);
     };
 }
 NS_CC_END
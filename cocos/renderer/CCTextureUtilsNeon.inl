@@ -0,0 +1,107 @@
+/****************************************************************************
+Copyright (c) 2020 c4games.com.
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#include <arm_neon.h>
+#include <string.h>
+
+NS_CC_BEGIN
+
+namespace backend { namespace PixelFormatUtils {
+
+// NEON building blocks for the pixel converters, four pixels in 32 bit RGBA lanes (R in the low byte).
+struct PixelNeon
+{
+    typedef uint32x4_t Vec;
+    enum { LANES = 4 };
+    // load24() reads 16 bytes for 12, so 2 more pixels must follow
+    enum { LOAD24_PADDING = 2 };
+
+    static inline Vec set1(uint32_t value) { return vdupq_n_u32(value); }
+    static inline Vec bitAnd(Vec a, Vec b) { return vandq_u32(a, b); }
+    static inline Vec bitOr(Vec a, Vec b) { return vorrq_u32(a, b); }
+    static inline Vec add32(Vec a, Vec b) { return vaddq_u32(a, b); }
+    static inline Vec sub32(Vec a, Vec b) { return vsubq_u32(a, b); }
+    template<int N> static inline Vec shiftLeft32(Vec a) { return vshlq_n_u32(a, N); }
+    template<int N> static inline Vec shiftRight32(Vec a) { return vshrq_n_u32(a, N); }
+    template<int N> static inline Vec shiftRight16(Vec a) { return vreinterpretq_u32_u16(vshrq_n_u16(vreinterpretq_u16_u32(a), N)); }
+    static inline Vec mul16(Vec a, Vec b) { return vreinterpretq_u32_u16(vmulq_u16(vreinterpretq_u16_u32(a), vreinterpretq_u16_u32(b))); }
+
+    // (R * 299 + G * 587 + B * 114 + 500) / 1000, the division goes through float which is exact for these sums
+    static inline Vec luminance(Vec rgba)
+    {
+        Vec mask = vdupq_n_u32(0xFF);
+        Vec sum = vmulq_n_u32(vandq_u32(rgba, mask), 299);
+        sum = vmlaq_n_u32(sum, vandq_u32(vshrq_n_u32(rgba, 8), mask), 587);
+        sum = vmlaq_n_u32(sum, vandq_u32(vshrq_n_u32(rgba, 16), mask), 114);
+        float32x4_t scaled = vmulq_f32(vaddq_f32(vcvtq_f32_u32(sum), vdupq_n_f32(500.5f)), vdupq_n_f32(0.001f));
+        return vcvtq_u32_f32(scaled);
+    }
+
+    static inline Vec load32(const unsigned char* p) { return vreinterpretq_u32_u8(vld1q_u8(p)); }
+    static inline void store32(unsigned char* p, Vec v) { vst1q_u8(p, vreinterpretq_u8_u32(v)); }
+
+    static inline Vec load24(const unsigned char* p)
+    {
+        static const uint8_t lowIndices[8] = { 0, 1, 2, 255, 3, 4, 5, 255 };
+        static const uint8_t highIndices[8] = { 6, 7, 8, 255, 9, 10, 11, 255 };
+        uint8x16_t bytes = vld1q_u8(p);
+        uint8x8x2_t table = { { vget_low_u8(bytes), vget_high_u8(bytes) } };
+        // out of range indices give 0, which leaves the alpha bytes empty
+        return vreinterpretq_u32_u8(vcombine_u8(vtbl2_u8(table, vld1_u8(lowIndices)), vtbl2_u8(table, vld1_u8(highIndices))));
+    }
+
+    static inline void store24(unsigned char* p, Vec v)
+    {
+        static const uint8_t lowIndices[8] = { 0, 1, 2, 4, 5, 6, 8, 9 };
+        static const uint8_t highIndices[8] = { 10, 12, 13, 14, 0, 0, 0, 0 };
+        uint8x16_t bytes = vreinterpretq_u8_u32(v);
+        uint8x8x2_t table = { { vget_low_u8(bytes), vget_high_u8(bytes) } };
+        vst1_u8(p, vtbl2_u8(table, vld1_u8(lowIndices)));
+        uint32_t word = vget_lane_u32(vreinterpret_u32_u8(vtbl2_u8(table, vld1_u8(highIndices))), 0);
+        memcpy(p + 8, &word, 4);
+    }
+
+    static inline Vec load16(const unsigned char* p) { return vmovl_u16(vreinterpret_u16_u8(vld1_u8(p))); }
+    static inline void store16(unsigned char* p, Vec v) { vst1_u8(p, vreinterpret_u8_u16(vmovn_u32(v))); }
+
+    static inline Vec load8(const unsigned char* p)
+    {
+        uint32_t word;
+        memcpy(&word, p, 4);
+        return vmovl_u16(vget_low_u16(vmovl_u8(vreinterpret_u8_u32(vdup_n_u32(word)))));
+    }
+
+    static inline void store8(unsigned char* p, Vec v)
+    {
+        uint16x4_t half = vmovn_u32(v);
+        uint32_t word = vget_lane_u32(vreinterpret_u32_u8(vmovn_u16(vcombine_u16(half, half))), 0);
+        memcpy(p, &word, 4);
+    }
+};
+
+typedef PixelNeon PixelSimd;
+
+}}
+
+NS_CC_END
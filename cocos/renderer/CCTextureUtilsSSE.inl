@@ -0,0 +1,193 @@
+/****************************************************************************
+Copyright (c) 2020 c4games.com.
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#if defined(USE_PIXEL_AVX2)
+#include <immintrin.h>
+#else
+#include <emmintrin.h>
+#endif
+#include <string.h>
+
+NS_CC_BEGIN
+
+namespace backend { namespace PixelFormatUtils {
+
+// SSE2 building blocks for the pixel converters, four pixels in 32 bit RGBA lanes (R in the low byte).
+struct PixelSSE2
+{
+    typedef __m128i Vec;
+    enum { LANES = 4 };
+    // load24() reads 16 bytes for 12, so 2 more pixels must follow
+    enum { LOAD24_PADDING = 2 };
+
+    static inline Vec set1(uint32_t value) { return _mm_set1_epi32(static_cast<int>(value)); }
+    static inline Vec bitAnd(Vec a, Vec b) { return _mm_and_si128(a, b); }
+    static inline Vec bitOr(Vec a, Vec b) { return _mm_or_si128(a, b); }
+    static inline Vec add32(Vec a, Vec b) { return _mm_add_epi32(a, b); }
+    static inline Vec sub32(Vec a, Vec b) { return _mm_sub_epi32(a, b); }
+    template<int N> static inline Vec shiftLeft32(Vec a) { return _mm_slli_epi32(a, N); }
+    template<int N> static inline Vec shiftRight32(Vec a) { return _mm_srli_epi32(a, N); }
+    template<int N> static inline Vec shiftRight16(Vec a) { return _mm_srli_epi16(a, N); }
+    static inline Vec mul16(Vec a, Vec b) { return _mm_mullo_epi16(a, b); }
+
+    // (R * 299 + G * 587 + B * 114 + 500) / 1000, the division goes through float which is exact for these sums
+    static inline Vec luminance(Vec rgba)
+    {
+        Vec rb = _mm_and_si128(rgba, _mm_set1_epi32(0x00FF00FF));
+        Vec g = _mm_and_si128(_mm_srli_epi32(rgba, 8), _mm_set1_epi32(0xFF));
+        Vec sum = _mm_add_epi32(_mm_madd_epi16(rb, _mm_set1_epi32(299 | (114 << 16))), _mm_madd_epi16(g, _mm_set1_epi32(587)));
+        __m128 scaled = _mm_mul_ps(_mm_add_ps(_mm_cvtepi32_ps(sum), _mm_set1_ps(500.5f)), _mm_set1_ps(0.001f));
+        return _mm_cvttps_epi32(scaled);
+    }
+
+    static inline Vec load32(const unsigned char* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+    static inline void store32(unsigned char* p, Vec v) { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v); }
+
+    static inline Vec load24(const unsigned char* p)
+    {
+        Vec v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        Vec p01 = _mm_unpacklo_epi32(v, _mm_srli_si128(v, 3));
+        Vec p23 = _mm_unpacklo_epi32(_mm_srli_si128(v, 6), _mm_srli_si128(v, 9));
+        return _mm_and_si128(_mm_unpacklo_epi64(p01, p23), _mm_set1_epi32(0x00FFFFFF));
+    }
+
+    static inline void store24(unsigned char* p, Vec v)
+    {
+        // moves pixel 1 and 3 next to pixel 0 and 2, 6 bytes per 64 bit half
+        Vec rgb = _mm_and_si128(v, _mm_set1_epi32(0x00FFFFFF));
+        Vec even = _mm_and_si128(rgb, _mm_set_epi32(0, -1, 0, -1));
+        Vec odd = _mm_srli_epi64(_mm_andnot_si128(_mm_set_epi32(0, -1, 0, -1), rgb), 8);
+        alignas(16) uint64_t halves[2];
+        _mm_store_si128(reinterpret_cast<__m128i*>(halves), _mm_or_si128(even, odd));
+        memcpy(p, &halves[0], 6);
+        memcpy(p + 6, &halves[1], 6);
+    }
+
+    static inline Vec load16(const unsigned char* p)
+    {
+        return _mm_unpacklo_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(p)), _mm_setzero_si128());
+    }
+
+    static inline void store16(unsigned char* p, Vec v)
+    {
+        // SSE2 only packs with signed saturation, sign extending the low 16 bits keeps them as they are
+        Vec s = _mm_srai_epi32(_mm_slli_epi32(v, 16), 16);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(p), _mm_packs_epi32(s, s));
+    }
+
+    static inline Vec load8(const unsigned char* p)
+    {
+        int word;
+        memcpy(&word, p, 4);
+        Vec zero = _mm_setzero_si128();
+        return _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(word), zero), zero);
+    }
+
+    static inline void store8(unsigned char* p, Vec v)
+    {
+        Vec s = _mm_packs_epi32(v, v);
+        int word = _mm_cvtsi128_si32(_mm_packus_epi16(s, s));
+        memcpy(p, &word, 4);
+    }
+};
+
+#if defined(USE_PIXEL_AVX2)
+
+// AVX2 building blocks, eight pixels per step. Packed 24 bit pixels go through the SSE2 code, one half at a time.
+struct PixelAVX2
+{
+    typedef __m256i Vec;
+    enum { LANES = 8 };
+    enum { LOAD24_PADDING = PixelSSE2::LOAD24_PADDING };
+
+    static inline Vec set1(uint32_t value) { return _mm256_set1_epi32(static_cast<int>(value)); }
+    static inline Vec bitAnd(Vec a, Vec b) { return _mm256_and_si256(a, b); }
+    static inline Vec bitOr(Vec a, Vec b) { return _mm256_or_si256(a, b); }
+    static inline Vec add32(Vec a, Vec b) { return _mm256_add_epi32(a, b); }
+    static inline Vec sub32(Vec a, Vec b) { return _mm256_sub_epi32(a, b); }
+    template<int N> static inline Vec shiftLeft32(Vec a) { return _mm256_slli_epi32(a, N); }
+    template<int N> static inline Vec shiftRight32(Vec a) { return _mm256_srli_epi32(a, N); }
+    template<int N> static inline Vec shiftRight16(Vec a) { return _mm256_srli_epi16(a, N); }
+    static inline Vec mul16(Vec a, Vec b) { return _mm256_mullo_epi16(a, b); }
+
+    static inline Vec luminance(Vec rgba)
+    {
+        Vec rb = _mm256_and_si256(rgba, _mm256_set1_epi32(0x00FF00FF));
+        Vec g = _mm256_and_si256(_mm256_srli_epi32(rgba, 8), _mm256_set1_epi32(0xFF));
+        Vec sum = _mm256_add_epi32(_mm256_madd_epi16(rb, _mm256_set1_epi32(299 | (114 << 16))), _mm256_madd_epi16(g, _mm256_set1_epi32(587)));
+        __m256 scaled = _mm256_mul_ps(_mm256_add_ps(_mm256_cvtepi32_ps(sum), _mm256_set1_ps(500.5f)), _mm256_set1_ps(0.001f));
+        return _mm256_cvttps_epi32(scaled);
+    }
+
+    static inline Vec load32(const unsigned char* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+    static inline void store32(unsigned char* p, Vec v) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v); }
+
+    static inline Vec load24(const unsigned char* p)
+    {
+        return _mm256_inserti128_si256(_mm256_castsi128_si256(PixelSSE2::load24(p)), PixelSSE2::load24(p + 12), 1);
+    }
+
+    static inline void store24(unsigned char* p, Vec v)
+    {
+        PixelSSE2::store24(p, _mm256_castsi256_si128(v));
+        PixelSSE2::store24(p + 12, _mm256_extracti128_si256(v, 1));
+    }
+
+    static inline Vec load16(const unsigned char* p)
+    {
+        return _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+    }
+
+    static inline void store16(unsigned char* p, Vec v)
+    {
+        // packing works per 128 bit lane, gather the two useful quarters afterwards
+        Vec packed = _mm256_permute4x64_epi64(_mm256_packus_epi32(v, v), _MM_SHUFFLE(3, 1, 2, 0));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(p), _mm256_castsi256_si128(packed));
+    }
+
+    static inline Vec load8(const unsigned char* p)
+    {
+        return _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(p)));
+    }
+
+    static inline void store8(unsigned char* p, Vec v)
+    {
+        Vec packed = _mm256_packus_epi32(v, v);
+        packed = _mm256_packus_epi16(packed, packed);
+        packed = _mm256_permutevar8x32_epi32(packed, _mm256_setr_epi32(0, 4, 0, 4, 0, 4, 0, 4));
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(p), _mm256_castsi256_si128(packed));
+    }
+};
+
+typedef PixelAVX2 PixelSimd;
+
+#else
+
+typedef PixelSSE2 PixelSimd;
+
+#endif
+
+}}
+
+NS_CC_END
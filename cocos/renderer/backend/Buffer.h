@@ -40,6 +40,16 @@ CC_BACKEND_BEGIN
  * @{
  */
 
+/**
+ * @brief Statistics of the BufferUsage::STREAM buffers.
+ */
+struct StreamStats
+{
+    std::size_t uploadedBytes = 0; ///< Bytes written by Buffer::streamData().
+    unsigned int stallsAvoided = 0; ///< Writes which got fresh storage instead of waiting for the GPU to finish reading a region.
+    unsigned int overflowOrphans = 0; ///< Writes which got fresh storage because a frame streamed more than a region holds.
+};
+
 /**
  * @brief Used to store vertex and index data data.
  */
@@ -70,12 +80,39 @@ public:
      */
     virtual void usingDefaultStoredData(bool needDefaultStoredData) = 0;
 
+    /**
+     * @brief Append data to a BufferUsage::STREAM buffer.
+     * A stream buffer is a ring of per frame regions of getSize() bytes, data is appended to the region of the
+     * current frame, so the write never waits for the GPU to finish drawing the previous frames.
+     * The data stays valid until the end of the frame, use it with the returned offset, see `CommandBuffer::setVertexBuffer`.
+     * Don't mix it with updateData() and updateSubData().
+     * @param data Specifies a pointer to the data that will be copied into the data store.
+     * @param size Specifies the size in bytes of the data, at most getSize().
+     * @return The offset in bytes of the data in the buffer, a multiple of 4.
+     */
+    virtual std::size_t streamData(void* data, std::size_t size) = 0;
+
     /**
      * Get buffer size in bytes.
      * @return The buffer size in bytes.
      */
     std::size_t getSize() const { return _size; }
 
+    /**
+     * Get the expected usage pattern of the buffer.
+     */
+    BufferUsage getUsage() const { return _usage; }
+
+    /**
+     * Get the statistics of all the stream buffers during the previous frame.
+     */
+    static const StreamStats& getStreamStats() { return _lastFrameStreamStats; }
+
+    /**
+     * Called by the backend at the beginning of a frame, makes the statistics of the current frame available.
+     */
+    static void resetStreamStats();
+
 protected:
     /**
      * @param size Specifies the size in bytes of the buffer object's new data store.
@@ -93,6 +130,9 @@ protected:
     BufferUsage _usage = BufferUsage::DYNAMIC; ///< Buffer usage.
     BufferType _type = BufferType::VERTEX; ///< Buffer type.
     std::size_t _size = 0; ///< buffer size in bytes.
+
+    static StreamStats _frameStreamStats; ///< Statistics of the current frame.
+    static StreamStats _lastFrameStreamStats;
 };
 
 // end of _backend group
@@ -50,6 +50,15 @@ class DepthStencilState;
  * @{
  */
 
+/**
+ * @brief Counts the state changes of a frame.
+ */
+struct StateStats
+{
+    unsigned int issuedCalls = 0; ///< State changes sent to the driver.
+    unsigned int skippedCalls = 0; ///< Redundant state changes which were filtered out.
+};
+
 /**
  * @brief Store encoded commands for the GPU to execute.
  * A command buffer stores encoded commands until the buffer is committed for execution by the GPU
@@ -99,8 +108,9 @@ public:
     /**
      * Set a global buffer for all vertex shaders at the given bind point index 0.
      * @param buffer The vertex buffer to be setted in the buffer argument table.
+     * @param offset Byte offset of the first vertex in the buffer, a multiple of 4, e.g. the offset returned by `Buffer::streamData`.
      */
-    virtual void setVertexBuffer(Buffer* buffer) = 0;
+    virtual void setVertexBuffer(Buffer* buffer, std::size_t offset = 0) = 0;
 
     /**
      * Set unifroms and textures
@@ -134,6 +144,27 @@ public:
      * @see `drawArrays(PrimitiveType primitiveType, unsigned int start,  unsigned int count)`
     */
     virtual void drawElements(PrimitiveType primitiveType, IndexFormat indexType, std::size_t count, std::size_t offset) = 0;
+
+    /**
+     * Set the per instance data of instanced draws, one model matrix (16 floats, column major) per instance.
+     * @param buffer A buffer object that the device will read the instance data from.
+     * @param offset Byte offset within buffer of the first instance.
+     * @see `drawElementsInstanced(PrimitiveType primitiveType, IndexFormat indexType, std::size_t count, std::size_t offset, std::size_t instanceCount)`
+     */
+    virtual void setInstanceBuffer(Buffer* buffer, std::size_t offset) = 0;
+
+    /**
+     * Draw several instances of primitives with an index list.
+     * The program reads the model matrix of each instance from the `a_instance` attribute.
+     * @note Only available when FeatureType::INSTANCED_DRAW is supported.
+     * @param primitiveType The type of primitives that elements are assembled into.
+     * @param indexType The type if indexes, either 16 bit integer or 32 bit integer.
+     * @param count The number of indexes to read from the index buffer for each instance.
+     * @param offset Byte offset within indexBuffer to start reading indexes from.
+     * @param instanceCount The number of instances to draw.
+     * @see `setInstanceBuffer(Buffer* buffer, std::size_t offset)`
+     */
+    virtual void drawElementsInstanced(PrimitiveType primitiveType, IndexFormat indexType, std::size_t count, std::size_t offset, std::size_t instanceCount) = 0;
     
     /**
      * Do some resources release.
@@ -144,6 +175,12 @@ public:
      * Present a drawable and commit a command buffer so it can be executed as soon as possible.
      */
     virtual void endFrame() = 0;
+
+    /**
+     * Forget the state the backend assumes is set, so it is set again by the next draw.
+     * Call it after the graphics API was used directly.
+     */
+    virtual void invalidateState() {}
     
     /**
      * Fixed-function state
@@ -184,11 +221,17 @@ public:
      */
     void setStencilReferenceValue(unsigned int frontRef, unsigned int backRef);
 
+    /**
+     * Get the state changes of the previous frame. Backends which don't filter state changes report zeros.
+     */
+    const StateStats& getStateStats() const { return _stateStats; }
+
 protected:
     virtual ~CommandBuffer() = default;
     
     unsigned int _stencilReferenceValueFront = 0; ///< front stencil reference value.
     unsigned int _stencilReferenceValueBack = 0; ///< back stencil reference value.
+    StateStats _stateStats; ///< filled by the backend in beginFrame().
 };
 
 // end of _backend group
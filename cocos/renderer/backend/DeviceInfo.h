@@ -42,7 +42,10 @@ enum class FeatureType : uint32_t
     VAO,
     MAPBUFFER,
     DEPTH24,
-    ASTC
+    ASTC,
+    ELEMENT_INDEX_UINT,
+    INSTANCED_DRAW,
+    PROGRAM_BINARY
 };
 
 /**
@@ -140,6 +140,12 @@ public:
      * @return The uniformInfos.
      */
     virtual const std::unordered_map<std::string, UniformInfo>& getAllActiveUniformInfo(ShaderStage stage) const = 0;
+
+    /**
+     * Whether the program was loaded from the program binary cache instead of being compiled from source.
+     * @see CC_ENABLE_PROGRAM_BINARY_CACHE
+     */
+    bool isLoadedFromBinaryCache() const { return _loadedFromBinaryCache; }
     
 protected:
     /**
@@ -185,6 +191,7 @@ protected:
     std::string _vertexShader; ///< Vertex shader.
     std::string _fragmentShader; ///< Fragment shader.
     ProgramType _programType = ProgramType::CUSTOM_PROGRAM; ///< built-in program type, initial value is CUSTOM_PROGRAM.
+    bool _loadedFromBinaryCache = false; ///< set by the backend when the program came from a cached binary.
 };
 
 //end of _backend group
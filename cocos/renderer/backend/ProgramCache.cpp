@@ -29,6 +29,8 @@
 #include "base/ccMacros.h"
 #include "base/CCConfiguration.h"
 
+#include <chrono>
+
 CC_BACKEND_BEGIN
 
 namespace
@@ -82,6 +84,8 @@ ProgramCache::~ProgramCache()
 
 bool ProgramCache::init()
 {
+    auto startTime = std::chrono::steady_clock::now();
+
     addProgram(ProgramType::POSITION_TEXTURE_COLOR);
     addProgram(ProgramType::ETC1);
     addProgram(ProgramType::LABEL_DISTANCE_NORMAL);
@@ -111,6 +115,21 @@ bool ProgramCache::init()
     addProgram(ProgramType::TERRAIN_3D);
     addProgram(ProgramType::PARTICLE_TEXTURE_3D);
     addProgram(ProgramType::PARTICLE_COLOR_3D);
+    if (Device::getInstance()->getDeviceInfo()->checkForFeatureSupported(FeatureType::INSTANCED_DRAW))
+    {
+        addProgram(ProgramType::POSITION_TEXTURE_3D_INSTANCE);
+        addProgram(ProgramType::POSITION_3D_INSTANCE);
+    }
+
+    _builtinProgramsLoadTime = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+    _builtinProgramsFromBinaryCache = 0;
+    for (auto& program : _cachedPrograms)
+    {
+        if (program.second->isLoadedFromBinaryCache())
+            ++_builtinProgramsFromBinaryCache;
+    }
+    CCLOG("cocos2d: ProgramCache: %d built-in programs created in %.1f ms, %d of them from the program binary cache",
+          (int)_cachedPrograms.size(), _builtinProgramsLoadTime, _builtinProgramsFromBinaryCache);
 
     /* FIXME: Naming style
     ** ETC1: POSITION_TEXTURE_COLOR_ETC1
@@ -233,6 +252,18 @@ void ProgramCache::addProgram(ProgramType type)
         case ProgramType::PARTICLE_COLOR_3D:
             program = backend::Device::getInstance()->newProgram(CC3D_particle_vert, CC3D_particleColor_frag);
             break;
+        case ProgramType::POSITION_TEXTURE_3D_INSTANCE:
+            {
+                std::string instancingDef = "\n#define USE_INSTANCING 1 \n";
+                program = backend::Device::getInstance()->newProgram(instancingDef + CC3D_positionTexture_vert, CC3D_colorTexture_frag);
+            }
+            break;
+        case ProgramType::POSITION_3D_INSTANCE:
+            {
+                std::string instancingDef = "\n#define USE_INSTANCING 1 \n";
+                program = backend::Device::getInstance()->newProgram(instancingDef + CC3D_positionTexture_vert, CC3D_color_frag);
+            }
+            break;
         default:
             CCASSERT(false, "Not built-in program type.");
             break;
@@ -297,6 +328,7 @@ void ProgramCache::removeAllPrograms()
         program.second->release();
     }
     _cachedPrograms.clear();
+    _builtinProgramsFromBinaryCache = 0;
 }
 
 CC_BACKEND_END
@@ -70,6 +70,17 @@ public:
      * Remove all program objects from cache.
      */
     void removeAllPrograms();
+
+    /**
+     * Get the time init() took to create the built-in programs, in milliseconds.
+     * Compare a cold start with a warm one to see what the program binary cache saves.
+     */
+    float getBuiltinProgramsLoadTime() const { return _builtinProgramsLoadTime; }
+
+    /**
+     * Get the number of built-in programs which init() loaded from the program binary cache.
+     */
+    int getBuiltinProgramsFromBinaryCache() const { return _builtinProgramsFromBinaryCache; }
     
 protected:
     ProgramCache() = default;
@@ -85,6 +96,9 @@ protected:
     
     static std::unordered_map<backend::ProgramType, backend::Program*> _cachedPrograms; ///< The cached program object.
     static ProgramCache *_sharedProgramCache; ///< A shared instance of the program cache.
+
+    float _builtinProgramsLoadTime = 0.f;
+    int _builtinProgramsFromBinaryCache = 0;
 };
 
 //end of _backend group
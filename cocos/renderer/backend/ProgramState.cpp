@@ -30,8 +30,10 @@
 #include "base/CCEventDispatcher.h"
 #include "base/CCEventType.h"
 #include "base/CCDirector.h"
+#include "xxhash.h"
 
 #include <algorithm>
+#include <mutex>
 
 #ifdef CC_USE_METAL
 #include "glsl_optimizer.h"
@@ -80,10 +82,43 @@ namespace {
         dst[4] = src[3]; dst[5] = src[4]; dst[6] = src[5];
         dst[8] = src[6]; dst[9] = src[7]; dst[10] = src[8];
     }
+
+    // Order independent, texture infos live in unordered maps.
+    uint32_t hashTextureInfos(const std::unordered_map<int, TextureInfo>& textureInfos, uint32_t seed)
+    {
+        uint32_t hash = 0;
+        for (const auto& iter : textureInfos)
+        {
+            uint32_t infoHash = XXH32(&iter.first, sizeof(iter.first), seed);
+            infoHash = XXH32(iter.second.slot.data(), iter.second.slot.size() * sizeof(uint32_t), infoHash);
+            infoHash = XXH32(iter.second.textures.data(), iter.second.textures.size() * sizeof(TextureBackend*), infoHash);
+            hash += infoHash;
+        }
+        return hash;
+    }
+
+    bool isSameTextureInfos(const std::unordered_map<int, TextureInfo>& lhs, const std::unordered_map<int, TextureInfo>& rhs)
+    {
+        if (lhs.size() != rhs.size())
+            return false;
+
+        for (const auto& iter : lhs)
+        {
+            auto other = rhs.find(iter.first);
+            if (other == rhs.end() || other->second.slot != iter.second.slot || other->second.textures != iter.second.textures)
+                return false;
+        }
+        return true;
+    }
 }
 
 //static field
 std::vector<ProgramState::AutoBindingResolver*> ProgramState::_customAutoBindingResolvers;
+std::unordered_multimap<uint32_t, ProgramState::Storage*> ProgramState::_internedStorages;
+ProgramState::SharingStats ProgramState::_sharingStats;
+// Guards the interned storages, the reference counts of the storages and the stats.
+// Program states may be created and released by the loader threads too.
+static std::recursive_mutex s_sharingMutex;
 
 TextureInfo::TextureInfo(const std::vector<uint32_t>& _slots, const std::vector<backend::TextureBackend*> _textures)
 : slot(_slots)
@@ -155,89 +190,261 @@ TextureInfo& TextureInfo::operator=(const TextureInfo& rhs)
     return *this;
 }
 
-ProgramState::ProgramState(Program* program)
+ProgramState::Storage::Storage(Program* program)
+: program(program)
 {
-    init(program);
+    vertexUniformBufferSize = program->getUniformBufferSize(ShaderStage::VERTEX);
+    vertexUniformBuffer = new char[vertexUniformBufferSize];
+    memset(vertexUniformBuffer, 0, vertexUniformBufferSize);
+#ifdef CC_USE_METAL
+    fragmentUniformBufferSize = program->getUniformBufferSize(ShaderStage::FRAGMENT);
+    fragmentUniformBuffer = new char[fragmentUniformBufferSize];
+    memset(fragmentUniformBuffer, 0, fragmentUniformBufferSize);
+#endif
+
+#if CC_ENABLE_CACHE_TEXTURE_DATA
+    backToForegroundListener = EventListenerCustom::create(EVENT_RENDERER_RECREATED, [this](EventCustom*){
+        this->resetUniforms();
+    });
+    Director::getInstance()->getEventDispatcher()->addEventListenerWithFixedPriority(backToForegroundListener, -1);
+#endif
+
+    std::lock_guard<std::recursive_mutex> lock(s_sharingMutex);
+    ++_sharingStats.storages;
+    _sharingStats.bytes += sizeof(Storage) + vertexUniformBufferSize + fragmentUniformBufferSize;
 }
 
-bool ProgramState::init(Program* program)
+ProgramState::Storage::Storage(const Storage& other)
+: program(other.program)
+, vertexUniformBufferSize(other.vertexUniformBufferSize)
+, fragmentUniformBufferSize(other.fragmentUniformBufferSize)
+, vertexTextureInfos(other.vertexTextureInfos)
+, fragmentTextureInfos(other.fragmentTextureInfos)
 {
-    CC_SAFE_RETAIN(program);
-    _program = program;
-    _vertexUniformBufferSize = _program->getUniformBufferSize(ShaderStage::VERTEX);
-    _vertexUniformBuffer = new char[_vertexUniformBufferSize];
-    memset(_vertexUniformBuffer, 0, _vertexUniformBufferSize);
+    vertexUniformBuffer = new char[vertexUniformBufferSize];
+    memcpy(vertexUniformBuffer, other.vertexUniformBuffer, vertexUniformBufferSize);
 #ifdef CC_USE_METAL
-    _fragmentUniformBufferSize = _program->getUniformBufferSize(ShaderStage::FRAGMENT);
-    _fragmentUniformBuffer = new char[_fragmentUniformBufferSize];
-    memset(_fragmentUniformBuffer, 0, _fragmentUniformBufferSize);
+    fragmentUniformBuffer = new char[fragmentUniformBufferSize];
+    memcpy(fragmentUniformBuffer, other.fragmentUniformBuffer, fragmentUniformBufferSize);
 #endif
 
 #if CC_ENABLE_CACHE_TEXTURE_DATA
-    _backToForegroundListener = EventListenerCustom::create(EVENT_RENDERER_RECREATED, [this](EventCustom*){
+    backToForegroundListener = EventListenerCustom::create(EVENT_RENDERER_RECREATED, [this](EventCustom*){
         this->resetUniforms();
     });
-    Director::getInstance()->getEventDispatcher()->addEventListenerWithFixedPriority(_backToForegroundListener, -1);
+    Director::getInstance()->getEventDispatcher()->addEventListenerWithFixedPriority(backToForegroundListener, -1);
 #endif
-    return true;
+
+    std::lock_guard<std::recursive_mutex> lock(s_sharingMutex);
+    ++_sharingStats.storages;
+    _sharingStats.bytes += sizeof(Storage) + vertexUniformBufferSize + fragmentUniformBufferSize;
 }
 
-void ProgramState::resetUniforms()
+ProgramState::Storage::~Storage()
 {
+    CC_SAFE_DELETE_ARRAY(vertexUniformBuffer);
+    CC_SAFE_DELETE_ARRAY(fragmentUniformBuffer);
+
 #if CC_ENABLE_CACHE_TEXTURE_DATA
-    if(_program == nullptr)
+    Director::getInstance()->getEventDispatcher()->removeEventListener(backToForegroundListener);
+#endif
+
+    std::lock_guard<std::recursive_mutex> lock(s_sharingMutex);
+    --_sharingStats.storages;
+    _sharingStats.bytes -= sizeof(Storage) + vertexUniformBufferSize + fragmentUniformBufferSize;
+}
+
+uint32_t ProgramState::Storage::computeHash() const
+{
+    uint32_t seed = XXH32(&program, sizeof(program), 0);
+    uint32_t result = XXH32(vertexUniformBuffer, vertexUniformBufferSize, seed);
+    if (fragmentUniformBuffer)
+        result = XXH32(fragmentUniformBuffer, fragmentUniformBufferSize, result);
+    result ^= hashTextureInfos(vertexTextureInfos, seed);
+    result ^= hashTextureInfos(fragmentTextureInfos, ~seed);
+    return result;
+}
+
+bool ProgramState::Storage::isSameData(const Storage& other) const
+{
+    return program == other.program
+        && vertexUniformBufferSize == other.vertexUniformBufferSize
+        && fragmentUniformBufferSize == other.fragmentUniformBufferSize
+        && memcmp(vertexUniformBuffer, other.vertexUniformBuffer, vertexUniformBufferSize) == 0
+        && (fragmentUniformBufferSize == 0 || memcmp(fragmentUniformBuffer, other.fragmentUniformBuffer, fragmentUniformBufferSize) == 0)
+        && isSameTextureInfos(vertexTextureInfos, other.vertexTextureInfos)
+        && isSameTextureInfos(fragmentTextureInfos, other.fragmentTextureInfos);
+}
+
+void ProgramState::Storage::resetUniforms()
+{
+#if CC_ENABLE_CACHE_TEXTURE_DATA
+    if(program == nullptr)
         return;
 
-    const auto& uniformLocation = _program->getAllUniformsLocation();
+    const auto& uniformLocation = program->getAllUniformsLocation();
     for(const auto& uniform : uniformLocation)
     {
         auto location = uniform.second;
-        auto mappedLocation = _program->getMappedLocation(location);
+        auto mappedLocation = program->getMappedLocation(location);
 
         //check if current location had been set before
-        if(_vertexTextureInfos.find(location) != _vertexTextureInfos.end())
+        if(vertexTextureInfos.find(location) != vertexTextureInfos.end())
         {
-            _vertexTextureInfos[location].location = mappedLocation;
+            vertexTextureInfos[location].location = mappedLocation;
         }
     }
 #endif
 }
 
+ProgramState::ProgramState(Program* program, bool shared)
+{
+    init(program, shared);
+}
+
+bool ProgramState::init(Program* program, bool shared)
+{
+    CC_SAFE_RETAIN(program);
+    _program = program;
+    _shared = shared;
+    _storage = new Storage(program);
+
+    std::lock_guard<std::recursive_mutex> lock(s_sharingMutex);
+    if (_shared)
+        internStorage(_storage);
+
+    ++_sharingStats.programStates;
+    _sharingStats.bytes += sizeof(ProgramState) + sizeof(VertexLayout);
+    return true;
+}
+
 ProgramState::ProgramState()
 {
+    std::lock_guard<std::recursive_mutex> lock(s_sharingMutex);
+    ++_sharingStats.programStates;
+    _sharingStats.bytes += sizeof(ProgramState) + sizeof(VertexLayout);
 }
 
 ProgramState::~ProgramState()
 {
     CC_SAFE_RELEASE(_program);
-    CC_SAFE_DELETE_ARRAY(_vertexUniformBuffer);
-    CC_SAFE_DELETE_ARRAY(_fragmentUniformBuffer);
-    
-#if CC_ENABLE_CACHE_TEXTURE_DATA
-    Director::getInstance()->getEventDispatcher()->removeEventListener(_backToForegroundListener);
-#endif
+
+    std::lock_guard<std::recursive_mutex> lock(s_sharingMutex);
+    if (_storage)
+        releaseStorage(_storage);
+
+    --_sharingStats.programStates;
+    _sharingStats.bytes -= sizeof(ProgramState) + sizeof(VertexLayout);
 }
 
 ProgramState *ProgramState::clone() const
 {
     ProgramState *cp = new ProgramState();
     cp->_program = _program;
-    cp->_vertexUniformBufferSize = _vertexUniformBufferSize;
-    cp->_fragmentUniformBufferSize = _fragmentUniformBufferSize;
-    cp->_vertexTextureInfos = _vertexTextureInfos;
-    cp->_fragmentTextureInfos = _fragmentTextureInfos;
-    cp->_vertexUniformBuffer = new char[_vertexUniformBufferSize];
-    memcpy(cp->_vertexUniformBuffer, _vertexUniformBuffer, _vertexUniformBufferSize);
+    cp->_shared = _shared;
+    if (_shared)
+    {
+        std::lock_guard<std::recursive_mutex> lock(s_sharingMutex);
+        cp->_storage = _storage;
+        ++_storage->referenceCount;
+    }
+    else
+    {
+        cp->_storage = new Storage(*_storage);
+    }
     cp->_vertexLayout = _vertexLayout;
-#ifdef CC_USE_METAL
-    cp->_fragmentUniformBuffer = new char[_fragmentUniformBufferSize];
-    memcpy(cp->_fragmentUniformBuffer, _fragmentUniformBuffer, _fragmentUniformBufferSize);
-#endif
     CC_SAFE_RETAIN(cp->_program);
 
     return cp;
 }
 
+ProgramState::SharingStats ProgramState::getSharingStats()
+{
+    std::lock_guard<std::recursive_mutex> lock(s_sharingMutex);
+    SharingStats stats = _sharingStats;
+    stats.internedStorages = _internedStorages.size();
+    return stats;
+}
+
+void ProgramState::internStorage(Storage*& storage)
+{
+    std::lock_guard<std::recursive_mutex> lock(s_sharingMutex);
+    storage->hash = storage->computeHash();
+    auto range = _internedStorages.equal_range(storage->hash);
+    for (auto iter = range.first; iter != range.second; ++iter)
+    {
+        if (iter->second->isSameData(*storage))
+        {
+            ++iter->second->referenceCount;
+            releaseStorage(storage);
+            storage = iter->second;
+            return;
+        }
+    }
+
+    storage->interned = true;
+    _internedStorages.emplace(storage->hash, storage);
+}
+
+void ProgramState::uninternStorage(Storage* storage)
+{
+    std::lock_guard<std::recursive_mutex> lock(s_sharingMutex);
+    auto range = _internedStorages.equal_range(storage->hash);
+    for (auto iter = range.first; iter != range.second; ++iter)
+    {
+        if (iter->second == storage)
+        {
+            _internedStorages.erase(iter);
+            break;
+        }
+    }
+    storage->interned = false;
+}
+
+void ProgramState::releaseStorage(Storage* storage)
+{
+    std::lock_guard<std::recursive_mutex> lock(s_sharingMutex);
+    if (--storage->referenceCount > 0)
+        return;
+
+    if (storage->interned)
+        uninternStorage(storage);
+    delete storage;
+}
+
+void ProgramState::beginStorageWrite()
+{
+    if (!_storage->interned)
+        return;
+
+    std::lock_guard<std::recursive_mutex> lock(s_sharingMutex);
+    // Nobody else sees it, so it can be written in place as long as it is left out of the lookup meanwhile.
+    if (_storage->referenceCount == 1)
+    {
+        uninternStorage(_storage);
+        return;
+    }
+
+    auto storage = new Storage(*_storage);
+    releaseStorage(_storage);
+    _storage = storage;
+}
+
+void ProgramState::endStorageWrite()
+{
+    if (_shared)
+        internStorage(_storage);
+}
+
+void ProgramState::makeStoragePrivate()
+{
+    if (!_shared)
+        return;
+
+    beginStorageWrite();
+    _shared = false;
+}
+
 backend::UniformLocation ProgramState::getUniformLocation(backend::Uniform name) const
 {
     return _program->getUniformLocation(name);
@@ -250,7 +457,9 @@ backend::UniformLocation ProgramState::getUniformLocation(const std::string& uni
 
 void ProgramState::setCallbackUniform(const backend::UniformLocation& uniformLocation,const UniformCallback& callback)
 {
-    _callbackUniforms[uniformLocation] = callback;
+    // Callbacks can't be compared, so the storage can't be shared any more.
+    makeStoragePrivate();
+    _storage->callbackUniforms[uniformLocation] = callback;
 }
 
 void ProgramState::setUniform(const backend::UniformLocation& uniformLocation, const void* data, std::size_t size)
@@ -349,17 +558,26 @@ void ProgramState::setVertexUniform(int location, const void* data, std::size_t
 //float3 etc in Metal has both sizeof and alignment same as float4, need convert to correct laytout
 #ifdef CC_USE_METAL
     const auto& uniformInfo = _program->getActiveUniformInfo(ShaderStage::VERTEX, location);
+    if(_storage->interned && !uniformInfo.needConvert && memcmp(_storage->vertexUniformBuffer + location, data, size) == 0)
+        return;
+
+    beginStorageWrite();
     if(uniformInfo.needConvert)
     {
-        convertAndCopyUniformData(uniformInfo, data, size, _vertexUniformBuffer);
+        convertAndCopyUniformData(uniformInfo, data, size, _storage->vertexUniformBuffer);
     }
     else
     {
-        memcpy(_vertexUniformBuffer + location, data, size);
+        memcpy(_storage->vertexUniformBuffer + location, data, size);
     }
 #else
-    memcpy(_vertexUniformBuffer + offset, data, size);
+    if(_storage->interned && memcmp(_storage->vertexUniformBuffer + offset, data, size) == 0)
+        return;
+
+    beginStorageWrite();
+    memcpy(_storage->vertexUniformBuffer + offset, data, size);
 #endif
+    endStorageWrite();
 }
 
 void ProgramState::setFragmentUniform(int location, const void* data, std::size_t size)
@@ -370,14 +588,19 @@ void ProgramState::setFragmentUniform(int location, const void* data, std::size_
 //float3 etc in Metal has both sizeof and alignment same as float4, need convert to correct laytout
 #ifdef CC_USE_METAL
     const auto& uniformInfo = _program->getActiveUniformInfo(ShaderStage::FRAGMENT, location);
+    if(_storage->interned && !uniformInfo.needConvert && memcmp(_storage->fragmentUniformBuffer + location, data, size) == 0)
+        return;
+
+    beginStorageWrite();
     if(uniformInfo.needConvert)
     {
-        convertAndCopyUniformData(uniformInfo, data, size, _fragmentUniformBuffer);
+        convertAndCopyUniformData(uniformInfo, data, size, _storage->fragmentUniformBuffer);
     }
     else
     {
-        memcpy(_fragmentUniformBuffer + location, data, size);
+        memcpy(_storage->fragmentUniformBuffer + location, data, size);
     }
+    endStorageWrite();
 #endif
 }
 
@@ -394,14 +617,14 @@ void ProgramState::setTexture(const backend::UniformLocation& uniformLocation, u
     switch (uniformLocation.shaderStage)
     {
         case backend::ShaderStage::VERTEX:
-            setTexture(uniformLocation.location[0], slot, texture, _vertexTextureInfos);
+            setTexture(uniformLocation.location[0], slot, texture, ShaderStage::VERTEX);
             break;
         case backend::ShaderStage::FRAGMENT:
-            setTexture(uniformLocation.location[1], slot, texture, _fragmentTextureInfos);
+            setTexture(uniformLocation.location[1], slot, texture, ShaderStage::FRAGMENT);
             break;
         case backend::ShaderStage::VERTEX_AND_FRAGMENT:
-            setTexture(uniformLocation.location[0], slot, texture, _vertexTextureInfos);
-            setTexture(uniformLocation.location[1], slot, texture, _fragmentTextureInfos);
+            setTexture(uniformLocation.location[0], slot, texture, ShaderStage::VERTEX);
+            setTexture(uniformLocation.location[1], slot, texture, ShaderStage::FRAGMENT);
             break;
         default:
             break;
@@ -413,24 +636,36 @@ void ProgramState::setTextureArray(const backend::UniformLocation& uniformLocati
     switch (uniformLocation.shaderStage)
     {
         case backend::ShaderStage::VERTEX:
-            setTextureArray(uniformLocation.location[0], slots, textures, _vertexTextureInfos);
+            setTextureArray(uniformLocation.location[0], slots, textures, ShaderStage::VERTEX);
             break;
         case backend::ShaderStage::FRAGMENT:
-            setTextureArray(uniformLocation.location[1], slots, textures, _fragmentTextureInfos);
+            setTextureArray(uniformLocation.location[1], slots, textures, ShaderStage::FRAGMENT);
             break;
         case backend::ShaderStage::VERTEX_AND_FRAGMENT:
-            setTextureArray(uniformLocation.location[0], slots, textures, _vertexTextureInfos);
-            setTextureArray(uniformLocation.location[1], slots, textures, _fragmentTextureInfos);
+            setTextureArray(uniformLocation.location[0], slots, textures, ShaderStage::VERTEX);
+            setTextureArray(uniformLocation.location[1], slots, textures, ShaderStage::FRAGMENT);
             break;
         default:
             break;
     }
 }
 
-void ProgramState::setTexture(int location, uint32_t slot, backend::TextureBackend* texture, std::unordered_map<int, TextureInfo>& textureInfo)
+void ProgramState::setTexture(int location, uint32_t slot, backend::TextureBackend* texture, ShaderStage stage)
 {
     if(location < 0)
         return;
+
+    if(_storage->interned)
+    {
+        const auto& textureInfos = stage == ShaderStage::VERTEX ? _storage->vertexTextureInfos : _storage->fragmentTextureInfos;
+        auto iter = textureInfos.find(location);
+        if(iter != textureInfos.end() && iter->second.slot.size() == 1 && iter->second.slot[0] == slot
+           && iter->second.textures.size() == 1 && iter->second.textures[0] == texture)
+            return;
+    }
+
+    beginStorageWrite();
+    auto& textureInfo = stage == ShaderStage::VERTEX ? _storage->vertexTextureInfos : _storage->fragmentTextureInfos;
     TextureInfo& info = textureInfo[location];
     info.releaseTextures();
     info.slot = {slot};
@@ -439,11 +674,14 @@ void ProgramState::setTexture(int location, uint32_t slot, backend::TextureBacke
 #if CC_ENABLE_CACHE_TEXTURE_DATA
     info.location = location;
 #endif
+    endStorageWrite();
 }
 
-void ProgramState::setTextureArray(int location, const std::vector<uint32_t>& slots, const std::vector<backend::TextureBackend*> textures, std::unordered_map<int, TextureInfo>& textureInfo)
+void ProgramState::setTextureArray(int location, const std::vector<uint32_t>& slots, const std::vector<backend::TextureBackend*> textures, ShaderStage stage)
 {
     assert(slots.size() == textures.size());
+    beginStorageWrite();
+    auto& textureInfo = stage == ShaderStage::VERTEX ? _storage->vertexTextureInfos : _storage->fragmentTextureInfos;
     TextureInfo& info = textureInfo[location];
     info.releaseTextures();
     info.slot = slots;
@@ -452,11 +690,14 @@ void ProgramState::setTextureArray(int location, const std::vector<uint32_t>& sl
 #if CC_ENABLE_CACHE_TEXTURE_DATA
     info.location = location;
 #endif
+    endStorageWrite();
 }
 
 void ProgramState::setParameterAutoBinding(const std::string &uniform, const std::string &autoBinding)
 {
-    _autoBindings.emplace(uniform, autoBinding);
+    // Resolvers may set callback uniforms, which can't be shared.
+    makeStoragePrivate();
+    _storage->autoBindings.emplace(uniform, autoBinding);
     applyAutoBinding(uniform, autoBinding);
 }
 
@@ -483,14 +724,31 @@ ProgramState::AutoBindingResolver::~AutoBindingResolver()
 
 void ProgramState::getVertexUniformBuffer(char** buffer, std::size_t& size) const
 {
-    *buffer = _vertexUniformBuffer;
-    size = _vertexUniformBufferSize;
+    *buffer = _storage->vertexUniformBuffer;
+    size = _storage->vertexUniformBufferSize;
 }
 
 void ProgramState::getFragmentUniformBuffer(char** buffer, std::size_t& size) const
 {
-    *buffer = _fragmentUniformBuffer;
-    size = _fragmentUniformBufferSize;
+    *buffer = _storage->fragmentUniformBuffer;
+    size = _storage->fragmentUniformBufferSize;
+}
+
+void ProgramState::setUniformBuffers(const char* vertexBuffer, std::size_t vertexSize, const char* fragmentBuffer, std::size_t fragmentSize)
+{
+    if (vertexSize != _storage->vertexUniformBufferSize || fragmentSize != _storage->fragmentUniformBufferSize)
+        return;
+
+    if ((!vertexSize || memcmp(_storage->vertexUniformBuffer, vertexBuffer, vertexSize) == 0) &&
+        (!fragmentSize || memcmp(_storage->fragmentUniformBuffer, fragmentBuffer, fragmentSize) == 0))
+        return;
+
+    beginStorageWrite();
+    if (vertexSize)
+        memcpy(_storage->vertexUniformBuffer, vertexBuffer, vertexSize);
+    if (fragmentSize)
+        memcpy(_storage->fragmentUniformBuffer, fragmentBuffer, fragmentSize);
+    endStorageWrite();
 }
 
 CC_BACKEND_END
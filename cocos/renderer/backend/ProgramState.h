@@ -71,24 +71,48 @@ struct TextureInfo
 /**
  * A program state object can create or reuse a program.
  * Each program state object keep its own unifroms and textures data.
+ *
+ * A shared program state points at an interned storage which is used by all shared program states
+ * with the same program, uniforms and textures. Writing a different value gives it a private copy of
+ * the storage, which is interned again so that nodes ending up with the same values share it as well.
  */
 class ProgramState : public Ref
 {
 public:
     using UniformCallback = std::function<void(ProgramState*, const UniformLocation &)>;
 
+    /** Counters of the program states alive, used to measure the memory saved by shared program states. */
+    struct SharingStats
+    {
+        std::size_t programStates = 0;
+        std::size_t storages = 0;
+        std::size_t internedStorages = 0;
+        /** Approximate memory used by program states and their storages, in bytes. */
+        std::size_t bytes = 0;
+    };
+
     /**
      * @param program Specifies the program.
+     * @param shared Whether the uniforms and textures data is shared with identical program states.
      */
-    ProgramState(Program* program);
+    ProgramState(Program* program, bool shared = false);
     
     ///destructor
     virtual ~ProgramState();
     
     /**
-     * Deep clone ProgramState
+     * Deep clone ProgramState, a shared program state is cloned by sharing its storage.
      */
     ProgramState *clone() const;
+
+    /**
+     * Whether the uniforms and textures data is shared with identical program states.
+     * Setting a callback uniform or an auto binding makes the program state private.
+     */
+    bool isShared() const { return _shared; }
+
+    /** Get the counters of the program states alive. */
+    static SharingStats getSharingStats();
     
     /**
      * Get the program object.
@@ -170,19 +194,19 @@ public:
      * Get vertex texture informations
      * @return Vertex texture informations. Key is the texture location, Value store the texture informations
      */
-    inline const std::unordered_map<int, TextureInfo>& getVertexTextureInfos() const { return _vertexTextureInfos; }
+    inline const std::unordered_map<int, TextureInfo>& getVertexTextureInfos() const { return _storage->vertexTextureInfos; }
 
     /**
      * Get fragment texture informations
      * @return Fragment texture informations. Key is the texture location, Value store the texture informations
      */
-    inline const std::unordered_map<int, TextureInfo>& getFragmentTextureInfos() const { return _fragmentTextureInfos; }
+    inline const std::unordered_map<int, TextureInfo>& getFragmentTextureInfos() const { return _storage->fragmentTextureInfos; }
 
     /**
      * Get the uniform callback function.
      * @return Uniform callback funciton.
      */
-    inline const std::unordered_map<UniformLocation, UniformCallback, UniformLocation>& getCallbackUniforms() const { return _callbackUniforms; }
+    inline const std::unordered_map<UniformLocation, UniformCallback, UniformLocation>& getCallbackUniforms() const { return _storage->callbackUniforms; }
 
     /**
      * Get vertex uniform buffer. The buffer store all the vertex uniform's data.
@@ -197,6 +221,12 @@ public:
      * @param[out] size Specifies the size of the buffer in bytes.
      */
     void getFragmentUniformBuffer(char** buffer, std::size_t& size) const;
+
+    /**
+     * Replace the vertex and fragment uniform buffers, for example with a copy taken earlier by
+     * getVertexUniformBuffer() and getFragmentUniformBuffer(). The sizes must be the same.
+     */
+    void setUniformBuffers(const char* vertexBuffer, std::size_t vertexSize, const char* fragmentBuffer, std::size_t fragmentSize);
     
     /**
     * An abstract base class that can be extended to support custom material auto bindings.
@@ -262,6 +292,42 @@ public:
 
     inline std::shared_ptr<VertexLayout> getVertexLayout() const { return _vertexLayout; }
 protected:
+    /**
+     * Uniforms and textures data, reference counted by the program states using it.
+     * An interned storage is never written while it is used by more than one program state.
+     */
+    struct Storage
+    {
+        explicit Storage(Program* program);
+        /** Copies the uniforms and textures, callback uniforms and auto bindings are not copied. */
+        Storage(const Storage& other);
+        ~Storage();
+
+        uint32_t computeHash() const;
+        bool isSameData(const Storage& other) const;
+        /** Reset uniform informations when EGL context lost */
+        void resetUniforms();
+
+        backend::Program* program = nullptr;
+        std::unordered_map<UniformLocation, UniformCallback, UniformLocation> callbackUniforms;
+        char* vertexUniformBuffer = nullptr;
+        char* fragmentUniformBuffer = nullptr;
+        std::size_t vertexUniformBufferSize = 0;
+        std::size_t fragmentUniformBufferSize = 0;
+
+        std::unordered_map<int, TextureInfo> vertexTextureInfos;
+        std::unordered_map<int, TextureInfo> fragmentTextureInfos;
+
+        std::unordered_map<std::string, std::string> autoBindings;
+
+        unsigned int referenceCount = 1;
+        uint32_t hash = 0;
+        bool interned = false;
+
+#if CC_ENABLE_CACHE_TEXTURE_DATA
+        EventListenerCustom* backToForegroundListener = nullptr;
+#endif
+    };
 
     ProgramState();
 
@@ -286,26 +352,32 @@ protected:
      * @param location Specifies the location of texture.
      * @param slot Specifies slot selector of texture.
      * @param texture Specifies the texture to set in given location.
-     * @param textureInfo Specifies the texture information to update.
+     * @param stage Specifies the stage of the texture informations to update.
      */
-    void setTexture(int location, uint32_t slot, backend::TextureBackend* texture, std::unordered_map<int, TextureInfo>& textureInfo);
+    void setTexture(int location, uint32_t slot, backend::TextureBackend* texture, ShaderStage stage);
     
     /**
      * Set textures in array.
      * @param location Specifies the location of texture.
      * @param slots Specifies slot selector of texture.
      * @param textures Specifies the texture to set in given location.
-     * @param textureInfo Specifies the texture information to update.
-     */
-    void setTextureArray(int location, const std::vector<uint32_t>& slots, const std::vector<backend::TextureBackend*> textures, std::unordered_map<int, TextureInfo>& textureInfo);
-    
-    /**
-     * Reset uniform informations when EGL context lost
+     * @param stage Specifies the stage of the texture informations to update.
      */
-    void resetUniforms();
+    void setTextureArray(int location, const std::vector<uint32_t>& slots, const std::vector<backend::TextureBackend*> textures, ShaderStage stage);
 
     ///Initialize.
-    bool init(Program* program);
+    bool init(Program* program, bool shared);
+
+    /** Makes the storage writable, copying it if it is used by other program states. */
+    void beginStorageWrite();
+    /** Interns the written storage again, switching to an identical one if there is any. */
+    void endStorageWrite();
+    /** Gives the program state a private storage which is never shared again. */
+    void makeStoragePrivate();
+
+    static void internStorage(Storage*& storage);
+    static void uninternStorage(Storage* storage);
+    static void releaseStorage(Storage* storage);
     
 #ifdef CC_USE_METAL
     /**
@@ -326,23 +398,13 @@ protected:
     void applyAutoBinding(const std::string &, const std::string &);
 
     backend::Program*                                       _program = nullptr;
-    std::unordered_map<UniformLocation, UniformCallback, UniformLocation>   _callbackUniforms;
-    char* _vertexUniformBuffer = nullptr;
-    char* _fragmentUniformBuffer = nullptr;
-    std::size_t _vertexUniformBufferSize = 0;
-    std::size_t _fragmentUniformBufferSize = 0;
-
-    std::unordered_map<int, TextureInfo>                    _vertexTextureInfos;
-    std::unordered_map<int, TextureInfo>                    _fragmentTextureInfos;
-
-    std::unordered_map<std::string, std::string>            _autoBindings;
+    Storage*                                                _storage = nullptr;
+    bool                                                    _shared = false;
 
     static std::vector<AutoBindingResolver*>                _customAutoBindingResolvers;
+    static std::unordered_multimap<uint32_t, Storage*>      _internedStorages;
+    static SharingStats                                     _sharingStats;
     std::shared_ptr<VertexLayout> _vertexLayout = std::make_shared<VertexLayout>();
-
-#if CC_ENABLE_CACHE_TEXTURE_DATA
-    EventListenerCustom* _backToForegroundListener = nullptr;
-#endif
 };
 
 //end of _backend group
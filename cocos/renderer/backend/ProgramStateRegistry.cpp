@@ -50,10 +50,15 @@ ProgramState* ProgramStateRegistry::getProgramState(ProgramType programType, int
     if (it != this->_registry.end()) {
         auto fallback = it->second;
         if (fallback)
-            return new(std::nothrow) ProgramState(fallback);
+            return getProgramState(fallback);
     }
 
-    return new(std::nothrow) ProgramState(Program::getBuiltinProgram((ProgramType)programType));
+    return getProgramState(Program::getBuiltinProgram((ProgramType)programType));
+}
+
+ProgramState* ProgramStateRegistry::getProgramState(Program* program)
+{
+    return new(std::nothrow) ProgramState(program, _sharingEnabled);
 }
 
 ProgramType ProgramStateRegistry::getProgramType(ProgramType programType, int textureFormatEXT)
@@ -44,9 +44,20 @@ public:
     ProgramState* getProgramState(ProgramType programType, int textureFormatEXT);
     ProgramType getProgramType(ProgramType programType, int textureFormatEXT);
 
+    /**
+     * Creates a program state of the program, which shares its uniforms and textures with
+     * identical program states when sharing is enabled. The caller owns the returned program state.
+     */
+    ProgramState* getProgramState(Program* program);
+
+    /** Enables or disables sharing of the program states created afterwards, see CC_ENABLE_SHARED_PROGRAM_STATE. */
+    void setSharingEnabled(bool enabled) { _sharingEnabled = enabled; }
+    bool isSharingEnabled() const { return _sharingEnabled; }
+
 protected:
 
     std::unordered_map<uint32_t, Program*> _registry;
+    bool _sharingEnabled = CC_ENABLE_SHARED_PROGRAM_STATE;
 };
 
 //end of _backend group
@@ -36,7 +36,8 @@ CC_BACKEND_BEGIN
 enum class BufferUsage : uint32_t
 {
     STATIC,
-    DYNAMIC
+    DYNAMIC,
+    STREAM ///< Rewritten every frame, see Buffer::streamData().
 };
 
 enum class BufferType : uint32_t
@@ -374,6 +375,8 @@ enum class ProgramType : size_t
     SKINPOSITION_BUMPEDNORMAL_TEXTURE_3D,   //CC3D_skinPositionNormalTexture_vert,  CC3D_colorNormalTexture_frag
     PARTICLE_TEXTURE_3D,                    //CC3D_particle_vert,                   CC3D_particleTexture_frag
     PARTICLE_COLOR_3D,                      //CC3D_particle_vert,                   CC3D_particleColor_frag
+    POSITION_TEXTURE_3D_INSTANCE,           //CC3D_positionTexture_vert,            CC3D_colorTexture_frag, requires FeatureType::INSTANCED_DRAW
+    POSITION_3D_INSTANCE,                   //CC3D_positionTexture_vert,            CC3D_color_frag, requires FeatureType::INSTANCED_DRAW
 
     CUSTOM_PROGRAM,                         //user-define program
 };
@@ -395,6 +398,8 @@ static const char* ATTRIBUTE_NAME_TEXCOORD = "a_texCoord";
 static const char* ATTRIBUTE_NAME_TEXCOORD1 = "a_texCoord1";
 static const char* ATTRIBUTE_NAME_TEXCOORD2 = "a_texCoord2";
 static const char* ATTRIBUTE_NAME_TEXCOORD3 = "a_texCoord3";
+///per instance model matrix (mat4) of instanced programs
+static const char* ATTRIBUTE_NAME_INSTANCE = "a_instance";
 
 /**
  * @brief a structor to store blend descriptor
@@ -48,7 +48,7 @@ public:
      * @param mtlDevice The device for which MTLBuffer object was created.
      * @param size Specifies the size in bytes of the buffer object's new data store.
      * @param type Specifies the target buffer object. The symbolic constant must be BufferType::VERTEX or BufferType::INDEX.
-     * @param usage Specifies the expected usage pattern of the data store. The symbolic constant must be BufferUsage::STATIC, BufferUsage::DYNAMIC.
+     * @param usage Specifies the expected usage pattern of the data store. The symbolic constant must be BufferUsage::STATIC, BufferUsage::DYNAMIC or BufferUsage::STREAM.
      */
     BufferMTL(id<MTLDevice> mtlDevice, std::size_t size, BufferType type, BufferUsage usage);
     ~BufferMTL();
@@ -75,6 +75,14 @@ public:
      * Emply implementation. Mainly used in EGL context lost.
      */
     virtual void usingDefaultStoredData(bool needDefaultStoredData) override {};
+
+    /**
+     * @brief Append data to the buffer of the current frame of a BufferUsage::STREAM buffer.
+     * @param data Specifies a pointer to the data that will be copied into the data store.
+     * @param size Specifies the size in bytes of the data, the data of one frame shall not exceed getSize().
+     * @return The offset in bytes of the data in the buffer.
+     */
+    virtual std::size_t streamData(void* data, std::size_t size) override;
     
     /// @name Setters & Getters
     id<MTLBuffer> getMTLBuffer() const;
@@ -92,6 +100,7 @@ private:
     NSMutableArray* _dynamicDataBuffers = nil;
     int _currentFrameIndex = 0;
     bool _indexUpdated = false;
+    std::size_t _streamOffset = 0;
 };
 
 // end of _metal group
@@ -31,7 +31,8 @@ CC_BACKEND_BEGIN
 BufferMTL::BufferMTL(id<MTLDevice> mtlDevice, std::size_t size, BufferType type, BufferUsage usage)
 : Buffer(size, type, usage)
 {
-    if (BufferUsage::DYNAMIC == usage)
+    // a stream buffer is a dynamic buffer written at increasing offsets
+    if (BufferUsage::STATIC != usage)
     {
         NSMutableArray *mutableDynamicDataBuffers = [NSMutableArray arrayWithCapacity:MAX_INFLIGHT_BUFFER];
         for (int i = 0; i < MAX_INFLIGHT_BUFFER; ++i)
@@ -53,7 +54,7 @@ BufferMTL::BufferMTL(id<MTLDevice> mtlDevice, std::size_t size, BufferType type,
 
 BufferMTL::~BufferMTL()
 {
-    if (BufferUsage::DYNAMIC == _usage)
+    if (BufferUsage::STATIC != _usage)
     {
         for (id<MTLBuffer> buffer in _dynamicDataBuffers)
             [buffer release];
@@ -82,6 +83,22 @@ void BufferMTL::updateSubData(void* data, std::size_t offset, std::size_t size)
     memcpy((uint8_t*)_mtlBuffer.contents + offset, data, size);
 }
 
+std::size_t BufferMTL::streamData(void* data, std::size_t size)
+{
+    assert(BufferUsage::STREAM == _usage);
+    // first write of the frame, the buffer of the frame is empty
+    if (!_indexUpdated)
+        _streamOffset = 0;
+    updateIndex();
+
+    std::size_t offset = (_streamOffset + 3) & ~(std::size_t)3;
+    assert(offset + size <= _size);
+    memcpy((uint8_t*)_mtlBuffer.contents + offset, data, size);
+    _streamOffset = offset + size;
+    _frameStreamStats.uploadedBytes += size;
+    return offset;
+}
+
 id<MTLBuffer> BufferMTL::getMTLBuffer() const
 {
     return _mtlBuffer;
@@ -94,7 +111,7 @@ void BufferMTL::beginFrame()
 
 void BufferMTL::updateIndex()
 {
-    if (BufferUsage::DYNAMIC == _usage && !_indexUpdated)
+    if (BufferUsage::STATIC != _usage && !_indexUpdated)
     {
         _currentFrameIndex = (_currentFrameIndex + 1) % MAX_INFLIGHT_BUFFER;
         _mtlBuffer = _dynamicDataBuffers[_currentFrameIndex];
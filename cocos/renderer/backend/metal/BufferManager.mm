@@ -43,6 +43,8 @@ void BufferManager::removeBuffer(BufferMTL* buffer)
 
 void BufferManager::beginFrame()
 {
+    Buffer::resetStreamStats();
+
     for (auto& buffer : _buffers)
         buffer->beginFrame();
 }
@@ -98,8 +98,9 @@ public:
     /**
      * Set a global buffer for all vertex shaders at the given bind point index 0.
      * @param buffer The buffer to set in the buffer argument table.
+     * @param offset Byte offset of the first vertex in the buffer.
      */
-    virtual void setVertexBuffer(Buffer* buffer) override;
+    virtual void setVertexBuffer(Buffer* buffer, std::size_t offset = 0) override;
     
     /**
      * Set the uniform data at a given vertex and fragment buffer binding point 1
@@ -134,6 +135,27 @@ public:
      * @see `drawArrays(PrimitiveType primitiveType, unsigned int start,  unsigned int count)`
     */
     virtual void drawElements(PrimitiveType primitiveType, IndexFormat indexType, std::size_t count, std::size_t offset) override;
+
+    /**
+     * Set the per instance data of instanced draws, one model matrix (16 floats, column major) per instance.
+     * @param buffer A buffer object that the device will read the instance data from.
+     * @param offset Byte offset within buffer of the first instance.
+     * @see `drawElementsInstanced(PrimitiveType primitiveType, IndexFormat indexType, std::size_t count, std::size_t offset, std::size_t instanceCount)`
+     */
+    virtual void setInstanceBuffer(Buffer* buffer, std::size_t offset) override;
+
+    /**
+     * Draw several instances of primitives with an index list.
+     * The program reads the model matrix of each instance from the `a_instance` attribute.
+     * @note Only available when FeatureType::INSTANCED_DRAW is supported.
+     * @param primitiveType The type of primitives that elements are assembled into.
+     * @param indexType The type if indexes, either 16 bit integer or 32 bit integer.
+     * @param count The number of indexes to read from the index buffer for each instance.
+     * @param offset Byte offset within indexBuffer to start reading indexes from.
+     * @param instanceCount The number of instances to draw.
+     * @see `setInstanceBuffer(Buffer* buffer, std::size_t offset)`
+     */
+    virtual void drawElementsInstanced(PrimitiveType primitiveType, IndexFormat indexType, std::size_t count, std::size_t offset, std::size_t instanceCount) override;
     
     /**
      * Do some resources release.
@@ -297,11 +297,11 @@ void CommandBufferMTL::setWinding(Winding winding)
     [_mtlRenderEncoder setFrontFacingWinding:toMTLWinding(winding)];
 }
 
-void CommandBufferMTL::setVertexBuffer(Buffer* buffer)
+void CommandBufferMTL::setVertexBuffer(Buffer* buffer, std::size_t offset)
 {
     // Vertex buffer is bound in index 0.
     [_mtlRenderEncoder setVertexBuffer:static_cast<BufferMTL*>(buffer)->getMTLBuffer()
-                                offset:0
+                                offset:offset
                                atIndex:0];
 }
 
@@ -341,6 +341,16 @@ void CommandBufferMTL::drawElements(PrimitiveType primitiveType, IndexFormat ind
     
 }
 
+void CommandBufferMTL::setInstanceBuffer(Buffer* buffer, std::size_t offset)
+{
+}
+
+void CommandBufferMTL::drawElementsInstanced(PrimitiveType primitiveType, IndexFormat indexType, std::size_t count, std::size_t offset, std::size_t instanceCount)
+{
+    // Instanced drawing isn't supported by the metal backend, check FeatureType::INSTANCED_DRAW first.
+    assert(false);
+}
+
 void CommandBufferMTL::endRenderPass()
 {
     afterDraw();
@@ -442,6 +442,13 @@ bool DeviceInfoMTL::checkForFeatureSupported(FeatureType feature)
     case FeatureType::ASTC:
         featureSupported = supportASTC(_featureSet);
         break;
+    case FeatureType::ELEMENT_INDEX_UINT:
+        featureSupported = true;
+        break;
+    case FeatureType::INSTANCED_DRAW:
+        // per instance attributes are not mapped to the metal vertex descriptor yet
+        featureSupported = false;
+        break;
     default:
         break;
     }
@@ -23,6 +23,8 @@
  ****************************************************************************/
  
 #include "BufferGL.h"
+#include "BufferManagerGL.h"
+#include "StateCacheGL.h"
 #include <cassert>
 #include "base/ccMacros.h"
 #include "base/CCDirector.h"
@@ -40,10 +42,28 @@ namespace {
                 return GL_STATIC_DRAW;
             case BufferUsage::DYNAMIC:
                 return GL_DYNAMIC_DRAW;
+            case BufferUsage::STREAM:
+                return GL_STREAM_DRAW;
             default:
                 return GL_DYNAMIC_DRAW;
         }
     }
+
+    GLenum toGLTarget(const BufferType& type)
+    {
+        return BufferType::VERTEX == type ? GL_ARRAY_BUFFER : GL_ELEMENT_ARRAY_BUFFER;
+    }
+
+    bool isStreamFenceSupported()
+    {
+#ifdef CC_PLATFORM_PC
+        // sync objects and buffer mapping are OpenGL 3.x features. The GLES builds use the GLES2 headers,
+        // so they orphan the storage once per round of regions instead.
+        return glFenceSync != nullptr && glMapBufferRange != nullptr;
+#else
+        return false;
+#endif
+    }
 }
 
 BufferGL::BufferGL(std::size_t size, BufferType type, BufferUsage usage)
@@ -51,6 +71,13 @@ BufferGL::BufferGL(std::size_t size, BufferType type, BufferUsage usage)
 {
     glGenBuffers(1, &_buffer);
 
+    if (BufferUsage::STREAM == usage)
+    {
+        // keep the regions 4 bytes aligned
+        _streamRegionSize = (size + 3) & ~(std::size_t)3;
+        BufferManagerGL::addBuffer(this);
+    }
+
 #if CC_ENABLE_CACHE_TEXTURE_DATA
     _backToForegroundListener = EventListenerCustom::create(EVENT_RENDERER_RECREATED, [this](EventCustom*){
         this->reloadBuffer();
@@ -62,7 +89,19 @@ BufferGL::BufferGL(std::size_t size, BufferType type, BufferUsage usage)
 BufferGL::~BufferGL()
 {
     if (_buffer)
-        glDeleteBuffers(1, &_buffer);
+        StateCacheGL::deleteBuffer(_buffer);
+
+    if (BufferUsage::STREAM == _usage)
+    {
+#ifdef CC_PLATFORM_PC
+        for (auto& fence : _streamFences)
+        {
+            if (fence)
+                glDeleteSync(fence);
+        }
+#endif
+        BufferManagerGL::removeBuffer(this);
+    }
 
 #if CC_ENABLE_CACHE_TEXTURE_DATA
     CC_SAFE_DELETE_ARRAY(_data);
@@ -82,6 +121,18 @@ void BufferGL::reloadBuffer()
 {
     glGenBuffers(1, &_buffer);
 
+    if (BufferUsage::STREAM == _usage)
+    {
+        // the fences died with the context, the storage is allocated again by the next streamData()
+#ifdef CC_PLATFORM_PC
+        for (auto& fence : _streamFences)
+            fence = nullptr;
+#endif
+        _bufferAllocated = 0;
+        _streamWritten = false;
+        return;
+    }
+
     if(!_needDefaultStoredData)
         return;
 
@@ -112,12 +163,12 @@ void BufferGL::updateData(void* data, std::size_t size)
     {
         if (BufferType::VERTEX == _type)
         {
-            glBindBuffer(GL_ARRAY_BUFFER, _buffer);
+            StateCacheGL::bindBuffer(GL_ARRAY_BUFFER, _buffer);
             glBufferData(GL_ARRAY_BUFFER, size, data, toGLUsage(_usage));
         }
         else
         {
-            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _buffer);
+            StateCacheGL::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, _buffer);
             glBufferData(GL_ELEMENT_ARRAY_BUFFER, size, data, toGLUsage(_usage));
         }
         CHECK_GL_ERROR_DEBUG();
@@ -140,12 +191,12 @@ void BufferGL::updateSubData(void* data, std::size_t offset, std::size_t size)
         CHECK_GL_ERROR_DEBUG();
         if (BufferType::VERTEX == _type)
         {
-            glBindBuffer(GL_ARRAY_BUFFER, _buffer);
+            StateCacheGL::bindBuffer(GL_ARRAY_BUFFER, _buffer);
             glBufferSubData(GL_ARRAY_BUFFER, offset, size, data);
         }
         else
         {
-            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _buffer);
+            StateCacheGL::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, _buffer);
             glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, offset, size, data);
         }
 
@@ -156,4 +207,120 @@ void BufferGL::updateSubData(void* data, std::size_t offset, std::size_t size)
     }
 }
 
+std::size_t BufferGL::streamData(void* data, std::size_t size)
+{
+    CCASSERT(BufferUsage::STREAM == _usage, "streamData() needs a BufferUsage::STREAM buffer");
+    CCASSERT(size <= _size, "buffer size overflow");
+
+    if (!_buffer)
+        return 0;
+
+    if (_bufferAllocated == 0)
+        orphanStreamStorage();
+
+    std::size_t offset = (_streamOffset + 3) & ~(std::size_t)3;
+    if (offset + size > (_streamRegion + 1) * _streamRegionSize)
+    {
+        // More data than a region in this frame, continue in fresh storage instead of spilling into
+        // the region of a previous frame, which the GPU may still read from.
+        orphanStreamStorage();
+        ++_frameStreamStats.overflowOrphans;
+        offset = _streamOffset;
+    }
+
+    GLenum target = toGLTarget(_type);
+    StateCacheGL::bindBuffer(target, _buffer);
+#ifdef CC_PLATFORM_PC
+    void* dst = nullptr;
+    if (isStreamFenceSupported())
+    {
+        // The fences guarantee the GPU doesn't read the range anymore, don't let the driver check it.
+        dst = glMapBufferRange(target, offset, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+    }
+    if (dst)
+    {
+        memcpy(dst, data, size);
+        glUnmapBuffer(target);
+    }
+    else
+#endif
+    {
+        glBufferSubData(target, offset, size, data);
+    }
+    CHECK_GL_ERROR_DEBUG();
+
+    _streamOffset = offset + size;
+    _streamWritten = true;
+    _frameStreamStats.uploadedBytes += size;
+    return offset;
+}
+
+void BufferGL::orphanStreamStorage()
+{
+    // The draws in flight keep using the old storage, nothing reads the new one yet.
+    GLenum target = toGLTarget(_type);
+    StateCacheGL::bindBuffer(target, _buffer);
+    _bufferAllocated = _streamRegionSize * STREAM_FRAME_REGIONS;
+    glBufferData(target, _bufferAllocated, nullptr, GL_STREAM_DRAW);
+    CHECK_GL_ERROR_DEBUG();
+
+#ifdef CC_PLATFORM_PC
+    for (auto& fence : _streamFences)
+    {
+        if (fence)
+        {
+            glDeleteSync(fence);
+            fence = nullptr;
+        }
+    }
+#endif
+    _streamOffset = _streamRegion * _streamRegionSize;
+}
+
+void BufferGL::beginFrame()
+{
+    // not written yet
+    if (_bufferAllocated == 0)
+        return;
+
+    _streamRegion = (_streamRegion + 1) % STREAM_FRAME_REGIONS;
+    _streamOffset = _streamRegion * _streamRegionSize;
+
+#ifdef CC_PLATFORM_PC
+    if (isStreamFenceSupported())
+    {
+        auto& fence = _streamFences[_streamRegion];
+        if (fence == nullptr)
+            return;
+
+        GLenum status = glClientWaitSync(fence, 0, 0);
+        glDeleteSync(fence);
+        fence = nullptr;
+        if (GL_TIMEOUT_EXPIRED == status)
+        {
+            // The GPU is still reading the region, writing to it would wait.
+            orphanStreamStorage();
+            ++_frameStreamStats.stallsAvoided;
+        }
+        return;
+    }
+#endif
+
+    // Without fences there is no telling when the GPU is done with a region, get new storage once per round.
+    if (_streamRegion == 0)
+        orphanStreamStorage();
+}
+
+void BufferGL::endFrame()
+{
+    if (!_streamWritten)
+        return;
+
+    _streamWritten = false;
+#ifdef CC_PLATFORM_PC
+    if (isStreamFenceSupported())
+        _streamFences[_streamRegion] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+#endif
+}
+
 CC_BACKEND_END
@@ -38,14 +38,20 @@ CC_BACKEND_BEGIN
 
 /**
  * Store vertex and index data.
+ * A BufferUsage::STREAM buffer allocates STREAM_FRAME_REGIONS regions of its size, and writes each frame to the next
+ * region. A fence at the end of the frame tells when the GPU is done with the region, so it can be written without
+ * synchronization, and when the GPU is late the storage is orphaned instead of waiting.
  */
 class BufferGL : public Buffer
 {
 public:
+    /** The number of frames a stream buffer can hold. */
+    static const int STREAM_FRAME_REGIONS = 3;
+
     /**
      * @param size Specifies the size in bytes of the buffer object's new data store.
      * @param type Specifies the target buffer object. The symbolic constant must be BufferType::VERTEX or BufferType::INDEX.
-     * @param usage Specifies the expected usage pattern of the data store. The symbolic constant must be BufferUsage::STATIC, BufferUsage::DYNAMIC.
+     * @param usage Specifies the expected usage pattern of the data store. The symbolic constant must be BufferUsage::STATIC, BufferUsage::DYNAMIC or BufferUsage::STREAM.
      */
     BufferGL(std::size_t size, BufferType type, BufferUsage usage);
     ~BufferGL();
@@ -74,6 +80,24 @@ public:
      */
     virtual void usingDefaultStoredData(bool needDefaultStoredData) override ;
 
+    /**
+     * @brief Append data to the region of the current frame of a BufferUsage::STREAM buffer.
+     * @param data Specifies a pointer to the data that will be copied into the data store.
+     * @param size Specifies the size in bytes of the data, at most getSize().
+     * @return The offset in bytes of the data in the buffer.
+     */
+    virtual std::size_t streamData(void* data, std::size_t size) override;
+
+    /**
+     * Stream buffer only, switch to the region of the next frame.
+     */
+    void beginFrame();
+
+    /**
+     * Stream buffer only, fence the region of the frame if it was written.
+     */
+    void endFrame();
+
     /**
      * Get buffer object.
      * @return Buffer object.
@@ -81,6 +105,8 @@ public:
     inline GLuint getHandler() const { return _buffer; }
 
 private:
+    void orphanStreamStorage();
+
 #if CC_ENABLE_CACHE_TEXTURE_DATA
     void reloadBuffer();
     void fillBuffer(void* data, std::size_t offset, std::size_t size);
@@ -93,6 +119,14 @@ private:
     std::size_t _bufferAllocated = 0;
     char* _data = nullptr;
     bool _needDefaultStoredData = true;
+
+    std::size_t _streamRegionSize = 0;
+    std::size_t _streamOffset = 0;
+    int _streamRegion = 0;
+    bool _streamWritten = false;
+#ifdef CC_PLATFORM_PC
+    GLsync _streamFences[STREAM_FRAME_REGIONS] = {};
+#endif
 };
 //end of _opengl group
 ///> @}
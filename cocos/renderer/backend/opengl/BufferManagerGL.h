@@ -0,0 +1,73 @@
+/****************************************************************************
+Copyright (c) 2020 c4games.com.
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+#pragma once
+
+#include <vector>
+#include "../Macros.h"
+
+CC_BACKEND_BEGIN
+
+class BufferGL;
+
+/**
+ * @addtogroup _opengl
+ * @{
+ */
+
+/**
+ * @brief A static class to manage the BufferUsage::STREAM buffers.
+ * Moves them to the region of the next frame at the beginning of a frame, and fences the region of the frame at its end.
+ */
+class BufferManagerGL
+{
+public:
+    /**
+     * Add a stream buffer into container.
+     * @param buffer Specifies the buffer to be added.
+     */
+    static void addBuffer(BufferGL* buffer);
+
+    /**
+     * Remove a stream buffer from container.
+     * @param buffer Specifies the buffer to be removed.
+     */
+    static void removeBuffer(BufferGL* buffer);
+
+    /**
+     * Switch the stream buffers to the region of the new frame.
+     */
+    static void beginFrame();
+
+    /**
+     * Fence the regions written during the frame.
+     */
+    static void endFrame();
+
+private:
+    static std::vector<BufferGL*> _buffers;
+};
+
+// end of _opengl group
+/// @}
+CC_BACKEND_END
@@ -24,6 +24,8 @@
  
 #include "CommandBufferGL.h"
 #include "BufferGL.h"
+#include "BufferManagerGL.h"
+#include "StateCacheGL.h"
 #include "RenderPipelineGL.h"
 #include "TextureGL.h"
 #include "DepthStencilStateGL.h"
@@ -33,6 +35,7 @@
 #include "base/CCEventType.h"
 #include "base/CCDirector.h"
 #include "renderer/backend/opengl/UtilsGL.h"
+#include "xxhash.h"
 #include <algorithm>
 
 CC_BACKEND_BEGIN
@@ -69,6 +72,28 @@ namespace
             return ;
         }
     }
+
+    // Identifies the attribute setup of a layout, the attribute locations come from the program.
+    uint32_t hashVertexLayout(const VertexLayout* vertexLayout, uint32_t& attribMask)
+    {
+        uint32_t stride = (uint32_t)vertexLayout->getStride();
+        uint32_t hash = XXH32(&stride, sizeof(stride), 0);
+        attribMask = 0;
+        for (const auto& attributeInfo : vertexLayout->getAttributes())
+        {
+            const auto& attribute = attributeInfo.second;
+            uint32_t values[4] = {
+                (uint32_t)attribute.index,
+                (uint32_t)attribute.format,
+                (uint32_t)attribute.offset,
+                attribute.needToBeNormallized ? 1u : 0u
+            };
+            hash = XXH32(values, sizeof(values), hash);
+            if (attribute.index < 32)
+                attribMask |= 1u << attribute.index;
+        }
+        return hash;
+    }
 }
 
 CommandBufferGL::CommandBufferGL()
@@ -77,10 +102,12 @@ CommandBufferGL::CommandBufferGL()
 
 #if CC_ENABLE_CACHE_TEXTURE_DATA
     _backToForegroundListener = EventListenerCustom::create(EVENT_RENDERER_RECREATED, [this](EventCustom*){
+       StateCacheGL::reset();
        if(_generatedFBO)
            glGenFramebuffers(1, &_generatedFBO); //recreate framebuffer
     });
-    Director::getInstance()->getEventDispatcher()->addEventListenerWithFixedPriority(_backToForegroundListener, -1);
+    // before the buffers and programs reload themselves through the state cache
+    Director::getInstance()->getEventDispatcher()->addEventListenerWithFixedPriority(_backToForegroundListener, -2);
 #endif
 }
 
@@ -98,6 +125,12 @@ CommandBufferGL::~CommandBufferGL()
 
 void CommandBufferGL::beginFrame()
 {
+    _stateStats = StateCacheGL::getStats();
+    StateCacheGL::resetStats();
+    // Nothing else should touch the state, but don't let a mistake outlive the frame.
+    StateCacheGL::invalidate();
+
+    BufferManagerGL::beginFrame();
 }
 
 void CommandBufferGL::beginRenderPass(const RenderPassDescriptor& descirptor)
@@ -252,22 +285,14 @@ void CommandBufferGL::applyRenderPassDescriptor(const RenderPassDescriptor& desc
     
     CHECK_GL_ERROR_DEBUG();
     
-    GLboolean oldDepthWrite = GL_FALSE;
-    GLboolean oldDepthTest = GL_FALSE;
-    GLfloat oldDepthClearValue = 0.f;
-    GLint oldDepthFunc = GL_LESS;
+    // No need to restore the depth state afterwards, every draw sets the one it needs.
     if (descirptor.needClearDepth)
     {
-        glGetBooleanv(GL_DEPTH_WRITEMASK, &oldDepthWrite);
-        glGetBooleanv(GL_DEPTH_TEST, &oldDepthTest);
-        glGetFloatv(GL_DEPTH_CLEAR_VALUE, &oldDepthClearValue);
-        glGetIntegerv(GL_DEPTH_FUNC, &oldDepthFunc);
-        
         mask |= GL_DEPTH_BUFFER_BIT;
         glClearDepth(descirptor.clearDepthValue);
-        glEnable(GL_DEPTH_TEST);
-        glDepthMask(GL_TRUE);
-        glDepthFunc(GL_ALWAYS);
+        StateCacheGL::setCapability(GL_DEPTH_TEST, true);
+        StateCacheGL::depthMask(GL_TRUE);
+        StateCacheGL::depthFunc(GL_ALWAYS);
     }
     
     CHECK_GL_ERROR_DEBUG();
@@ -281,19 +306,6 @@ void CommandBufferGL::applyRenderPassDescriptor(const RenderPassDescriptor& desc
     if(mask) glClear(mask);
     
     CHECK_GL_ERROR_DEBUG();
-    
-    // restore depth test
-    if (descirptor.needClearDepth)
-    {
-        if (!oldDepthTest)
-            glDisable(GL_DEPTH_TEST);
-        
-        glDepthMask(oldDepthWrite);
-        glDepthFunc(oldDepthFunc);
-        glClearDepth(oldDepthClearValue);
-    }
-    
-    CHECK_GL_ERROR_DEBUG();
 }
 
 void CommandBufferGL::setRenderPipeline(RenderPipeline* renderPipeline)
@@ -324,7 +336,7 @@ void CommandBufferGL::setCullMode(CullMode mode)
 
 void CommandBufferGL::setWinding(Winding winding)
 {
-    glFrontFace(UtilsGL::toGLFrontFace(winding));
+    StateCacheGL::frontFace(UtilsGL::toGLFrontFace(winding));
 }
 
 void CommandBufferGL::setIndexBuffer(Buffer* buffer)
@@ -338,9 +350,22 @@ void CommandBufferGL::setIndexBuffer(Buffer* buffer)
     _indexBuffer = static_cast<BufferGL*>(buffer);
 }
 
-void CommandBufferGL::setVertexBuffer(Buffer* buffer)
+void CommandBufferGL::setInstanceBuffer(Buffer* buffer, std::size_t offset)
 {
     assert(buffer != nullptr);
+    if (buffer == nullptr)
+        return;
+
+    buffer->retain();
+    CC_SAFE_RELEASE(_instanceBuffer);
+    _instanceBuffer = static_cast<BufferGL*>(buffer);
+    _instanceBufferOffset = offset;
+}
+
+void CommandBufferGL::setVertexBuffer(Buffer* buffer, std::size_t offset)
+{
+    assert(buffer != nullptr);
+    _vertexBufferOffset = offset;
     if (buffer == nullptr || _vertexBuffer == buffer)
         return;
     
@@ -366,18 +391,40 @@ void CommandBufferGL::drawArrays(PrimitiveType primitiveType, std::size_t start,
 void CommandBufferGL::drawElements(PrimitiveType primitiveType, IndexFormat indexType, std::size_t count, std::size_t offset)
 {
     prepareDrawing();
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _indexBuffer->getHandler());
+    StateCacheGL::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, _indexBuffer->getHandler());
     glDrawElements(UtilsGL::toGLPrimitiveType(primitiveType), count, UtilsGL::toGLIndexType(indexType), (GLvoid*)offset);
     CHECK_GL_ERROR_DEBUG();
     cleanResources();
 }
 
+void CommandBufferGL::drawElementsInstanced(PrimitiveType primitiveType, IndexFormat indexType, std::size_t count, std::size_t offset, std::size_t instanceCount)
+{
+#ifdef CC_PLATFORM_PC
+    prepareDrawing();
+    const auto& program = _renderPipeline->getProgram();
+    bindInstanceBuffer(program);
+    StateCacheGL::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, _indexBuffer->getHandler());
+    glDrawElementsInstanced(UtilsGL::toGLPrimitiveType(primitiveType), count, UtilsGL::toGLIndexType(indexType), (GLvoid*)offset, instanceCount);
+    CHECK_GL_ERROR_DEBUG();
+    unbindInstanceBuffer(program);
+#else
+    CCASSERT(false, "Instanced drawing isn't supported, check FeatureType::INSTANCED_DRAW first.");
+#endif
+    cleanResources();
+}
+
 void CommandBufferGL::endRenderPass()
 {
 }
 
 void CommandBufferGL::endFrame()
 {
+    BufferManagerGL::endFrame();
+}
+
+void CommandBufferGL::invalidateState()
+{
+    StateCacheGL::invalidate();
 }
 
 void CommandBufferGL::setDepthStencilState(DepthStencilState* depthStencilState)	
@@ -395,7 +442,7 @@ void CommandBufferGL::setDepthStencilState(DepthStencilState* depthStencilState)
 void CommandBufferGL::prepareDrawing() const
 {   
     const auto& program = _renderPipeline->getProgram();
-    glUseProgram(program->getHandler());
+    StateCacheGL::useProgram(program->getHandler());
     
     bindVertexBuffer(program);
     setUniforms(program);
@@ -412,12 +459,12 @@ void CommandBufferGL::prepareDrawing() const
     // Set cull mode.
     if (CullMode::NONE == _cullMode)
     {
-        glDisable(GL_CULL_FACE);
+        StateCacheGL::setCapability(GL_CULL_FACE, false);
     }
     else
     {
-        glEnable(GL_CULL_FACE);
-        glCullFace(UtilsGL::toGLCullMode(_cullMode));
+        StateCacheGL::setCapability(GL_CULL_FACE, true);
+        StateCacheGL::cullFace(UtilsGL::toGLCullMode(_cullMode));
     }
 }
 
@@ -429,20 +476,68 @@ void CommandBufferGL::bindVertexBuffer(ProgramGL *program) const
     if (!vertexLayout->isValid())
         return;
     
-    glBindBuffer(GL_ARRAY_BUFFER, _vertexBuffer->getHandler());
-
     const auto& attributes = vertexLayout->getAttributes();
+    uint32_t attribMask = 0;
+    uint32_t layoutHash = hashVertexLayout(vertexLayout.get(), attribMask);
+    if (StateCacheGL::bindVertexArray(_vertexBuffer->getHandler(), layoutHash, _vertexBufferOffset))
+    {
+        // the buffer binding, and enabling and pointing every attribute
+        StateCacheGL::addSkippedCalls(1 + 2 * (unsigned int)attributes.size());
+        return;
+    }
+
+    StateCacheGL::bindBuffer(GL_ARRAY_BUFFER, _vertexBuffer->getHandler());
+    StateCacheGL::setVertexAttribArrays(attribMask);
+    StateCacheGL::addIssuedCalls((unsigned int)attributes.size());
     for (const auto& attributeInfo : attributes)
     {
         const auto& attribute = attributeInfo.second;
-        glEnableVertexAttribArray(attribute.index);
+        if (attribute.index >= 32)
+            StateCacheGL::enableVertexAttribArray(attribute.index);
         glVertexAttribPointer(attribute.index,
             UtilsGL::getGLAttributeSize(attribute.format),
             UtilsGL::toGLAttributeType(attribute.format),
             attribute.needToBeNormallized,
             vertexLayout->getStride(),
-            (GLvoid*)attribute.offset);
+            (GLvoid*)(_vertexBufferOffset + attribute.offset));
+    }
+}
+
+void CommandBufferGL::bindInstanceBuffer(ProgramGL* program) const
+{
+#ifdef CC_PLATFORM_PC
+    auto location = program->getAttributeLocation(Attribute::INSTANCE);
+    if (location < 0 || _instanceBuffer == nullptr)
+        return;
+
+    // A mat4 attribute takes 4 consecutive locations, one per column.
+    StateCacheGL::bindBuffer(GL_ARRAY_BUFFER, _instanceBuffer->getHandler());
+    for (int i = 0; i < 4; ++i)
+    {
+        StateCacheGL::enableVertexAttribArray(location + i);
+        glVertexAttribPointer(location + i, 4, GL_FLOAT, GL_FALSE, sizeof(float) * 16,
+            (GLvoid*)(_instanceBufferOffset + sizeof(float) * 4 * i));
+        glVertexAttribDivisor(location + i, 1);
     }
+    StateCacheGL::addIssuedCalls(8);
+#endif
+}
+
+void CommandBufferGL::unbindInstanceBuffer(ProgramGL* program) const
+{
+#ifdef CC_PLATFORM_PC
+    auto location = program->getAttributeLocation(Attribute::INSTANCE);
+    if (location < 0)
+        return;
+
+    // The locations may be used by per vertex attributes of the next program.
+    for (int i = 0; i < 4; ++i)
+    {
+        glVertexAttribDivisor(location + i, 0);
+        StateCacheGL::disableVertexAttribArray(location + i);
+    }
+    StateCacheGL::addIssuedCalls(4);
+#endif
 }
 
 void CommandBufferGL::setUniforms(ProgramGL* program) const
@@ -468,11 +563,19 @@ void CommandBufferGL::setUniforms(ProgramGL* program) const
                 continue;
 
             int elementCount = uniformInfo.count;
+            void* data = buffer + uniformInfo.bufferOffset;
+            if (!program->updateUniformCache(uniformInfo.location, data, uniformInfo.size * elementCount))
+            {
+                StateCacheGL::addSkippedCalls(1);
+                continue;
+            }
+
+            StateCacheGL::addIssuedCalls(1);
             setUniform(uniformInfo.isArray,
                 uniformInfo.location,
                 elementCount,
                 uniformInfo.type,
-                (void*)(buffer + uniformInfo.bufferOffset));
+                data);
         }
         
         const auto& textureInfo = _programState->getVertexTextureInfos();
@@ -491,6 +594,13 @@ void CommandBufferGL::setUniforms(ProgramGL* program) const
             }
             
             auto arrayCount = slot.size();
+            if (!program->updateUniformCache(location, slot.data(), arrayCount * sizeof(slot[0])))
+            {
+                StateCacheGL::addSkippedCalls(1);
+                continue;
+            }
+
+            StateCacheGL::addIssuedCalls(1);
             if (arrayCount > 1)
                 glUniform1iv(location, (uint32_t)arrayCount, (GLint*)slot.data());
             else
@@ -594,6 +704,7 @@ void CommandBufferGL::setUniform(bool isArray, GLuint location, unsigned int siz
 void CommandBufferGL::cleanResources()
 {
     CC_SAFE_RELEASE_NULL(_indexBuffer);
+    CC_SAFE_RELEASE_NULL(_instanceBuffer);
     CC_SAFE_RELEASE_NULL(_programState);  
     CC_SAFE_RELEASE_NULL(_vertexBuffer);
 }
@@ -601,9 +712,9 @@ void CommandBufferGL::cleanResources()
 void CommandBufferGL::setLineWidth(float lineWidth)
 {
     if(lineWidth > 0.0f)
-        glLineWidth(lineWidth);
+        StateCacheGL::lineWidth(lineWidth);
     else
-        glLineWidth(1.0f);
+        StateCacheGL::lineWidth(1.0f);
     
 }
 
@@ -612,12 +723,12 @@ void CommandBufferGL::setScissorRect(bool isEnabled, float x, float y, float wid
 {
     if(isEnabled)
     {
-        glEnable(GL_SCISSOR_TEST);
-        glScissor(x, y, width, height);
+        StateCacheGL::setCapability(GL_SCISSOR_TEST, true);
+        StateCacheGL::scissor(x, y, width, height);
     }
     else
     {
-        glDisable(GL_SCISSOR_TEST);
+        StateCacheGL::setCapability(GL_SCISSOR_TEST, false);
     }
 }
 
@@ -97,8 +97,9 @@ public:
     /**
      * Set a global buffer for all vertex shaders at the given bind point index 0.
      * @param buffer The vertex buffer to be setted in the buffer argument table.
+     * @param offset Byte offset of the first vertex in the buffer.
      */
-    virtual void setVertexBuffer(Buffer* buffer) override;
+    virtual void setVertexBuffer(Buffer* buffer, std::size_t offset = 0) override;
 
     /**
      * Set unifroms and textures
@@ -132,6 +133,27 @@ public:
      * @see `drawArrays(PrimitiveType primitiveType, unsigned int start,  unsigned int count)`
     */
     virtual void drawElements(PrimitiveType primitiveType, IndexFormat indexType, std::size_t count, std::size_t offset) override;
+
+    /**
+     * Set the per instance data of instanced draws, one model matrix (16 floats, column major) per instance.
+     * @param buffer A buffer object that the device will read the instance data from.
+     * @param offset Byte offset within buffer of the first instance.
+     * @see `drawElementsInstanced(PrimitiveType primitiveType, IndexFormat indexType, std::size_t count, std::size_t offset, std::size_t instanceCount)`
+     */
+    virtual void setInstanceBuffer(Buffer* buffer, std::size_t offset) override;
+
+    /**
+     * Draw several instances of primitives with an index list.
+     * The program reads the model matrix of each instance from the `a_instance` attribute.
+     * @note Only available when FeatureType::INSTANCED_DRAW is supported.
+     * @param primitiveType The type of primitives that elements are assembled into.
+     * @param indexType The type if indexes, either 16 bit integer or 32 bit integer.
+     * @param count The number of indexes to read from the index buffer for each instance.
+     * @param offset Byte offset within indexBuffer to start reading indexes from.
+     * @param instanceCount The number of instances to draw.
+     * @see `setInstanceBuffer(Buffer* buffer, std::size_t offset)`
+     */
+    virtual void drawElementsInstanced(PrimitiveType primitiveType, IndexFormat indexType, std::size_t count, std::size_t offset, std::size_t instanceCount) override;
     
     /**
      * Do some resources release.
@@ -142,6 +164,11 @@ public:
      * Present a drawable and commit a command buffer so it can be executed as soon as possible.
      */
     virtual void endFrame() override;
+
+    /**
+     * Forget the state shadowed by StateCacheGL, after OpenGL was called directly.
+     */
+    virtual void invalidateState() override;
     
     /**
      * Fixed-function state
@@ -180,6 +207,8 @@ private:
     
     void prepareDrawing() const;
     void bindVertexBuffer(ProgramGL* program) const;
+    void bindInstanceBuffer(ProgramGL* program) const;
+    void unbindInstanceBuffer(ProgramGL* program) const;
     void setUniforms(ProgramGL* program) const;
     void setUniform(bool isArray, GLuint location, unsigned int size, GLenum uniformType, void* data) const;
     void cleanResources();
@@ -197,8 +226,11 @@ private:
     GLint _defaultFBO = 0;  // The value gets from glGetIntegerv, so need to use GLint
     GLuint _currentFBO = 0;
     BufferGL* _vertexBuffer = nullptr;
+    std::size_t _vertexBufferOffset = 0;
     ProgramState* _programState = nullptr;
     BufferGL* _indexBuffer = nullptr;
+    BufferGL* _instanceBuffer = nullptr;
+    std::size_t _instanceBufferOffset = 0;
     RenderPipelineGL* _renderPipeline = nullptr;
     CullMode _cullMode = CullMode::NONE;
     DepthStencilStateGL* _depthStencilStateGL = nullptr;
@@ -27,13 +27,14 @@
 
 #include "base/ccMacros.h"
 #include "renderer/backend/opengl/UtilsGL.h"
+#include "renderer/backend/opengl/StateCacheGL.h"
 
 CC_BACKEND_BEGIN
 
 void DepthStencilStateGL::reset()
 {
-    glDisable(GL_DEPTH_TEST);
-    glDisable(GL_STENCIL_TEST);
+    StateCacheGL::setCapability(GL_DEPTH_TEST, false);
+    StateCacheGL::setCapability(GL_STENCIL_TEST, false);
 }
 
 DepthStencilStateGL::DepthStencilStateGL(const DepthStencilDescriptor& descriptor)
@@ -44,26 +45,16 @@ void DepthStencilStateGL::apply(unsigned int stencilReferenceValueFront, unsigne
 {
     // depth test
     
-    if (_depthStencilInfo.depthTestEnabled)
-    {
-        glEnable(GL_DEPTH_TEST); 
-    }
-    else
-    {
-        glDisable(GL_DEPTH_TEST);
-    }
+    StateCacheGL::setCapability(GL_DEPTH_TEST, _depthStencilInfo.depthTestEnabled);
     
     if (_depthStencilInfo.depthWriteEnabled)
-        glDepthMask(GL_TRUE);
+        StateCacheGL::depthMask(GL_TRUE);
     else
-        glDepthMask(GL_FALSE);
+        StateCacheGL::depthMask(GL_FALSE);
     
-    glDepthFunc(UtilsGL::toGLComareFunction(_depthStencilInfo.depthCompareFunction));
+    StateCacheGL::depthFunc(UtilsGL::toGLComareFunction(_depthStencilInfo.depthCompareFunction));
     
-    if (_depthStencilInfo.stencilTestEnabled)
-        glEnable(GL_STENCIL_TEST);
-    else
-        glDisable(GL_STENCIL_TEST);
+    StateCacheGL::setCapability(GL_STENCIL_TEST, _depthStencilInfo.stencilTestEnabled);
 
     // stencil test
     if (_depthStencilInfo.stencilTestEnabled)
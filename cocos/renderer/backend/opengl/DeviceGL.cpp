@@ -31,6 +31,7 @@
 #include "DepthStencilStateGL.h"
 #include "ProgramGL.h"
 #include "DeviceInfoGL.h"
+#include "StateCacheGL.h"
 
 CC_BACKEND_BEGIN
 
@@ -50,6 +51,8 @@ DeviceGL::DeviceGL()
         delete _deviceInfo;
         _deviceInfo = nullptr;
     }
+
+    StateCacheGL::init(_deviceInfo && _deviceInfo->checkForFeatureSupported(FeatureType::VAO));
 }
 
 DeviceGL::~DeviceGL()
@@ -101,6 +101,34 @@ bool DeviceInfoGL::checkForFeatureSupported(FeatureType feature)
     case FeatureType::ASTC:
         featureSupported = checkForGLExtension("GL_OES_texture_compression_astc");
         break;
+    case FeatureType::ELEMENT_INDEX_UINT:
+#ifdef CC_PLATFORM_PC
+        featureSupported = true;
+#else
+        featureSupported = checkForGLExtension("GL_OES_element_index_uint");
+#endif
+        break;
+    case FeatureType::INSTANCED_DRAW:
+#ifdef CC_PLATFORM_PC
+        // OpenGL 3.3 or ARB_instanced_arrays, the entry points are loaded at runtime
+        featureSupported = glDrawElementsInstanced != nullptr && glVertexAttribDivisor != nullptr;
+#endif
+        break;
+    case FeatureType::PROGRAM_BINARY:
+    {
+#ifdef CC_PLATFORM_PC
+        // OpenGL 4.1 or ARB_get_program_binary
+        featureSupported = glGetProgramBinary != nullptr && glProgramBinary != nullptr;
+#else
+        featureSupported = checkForGLExtension("GL_OES_get_program_binary") && glGetProgramBinary != nullptr && glProgramBinary != nullptr;
+#endif
+        // a driver may support the entry points without any binary format
+        GLint formats = 0;
+        if (featureSupported)
+            glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+        featureSupported = formats > 0;
+        break;
+    }
     default:
         break;
     }
@@ -0,0 +1,193 @@
+/****************************************************************************
+Copyright (c) 2020 c4games.com.
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+ 
+#include "ProgramBinaryCacheGL.h"
+#include "../Device.h"
+#include "base/ccMacros.h"
+#include "base/CCData.h"
+#include "base/ccUTF8.h"
+#include "platform/CCFileUtils.h"
+#include "xxhash.h"
+
+CC_BACKEND_BEGIN
+
+namespace {
+    // Bump when the file layout changes.
+    const uint32_t BINARY_CACHE_VERSION = 1;
+    const uint32_t BINARY_MAGIC = 0x42504343; // "CCPB"
+
+    struct BinaryHeader
+    {
+        uint32_t magic;
+        uint32_t format;
+        uint32_t vertexHash;
+        uint32_t fragmentHash;
+        uint32_t vertexLength;
+        uint32_t fragmentLength;
+        uint32_t binaryLength;
+    };
+
+    const char* getGLString(GLenum name)
+    {
+        auto str = reinterpret_cast<const char*>(glGetString(name));
+        return str ? str : "";
+    }
+}
+
+int ProgramBinaryCacheGL::_state = 0;
+std::string ProgramBinaryCacheGL::_directory;
+
+bool ProgramBinaryCacheGL::isAvailable()
+{
+#if CC_ENABLE_PROGRAM_BINARY_CACHE
+    if (_state == 0)
+    {
+        _state = -1;
+        auto deviceInfo = Device::getInstance()->getDeviceInfo();
+        if (deviceInfo == nullptr || !deviceInfo->checkForFeatureSupported(FeatureType::PROGRAM_BINARY))
+            return false;
+
+        // A binary only works with the driver which created it, drop all of them when it changes.
+        auto fileUtils = FileUtils::getInstance();
+        _directory = fileUtils->getWritablePath() + "program_binaries/";
+        std::string driver = StringUtils::format("%u\n%s\n%s\n%s", BINARY_CACHE_VERSION,
+                                                 getGLString(GL_VENDOR), getGLString(GL_RENDERER), getGLString(GL_VERSION));
+        std::string driverFile = _directory + "driver.txt";
+        if (!fileUtils->isFileExist(driverFile) || fileUtils->getStringFromFile(driverFile) != driver)
+        {
+            if (fileUtils->isDirectoryExist(_directory))
+                fileUtils->removeDirectory(_directory);
+            if (!fileUtils->createDirectory(_directory) || !fileUtils->writeStringToFile(driver, driverFile))
+            {
+                CCLOG("cocos2d: ProgramBinaryCacheGL: can't write to %s, the program binaries aren't cached", _directory.c_str());
+                return false;
+            }
+        }
+        _state = 1;
+    }
+    return _state > 0;
+#else
+    return false;
+#endif
+}
+
+std::string ProgramBinaryCacheGL::getBinaryPath(uint32_t vertexHash, uint32_t fragmentHash)
+{
+    return _directory + StringUtils::format("%08x%08x.bin", vertexHash, fragmentHash);
+}
+
+GLuint ProgramBinaryCacheGL::loadProgram(const std::string& vertexShader, const std::string& fragmentShader)
+{
+    if (!isAvailable())
+        return 0;
+
+    uint32_t vertexHash = XXH32(vertexShader.data(), vertexShader.size(), 0);
+    uint32_t fragmentHash = XXH32(fragmentShader.data(), fragmentShader.size(), 0);
+    auto path = getBinaryPath(vertexHash, fragmentHash);
+    auto fileUtils = FileUtils::getInstance();
+    if (!fileUtils->isFileExist(path))
+        return 0;
+
+    Data data = fileUtils->getDataFromFile(path);
+    BinaryHeader header;
+    if (data.getSize() < (ssize_t)sizeof(header))
+        return 0;
+    memcpy(&header, data.getBytes(), sizeof(header));
+
+    // the lengths make a hash collision of two shaders harmless
+    if (header.magic != BINARY_MAGIC
+        || header.vertexHash != vertexHash || header.fragmentHash != fragmentHash
+        || header.vertexLength != vertexShader.size() || header.fragmentLength != fragmentShader.size()
+        || header.binaryLength != data.getSize() - sizeof(header))
+    {
+        fileUtils->removeFile(path);
+        return 0;
+    }
+
+    GLuint program = glCreateProgram();
+    if (!program)
+        return 0;
+
+    glProgramBinary(program, header.format, data.getBytes() + sizeof(header), header.binaryLength);
+    GLint status = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &status);
+    if (GL_FALSE == status)
+    {
+        // The driver may reject binaries at any time, i.e. after an update which kept the version string.
+        glDeleteProgram(program);
+        fileUtils->removeFile(path);
+        return 0;
+    }
+    return program;
+}
+
+void ProgramBinaryCacheGL::prepareProgram(GLuint program)
+{
+#ifdef CC_PLATFORM_PC
+    // Without the hint a driver may not keep the binary of a linked program. GLES2 with OES_get_program_binary has no hint.
+    if (program && isAvailable() && glProgramParameteri != nullptr)
+        glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+#endif
+}
+
+void ProgramBinaryCacheGL::saveProgram(GLuint program, const std::string& vertexShader, const std::string& fragmentShader)
+{
+    if (!program || !isAvailable())
+        return;
+
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+        return;
+
+    BinaryHeader header;
+    header.magic = BINARY_MAGIC;
+    header.vertexHash = XXH32(vertexShader.data(), vertexShader.size(), 0);
+    header.fragmentHash = XXH32(fragmentShader.data(), fragmentShader.size(), 0);
+    header.vertexLength = (uint32_t)vertexShader.size();
+    header.fragmentLength = (uint32_t)fragmentShader.size();
+
+    auto bytes = (unsigned char*)malloc(sizeof(header) + length);
+    if (bytes == nullptr)
+        return;
+
+    GLsizei written = 0;
+    GLenum format = 0;
+    glGetProgramBinary(program, length, &written, &format, bytes + sizeof(header));
+    if (written <= 0)
+    {
+        free(bytes);
+        return;
+    }
+    header.format = format;
+    header.binaryLength = written;
+    memcpy(bytes, &header, sizeof(header));
+
+    Data data;
+    data.fastSet(bytes, sizeof(header) + written);
+    // don't keep the startup waiting for the disk
+    FileUtils::getInstance()->writeDataToFile(std::move(data), getBinaryPath(header.vertexHash, header.fragmentHash), [](bool) {});
+}
+
+CC_BACKEND_END
@@ -0,0 +1,80 @@
+/****************************************************************************
+Copyright (c) 2020 c4games.com.
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+ 
+#pragma once
+
+#include "../Macros.h"
+#include "platform/CCGL.h"
+
+#include <string>
+
+CC_BACKEND_BEGIN
+
+/**
+ * @addtogroup _opengl
+ * @{
+ */
+
+/**
+ * @brief A static class which keeps the binaries of linked programs in the writable path.
+ * A binary is found by the hashes of the shader sources, all binaries are dropped when the driver changes.
+ * @see CC_ENABLE_PROGRAM_BINARY_CACHE
+ */
+class ProgramBinaryCacheGL
+{
+public:
+    /**
+     * Create a program from the cached binary of the shader sources.
+     * @param vertexShader The vertex shader source.
+     * @param fragmentShader The fragment shader source.
+     * @return The linked program, or 0 if there is no usable binary.
+     */
+    static GLuint loadProgram(const std::string& vertexShader, const std::string& fragmentShader);
+
+    /**
+     * Ask the driver to keep the binary of a program, call it before glLinkProgram().
+     * @param program The program to link.
+     */
+    static void prepareProgram(GLuint program);
+
+    /**
+     * Store the binary of a program linked from the shader sources.
+     * @param program The linked program.
+     * @param vertexShader The vertex shader source.
+     * @param fragmentShader The fragment shader source.
+     */
+    static void saveProgram(GLuint program, const std::string& vertexShader, const std::string& fragmentShader);
+
+private:
+    static bool isAvailable();
+    static std::string getBinaryPath(uint32_t vertexHash, uint32_t fragmentHash);
+
+    // 0 not checked yet, 1 available, -1 unavailable
+    static int _state;
+    static std::string _directory;
+};
+
+// end of _opengl group
+/// @}
+CC_BACKEND_END
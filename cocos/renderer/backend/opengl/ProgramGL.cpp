@@ -31,28 +31,44 @@
 #include "base/CCEventDispatcher.h"
 #include "base/CCEventType.h"
 #include "renderer/backend/opengl/UtilsGL.h"
+#include "renderer/backend/opengl/StateCacheGL.h"
+#include "renderer/backend/opengl/ProgramBinaryCacheGL.h"
 
 CC_BACKEND_BEGIN
 
 namespace {
     static const std::string SHADER_PREDEFINE = "#version 100\n precision highp float;\n precision highp int;\n";
+
+    std::string getShaderSource(const std::string& source)
+    {
+#if CC_TARGET_PLATFORM == CC_PLATFORM_ANDROID || CC_USE_GLES_ON_DESKTOP
+        // some device required manually specify the precision qualifiers for vertex shader.
+        return SHADER_PREDEFINE + source;
+#else
+        return source;
+#endif
+    }
 }
 
 ProgramGL::ProgramGL(const std::string& vertexShader, const std::string& fragmentShader)
 : Program(vertexShader, fragmentShader)
 {
-#if CC_TARGET_PLATFORM == CC_PLATFORM_ANDROID || CC_USE_GLES_ON_DESKTOP
-    // some device required manually specify the precision qualifiers for vertex shader.
-    _vertexShaderModule = static_cast<ShaderModuleGL*>(ShaderCache::newVertexShaderModule(SHADER_PREDEFINE + _vertexShader));
-    _fragmentShaderModule = static_cast<ShaderModuleGL*>(ShaderCache::newFragmentShaderModule(SHADER_PREDEFINE + _fragmentShader));
-#else
-    _vertexShaderModule = static_cast<ShaderModuleGL*>(ShaderCache::newVertexShaderModule(_vertexShader));
-    _fragmentShaderModule = static_cast<ShaderModuleGL*>(ShaderCache::newFragmentShaderModule(_fragmentShader));
-#endif
+    auto vertexSource = getShaderSource(_vertexShader);
+    auto fragmentSource = getShaderSource(_fragmentShader);
+
+    // the shader modules are only needed to link the program from source
+    _program = ProgramBinaryCacheGL::loadProgram(vertexSource, fragmentSource);
+    _loadedFromBinaryCache = _program != 0;
+    if (!_loadedFromBinaryCache)
+    {
+        _vertexShaderModule = static_cast<ShaderModuleGL*>(ShaderCache::newVertexShaderModule(vertexSource));
+        _fragmentShaderModule = static_cast<ShaderModuleGL*>(ShaderCache::newFragmentShaderModule(fragmentSource));
 
-    CC_SAFE_RETAIN(_vertexShaderModule);
-    CC_SAFE_RETAIN(_fragmentShaderModule);
-    compileProgram();
+        CC_SAFE_RETAIN(_vertexShaderModule);
+        CC_SAFE_RETAIN(_fragmentShaderModule);
+        compileProgram();
+        ProgramBinaryCacheGL::saveProgram(_program, vertexSource, fragmentSource);
+    }
     computeUniformInfos();
     computeLocations();
 #if CC_ENABLE_CACHE_TEXTURE_DATA
@@ -76,7 +92,7 @@ ProgramGL::~ProgramGL()
     CC_SAFE_RELEASE(_vertexShaderModule);
     CC_SAFE_RELEASE(_fragmentShaderModule);
     if (_program)
-        glDeleteProgram(_program);
+        StateCacheGL::deleteProgram(_program);
 
 #if CC_ENABLE_CACHE_TEXTURE_DATA
     Director::getInstance()->getEventDispatcher()->removeEventListener(_backToForegroundListener);
@@ -87,11 +103,31 @@ ProgramGL::~ProgramGL()
 void ProgramGL::reloadProgram()
 {
     _activeUniformInfos.clear();
+    _uploadedUniforms.clear();
     _mapToCurrentActiveLocation.clear();
     _mapToOriginalLocation.clear();
-    static_cast<ShaderModuleGL*>(_vertexShaderModule)->compileShader(backend::ShaderStage::VERTEX, SHADER_PREDEFINE + _vertexShader);
-    static_cast<ShaderModuleGL*>(_fragmentShaderModule)->compileShader(backend::ShaderStage::FRAGMENT, SHADER_PREDEFINE + _fragmentShader);
-    compileProgram();
+    auto vertexSource = getShaderSource(_vertexShader);
+    auto fragmentSource = getShaderSource(_fragmentShader);
+    _program = ProgramBinaryCacheGL::loadProgram(vertexSource, fragmentSource);
+    _loadedFromBinaryCache = _program != 0;
+    if (!_loadedFromBinaryCache)
+    {
+        if (_vertexShaderModule && _fragmentShaderModule)
+        {
+            _vertexShaderModule->compileShader(backend::ShaderStage::VERTEX, vertexSource);
+            _fragmentShaderModule->compileShader(backend::ShaderStage::FRAGMENT, fragmentSource);
+        }
+        else
+        {
+            // Loaded from a binary last time. Modules of the ShaderCache may not be compiled for the new context yet, use own ones.
+            CC_SAFE_RELEASE_NULL(_vertexShaderModule);
+            CC_SAFE_RELEASE_NULL(_fragmentShaderModule);
+            _vertexShaderModule = new (std::nothrow) ShaderModuleGL(ShaderStage::VERTEX, vertexSource);
+            _fragmentShaderModule = new (std::nothrow) ShaderModuleGL(ShaderStage::FRAGMENT, fragmentSource);
+        }
+        compileProgram();
+        ProgramBinaryCacheGL::saveProgram(_program, vertexSource, fragmentSource);
+    }
     computeUniformInfos();
 
     for(const auto& uniform : _activeUniformInfos)
@@ -122,6 +158,7 @@ void ProgramGL::compileProgram()
     glAttachShader(_program, vertShader);
     glAttachShader(_program, fragShader);
 
+    ProgramBinaryCacheGL::prepareProgram(_program);
     glLinkProgram(_program);
 
     GLint status = 0;
@@ -159,6 +196,10 @@ void ProgramGL::computeLocations()
     location = glGetAttribLocation(_program, ATTRIBUTE_NAME_TEXCOORD);
     _builtinAttributeLocation[Attribute::TEXCOORD] = location;
 
+    ///a_instance
+    location = glGetAttribLocation(_program, ATTRIBUTE_NAME_INSTANCE);
+    _builtinAttributeLocation[Attribute::INSTANCE] = location;
+
     ///u_MVPMatrix
     location = glGetUniformLocation(_program, UNIFORM_NAME_MVP_MATRIX);
     _builtinUniformLocation[Uniform::MVP_MATRIX].location[0] = location;
@@ -350,6 +391,16 @@ const std::unordered_map<std::string, UniformInfo>& ProgramGL::getAllActiveUnifo
     return _activeUniformInfos;
 }
 
+bool ProgramGL::updateUniformCache(int location, const void* data, std::size_t size)
+{
+    auto& uploaded = _uploadedUniforms[location];
+    if (uploaded.size() == size && memcmp(uploaded.data(), data, size) == 0)
+        return false;
+
+    uploaded.assign(static_cast<const char*>(data), static_cast<const char*>(data) + size);
+    return true;
+}
+
 std::size_t ProgramGL::getUniformBufferSize(ShaderStage stage) const
 {
     return _totalBufferSize;
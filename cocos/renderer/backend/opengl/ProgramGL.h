@@ -157,6 +157,15 @@ public:
      */
     virtual const std::unordered_map<std::string, UniformInfo>& getAllActiveUniformInfo(ShaderStage stage) const override ;
 
+    /**
+     * Compare a uniform value with a copy of the value uploaded last, and remember it.
+     * @param location The uniform location.
+     * @param data The uniform value.
+     * @param size The size of the value in bytes.
+     * @return true if the value differs and has to be uploaded.
+     */
+    bool updateUniformCache(int location, const void* data, std::size_t size);
+
 private:
     void compileProgram();
     bool getAttributeLocation(const std::string& attributeName, unsigned int& location) const;
@@ -187,6 +196,7 @@ private:
     UniformLocation _builtinUniformLocation[UNIFORM_MAX];
     int _builtinAttributeLocation[Attribute::ATTRIBUTE_MAX];
     std::unordered_map<int, int> _bufferOffset;
+    std::unordered_map<int, std::vector<char>> _uploadedUniforms; ///< copies of the uploaded uniform values by location
 };
 //end of _opengl group
 /// @}
@@ -0,0 +1,394 @@
+/****************************************************************************
+Copyright (c) 2020 c4games.com.
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+ 
+#include "StateCacheGL.h"
+#include <algorithm>
+
+CC_BACKEND_BEGIN
+
+namespace {
+    // Marks a cached value as unknown, no OpenGL name or enum has it.
+    const GLuint UNKNOWN = 0xffffffff;
+
+    uint32_t toCapabilityBit(GLenum capability)
+    {
+        switch (capability)
+        {
+            case GL_BLEND:
+                return 1 << 0;
+            case GL_DEPTH_TEST:
+                return 1 << 1;
+            case GL_STENCIL_TEST:
+                return 1 << 2;
+            case GL_CULL_FACE:
+                return 1 << 3;
+            case GL_SCISSOR_TEST:
+                return 1 << 4;
+            default:
+                return 0;
+        }
+    }
+}
+
+bool StateCacheGL::_useVertexArrays = false;
+StateStats StateCacheGL::_stats;
+
+GLuint StateCacheGL::_program = UNKNOWN;
+GLuint StateCacheGL::_arrayBuffer = UNKNOWN;
+uint32_t StateCacheGL::_capabilities = 0;
+uint32_t StateCacheGL::_knownCapabilities = 0;
+GLuint StateCacheGL::_blendEquation[2] = {UNKNOWN, UNKNOWN};
+GLuint StateCacheGL::_blendFunc[4] = {UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN};
+GLuint StateCacheGL::_colorMask = UNKNOWN;
+GLuint StateCacheGL::_depthMask = UNKNOWN;
+GLuint StateCacheGL::_depthFunc = UNKNOWN;
+GLuint StateCacheGL::_cullFace = UNKNOWN;
+GLuint StateCacheGL::_frontFace = UNKNOWN;
+GLint StateCacheGL::_scissor[4] = {};
+bool StateCacheGL::_scissorValid = false;
+GLfloat StateCacheGL::_lineWidth = -1.0f;
+
+StateCacheGL::VertexArrayState* StateCacheGL::_vertexArray = nullptr;
+StateCacheGL::VertexArrayState StateCacheGL::_defaultVertexArray;
+std::unordered_map<uint64_t, StateCacheGL::VertexArrayState> StateCacheGL::_vertexArrays;
+
+void StateCacheGL::init(bool useVertexArrays)
+{
+    reset();
+    _useVertexArrays = useVertexArrays;
+}
+
+void StateCacheGL::invalidate()
+{
+    _program = UNKNOWN;
+    _arrayBuffer = UNKNOWN;
+    _knownCapabilities = 0;
+    std::fill(_blendEquation, _blendEquation + 2, UNKNOWN);
+    std::fill(_blendFunc, _blendFunc + 4, UNKNOWN);
+    _colorMask = UNKNOWN;
+    _depthMask = UNKNOWN;
+    _depthFunc = UNKNOWN;
+    _cullFace = UNKNOWN;
+    _frontFace = UNKNOWN;
+    _scissorValid = false;
+    _lineWidth = -1.0f;
+
+    // Only the backend enables attribute arrays, so the enabled ones are still known.
+    _vertexArray = nullptr;
+    _defaultVertexArray.elementBuffer = UNKNOWN;
+    _defaultVertexArray.valid = false;
+    for (auto& iter : _vertexArrays)
+        iter.second.elementBuffer = UNKNOWN;
+}
+
+void StateCacheGL::reset()
+{
+    _vertexArrays.clear();
+    resetVertexArrayState(_defaultVertexArray);
+    invalidate();
+}
+
+void StateCacheGL::resetStats()
+{
+    _stats.issuedCalls = 0;
+    _stats.skippedCalls = 0;
+}
+
+bool StateCacheGL::setCached(GLuint& cached, GLuint value)
+{
+    if (cached == value)
+    {
+        ++_stats.skippedCalls;
+        return false;
+    }
+
+    cached = value;
+    ++_stats.issuedCalls;
+    return true;
+}
+
+void StateCacheGL::resetVertexArrayState(VertexArrayState& state)
+{
+    state.elementBuffer = UNKNOWN;
+    state.enabledAttribs = 0;
+    state.valid = false;
+}
+
+void StateCacheGL::useProgram(GLuint program)
+{
+    if (setCached(_program, program))
+        glUseProgram(program);
+}
+
+void StateCacheGL::bindBuffer(GLenum target, GLuint buffer)
+{
+    if (GL_ELEMENT_ARRAY_BUFFER == target)
+    {
+        // The element array binding belongs to the bound vertex array object.
+        if (_vertexArray == nullptr)
+        {
+            ++_stats.issuedCalls;
+            glBindBuffer(target, buffer);
+        }
+        else if (setCached(_vertexArray->elementBuffer, buffer))
+            glBindBuffer(target, buffer);
+        return;
+    }
+
+    if (setCached(_arrayBuffer, buffer))
+        glBindBuffer(target, buffer);
+}
+
+void StateCacheGL::enableVertexAttribArray(GLuint index)
+{
+    uint32_t bit = index < 32 ? 1u << index : 0;
+    if (_vertexArray && bit && (_vertexArray->enabledAttribs & bit))
+    {
+        ++_stats.skippedCalls;
+        return;
+    }
+
+    if (_vertexArray)
+        _vertexArray->enabledAttribs |= bit;
+    ++_stats.issuedCalls;
+    glEnableVertexAttribArray(index);
+}
+
+void StateCacheGL::disableVertexAttribArray(GLuint index)
+{
+    uint32_t bit = index < 32 ? 1u << index : 0;
+    if (_vertexArray && bit && !(_vertexArray->enabledAttribs & bit))
+    {
+        ++_stats.skippedCalls;
+        return;
+    }
+
+    if (_vertexArray)
+        _vertexArray->enabledAttribs &= ~bit;
+    ++_stats.issuedCalls;
+    glDisableVertexAttribArray(index);
+}
+
+void StateCacheGL::setVertexAttribArrays(uint32_t mask)
+{
+    uint32_t enabled = _vertexArray ? _vertexArray->enabledAttribs : ~mask;
+    for (GLuint index = 0; index < 32; ++index)
+    {
+        uint32_t bit = 1u << index;
+        if ((mask & bit) && !(enabled & bit))
+            enableVertexAttribArray(index);
+        else if (!(mask & bit) && (enabled & bit))
+            disableVertexAttribArray(index);
+    }
+}
+
+void StateCacheGL::setCapability(GLenum capability, bool enabled)
+{
+    uint32_t bit = toCapabilityBit(capability);
+    if (bit && (_knownCapabilities & bit) && enabled == ((_capabilities & bit) != 0))
+    {
+        ++_stats.skippedCalls;
+        return;
+    }
+
+    _knownCapabilities |= bit;
+    if (enabled)
+    {
+        _capabilities |= bit;
+        glEnable(capability);
+    }
+    else
+    {
+        _capabilities &= ~bit;
+        glDisable(capability);
+    }
+    ++_stats.issuedCalls;
+}
+
+void StateCacheGL::blendEquationSeparate(GLenum modeRGB, GLenum modeAlpha)
+{
+    if (_blendEquation[0] == modeRGB && _blendEquation[1] == modeAlpha)
+    {
+        ++_stats.skippedCalls;
+        return;
+    }
+
+    _blendEquation[0] = modeRGB;
+    _blendEquation[1] = modeAlpha;
+    ++_stats.issuedCalls;
+    glBlendEquationSeparate(modeRGB, modeAlpha);
+}
+
+void StateCacheGL::blendFuncSeparate(GLenum srcRGB, GLenum dstRGB, GLenum srcAlpha, GLenum dstAlpha)
+{
+    if (_blendFunc[0] == srcRGB && _blendFunc[1] == dstRGB && _blendFunc[2] == srcAlpha && _blendFunc[3] == dstAlpha)
+    {
+        ++_stats.skippedCalls;
+        return;
+    }
+
+    _blendFunc[0] = srcRGB;
+    _blendFunc[1] = dstRGB;
+    _blendFunc[2] = srcAlpha;
+    _blendFunc[3] = dstAlpha;
+    ++_stats.issuedCalls;
+    glBlendFuncSeparate(srcRGB, dstRGB, srcAlpha, dstAlpha);
+}
+
+void StateCacheGL::colorMask(GLboolean red, GLboolean green, GLboolean blue, GLboolean alpha)
+{
+    GLuint mask = (red ? 1 : 0) | (green ? 2 : 0) | (blue ? 4 : 0) | (alpha ? 8 : 0);
+    if (setCached(_colorMask, mask))
+        glColorMask(red, green, blue, alpha);
+}
+
+void StateCacheGL::depthMask(GLboolean flag)
+{
+    if (setCached(_depthMask, flag ? GL_TRUE : GL_FALSE))
+        glDepthMask(flag);
+}
+
+void StateCacheGL::depthFunc(GLenum func)
+{
+    if (setCached(_depthFunc, func))
+        glDepthFunc(func);
+}
+
+void StateCacheGL::cullFace(GLenum mode)
+{
+    if (setCached(_cullFace, mode))
+        glCullFace(mode);
+}
+
+void StateCacheGL::frontFace(GLenum mode)
+{
+    if (setCached(_frontFace, mode))
+        glFrontFace(mode);
+}
+
+void StateCacheGL::scissor(GLint x, GLint y, GLsizei width, GLsizei height)
+{
+    if (_scissorValid && _scissor[0] == x && _scissor[1] == y && _scissor[2] == width && _scissor[3] == height)
+    {
+        ++_stats.skippedCalls;
+        return;
+    }
+
+    _scissor[0] = x;
+    _scissor[1] = y;
+    _scissor[2] = width;
+    _scissor[3] = height;
+    _scissorValid = true;
+    ++_stats.issuedCalls;
+    glScissor(x, y, width, height);
+}
+
+void StateCacheGL::lineWidth(GLfloat width)
+{
+    if (_lineWidth == width)
+    {
+        ++_stats.skippedCalls;
+        return;
+    }
+
+    _lineWidth = width;
+    ++_stats.issuedCalls;
+    glLineWidth(width);
+}
+
+bool StateCacheGL::bindVertexArray(GLuint buffer, uint32_t layoutHash, std::size_t offset)
+{
+    VertexArrayState* state = &_defaultVertexArray;
+    if (_useVertexArrays)
+    {
+        state = &_vertexArrays[(uint64_t)buffer << 32 | layoutHash];
+        if (state->vao == 0)
+        {
+            glGenVertexArrays(1, &state->vao);
+            resetVertexArrayState(*state);
+        }
+    }
+
+    if (_vertexArray != state)
+    {
+        if (_useVertexArrays)
+        {
+            glBindVertexArray(state->vao);
+            ++_stats.issuedCalls;
+        }
+        _vertexArray = state;
+    }
+    else if (_useVertexArrays)
+        ++_stats.skippedCalls;
+
+    if (state->valid && state->buffer == buffer && state->layoutHash == layoutHash && state->offset == offset)
+        return true;
+
+    // the caller sets up the attributes now
+    state->buffer = buffer;
+    state->layoutHash = layoutHash;
+    state->offset = offset;
+    state->valid = true;
+    return false;
+}
+
+void StateCacheGL::deleteBuffer(GLuint buffer)
+{
+    glDeleteBuffers(1, &buffer);
+
+    // Deleting a bound buffer unbinds it, the name may come back for another buffer.
+    if (_arrayBuffer == buffer)
+        _arrayBuffer = UNKNOWN;
+
+    if (_defaultVertexArray.buffer == buffer)
+        _defaultVertexArray.valid = false;
+    if (_defaultVertexArray.elementBuffer == buffer)
+        _defaultVertexArray.elementBuffer = UNKNOWN;
+
+    for (auto iter = _vertexArrays.begin(); iter != _vertexArrays.end();)
+    {
+        auto& state = iter->second;
+        if (state.buffer == buffer)
+        {
+            if (_vertexArray == &state)
+                _vertexArray = nullptr;
+            glDeleteVertexArrays(1, &state.vao);
+            iter = _vertexArrays.erase(iter);
+            continue;
+        }
+
+        if (state.elementBuffer == buffer)
+            state.elementBuffer = UNKNOWN;
+        ++iter;
+    }
+}
+
+void StateCacheGL::deleteProgram(GLuint program)
+{
+    glDeleteProgram(program);
+    if (_program == program)
+        _program = UNKNOWN;
+}
+
+CC_BACKEND_END
@@ -0,0 +1,165 @@
+/****************************************************************************
+Copyright (c) 2020 c4games.com.
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+ 
+#pragma once
+
+#include "../Macros.h"
+#include "../CommandBuffer.h"
+#include "platform/CCGL.h"
+
+#include <cstdint>
+#include <unordered_map>
+
+CC_BACKEND_BEGIN
+
+/**
+ * @addtogroup _opengl
+ * @{
+ */
+
+/**
+ * @brief A static class which shadows the OpenGL state set by the backend.
+ * Calls which wouldn't change anything are dropped, and vertex array objects remember the attribute setup of
+ * a vertex buffer and layout. All state changes of the backend have to go through it, otherwise the shadow copy is wrong.
+ */
+class StateCacheGL
+{
+public:
+    /**
+     * Reset the cache for a new context.
+     * @param useVertexArrays Whether vertex array objects are available, see FeatureType::VAO.
+     */
+    static void init(bool useVertexArrays);
+
+    /**
+     * Forget the bound state, the next call of each setter is sent to OpenGL.
+     * The vertex array objects are kept.
+     */
+    static void invalidate();
+
+    /**
+     * Forget everything including the vertex array objects, without deleting them. Used when the context was lost.
+     */
+    static void reset();
+
+    /**
+     * Get the numbers of issued and skipped calls since the last resetStats().
+     */
+    static const StateStats& getStats() { return _stats; }
+
+    /**
+     * Clear the call counters.
+     */
+    static void resetStats();
+
+    /**
+     * Count state changes which were skipped without going through the cache, i.e. the attribute setup of a cached vertex array object.
+     */
+    static void addSkippedCalls(unsigned int count) { _stats.skippedCalls += count; }
+
+    /**
+     * Count state changes which were made without going through the cache, i.e. glVertexAttribPointer.
+     */
+    static void addIssuedCalls(unsigned int count) { _stats.issuedCalls += count; }
+
+    static void useProgram(GLuint program);
+    static void bindBuffer(GLenum target, GLuint buffer);
+    static void enableVertexAttribArray(GLuint index);
+    static void disableVertexAttribArray(GLuint index);
+    /** Enable the attribute arrays in mask and disable the other ones. */
+    static void setVertexAttribArrays(uint32_t mask);
+    /** Enable or disable one of GL_BLEND, GL_DEPTH_TEST, GL_STENCIL_TEST, GL_CULL_FACE and GL_SCISSOR_TEST. */
+    static void setCapability(GLenum capability, bool enabled);
+    static void blendEquationSeparate(GLenum modeRGB, GLenum modeAlpha);
+    static void blendFuncSeparate(GLenum srcRGB, GLenum dstRGB, GLenum srcAlpha, GLenum dstAlpha);
+    static void colorMask(GLboolean red, GLboolean green, GLboolean blue, GLboolean alpha);
+    static void depthMask(GLboolean flag);
+    static void depthFunc(GLenum func);
+    static void cullFace(GLenum mode);
+    static void frontFace(GLenum mode);
+    static void scissor(GLint x, GLint y, GLsizei width, GLsizei height);
+    static void lineWidth(GLfloat width);
+
+    /**
+     * Make the attribute setup of a vertex layout on a vertex buffer current.
+     * With vertex array objects each buffer and layout pair gets its own, otherwise the setup of the last draw is compared.
+     * @param buffer The vertex buffer.
+     * @param layoutHash Identifies the vertex layout, including the attribute locations of the program.
+     * @param offset Byte offset added to the attribute offsets.
+     * @return true if the attribute pointers are already set up, otherwise the caller has to set them.
+     */
+    static bool bindVertexArray(GLuint buffer, uint32_t layoutHash, std::size_t offset);
+
+    /**
+     * Delete a buffer and forget the vertex array objects which use it.
+     */
+    static void deleteBuffer(GLuint buffer);
+
+    /**
+     * Delete a program, so that a program which gets the same name later isn't taken for it.
+     */
+    static void deleteProgram(GLuint program);
+
+private:
+    struct VertexArrayState
+    {
+        GLuint vao = 0;
+        GLuint buffer = 0;
+        uint32_t layoutHash = 0;
+        std::size_t offset = 0;
+        GLuint elementBuffer = 0;
+        uint32_t enabledAttribs = 0;
+        bool valid = false;
+    };
+
+    static bool setCached(GLuint& cached, GLuint value);
+    static void resetVertexArrayState(VertexArrayState& state);
+
+    static bool _useVertexArrays;
+    static StateStats _stats;
+
+    static GLuint _program;
+    static GLuint _arrayBuffer;
+    static uint32_t _capabilities;
+    static uint32_t _knownCapabilities;
+    static GLuint _blendEquation[2];
+    static GLuint _blendFunc[4];
+    static GLuint _colorMask;
+    static GLuint _depthMask;
+    static GLuint _depthFunc;
+    static GLuint _cullFace;
+    static GLuint _frontFace;
+    static GLint _scissor[4];
+    static bool _scissorValid;
+    static GLfloat _lineWidth;
+
+    // nullptr when the bound vertex array object is unknown
+    static VertexArrayState* _vertexArray;
+    static VertexArrayState _defaultVertexArray;
+    static std::unordered_map<uint64_t, VertexArrayState> _vertexArrays;
+};
+
+// end of _opengl group
+/// @}
+CC_BACKEND_END
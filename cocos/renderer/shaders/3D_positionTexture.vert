@@ -27,14 +27,22 @@ const char* CC3D_positionTexture_vert = R"(
 
 attribute vec4 a_position;
 attribute vec2 a_texCoord;
+#ifdef USE_INSTANCING
+attribute mat4 a_instance;
+#endif
 
 varying vec2 TextureCoordOut;
 
+// with USE_INSTANCING it holds the view projection matrix only
 uniform mat4 u_MVPMatrix;
 
 void main(void)
 {
+#ifdef USE_INSTANCING
+    gl_Position = u_MVPMatrix * (a_instance * a_position);
+#else
     gl_Position = u_MVPMatrix * a_position;
+#endif
     TextureCoordOut = a_texCoord;
     TextureCoordOut.y = 1.0 - TextureCoordOut.y;
 }
@@ -319,6 +319,8 @@ void SkeletonTwoColorBatch::flush (TwoColorTrianglesCommand* materialCommand) {
 
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+	// the backend doesn't know about the calls above
+	Director::getInstance()->getRenderer()->invalidateState();
 
 	_numVerticesBuffer = 0;
 	_numIndicesBuffer = 0;
@@ -23,6 +23,7 @@
  ****************************************************************************/
 
 #include "FileUtilsTest.h"
+#include <thread>
 
 USING_NS_CC;
 
@@ -48,6 +49,9 @@ FileUtilsTests::FileUtilsTests()
     ADD_TEST_CASE(TestWriteDataAsync);
     ADD_TEST_CASE(TestListFiles);
     ADD_TEST_CASE(TestIsFileExistRejectFolder);
+    ADD_TEST_CASE(TestAssetPack);
+    ADD_TEST_CASE(TestFileIndex);
+    ADD_TEST_CASE(TestPlistCache);
 }
 
 // TestResolutionDirectories
@@ -1392,3 +1396,220 @@ std::string TestIsFileExistRejectFolder::subtitle() const
 {
     return "";
 }
+
+// TestAssetPack
+
+void TestAssetPack::onEnter()
+{
+    FileUtilsDemo::onEnter();
+    auto fs = FileUtils::getInstance();
+    auto winSize = Director::getInstance()->getWinSize();
+
+    auto readResult = Label::createWithTTF("show readResult", "fonts/Thonburi.ttf", 16);
+    this->addChild(readResult);
+    readResult->setPosition(winSize.width / 2, winSize.height / 2);
+
+    std::string names[] = {"background.wav", "fileLookup.plist", "Images/grossini.png"};
+    std::vector<AssetPack::Source> sources;
+    for (auto& name : names)
+        sources.push_back({name, fs->fullPathForFilename(name)});
+
+    auto runTests = [&](bool compress) {
+        std::string packPath = fs->getWritablePath() + (compress ? "deflated.pack" : "stored.pack");
+        _packPaths.push_back(packPath);
+
+        if (!AssetPack::write(packPath, sources, compress))
+            return std::string("failed: write the pack");
+        if (!fs->mountAssetPack(packPath, true))
+            return std::string("failed: mount the pack");
+
+        std::string prefix = packPath + "/";
+        for (auto& source : sources)
+        {
+            std::string loose;
+            fs->getContents(source.path, &loose);
+
+            std::string fullPath = fs->fullPathForFilename(source.name);
+            if (fullPath != prefix + source.name)
+                return "failed: " + source.name + " not found in the pack";
+            if (!fs->isFileExist(source.name))
+                return "failed: isFileExist(" + source.name + ")";
+            if (fs->getFileSize(fullPath) != static_cast<int64_t>(loose.size()))
+                return "failed: getFileSize(" + source.name + ")";
+
+            std::string packed;
+            auto err = fs->getContents(source.name, &packed);
+            if (err != FileUtils::Status::OK)
+                return "failed: error: " + FileErrors[(int)err];
+            if (packed != loose)
+                return "failed: contents of " + source.name;
+
+            auto view = fs->getContentsView(source.name);
+            if (!compress && !view)
+                return "failed: no view of " + source.name;
+            if (view && (view.size() != loose.size() || memcmp(view.data(), loose.data(), loose.size()) != 0))
+                return "failed: view of " + source.name;
+        }
+
+        std::string missing;
+        if (fs->isFileExist(prefix + "missing.txt") || fs->getContents(prefix + "missing.txt", &missing) != FileUtils::Status::NotExists)
+            return std::string("failed: missing file found");
+
+        fs->unmountAssetPack(packPath);
+        if (fs->fullPathForFilename(names[0]).compare(0, prefix.size(), prefix) == 0)
+            return std::string("failed: still mounted");
+
+        return std::string("read success");
+    };
+
+    std::string result = "stored: " + runTests(false);
+    result += "\ndeflated: " + runTests(true);
+    readResult->setString(result);
+}
+
+void TestAssetPack::onExit()
+{
+    auto fs = FileUtils::getInstance();
+    for (auto& packPath : _packPaths)
+    {
+        fs->unmountAssetPack(packPath);
+        fs->removeFile(packPath);
+    }
+
+    FileUtilsDemo::onExit();
+}
+
+std::string TestAssetPack::title() const
+{
+    return "FileUtils: asset packs";
+}
+
+std::string TestAssetPack::subtitle() const
+{
+    return "Reads files through mounted packs, stored and deflated";
+}
+
+// TestFileIndex
+
+void TestFileIndex::onEnter()
+{
+    FileUtilsDemo::onEnter();
+    auto fs = FileUtils::getInstance();
+    auto winSize = Director::getInstance()->getWinSize();
+
+    auto readResult = Label::createWithTTF("show readResult", "fonts/Thonburi.ttf", 16);
+    this->addChild(readResult);
+    readResult->setPosition(winSize.width / 2, winSize.height / 2);
+
+    std::string names[] = {"fileLookup.plist", "Images/grossini.png", "background.wav", "fonts/Thonburi.ttf",
+        "Images/../fileLookup.plist", "Images", "not-existing.png"};
+
+    fs->purgeCachedEntries();
+    std::vector<std::string> expected;
+    for (auto& name : names)
+        expected.push_back(fs->fullPathForFilename(name));
+
+    auto runTests = [&]() {
+        fs->buildFileIndex();
+        for (size_t i = 0; i < expected.size(); ++i)
+        {
+            std::string fullPath = fs->fullPathForFilename(names[i]);
+            if (fullPath != expected[i])
+                return "failed: " + names[i] + " -> " + fullPath + ", expected " + expected[i];
+        }
+
+        // lookups of loading threads share the cache
+        std::string threadResult;
+        std::thread loader([&]() {
+            for (size_t i = 0; i < expected.size(); ++i)
+            {
+                if (fs->fullPathForFilename(names[i]) != expected[i])
+                    threadResult = "failed: " + names[i] + " on another thread";
+            }
+        });
+        loader.join();
+        if (!threadResult.empty())
+            return threadResult;
+
+        return std::string("lookup success");
+    };
+    readResult->setString("FileUtils::buildFileIndex() " + runTests());
+}
+
+void TestFileIndex::onExit()
+{
+    FileUtils::getInstance()->clearFileIndex();
+    FileUtilsDemo::onExit();
+}
+
+std::string TestFileIndex::title() const
+{
+    return "FileUtils: file index";
+}
+
+std::string TestFileIndex::subtitle() const
+{
+    return "Full paths found through the index match the file system ones";
+}
+
+// TestPlistCache
+
+void TestPlistCache::onEnter()
+{
+    FileUtilsDemo::onEnter();
+    auto fs = FileUtils::getInstance();
+    auto winSize = Director::getInstance()->getWinSize();
+
+    auto readResult = Label::createWithTTF("show readResult", "fonts/Thonburi.ttf", 16);
+    this->addChild(readResult);
+    readResult->setPosition(winSize.width / 2, winSize.height / 2);
+
+    auto runTests = [&]() {
+        const std::string plist = "animations/grossini.plist";
+        ValueMap parsed = fs->getValueMapFromFile(plist);
+        if (parsed.empty())
+            return std::string("failed to parse ") + plist;
+
+        Data compiled = BinaryValue::encode(parsed);
+        ValueMap decoded;
+        if (!BinaryValue::decode(compiled.getBytes(), compiled.getSize(), &decoded) || Value(decoded) != Value(parsed))
+            return std::string("BinaryValue round trip failed");
+        if (Value(fs->getValueMapFromData(reinterpret_cast<const char*>(compiled.getBytes()), static_cast<int>(compiled.getSize()))) != Value(parsed))
+            return std::string("getValueMapFromData() failed on compiled data");
+
+        // the first load compiles the plist into the cache, the second one reads the copy
+        std::string cacheDirectory = fs->getWritablePath() + "plist-cache/";
+        fs->removeDirectory(cacheDirectory);
+        fs->setPlistCacheDirectory(cacheDirectory);
+        for (int i = 0; i < 2; ++i)
+        {
+            if (Value(fs->getValueMapFromFile(plist)) != Value(parsed))
+                return StringUtils::format("load %d through the cache doesn't match the plist", i + 1);
+        }
+
+        auto files = fs->listFiles(cacheDirectory);
+        bool cached = std::any_of(files.begin(), files.end(), [](const std::string& file) {
+            return file.size() > 4 && file.compare(file.size() - 4, 4, ".bin") == 0;
+        });
+        return std::string(cached ? "compiled plists match" : "failed: nothing was cached");
+    };
+    readResult->setString(runTests());
+}
+
+void TestPlistCache::onExit()
+{
+    auto fs = FileUtils::getInstance();
+    fs->setPlistCacheDirectory("");
+    fs->removeDirectory(fs->getWritablePath() + "plist-cache/");
+    FileUtilsDemo::onExit();
+}
+
+std::string TestPlistCache::title() const
+{
+    return "FileUtils: compiled plists";
+}
+
+std::string TestPlistCache::subtitle() const
+{
+    return "Plists read from their binary copies match the XML ones";
+}
@@ -269,4 +269,39 @@ public:
     virtual std::string subtitle() const override;
 };
 
+class TestAssetPack : public FileUtilsDemo
+{
+public:
+    CREATE_FUNC(TestAssetPack);
+
+    virtual void onEnter() override;
+    virtual void onExit() override;
+    virtual std::string title() const override;
+    virtual std::string subtitle() const override;
+private:
+    std::vector<std::string> _packPaths;
+};
+
+class TestFileIndex : public FileUtilsDemo
+{
+public:
+    CREATE_FUNC(TestFileIndex);
+
+    virtual void onEnter() override;
+    virtual void onExit() override;
+    virtual std::string title() const override;
+    virtual std::string subtitle() const override;
+};
+
+class TestPlistCache : public FileUtilsDemo
+{
+public:
+    CREATE_FUNC(TestPlistCache);
+
+    virtual void onEnter() override;
+    virtual void onExit() override;
+    virtual std::string title() const override;
+    virtual std::string subtitle() const override;
+};
+
 #endif /* __FILEUTILSTEST_H__ */
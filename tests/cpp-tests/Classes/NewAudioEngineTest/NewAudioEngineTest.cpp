@@ -49,6 +49,7 @@ AudioEngineTests::AudioEngineTests()
     ADD_TEST_CASE(AudioIssue16938Test);
     ADD_TEST_CASE(AudioPlayInFinishedCB);
     ADD_TEST_CASE(AudioUncacheInFinishedCB);
+    ADD_TEST_CASE(AudioVirtualVoicesTest);
 
     ADD_TEST_CASE(AudioIssue18597Test);
     ADD_TEST_CASE(AudioIssue11143Test);
@@ -1191,4 +1192,111 @@ std::string AudioUncacheInFinishedCB::subtitle() const
     return "Should not crash";
 }
 
+// The voices have the priority of their profile and a volume chosen by their index, so the ones which must have
+// a source are known in advance. Run with ALSOFT_DRIVERS=null to check it without an audio device.
+void AudioVirtualVoicesTest::onEnter()
+{
+    AudioEngineTestDemo::onEnter();
+
+    auto s = Director::getInstance()->getVisibleSize();
+    _resultLabel = Label::createWithTTF("", "fonts/arial.ttf", 20);
+    _resultLabel->setPosition(s.width / 2, s.height * 0.4f);
+    addChild(_resultLabel);
+
+    for (int index = 0; index < PRIORITY_COUNT; ++index)
+    {
+        _profiles[index].name = StringUtils::format("VirtualVoices%d", index);
+        _profiles[index].priority = index;
+    }
+
+    _voices.clear();
+    for (int index = 0; index < VOICE_COUNT; ++index)
+    {
+        Voice voice;
+        voice.priority = (index * 3) % PRIORITY_COUNT;
+        voice.volume = ((index * 37) % 100 + 1) / 100.0f;
+        voice.audioID = AudioEngine::play2d("background.mp3", true, voice.volume, &_profiles[voice.priority]);
+        if (voice.audioID == AudioEngine::INVALID_AUDIO_ID)
+        {
+            showResult(false, "play2d");
+            return;
+        }
+        _voices.push_back(voice);
+    }
+
+    scheduleOnce([this](float dt){
+        if (!checkRealVoices("play"))
+            return;
+
+        // the sources of the stopped voices go to the next most important ones
+        for (int index = 0; index < 10; ++index)
+        {
+            AudioEngine::stop(_voices.front().audioID);
+            _voices.erase(_voices.begin());
+        }
+        if (!checkRealVoices("stop"))
+            return;
+
+        scheduleOnce([this](float dt){
+            for (auto&& voice : _voices)
+            {
+                if (AudioEngine::isVirtual(voice.audioID) && AudioEngine::getCurrentTime(voice.audioID) <= 0.0f)
+                {
+                    showResult(false, "virtual time");
+                    return;
+                }
+            }
+            showResult(true, "virtual time");
+        }, 0.5f, "checkTime");
+    }, 1.0f, "checkVoices");
+}
 
+bool AudioVirtualVoicesTest::checkRealVoices(const char* step)
+{
+    auto stats = AudioEngine::getVoiceStats();
+    if (stats.voices != _voices.size() || stats.realVoices == 0)
+    {
+        showResult(false, step);
+        return false;
+    }
+
+    // the same order as the engine: priority, then volume, then the newest
+    std::stable_sort(_voices.begin(), _voices.end(), [](const Voice& a, const Voice& b){
+        if (a.priority != b.priority)
+            return a.priority > b.priority;
+        if (a.volume != b.volume)
+            return a.volume > b.volume;
+        return a.audioID > b.audioID;
+    });
+
+    for (size_t index = 0; index < _voices.size(); ++index)
+    {
+        if (AudioEngine::isVirtual(_voices[index].audioID) != (index >= stats.realVoices))
+        {
+            showResult(false, step);
+            return false;
+        }
+    }
+
+    log("AudioVirtualVoicesTest %s: %u voices, %u real, %u steals, %u revivals", step,
+        stats.voices, stats.realVoices, stats.steals, stats.revivals);
+    return true;
+}
+
+void AudioVirtualVoicesTest::showResult(bool passed, const char* step)
+{
+    auto result = StringUtils::format("%s (%s)", passed ? "PASS" : "FAIL", step);
+    log("AudioVirtualVoicesTest: %s", result.c_str());
+    _resultLabel->setString(result);
+    _resultLabel->setColor(passed ? Color3B::GREEN : Color3B::RED);
+}
+
+std::string AudioVirtualVoicesTest::title() const
+{
+    return "Virtual voices";
+}
+
+std::string AudioVirtualVoicesTest::subtitle() const
+{
+    return "500 voices share the sources by priority and volume";
+}
@@ -341,4 +341,33 @@ public:
 private:
 };
 
+class AudioVirtualVoicesTest : public AudioEngineTestDemo
+{
+public:
+    CREATE_FUNC(AudioVirtualVoicesTest);
+
+    virtual void onEnter() override;
+
+    virtual std::string title() const override;
+    virtual std::string subtitle() const override;
+
+private:
+    static const int VOICE_COUNT = 500;
+    static const int PRIORITY_COUNT = 5;
+
+    struct Voice
+    {
+        int audioID;
+        int priority;
+        float volume;
+    };
+
+    bool checkRealVoices(const char* step);
+    void showResult(bool passed, const char* step);
+
+    std::vector<Voice> _voices;
+    cocos2d::AudioProfile _profiles[PRIORITY_COUNT];
+    cocos2d::Label* _resultLabel = nullptr;
+};
+
 #endif /* defined(__NEWAUDIOENGINE_TEST_H_) */
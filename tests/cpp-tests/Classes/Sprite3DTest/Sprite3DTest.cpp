@@ -70,6 +70,7 @@ Sprite3DTests::Sprite3DTests()
     ADD_TEST_CASE(Sprite3DPropertyTest);
     ADD_TEST_CASE(Sprite3DNormalMappingTest);
     ADD_TEST_CASE(Issue16155Test);
+    ADD_TEST_CASE(Sprite3DInstancingTest);
 };
 
 //------------------------------------------------------------------
@@ -2720,3 +2721,65 @@ std::string Issue16155Test::subtitle() const
 {
     return "Should not leak texture. See console";
 }
+
+//------------------------------------------------------------------
+//
+// Sprite3DInstancingTest
+//
+//------------------------------------------------------------------
+Sprite3DInstancingTest::Sprite3DInstancingTest()
+{
+    auto s = Director::getInstance()->getWinSize();
+
+    // All the sprites share one instanced material, the renderer merges the meshes with the same color into one draw call.
+    auto material = Sprite3DMaterial::createBuiltInMaterial(Sprite3DMaterial::MaterialType::UNLIT_INSTANCE, false);
+    const int columns = 10;
+    const int rows = 5;
+    for (int row = 0; row < rows; ++row)
+    {
+        for (int column = 0; column < columns; ++column)
+        {
+            auto sprite = Sprite3D::create("Sprite3DTest/boss1.obj");
+            sprite->setTexture("Sprite3DTest/boss.png");
+            sprite->setMaterial(material);
+            sprite->setScale(1.5f);
+            sprite->setPosition(Vec2((column + 0.5f) * s.width / columns, s.height * 0.2f + row * s.height * 0.6f / rows));
+            sprite->runAction(RepeatForever::create(RotateBy::create(2.0f + column * 0.2f, Vec3(0, 360, 0))));
+            if (row % 2)
+                sprite->setColor(Color3B::RED);
+            addChild(sprite);
+        }
+    }
+
+    _statsLabel = Label::createWithTTF("", "fonts/arial.ttf", 12);
+    _statsLabel->setPosition(Vec2(s.width / 2, s.height * 0.12f));
+    addChild(_statsLabel);
+
+    scheduleUpdate();
+}
+
+void Sprite3DInstancingTest::update(float dt)
+{
+    auto renderer = Director::getInstance()->getRenderer();
+    if (!renderer->isMeshInstancingSupported() || Director::getInstance()->getRunningScene() != this)
+        return;
+
+    // the stats of the last frame, one instanced draw per color
+    const auto batches = renderer->getDrawnInstancedBatches();
+    const auto instances = renderer->getDrawnInstances();
+    _statsLabel->setString(StringUtils::format("instanced draws: %d, instances: %d", (int)batches, (int)instances));
+    if (++_frames > 1)
+        CCASSERT(batches == 2 && instances == 50, "the sprites should be drawn with one instanced draw per color");
+}
+
+std::string Sprite3DInstancingTest::title() const
+{
+    return "Sprite3D Instancing Test";
+}
+
+std::string Sprite3DInstancingTest::subtitle() const
+{
+    if (!Director::getInstance()->getRenderer()->isMeshInstancingSupported())
+        return "Instancing not supported, one draw call per sprite";
+    return "50 rotating sprites, one draw call per color";
+}
@@ -614,3 +614,17 @@ public:
     virtual std::string title() const override;
     virtual std::string subtitle() const override;
 };
+
+class Sprite3DInstancingTest : public Sprite3DTestDemo
+{
+public:
+    CREATE_FUNC(Sprite3DInstancingTest);
+    Sprite3DInstancingTest();
+    virtual std::string title() const override;
+    virtual std::string subtitle() const override;
+    virtual void update(float dt) override;
+
+protected:
+    cocos2d::Label* _statsLabel = nullptr;
+    int _frames = 0;
+};
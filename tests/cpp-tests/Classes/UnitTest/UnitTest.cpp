@@ -26,6 +26,15 @@
 #include "ui/UIHelper.h"
 #include "network/Uri.h"
 #include "base/ccUtils.h"
+#include "renderer/CCTextureUtils.h"
+#include "base/s3tc.h"
+#include "base/atitc.h"
+#include "base/etc1.h"
+#include "base/astc.h"
+#include "base/pvr.h"
+#include <random>
+#include <set>
+#include <thread>
 
 USING_NS_CC;
 using namespace cocos2d::network;
@@ -77,6 +86,11 @@ UnitTests::UnitTests()
     ADD_TEST_CASE(ParseIntegerListTest);
     ADD_TEST_CASE(ParseUriTest);
     ADD_TEST_CASE(ResizableBufferAdapterTest);
+    ADD_TEST_CASE(PixelFormatConversionTest);
+    ADD_TEST_CASE(CompressedTextureDecodeTest);
+#if CC_ENABLE_FRAME_PROFILER
+    ADD_TEST_CASE(FrameProfilerTest);
+#endif
 #ifdef UNIT_TEST_FOR_OPTIMIZED_MATH_UTIL
     ADD_TEST_CASE(MathUtilTest);
 #endif
@@ -1757,4 +1771,324 @@ std::string ResizableBufferAdapterTest::subtitle() const
     return "ResiziableBufferAdapter<Data> Test";
 }
 
+// PixelFormatConversionTest
+
+namespace {
+    struct ConversionResult
+    {
+        backend::PixelFormat format;
+        std::vector<unsigned char> data;
+    };
+
+    ConversionResult convertPixels(const std::vector<unsigned char>& data, backend::PixelFormat originFormat, backend::PixelFormat format, bool premultiply = false)
+    {
+        using namespace backend::PixelFormatUtils;
+
+        unsigned char* outData = nullptr;
+        size_t outDataLen = 0;
+        ConversionResult result;
+        // convertDataToFormat() only takes RGBA4444 and A8 data with Metal
+        switch (originFormat)
+        {
+            case backend::PixelFormat::RGBA4444:
+                result.format = convertRGBA4444ToFormat(data.data(), data.size(), format, &outData, &outDataLen);
+                break;
+            case backend::PixelFormat::A8:
+                result.format = convertA8ToFormat(data.data(), data.size(), format, &outData, &outDataLen);
+                break;
+            default:
+                result.format = convertDataToFormat(data.data(), data.size(), originFormat, format, &outData, &outDataLen, premultiply);
+                break;
+        }
+
+        result.data.assign(outData, outData + outDataLen);
+        if (outData != data.data())
+        {
+            free(outData);
+        }
+        return result;
+    }
+}
+
+void PixelFormatConversionTest::onEnter()
+{
+    UnitTestDemo::onEnter();
+
+    using namespace backend::PixelFormatUtils;
+    typedef backend::PixelFormat PixelFormat;
+
+    struct Source
+    {
+        PixelFormat format;
+        int bytesPerPixel;
+        std::vector<PixelFormat> targets;
+    };
+    const std::vector<PixelFormat> allTargets = {
+        PixelFormat::RGBA8888, PixelFormat::RGB888, PixelFormat::RGB565, PixelFormat::A8, PixelFormat::I8, PixelFormat::AI88,
+        PixelFormat::RGBA4444, PixelFormat::RGB5A1, PixelFormat::MTL_B5G6R5, PixelFormat::MTL_BGR5A1, PixelFormat::MTL_ABGR4
+    };
+    const Source sources[] = {
+        { PixelFormat::I8, 1, allTargets },
+        { PixelFormat::AI88, 2, allTargets },
+        { PixelFormat::RGB888, 3, allTargets },
+        { PixelFormat::RGBA8888, 4, allTargets },
+        { PixelFormat::RGB5A1, 2, { PixelFormat::RGBA8888, PixelFormat::MTL_BGR5A1 } },
+        { PixelFormat::RGB565, 2, { PixelFormat::RGBA8888, PixelFormat::MTL_B5G6R5 } },
+        { PixelFormat::RGBA4444, 2, { PixelFormat::RGBA8888, PixelFormat::MTL_ABGR4 } },
+        { PixelFormat::A8, 1, { PixelFormat::RGBA8888 } },
+        { PixelFormat::BGRA8888, 4, { PixelFormat::RGBA8888 } },
+    };
+    // odd sizes leave pixels to the scalar code after the kernels, the last ones are split in stripes over threads
+    const size_t pixelCounts[] = { 1, 3, 7, 8, 17, 33, 1001, 300 * 300 + 5, 1024 * 1024 + 3 };
+
+    const bool simdEnabled = isSIMDEnabled();
+    const int conversionThreads = getConversionThreads();
+    std::mt19937 random(2020);
+
+    for (const auto& source : sources)
+    {
+        for (auto format : source.targets)
+        {
+            for (auto pixels : pixelCounts)
+            {
+                std::vector<unsigned char> data(pixels * source.bytesPerPixel);
+                for (auto& byte : data)
+                {
+                    byte = static_cast<unsigned char>(random());
+                }
+
+                // the plain loops on the calling thread are the reference
+                setSIMDEnabled(false);
+                setConversionThreads(1);
+                auto expected = convertPixels(data, source.format, format);
+
+                setSIMDEnabled(true);
+                auto simd = convertPixels(data, source.format, format);
+                EXPECT_EQ(simd.format, expected.format);
+                EXPECT_TRUE(simd.data == expected.data);
+
+                setConversionThreads(0);
+                auto threaded = convertPixels(data, source.format, format);
+                EXPECT_EQ(threaded.format, expected.format);
+                EXPECT_TRUE(threaded.data == expected.data);
+            }
+        }
+    }
+
+    // premultiplying while converting gives the same as premultiplying first
+    for (auto format : allTargets)
+    {
+        for (auto pixels : pixelCounts)
+        {
+            std::vector<unsigned char> data(pixels * 4);
+            for (auto& byte : data)
+            {
+                byte = static_cast<unsigned char>(random());
+            }
+
+            std::vector<unsigned char> premultiplied(data.size());
+            for (size_t i = 0; i < pixels; ++i)
+            {
+                const unsigned char* p = &data[i * 4];
+                unsigned int pixel = CC_RGB_PREMULTIPLY_ALPHA(p[0], p[1], p[2], p[3]);
+                memcpy(&premultiplied[i * 4], &pixel, 4);
+            }
+
+            setSIMDEnabled(false);
+            setConversionThreads(1);
+            auto expected = convertPixels(premultiplied, PixelFormat::RGBA8888, format);
+            auto scalar = convertPixels(data, PixelFormat::RGBA8888, format, true);
+            EXPECT_TRUE(scalar.data == expected.data);
+
+            setSIMDEnabled(true);
+            setConversionThreads(0);
+            auto fused = convertPixels(data, PixelFormat::RGBA8888, format, true);
+            EXPECT_TRUE(fused.data == expected.data);
+
+            premultiplyAlpha(data.data(), data.size(), data.data());
+            EXPECT_TRUE(data == premultiplied);
+        }
+    }
+
+    setSIMDEnabled(simdEnabled);
+    setConversionThreads(conversionThreads);
+}
+
+std::string PixelFormatConversionTest::subtitle() const
+{
+    return StringUtils::format("Pixel format conversion, SIMD: %s", backend::PixelFormatUtils::getSIMDName());
+}
+
+// CompressedTextureDecodeTest
+
+void CompressedTextureDecodeTest::onEnter()
+{
+    UnitTestDemo::onEnter();
+
+    // decoding on the calling thread only is the reference, the split by block rows must give the same bytes
+    typedef std::function<void(const std::vector<unsigned char>& in, std::vector<unsigned char>& out, int width, int height, int maxThreads)> Decoder;
+    struct Format
+    {
+        int bytesPerPixel;
+        bool powerOfTwo;
+        Decoder decode;
+    };
+    const Format formats[] = {
+        { 4, false, [](const std::vector<unsigned char>& in, std::vector<unsigned char>& out, int width, int height, int maxThreads) {
+            s3tc_decode(const_cast<uint8_t*>(in.data()), out.data(), width, height, S3TCDecodeFlag::DXT1, maxThreads);
+        } },
+        { 4, false, [](const std::vector<unsigned char>& in, std::vector<unsigned char>& out, int width, int height, int maxThreads) {
+            s3tc_decode(const_cast<uint8_t*>(in.data()), out.data(), width, height, S3TCDecodeFlag::DXT5, maxThreads);
+        } },
+        { 4, false, [](const std::vector<unsigned char>& in, std::vector<unsigned char>& out, int width, int height, int maxThreads) {
+            atitc_decode(const_cast<uint8_t*>(in.data()), out.data(), width, height, ATITCDecodeFlag::ATC_RGB, maxThreads);
+        } },
+        { 4, false, [](const std::vector<unsigned char>& in, std::vector<unsigned char>& out, int width, int height, int maxThreads) {
+            atitc_decode(const_cast<uint8_t*>(in.data()), out.data(), width, height, ATITCDecodeFlag::ATC_INTERPOLATED_ALPHA, maxThreads);
+        } },
+        { 3, false, [](const std::vector<unsigned char>& in, std::vector<unsigned char>& out, int width, int height, int maxThreads) {
+            etc1_decode_image(in.data(), out.data(), width, height, 3, width * 3, maxThreads);
+        } },
+        { 2, false, [](const std::vector<unsigned char>& in, std::vector<unsigned char>& out, int width, int height, int maxThreads) {
+            etc1_decode_image(in.data(), out.data(), width, height, 2, width * 2, maxThreads);
+        } },
+        { 4, false, [](const std::vector<unsigned char>& in, std::vector<unsigned char>& out, int width, int height, int maxThreads) {
+            decompress_astc(in.data(), out.data(), width, height, 4, 4, static_cast<uint32_t>(in.size()), maxThreads);
+        } },
+        { 4, false, [](const std::vector<unsigned char>& in, std::vector<unsigned char>& out, int width, int height, int maxThreads) {
+            decompress_astc(in.data(), out.data(), width, height, 6, 6, static_cast<uint32_t>(in.size()), maxThreads);
+        } },
+        { 4, true, [](const std::vector<unsigned char>& in, std::vector<unsigned char>& out, int width, int height, int maxThreads) {
+            PVRTDecompressPVRTC(in.data(), width, height, out.data(), false, maxThreads);
+        } },
+        { 4, true, [](const std::vector<unsigned char>& in, std::vector<unsigned char>& out, int width, int height, int maxThreads) {
+            PVRTDecompressPVRTC(in.data(), width, height, out.data(), true, maxThreads);
+        } },
+    };
+    // odd sizes have partial blocks at the edges, the large ones are split over several threads
+    const int sizes[][2] = { { 4, 4 }, { 8, 8 }, { 12, 20 }, { 64, 64 }, { 100, 300 }, { 256, 512 }, { 1024, 1024 } };
+
+    std::mt19937 random(2020);
+    for (const auto& format : formats)
+    {
+        for (const auto& size : sizes)
+        {
+            int width = size[0], height = size[1];
+            if (format.powerOfTwo && ((width & (width - 1)) || (height & (height - 1))))
+                continue;
+
+            // one byte per pixel is more than any of these formats needs, even with partial blocks
+            std::vector<unsigned char> encoded((width + 8) * (height + 8));
+            for (auto& byte : encoded)
+            {
+                byte = static_cast<unsigned char>(random());
+            }
+
+            std::vector<unsigned char> expected(width * height * format.bytesPerPixel);
+            format.decode(encoded, expected, width, height, 1);
+
+            std::vector<unsigned char> parallel(expected.size());
+            format.decode(encoded, parallel, width, height, 0);
+            EXPECT_TRUE(parallel == expected);
+        }
+    }
+
+    // a DXT1 block of pure red, 5 bit channels aren't expanded
+    std::vector<unsigned char> red = { 0x00, 0xf8, 0x1f, 0x00, 0x00, 0x00, 0x00, 0x00 };
+    std::vector<unsigned char> pixels(4 * 4 * 4);
+    s3tc_decode(red.data(), pixels.data(), 4, 4, S3TCDecodeFlag::DXT1, 0);
+    for (size_t i = 0; i < pixels.size(); i += 4)
+    {
+        EXPECT_EQ(pixels[i], 0xf8);
+        EXPECT_EQ(pixels[i + 1], 0);
+        EXPECT_EQ(pixels[i + 2], 0);
+        EXPECT_EQ(pixels[i + 3], 0xff);
+    }
+}
+
+std::string CompressedTextureDecodeTest::subtitle() const
+{
+    return "Software decoders of compressed textures";
+}
+
+#if CC_ENABLE_FRAME_PROFILER
+
+// FrameProfilerTest
+
+void FrameProfilerTest::onEnter()
+{
+    UnitTestDemo::onEnter();
+
+    const int zonesPerThread = 100;
+    auto profiler = FrameProfiler::getInstance();
+    std::string path = FileUtils::getInstance()->getWritablePath() + "FrameProfilerTest.json";
+    std::string writtenPath;
+
+    // the capture starts and ends at the start of a frame, done by hand here instead of waiting for the Director
+    profiler->startCapture(0, path, [&writtenPath](const std::string& tracePath) {
+        writtenPath = tracePath;
+    });
+    profiler->beginFrame();
+    EXPECT_TRUE(FrameProfiler::isCapturing());
+
+    for (int i = 0; i < zonesPerThread; ++i)
+    {
+        CC_PROFILE_ZONE("FrameProfilerTest.main");
+    }
+    // a restarted worker takes over the buffer of the exited one
+    for (int run = 0; run < 2; ++run)
+    {
+        std::thread worker([zonesPerThread]() {
+            CC_PROFILE_THREAD("FrameProfilerTest");
+            for (int i = 0; i < zonesPerThread; ++i)
+            {
+                CC_PROFILE_ZONE("FrameProfilerTest.worker");
+            }
+        });
+        worker.join();
+    }
+
+    profiler->stopCapture();
+    profiler->beginFrame();
+    EXPECT_FALSE(FrameProfiler::isCapturing());
+    EXPECT_EQ(writtenPath, path);
+
+    // one complete event per line, count the zones of each thread
+    std::string trace = FileUtils::getInstance()->getStringFromFile(path);
+    int mainZones = 0, workerZones = 0;
+    std::set<std::string> workerThreads;
+    size_t begin = 0;
+    while (begin < trace.size())
+    {
+        size_t end = trace.find('\n', begin);
+        if (end == std::string::npos)
+            end = trace.size();
+        std::string event = trace.substr(begin, end - begin);
+        begin = end + 1;
+
+        if (event.find("\"ph\":\"X\"") == std::string::npos)
+            continue;
+        if (event.find("\"name\":\"FrameProfilerTest.main\"") != std::string::npos)
+        {
+            ++mainZones;
+        }
+        else if (event.find("\"name\":\"FrameProfilerTest.worker\"") != std::string::npos)
+        {
+            ++workerZones;
+            auto tid = event.find("\"tid\":");
+            workerThreads.insert(event.substr(tid, event.find(',', tid) - tid));
+        }
+    }
+    EXPECT_EQ(mainZones, zonesPerThread);
+    EXPECT_EQ(workerZones, 2 * zonesPerThread);
+    EXPECT_EQ(workerThreads.size(), 1u);
+
+    FileUtils::getInstance()->removeFile(path);
+}
+
+std::string FrameProfilerTest::subtitle() const
+{
+    return "FrameProfiler capture of several threads";
+}
 
+#endif // CC_ENABLE_FRAME_PROFILER
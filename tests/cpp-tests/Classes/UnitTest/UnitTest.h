@@ -112,5 +112,31 @@ public:
     virtual std::string subtitle() const override;
 };
 
+class PixelFormatConversionTest : public UnitTestDemo
+{
+public:
+    CREATE_FUNC(PixelFormatConversionTest);
+    virtual void onEnter() override;
+    virtual std::string subtitle() const override;
+};
+
+class CompressedTextureDecodeTest : public UnitTestDemo
+{
+public:
+    CREATE_FUNC(CompressedTextureDecodeTest);
+    virtual void onEnter() override;
+    virtual std::string subtitle() const override;
+};
+
+#if CC_ENABLE_FRAME_PROFILER
+class FrameProfilerTest : public UnitTestDemo
+{
+public:
+    CREATE_FUNC(FrameProfilerTest);
+    virtual void onEnter() override;
+    virtual std::string subtitle() const override;
+};
+#endif
+
 
 #endif /* __UNIT_TEST__ */
@@ -25,6 +25,8 @@
 #include "ZipTests.h"
 
 #include <sstream>
+#include <thread>
+#include <atomic>
 
 #include "unzip/unzip.h"
 #include "unzip/crypt.h"
@@ -34,6 +36,7 @@ using namespace cocos2d;
 ZipTests::ZipTests() {
     ADD_TEST_CASE(UnZipNormalFile);
     ADD_TEST_CASE(UnZipWithPassword);
+    ADD_TEST_CASE(ZipFileConcurrentRead);
 }
 
 std::string ZipTest::title() const {
@@ -165,3 +168,59 @@ void UnZipWithPassword::onEnter() {
 std::string UnZipWithPassword::subtitle() const {
     return "unzip with password";
 }
+
+void ZipFileConcurrentRead::onEnter() {
+    TestCase::onEnter();
+
+    const auto winSize = Director::getInstance()->getWinSize();
+
+    Label *label = Label::createWithTTF("unziping file", "fonts/Marker Felt.ttf", 23);
+    label->setPosition(winSize.width/2, winSize.height/2);
+    addChild(label);
+
+    auto fu = FileUtils::getInstance();
+    Data origContent = fu->getDataFromFile("zip/10k.txt");
+    Data zipContent = fu->getDataFromFile("zip/10k-nopass.zip");
+    std::unique_ptr<ZipFile> zip(ZipFile::createWithBuffer(zipContent.getBytes(), zipContent.getSize()));
+    if (!zip || !zip->fileExists("10k.txt")) {
+        label->setString("Failed to open zip file");
+        return;
+    }
+
+    // every thread reads the file over and over, without any lock around the zip file
+    const int threadCount = 4;
+    const int readsPerThread = 50;
+    std::atomic<int> mismatches(0);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < threadCount; ++i) {
+        threads.emplace_back([&]() {
+            for (int read = 0; read < readsPerThread; ++read) {
+                ssize_t size = 0;
+                unsigned char* data = zip->getFileData("10k.txt", &size);
+                if (size != origContent.getSize() || memcmp(data, origContent.getBytes(), size) != 0)
+                    ++mismatches;
+                free(data);
+            }
+        });
+    }
+    for (auto& thread : threads)
+        thread.join();
+
+    // password protected files can't be read
+    Data encryptedContent = fu->getDataFromFile("zip/10k.zip");
+    std::unique_ptr<ZipFile> encrypted(ZipFile::createWithBuffer(encryptedContent.getBytes(), encryptedContent.getSize()));
+    ssize_t encryptedSize = 0;
+    unsigned char* encryptedData = encrypted ? encrypted->getFileData("10k.txt", &encryptedSize) : nullptr;
+    free(encryptedData);
+
+    if (mismatches != 0)
+        label->setString(StringUtils::format("unzip error! %d of %d reads mismatch!", mismatches.load(), threadCount * readsPerThread));
+    else if (encryptedData)
+        label->setString("unzip error! encrypted file read without password!");
+    else
+        label->setString("unzip ok!");
+}
+
+std::string ZipFileConcurrentRead::subtitle() const {
+    return "ZipFile read by 4 threads at once";
+}
@@ -50,3 +50,10 @@ public:
     virtual std::string subtitle() const override;
 };
 
+class ZipFileConcurrentRead : public ZipTest
+{
+public:
+    CREATE_FUNC(ZipFileConcurrentRead);
+    virtual void onEnter() override;
+    virtual std::string subtitle() const override;
+};
@@ -0,0 +1,554 @@
+/****************************************************************************
+ Copyright (c) 2020 c4games.com.
+
+ http://www.cocos2d-x.org
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+
+#include "PerformanceAudioTest.h"
+#include "Profile.h"
+#include "audio/include/AudioEngine.h"
+#include "audio/include/AudioStreamer.h"
+#include "audio/include/AudioSampleConverter.h"
+
+USING_NS_CC;
+
+PerformceAudioTests::PerformceAudioTests()
+{
+    ADD_TEST_CASE(AudioStreamingStressTest);
+    ADD_TEST_CASE(AudioCacheBudgetTest);
+    ADD_TEST_CASE(AudioPreloadBenchmarkTest);
+}
+
+////////////////////////////////////////////////////////
+//
+// AudioStreamingStressTest
+//
+////////////////////////////////////////////////////////
+static const int kAudioStreams = 32;
+static const float kAudioStreamingTime = 10.0f;
+static const float kAudioSeekInterval = 0.1f;
+static const int kAudioFileSeconds = 30;
+static const int kAudioSampleRate = 44100;
+
+// A WAV of a quiet tone, a bit different on every channel, stereo 16 bits PCM by default.
+static bool writeToneWav(const std::string& path, float seconds, float frequency, int channels = 2, int bits = 16, bool isFloat = false)
+{
+    const uint32_t frames = static_cast<uint32_t>(seconds * kAudioSampleRate);
+    const uint32_t bytesPerSample = bits / 8;
+    const uint32_t bytesPerFrame = channels * bytesPerSample;
+    const uint32_t dataSize = frames * bytesPerFrame;
+
+    std::vector<unsigned char> bytes(44 + dataSize);
+    auto put32 = [&bytes](size_t offset, uint32_t value) {
+        for (int i = 0; i < 4; ++i)
+            bytes[offset + i] = static_cast<unsigned char>(value >> (8 * i));
+    };
+    auto put16 = [&bytes](size_t offset, uint16_t value) {
+        bytes[offset] = static_cast<unsigned char>(value);
+        bytes[offset + 1] = static_cast<unsigned char>(value >> 8);
+    };
+    memcpy(bytes.data(), "RIFF", 4);
+    put32(4, 36 + dataSize);
+    memcpy(bytes.data() + 8, "WAVEfmt ", 8);
+    put32(16, 16);
+    put16(20, isFloat ? 3 : 1); // IEEE float or PCM
+    put16(22, channels);
+    put32(24, kAudioSampleRate);
+    put32(28, kAudioSampleRate * bytesPerFrame);
+    put16(32, bytesPerFrame);
+    put16(34, bits);
+    memcpy(bytes.data() + 36, "data", 4);
+    put32(40, dataSize);
+
+    auto out = bytes.data() + 44;
+    for (uint32_t frame = 0; frame < frames; ++frame)
+    {
+        float t = static_cast<float>(frame) / kAudioSampleRate;
+        for (int channel = 0; channel < channels; ++channel)
+        {
+            float value = 2000 * sinf(t * frequency * (1 + 0.5f * channel) * 2 * M_PI);
+            if (isFloat)
+            {
+                float sample = value / 32768;
+                memcpy(out, &sample, sizeof(sample));
+            }
+            else
+            {
+                auto sample = static_cast<int32_t>(static_cast<int16_t>(value)) << (bits - 16);
+                for (uint32_t i = 0; i < bytesPerSample; ++i)
+                    out[i] = static_cast<unsigned char>(sample >> (8 * i));
+            }
+            out += bytesPerSample;
+        }
+    }
+
+    Data data;
+    data.fastSet(bytes.data(), static_cast<ssize_t>(bytes.size()));
+    bool ret = FileUtils::getInstance()->writeDataToFile(data, path);
+    data.fastSet(nullptr, 0);
+    return ret;
+}
+
+void AudioStreamingStressTest::onEnter()
+{
+    TestCase::onEnter();
+
+    auto s = Director::getInstance()->getWinSize();
+    _resultLabel = Label::createWithTTF("Preparing streams...", "fonts/arial.ttf", 12);
+    _resultLabel->setPosition(Vec2(s.width / 2, s.height / 2));
+    addChild(_resultLabel);
+
+    // larger than what AudioCache decodes at once, so it is streamed
+    _filePath = FileUtils::getInstance()->getWritablePath() + "perf_audio_stream.wav";
+    if (!FileUtils::getInstance()->isFileExist(_filePath) && !writeToneWav(_filePath, kAudioFileSeconds, 440))
+    {
+        _resultLabel->setString("Writing the WAV file failed!");
+        return;
+    }
+
+    if (isAutoTesting())
+    {
+        Profile::getInstance()->testCaseBegin("AudioStreamingStressTest",
+                                              genStrVector("Streams", nullptr),
+                                              genStrVector("CPU(%)", "StreamingCPU(%)", "Wakeups/s", "Underruns", nullptr));
+    }
+
+    // the test may be left before the file is loaded
+    retain();
+    AudioEngine::preload(_filePath, [this](bool isSuccess) {
+        if (isRunning())
+        {
+            if (isSuccess)
+                scheduleOnce(CC_SCHEDULE_SELECTOR(AudioStreamingStressTest::startStreams), 0.1f);
+            else
+                _resultLabel->setString("Loading the WAV file failed!");
+        }
+        release();
+    });
+}
+
+void AudioStreamingStressTest::onExit()
+{
+    unscheduleAllCallbacks();
+    for (auto audioID : _audioIDs)
+        AudioEngine::stop(audioID);
+    _audioIDs.clear();
+    if (!_filePath.empty())
+        AudioEngine::uncache(_filePath);
+
+    TestCase::onExit();
+}
+
+void AudioStreamingStressTest::startStreams(float /*dt*/)
+{
+    for (int stream = 0; stream < kAudioStreams; ++stream)
+    {
+        int audioID = AudioEngine::play2d(_filePath, true, 1.0f / kAudioStreams);
+        if (audioID != AudioEngine::INVALID_AUDIO_ID)
+            _audioIDs.push_back(audioID);
+    }
+
+#if CC_USE_ALSOFT
+    AudioStreamer::getInstance()->resetStats();
+#endif
+    _seeks = 0;
+    _seed = 1;
+    _nextSeek = kAudioSeekInterval;
+    _cpuBegin = std::clock();
+    _begin = std::chrono::steady_clock::now();
+    scheduleUpdate();
+}
+
+void AudioStreamingStressTest::update(float /*dt*/)
+{
+    float elapsed = std::chrono::duration<float>(std::chrono::steady_clock::now() - _begin).count();
+    if (elapsed >= kAudioStreamingTime)
+    {
+        unscheduleUpdate();
+        finishStreams();
+        return;
+    }
+
+    // the seeks go through the command queues of the streaming threads
+    if (elapsed >= _nextSeek && !_audioIDs.empty())
+    {
+        _seed = _seed * 1103515245 + 12345;
+        unsigned int random = _seed >> 8;
+        AudioEngine::setCurrentTime(_audioIDs[random % _audioIDs.size()], static_cast<float>(random % (kAudioFileSeconds * 10)) / 10);
+        ++_seeks;
+        _nextSeek += kAudioSeekInterval;
+    }
+
+    _resultLabel->setString(StringUtils::format("%d streams playing, %.1f s", (int)_audioIDs.size(), elapsed));
+}
+
+void AudioStreamingStressTest::finishStreams()
+{
+    double wallTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - _begin).count();
+    double cpuTime = static_cast<double>(std::clock() - _cpuBegin) / CLOCKS_PER_SEC;
+
+    int streams = static_cast<int>(_audioIDs.size());
+    double streamingCpu = 0;
+    double wakeups = 0;
+    unsigned long long underruns = 0;
+#if CC_USE_ALSOFT
+    auto stats = AudioStreamer::getInstance()->getStats();
+    streams = stats.streams;
+    streamingCpu = stats.busyTime / wallTime * 100;
+    wakeups = stats.wakeups / wallTime;
+    underruns = stats.underruns;
+#endif
+    // std::clock() counts the time of all threads of the process, 100% is one core
+    double cpu = cpuTime / wallTime * 100;
+
+    for (auto audioID : _audioIDs)
+        AudioEngine::stop(audioID);
+    _audioIDs.clear();
+
+    log("AudioStreamingStressTest: %d streams, %d seeks, cpu %.1f%%, streaming threads %.2f%%, %.1f wakeups/s, %llu underruns",
+        streams, _seeks, cpu, streamingCpu, wakeups, underruns);
+    _resultLabel->setString(StringUtils::format("%d streams, %d seeks\nCPU %.1f%%, streaming threads %.2f%%\n%.1f wakeups/s, %llu underruns",
+                                                streams, _seeks, cpu, streamingCpu, wakeups, underruns));
+
+    if (isAutoTesting())
+    {
+        Profile::getInstance()->addTestResult(genStrVector(genStr("%d", streams).c_str(), nullptr),
+                                              genStrVector(genStr("%.1f", cpu).c_str(), genStr("%.2f", streamingCpu).c_str(),
+                                                           genStr("%.1f", wakeups).c_str(), genStr("%llu", underruns).c_str(), nullptr));
+        Profile::getInstance()->testCaseEnd();
+        setAutoTesting(false);
+    }
+}
+
+std::string AudioStreamingStressTest::title() const
+{
+    return "Audio Streaming Stress Test";
+}
+
+std::string AudioStreamingStressTest::subtitle() const
+{
+    return StringUtils::format("%d looping streams for %.0f s, a seek every %.0f ms", kAudioStreams, kAudioStreamingTime,
+                               kAudioSeekInterval * 1000);
+}
+
+////////////////////////////////////////////////////////
+//
+// AudioCacheBudgetTest
+//
+////////////////////////////////////////////////////////
+static const int kAudioEffects = 120;
+static const float kAudioEffectSeconds = 0.25f;
+static const int kAudioEffectPlays = 600;
+static const size_t kAudioCacheBudget = 1024 * 1024;
+
+void AudioCacheBudgetTest::onEnter()
+{
+    TestCase::onEnter();
+
+    auto s = Director::getInstance()->getWinSize();
+    _resultLabel = Label::createWithTTF("Writing sound effects...", "fonts/arial.ttf", 12);
+    _resultLabel->setPosition(Vec2(s.width / 2, s.height / 2));
+    addChild(_resultLabel);
+
+    _budgetBefore = AudioEngine::getCacheBudget();
+    _budget = 0;
+    _results.clear();
+
+    _filePaths.clear();
+    auto fileUtils = FileUtils::getInstance();
+    for (int effect = 0; effect < kAudioEffects; ++effect)
+    {
+        auto path = fileUtils->getWritablePath() + StringUtils::format("perf_audio_effect_%d.wav", effect);
+        if (!fileUtils->isFileExist(path) && !writeToneWav(path, kAudioEffectSeconds, 220.0f + effect * 10))
+        {
+            _resultLabel->setString("Writing the WAV files failed!");
+            return;
+        }
+        _filePaths.push_back(path);
+    }
+
+    if (isAutoTesting())
+    {
+        Profile::getInstance()->testCaseBegin("AudioCacheBudgetTest",
+                                              genStrVector("Budget", nullptr),
+                                              genStrVector("Hits", "Misses", "Evictions", "PeakPCM(KB)", "WorstPlay(ms)", nullptr));
+    }
+
+    scheduleOnce(CC_SCHEDULE_SELECTOR(AudioCacheBudgetTest::startMode), 0.1f);
+}
+
+void AudioCacheBudgetTest::onExit()
+{
+    unscheduleAllCallbacks();
+    AudioEngine::stopAll();
+    for (auto& path : _filePaths)
+        AudioEngine::uncache(path);
+    AudioEngine::setCacheBudget(_budgetBefore);
+
+    TestCase::onExit();
+}
+
+void AudioCacheBudgetTest::startMode(float /*dt*/)
+{
+    AudioEngine::stopAll();
+    for (auto& path : _filePaths)
+        AudioEngine::uncache(path);
+    AudioEngine::setCacheBudget(_budget);
+    AudioEngine::resetCacheStats();
+
+    _plays = 0;
+    _seed = 1;
+    _peakPcmBytes = 0;
+    _worstPlayMs = 0;
+    scheduleUpdate();
+}
+
+void AudioCacheBudgetTest::update(float /*dt*/)
+{
+    if (_plays == kAudioEffectPlays)
+    {
+        unscheduleUpdate();
+        finishMode();
+        return;
+    }
+
+    // a few effects are played much more often than the others, like the clicks and shots of a game
+    _seed = _seed * 1103515245 + 12345;
+    unsigned int random = _seed >> 8;
+    int effect = (random % 4 != 0) ? random % 8 : random % kAudioEffects;
+
+    auto begin = std::chrono::steady_clock::now();
+    AudioEngine::play2d(_filePaths[effect], false, 0.1f);
+    _worstPlayMs = std::max(_worstPlayMs, std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - begin).count());
+    _peakPcmBytes = std::max(_peakPcmBytes, AudioEngine::getCacheStats().pcmBytes);
+    ++_plays;
+}
+
+void AudioCacheBudgetTest::finishMode()
+{
+    auto stats = AudioEngine::getCacheStats();
+    auto mode = _budget > 0 ? StringUtils::format("%d KB", static_cast<int>(_budget / 1024)) : std::string("unlimited");
+    log("AudioCacheBudgetTest %s: %u hits, %u misses, %u evictions, peak %d KB of PCM, worst play2d %.2f ms", mode.c_str(),
+        stats.hits, stats.misses, stats.evictions, static_cast<int>(_peakPcmBytes / 1024), _worstPlayMs);
+    _results += StringUtils::format("%s: %u hits, %u misses, %u evictions, peak %d KB, play2d %.2f ms\n", mode.c_str(),
+                                    stats.hits, stats.misses, stats.evictions, static_cast<int>(_peakPcmBytes / 1024), _worstPlayMs);
+    _resultLabel->setString(_results);
+
+    if (isAutoTesting())
+    {
+        Profile::getInstance()->addTestResult(genStrVector(mode.c_str(), nullptr),
+                                              genStrVector(genStr("%u", stats.hits).c_str(), genStr("%u", stats.misses).c_str(),
+                                                           genStr("%u", stats.evictions).c_str(),
+                                                           genStr("%d", static_cast<int>(_peakPcmBytes / 1024)).c_str(),
+                                                           genStr("%.2f", _worstPlayMs).c_str(), nullptr));
+    }
+
+    if (_budget == 0)
+    {
+        _budget = kAudioCacheBudget;
+        scheduleOnce(CC_SCHEDULE_SELECTOR(AudioCacheBudgetTest::startMode), 0.5f);
+    }
+    else if (isAutoTesting())
+    {
+        Profile::getInstance()->testCaseEnd();
+        setAutoTesting(false);
+    }
+}
+
+std::string AudioCacheBudgetTest::title() const
+{
+    return "Audio Cache Budget Test";
+}
+
+std::string AudioCacheBudgetTest::subtitle() const
+{
+    return StringUtils::format("%d plays of %d effects, unlimited vs %d KB of PCM", kAudioEffectPlays, kAudioEffects,
+                               static_cast<int>(kAudioCacheBudget / 1024));
+}
+
+////////////////////////////////////////////////////////
+//
+// AudioPreloadBenchmarkTest
+//
+////////////////////////////////////////////////////////
+static const int kPreloadFilesPerFormat = 50;
+static const float kPreloadFileSeconds = 2.0f;
+
+static const struct PreloadFormat
+{
+    const char* name;
+    int channels;
+    int bits;
+    bool isFloat;
+} kPreloadFormats[] = {
+    { "16 bits stereo", 2, 16, false },
+    { "24 bits stereo", 2, 24, false },
+    { "float stereo", 2, 32, true },
+    { "16 bits 5.1", 6, 16, false },
+};
+static const int kPreloadFormatCount = sizeof(kPreloadFormats) / sizeof(kPreloadFormats[0]);
+// Every format with and without the SIMD converters, then all the files at once.
+static const int kPreloadSteps = kPreloadFormatCount * 2 + 1;
+
+void AudioPreloadBenchmarkTest::onEnter()
+{
+    TestCase::onEnter();
+
+    auto s = Director::getInstance()->getWinSize();
+    _resultLabel = Label::createWithTTF("Writing sound effects...", "fonts/arial.ttf", 12);
+    _resultLabel->setPosition(Vec2(s.width / 2, s.height / 2));
+    addChild(_resultLabel);
+
+    _simdBefore = AudioSampleConverter::isSIMDEnabled();
+    _results.clear();
+    _step = 0;
+
+    _filePaths.clear();
+    _formatBytes.assign(kPreloadFormatCount, 0);
+    auto fileUtils = FileUtils::getInstance();
+    for (int format = 0; format < kPreloadFormatCount; ++format)
+    {
+        auto& info = kPreloadFormats[format];
+        for (int effect = 0; effect < kPreloadFilesPerFormat; ++effect)
+        {
+            auto path = fileUtils->getWritablePath() + StringUtils::format("perf_audio_preload_%d_%d.wav", format, effect);
+            if (!fileUtils->isFileExist(path)
+                && !writeToneWav(path, kPreloadFileSeconds, 220.0f + effect * 10, info.channels, info.bits, info.isFloat))
+            {
+                _resultLabel->setString("Writing the WAV files failed!");
+                return;
+            }
+            _filePaths.push_back(path);
+            _formatBytes[format] += static_cast<size_t>(fileUtils->getFileSize(path));
+        }
+    }
+
+    if (isAutoTesting())
+    {
+        Profile::getInstance()->testCaseBegin("AudioPreloadBenchmarkTest",
+                                              genStrVector("Files", "SIMD", nullptr),
+                                              genStrVector("Wall(ms)", "MB/s", nullptr));
+    }
+
+    scheduleOnce(CC_SCHEDULE_SELECTOR(AudioPreloadBenchmarkTest::startStep), 0.1f);
+}
+
+void AudioPreloadBenchmarkTest::onExit()
+{
+    unscheduleAllCallbacks();
+    for (auto& path : _filePaths)
+        AudioEngine::uncache(path);
+    AudioSampleConverter::setSIMDEnabled(_simdBefore);
+
+    TestCase::onExit();
+}
+
+void AudioPreloadBenchmarkTest::startStep(float /*dt*/)
+{
+    for (auto& path : _filePaths)
+        AudioEngine::uncache(path);
+
+    std::vector<std::string> paths;
+    if (_step < kPreloadFormatCount * 2)
+    {
+        auto first = _filePaths.begin() + (_step / 2) * kPreloadFilesPerFormat;
+        paths.assign(first, first + kPreloadFilesPerFormat);
+    }
+    else
+    {
+        paths = _filePaths;
+    }
+    AudioSampleConverter::setSIMDEnabled(_step % 2 == 0);
+
+    // the test may be left before the files are loaded, the wall time includes up to a frame of the cocos thread
+    retain();
+    _begin = std::chrono::steady_clock::now();
+    AudioEngine::preloadBatch(paths, [this](int loaded, int total) {
+        if (isRunning())
+        {
+            _resultLabel->setString(_results + StringUtils::format("Preloading %d/%d...", loaded, total));
+        }
+    }, [this](bool allSucceeded) {
+        if (isRunning())
+        {
+            finishStep(allSucceeded);
+        }
+        release();
+    });
+}
+
+void AudioPreloadBenchmarkTest::finishStep(bool allSucceeded)
+{
+    float wallMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - _begin).count();
+
+    size_t bytes = 0;
+    std::string files;
+    if (_step < kPreloadFormatCount * 2)
+    {
+        bytes = _formatBytes[_step / 2];
+        files = kPreloadFormats[_step / 2].name;
+    }
+    else
+    {
+        for (auto formatBytes : _formatBytes)
+            bytes += formatBytes;
+        files = StringUtils::format("all %d", static_cast<int>(_filePaths.size()));
+    }
+    bool simd = AudioSampleConverter::isSIMDEnabled();
+    float mbPerSecond = wallMs > 0 ? bytes / (1024.0f * 1024.0f) / (wallMs / 1000) : 0;
+
+    log("AudioPreloadBenchmarkTest %s, SIMD %s: %.1f MB in %.1f ms, %.1f MB/s%s", files.c_str(), simd ? "on" : "off",
+        bytes / (1024.0f * 1024.0f), wallMs, mbPerSecond, allSucceeded ? "" : ", some files failed");
+    _results += StringUtils::format("%s, SIMD %s: %.1f ms, %.1f MB/s%s\n", files.c_str(), simd ? "on" : "off", wallMs, mbPerSecond,
+                                    allSucceeded ? "" : " (failed)");
+    _resultLabel->setString(_results);
+
+    if (isAutoTesting())
+    {
+        Profile::getInstance()->addTestResult(genStrVector(files.c_str(), simd ? "on" : "off", nullptr),
+                                              genStrVector(genStr("%.1f", wallMs).c_str(), genStr("%.1f", mbPerSecond).c_str(), nullptr));
+    }
+
+    if (++_step < kPreloadSteps)
+    {
+        scheduleOnce(CC_SCHEDULE_SELECTOR(AudioPreloadBenchmarkTest::startStep), 0.2f);
+    }
+    else
+    {
+        AudioSampleConverter::setSIMDEnabled(_simdBefore);
+        if (isAutoTesting())
+        {
+            Profile::getInstance()->testCaseEnd();
+            setAutoTesting(false);
+        }
+    }
+}
+
+std::string AudioPreloadBenchmarkTest::title() const
+{
+    return "Audio Preload Benchmark";
+}
+
+std::string AudioPreloadBenchmarkTest::subtitle() const
+{
+    return StringUtils::format("%d WAV files of %d formats converted to 16 bits stereo, SIMD: %s",
+                               kPreloadFilesPerFormat * kPreloadFormatCount, kPreloadFormatCount, AudioSampleConverter::getSIMDName());
+}
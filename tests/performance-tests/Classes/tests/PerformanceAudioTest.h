@@ -0,0 +1,121 @@
+/****************************************************************************
+ Copyright (c) 2020 c4games.com.
+
+ http://www.cocos2d-x.org
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+
+#ifndef __PERFORMANCE_AUDIO_TEST_H__
+#define __PERFORMANCE_AUDIO_TEST_H__
+
+#include "BaseTest.h"
+#include <chrono>
+#include <ctime>
+
+DEFINE_TEST_SUITE(PerformceAudioTests);
+
+/**
+ Plays 32 looping streams of a generated 30 seconds WAV at once for 10 seconds, seeking one of them
+ every 100 ms, and reports the CPU usage of the process and of the streaming threads and the underruns.
+ Run it with ALSOFT_DRIVERS=null to mix on openal-soft's null device, without audio hardware.
+ */
+class AudioStreamingStressTest : public TestCase
+{
+public:
+    CREATE_FUNC(AudioStreamingStressTest);
+
+    virtual std::string title() const override;
+    virtual std::string subtitle() const override;
+    virtual void onEnter() override;
+    virtual void onExit() override;
+    virtual void update(float dt) override;
+
+protected:
+    void startStreams(float dt);
+    void finishStreams();
+
+    cocos2d::Label* _resultLabel = nullptr;
+    std::string _filePath;
+    std::vector<int> _audioIDs;
+    int _seeks = 0;
+    unsigned int _seed = 0;
+    float _nextSeek = 0;
+    std::clock_t _cpuBegin = 0;
+    std::chrono::steady_clock::time_point _begin;
+};
+
+/**
+ Plays 600 short effects, one per frame, a few much more often than the others,
+ without and with a cache budget, and reports the cache statistics and the longest play2d().
+ */
+class AudioCacheBudgetTest : public TestCase
+{
+public:
+    CREATE_FUNC(AudioCacheBudgetTest);
+
+    virtual std::string title() const override;
+    virtual std::string subtitle() const override;
+    virtual void onEnter() override;
+    virtual void onExit() override;
+    virtual void update(float dt) override;
+
+protected:
+    void startMode(float dt);
+    void finishMode();
+
+    cocos2d::Label* _resultLabel = nullptr;
+    std::string _results;
+    std::vector<std::string> _filePaths;
+    size_t _budget = 0;
+    size_t _budgetBefore = 0;
+    int _plays = 0;
+    unsigned int _seed = 0;
+    size_t _peakPcmBytes = 0;
+    float _worstPlayMs = 0;
+};
+
+/**
+ Preloads 200 generated effects of 4 WAV formats with AudioEngine::preloadBatch(), format by format with and
+ without the SIMD sample converters, then all of them at once, and reports the wall time and the MB/s of WAV decoded.
+ */
+class AudioPreloadBenchmarkTest : public TestCase
+{
+public:
+    CREATE_FUNC(AudioPreloadBenchmarkTest);
+
+    virtual std::string title() const override;
+    virtual std::string subtitle() const override;
+    virtual void onEnter() override;
+    virtual void onExit() override;
+
+protected:
+    void startStep(float dt);
+    void finishStep(bool allSucceeded);
+
+    cocos2d::Label* _resultLabel = nullptr;
+    std::string _results;
+    std::vector<std::string> _filePaths;
+    std::vector<size_t> _formatBytes;
+    int _step = 0;
+    bool _simdBefore = true;
+    std::chrono::steady_clock::time_point _begin;
+};
+
+#endif //__PERFORMANCE_AUDIO_TEST_H__
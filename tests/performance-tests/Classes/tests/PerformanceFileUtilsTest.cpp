@@ -0,0 +1,736 @@
+/****************************************************************************
+ Copyright (c) 2020 c4games.com.
+
+ http://www.cocos2d-x.org
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+
+#include "PerformanceFileUtilsTest.h"
+#include "Profile.h"
+#include "unzip/unzip.h"
+#include <zlib.h>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <unordered_map>
+
+USING_NS_CC;
+
+PerformceFileUtilsTests::PerformceFileUtilsTests()
+{
+    ADD_TEST_CASE(AssetPackLoadTest);
+    ADD_TEST_CASE(ZipFileReadTest);
+    ADD_TEST_CASE(FullPathLookupTest);
+    ADD_TEST_CASE(PlistLoadTest);
+}
+
+////////////////////////////////////////////////////////
+//
+// AssetPackLoadTest
+//
+////////////////////////////////////////////////////////
+static const int kPackFileCount = 5000;
+static const int kPackFilesPerDir = 100;
+
+static std::string packFileName(int index)
+{
+    return StringUtils::format("d%02d/f%04d.bin", index / kPackFilesPerDir, index);
+}
+
+void AssetPackLoadTest::onEnter()
+{
+    TestCase::onEnter();
+
+    auto s = Director::getInstance()->getWinSize();
+    _resultLabel = Label::createWithTTF("Writing files...", "fonts/arial.ttf", 12);
+    _resultLabel->setPosition(Vec2(s.width / 2, s.height / 2));
+    addChild(_resultLabel);
+
+    // the label shows up first, writing and reading the files blocks for a while
+    scheduleOnce(CC_SCHEDULE_SELECTOR(AssetPackLoadTest::runBenchmark), 0.1f);
+}
+
+void AssetPackLoadTest::onExit()
+{
+    auto fs = FileUtils::getInstance();
+    if (!_storedPack.empty())
+    {
+        fs->unmountAssetPack(_storedPack);
+        fs->unmountAssetPack(_deflatedPack);
+        fs->removeFile(_storedPack);
+        fs->removeFile(_deflatedPack);
+        fs->removeDirectory(_looseDir);
+    }
+
+    TestCase::onExit();
+}
+
+void AssetPackLoadTest::runBenchmark(float /*dt*/)
+{
+    auto fs = FileUtils::getInstance();
+    _looseDir = fs->getWritablePath() + "asset-pack-test/";
+    _storedPack = fs->getWritablePath() + "asset-pack-test-stored.pack";
+    _deflatedPack = fs->getWritablePath() + "asset-pack-test-deflated.pack";
+
+    // small files of 64 bytes to 4 KB, with some redundancy so that deflating them pays off
+    std::vector<AssetPack::Source> sources;
+    srand(0);
+    for (int index = 0; index < kPackFileCount; ++index)
+    {
+        if (index % kPackFilesPerDir == 0)
+            fs->createDirectory(_looseDir + StringUtils::format("d%02d", index / kPackFilesPerDir));
+
+        std::string contents(64 + rand() % 4033, '\0');
+        for (auto& c : contents)
+            c = static_cast<char>('a' + rand() % 16);
+
+        std::string name = packFileName(index);
+        fs->writeStringToFile(contents, _looseDir + name);
+        sources.push_back({name, _looseDir + name});
+    }
+
+    if (!AssetPack::write(_storedPack, sources, false) || !AssetPack::write(_deflatedPack, sources, true))
+    {
+        _resultLabel->setString("Failed to write the packs");
+        return;
+    }
+
+    struct Variant
+    {
+        const char* name;
+        std::string prefix;
+        bool view;
+    };
+    const Variant variants[] = {
+        { "loose files", _looseDir, false },
+        { "stored pack", _storedPack + "/", false },
+        { "stored pack, views", _storedPack + "/", true },
+        { "deflated pack", _deflatedPack + "/", false },
+    };
+
+    fs->mountAssetPack(_storedPack);
+    fs->mountAssetPack(_deflatedPack);
+
+    if (isAutoTesting())
+    {
+        Profile::getInstance()->testCaseBegin("AssetPackLoadTest",
+                                              genStrVector("Source", nullptr),
+                                              genStrVector("Time", "Per file", nullptr));
+    }
+
+    // the loose files were just written, so all variants read from a warm cache
+    std::string results;
+    for (const auto& variant : variants)
+    {
+        size_t bytes = 0;
+        auto begin = std::chrono::steady_clock::now();
+        for (int index = 0; index < kPackFileCount; ++index)
+        {
+            std::string path = variant.prefix + packFileName(index);
+            if (variant.view)
+            {
+                bytes += fs->getContentsView(path).size();
+            }
+            else
+            {
+                Data data = fs->getDataFromFile(path);
+                bytes += data.getSize();
+            }
+        }
+        float ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - begin).count();
+        float usPerFile = ms * 1000.0f / kPackFileCount;
+
+        log("%s: %.2f ms, %.2f us per file, %d bytes", variant.name, ms, usPerFile, static_cast<int>(bytes));
+        results += StringUtils::format("%s: %.1f ms, %.2f us per file\n", variant.name, ms, usPerFile);
+
+        if (isAutoTesting())
+            Profile::getInstance()->addTestResult(genStrVector(variant.name, nullptr),
+                                                  genStrVector(genStr("%.2fms", ms).c_str(), genStr("%.2fus", usPerFile).c_str(), nullptr));
+    }
+    _resultLabel->setString(results);
+
+    if (isAutoTesting())
+    {
+        Profile::getInstance()->testCaseEnd();
+        setAutoTesting(false);
+    }
+}
+
+std::string AssetPackLoadTest::title() const
+{
+    return "Asset Pack Load Test";
+}
+
+std::string AssetPackLoadTest::subtitle() const
+{
+    return StringUtils::format("Reads %d small files, loose and from packs", kPackFileCount);
+}
+
+////////////////////////////////////////////////////////
+//
+// ZipFileReadTest
+//
+////////////////////////////////////////////////////////
+static const int kZipFileCount = 2000;
+static const int kZipReaderCounts[] = { 1, 4, 8 };
+
+static void appendLE(std::string& out, uint32_t value, int bytes)
+{
+    for (int i = 0; i < bytes; ++i)
+        out.push_back(static_cast<char>((value >> (i * 8)) & 0xff));
+}
+
+// writes a zip of small files, every other one deflated
+static bool writeBenchmarkZip(const std::string& path, std::vector<std::string>* names)
+{
+    std::string archive;
+    std::string centralDir;
+    srand(0);
+    for (int index = 0; index < kZipFileCount; ++index)
+    {
+        std::string name = StringUtils::format("dir%02d/file%04d.bin", index / 100, index);
+        std::string contents(256 + rand() % 8192, '\0');
+        for (auto& c : contents)
+            c = static_cast<char>('a' + rand() % 16);
+
+        uint16_t method = index % 2 ? 8 : 0;
+        std::string stored = contents;
+        if (method == 8)
+        {
+            z_stream stream = { 0 };
+            deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY);
+            stored.resize(deflateBound(&stream, static_cast<uLong>(contents.size())));
+            stream.next_in = reinterpret_cast<Bytef*>(&contents[0]);
+            stream.avail_in = static_cast<uInt>(contents.size());
+            stream.next_out = reinterpret_cast<Bytef*>(&stored[0]);
+            stream.avail_out = static_cast<uInt>(stored.size());
+            deflate(&stream, Z_FINISH);
+            stored.resize(stream.total_out);
+            deflateEnd(&stream);
+        }
+        uint32_t crc = static_cast<uint32_t>(crc32(0, reinterpret_cast<const Bytef*>(contents.data()), static_cast<uInt>(contents.size())));
+        uint32_t localHeaderOffset = static_cast<uint32_t>(archive.size());
+
+        // local header, then the central directory record
+        appendLE(archive, 0x04034b50, 4);
+        appendLE(archive, 20, 2);
+        appendLE(archive, 0, 2);
+        appendLE(archive, method, 2);
+        appendLE(archive, 0, 4);
+        appendLE(archive, crc, 4);
+        appendLE(archive, static_cast<uint32_t>(stored.size()), 4);
+        appendLE(archive, static_cast<uint32_t>(contents.size()), 4);
+        appendLE(archive, static_cast<uint32_t>(name.size()), 2);
+        appendLE(archive, 0, 2);
+        archive += name;
+        archive += stored;
+
+        appendLE(centralDir, 0x02014b50, 4);
+        appendLE(centralDir, 20, 2);
+        appendLE(centralDir, 20, 2);
+        appendLE(centralDir, 0, 2);
+        appendLE(centralDir, method, 2);
+        appendLE(centralDir, 0, 4);
+        appendLE(centralDir, crc, 4);
+        appendLE(centralDir, static_cast<uint32_t>(stored.size()), 4);
+        appendLE(centralDir, static_cast<uint32_t>(contents.size()), 4);
+        appendLE(centralDir, static_cast<uint32_t>(name.size()), 2);
+        appendLE(centralDir, 0, 4);
+        appendLE(centralDir, 0, 4);
+        appendLE(centralDir, 0, 4);
+        appendLE(centralDir, localHeaderOffset, 4);
+        centralDir += name;
+
+        names->push_back(name);
+    }
+
+    uint32_t centralDirOffset = static_cast<uint32_t>(archive.size());
+    archive += centralDir;
+    appendLE(archive, 0x06054b50, 4);
+    appendLE(archive, 0, 4);
+    appendLE(archive, kZipFileCount, 2);
+    appendLE(archive, kZipFileCount, 2);
+    appendLE(archive, static_cast<uint32_t>(centralDir.size()), 4);
+    appendLE(archive, centralDirOffset, 4);
+    appendLE(archive, 0, 2);
+
+    return FileUtils::getInstance()->writeStringToFile(archive, path);
+}
+
+// how ZipFile used to read: minizip keeps the current file in its state, so all readers share one lock
+class LockedMinizipReader
+{
+public:
+    explicit LockedMinizipReader(const std::string& path)
+    {
+        _zipFile = unzOpen(path.c_str());
+        if (!_zipFile)
+            return;
+
+        char name[256];
+        int err = unzGoToFirstFile(_zipFile);
+        while (err == UNZ_OK)
+        {
+            unz_file_info info;
+            unz_file_pos pos;
+            if (unzGetCurrentFileInfo(_zipFile, &info, name, sizeof(name), nullptr, 0, nullptr, 0) == UNZ_OK
+                && unzGetFilePos(_zipFile, &pos) == UNZ_OK)
+            {
+                _entries[name] = std::make_pair(pos, static_cast<size_t>(info.uncompressed_size));
+            }
+            err = unzGoToNextFile(_zipFile);
+        }
+    }
+
+    ~LockedMinizipReader()
+    {
+        if (_zipFile)
+            unzClose(_zipFile);
+    }
+
+    size_t read(const std::string& name, std::vector<unsigned char>* buffer)
+    {
+        auto it = _entries.find(name);
+        if (it == _entries.end())
+            return 0;
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (unzGoToFilePos(_zipFile, &it->second.first) != UNZ_OK || unzOpenCurrentFile(_zipFile) != UNZ_OK)
+            return 0;
+        buffer->resize(it->second.second);
+        int size = unzReadCurrentFile(_zipFile, buffer->data(), static_cast<unsigned int>(buffer->size()));
+        unzCloseCurrentFile(_zipFile);
+        return size > 0 ? static_cast<size_t>(size) : 0;
+    }
+
+private:
+    unzFile _zipFile = nullptr;
+    std::mutex _mutex;
+    std::unordered_map<std::string, std::pair<unz_file_pos, size_t>> _entries;
+};
+
+void ZipFileReadTest::onEnter()
+{
+    TestCase::onEnter();
+
+    auto s = Director::getInstance()->getWinSize();
+    _resultLabel = Label::createWithTTF("Writing zip...", "fonts/arial.ttf", 12);
+    _resultLabel->setPosition(Vec2(s.width / 2, s.height / 2));
+    addChild(_resultLabel);
+
+    scheduleOnce(CC_SCHEDULE_SELECTOR(ZipFileReadTest::runBenchmark), 0.1f);
+}
+
+void ZipFileReadTest::onExit()
+{
+    if (!_zipPath.empty())
+        FileUtils::getInstance()->removeFile(_zipPath);
+
+    TestCase::onExit();
+}
+
+void ZipFileReadTest::runBenchmark(float /*dt*/)
+{
+    _zipPath = FileUtils::getInstance()->getWritablePath() + "zip-read-test.zip";
+    std::vector<std::string> names;
+    if (!writeBenchmarkZip(_zipPath, &names))
+    {
+        _resultLabel->setString("Failed to write the zip file");
+        return;
+    }
+
+    ZipFile zipFile(_zipPath);
+    LockedMinizipReader minizip(_zipPath);
+
+    typedef std::function<size_t(const std::string& name, std::vector<unsigned char>* buffer)> Reader;
+    struct Implementation
+    {
+        const char* name;
+        Reader read;
+    };
+    const Implementation implementations[] = {
+        { "minizip, locked", [&](const std::string& name, std::vector<unsigned char>* buffer) {
+            return minizip.read(name, buffer);
+        } },
+        { "ZipFile", [&](const std::string& name, std::vector<unsigned char>* /*buffer*/) {
+            ssize_t size = 0;
+            free(zipFile.getFileData(name, &size));
+            return static_cast<size_t>(size);
+        } },
+    };
+
+    if (isAutoTesting())
+    {
+        Profile::getInstance()->testCaseBegin("ZipFileReadTest",
+                                              genStrVector("Implementation", "Readers", nullptr),
+                                              genStrVector("Time", "Speed", nullptr));
+    }
+
+    // every reader reads all files, so the work grows with the readers and the time shows how well they overlap
+    std::string results;
+    for (const auto& implementation : implementations)
+    {
+        results += implementation.name;
+        for (int readers : kZipReaderCounts)
+        {
+            std::atomic<size_t> bytes(0);
+            auto begin = std::chrono::steady_clock::now();
+            std::vector<std::thread> threads;
+            for (int reader = 0; reader < readers; ++reader)
+            {
+                threads.emplace_back([&, reader]() {
+                    std::vector<unsigned char> buffer;
+                    size_t readerBytes = 0;
+                    for (size_t index = 0; index < names.size(); ++index)
+                        readerBytes += implementation.read(names[(index + reader * 97) % names.size()], &buffer);
+                    bytes += readerBytes;
+                });
+            }
+            for (auto& thread : threads)
+                thread.join();
+            float ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - begin).count();
+            float mbPerSecond = bytes / (ms * 1000.0f);
+
+            log("%s, %d readers: %.2f ms, %.1f MB/s", implementation.name, readers, ms, mbPerSecond);
+            results += StringUtils::format("  %d: %.1f ms", readers, ms);
+
+            if (isAutoTesting())
+                Profile::getInstance()->addTestResult(genStrVector(implementation.name, genStr("%d", readers).c_str(), nullptr),
+                                                      genStrVector(genStr("%.2fms", ms).c_str(), genStr("%.1fMB/s", mbPerSecond).c_str(), nullptr));
+        }
+        results += "\n";
+    }
+    _resultLabel->setString(results);
+
+    if (isAutoTesting())
+    {
+        Profile::getInstance()->testCaseEnd();
+        setAutoTesting(false);
+    }
+}
+
+std::string ZipFileReadTest::title() const
+{
+    return "ZipFile Read Test";
+}
+
+std::string ZipFileReadTest::subtitle() const
+{
+    return StringUtils::format("Every reader reads all %d files of a zip", kZipFileCount);
+}
+
+////////////////////////////////////////////////////////
+//
+// FullPathLookupTest
+//
+////////////////////////////////////////////////////////
+static const int kLookupSearchPaths = 10;
+static const int kLookupFilesPerPath = 50;
+static const int kLookupMissingFiles = 50;
+static const int kLookupPasses = 5;
+static const int kLookupThreads = 4;
+
+void FullPathLookupTest::onEnter()
+{
+    TestCase::onEnter();
+
+    auto s = Director::getInstance()->getWinSize();
+    _resultLabel = Label::createWithTTF("Writing files...", "fonts/arial.ttf", 12);
+    _resultLabel->setPosition(Vec2(s.width / 2, s.height / 2));
+    addChild(_resultLabel);
+
+    scheduleOnce(CC_SCHEDULE_SELECTOR(FullPathLookupTest::runBenchmark), 0.1f);
+}
+
+void FullPathLookupTest::onExit()
+{
+    auto fs = FileUtils::getInstance();
+    if (!_lookupDir.empty())
+    {
+        fs->clearFileIndex();
+        fs->setSearchPaths(_defaultSearchPaths);
+        fs->removeDirectory(_lookupDir);
+    }
+
+    TestCase::onExit();
+}
+
+void FullPathLookupTest::runBenchmark(float /*dt*/)
+{
+    auto fs = FileUtils::getInstance();
+    _lookupDir = fs->getWritablePath() + "lookup-test/";
+    _defaultSearchPaths = fs->getOriginalSearchPaths();
+
+    // every search path has its own files, so most lookups miss in several search paths first
+    std::vector<std::string> searchPaths;
+    std::vector<std::string> names;
+    for (int path = 0; path < kLookupSearchPaths; ++path)
+    {
+        std::string dir = _lookupDir + StringUtils::format("path%d/", path);
+        fs->createDirectory(dir);
+        searchPaths.push_back(dir);
+        for (int file = 0; file < kLookupFilesPerPath; ++file)
+        {
+            std::string name = StringUtils::format("file%d_%d.png", path, file);
+            fs->writeStringToFile("lookup", dir + name);
+            names.push_back(name);
+        }
+    }
+    for (int file = 0; file < kLookupMissingFiles; ++file)
+    {
+        names.push_back(StringUtils::format("missing%d.png", file));
+    }
+    searchPaths.insert(searchPaths.end(), _defaultSearchPaths.begin(), _defaultSearchPaths.end());
+    fs->setSearchPaths(searchPaths);
+
+    bool popupNotify = fs->isPopupNotify();
+    fs->setPopupNotify(false);
+
+    struct Variant
+    {
+        const char* name;
+        bool index;
+        bool coldCache;
+        int threads;
+    };
+    const Variant variants[] = {
+        { "file system, cold cache", false, true, 1 },
+        { "file system, warm cache", false, false, 1 },
+        { "file index, cold cache", true, true, 1 },
+        { "file index, warm cache", true, false, 1 },
+        { "file index, warm cache, 4 threads", true, false, kLookupThreads },
+    };
+
+    if (isAutoTesting())
+    {
+        Profile::getInstance()->testCaseBegin("FullPathLookupTest",
+                                              genStrVector("Variant", nullptr),
+                                              genStrVector("Lookups", nullptr));
+    }
+
+    std::string results;
+    for (const auto& variant : variants)
+    {
+        if (variant.index)
+        {
+            auto begin = std::chrono::steady_clock::now();
+            fs->buildFileIndex();
+            float ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - begin).count();
+            log("buildFileIndex: %.2f ms", ms);
+        }
+        else
+        {
+            fs->clearFileIndex();
+        }
+
+        // warm the cache up, or start from an empty one on every pass
+        fs->purgeCachedEntries();
+        if (!variant.coldCache)
+        {
+            for (const auto& name : names)
+                fs->fullPathForFilename(name);
+        }
+
+        auto begin = std::chrono::steady_clock::now();
+        std::vector<std::thread> threads;
+        for (int thread = 1; thread < variant.threads; ++thread)
+        {
+            threads.emplace_back([&]() {
+                for (int pass = 0; pass < kLookupPasses; ++pass)
+                    for (const auto& name : names)
+                        fs->fullPathForFilename(name);
+            });
+        }
+        for (int pass = 0; pass < kLookupPasses; ++pass)
+        {
+            if (variant.coldCache)
+                fs->purgeCachedEntries();
+            for (const auto& name : names)
+                fs->fullPathForFilename(name);
+        }
+        for (auto& thread : threads)
+            thread.join();
+        float ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - begin).count();
+        float lookupsPerSecond = names.size() * kLookupPasses * variant.threads / (ms / 1000.0f);
+
+        log("%s: %.2f ms, %.0f lookups/s", variant.name, ms, lookupsPerSecond);
+        results += StringUtils::format("%s: %.0f lookups/s\n", variant.name, lookupsPerSecond);
+
+        if (isAutoTesting())
+            Profile::getInstance()->addTestResult(genStrVector(variant.name, nullptr),
+                                                  genStrVector(genStr("%.0f/s", lookupsPerSecond).c_str(), nullptr));
+    }
+    _resultLabel->setString(results);
+
+    fs->setPopupNotify(popupNotify);
+
+    if (isAutoTesting())
+    {
+        Profile::getInstance()->testCaseEnd();
+        setAutoTesting(false);
+    }
+}
+
+std::string FullPathLookupTest::title() const
+{
+    return "Full Path Lookup Test";
+}
+
+std::string FullPathLookupTest::subtitle() const
+{
+    return StringUtils::format("fullPathForFilename() of %d files in %d search paths",
+                               kLookupSearchPaths * kLookupFilesPerPath + kLookupMissingFiles, kLookupSearchPaths);
+}
+
+////////////////////////////////////////////////////////
+//
+// PlistLoadTest
+//
+////////////////////////////////////////////////////////
+static const int kPlistCount = 100;
+static const int kPlistFrames = 500;
+
+// a sprite sheet like the ones TexturePacker writes
+static ValueMap makeSpriteSheet(int sheet)
+{
+    ValueMap frames;
+    for (int frame = 0; frame < kPlistFrames; ++frame)
+    {
+        int x = (frame % 32) * 64, y = (frame / 32) * 64;
+        ValueMap info;
+        info["frame"] = StringUtils::format("{{%d,%d},{60,58}}", x, y);
+        info["offset"] = "{1,-2}";
+        info["rotated"] = frame % 3 == 0;
+        info["sourceColorRect"] = "{{3,1},{60,58}}";
+        info["sourceSize"] = "{64,64}";
+        frames[StringUtils::format("sheet%d/frame%04d.png", sheet, frame)] = Value(std::move(info));
+    }
+
+    ValueMap metadata;
+    metadata["format"] = 2;
+    metadata["realTextureFileName"] = StringUtils::format("sheet%d.png", sheet);
+    metadata["size"] = "{2048,1024}";
+    metadata["textureFileName"] = StringUtils::format("sheet%d.png", sheet);
+
+    ValueMap dict;
+    dict["frames"] = Value(std::move(frames));
+    dict["metadata"] = Value(std::move(metadata));
+    return dict;
+}
+
+void PlistLoadTest::onEnter()
+{
+    TestCase::onEnter();
+
+    auto s = Director::getInstance()->getWinSize();
+    _resultLabel = Label::createWithTTF("Writing plists...", "fonts/arial.ttf", 12);
+    _resultLabel->setPosition(Vec2(s.width / 2, s.height / 2));
+    addChild(_resultLabel);
+
+    scheduleOnce(CC_SCHEDULE_SELECTOR(PlistLoadTest::runBenchmark), 0.1f);
+}
+
+void PlistLoadTest::onExit()
+{
+    if (!_plistDir.empty())
+        FileUtils::getInstance()->removeDirectory(_plistDir);
+
+    TestCase::onExit();
+}
+
+void PlistLoadTest::runBenchmark(float /*dt*/)
+{
+    auto fs = FileUtils::getInstance();
+    _plistDir = fs->getWritablePath() + "plist-test/";
+    fs->removeDirectory(_plistDir);
+    fs->createDirectory(_plistDir);
+
+    std::vector<std::string> plists;
+    int64_t xmlBytes = 0;
+    for (int sheet = 0; sheet < kPlistCount; ++sheet)
+    {
+        std::string path = _plistDir + StringUtils::format("sheet%d.plist", sheet);
+        fs->writeValueMapToFile(makeSpriteSheet(sheet), path);
+        xmlBytes += fs->getFileSize(path);
+        plists.push_back(path);
+    }
+
+    // the XML pass mustn't be served by the plist cache
+    std::string cacheDirectory = fs->getPlistCacheDirectory();
+    fs->setPlistCacheDirectory("");
+
+    auto loadAll = [&]() {
+        size_t frames = 0;
+        auto begin = std::chrono::steady_clock::now();
+        for (const auto& path : plists)
+        {
+            ValueMap dict = fs->getValueMapFromFile(path);
+            frames += dict["frames"].asValueMap().size();
+        }
+        float ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - begin).count();
+        CCASSERT(frames == static_cast<size_t>(kPlistCount * kPlistFrames), "a plist wasn't loaded");
+        return ms;
+    };
+
+    float xmlMs = loadAll();
+
+    auto begin = std::chrono::steady_clock::now();
+    int64_t binaryBytes = 0;
+    for (const auto& path : plists)
+    {
+        std::string compiledPath = FileUtils::getCompiledPlistPath(path);
+        fs->writeDataToFile(BinaryValue::encode(fs->getValueMapFromFile(path)), compiledPath);
+        binaryBytes += fs->getFileSize(compiledPath);
+    }
+    float compileMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - begin).count();
+
+    float binaryMs = loadAll();
+    fs->setPlistCacheDirectory(cacheDirectory);
+
+    log("PlistLoadTest: XML %.2f ms (%lld bytes), compiled %.2f ms (%lld bytes), compiling took %.2f ms", xmlMs,
+        static_cast<long long>(xmlBytes), binaryMs, static_cast<long long>(binaryBytes), compileMs);
+    _resultLabel->setString(StringUtils::format("XML plists: %.1f ms, %lld KB\ncompiled plists: %.1f ms, %lld KB\nspeedup: %.1fx",
+                                                xmlMs, static_cast<long long>(xmlBytes / 1024), binaryMs,
+                                                static_cast<long long>(binaryBytes / 1024), xmlMs / binaryMs));
+
+    if (isAutoTesting())
+    {
+        Profile::getInstance()->testCaseBegin("PlistLoadTest",
+                                              genStrVector("Format", nullptr),
+                                              genStrVector("Time(ms)", "Size(KB)", nullptr));
+        Profile::getInstance()->addTestResult(genStrVector("XML", nullptr),
+                                              genStrVector(genStr("%.2f", xmlMs).c_str(), genStr("%lld", static_cast<long long>(xmlBytes / 1024)).c_str(), nullptr));
+        Profile::getInstance()->addTestResult(genStrVector("compiled", nullptr),
+                                              genStrVector(genStr("%.2f", binaryMs).c_str(), genStr("%lld", static_cast<long long>(binaryBytes / 1024)).c_str(), nullptr));
+        Profile::getInstance()->testCaseEnd();
+        setAutoTesting(false);
+    }
+}
+
+std::string PlistLoadTest::title() const
+{
+    return "Plist Load Test";
+}
+
+std::string PlistLoadTest::subtitle() const
+{
+    return StringUtils::format("%d sprite sheet plists of %d frames, XML vs compiled", kPlistCount, kPlistFrames);
+}
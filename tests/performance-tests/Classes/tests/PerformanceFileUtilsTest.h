@@ -0,0 +1,116 @@
+/****************************************************************************
+ Copyright (c) 2020 c4games.com.
+
+ http://www.cocos2d-x.org
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+
+#ifndef __PERFORMANCE_FILEUTILS_TEST_H__
+#define __PERFORMANCE_FILEUTILS_TEST_H__
+
+#include "BaseTest.h"
+
+DEFINE_TEST_SUITE(PerformceFileUtilsTests);
+
+/**
+ Reads thousands of small files one by one, as loose files and from mounted asset packs, stored and deflated.
+ */
+class AssetPackLoadTest : public TestCase
+{
+public:
+    CREATE_FUNC(AssetPackLoadTest);
+
+    virtual std::string title() const override;
+    virtual std::string subtitle() const override;
+    virtual void onEnter() override;
+    virtual void onExit() override;
+
+protected:
+    void runBenchmark(float dt);
+
+    cocos2d::Label* _resultLabel = nullptr;
+    std::string _looseDir;
+    std::string _storedPack;
+    std::string _deflatedPack;
+};
+
+/**
+ Reads the files of a zip archive on 1, 4 and 8 threads at once, through ZipFile and through minizip
+ behind a lock like ZipFile did before.
+ */
+class ZipFileReadTest : public TestCase
+{
+public:
+    CREATE_FUNC(ZipFileReadTest);
+
+    virtual std::string title() const override;
+    virtual std::string subtitle() const override;
+    virtual void onEnter() override;
+    virtual void onExit() override;
+
+protected:
+    void runBenchmark(float dt);
+
+    cocos2d::Label* _resultLabel = nullptr;
+    std::string _zipPath;
+};
+
+/**
+ Looks files up in 10 search paths with cold and warm path caches, through the file system and through the file index.
+ */
+class FullPathLookupTest : public TestCase
+{
+public:
+    CREATE_FUNC(FullPathLookupTest);
+
+    virtual std::string title() const override;
+    virtual std::string subtitle() const override;
+    virtual void onEnter() override;
+    virtual void onExit() override;
+
+protected:
+    void runBenchmark(float dt);
+
+    cocos2d::Label* _resultLabel = nullptr;
+    std::string _lookupDir;
+    std::vector<std::string> _defaultSearchPaths;
+};
+
+/**
+ Loads 100 large sprite sheet plists through FileUtils::getValueMapFromFile(), parsing the XML and reading compiled copies.
+ */
+class PlistLoadTest : public TestCase
+{
+public:
+    CREATE_FUNC(PlistLoadTest);
+
+    virtual std::string title() const override;
+    virtual std::string subtitle() const override;
+    virtual void onEnter() override;
+    virtual void onExit() override;
+
+protected:
+    void runBenchmark(float dt);
+
+    cocos2d::Label* _resultLabel = nullptr;
+    std::string _plistDir;
+};
+
+#endif //__PERFORMANCE_FILEUTILS_TEST_H__
@@ -69,6 +69,8 @@ PerformceNodeChildrenTests::PerformceNodeChildrenTests()
 //    ADD_TEST_CASE(ReorderSpriteSheet);
 //    ADD_TEST_CASE(SortAllChildrenSpriteSheet);
     ADD_TEST_CASE(VisitSceneGraph);
+    ADD_TEST_CASE(TransformPassSerial);
+    ADD_TEST_CASE(TransformPassThreaded);
 }
 
 enum {
@@ -1004,3 +1006,109 @@ const char*  VisitSceneGraph::testName()
 {
     return "visit()";
 }
+
+////////////////////////////////////////////////////////
+//
+// TransformPassSceneGraph
+//
+////////////////////////////////////////////////////////
+static const int kTransformSubtreeChildren = 9;
+
+void TransformPassSceneGraph::updateQuantityOfNodes()
+{
+    // increase nodes
+    if( currentQuantityOfNodes < quantityOfNodes )
+    {
+        for(int i = 0; i < (quantityOfNodes-currentQuantityOfNodes); i++)
+        {
+            auto node = Node::create();
+            node->setPosition(Vec2(-1000,-1000));
+            for (int j = 0; j < kTransformSubtreeChildren; j++)
+            {
+                auto child = Node::create();
+                child->setPosition(Vec2(j * 10.0f, j * 5.0f));
+                child->setRotation(j * 10.0f);
+                child->setScale(1.0f + j * 0.1f);
+                node->addChild(child);
+            }
+            this->addChild(node);
+            node->setTag(1000 + currentQuantityOfNodes + i );
+        }
+    }
+
+    // decrease nodes
+    else if ( currentQuantityOfNodes > quantityOfNodes )
+    {
+        for(int i = 0; i < (currentQuantityOfNodes-quantityOfNodes); i++)
+        {
+            this->removeChildByTag(1000 + currentQuantityOfNodes - i -1 );
+        }
+    }
+
+    currentQuantityOfNodes = quantityOfNodes;
+}
+
+void TransformPassSceneGraph::update(float dt)
+{
+    // rotating the roots of the subtrees makes every transform dirty
+    _angle += 1.0f;
+    for (int i = 0; i < currentQuantityOfNodes; i++)
+    {
+        auto node = this->getChildByTag(1000 + i);
+        if (node)
+            node->setRotation(_angle);
+    }
+
+    auto director = Director::getInstance();
+    int threads = getTransformThreads();
+
+    CC_PROFILER_START( this->profilerName() );
+    if (threads > 1)
+        this->updateTransforms(director->getMatrix(MATRIX_STACK_TYPE::MATRIX_STACK_MODELVIEW), Node::FLAGS_TRANSFORM_DIRTY, threads);
+    this->visit();
+    CC_PROFILER_STOP( this->profilerName() );
+
+    // Call `Renderer::clean` to prevent crash if current scene is destroyed.
+    // The render commands associated with current scene should be cleaned.
+    director->getRenderer()->clean();
+}
+
+std::string TransformPassSceneGraph::title() const
+{
+    return "Performance of the transform pass";
+}
+
+////////////////////////////////////////////////////////
+//
+// TransformPassSerial
+//
+////////////////////////////////////////////////////////
+std::string TransformPassSerial::subtitle() const
+{
+    return "10 dirty nodes per node, updated by visit(). See console";
+}
+
+const char*  TransformPassSerial::testName()
+{
+    return "visit() serial transforms";
+}
+
+////////////////////////////////////////////////////////
+//
+// TransformPassThreaded
+//
+////////////////////////////////////////////////////////
+int TransformPassThreaded::getTransformThreads() const
+{
+    return ParallelTaskPool::getInstance()->getThreadCount();
+}
+
+std::string TransformPassThreaded::subtitle() const
+{
+    return "10 dirty nodes per node, updateTransforms() on all threads, then visit(). See console";
+}
+
+const char*  TransformPassThreaded::testName()
+{
+    return "visit() threaded transforms";
+}
@@ -242,4 +242,45 @@ public:
     virtual const char* testName() override;
 };
 
+/**
+ Visits a scene graph whose transforms are all dirty, each node of the quantity is a subtree of 10 nodes.
+ The subclasses update the transforms on the calling thread or on the ParallelTaskPool first.
+ */
+class TransformPassSceneGraph : public VisitSceneGraph
+{
+public:
+    virtual void update(float dt) override;
+    void updateQuantityOfNodes() override;
+    virtual std::string title() const override;
+
+protected:
+    virtual int getTransformThreads() const = 0;
+
+    float _angle = 0;
+};
+
+class TransformPassSerial : public TransformPassSceneGraph
+{
+public:
+    CREATE_FUNC(TransformPassSerial);
+
+    virtual std::string subtitle() const override;
+    virtual const char* testName() override;
+
+protected:
+    virtual int getTransformThreads() const override { return 1; }
+};
+
+class TransformPassThreaded : public TransformPassSceneGraph
+{
+public:
+    CREATE_FUNC(TransformPassThreaded);
+
+    virtual std::string subtitle() const override;
+    virtual const char* testName() override;
+
+protected:
+    virtual int getTransformThreads() const override;
+};
+
 #endif // __PERFORMANCE_NODE_CHILDREN_TEST_H__
@@ -0,0 +1,621 @@
+/****************************************************************************
+ Copyright (c) 2020 c4games.com.
+
+ http://www.cocos2d-x.org
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+
+#include "PerformanceRendererTest.h"
+#include "Profile.h"
+#include "renderer/backend/Buffer.h"
+#include "renderer/backend/CommandBuffer.h"
+#include "renderer/backend/ProgramStateRegistry.h"
+
+USING_NS_CC;
+
+// Enable profiles for this file
+#undef CC_PROFILER_DISPLAY_TIMERS
+#define CC_PROFILER_DISPLAY_TIMERS() Profiler::getInstance()->displayTimers()
+#undef CC_PROFILER_PURGE_ALL
+#define CC_PROFILER_PURGE_ALL() Profiler::getInstance()->releaseAllTimers()
+
+#undef CC_PROFILER_START
+#define CC_PROFILER_START(__name__) ProfilingBeginTimingBlock(__name__)
+#undef CC_PROFILER_STOP
+#define CC_PROFILER_STOP(__name__) ProfilingEndTimingBlock(__name__)
+#undef CC_PROFILER_RESET
+#define CC_PROFILER_RESET(__name__) ProfilingResetTimingBlock(__name__)
+
+static const int kQuadCount = 30000;
+
+// Adds quantity sprites sharing one texture and blend mode, so they can all go into the same batch.
+static void addBatchableSprites(Node* parent, int quantity)
+{
+    auto s = Director::getInstance()->getWinSize();
+    std::srand(0);
+    for (int i = 0; i < quantity; ++i)
+    {
+        auto sprite = Sprite::create("Images/grossini_dance_01.png");
+        sprite->setPosition(Vec2(CCRANDOM_0_1() * s.width, CCRANDOM_0_1() * s.height));
+        sprite->setRotation(CCRANDOM_0_1() * 360);
+        sprite->setScale(0.25f);
+        parent->addChild(sprite);
+    }
+}
+
+PerformceRendererTests::PerformceRendererTests()
+{
+    ADD_TEST_CASE(VertexFillThreadsTest);
+    ADD_TEST_CASE(TrianglesIndexFormatTest);
+    ADD_TEST_CASE(MeshInstancingTest);
+    ADD_TEST_CASE(StreamingBufferTest);
+    ADD_TEST_CASE(StateChangesTest);
+    ADD_TEST_CASE(ProgramStateSharingTest);
+    ADD_TEST_CASE(RenderQueueSortTest);
+}
+
+////////////////////////////////////////////////////////
+//
+// PerformanceRendererScene
+//
+////////////////////////////////////////////////////////
+bool PerformanceRendererScene::init()
+{
+    if (!TestCase::init())
+        return false;
+
+    auto s = Director::getInstance()->getWinSize();
+
+    MenuItemFont::setFontSize(30);
+    auto menu = Menu::create();
+    for (int i = 0; i < getVariantCount(); ++i)
+    {
+        auto item = MenuItemFont::create(getVariantName(i), [this, i](Ref*) { switchVariant(i); });
+        item->setColor(Color3B(0,200,20));
+        menu->addChild(item);
+    }
+    menu->alignItemsHorizontally();
+    menu->setPosition(Vec2(s.width/2, s.height - 100));
+    addChild(menu, 1);
+
+    _infoLabel = Label::createWithTTF("", "fonts/arial.ttf", 20);
+    _infoLabel->setColor(Color3B(0,200,20));
+    _infoLabel->setPosition(Vec2(s.width/2, s.height - 130));
+    addChild(_infoLabel, 1);
+
+    return true;
+}
+
+void PerformanceRendererScene::onEnter()
+{
+    TestCase::onEnter();
+
+    // Renderer::render() runs between these two events
+    auto dispatcher = Director::getInstance()->getEventDispatcher();
+    _afterVisitListener = dispatcher->addCustomEventListener(Director::EVENT_AFTER_VISIT, [this](EventCustom*) {
+        if (_timeRender)
+            CC_PROFILER_START(_profilerName.c_str());
+    });
+    _afterDrawListener = dispatcher->addCustomEventListener(Director::EVENT_AFTER_DRAW, [this](EventCustom*) {
+        if (_timeRender)
+            CC_PROFILER_STOP(_profilerName.c_str());
+        updateInfoLabel();
+    });
+
+    if (isAutoTesting())
+    {
+        Profile::getInstance()->testCaseBegin(title() + " " + subtitle(),
+                                              genStrVector("Variant", nullptr),
+                                              genStrVector("Avg", "Min", "Max", "Batches", nullptr));
+    }
+
+    switchVariant(0);
+    schedule(CC_SCHEDULE_SELECTOR(PerformanceRendererScene::dumpProfilerInfo), 2.0f);
+}
+
+void PerformanceRendererScene::onExit()
+{
+    auto dispatcher = Director::getInstance()->getEventDispatcher();
+    dispatcher->removeEventListener(_afterVisitListener);
+    dispatcher->removeEventListener(_afterDrawListener);
+    _afterVisitListener = _afterDrawListener = nullptr;
+
+    restoreDefaults();
+    CC_PROFILER_PURGE_ALL();
+
+    TestCase::onExit();
+}
+
+void PerformanceRendererScene::switchVariant(int index)
+{
+    _variant = index;
+    _profilerName = getVariantName(index);
+    applyVariant(index);
+    CC_PROFILER_PURGE_ALL();
+}
+
+void PerformanceRendererScene::updateInfoLabel()
+{
+    auto renderer = Director::getInstance()->getRenderer();
+    _infoLabel->setString(StringUtils::format("%s: %d batches, %d vertices",
+                                              _profilerName.c_str(),
+                                              (int)renderer->getDrawnBatches(),
+                                              (int)renderer->getDrawnVertices()));
+}
+
+void PerformanceRendererScene::dumpProfilerInfo(float dt)
+{
+    CC_PROFILER_DISPLAY_TIMERS();
+
+    if (!isAutoTesting())
+        return;
+
+    auto timer = Profiler::getInstance()->_activeTimers.at(_profilerName);
+    if (timer)
+    {
+        auto batches = Director::getInstance()->getRenderer()->getDrawnBatches();
+        Profile::getInstance()->addTestResult(genStrVector(_profilerName.c_str(), nullptr),
+                                              genStrVector(genStr("%ldµ", timer->_averageTime2).c_str(),
+                                                           genStr("%ldµ", timer->minTime).c_str(),
+                                                           genStr("%ldµ", timer->maxTime).c_str(),
+                                                           genStr("%d", (int)batches).c_str(), nullptr));
+    }
+
+    if (_variant + 1 >= getVariantCount())
+    {
+        setAutoTesting(false);
+        Profile::getInstance()->testCaseEnd();
+    }
+    else
+    {
+        switchVariant(_variant + 1);
+    }
+}
+
+////////////////////////////////////////////////////////
+//
+// VertexFillThreadsTest
+//
+////////////////////////////////////////////////////////
+static const int s_fillThreads[] = { 1, 2, 4, 8 };
+
+bool VertexFillThreadsTest::init()
+{
+    if (!PerformanceRendererScene::init())
+        return false;
+
+    // everything is batched, so the vertex fill dominates
+    addBatchableSprites(this, kQuadCount);
+
+    return true;
+}
+
+std::string VertexFillThreadsTest::subtitle() const
+{
+    return StringUtils::format("%d quads, Renderer::setVertexFillThreads", kQuadCount);
+}
+
+int VertexFillThreadsTest::getVariantCount() const
+{
+    return sizeof(s_fillThreads) / sizeof(s_fillThreads[0]);
+}
+
+std::string VertexFillThreadsTest::getVariantName(int index) const
+{
+    return StringUtils::format("%d thread(s)", s_fillThreads[index]);
+}
+
+void VertexFillThreadsTest::applyVariant(int index)
+{
+    Director::getInstance()->getRenderer()->setVertexFillThreads(s_fillThreads[index]);
+}
+
+void VertexFillThreadsTest::restoreDefaults()
+{
+    Director::getInstance()->getRenderer()->setVertexFillThreads(1);
+}
+
+////////////////////////////////////////////////////////
+//
+// TrianglesIndexFormatTest
+//
+////////////////////////////////////////////////////////
+static const int kLargeBatchQuadCount = 60000;
+
+bool TrianglesIndexFormatTest::init()
+{
+    if (!PerformanceRendererScene::init())
+        return false;
+
+    // 240000 vertices: 4 flushes with 16 bit indices, 1 with 32 bit indices
+    addBatchableSprites(this, kLargeBatchQuadCount);
+
+    return true;
+}
+
+std::string TrianglesIndexFormatTest::subtitle() const
+{
+    return StringUtils::format("%d quads, Renderer::setTrianglesBatchFormat", kLargeBatchQuadCount);
+}
+
+std::string TrianglesIndexFormatTest::getVariantName(int index) const
+{
+    return index == 0 ? "16 bit indices" : "32 bit indices";
+}
+
+void TrianglesIndexFormatTest::applyVariant(int index)
+{
+    auto renderer = Director::getInstance()->getRenderer();
+    if (index == 0)
+        renderer->setTrianglesBatchFormat(backend::IndexFormat::U_SHORT);
+    else
+        renderer->setTrianglesBatchFormat(backend::IndexFormat::U_INT, kLargeBatchQuadCount * 4);
+}
+
+void TrianglesIndexFormatTest::restoreDefaults()
+{
+    Director::getInstance()->getRenderer()->setTrianglesBatchFormat(backend::IndexFormat::U_SHORT);
+}
+
+////////////////////////////////////////////////////////
+//
+// MeshInstancingTest
+//
+////////////////////////////////////////////////////////
+static const int kMeshInstanceColumns = 40;
+static const int kMeshInstanceRows = 25;
+
+bool MeshInstancingTest::init()
+{
+    if (!PerformanceRendererScene::init())
+        return false;
+
+    auto s = Director::getInstance()->getWinSize();
+    for (int row = 0; row < kMeshInstanceRows; ++row)
+    {
+        for (int column = 0; column < kMeshInstanceColumns; ++column)
+        {
+            auto sprite = Sprite3D::create("Sprite3DTest/boss1.obj");
+            sprite->setTexture("Sprite3DTest/boss.png");
+            sprite->setScale(0.8f);
+            sprite->setPosition(Vec2((column + 0.5f) * s.width / kMeshInstanceColumns, (row + 0.5f) * (s.height - 150) / kMeshInstanceRows));
+            sprite->setRotation3D(Vec3(0, CCRANDOM_0_1() * 360, 0));
+            addChild(sprite);
+            _sprites.pushBack(sprite);
+        }
+    }
+
+    return true;
+}
+
+std::string MeshInstancingTest::subtitle() const
+{
+    bool supported = Director::getInstance()->getRenderer()->isMeshInstancingSupported();
+    return StringUtils::format("%d Sprite3D, instancing %s", kMeshInstanceRows * kMeshInstanceColumns, supported ? "supported" : "not supported");
+}
+
+std::string MeshInstancingTest::getVariantName(int index) const
+{
+    return index == 0 ? "one draw per mesh" : "instanced";
+}
+
+void MeshInstancingTest::applyVariant(int index)
+{
+    if (index == 0)
+    {
+        // a material per sprite, as Sprite3D::create() does
+        for (auto sprite : _sprites)
+            sprite->setMaterial(Sprite3DMaterial::createBuiltInMaterial(Sprite3DMaterial::MaterialType::UNLIT, false));
+    }
+    else
+    {
+        // one material shared by all the sprites, so their meshes can be merged
+        auto material = Sprite3DMaterial::createBuiltInMaterial(Sprite3DMaterial::MaterialType::UNLIT_INSTANCE, false);
+        for (auto sprite : _sprites)
+            sprite->setMaterial(material);
+    }
+}
+
+////////////////////////////////////////////////////////
+//
+// StreamingBufferTest
+//
+////////////////////////////////////////////////////////
+static const int kStreamingGroups = 50;
+static const int kStreamingQuadsPerGroup = 200;
+
+bool StreamingBufferTest::init()
+{
+    if (!PerformanceRendererScene::init())
+        return false;
+
+    // every DrawNode breaks the sprite batch, so the triangles are uploaded once per group
+    for (int i = 0; i < kStreamingGroups; ++i)
+    {
+        auto group = Node::create();
+        addBatchableSprites(group, kStreamingQuadsPerGroup);
+        addChild(group);
+
+        auto drawNode = DrawNode::create();
+        addChild(drawNode);
+        _drawNodes.pushBack(drawNode);
+    }
+
+    scheduleUpdate();
+    return true;
+}
+
+std::string StreamingBufferTest::subtitle() const
+{
+    return StringUtils::format("%d batches of %d quads and a redrawn DrawNode, Renderer::setTrianglesStreaming", kStreamingGroups, kStreamingQuadsPerGroup);
+}
+
+void StreamingBufferTest::update(float dt)
+{
+    auto s = Director::getInstance()->getWinSize();
+    for (auto drawNode : _drawNodes)
+    {
+        drawNode->clear();
+        for (int i = 0; i < 10; ++i)
+        {
+            drawNode->drawSegment(Vec2(CCRANDOM_0_1() * s.width, CCRANDOM_0_1() * s.height),
+                                  Vec2(CCRANDOM_0_1() * s.width, CCRANDOM_0_1() * s.height),
+                                  2, Color4F(CCRANDOM_0_1(), CCRANDOM_0_1(), CCRANDOM_0_1(), 1));
+        }
+    }
+}
+
+std::string StreamingBufferTest::getVariantName(int index) const
+{
+    return index == 0 ? "buffer data per batch" : "stream buffer";
+}
+
+void StreamingBufferTest::applyVariant(int index)
+{
+    Director::getInstance()->getRenderer()->setTrianglesStreaming(index == 1);
+}
+
+void StreamingBufferTest::restoreDefaults()
+{
+    Director::getInstance()->getRenderer()->setTrianglesStreaming(true);
+}
+
+void StreamingBufferTest::updateInfoLabel()
+{
+    auto renderer = Director::getInstance()->getRenderer();
+    auto& stats = renderer->getStreamStats();
+    _infoLabel->setString(StringUtils::format("%s: %d batches, %d KB streamed, %u stalls avoided, %u overflows",
+                                              _profilerName.c_str(),
+                                              (int)renderer->getDrawnBatches(),
+                                              (int)(stats.uploadedBytes / 1024),
+                                              stats.stallsAvoided,
+                                              stats.overflowOrphans));
+}
+
+////////////////////////////////////////////////////////
+//
+// StateChangesTest
+//
+////////////////////////////////////////////////////////
+static const int kStateChangeSprites = 1000;
+
+bool StateChangesTest::init()
+{
+    if (!PerformanceRendererScene::init())
+        return false;
+
+    // neighbours never share the texture, so every sprite is a draw of its own
+    auto s = Director::getInstance()->getWinSize();
+    std::srand(0);
+    for (int i = 0; i < kStateChangeSprites; ++i)
+    {
+        auto sprite = Sprite::create(i % 2 ? "Images/grossini_dance_01.png" : "Images/grossini_dance_02.png");
+        sprite->setPosition(Vec2(CCRANDOM_0_1() * s.width, CCRANDOM_0_1() * s.height));
+        sprite->setScale(0.25f);
+        addChild(sprite);
+        _sprites.pushBack(sprite);
+    }
+
+    return true;
+}
+
+std::string StateChangesTest::subtitle() const
+{
+    return StringUtils::format("%d sprites with alternating textures, redundant GL calls are skipped", kStateChangeSprites);
+}
+
+std::string StateChangesTest::getVariantName(int index) const
+{
+    return index == 0 ? "same blend func" : "alternating blend funcs";
+}
+
+void StateChangesTest::applyVariant(int index)
+{
+    for (int i = 0; i < kStateChangeSprites; ++i)
+    {
+        if (index == 1 && i % 2)
+            _sprites.at(i)->setBlendFunc(BlendFunc::ADDITIVE);
+        else
+            _sprites.at(i)->setBlendFunc(BlendFunc::ALPHA_PREMULTIPLIED);
+    }
+}
+
+void StateChangesTest::updateInfoLabel()
+{
+    auto renderer = Director::getInstance()->getRenderer();
+    auto& stats = renderer->getStateStats();
+    _infoLabel->setString(StringUtils::format("%s: %d batches, %u GL state calls, %u skipped",
+                                              _profilerName.c_str(),
+                                              (int)renderer->getDrawnBatches(),
+                                              stats.issuedCalls,
+                                              stats.skippedCalls));
+}
+
+////////////////////////////////////////////////////////
+//
+// ProgramStateSharingTest
+//
+////////////////////////////////////////////////////////
+static const int kSharingSprites = 2000;
+static const int kSharingLabels = 200;
+
+bool ProgramStateSharingTest::init()
+{
+    if (!PerformanceRendererScene::init())
+        return false;
+
+    _container = Node::create();
+    addChild(_container);
+
+    return true;
+}
+
+std::string ProgramStateSharingTest::subtitle() const
+{
+    return StringUtils::format("%d sprites and %d labels, memory of their program states", kSharingSprites, kSharingLabels);
+}
+
+std::string ProgramStateSharingTest::getVariantName(int index) const
+{
+    return index == 0 ? "private program states" : "shared program states";
+}
+
+void ProgramStateSharingTest::applyVariant(int index)
+{
+    // sharing is decided when a program state is created, so the nodes are created again
+    _container->removeAllChildren();
+    backend::ProgramStateRegistry::getInstance()->setSharingEnabled(index == 1);
+
+    auto before = backend::ProgramState::getSharingStats();
+
+    auto s = Director::getInstance()->getWinSize();
+    std::srand(0);
+    for (int i = 0; i < kSharingSprites; ++i)
+    {
+        auto sprite = Sprite::create(i % 2 ? "Images/grossini_dance_01.png" : "Images/grossini_dance_02.png");
+        sprite->setPosition(Vec2(CCRANDOM_0_1() * s.width, CCRANDOM_0_1() * s.height));
+        sprite->setScale(0.25f);
+        _container->addChild(sprite);
+    }
+    for (int i = 0; i < kSharingLabels; ++i)
+    {
+        auto label = Label::createWithBMFont("fonts/bitmapFontTest3.fnt", "Score");
+        label->setPosition(Vec2(CCRANDOM_0_1() * s.width, CCRANDOM_0_1() * s.height));
+        _container->addChild(label);
+    }
+
+    auto after = backend::ProgramState::getSharingStats();
+    _programStates = static_cast<int>(after.programStates - before.programStates);
+    _storages = static_cast<int>(after.storages - before.storages);
+    _bytesPerNode = static_cast<float>(after.bytes - before.bytes) / (kSharingSprites + kSharingLabels);
+}
+
+void ProgramStateSharingTest::restoreDefaults()
+{
+    backend::ProgramStateRegistry::getInstance()->setSharingEnabled(CC_ENABLE_SHARED_PROGRAM_STATE);
+}
+
+void ProgramStateSharingTest::updateInfoLabel()
+{
+    // storages are interned again after the first draw updated the uniforms
+    auto stats = backend::ProgramState::getSharingStats();
+    _infoLabel->setString(StringUtils::format("%s: %d program states, %d storages, ~%.0f bytes per node (%d storages interned now)",
+                                              _profilerName.c_str(),
+                                              _programStates,
+                                              _storages,
+                                              _bytesPerNode,
+                                              (int)stats.internedStorages));
+}
+
+////////////////////////////////////////////////////////
+//
+// RenderQueueSortTest
+//
+////////////////////////////////////////////////////////
+static const int s_sortCommandCounts[] = { 10000, 100000 };
+
+// RenderQueue::sort() before the sort keys
+static bool compareGlobalOrder(RenderCommand* a, RenderCommand* b)
+{
+    return a->getGlobalOrder() < b->getGlobalOrder();
+}
+
+bool RenderQueueSortTest::init()
+{
+    if (!PerformanceRendererScene::init())
+        return false;
+
+    // 64 distinct global orders on both sides of zero, like a UI with many layers
+    _commands.resize(s_sortCommandCounts[1]);
+    std::srand(0);
+    for (auto& command : _commands)
+    {
+        int z = std::rand() % 64 - 32;
+        command.init(z < 0 ? z * 0.5f : (z + 1) * 0.5f);
+    }
+
+    _timeRender = false;
+    scheduleUpdate();
+    return true;
+}
+
+std::string RenderQueueSortTest::subtitle() const
+{
+    return "RenderQueue::sort() of commands with random global orders";
+}
+
+std::string RenderQueueSortTest::getVariantName(int index) const
+{
+    return StringUtils::format("%dk commands, %s", s_sortCommandCounts[index / 2] / 1000, index % 2 ? "radix sort of keys" : "std::stable_sort");
+}
+
+void RenderQueueSortTest::applyVariant(int index)
+{
+    _commandCount = s_sortCommandCounts[index / 2];
+    _radixSort = index % 2 == 1;
+}
+
+void RenderQueueSortTest::update(float dt)
+{
+    RenderQueue queue;
+    for (int i = 0; i < _commandCount; ++i)
+    {
+        queue.push_back(&_commands[i]);
+    }
+
+    CC_PROFILER_START(_profilerName.c_str());
+    if (_radixSort)
+    {
+        queue.sort();
+    }
+    else
+    {
+        auto& negative = queue.getSubQueue(RenderQueue::QUEUE_GROUP::GLOBALZ_NEG);
+        auto& positive = queue.getSubQueue(RenderQueue::QUEUE_GROUP::GLOBALZ_POS);
+        std::stable_sort(std::begin(negative), std::end(negative), compareGlobalOrder);
+        std::stable_sort(std::begin(positive), std::end(positive), compareGlobalOrder);
+    }
+    CC_PROFILER_STOP(_profilerName.c_str());
+}
+
+void RenderQueueSortTest::updateInfoLabel()
+{
+    _infoLabel->setString(StringUtils::format("%s: %d commands sorted per frame", _profilerName.c_str(), _commandCount));
+}
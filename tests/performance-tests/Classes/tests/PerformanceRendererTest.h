@@ -0,0 +1,188 @@
+/****************************************************************************
+ Copyright (c) 2020 c4games.com.
+
+ http://www.cocos2d-x.org
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+
+#ifndef __PERFORMANCE_RENDERER_TEST_H__
+#define __PERFORMANCE_RENDERER_TEST_H__
+
+#include "BaseTest.h"
+
+DEFINE_TEST_SUITE(PerformceRendererTests);
+
+/**
+ Measures Renderer::render() of the same scene in several variants (thread count, buffer mode...).
+ Each variant has its own profiler timer, the menu switches between them and the auto test runs them all.
+ */
+class PerformanceRendererScene : public TestCase
+{
+public:
+    virtual bool init() override;
+    virtual void onEnter() override;
+    virtual void onExit() override;
+
+    virtual std::string title() const override { return "Renderer Performance Test"; }
+
+protected:
+    virtual int getVariantCount() const = 0;
+    virtual std::string getVariantName(int index) const = 0;
+    virtual void applyVariant(int index) = 0;
+    /** Called when leaving the test, restores what applyVariant changed. */
+    virtual void restoreDefaults() {}
+
+    void switchVariant(int index);
+    void dumpProfilerInfo(float dt);
+    virtual void updateInfoLabel();
+
+    int _variant = 0;
+    std::string _profilerName;
+    /** Whether the profiler times Renderer::render(), tests timing something else turn it off. */
+    bool _timeRender = true;
+    cocos2d::Label* _infoLabel = nullptr;
+    cocos2d::EventListenerCustom* _afterVisitListener = nullptr;
+    cocos2d::EventListenerCustom* _afterDrawListener = nullptr;
+};
+
+class VertexFillThreadsTest : public PerformanceRendererScene
+{
+public:
+    CREATE_FUNC(VertexFillThreadsTest);
+
+    virtual bool init() override;
+    virtual std::string subtitle() const override;
+
+protected:
+    virtual int getVariantCount() const override;
+    virtual std::string getVariantName(int index) const override;
+    virtual void applyVariant(int index) override;
+    virtual void restoreDefaults() override;
+};
+
+class TrianglesIndexFormatTest : public PerformanceRendererScene
+{
+public:
+    CREATE_FUNC(TrianglesIndexFormatTest);
+
+    virtual bool init() override;
+    virtual std::string subtitle() const override;
+
+protected:
+    virtual int getVariantCount() const override { return 2; }
+    virtual std::string getVariantName(int index) const override;
+    virtual void applyVariant(int index) override;
+    virtual void restoreDefaults() override;
+};
+
+class MeshInstancingTest : public PerformanceRendererScene
+{
+public:
+    CREATE_FUNC(MeshInstancingTest);
+
+    virtual bool init() override;
+    virtual std::string subtitle() const override;
+
+protected:
+    virtual int getVariantCount() const override { return 2; }
+    virtual std::string getVariantName(int index) const override;
+    virtual void applyVariant(int index) override;
+
+    cocos2d::Vector<cocos2d::Sprite3D*> _sprites;
+};
+
+class StreamingBufferTest : public PerformanceRendererScene
+{
+public:
+    CREATE_FUNC(StreamingBufferTest);
+
+    virtual bool init() override;
+    virtual std::string subtitle() const override;
+    virtual void update(float dt) override;
+
+protected:
+    virtual int getVariantCount() const override { return 2; }
+    virtual std::string getVariantName(int index) const override;
+    virtual void applyVariant(int index) override;
+    virtual void restoreDefaults() override;
+    virtual void updateInfoLabel() override;
+
+    cocos2d::Vector<cocos2d::DrawNode*> _drawNodes;
+};
+
+class StateChangesTest : public PerformanceRendererScene
+{
+public:
+    CREATE_FUNC(StateChangesTest);
+
+    virtual bool init() override;
+    virtual std::string subtitle() const override;
+
+protected:
+    virtual int getVariantCount() const override { return 2; }
+    virtual std::string getVariantName(int index) const override;
+    virtual void applyVariant(int index) override;
+    virtual void updateInfoLabel() override;
+
+    cocos2d::Vector<cocos2d::Sprite*> _sprites;
+};
+
+class ProgramStateSharingTest : public PerformanceRendererScene
+{
+public:
+    CREATE_FUNC(ProgramStateSharingTest);
+
+    virtual bool init() override;
+    virtual std::string subtitle() const override;
+
+protected:
+    virtual int getVariantCount() const override { return 2; }
+    virtual std::string getVariantName(int index) const override;
+    virtual void applyVariant(int index) override;
+    virtual void restoreDefaults() override;
+    virtual void updateInfoLabel() override;
+
+    cocos2d::Node* _container = nullptr;
+    int _programStates = 0;
+    int _storages = 0;
+    float _bytesPerNode = 0;
+};
+
+class RenderQueueSortTest : public PerformanceRendererScene
+{
+public:
+    CREATE_FUNC(RenderQueueSortTest);
+
+    virtual bool init() override;
+    virtual std::string subtitle() const override;
+    virtual void update(float dt) override;
+
+protected:
+    virtual int getVariantCount() const override { return 4; }
+    virtual std::string getVariantName(int index) const override;
+    virtual void applyVariant(int index) override;
+    virtual void updateInfoLabel() override;
+
+    std::vector<cocos2d::CustomCommand> _commands;
+    int _commandCount = 0;
+    bool _radixSort = false;
+};
+
+#endif //__PERFORMANCE_RENDERER_TEST_H__
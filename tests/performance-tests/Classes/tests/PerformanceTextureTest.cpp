@@ -24,12 +24,23 @@
 
 #include "PerformanceTextureTest.h"
 #include "Profile.h"
+#include "renderer/CCTextureUtils.h"
+#include "base/s3tc.h"
+#include "base/atitc.h"
+#include "base/etc1.h"
+#include "base/astc.h"
+#include "base/pvr.h"
 
 USING_NS_CC;
 
 PerformceTextureTests::PerformceTextureTests()
 {
     ADD_TEST_CASE(TexturePerformceTest);
+    ADD_TEST_CASE(TextureAsyncLoadingTest);
+    ADD_TEST_CASE(TextureBudgetChurnTest);
+    ADD_TEST_CASE(PixelConversionThroughputTest);
+    ADD_TEST_CASE(CompressedDecodeThroughputTest);
+    ADD_TEST_CASE(ImageEncodeThroughputTest);
 }
 
 static float calculateDeltaTime( struct timeval *lastUpdate )
@@ -356,3 +367,655 @@ std::string TexturePerformceTest::subtitle() const
 {
     return "See console for results";
 }
+
+////////////////////////////////////////////////////////
+//
+// TextureAsyncLoadingTest
+//
+////////////////////////////////////////////////////////
+void TextureAsyncLoadingTest::onEnter()
+{
+    TestCase::onEnter();
+
+    auto fileUtils = FileUtils::getInstance();
+    _files.clear();
+    for (const auto& file : fileUtils->listFiles("Images/"))
+    {
+        if (fileUtils->getFileExtension(file) == ".png")
+            _files.push_back(file);
+    }
+
+    _threadCounts.clear();
+    int maxThreads = std::max(static_cast<int>(std::thread::hardware_concurrency()), 1);
+    for (int threads = 1; threads < maxThreads; threads *= 2)
+        _threadCounts.push_back(threads);
+    _threadCounts.push_back(maxThreads);
+
+    auto s = Director::getInstance()->getWinSize();
+    _resultLabel = Label::createWithTTF("", "fonts/arial.ttf", 14);
+    _resultLabel->setPosition(Vec2(s.width / 2, s.height / 2));
+    addChild(_resultLabel);
+
+    if (isAutoTesting())
+    {
+        Profile::getInstance()->testCaseBegin("TextureAsyncLoadingTest",
+                                              genStrVector("Threads", "Images", nullptr),
+                                              genStrVector("Time", nullptr));
+    }
+
+    _defaultThreads = Director::getInstance()->getTextureCache()->getLoadingThreads();
+    _run = 0;
+    _results.clear();
+    scheduleOnce(CC_SCHEDULE_SELECTOR(TextureAsyncLoadingTest::startRun), 0);
+}
+
+void TextureAsyncLoadingTest::onExit()
+{
+    auto cache = Director::getInstance()->getTextureCache();
+    for (const auto& file : _files)
+    {
+        cache->cancelImageAsync(file);
+        cache->removeTextureForKey(file);
+    }
+    cache->setLoadingThreads(_defaultThreads);
+
+    TestCase::onExit();
+}
+
+void TextureAsyncLoadingTest::startRun(float /*dt*/)
+{
+    auto cache = Director::getInstance()->getTextureCache();
+    // every run decodes all images again
+    for (const auto& file : _files)
+        cache->removeTextureForKey(file);
+
+    cache->setLoadingThreads(_threadCounts[_run]);
+    _pending = _files.size();
+    _begin = std::chrono::steady_clock::now();
+    for (const auto& file : _files)
+    {
+        cache->addImageAsync(file, [this](Texture2D* /*texture*/) {
+            if (--_pending == 0)
+                finishRun();
+        }, file, TextureCache::LoadPriority::NORMAL);
+    }
+}
+
+void TextureAsyncLoadingTest::finishRun()
+{
+    auto ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - _begin).count();
+    int threads = _threadCounts[_run];
+    log("%d loading threads: %d images in %.2f ms", threads, static_cast<int>(_files.size()), ms);
+    _results += StringUtils::format("%d loading threads: %.2f ms\n", threads, ms);
+    _resultLabel->setString(_results);
+
+    if (isAutoTesting())
+        Profile::getInstance()->addTestResult(genStrVector(genStr("%d", threads).c_str(), genStr("%d", static_cast<int>(_files.size())).c_str(), nullptr),
+                                              genStrVector(genStr("%fms", ms).c_str(), nullptr));
+
+    if (++_run < _threadCounts.size())
+    {
+        scheduleOnce(CC_SCHEDULE_SELECTOR(TextureAsyncLoadingTest::startRun), 0);
+    }
+    else if (isAutoTesting())
+    {
+        Profile::getInstance()->testCaseEnd();
+        setAutoTesting(false);
+    }
+}
+
+std::string TextureAsyncLoadingTest::title() const
+{
+    return "Async Texture Loading Test";
+}
+
+std::string TextureAsyncLoadingTest::subtitle() const
+{
+    return "Wall time of addImageAsync() per loading thread count";
+}
+
+////////////////////////////////////////////////////////
+//
+// TextureBudgetChurnTest
+//
+////////////////////////////////////////////////////////
+static const int kChurnFrames = 300;
+static const int kChurnImagesPerFrame = 4;
+
+void TextureBudgetChurnTest::onEnter()
+{
+    TestCase::onEnter();
+
+    auto fileUtils = FileUtils::getInstance();
+    auto cache = Director::getInstance()->getTextureCache();
+    _files.clear();
+    _workingSetBytes = 0;
+    for (const auto& file : fileUtils->listFiles("Images/"))
+    {
+        if (fileUtils->getFileExtension(file) != ".png")
+            continue;
+
+        // measure the working set
+        auto texture = cache->addImage(file);
+        if (texture)
+        {
+            _files.push_back(file);
+            _workingSetBytes += texture->getPixelsWide() * texture->getPixelsHigh() * texture->getBitsPerPixelForFormat() / 8;
+            cache->removeTexture(texture);
+        }
+    }
+
+    auto s = Director::getInstance()->getWinSize();
+    _resultLabel = Label::createWithTTF("", "fonts/arial.ttf", 14);
+    _resultLabel->setPosition(Vec2(s.width / 2, s.height / 2));
+    addChild(_resultLabel);
+
+    if (isAutoTesting())
+    {
+        Profile::getInstance()->testCaseBegin("TextureBudgetChurnTest",
+                                              genStrVector("Budget", nullptr),
+                                              genStrVector("Time", "Evictions", "Reloads", nullptr));
+    }
+
+    _defaultBudget = cache->getMemoryBudget();
+    _run = 0;
+    _results.clear();
+    std::srand(0);
+    startRun();
+    scheduleUpdate();
+}
+
+void TextureBudgetChurnTest::onExit()
+{
+    _usedTextures.clear();
+    auto cache = Director::getInstance()->getTextureCache();
+    cache->setMemoryBudget(_defaultBudget);
+    for (const auto& file : _files)
+        cache->removeTextureForKey(file);
+
+    TestCase::onExit();
+}
+
+void TextureBudgetChurnTest::startRun()
+{
+    auto cache = Director::getInstance()->getTextureCache();
+    // the first run has no budget, the second one holds a quarter of the working set
+    cache->setMemoryBudget(_run == 0 ? 0 : _workingSetBytes / 4);
+    _frame = 0;
+    _totalMs = 0;
+    _evictions = cache->getEvictionCount();
+    _reloads = cache->getReloadCount();
+}
+
+void TextureBudgetChurnTest::update(float /*dt*/)
+{
+    if (_run > 1)
+        return;
+
+    auto cache = Director::getInstance()->getTextureCache();
+
+    // the textures of the last frame are not referenced anymore
+    _usedTextures.clear();
+    auto begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < kChurnImagesPerFrame && !_files.empty(); ++i)
+    {
+        auto texture = cache->addImage(_files[std::rand() % _files.size()]);
+        if (texture)
+            _usedTextures.pushBack(texture);
+    }
+    _totalMs += std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - begin).count();
+
+    if (++_frame < kChurnFrames)
+        return;
+
+    auto evictions = cache->getEvictionCount() - _evictions;
+    auto reloads = cache->getReloadCount() - _reloads;
+    std::string budget = _run == 0 ? "none" : StringUtils::format("%.2f MB", cache->getMemoryBudget() / (1024.0f * 1024.0f));
+    _results += StringUtils::format("budget %s: %.3f ms per frame, %u evictions, %u reloads, %.2f MB cached\n",
+        budget.c_str(), _totalMs / kChurnFrames, evictions, reloads,
+        cache->getMemoryUsage() / (1024.0f * 1024.0f));
+    log("%s", _results.c_str());
+    _resultLabel->setString(_results);
+
+    if (isAutoTesting())
+        Profile::getInstance()->addTestResult(genStrVector(budget.c_str(), nullptr),
+                                              genStrVector(genStr("%fms", _totalMs / kChurnFrames).c_str(),
+                                                           genStr("%u", evictions).c_str(),
+                                                           genStr("%u", reloads).c_str(), nullptr));
+
+    if (++_run <= 1)
+    {
+        startRun();
+    }
+    else if (isAutoTesting())
+    {
+        Profile::getInstance()->testCaseEnd();
+        setAutoTesting(false);
+    }
+}
+
+std::string TextureBudgetChurnTest::title() const
+{
+    return "Texture Budget Churn Test";
+}
+
+std::string TextureBudgetChurnTest::subtitle() const
+{
+    return "addImage() time per frame with and without a memory budget";
+}
+
+////////////////////////////////////////////////////////
+//
+// PixelConversionThroughputTest
+//
+////////////////////////////////////////////////////////
+static const int kConversionImageSize = 2048;
+static const int kConversionRepeats = 5;
+
+void PixelConversionThroughputTest::onEnter()
+{
+    TestCase::onEnter();
+
+    auto s = Director::getInstance()->getWinSize();
+    _resultLabel = Label::createWithTTF("Converting...", "fonts/arial.ttf", 12);
+    _resultLabel->setPosition(Vec2(s.width / 2, s.height / 2));
+    addChild(_resultLabel);
+
+    _defaultSIMD = backend::PixelFormatUtils::isSIMDEnabled();
+    _defaultThreads = backend::PixelFormatUtils::getConversionThreads();
+
+    // the label shows up first, converting blocks for a while
+    scheduleOnce(CC_SCHEDULE_SELECTOR(PixelConversionThroughputTest::runConversions), 0.1f);
+}
+
+void PixelConversionThroughputTest::onExit()
+{
+    backend::PixelFormatUtils::setSIMDEnabled(_defaultSIMD);
+    backend::PixelFormatUtils::setConversionThreads(_defaultThreads);
+
+    TestCase::onExit();
+}
+
+void PixelConversionThroughputTest::runConversions(float /*dt*/)
+{
+    using namespace backend::PixelFormatUtils;
+    typedef backend::PixelFormat PixelFormat;
+
+    struct Conversion
+    {
+        const char* name;
+        PixelFormat originFormat;
+        int bytesPerPixel;
+        PixelFormat format;
+        bool premultiply;
+    };
+    const Conversion conversions[] = {
+        { "RGBA8888 > RGBA4444", PixelFormat::RGBA8888, 4, PixelFormat::RGBA4444, false },
+        { "RGBA8888 > RGBA4444 premultiplied", PixelFormat::RGBA8888, 4, PixelFormat::RGBA4444, true },
+        { "RGBA8888 > RGB565", PixelFormat::RGBA8888, 4, PixelFormat::RGB565, false },
+        { "RGBA8888 > RGB5A1", PixelFormat::RGBA8888, 4, PixelFormat::RGB5A1, false },
+        { "RGBA8888 > I8", PixelFormat::RGBA8888, 4, PixelFormat::I8, false },
+        { "RGB888 > RGBA8888", PixelFormat::RGB888, 3, PixelFormat::RGBA8888, false },
+        { "I8 > RGBA8888", PixelFormat::I8, 1, PixelFormat::RGBA8888, false },
+        { "AI88 > RGBA8888", PixelFormat::AI88, 2, PixelFormat::RGBA8888, false },
+    };
+    struct Mode
+    {
+        const char* name;
+        bool simd;
+        int threads;
+    };
+    const Mode modes[] = {
+        { "scalar", false, 1 },
+        { getSIMDName(), true, 1 },
+        { "threaded", true, 0 },
+    };
+
+    if (isAutoTesting())
+    {
+        Profile::getInstance()->testCaseBegin("PixelConversionThroughputTest",
+                                              genStrVector("Conversion", "Mode", nullptr),
+                                              genStrVector("Speed", nullptr));
+    }
+
+    const size_t pixels = kConversionImageSize * kConversionImageSize;
+    std::vector<unsigned char> image(pixels * 4);
+    for (size_t i = 0; i < image.size(); ++i)
+    {
+        image[i] = static_cast<unsigned char>(rand());
+    }
+
+    std::string results;
+    for (const auto& conversion : conversions)
+    {
+        results += conversion.name;
+        for (const auto& mode : modes)
+        {
+            setSIMDEnabled(mode.simd);
+            setConversionThreads(mode.threads);
+
+            // the best of a few runs, the first one also pays for page faults of the output
+            float bestMs = 0;
+            for (int repeat = 0; repeat < kConversionRepeats; ++repeat)
+            {
+                unsigned char* outData = nullptr;
+                size_t outDataLen = 0;
+                auto begin = std::chrono::steady_clock::now();
+                convertDataToFormat(image.data(), pixels * conversion.bytesPerPixel, conversion.originFormat, conversion.format,
+                                    &outData, &outDataLen, conversion.premultiply);
+                float ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - begin).count();
+                if (outData != image.data())
+                {
+                    free(outData);
+                }
+                if (repeat == 0 || ms < bestMs)
+                {
+                    bestMs = ms;
+                }
+            }
+
+            float megapixels = pixels / (bestMs * 1000.0f);
+            log("%s, %s: %.2f ms, %.1f Mpixel/s", conversion.name, mode.name, bestMs, megapixels);
+            results += StringUtils::format("  %s %.0f", mode.name, megapixels);
+
+            if (isAutoTesting())
+                Profile::getInstance()->addTestResult(genStrVector(conversion.name, mode.name, nullptr),
+                                                      genStrVector(genStr("%.1fMpixel/s", megapixels).c_str(), nullptr));
+        }
+        results += "\n";
+    }
+    _resultLabel->setString(results);
+
+    setSIMDEnabled(_defaultSIMD);
+    setConversionThreads(_defaultThreads);
+
+    if (isAutoTesting())
+    {
+        Profile::getInstance()->testCaseEnd();
+        setAutoTesting(false);
+    }
+}
+
+std::string PixelConversionThroughputTest::title() const
+{
+    return "Pixel Conversion Throughput Test";
+}
+
+std::string PixelConversionThroughputTest::subtitle() const
+{
+    return "Mpixel/s of the scalar code, the SIMD kernels and the threaded kernels";
+}
+
+////////////////////////////////////////////////////////
+//
+// CompressedDecodeThroughputTest
+//
+////////////////////////////////////////////////////////
+static const int kDecodeImageSize = 1024;
+static const int kDecodeRepeats = 3;
+
+void CompressedDecodeThroughputTest::onEnter()
+{
+    TestCase::onEnter();
+
+    auto s = Director::getInstance()->getWinSize();
+    _resultLabel = Label::createWithTTF("Decoding...", "fonts/arial.ttf", 12);
+    _resultLabel->setPosition(Vec2(s.width / 2, s.height / 2));
+    addChild(_resultLabel);
+
+    // the label shows up first, decoding blocks for a while
+    scheduleOnce(CC_SCHEDULE_SELECTOR(CompressedDecodeThroughputTest::runDecoders), 0.1f);
+}
+
+void CompressedDecodeThroughputTest::runDecoders(float /*dt*/)
+{
+    typedef std::function<void(unsigned char* in, unsigned char* out, int size, int maxThreads)> Decoder;
+    struct Format
+    {
+        const char* name;
+        Decoder decode;
+    };
+    const Format formats[] = {
+        { "DXT1", [](unsigned char* in, unsigned char* out, int size, int maxThreads) {
+            s3tc_decode(in, out, size, size, S3TCDecodeFlag::DXT1, maxThreads);
+        } },
+        { "DXT5", [](unsigned char* in, unsigned char* out, int size, int maxThreads) {
+            s3tc_decode(in, out, size, size, S3TCDecodeFlag::DXT5, maxThreads);
+        } },
+        { "ATC interpolated alpha", [](unsigned char* in, unsigned char* out, int size, int maxThreads) {
+            atitc_decode(in, out, size, size, ATITCDecodeFlag::ATC_INTERPOLATED_ALPHA, maxThreads);
+        } },
+        { "ETC1", [](unsigned char* in, unsigned char* out, int size, int maxThreads) {
+            etc1_decode_image(in, out, size, size, 3, size * 3, maxThreads);
+        } },
+        { "ASTC 4x4", [](unsigned char* in, unsigned char* out, int size, int maxThreads) {
+            decompress_astc(in, out, size, size, 4, 4, size * size, maxThreads);
+        } },
+        { "ASTC 8x8", [](unsigned char* in, unsigned char* out, int size, int maxThreads) {
+            decompress_astc(in, out, size, size, 8, 8, size * size / 4, maxThreads);
+        } },
+        { "PVRTC 4bpp", [](unsigned char* in, unsigned char* out, int size, int maxThreads) {
+            PVRTDecompressPVRTC(in, size, size, out, false, maxThreads);
+        } },
+        { "PVRTC 2bpp", [](unsigned char* in, unsigned char* out, int size, int maxThreads) {
+            PVRTDecompressPVRTC(in, size, size, out, true, maxThreads);
+        } },
+    };
+    struct Mode
+    {
+        const char* name;
+        int threads;
+    };
+    const Mode modes[] = {
+        { "1 thread", 1 },
+        { "threaded", 0 },
+    };
+
+    if (isAutoTesting())
+    {
+        Profile::getInstance()->testCaseBegin("CompressedDecodeThroughputTest",
+                                              genStrVector("Format", "Mode", nullptr),
+                                              genStrVector("Speed", nullptr));
+    }
+
+    // random blocks, one byte per pixel is enough encoded data for all of the formats
+    const size_t pixels = kDecodeImageSize * kDecodeImageSize;
+    std::vector<unsigned char> encoded(pixels);
+    for (size_t i = 0; i < encoded.size(); ++i)
+    {
+        encoded[i] = static_cast<unsigned char>(rand());
+    }
+    std::vector<unsigned char> decoded(pixels * 4);
+
+    std::string results;
+    for (const auto& format : formats)
+    {
+        results += format.name;
+        for (const auto& mode : modes)
+        {
+            float bestMs = 0;
+            for (int repeat = 0; repeat < kDecodeRepeats; ++repeat)
+            {
+                auto begin = std::chrono::steady_clock::now();
+                format.decode(encoded.data(), decoded.data(), kDecodeImageSize, mode.threads);
+                float ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - begin).count();
+                if (repeat == 0 || ms < bestMs)
+                {
+                    bestMs = ms;
+                }
+            }
+
+            float megapixels = pixels / (bestMs * 1000.0f);
+            log("%s, %s: %.2f ms, %.1f Mpixel/s", format.name, mode.name, bestMs, megapixels);
+            results += StringUtils::format("  %s %.1f", mode.name, megapixels);
+
+            if (isAutoTesting())
+                Profile::getInstance()->addTestResult(genStrVector(format.name, mode.name, nullptr),
+                                                      genStrVector(genStr("%.1fMpixel/s", megapixels).c_str(), nullptr));
+        }
+        results += "\n";
+    }
+    _resultLabel->setString(results);
+
+    if (isAutoTesting())
+    {
+        Profile::getInstance()->testCaseEnd();
+        setAutoTesting(false);
+    }
+}
+
+std::string CompressedDecodeThroughputTest::title() const
+{
+    return "Compressed Texture Decode Throughput Test";
+}
+
+std::string CompressedDecodeThroughputTest::subtitle() const
+{
+    return StringUtils::format("Mpixel/s of the software decoders on 1 and %d threads",
+                               ParallelTaskPool::getInstance()->getThreadCount());
+}
+
+////////////////////////////////////////////////////////
+//
+// ImageEncodeThroughputTest
+//
+////////////////////////////////////////////////////////
+static const int kEncodeWidth = 1920;
+static const int kEncodeHeight = 1080;
+static const int kEncodeAsyncSaves = 8;
+
+void ImageEncodeThroughputTest::onEnter()
+{
+    TestCase::onEnter();
+
+    auto s = Director::getInstance()->getWinSize();
+    _resultLabel = Label::createWithTTF("Encoding...", "fonts/arial.ttf", 12);
+    _resultLabel->setPosition(Vec2(s.width / 2, s.height / 2));
+    addChild(_resultLabel);
+
+    // the label shows up first, encoding blocks for a while
+    scheduleOnce(CC_SCHEDULE_SELECTOR(ImageEncodeThroughputTest::runEncoders), 0.1f);
+}
+
+void ImageEncodeThroughputTest::onExit()
+{
+    // saves still running keep the image alive, their files are left for the next run to overwrite
+    CC_SAFE_RELEASE_NULL(_image);
+    if (!_encodeDir.empty() && _pendingSaves == 0)
+        FileUtils::getInstance()->removeDirectory(_encodeDir);
+
+    TestCase::onExit();
+}
+
+void ImageEncodeThroughputTest::runEncoders(float /*dt*/)
+{
+    auto fs = FileUtils::getInstance();
+    _encodeDir = fs->getWritablePath() + "encode-test/";
+    fs->createDirectory(_encodeDir);
+
+    // looks like a screenshot: gradients, flat panels and a noisy area, opaque but saved with alpha
+    std::vector<unsigned char> pixels(kEncodeWidth * kEncodeHeight * 4);
+    for (int y = 0; y < kEncodeHeight; ++y)
+    {
+        for (int x = 0; x < kEncodeWidth; ++x)
+        {
+            unsigned char* pixel = &pixels[(y * kEncodeWidth + x) * 4];
+            bool panel = (x / 240 + y / 270) % 3 == 0;
+            bool noise = x > kEncodeWidth * 2 / 3 && y > kEncodeHeight / 2;
+            pixel[0] = panel ? 40 : static_cast<unsigned char>(x * 255 / kEncodeWidth);
+            pixel[1] = panel ? 60 : static_cast<unsigned char>(y * 255 / kEncodeHeight);
+            pixel[2] = noise ? static_cast<unsigned char>(rand()) : 128;
+            pixel[3] = 255;
+        }
+    }
+    _image = new (std::nothrow) Image();
+    _image->initWithRawData(pixels.data(), pixels.size(), kEncodeWidth, kEncodeHeight, 8);
+
+    struct Setting
+    {
+        const char* name;
+        const char* extension;
+        Image::EncodeOptions options;
+    };
+    Image::EncodeOptions level1;
+    level1.pngCompressionLevel = 1;
+    Image::EncodeOptions quality75;
+    quality75.jpgQuality = 75;
+    const Setting settings[] = {
+        { "PNG default", ".png", Image::EncodeOptions() },
+        { "PNG level 1", ".png", level1 },
+        { "PNG fast lossless", ".png", Image::EncodeOptions::fastLossless() },
+        { "PNG smallest", ".png", Image::EncodeOptions::smallest() },
+        { "JPG quality 90", ".jpg", Image::EncodeOptions() },
+        { "JPG quality 75", ".jpg", quality75 },
+    };
+
+    if (isAutoTesting())
+    {
+        Profile::getInstance()->testCaseBegin("ImageEncodeThroughputTest",
+                                              genStrVector("Setting", nullptr),
+                                              genStrVector("Speed", "Size(KB)", nullptr));
+    }
+
+    float megabytes = pixels.size() / (1024.0f * 1024.0f);
+    _results.clear();
+    for (const auto& setting : settings)
+    {
+        std::string path = _encodeDir + "sync" + setting.extension;
+        auto begin = std::chrono::steady_clock::now();
+        bool saved = _image->saveToFile(path, false, setting.options);
+        float ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - begin).count();
+        long long kilobytes = saved ? static_cast<long long>(fs->getFileSize(path) / 1024) : 0;
+
+        float speed = megabytes / (ms / 1000.0f);
+        log("%s: %.2f ms, %.1f MB/s, %lld KB", setting.name, ms, speed, kilobytes);
+        _results += StringUtils::format("%s: %.1f MB/s, %lld KB\n", setting.name, speed, kilobytes);
+
+        if (isAutoTesting())
+            Profile::getInstance()->addTestResult(genStrVector(setting.name, nullptr),
+                                                  genStrVector(genStr("%.1fMB/s", speed).c_str(), genStr("%lld", kilobytes).c_str(), nullptr));
+    }
+    _resultLabel->setString(_results);
+
+    // a burst of captures, the main thread only queues them
+    _pendingSaves = kEncodeAsyncSaves;
+    _asyncBegin = std::chrono::steady_clock::now();
+    for (int save = 0; save < kEncodeAsyncSaves; ++save)
+    {
+        std::string path = _encodeDir + StringUtils::format("async%d.png", save);
+        _image->saveToFileAsync(path, false, Image::EncodeOptions::fastLossless(), [this](bool /*succeeded*/) {
+            if (--_pendingSaves == 0)
+                finishAsyncSaves();
+        });
+    }
+    float queueMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - _asyncBegin).count();
+    log("queueing %d async saves: %.3f ms", kEncodeAsyncSaves, queueMs);
+}
+
+void ImageEncodeThroughputTest::finishAsyncSaves()
+{
+    float ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - _asyncBegin).count();
+    float imagesPerSecond = kEncodeAsyncSaves / (ms / 1000.0f);
+    log("%d async fast lossless saves: %.2f ms, %.1f images/s", kEncodeAsyncSaves, ms, imagesPerSecond);
+    _results += StringUtils::format("%d async fast lossless saves: %.1f images/s", kEncodeAsyncSaves, imagesPerSecond);
+    _resultLabel->setString(_results);
+
+    if (isAutoTesting())
+    {
+        Profile::getInstance()->addTestResult(genStrVector("PNG fast lossless, async", nullptr),
+                                              genStrVector(genStr("%.1fimages/s", imagesPerSecond).c_str(), "-", nullptr));
+        Profile::getInstance()->testCaseEnd();
+        setAutoTesting(false);
+    }
+}
+
+std::string ImageEncodeThroughputTest::title() const
+{
+    return "Image Encode Throughput Test";
+}
+
+std::string ImageEncodeThroughputTest::subtitle() const
+{
+    return StringUtils::format("%dx%d RGBA, PNG and JPG settings, then %d saves on the compute threads",
+                               kEncodeWidth, kEncodeHeight, kEncodeAsyncSaves);
+}
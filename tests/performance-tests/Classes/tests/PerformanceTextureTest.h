@@ -26,6 +26,7 @@
 #define __PERFORMANCE_TEXTURE_TEST_H__
 
 #include "BaseTest.h"
+#include <chrono>
 
 DEFINE_TEST_SUITE(PerformceTextureTests);
 
@@ -42,4 +43,126 @@ public:
     virtual void onEnter() override;
 };
 
+/**
+ Loads all images of the Images folder with TextureCache::addImageAsync() once per loading thread count,
+ and reports the wall time until the last callback.
+ */
+class TextureAsyncLoadingTest : public TestCase
+{
+public:
+    CREATE_FUNC(TextureAsyncLoadingTest);
+
+    virtual std::string title() const override;
+    virtual std::string subtitle() const override;
+    virtual void onEnter() override;
+    virtual void onExit() override;
+
+protected:
+    void startRun(float dt);
+    void finishRun();
+
+    std::vector<std::string> _files;
+    std::vector<int> _threadCounts;
+    size_t _run = 0;
+    size_t _pending = 0;
+    int _defaultThreads = 1;
+    std::chrono::steady_clock::time_point _begin;
+    std::string _results;
+    cocos2d::Label* _resultLabel = nullptr;
+};
+
+/**
+ Requests a few random images per frame from a working set larger than the memory budget, and reports the
+ time spent in addImage() with and without the budget, along with the evictions and reloads.
+ */
+class TextureBudgetChurnTest : public TestCase
+{
+public:
+    CREATE_FUNC(TextureBudgetChurnTest);
+
+    virtual std::string title() const override;
+    virtual std::string subtitle() const override;
+    virtual void onEnter() override;
+    virtual void onExit() override;
+    virtual void update(float dt) override;
+
+protected:
+    void startRun();
+
+    std::vector<std::string> _files;
+    cocos2d::Vector<cocos2d::Texture2D*> _usedTextures;
+    int _run = 0;
+    int _frame = 0;
+    float _totalMs = 0;
+    unsigned int _evictions = 0;
+    unsigned int _reloads = 0;
+    size_t _workingSetBytes = 0;
+    size_t _defaultBudget = 0;
+    std::string _results;
+    cocos2d::Label* _resultLabel = nullptr;
+};
+
+/**
+ Converts a 2048x2048 image between the common pixel formats with the scalar code, the SIMD kernels,
+ and the SIMD kernels on all threads, and reports the megapixels per second of each.
+ */
+class PixelConversionThroughputTest : public TestCase
+{
+public:
+    CREATE_FUNC(PixelConversionThroughputTest);
+
+    virtual std::string title() const override;
+    virtual std::string subtitle() const override;
+    virtual void onEnter() override;
+    virtual void onExit() override;
+
+protected:
+    void runConversions(float dt);
+
+    bool _defaultSIMD = true;
+    int _defaultThreads = 0;
+    cocos2d::Label* _resultLabel = nullptr;
+};
+
+class CompressedDecodeThroughputTest : public TestCase
+{
+public:
+    CREATE_FUNC(CompressedDecodeThroughputTest);
+
+    virtual std::string title() const override;
+    virtual std::string subtitle() const override;
+    virtual void onEnter() override;
+
+protected:
+    void runDecoders(float dt);
+
+    cocos2d::Label* _resultLabel = nullptr;
+};
+
+/**
+ Encodes a 1920x1080 RGBA image with each of several Image::EncodeOptions and reports the megabytes per second
+ and file size of each, then saves a batch of images with saveToFileAsync() to measure the thread pool.
+ */
+class ImageEncodeThroughputTest : public TestCase
+{
+public:
+    CREATE_FUNC(ImageEncodeThroughputTest);
+
+    virtual std::string title() const override;
+    virtual std::string subtitle() const override;
+    virtual void onEnter() override;
+    virtual void onExit() override;
+
+protected:
+    void runEncoders(float dt);
+    void finishAsyncSaves();
+
+    cocos2d::Image* _image = nullptr;
+    std::string _encodeDir;
+    std::string _results;
+    int _pendingSaves = 0;
+    std::chrono::steady_clock::time_point _asyncBegin;
+    cocos2d::Label* _resultLabel = nullptr;
+};
+
 #endif
@@ -0,0 +1,177 @@
+/****************************************************************************
+ Copyright (c) 2020 c4games.com.
+
+ http://www.cocos2d-x.org
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+
+#include "PerformanceUserDefaultTest.h"
+#include "Profile.h"
+
+USING_NS_CC;
+
+PerformceUserDefaultTests::PerformceUserDefaultTests()
+{
+    ADD_TEST_CASE(UserDefaultWriteTest);
+}
+
+////////////////////////////////////////////////////////
+//
+// UserDefaultWriteTest
+//
+////////////////////////////////////////////////////////
+static const int kUserDefaultFrames = 200;
+static const int kUserDefaultWritesPerFrame = 500;
+static const int kUserDefaultKeys = 2000;
+
+static std::string userDefaultKey(int index)
+{
+    return StringUtils::format("perf_userdefault_%d", index);
+}
+
+void UserDefaultWriteTest::onEnter()
+{
+    TestCase::onEnter();
+
+    auto s = Director::getInstance()->getWinSize();
+    _resultLabel = Label::createWithTTF("Writing values...", "fonts/arial.ttf", 12);
+    _resultLabel->setPosition(Vec2(s.width / 2, s.height / 2));
+    addChild(_resultLabel);
+
+    _batchingBefore = UserDefault::getInstance()->isWriteBatchingEnabled();
+    _batching = false;
+    _results.clear();
+
+    if (isAutoTesting())
+    {
+        Profile::getInstance()->testCaseBegin("UserDefaultWriteTest",
+                                              genStrVector("Mode", nullptr),
+                                              genStrVector("Total(ms)", "WorstFrame(ms)", "WorstWrites(ms)", nullptr));
+    }
+
+    scheduleOnce(CC_SCHEDULE_SELECTOR(UserDefaultWriteTest::startMode), 0.1f);
+}
+
+void UserDefaultWriteTest::onExit()
+{
+    unscheduleUpdate();
+
+    // the deletions are batched too, instead of rewriting the file for every key
+    auto userDefault = UserDefault::getInstance();
+    userDefault->setWriteBatchingEnabled(true);
+    for (int key = 0; key < kUserDefaultKeys; ++key)
+        userDefault->deleteValueForKey(userDefaultKey(key).c_str());
+    userDefault->flush();
+    userDefault->setWriteBatchingEnabled(_batchingBefore);
+
+    TestCase::onExit();
+}
+
+void UserDefaultWriteTest::startMode(float /*dt*/)
+{
+    UserDefault::getInstance()->setWriteBatchingEnabled(_batching);
+    _frame = 0;
+    _seed = 1;
+    _worstFrameMs = 0;
+    _worstWritesMs = 0;
+    _modeBegin = _frameBegin = std::chrono::steady_clock::now();
+    scheduleUpdate();
+}
+
+void UserDefaultWriteTest::update(float /*dt*/)
+{
+    auto now = std::chrono::steady_clock::now();
+    // the batched writes of a frame are committed after the updates, so they show up in the interval between two frames
+    if (_frame > 0)
+        _worstFrameMs = std::max(_worstFrameMs, std::chrono::duration<float, std::milli>(now - _frameBegin).count());
+    _frameBegin = now;
+
+    if (_frame == kUserDefaultFrames)
+    {
+        unscheduleUpdate();
+        finishMode();
+        return;
+    }
+
+    // the same mix of types and sizes in both modes, with a few keys written much more often than the others
+    auto userDefault = UserDefault::getInstance();
+    for (int write = 0; write < kUserDefaultWritesPerFrame; ++write)
+    {
+        _seed = _seed * 1103515245 + 12345;
+        unsigned int random = _seed >> 8;
+        int key = (random % 4 == 0) ? random % kUserDefaultKeys : random % 16;
+        switch (random % 3)
+        {
+        case 0:
+            userDefault->setIntegerForKey(userDefaultKey(key).c_str(), static_cast<int>(random));
+            break;
+        case 1:
+            userDefault->setFloatForKey(userDefaultKey(key).c_str(), random * 0.5f);
+            break;
+        default:
+            userDefault->setStringForKey(userDefaultKey(key).c_str(), std::string(10 + random % 200, 'a' + random % 26));
+            break;
+        }
+    }
+    float writesMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - now).count();
+    _worstWritesMs = std::max(_worstWritesMs, writesMs);
+    ++_frame;
+}
+
+void UserDefaultWriteTest::finishMode()
+{
+    UserDefault::getInstance()->flush();
+    float totalMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - _modeBegin).count();
+
+    const char* mode = _batching ? "batched" : "immediate";
+    log("UserDefaultWriteTest %s: total %.2f ms, worst frame %.2f ms, worst writes %.2f ms", mode, totalMs,
+        _worstFrameMs, _worstWritesMs);
+    _results += StringUtils::format("%s: worst frame %.2f ms, writes %.2f ms\n", mode, _worstFrameMs, _worstWritesMs);
+    _resultLabel->setString(_results);
+
+    if (isAutoTesting())
+    {
+        Profile::getInstance()->addTestResult(genStrVector(mode, nullptr),
+                                              genStrVector(genStr("%.2f", totalMs).c_str(), genStr("%.2f", _worstFrameMs).c_str(),
+                                                           genStr("%.2f", _worstWritesMs).c_str(), nullptr));
+    }
+
+    if (!_batching)
+    {
+        _batching = true;
+        scheduleOnce(CC_SCHEDULE_SELECTOR(UserDefaultWriteTest::startMode), 0.1f);
+    }
+    else if (isAutoTesting())
+    {
+        Profile::getInstance()->testCaseEnd();
+        setAutoTesting(false);
+    }
+}
+
+std::string UserDefaultWriteTest::title() const
+{
+    return "UserDefault Write Test";
+}
+
+std::string UserDefaultWriteTest::subtitle() const
+{
+    return StringUtils::format("%d writes per frame for %d frames, immediate vs batched", kUserDefaultWritesPerFrame,
+                               kUserDefaultFrames);
+}
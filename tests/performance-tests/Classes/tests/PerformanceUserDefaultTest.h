@@ -0,0 +1,64 @@
+/****************************************************************************
+ Copyright (c) 2020 c4games.com.
+
+ http://www.cocos2d-x.org
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ ****************************************************************************/
+
+#ifndef __PERFORMANCE_USERDEFAULT_TEST_H__
+#define __PERFORMANCE_USERDEFAULT_TEST_H__
+
+#include "BaseTest.h"
+#include <chrono>
+
+DEFINE_TEST_SUITE(PerformceUserDefaultTests);
+
+/**
+ Writes 100000 values to UserDefault over 200 frames, appended one by one and batched per frame,
+ and reports the longest frame of each mode.
+ */
+class UserDefaultWriteTest : public TestCase
+{
+public:
+    CREATE_FUNC(UserDefaultWriteTest);
+
+    virtual std::string title() const override;
+    virtual std::string subtitle() const override;
+    virtual void onEnter() override;
+    virtual void onExit() override;
+    virtual void update(float dt) override;
+
+protected:
+    void startMode(float dt);
+    void finishMode();
+
+    cocos2d::Label* _resultLabel = nullptr;
+    std::string _results;
+    bool _batching = false;
+    bool _batchingBefore = false;
+    int _frame = 0;
+    unsigned int _seed = 0;
+    float _worstFrameMs = 0;
+    float _worstWritesMs = 0;
+    std::chrono::steady_clock::time_point _modeBegin;
+    std::chrono::steady_clock::time_point _frameBegin;
+};
+
+#endif //__PERFORMANCE_USERDEFAULT_TEST_H__
@@ -56,6 +56,10 @@ public:
         addTest("Callback Tests", []() { return new PerformceCallbackTests(); });
         addTest("Math Tests", []() { return new PerformceMathTests(); });
         addTest("Container Tests", []() { return new PerformceContainerTests(); });
+        addTest("Renderer Tests", []() { return new PerformceRendererTests(); });
+        addTest("FileUtils Tests", []() { return new PerformceFileUtilsTests(); });
+        addTest("UserDefault Tests", []() { return new PerformceUserDefaultTests(); });
+        addTest("Audio Tests", []() { return new PerformceAudioTests(); });
     }
 };
 
@@ -38,5 +38,9 @@
 #include "PerformanceCallbackTest.h"
 #include "PerformanceMathTest.h"
 #include "PerformanceContainerTest.h"
+#include "PerformanceRendererTest.h"
+#include "PerformanceFileUtilsTest.h"
+#include "PerformanceUserDefaultTest.h"
+#include "PerformanceAudioTest.h"
 
 #endif
@@ -0,0 +1,186 @@
+/****************************************************************************
+Copyright (c) 2020 c4games.com.
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+// Packs a directory into an asset pack which FileUtils::mountAssetPack() can mount.
+// usage: asset-packer [--compress] [--compile-plists] <input directory> <output pack>
+
+#include "cocos2d.h"
+#include <stdio.h>
+#include <string.h>
+#include <unordered_set>
+#if defined(_WIN32)
+#include <direct.h>
+#define getcwd _getcwd
+#else
+#include <unistd.h>
+#endif
+
+USING_NS_CC;
+
+// FileUtils resolves relative paths against its search paths, command line paths are relative to the working directory
+static std::string toAbsolutePath(std::string path)
+{
+    std::replace(path.begin(), path.end(), '\\', '/');
+    if (FileUtils::getInstance()->isAbsolutePath(path))
+        return path;
+
+    char cwd[4096];
+    if (getcwd(cwd, sizeof(cwd)) == nullptr)
+        return path;
+
+    std::string absolutePath = cwd;
+    std::replace(absolutePath.begin(), absolutePath.end(), '\\', '/');
+    if (absolutePath.back() != '/')
+        absolutePath += '/';
+    return absolutePath + path;
+}
+
+static void printUsage()
+{
+    fprintf(stderr, "usage: asset-packer [--compress] [--compile-plists] <input directory> <output pack>\n"
+                    "  --compress         deflate the files which get smaller, the others are stored as they are\n"
+                    "  --compile-plists   add a compiled copy of every plist, FileUtils reads it instead of the XML\n");
+}
+
+static bool endsWith(const std::string& str, const char* suffix)
+{
+    size_t length = strlen(suffix);
+    return str.size() >= length && str.compare(str.size() - length, length, suffix) == 0;
+}
+
+// Compiles the plists among the sources into a directory and adds the compiled files beside them in the pack.
+static bool compilePlists(std::vector<AssetPack::Source>& sources, const std::string& compiledDir)
+{
+    auto fs = FileUtils::getInstance();
+    std::vector<AssetPack::Source> compiled;
+    for (const auto& source : sources)
+    {
+        if (!endsWith(source.name, ".plist"))
+            continue;
+
+        // plists have a dictionary or an array at their root
+        Data data;
+        ValueMap dict = fs->getValueMapFromFile(source.path);
+        if (!dict.empty())
+        {
+            data = BinaryValue::encode(dict);
+        }
+        else
+        {
+            ValueVector array = fs->getValueVectorFromFile(source.path);
+            if (array.empty())
+            {
+                fprintf(stderr, "asset-packer: %s is empty or not a plist, it isn't compiled\n", source.path.c_str());
+                continue;
+            }
+            data = BinaryValue::encode(array);
+        }
+
+        std::string path = compiledDir + StringUtils::format("%d.bin", static_cast<int>(compiled.size()));
+        if (!fs->writeDataToFile(data, path))
+        {
+            fprintf(stderr, "asset-packer: can't write %s\n", path.c_str());
+            return false;
+        }
+        compiled.push_back({FileUtils::getCompiledPlistPath(source.name), path});
+    }
+
+    // compiled copies already in the input directory are replaced
+    std::unordered_set<std::string> names;
+    for (const auto& item : compiled)
+        names.insert(item.name);
+    sources.erase(std::remove_if(sources.begin(), sources.end(), [&](const AssetPack::Source& source) {
+        return names.count(source.name) != 0;
+    }), sources.end());
+
+    sources.insert(sources.end(), compiled.begin(), compiled.end());
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    bool compress = false;
+    bool compile = false;
+    std::vector<std::string> args;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "--compress") == 0)
+            compress = true;
+        else if (strcmp(argv[i], "--compile-plists") == 0)
+            compile = true;
+        else
+            args.push_back(argv[i]);
+    }
+
+    if (args.size() != 2)
+    {
+        printUsage();
+        return 1;
+    }
+
+    auto fs = FileUtils::getInstance();
+    std::string inputDir = toAbsolutePath(args[0]);
+    std::string packPath = toAbsolutePath(args[1]);
+    if (inputDir.back() != '/')
+        inputDir += '/';
+
+    if (!fs->isDirectoryExist(inputDir))
+    {
+        fprintf(stderr, "asset-packer: %s isn't a directory\n", inputDir.c_str());
+        return 1;
+    }
+
+    std::vector<std::string> files;
+    fs->listFilesRecursively(inputDir, &files);
+
+    // the names in the pack are the paths relative to the input directory
+    std::vector<AssetPack::Source> sources;
+    for (auto& file : files)
+    {
+        std::replace(file.begin(), file.end(), '\\', '/');
+        if (file.back() == '/' || file == packPath || file.compare(0, inputDir.size(), inputDir) != 0)
+            continue;
+        sources.push_back({file.substr(inputDir.size()), file});
+    }
+
+    std::string compiledDir = packPath + ".plists/";
+    if (compile && (!fs->createDirectory(compiledDir) || !compilePlists(sources, compiledDir)))
+    {
+        fs->removeDirectory(compiledDir);
+        return 1;
+    }
+
+    bool written = AssetPack::write(packPath, sources, compress);
+    if (compile)
+        fs->removeDirectory(compiledDir);
+    if (!written)
+    {
+        fprintf(stderr, "asset-packer: failed to write %s\n", packPath.c_str());
+        return 1;
+    }
+
+    printf("asset-packer: packed %d files into %s (%lld bytes)\n", static_cast<int>(sources.size()), packPath.c_str(),
+           static_cast<long long>(fs->getFileSize(packPath)));
+    return 0;
+}
@@ -0,0 +1,523 @@
+/****************************************************************************
+Copyright (c) 2020 c4games.com.
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+// Renders the mixed output of AudioEngine without an audio device, through the loopback device of openal-soft,
+// as fast as it can. The output only depends on the script, so it can be compared with a golden WAV.
+// usage: audio-render [--seconds <n>] [--rate <hz>] [--block <frames>] [--script <file>] [--wav <output>]
+
+#include "cocos2d.h"
+#include "audio/include/AudioEngine.h"
+#include "audio/include/AudioStreamer.h"
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <chrono>
+#include <sstream>
+#include <unordered_map>
+#if defined(_WIN32)
+#include <direct.h>
+#define getcwd _getcwd
+#else
+#include <unistd.h>
+#include <time.h>
+#include <dirent.h>
+#endif
+
+USING_NS_CC;
+
+// One line of a script: "<time> play <name> <file> [loop] [volume]", "<time> stop|pause|resume <name>",
+// "<time> seek <name> <seconds>" or "<time> volume <name> <volume>". Lines starting with # are comments.
+struct ScriptEvent
+{
+    double time = 0;
+    std::string command;
+    std::string name;
+    std::string file;
+    bool loop = false;
+    float value = 1.0f;
+};
+
+// FileUtils resolves relative paths against its search paths, command line paths are relative to the working directory
+static std::string toAbsolutePath(std::string path)
+{
+    std::replace(path.begin(), path.end(), '\\', '/');
+    if (FileUtils::getInstance()->isAbsolutePath(path))
+        return path;
+
+    char cwd[4096];
+    if (getcwd(cwd, sizeof(cwd)) == nullptr)
+        return path;
+
+    std::string absolutePath = cwd;
+    std::replace(absolutePath.begin(), absolutePath.end(), '\\', '/');
+    if (absolutePath.back() != '/')
+        absolutePath += '/';
+    return absolutePath + path;
+}
+
+static void printUsage()
+{
+    fprintf(stderr, "usage: audio-render [--seconds <n>] [--rate <hz>] [--block <frames>] [--script <file>] [--wav <output>]\n"
+                    "  --seconds   the length of the output, 60 by default\n"
+                    "  --rate      the sample rate of the output, 48000 by default\n"
+                    "  --block     the frames mixed at once, 480 by default\n"
+                    "  --script    the play, stop, pause, resume, seek and volume calls, a built-in script by default\n"
+                    "  --wav       writes the output, 16-bit stereo\n");
+}
+
+// CPU time of the calling thread in seconds
+static double getThreadCpuTime()
+{
+#if defined(_WIN32)
+    FILETIME creation, exit, kernel, user;
+    if (!GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel, &user))
+        return 0;
+    auto toSeconds = [](const FILETIME& time) {
+        return ((static_cast<uint64_t>(time.dwHighDateTime) << 32) | time.dwLowDateTime) / 10000000.0;
+    };
+    return toSeconds(kernel) + toSeconds(user);
+#else
+    timespec time;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time);
+    return time.tv_sec + time.tv_nsec / 1000000000.0;
+#endif
+}
+
+// The CPU time of every thread of the process, the loading and streaming threads included
+static void printThreadCpuTimes()
+{
+#if CC_TARGET_PLATFORM == CC_PLATFORM_LINUX
+    DIR* dir = opendir("/proc/self/task");
+    if (dir == nullptr)
+        return;
+
+    double ticks = static_cast<double>(sysconf(_SC_CLK_TCK));
+    printf("  threads:\n");
+    while (auto entry = readdir(dir))
+    {
+        if (entry->d_name[0] == '.')
+            continue;
+
+        std::string taskPath = std::string("/proc/self/task/") + entry->d_name;
+        std::string stat = FileUtils::getInstance()->getStringFromFile(taskPath + "/stat");
+        std::string name = FileUtils::getInstance()->getStringFromFile(taskPath + "/comm");
+        name.erase(std::remove(name.begin(), name.end(), '\n'), name.end());
+
+        // the fields after the name, which may contain spaces: state is the 3rd field, utime and stime the 14th and 15th
+        auto fields = stat.rfind(')');
+        if (fields == std::string::npos)
+            continue;
+        std::istringstream stream(stat.substr(fields + 2));
+        std::string field;
+        unsigned long long userTicks = 0, systemTicks = 0;
+        for (int index = 3; index <= 15 && stream >> field; ++index)
+        {
+            if (index == 14)
+                userTicks = strtoull(field.c_str(), nullptr, 10);
+            else if (index == 15)
+                systemTicks = strtoull(field.c_str(), nullptr, 10);
+        }
+        printf("    %-8s %-16s %8.3f s\n", entry->d_name, name.c_str(), (userTicks + systemTicks) / ticks);
+    }
+    closedir(dir);
+#endif
+}
+
+static bool writeToneWav(const std::string& path, float seconds, float frequency, int channels, int bits)
+{
+    const int sampleRate = 44100;
+    const uint32_t frames = static_cast<uint32_t>(seconds * sampleRate);
+    const uint32_t bytesPerSample = bits / 8;
+    const uint32_t bytesPerFrame = channels * bytesPerSample;
+    const uint32_t dataSize = frames * bytesPerFrame;
+
+    std::vector<unsigned char> bytes(44 + dataSize);
+    auto put32 = [&bytes](size_t offset, uint32_t value) {
+        for (int i = 0; i < 4; ++i)
+            bytes[offset + i] = static_cast<unsigned char>(value >> (8 * i));
+    };
+    auto put16 = [&bytes](size_t offset, uint16_t value) {
+        bytes[offset] = static_cast<unsigned char>(value);
+        bytes[offset + 1] = static_cast<unsigned char>(value >> 8);
+    };
+    memcpy(bytes.data(), "RIFF", 4);
+    put32(4, 36 + dataSize);
+    memcpy(bytes.data() + 8, "WAVEfmt ", 8);
+    put32(16, 16);
+    put16(20, 1); // PCM
+    put16(22, channels);
+    put32(24, sampleRate);
+    put32(28, sampleRate * bytesPerFrame);
+    put16(32, bytesPerFrame);
+    put16(34, bits);
+    memcpy(bytes.data() + 36, "data", 4);
+    put32(40, dataSize);
+
+    auto out = bytes.data() + 44;
+    for (uint32_t frame = 0; frame < frames; ++frame)
+    {
+        float t = static_cast<float>(frame) / sampleRate;
+        for (int channel = 0; channel < channels; ++channel)
+        {
+            float value = 8000 * sinf(t * frequency * (1 + 0.5f * channel) * 2 * static_cast<float>(M_PI));
+            auto sample = static_cast<int32_t>(static_cast<int16_t>(value)) * (1 << (bits - 16));
+            for (uint32_t i = 0; i < bytesPerSample; ++i)
+                out[i] = static_cast<unsigned char>(sample >> (8 * i));
+            out += bytesPerSample;
+        }
+    }
+
+    Data data;
+    data.fastSet(bytes.data(), static_cast<ssize_t>(bytes.size()));
+    bool ret = FileUtils::getInstance()->writeDataToFile(data, path);
+    data.fastSet(nullptr, 0);
+    return ret;
+}
+
+static bool writeOutputWav(const std::string& path, const std::vector<short>& samples, int sampleRate)
+{
+    const uint32_t dataSize = static_cast<uint32_t>(samples.size() * sizeof(short));
+    std::vector<unsigned char> bytes(44 + dataSize);
+    auto put32 = [&bytes](size_t offset, uint32_t value) {
+        for (int i = 0; i < 4; ++i)
+            bytes[offset + i] = static_cast<unsigned char>(value >> (8 * i));
+    };
+    auto put16 = [&bytes](size_t offset, uint16_t value) {
+        bytes[offset] = static_cast<unsigned char>(value);
+        bytes[offset + 1] = static_cast<unsigned char>(value >> 8);
+    };
+    memcpy(bytes.data(), "RIFF", 4);
+    put32(4, 36 + dataSize);
+    memcpy(bytes.data() + 8, "WAVEfmt ", 8);
+    put32(16, 16);
+    put16(20, 1);
+    put16(22, 2);
+    put32(24, sampleRate);
+    put32(28, sampleRate * 4);
+    put16(32, 4);
+    put16(34, 16);
+    memcpy(bytes.data() + 36, "data", 4);
+    put32(40, dataSize);
+
+    auto out = bytes.data() + 44;
+    for (auto sample : samples)
+    {
+        put16(out - bytes.data(), static_cast<uint16_t>(sample));
+        out += 2;
+    }
+
+    Data data;
+    data.fastSet(bytes.data(), static_cast<ssize_t>(bytes.size()));
+    bool ret = FileUtils::getInstance()->writeDataToFile(data, path);
+    data.fastSet(nullptr, 0);
+    return ret;
+}
+
+// Writes the files of the built-in script: a short effect, a 24-bit loop which is converted while loading and a
+// long music which is streamed. Returns the script.
+static std::string writeDefaultScript(const std::string& dir, double seconds)
+{
+    if (!writeToneWav(dir + "effect.wav", 0.25f, 880, 1, 16)
+        || !writeToneWav(dir + "loop.wav", 2.0f, 220, 2, 24)
+        || !writeToneWav(dir + "music.wav", 20.0f, 330, 2, 16))
+    {
+        return std::string();
+    }
+
+    std::string script;
+    script += "0 play music music.wav 1 0.6\n";
+    script += "0 play loop loop.wav 1 0.4\n";
+    for (int index = 0; index * 0.1 < seconds; ++index)
+    {
+        // a burst of effects every second, more than there are sources at its peak
+        double time = index * 0.1;
+        int count = index % 10 == 0 ? 40 : 2;
+        for (int effect = 0; effect < count; ++effect)
+            script += StringUtils::format("%.3f play effect%d effect.wav 0 0.2\n", time + effect * 0.001, index * 100 + effect);
+
+        if (index % 50 == 20)
+            script += StringUtils::format("%.3f seek music 12\n", time);
+        if (index % 50 == 30)
+            script += StringUtils::format("%.3f volume loop 0.1\n%.3f pause music\n", time, time);
+        if (index % 50 == 35)
+            script += StringUtils::format("%.3f volume loop 0.4\n%.3f resume music\n", time, time);
+    }
+    return script;
+}
+
+static bool parseScript(const std::string& text, std::vector<ScriptEvent>& events)
+{
+    std::istringstream lines(text);
+    std::string line;
+    for (int lineNumber = 1; std::getline(lines, line); ++lineNumber)
+    {
+        std::istringstream stream(line);
+        ScriptEvent event;
+        if (!(stream >> event.time))
+        {
+            if (line.find_first_not_of(" \t\r") == std::string::npos || line[line.find_first_not_of(" \t")] == '#')
+                continue;
+            fprintf(stderr, "audio-render: line %d of the script has no time\n", lineNumber);
+            return false;
+        }
+
+        bool valid = static_cast<bool>(stream >> event.command >> event.name);
+        if (valid && event.command == "play")
+        {
+            valid = static_cast<bool>(stream >> event.file);
+            int loop = 0;
+            if (valid && stream >> loop)
+            {
+                event.loop = loop != 0;
+                stream >> event.value;
+            }
+        }
+        else if (valid && (event.command == "seek" || event.command == "volume"))
+        {
+            valid = static_cast<bool>(stream >> event.value);
+        }
+        else if (valid && event.command != "stop" && event.command != "pause" && event.command != "resume")
+        {
+            valid = false;
+        }
+
+        if (!valid)
+        {
+            fprintf(stderr, "audio-render: line %d of the script is invalid: %s\n", lineNumber, line.c_str());
+            return false;
+        }
+        events.push_back(event);
+    }
+
+    std::stable_sort(events.begin(), events.end(), [](const ScriptEvent& a, const ScriptEvent& b) {
+        return a.time < b.time;
+    });
+    return true;
+}
+
+static void runEvent(const ScriptEvent& event, std::unordered_map<std::string, int>& audioIDs)
+{
+    if (event.command == "play")
+    {
+        audioIDs[event.name] = AudioEngine::play2d(event.file, event.loop, event.value);
+        return;
+    }
+
+    auto it = audioIDs.find(event.name);
+    if (it == audioIDs.end())
+        return;
+
+    if (event.command == "stop")
+    {
+        AudioEngine::stop(it->second);
+        audioIDs.erase(it);
+    }
+    else if (event.command == "pause")
+        AudioEngine::pause(it->second);
+    else if (event.command == "resume")
+        AudioEngine::resume(it->second);
+    else if (event.command == "seek")
+        AudioEngine::setCurrentTime(it->second, event.value);
+    else if (event.command == "volume")
+        AudioEngine::setVolume(it->second, event.value);
+}
+
+int main(int argc, char** argv)
+{
+    double seconds = 60;
+    int sampleRate = 48000;
+    int blockFrames = 480;
+    std::string scriptPath;
+    std::string wavPath;
+    for (int i = 1; i < argc; ++i)
+    {
+        bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--seconds") == 0 && hasValue)
+            seconds = atof(argv[++i]);
+        else if (strcmp(argv[i], "--rate") == 0 && hasValue)
+            sampleRate = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--block") == 0 && hasValue)
+            blockFrames = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--script") == 0 && hasValue)
+            scriptPath = toAbsolutePath(argv[++i]);
+        else if (strcmp(argv[i], "--wav") == 0 && hasValue)
+            wavPath = toAbsolutePath(argv[++i]);
+        else
+        {
+            printUsage();
+            return 1;
+        }
+    }
+
+    if (seconds <= 0 || sampleRate <= 0 || blockFrames <= 0)
+    {
+        printUsage();
+        return 1;
+    }
+    // the streams are refilled once per block, they underrun with blocks longer than their buffers
+    blockFrames = std::min(blockFrames, static_cast<int>(sampleRate * QUEUEBUFFER_TIME_STEP));
+
+    auto fs = FileUtils::getInstance();
+    std::string script;
+    if (scriptPath.empty())
+    {
+        std::string dir = fs->getWritablePath() + "audio-render/";
+        fs->createDirectory(dir);
+        fs->addSearchPath(dir, true);
+        script = writeDefaultScript(dir, seconds);
+        if (script.empty())
+        {
+            fprintf(stderr, "audio-render: can't write the files of the built-in script to %s\n", dir.c_str());
+            return 1;
+        }
+    }
+    else
+    {
+        // the files of a script are relative to it
+        fs->addSearchPath(scriptPath.substr(0, scriptPath.find_last_of('/') + 1), true);
+        script = fs->getStringFromFile(scriptPath);
+        if (script.empty())
+        {
+            fprintf(stderr, "audio-render: can't read %s\n", scriptPath.c_str());
+            return 1;
+        }
+    }
+
+    std::vector<ScriptEvent> events;
+    if (!parseScript(script, events))
+        return 1;
+
+    if (!AudioEngine::enableOfflineRendering(sampleRate))
+    {
+        fprintf(stderr, "audio-render: offline rendering needs openal-soft\n");
+        return 1;
+    }
+
+    // the engine is updated by the scheduler of the director, which runs without a view here
+    auto scheduler = Director::getInstance()->getScheduler();
+
+    // everything is loaded first, the loading threads would make the output depend on their timing otherwise
+    std::vector<std::string> files;
+    for (const auto& event : events)
+    {
+        if (event.command == "play" && std::find(files.begin(), files.end(), event.file) == files.end())
+            files.push_back(event.file);
+    }
+
+    typedef std::chrono::steady_clock Clock;
+    auto loadBegin = Clock::now();
+    bool loaded = false;
+    bool loadSucceeded = false;
+    AudioEngine::preloadBatch(files, nullptr, [&](bool allSucceeded) {
+        loaded = true;
+        loadSucceeded = allSucceeded;
+    });
+    while (!loaded)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        scheduler->update(0);
+    }
+    double loadTime = std::chrono::duration<double>(Clock::now() - loadBegin).count();
+    if (!loadSucceeded)
+    {
+        fprintf(stderr, "audio-render: loading the files of the script failed\n");
+        AudioEngine::end();
+        return 1;
+    }
+    auto cacheStats = AudioEngine::getCacheStats();
+
+    const int64_t totalFrames = static_cast<int64_t>(seconds * sampleRate);
+    const float blockTime = static_cast<float>(blockFrames) / sampleRate;
+    std::vector<short> block(blockFrames * 2);
+    std::vector<short> output;
+    if (!wavPath.empty())
+        output.reserve(static_cast<size_t>(totalFrames * 2));
+
+    std::unordered_map<std::string, int> audioIDs;
+    size_t nextEvent = 0;
+    unsigned int peakVoices = 0;
+    double updateCpuTime = 0;
+    double renderCpuTime = 0;
+    auto renderBegin = Clock::now();
+    double cpuBegin = getThreadCpuTime();
+
+    for (int64_t frame = 0; frame < totalFrames; frame += blockFrames)
+    {
+        int frames = static_cast<int>(std::min<int64_t>(blockFrames, totalFrames - frame));
+        double time = static_cast<double>(frame) / sampleRate;
+
+        double cpuTime = getThreadCpuTime();
+        for (; nextEvent < events.size() && events[nextEvent].time <= time; ++nextEvent)
+        {
+            runEvent(events[nextEvent], audioIDs);
+        }
+        scheduler->update(blockTime);
+
+        double updatedCpuTime = getThreadCpuTime();
+        updateCpuTime += updatedCpuTime - cpuTime;
+
+        if (!AudioEngine::renderOffline(block.data(), frames))
+        {
+            fprintf(stderr, "audio-render: rendering failed\n");
+            AudioEngine::end();
+            return 1;
+        }
+        renderCpuTime += getThreadCpuTime() - updatedCpuTime;
+
+        if (!wavPath.empty())
+            output.insert(output.end(), block.begin(), block.begin() + frames * 2);
+        peakVoices = std::max(peakVoices, AudioEngine::getVoiceStats().voices);
+    }
+
+    double renderTime = std::chrono::duration<double>(Clock::now() - renderBegin).count();
+    double mainCpuTime = getThreadCpuTime() - cpuBegin;
+    auto voiceStats = AudioEngine::getVoiceStats();
+    auto streamerStats = AudioStreamer::getInstance()->getStats();
+
+    printf("audio-render: %.1f s at %d Hz in %.3f s, %.1fx real time\n", seconds, sampleRate, renderTime,
+           renderTime > 0 ? seconds / renderTime : 0.0);
+    printf("  load: %d files, %.2f MB decoded in %.3f s, %.1f MB/s\n", static_cast<int>(files.size()),
+           cacheStats.pcmBytes / 1048576.0, loadTime, loadTime > 0 ? cacheStats.pcmBytes / 1048576.0 / loadTime : 0.0);
+    printf("  streaming: %llu frames decoded in %.3f s, %.2f Mframes/s, %llu underruns\n",
+           static_cast<unsigned long long>(streamerStats.framesDecoded), streamerStats.busyTime,
+           streamerStats.busyTime > 0 ? streamerStats.framesDecoded / 1000000.0 / streamerStats.busyTime : 0.0,
+           static_cast<unsigned long long>(streamerStats.underruns));
+    printf("  main thread: %.3f s CPU, %.3f s updating, %.3f s streaming and mixing\n", mainCpuTime, updateCpuTime, renderCpuTime);
+    printf("  voices: %u at most, %u steals, %u revivals\n", peakVoices, voiceStats.steals, voiceStats.revivals);
+    printThreadCpuTimes();
+
+    AudioEngine::end();
+
+    if (!wavPath.empty())
+    {
+        if (!writeOutputWav(wavPath, output, sampleRate))
+        {
+            fprintf(stderr, "audio-render: can't write %s\n", wavPath.c_str());
+            return 1;
+        }
+        printf("audio-render: wrote %s\n", wavPath.c_str());
+    }
+    return 0;
+}